@@ -0,0 +1,286 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the accuracy / latency trade-off of the early exit inference of a
+// binary classification Gradient Boosted Trees model (see
+// "serving/decision_forest/early_exit.h").
+//
+// For each value of "--max_error_rates", the early exit thresholds are
+// calibrated on "--validation", and the engine is benchmarked on "--dataset".
+// The report contains the inference time, the fraction of examples with the
+// same decision as the full model, and the accuracy.
+//
+// Usage example:
+//
+//   bazel run -c opt --copt=-mavx2 :benchmark_early_exit -- \
+//     --alsologtostderr \
+//     --model=/path/to/my/model \
+//     --validation=csv:/path/to/my/validation.csv \
+//     --dataset=csv:/path/to/my/test.csv
+//
+// Result:
+//
+//   batch_size : 100  num_runs : 20  num_trees_per_stage : 10
+//   max_error_rate  time/example(us)  agreement  accuracy
+//   ------------------------------------------------------
+//             full            0.7902     1.0000    0.8722
+//                0            0.5311     1.0000    0.8722
+//            0.001            0.3104     0.9991    0.8719
+//   ------------------------------------------------------
+//
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/early_exit.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/benchmark/inference.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+ABSL_FLAG(std::string, model, "", "Path to model.");
+ABSL_FLAG(std::string, dataset, "",
+          "Typed path to the benchmark dataset i.e. [type]:[path] format.");
+ABSL_FLAG(std::string, validation, "",
+          "Typed path to the dataset used to calibrate the early exit "
+          "thresholds. If not set, uses --dataset.");
+ABSL_FLAG(std::string, max_error_rates, "0,0.0001,0.001,0.01",
+          "Comma separated list of maximum error rates to evaluate.");
+ABSL_FLAG(int, num_trees_per_stage, 10,
+          "Number of trees evaluated before each early exit check.");
+ABSL_FLAG(std::string, engine, "auto",
+          "Early exit engine. One of \"auto\", \"generic\" and "
+          "\"quick_scorer\".");
+ABSL_FLAG(
+    int, num_runs, 20,
+    "Number of times the dataset is run. Higher values increase the "
+    "precision of the timings, but increase the duration of the benchmark.");
+ABSL_FLAG(int, batch_size, 100, "Number of examples per batch.");
+ABSL_FLAG(int, warmup_runs, 1,
+          "Number of runs through the dataset before the benchmark.");
+
+constexpr char kUsageMessage[] =
+    "Measures the accuracy / latency trade-off of the early exit inference of "
+    "a binary classification GBT model.";
+
+namespace yggdrasil_decision_forests {
+
+namespace {
+
+using serving::decision_forest::EarlyExitOptions;
+
+struct EarlyExitResult {
+  std::string name;
+  absl::Duration duration_per_example;
+  double agreement;
+  double accuracy;
+};
+
+absl::StatusOr<EarlyExitOptions::Engine> ParseEngine(
+    const absl::string_view engine) {
+  if (engine == "auto") {
+    return EarlyExitOptions::Engine::kAuto;
+  } else if (engine == "generic") {
+    return EarlyExitOptions::Engine::kGeneric;
+  } else if (engine == "quick_scorer") {
+    return EarlyExitOptions::Engine::kQuickScorer;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown early exit engine \"", engine, "\""));
+}
+
+// Probability of the positive class of all the examples of "dataset".
+absl::StatusOr<std::vector<float>> PredictDataset(
+    const serving::FastEngine& engine,
+    const dataset::VerticalDataset& dataset) {
+  auto examples = engine.AllocateExamples(dataset.nrow());
+  RETURN_IF_ERROR(serving::CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, dataset.nrow(), engine.features(), examples.get()));
+  std::vector<float> predictions;
+  engine.Predict(*examples, dataset.nrow(), &predictions);
+  return predictions;
+}
+
+absl::StatusOr<EarlyExitResult> Evaluate(
+    const absl::string_view name, const serving::FastEngine& engine,
+    const model::AbstractModel& model, const dataset::VerticalDataset& dataset,
+    const std::vector<float>& full_predictions,
+    const utils::BenchmarkInferenceRunOptions& options) {
+  std::vector<utils::BenchmarkInferenceResult> timings;
+  RETURN_IF_ERROR(utils::BenchmarkFastEngine(options, engine, model, dataset,
+                                             &timings, name));
+  ASSIGN_OR_RETURN(const auto predictions, PredictDataset(engine, dataset));
+
+  ASSIGN_OR_RETURN(
+      const auto* labels,
+      dataset.ColumnWithCastWithStatus<
+          dataset::VerticalDataset::CategoricalColumn>(model.label_col_idx()));
+  int num_agreements = 0;
+  int num_correct = 0;
+  for (int example_idx = 0; example_idx < dataset.nrow(); example_idx++) {
+    const bool decision = predictions[example_idx] >= 0.5f;
+    num_agreements += decision == (full_predictions[example_idx] >= 0.5f);
+    // The positive class is the categorical value 2.
+    num_correct += decision == (labels->values()[example_idx] == 2);
+  }
+  const double num_examples = std::max<int64_t>(1, dataset.nrow());
+  return EarlyExitResult{std::string(name),
+                         timings.front().duration_per_example,
+                         num_agreements / num_examples,
+                         num_correct / num_examples};
+}
+
+std::string ResultsToString(const utils::BenchmarkInferenceRunOptions& options,
+                            const int num_trees_per_stage,
+                            const std::vector<EarlyExitResult>& results) {
+  std::string report;
+  absl::StrAppendFormat(
+      &report, "batch_size : %d  num_runs : %d  num_trees_per_stage : %d\n",
+      options.batch_size, options.runs->num_runs, num_trees_per_stage);
+  absl::StrAppendFormat(
+      &report, "max_error_rate  time/example(us)  agreement  accuracy\n");
+  absl::StrAppendFormat(
+      &report, "------------------------------------------------------\n");
+  for (const auto& result : results) {
+    absl::StrAppendFormat(
+        &report, "%14s  %16.5g  %9.4f  %8.4f\n", result.name,
+        absl::ToDoubleMicroseconds(result.duration_per_example),
+        result.agreement, result.accuracy);
+  }
+  absl::StrAppendFormat(
+      &report, "------------------------------------------------------\n");
+  return report;
+}
+
+}  // namespace
+
+absl::Status Benchmark() {
+  // Parse flags.
+  const auto model_path = absl::GetFlag(FLAGS_model);
+  if (model_path.empty()) {
+    return absl::InvalidArgumentError("The --model is not specified.");
+  }
+  const auto dataset_path = absl::GetFlag(FLAGS_dataset);
+  if (dataset_path.empty()) {
+    return absl::InvalidArgumentError("The --dataset is not specified.");
+  }
+  auto validation_path = absl::GetFlag(FLAGS_validation);
+  if (validation_path.empty()) {
+    validation_path = dataset_path;
+  }
+  std::vector<float> max_error_rates;
+  for (const absl::string_view value :
+       absl::StrSplit(absl::GetFlag(FLAGS_max_error_rates), ',')) {
+    float max_error_rate;
+    if (!absl::SimpleAtof(value, &max_error_rate)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid --max_error_rates value \"", value, "\""));
+    }
+    max_error_rates.push_back(max_error_rate);
+  }
+  EarlyExitOptions early_exit_options;
+  early_exit_options.num_trees_per_stage =
+      absl::GetFlag(FLAGS_num_trees_per_stage);
+  ASSIGN_OR_RETURN(early_exit_options.engine,
+                   ParseEngine(absl::GetFlag(FLAGS_engine)));
+
+  const utils::BenchmarkInterfaceNumRunsOptions num_runs_options = {
+      /*.num_runs =*/absl::GetFlag(FLAGS_num_runs),
+      /*.warmup_runs =*/absl::GetFlag(FLAGS_warmup_runs),
+  };
+  const utils::BenchmarkInferenceRunOptions options{
+      /*.batch_size =*/absl::GetFlag(FLAGS_batch_size),
+      /*.runs =*/num_runs_options,
+      /*.time =*/absl::nullopt};
+
+  LOG(INFO) << "Loading model";
+  std::unique_ptr<model::AbstractModel> model;
+  RETURN_IF_ERROR(model::LoadModel(model_path, &model));
+  const auto* gbt_model = dynamic_cast<
+      const model::gradient_boosted_trees::GradientBoostedTreesModel*>(
+      model.get());
+  if (gbt_model == nullptr) {
+    return absl::InvalidArgumentError(
+        "The model is not a Gradient Boosted Trees model");
+  }
+
+  LOG(INFO) << "Loading datasets";
+  dataset::VerticalDataset dataset;
+  RETURN_IF_ERROR(LoadVerticalDataset(dataset_path, model->data_spec(),
+                                      &dataset,
+                                      /*ensure_non_missing=*/{}));
+  dataset::VerticalDataset validation;
+  RETURN_IF_ERROR(LoadVerticalDataset(validation_path, model->data_spec(),
+                                      &validation,
+                                      /*ensure_non_missing=*/{}));
+
+  std::vector<EarlyExitResult> results;
+
+  LOG(INFO) << "Running the full model";
+  ASSIGN_OR_RETURN(const auto full_engine, model->BuildFastEngine());
+  ASSIGN_OR_RETURN(const auto full_predictions,
+                   PredictDataset(*full_engine, dataset));
+  ASSIGN_OR_RETURN(auto full_result,
+                   Evaluate("full", *full_engine, *model, dataset,
+                            full_predictions, options));
+  results.push_back(std::move(full_result));
+
+  for (const float max_error_rate : max_error_rates) {
+    LOG(INFO) << "Running early exit with max_error_rate=" << max_error_rate;
+    early_exit_options.max_error_rate = max_error_rate;
+    ASSIGN_OR_RETURN(const auto engine,
+                     serving::decision_forest::BuildEarlyExitEngine(
+                         *gbt_model, validation, early_exit_options));
+    ASSIGN_OR_RETURN(auto result,
+                     Evaluate(absl::StrCat(max_error_rate), *engine, *model,
+                              dataset, full_predictions, options));
+    results.push_back(std::move(result));
+  }
+
+  // Show results.
+  std::cout << ResultsToString(options, early_exit_options.num_trees_per_stage,
+                               results);
+  return absl::OkStatus();
+}
+
+}  // namespace yggdrasil_decision_forests
+
+int main(int argc, char** argv) {
+  InitLogging(kUsageMessage, &argc, &argv, true);
+  const auto status = yggdrasil_decision_forests::Benchmark();
+  if (!status.ok()) {
+    LOG(INFO) << "The benchmark failed with the following error: " << status;
+    return 1;
+  }
+  return 0;
+}
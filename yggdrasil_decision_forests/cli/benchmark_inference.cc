@@ -50,6 +50,17 @@
 //   21.547          2154.8  Generic slow engine
 //   ----------------------------------------
 //
+// With "--latency", the benchmark also measures the latency distribution of
+// the evaluation of individual examples with the low latency engine (see
+// "serving/low_latency_engine.h"), as observed by an online service scoring
+// one example per request:
+//
+//   batch_size : 1  num_runs : 20
+//   p50(us)     p90(us)     p99(us)     max(us)     method
+//   ----------------------------------------
+//        0.93         1.1        1.87       24.53  GradientBoostedTrees...
+//   ----------------------------------------
+//
 #include <optional>
 #include <string>
 #include <vector>
@@ -63,6 +74,7 @@
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/low_latency_engine.h"
 #include "yggdrasil_decision_forests/utils/benchmark/inference.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 
@@ -83,6 +95,10 @@ ABSL_FLAG(bool, generic, true,
           "generic engine is slow and mostly a reference. Disable it if the "
           "benchmark runs for too long.");
 
+ABSL_FLAG(bool, latency, false,
+          "Also measures the p50/p90/p99 latency of the evaluation of the "
+          "examples one at a time with the low latency engine.");
+
 constexpr char kUsageMessage[] =
     "Benchmarks the inference time of a model with the available inference "
     "engines.";
@@ -115,6 +131,31 @@ std::string ResultsToString(
   return report;
 }
 
+std::string LatencyResultsToString(
+    const utils::BenchmarkInterfaceNumRunsOptions& options,
+    std::vector<utils::BenchmarkLatencyResult> results) {
+  std::string report;
+
+  // Sort the result from the lowest to the highest p99 latency.
+  std::sort(results.begin(), results.end(),
+            [](const auto& a, const auto& b) { return a.p99 < b.p99; });
+
+  absl::StrAppendFormat(&report, "batch_size : 1  num_runs : %d\n",
+                        options.num_runs);
+  absl::StrAppendFormat(
+      &report, "p50(us)     p90(us)     p99(us)     max(us)     method\n");
+  absl::StrAppendFormat(&report, "----------------------------------------\n");
+  for (const auto& result : results) {
+    absl::StrAppendFormat(&report, "%10.5g  %10.5g  %10.5g  %10.5g  %s\n",
+                          absl::ToDoubleMicroseconds(result.p50),
+                          absl::ToDoubleMicroseconds(result.p90),
+                          absl::ToDoubleMicroseconds(result.p99),
+                          absl::ToDoubleMicroseconds(result.max), result.name);
+  }
+  absl::StrAppendFormat(&report, "----------------------------------------\n");
+  return report;
+}
+
 absl::Status Benchmark() {
   // Parse flags.
   const auto model_path = absl::GetFlag(FLAGS_model);
@@ -147,6 +188,7 @@ absl::Status Benchmark() {
                           /*ensure_non_missing=*/model->input_features()));
 
   std::vector<utils::BenchmarkInferenceResult> results;
+  std::vector<utils::BenchmarkLatencyResult> latency_results;
 
   // Run engines.
   const auto engine_factories = model->ListCompatibleFastEngines();
@@ -158,6 +200,16 @@ absl::Status Benchmark() {
     RETURN_IF_ERROR(utils::BenchmarkFastEngine(options, *engine.get(),
                                                *model.get(), dataset, &results,
                                                engine_factory->name()));
+
+    if (absl::GetFlag(FLAGS_latency)) {
+      LOG(INFO) << "Running " << engine_factory->name()
+                << " with the low latency engine";
+      ASSIGN_OR_RETURN(auto latency_engine,
+                       serving::LowLatencyEngine::Create(std::move(engine)));
+      RETURN_IF_ERROR(utils::BenchmarkLowLatencyEngine(
+          num_runs_options, *latency_engine, dataset, &latency_results,
+          engine_factory->name()));
+    }
   }
 
   if (absl::GetFlag(FLAGS_generic)) {
@@ -168,6 +220,10 @@ absl::Status Benchmark() {
 
   // Show results.
   std::cout << ResultsToString(options, results);
+  if (!latency_results.empty()) {
+    std::cout << "\n" << LatencyResultsToString(num_runs_options,
+                                                latency_results);
+  }
   return absl::OkStatus();
 }
 
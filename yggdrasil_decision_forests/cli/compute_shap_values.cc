@@ -0,0 +1,209 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Computes the SHAP values of a decision forest model on a dataset (see
+// "serving/decision_forest/tree_shap.h"), and exports them in a csv file.
+//
+// The csv file contains one column per input feature of the model, and an
+// "expected_value" column. For each example, the sum of the values of the row
+// is equal to the model output before activation (e.g. the logit for binary
+// classification Gradient Boosted Trees).
+//
+// Usage example:
+//
+//   bazel run -c opt :compute_shap_values -- \
+//     --alsologtostderr \
+//     --model=/path/to/my/model \
+//     --dataset=csv:/path/to/my/dataset.csv \
+//     --output=/path/to/shap_values.csv
+//
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/tree_shap.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/csv.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+ABSL_FLAG(std::string, model, "", "Path to model.");
+ABSL_FLAG(std::string, dataset, "",
+          "Typed path to the dataset to explain i.e. [type]:[path] format.");
+ABSL_FLAG(std::string, output, "", "Output csv file with the SHAP values.");
+ABSL_FLAG(std::string, algorithm, "path_dependent",
+          "TreeSHAP algorithm. One of \"path_dependent\" and "
+          "\"interventional\".");
+ABSL_FLAG(std::string, background, "",
+          "Typed path to the background dataset of the \"interventional\" "
+          "algorithm. If not set, uses --dataset.");
+ABSL_FLAG(int, max_background_examples, 100,
+          "Maximum number of background examples of the \"interventional\" "
+          "algorithm.");
+ABSL_FLAG(int, num_threads, 6, "Number of threads.");
+ABSL_FLAG(int, batch_size, 1000, "Number of examples explained at once.");
+
+constexpr char kUsageMessage[] =
+    "Computes the SHAP values of a decision forest model on a dataset.";
+
+namespace yggdrasil_decision_forests {
+
+namespace {
+
+using serving::decision_forest::TreeShap;
+using serving::decision_forest::TreeShapOptions;
+
+absl::StatusOr<TreeShapOptions::Algorithm> ParseAlgorithm(
+    const absl::string_view algorithm) {
+  if (algorithm == "path_dependent") {
+    return TreeShapOptions::Algorithm::kPathDependent;
+  } else if (algorithm == "interventional") {
+    return TreeShapOptions::Algorithm::kInterventional;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown TreeSHAP algorithm \"", algorithm, "\""));
+}
+
+}  // namespace
+
+absl::Status ComputeShapValues() {
+  // Parse flags.
+  const auto model_path = absl::GetFlag(FLAGS_model);
+  if (model_path.empty()) {
+    return absl::InvalidArgumentError("The --model is not specified.");
+  }
+  const auto dataset_path = absl::GetFlag(FLAGS_dataset);
+  if (dataset_path.empty()) {
+    return absl::InvalidArgumentError("The --dataset is not specified.");
+  }
+  const auto output_path = absl::GetFlag(FLAGS_output);
+  if (output_path.empty()) {
+    return absl::InvalidArgumentError("The --output is not specified.");
+  }
+  const int batch_size = absl::GetFlag(FLAGS_batch_size);
+  if (batch_size <= 0) {
+    return absl::InvalidArgumentError("The --batch_size should be positive.");
+  }
+  TreeShapOptions options;
+  ASSIGN_OR_RETURN(options.algorithm,
+                   ParseAlgorithm(absl::GetFlag(FLAGS_algorithm)));
+  options.max_background_examples =
+      absl::GetFlag(FLAGS_max_background_examples);
+
+  LOG(INFO) << "Loading model";
+  std::unique_ptr<model::AbstractModel> model;
+  RETURN_IF_ERROR(model::LoadModel(model_path, &model));
+
+  LOG(INFO) << "Loading dataset";
+  dataset::VerticalDataset dataset;
+  RETURN_IF_ERROR(LoadVerticalDataset(dataset_path, model->data_spec(),
+                                      &dataset,
+                                      /*ensure_non_missing=*/{}));
+
+  dataset::VerticalDataset background;
+  const dataset::VerticalDataset* background_ptr = nullptr;
+  if (options.algorithm == TreeShapOptions::Algorithm::kInterventional) {
+    const auto background_path = absl::GetFlag(FLAGS_background);
+    if (background_path.empty()) {
+      background_ptr = &dataset;
+    } else {
+      LOG(INFO) << "Loading background dataset";
+      RETURN_IF_ERROR(LoadVerticalDataset(background_path, model->data_spec(),
+                                          &background,
+                                          /*ensure_non_missing=*/{}));
+      background_ptr = &background;
+    }
+  }
+
+  ASSIGN_OR_RETURN(auto tree_shap,
+                   TreeShap::Create(*model, options, background_ptr));
+  const int num_threads = absl::GetFlag(FLAGS_num_threads);
+  if (num_threads > 1) {
+    auto thread_pool =
+        std::make_shared<utils::concurrency::ThreadPool>(num_threads - 1);
+    thread_pool->StartWorkers();
+    tree_shap->SetParallelOptions(
+        {.thread_pool = std::move(thread_pool), .min_examples_per_thread = 16});
+  }
+
+  // Export the SHAP values.
+  ASSIGN_OR_RETURN(auto file_handle, file::OpenOutputFile(output_path));
+  file::OutputFileCloser file(std::move(file_handle));
+  utils::csv::Writer writer(file.stream());
+
+  const auto& input_features = tree_shap->input_features();
+  const int num_columns = input_features.size();
+  std::vector<std::string> row;
+  row.reserve(num_columns + 1);
+  for (const int column_idx : input_features) {
+    row.push_back(model->data_spec().columns(column_idx).name());
+  }
+  row.push_back("expected_value");
+  RETURN_IF_ERROR(writer.WriteRowStrings(row));
+
+  LOG(INFO) << "Computing the SHAP values of " << dataset.nrow()
+            << " examples";
+  const std::string expected_value = absl::StrCat(tree_shap->expected_value());
+  auto examples = tree_shap->AllocateExamples(batch_size);
+  std::vector<float> shap_values;
+  for (int64_t begin = 0; begin < dataset.nrow(); begin += batch_size) {
+    const int64_t end = std::min<int64_t>(begin + batch_size, dataset.nrow());
+    const int num_examples = end - begin;
+    examples->Clear();
+    RETURN_IF_ERROR(serving::CopyVerticalDatasetToAbstractExampleSet(
+        dataset, begin, end, tree_shap->features(), examples.get()));
+    shap_values.resize(num_examples * num_columns);
+    RETURN_IF_ERROR(tree_shap->Shap(*examples, num_examples,
+                                    absl::MakeSpan(shap_values)));
+    for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+      row.clear();
+      for (int column = 0; column < num_columns; column++) {
+        row.push_back(
+            absl::StrCat(shap_values[example_idx * num_columns + column]));
+      }
+      row.push_back(expected_value);
+      RETURN_IF_ERROR(writer.WriteRowStrings(row));
+    }
+  }
+  return file.Close();
+}
+
+}  // namespace yggdrasil_decision_forests
+
+int main(int argc, char** argv) {
+  InitLogging(kUsageMessage, &argc, &argv, true);
+  const auto status = yggdrasil_decision_forests::ComputeShapValues();
+  if (!status.ok()) {
+    LOG(INFO) << "The computation failed with the following error: "
+              << status;
+    return 1;
+  }
+  return 0;
+}
@@ -40,11 +40,29 @@
 //     the model filenames) with "new_file_prefix". Set "new_file_prefix" to the
 //     empty string (i.e. --new_file_prefix=) to remove the model prefix.
 //
+//   If profile_dataset is set:
+//     Records, in each node of a decision forest model, the number of examples
+//     of --profile_dataset reaching it. The inference engines then store the
+//     frequently visited nodes next to each other, make the most visited
+//     child of each node its fall-through child, and order the trees by
+//     expected traversal depth. This reduces the number of cache misses and
+//     of taken branches. --profile_dataset should be a sample of the
+//     inference traffic (e.g. "csv:/path/to/sample.csv"). The predictions are
+//     only changed by the floating point rounding of the sum of the trees.
+//
+//   If clear_profile is set:
+//     Removes the statistics recorded with --profile_dataset.
+//
 #include "absl/flags/flag.h"
 #include "absl/log/log.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/\
+decision_forest_interface.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 
@@ -63,6 +81,12 @@ ABSL_FLAG(std::string, pure_serving, kStringNoSet,
           "Clear the model from any information that is not required for model "
           "serving.This includes debugging, model interpretation and other "
           "meta-data. Can reduce significantly the size of the model.");
+ABSL_FLAG(std::string, profile_dataset, kStringNoSet,
+          "Typed path to a sample of the inference traffic. The number of "
+          "examples reaching each node is recorded in the model and used to "
+          "optimize the memory layout of the inference engines.");
+ABSL_FLAG(bool, clear_profile, false,
+          "Removes the statistics recorded with --profile_dataset.");
 
 constexpr char kUsageMessage[] = "Edits a trained model.";
 
@@ -111,6 +135,28 @@ void EditModel() {
     QCHECK_OK(model->MakePureServing());
   }
 
+  // Profile the node traffic.
+  if (absl::GetFlag(FLAGS_profile_dataset) != kStringNoSet ||
+      absl::GetFlag(FLAGS_clear_profile)) {
+    auto* df_model = dynamic_cast<model::DecisionForestInterface*>(model.get());
+    if (df_model == nullptr) {
+      LOG(FATAL) << "--profile_dataset and --clear_profile are only "
+                    "available for decision forest models.";
+    }
+    if (absl::GetFlag(FLAGS_clear_profile)) {
+      model::decision_tree::ClearNodeTraffic(
+          df_model->mutable_decision_trees());
+    }
+    if (absl::GetFlag(FLAGS_profile_dataset) != kStringNoSet) {
+      dataset::VerticalDataset profile_dataset;
+      QCHECK_OK(dataset::LoadVerticalDataset(
+          absl::GetFlag(FLAGS_profile_dataset), model->data_spec(),
+          &profile_dataset));
+      QCHECK_OK(model::decision_tree::SetNodeTraffic(
+          profile_dataset, df_model->mutable_decision_trees()));
+    }
+  }
+
   // Change how the model is exported.
   model::ModelIOOptions output_options;
   if (absl::GetFlag(FLAGS_new_file_prefix) != kStringNoSet) {
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Exports a YDF model into a serving image.
+//
+// A serving image contains the flattened inference engine of a decision forest
+// model. Unlike a model directory, a serving image is memory-mapped and used
+// in place by the inference engine, making the engine creation instantaneous
+// regardless of the model size. See
+// serving/decision_forest/serving_image.h for details.
+//
+// Usage example:
+//   export_serving_image --model=/path/to/model --output=/path/to/model.ydfimg
+//
+// Supported models:
+// - Gradient Boosted Trees, Random Forest and Isolation Forest.
+
+#include <memory>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/serving_image.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+ABSL_FLAG(std::string, model, "", "Model directory (required).");
+
+ABSL_FLAG(std::string, output, "", "Output serving image path (required).");
+
+constexpr char kUsageMessage[] = "Export a model into a serving image.";
+
+namespace yggdrasil_decision_forests {
+namespace cli {
+
+absl::Status ExportServingImage() {
+  // Check required flags.
+  STATUS_CHECK(!absl::GetFlag(FLAGS_model).empty());
+  STATUS_CHECK(!absl::GetFlag(FLAGS_output).empty());
+
+  std::unique_ptr<model::AbstractModel> model;
+  RETURN_IF_ERROR(model::LoadModel(absl::GetFlag(FLAGS_model), &model));
+  return serving::decision_forest::SaveServingImage(
+      *model, absl::GetFlag(FLAGS_output));
+}
+
+}  // namespace cli
+}  // namespace yggdrasil_decision_forests
+
+int main(int argc, char** argv) {
+  InitLogging(kUsageMessage, &argc, &argv, true);
+  QCHECK_OK(yggdrasil_decision_forests::cli::ExportServingImage());
+  return 0;
+}
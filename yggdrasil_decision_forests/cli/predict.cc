@@ -42,6 +42,7 @@
 
 #include "absl/flags/flag.h"
 #include "absl/log/log.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
@@ -50,7 +51,9 @@
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
 #include "yggdrasil_decision_forests/model/prediction.pb.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/evaluation.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 
@@ -71,6 +74,10 @@ ABSL_FLAG(std::string, key, "",
           "If set, copies the column \"key\" in the output prediction file. "
           "This key column cannot be an input feature of the model.");
 
+ABSL_FLAG(int, num_threads, 1,
+          "Number of threads used to compute the predictions with the "
+          "semi-fast engine.");
+
 constexpr char kUsageMessage[] =
     "Apply a model on a dataset and export the predictions to disk.";
 
@@ -139,19 +146,36 @@ void Predict() {
   if (engine_or.ok()) {
     LOG(INFO) << "Run predictions with semi-fast engine";
 
-    // Convert dataset to efficient format.
     auto engine = std::move(engine_or.value());
-    auto examples = engine->AllocateExamples(dataset.nrow());
-    QCHECK_OK(serving::CopyVerticalDatasetToAbstractExampleSet(
-        dataset, 0, dataset.nrow(), engine->features(), examples.get()));
-
-    // Apply the model.
+    const int num_prediction_dimensions = engine->NumPredictionDimension();
+    if (absl::GetFlag(FLAGS_num_threads) > 1) {
+      auto thread_pool = std::make_shared<utils::concurrency::ThreadPool>(
+          absl::GetFlag(FLAGS_num_threads) - 1,
+          utils::concurrency::ThreadPool::Options{.name_prefix = "predict"});
+      thread_pool->StartWorkers();
+      engine->SetParallelOptions({.thread_pool = std::move(thread_pool)});
+    }
     std::vector<float> fast_predictions;
-    engine->Predict(*examples, dataset.nrow(), &fast_predictions);
-    examples.reset();
+
+    // Apply the model directly on the dataset columns if possible.
+    const auto columnar_examples =
+        serving::ColumnarExamples::FromVerticalDataset(
+            dataset, 0, dataset.nrow(), engine->features());
+    if (columnar_examples.ok()) {
+      fast_predictions.resize(dataset.nrow() * num_prediction_dimensions);
+      QCHECK_OK(engine->PredictColumnar(columnar_examples.value(),
+                                        absl::MakeSpan(fast_predictions)));
+    } else {
+      // Convert dataset to efficient format.
+      auto examples = engine->AllocateExamples(dataset.nrow());
+      QCHECK_OK(serving::CopyVerticalDatasetToAbstractExampleSet(
+          dataset, 0, dataset.nrow(), engine->features(), examples.get()));
+
+      // Apply the model.
+      engine->Predict(*examples, dataset.nrow(), &fast_predictions);
+    }
 
     // Convert the prediction to the expected format.
-    const int num_prediction_dimensions = engine->NumPredictionDimension();
     for (dataset::VerticalDataset::row_t example_idx = 0;
          example_idx < dataset.nrow(); example_idx++) {
       auto& prediction = predictions[example_idx];
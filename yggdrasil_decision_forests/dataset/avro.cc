@@ -15,13 +15,16 @@
 
 #include "yggdrasil_decision_forests/dataset/avro.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <optional>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -36,13 +39,12 @@
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/zlib.h"
 
-#define MAYBE_SKIP_OPTIONAL(FIELD)                       \
-  if (field.optional) {                                  \
-    ASSIGN_OR_RETURN(const auto _has_value,              \
-                     current_block_reader_->ReadByte()); \
-    if (!_has_value) {                                   \
-      return absl::nullopt;                              \
-    }                                                    \
+#define MAYBE_SKIP_OPTIONAL(FIELD)                               \
+  if (field.optional) {                                          \
+    ASSIGN_OR_RETURN(const auto _has_value, cursor_.ReadByte()); \
+    if (!_has_value) {                                           \
+      return absl::nullopt;                                      \
+    }                                                            \
   }
 
 namespace yggdrasil_decision_forests::dataset::avro {
@@ -336,39 +338,23 @@ absl::StatusOr<std::string> AvroReader::ReadHeader() {
   return schema;
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextBlock() {
+absl::StatusOr<bool> AvroReader::ReadNextRawBlock(AvroRawBlock* block) {
   const auto num_objects_in_block_or = internal::ReadInteger(stream_.get());
   if (!num_objects_in_block_or.ok()) {
     return false;
   }
-  num_objects_in_current_block_ = num_objects_in_block_or.value();
-  next_object_in_current_block_ = 0;
+  block->num_records = num_objects_in_block_or.value();
 
   ASSIGN_OR_RETURN(const auto block_size, internal::ReadInteger(stream_.get()));
+  STATUS_CHECK_GE(block_size, 0);
 
-  current_block_.resize(block_size);
+  block->data.resize(block_size);
   ASSIGN_OR_RETURN(bool has_read,
-                   stream_->ReadExactly(&current_block_[0], block_size));
-  if (!has_read) {
+                   stream_->ReadExactly(&block->data[0], block_size));
+  if (!has_read && block_size > 0) {
     return absl::InvalidArgumentError("Unexpected end of stream");
   }
 
-  switch (codec_) {
-    case AvroCodec::kNull:
-      current_block_reader_ = utils::StringViewInputByteStream(current_block_);
-      break;
-    case AvroCodec::kDeflate:
-      // TODO: Multi-thread decompression.
-      zlib_working_buffer_.resize(1024 * 1024);
-      current_block_decompressed_.clear();
-      RETURN_IF_ERROR(
-          utils::Inflate(current_block_, &current_block_decompressed_,
-                         &zlib_working_buffer_, /*raw_deflate=*/true));
-      current_block_reader_ =
-          utils::StringViewInputByteStream(current_block_decompressed_);
-      break;
-  }
-
   new_sync_marker_.resize(16);
   ASSIGN_OR_RETURN(has_read, stream_->ReadExactly(&new_sync_marker_[0], 16));
   STATUS_CHECK(has_read);
@@ -380,9 +366,40 @@ absl::StatusOr<bool> AvroReader::ReadNextBlock() {
   return true;
 }
 
+absl::StatusOr<absl::string_view> AvroReader::DecompressBlock(
+    const AvroCodec codec, const std::string& raw_block,
+    std::string* decompressed, std::string* working_buffer) {
+  switch (codec) {
+    case AvroCodec::kNull:
+      return raw_block;
+    case AvroCodec::kDeflate:
+      working_buffer->resize(1024 * 1024);
+      decompressed->clear();
+      RETURN_IF_ERROR(utils::Inflate(raw_block, decompressed, working_buffer,
+                                     /*raw_deflate=*/true));
+      return *decompressed;
+  }
+  return absl::InvalidArgumentError("Unsupported codec");
+}
+
+absl::StatusOr<bool> AvroReader::ReadNextBlock() {
+  ASSIGN_OR_RETURN(const bool has_block, ReadNextRawBlock(&current_block_));
+  if (!has_block) {
+    return false;
+  }
+  num_objects_in_current_block_ = current_block_.num_records;
+  next_object_in_current_block_ = 0;
+
+  ASSIGN_OR_RETURN(const absl::string_view block,
+                   DecompressBlock(codec_, current_block_.data,
+                                   &current_block_decompressed_,
+                                   &zlib_working_buffer_));
+  cursor_ = internal::BlockCursor(block);
+  return true;
+}
+
 absl::StatusOr<bool> AvroReader::ReadNextRecord() {
-  if (!current_block_reader_.has_value() ||
-      current_block_reader_.value().left() == 0) {
+  if (cursor_.left() == 0) {
     // Read a new block of data.
     DCHECK_EQ(next_object_in_current_block_, num_objects_in_current_block_);
     ASSIGN_OR_RETURN(const bool has_next_block, ReadNextBlock());
@@ -395,48 +412,48 @@ absl::StatusOr<bool> AvroReader::ReadNextRecord() {
   return true;
 }
 
-absl::StatusOr<std::optional<bool>> AvroReader::ReadNextFieldBoolean(
+absl::StatusOr<std::optional<bool>> AvroBlockReader::ReadNextFieldBoolean(
     const AvroField& field) {
   MAYBE_SKIP_OPTIONAL(field);
-  ASSIGN_OR_RETURN(const auto value, current_block_reader_->ReadByte());
+  ASSIGN_OR_RETURN(const auto value, cursor_.ReadByte());
   return value;
 }
 
-absl::StatusOr<std::optional<int64_t>> AvroReader::ReadNextFieldInteger(
+absl::StatusOr<std::optional<int64_t>> AvroBlockReader::ReadNextFieldInteger(
     const AvroField& field) {
   MAYBE_SKIP_OPTIONAL(field);
-  return internal::ReadInteger(&current_block_reader_.value());
+  return cursor_.ReadInteger();
 }
 
-absl::StatusOr<std::optional<float>> AvroReader::ReadNextFieldFloat(
+absl::StatusOr<std::optional<float>> AvroBlockReader::ReadNextFieldFloat(
     const AvroField& field) {
   MAYBE_SKIP_OPTIONAL(field);
-  return internal::ReadFloat(&current_block_reader_.value());
+  return cursor_.ReadFloat();
 }
 
-absl::StatusOr<std::optional<double>> AvroReader::ReadNextFieldDouble(
+absl::StatusOr<std::optional<double>> AvroBlockReader::ReadNextFieldDouble(
     const AvroField& field) {
   MAYBE_SKIP_OPTIONAL(field);
-  return internal::ReadDouble(&current_block_reader_.value());
+  return cursor_.ReadDouble();
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldString(const AvroField& field,
-                                                     std::string* value) {
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldString(
+    const AvroField& field, std::string* value) {
   STATUS_CHECK(field.type == AvroType::kString ||
                field.type == AvroType::kBytes);
   if (field.optional) {
-    ASSIGN_OR_RETURN(const auto has_value, current_block_reader_->ReadByte());
+    ASSIGN_OR_RETURN(const auto has_value, cursor_.ReadByte());
     if (!has_value) {
       return false;
     }
     STATUS_CHECK_EQ(has_value, 2);
   }
-  RETURN_IF_ERROR(internal::ReadString(&current_block_reader_.value(), value));
+  RETURN_IF_ERROR(cursor_.ReadString(value));
   return true;
 }
 
 template <typename T, typename R>
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayFloatingPointTemplate(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayFloatingPointTemplate(
     const AvroField& field, std::vector<T>* values) {
   STATUS_CHECK(field.type == AvroType::kArray);
   STATUS_CHECK(field.sub_type == AvroType::kFloat ||
@@ -444,70 +461,77 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayFloatingPointTemplate(
 
   values->clear();
   if (field.optional) {
-    ASSIGN_OR_RETURN(const auto has_value, current_block_reader_->ReadByte());
+    ASSIGN_OR_RETURN(const auto has_value, cursor_.ReadByte());
     if (!has_value) {
       return false;
     }
     STATUS_CHECK_EQ(has_value, 2);
   }
   while (true) {
-    ASSIGN_OR_RETURN(auto num_values,
-                     internal::ReadInteger(&current_block_reader_.value()));
+    ASSIGN_OR_RETURN(auto num_values, cursor_.ReadInteger());
     if (num_values == 0) {
       break;
     }
     if (num_values < 0) {
-      ASSIGN_OR_RETURN(auto block_size,
-                       internal::ReadInteger(&current_block_reader_.value()));
+      ASSIGN_OR_RETURN(auto block_size, cursor_.ReadInteger());
       (void)block_size;
       num_values = -num_values;
     }
     STATUS_CHECK_GE(num_values, 0);
+    if constexpr (std::is_same_v<T, R>) {
+      if (!field.sub_optional) {
+        // The values are contiguous in the block.
+        const size_t begin = values->size();
+        values->resize(begin + num_values);
+        RETURN_IF_ERROR(
+            cursor_.ReadFloatingPoints(num_values, values->data() + begin));
+        continue;
+      }
+    }
     values->reserve(values->size() + num_values);
     for (size_t value_idx = 0; value_idx < num_values; value_idx++) {
       if (field.sub_optional) {
-        ASSIGN_OR_RETURN(const auto has_sub_value,
-                         current_block_reader_->ReadByte());
+        ASSIGN_OR_RETURN(const auto has_sub_value, cursor_.ReadByte());
         if (!has_sub_value) {
           values->push_back(std::numeric_limits<T>::quiet_NaN());
           continue;
         }
         STATUS_CHECK_EQ(has_sub_value, 2);
       }
-      ASSIGN_OR_RETURN(R value, internal::ReadFloatingPointTemplate<R>(
-                                    &current_block_reader_.value()));
+      R value;
+      RETURN_IF_ERROR(cursor_.ReadFloatingPoints(1, &value));
       values->push_back(value);
     }
   }
   return true;
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayFloat(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayFloat(
     const AvroField& field, std::vector<float>* values) {
   STATUS_CHECK(field.sub_type == AvroType::kFloat);
   return ReadNextFieldArrayFloatingPointTemplate<float>(field, values);
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayDouble(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayDouble(
     const AvroField& field, std::vector<double>* values) {
   STATUS_CHECK(field.sub_type == AvroType::kDouble);
   return ReadNextFieldArrayFloatingPointTemplate<double>(field, values);
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayDoubleIntoFloat(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayDoubleIntoFloat(
     const AvroField& field, std::vector<float>* values) {
   STATUS_CHECK(field.sub_type == AvroType::kDouble);
   return ReadNextFieldArrayFloatingPointTemplate<float, double>(field, values);
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayString(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayString(
     const AvroField& field, std::vector<std::string>* values) {
   STATUS_CHECK(field.type == AvroType::kArray);
   STATUS_CHECK(field.sub_type == AvroType::kString ||
                field.sub_type == AvroType::kBytes);
 
   if (field.optional) {
-    ASSIGN_OR_RETURN(const auto has_value, current_block_reader_->ReadByte());
+    ASSIGN_OR_RETURN(const auto has_value, cursor_.ReadByte());
     if (!has_value) {
       return false;
     }
@@ -515,30 +539,26 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayString(
   }
 
   while (true) {
-    ASSIGN_OR_RETURN(auto num_values,
-                     internal::ReadInteger(&current_block_reader_.value()));
+    ASSIGN_OR_RETURN(auto num_values, cursor_.ReadInteger());
     if (num_values == 0) {
       break;
     }
     values->reserve(values->size() + num_values);
     if (num_values < 0) {
-      ASSIGN_OR_RETURN(auto block_size,
-                       internal::ReadInteger(&current_block_reader_.value()));
+      ASSIGN_OR_RETURN(auto block_size, cursor_.ReadInteger());
       (void)block_size;
       num_values = -num_values;
     }
     for (size_t value_idx = 0; value_idx < num_values; value_idx++) {
       if (field.sub_optional) {
-        ASSIGN_OR_RETURN(const auto has_sub_value,
-                         current_block_reader_->ReadByte());
+        ASSIGN_OR_RETURN(const auto has_sub_value, cursor_.ReadByte());
         if (!has_sub_value) {
           values->push_back("");
           continue;
         }
       }
       std::string sub_value;
-      RETURN_IF_ERROR(
-          internal::ReadString(&current_block_reader_.value(), &sub_value));
+      RETURN_IF_ERROR(cursor_.ReadString(&sub_value));
       values->push_back(std::move(sub_value));
     }
   }
@@ -546,13 +566,13 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayString(
   return true;
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayFloat(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayArrayFloat(
     const AvroField& field, std::vector<std::vector<float>>* values) {
   STATUS_CHECK(field.sub_sub_type == AvroType::kFloat);
   return ReadNextFieldArrayArrayFloatingPointTemplate<float>(field, values);
 }
 
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayDoubleIntoFloat(
+absl::StatusOr<bool> AvroBlockReader::ReadNextFieldArrayArrayDoubleIntoFloat(
     const AvroField& field, std::vector<std::vector<float>>* values) {
   STATUS_CHECK(field.sub_sub_type == AvroType::kDouble);
   return ReadNextFieldArrayArrayFloatingPointTemplate<float, double>(field,
@@ -560,7 +580,8 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayDoubleIntoFloat(
 }
 
 template <typename T, typename R>
-absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayFloatingPointTemplate(
+absl::StatusOr<bool>
+AvroBlockReader::ReadNextFieldArrayArrayFloatingPointTemplate(
     const AvroField& field, std::vector<std::vector<T>>* values) {
   STATUS_CHECK(field.type == AvroType::kArray);
   STATUS_CHECK(field.sub_type == AvroType::kArray);
@@ -569,7 +590,7 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayFloatingPointTemplate(
 
   values->clear();
   if (field.optional) {
-    ASSIGN_OR_RETURN(const auto has_value, current_block_reader_->ReadByte());
+    ASSIGN_OR_RETURN(const auto has_value, cursor_.ReadByte());
     if (!has_value) {
       return false;
     }
@@ -577,14 +598,12 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayFloatingPointTemplate(
   }
 
   while (true) {
-    ASSIGN_OR_RETURN(auto num_values,
-                     internal::ReadInteger(&current_block_reader_.value()));
+    ASSIGN_OR_RETURN(auto num_values, cursor_.ReadInteger());
     if (num_values == 0) {
       break;
     }
     if (num_values < 0) {
-      ASSIGN_OR_RETURN(auto block_size,
-                       internal::ReadInteger(&current_block_reader_.value()));
+      ASSIGN_OR_RETURN(auto block_size, cursor_.ReadInteger());
       (void)block_size;
       num_values = -num_values;
     }
@@ -609,6 +628,85 @@ absl::StatusOr<bool> AvroReader::ReadNextFieldArrayArrayFloatingPointTemplate(
 
 namespace internal {
 
+absl::StatusOr<int64_t> BlockCursor::ReadInteger() {
+  // Note: Integers are encoded with variable length + zigzag encoding. A 64
+  // bits integer is encoded with at most 10 bytes.
+  constexpr size_t kMaxVarintBytes = 10;
+  const auto* data =
+      reinterpret_cast<const uint8_t*>(content_.data()) + current_;
+  const size_t max_num_bytes = std::min(left(), kMaxVarintBytes);
+
+  // Most integers (e.g. lengths, counts, small values) fit in a single byte.
+  if (max_num_bytes > 0 && data[0] < 0x80) {
+    current_++;
+    const uint64_t value = data[0];
+    return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+  }
+
+  // Variable length decoding. The bytes are only checked against
+  // "max_num_bytes" instead of the end of the block.
+  uint64_t value = 0;
+  size_t num_bytes = 0;
+  uint64_t byte = 0x80;
+  while (num_bytes < max_num_bytes && (byte & 0x80)) {
+    byte = data[num_bytes];
+    value |= (byte & 0x7F) << (7 * num_bytes);
+    num_bytes++;
+  }
+  if (byte & 0x80) {
+    if (max_num_bytes < kMaxVarintBytes) {
+      return absl::InvalidArgumentError("Unexpected end of stream");
+    }
+    return absl::InvalidArgumentError("Invalid variable length integer");
+  }
+  current_ += num_bytes;
+
+  // Zigzag decoding
+  return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+}
+
+absl::Status BlockCursor::ReadString(std::string* value) {
+  ASSIGN_OR_RETURN(const auto length, ReadInteger());
+  if (length < 0 || length > left()) {
+    return absl::InvalidArgumentError("Unexpected end of stream");
+  }
+  value->assign(content_.data() + current_, length);
+  current_ += length;
+  return absl::OkStatus();
+}
+
+template <typename T>
+absl::Status BlockCursor::ReadFloatingPoints(const size_t num_values,
+                                             T* values) {
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>);
+  const size_t num_bytes = num_values * sizeof(T);
+  if (num_bytes > left()) {
+    return absl::InvalidArgumentError("Unexpected end of stream");
+  }
+  if (num_bytes > 0) {
+    std::memcpy(values, content_.data() + current_, num_bytes);
+  }
+  current_ += num_bytes;
+  return absl::OkStatus();
+}
+
+template absl::Status BlockCursor::ReadFloatingPoints(size_t num_values,
+                                                      float* values);
+template absl::Status BlockCursor::ReadFloatingPoints(size_t num_values,
+                                                      double* values);
+
+absl::StatusOr<float> BlockCursor::ReadFloat() {
+  float value;
+  RETURN_IF_ERROR(ReadFloatingPoints(1, &value));
+  return value;
+}
+
+absl::StatusOr<double> BlockCursor::ReadDouble() {
+  double value;
+  RETURN_IF_ERROR(ReadFloatingPoints(1, &value));
+  return value;
+}
+
 absl::StatusOr<int64_t> ReadInteger(utils::InputByteStream* stream) {
   // Note: Integers are encoded with variable length + zigzag encoding.
 
@@ -76,23 +76,65 @@ struct AvroField {
   friend std::ostream& operator<<(std::ostream& os, const AvroField& field);
 };
 
-// Class to read Avro files.
-// Avro 1.12.0 file format:
-// https://avro.apache.org/docs/1.12.0/specification/
-class AvroReader {
+namespace internal {
+
+// Cursor over the decompressed content of an Avro block.
+//
+// Unlike "utils::InputByteStream", the methods are not virtual and read the
+// block in place. All the reads are checked against the end of the block.
+class BlockCursor {
  public:
-  // Creates a reader for the given Avro file.
-  static absl::StatusOr<std::unique_ptr<AvroReader>> Create(
-      absl::string_view path);
+  BlockCursor() = default;
+  explicit BlockCursor(absl::string_view content) : content_(content) {}
 
-  // Extracts the schema of the given Avro file.
-  static absl::StatusOr<std::string> ExtractSchema(absl::string_view path);
+  // Number of bytes left to read.
+  size_t left() const { return content_.size() - current_; }
 
-  // Reads the next record. Returns false if the end of the file is reached.
-  absl::StatusOr<bool> ReadNextRecord();
+  absl::StatusOr<char> ReadByte() {
+    if (current_ == content_.size()) {
+      return absl::InvalidArgumentError("Unexpected end of stream");
+    }
+    return content_[current_++];
+  }
 
-  // Skips all the fields (i.e., read with ReadNextField*).
-  absl::Status SkipAllFieldsInRecord();
+  // Reads a variable length + zigzag encoded integer.
+  absl::StatusOr<int64_t> ReadInteger();
+
+  absl::Status ReadString(std::string* value);
+
+  absl::StatusOr<float> ReadFloat();
+  absl::StatusOr<double> ReadDouble();
+
+  // Reads "num_values" consecutive float or double values.
+  template <typename T>
+  absl::Status ReadFloatingPoints(size_t num_values, T* values);
+
+ private:
+  // Content of the block.
+  absl::string_view content_;
+
+  // Next byte to read in "content_".
+  size_t current_ = 0;
+};
+
+}  // namespace internal
+
+// Block of an Avro file, as stored in the file i.e. possibly compressed.
+struct AvroRawBlock {
+  // Number of records in the block.
+  int64_t num_records = 0;
+  std::string data;
+};
+
+// Decodes the fields of the records of a decompressed Avro block. The fields of
+// a record should be read in the order of the schema.
+class AvroBlockReader {
+ public:
+  AvroBlockReader() = default;
+  explicit AvroBlockReader(absl::string_view block) : cursor_(block) {}
+
+  // Number of bytes of the block left to read.
+  size_t left() const { return cursor_.left(); }
 
   // Reads the next field. Returns nullopt if the field is optional and not set.
   absl::StatusOr<std::optional<bool>> ReadNextFieldBoolean(
@@ -129,6 +171,44 @@ class AvroReader {
   absl::StatusOr<bool> ReadNextFieldArrayArrayFloatingPointTemplate(
       const AvroField& field, std::vector<std::vector<T>>* values);
 
+ protected:
+  internal::BlockCursor cursor_;
+};
+
+// Class to read Avro files.
+// Avro 1.12.0 file format:
+// https://avro.apache.org/docs/1.12.0/specification/
+//
+// The records are read sequentially with "ReadNextRecord" and the
+// "ReadNextField*" methods. Alternatively, the blocks can be read without
+// being decompressed with "ReadNextRawBlock", and then decompressed
+// ("DecompressBlock") and decoded ("AvroBlockReader") concurrently.
+class AvroReader : public AvroBlockReader {
+ public:
+  // Creates a reader for the given Avro file.
+  static absl::StatusOr<std::unique_ptr<AvroReader>> Create(
+      absl::string_view path);
+
+  // Extracts the schema of the given Avro file.
+  static absl::StatusOr<std::string> ExtractSchema(absl::string_view path);
+
+  // Decompresses a raw block. Returns a view to "raw_block" (codec kNull) or to
+  // "decompressed". "working_buffer" is a zlib working buffer.
+  static absl::StatusOr<absl::string_view> DecompressBlock(
+      AvroCodec codec, const std::string& raw_block, std::string* decompressed,
+      std::string* working_buffer);
+
+  // Reads the next record. Returns false if the end of the file is reached.
+  absl::StatusOr<bool> ReadNextRecord();
+
+  // Reads the next block without decompressing nor decoding it. Returns false
+  // if the end of the file is reached. Should not be mixed with
+  // "ReadNextRecord".
+  absl::StatusOr<bool> ReadNextRawBlock(AvroRawBlock* block);
+
+  // Skips all the fields (i.e., read with ReadNextField*).
+  absl::Status SkipAllFieldsInRecord();
+
   // Closes the reader.
   absl::Status Close();
 
@@ -141,13 +221,15 @@ class AvroReader {
 
   const std::string& schema_string() const { return schema_string_; }
 
+  AvroCodec codec() const { return codec_; }
+
  private:
   AvroReader(std::unique_ptr<utils::InputByteStream>&& stream);
 
   // Reads the header of the Avro file. Should be called only once.
   absl::StatusOr<std::string> ReadHeader();
 
-  // Reads the next block of the Avro file.
+  // Reads and decompresses the next block of the Avro file.
   absl::StatusOr<bool> ReadNextBlock();
 
   std::unique_ptr<utils::InputByteStream> stream_;
@@ -160,10 +242,9 @@ class AvroReader {
   AvroCodec codec_ = AvroCodec::kNull;
 
   // Raw and uncompressed data of the current block.
-  std::string current_block_;
+  AvroRawBlock current_block_;
   std::string current_block_decompressed_;
   std::string zlib_working_buffer_;
-  std::optional<utils::StringViewInputByteStream> current_block_reader_;
 
   size_t num_objects_in_current_block_ = 0;
   size_t next_object_in_current_block_ = 0;
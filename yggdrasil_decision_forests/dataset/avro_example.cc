@@ -18,6 +18,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -33,6 +35,9 @@
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
@@ -138,40 +143,17 @@ absl::Status InitializeUnstackedColumn(
   return absl::OkStatus();
 }
 
-}  // namespace
-
-absl::Status AvroExampleReader::Implementation::OpenShard(
-    absl::string_view path) {
-  const bool is_first_file = reader_ == nullptr;
-  auto save_previous_reader = std::move(reader_);
-  ASSIGN_OR_RETURN(reader_, AvroReader::Create(path));
-  if (is_first_file) {
-    RETURN_IF_ERROR(ComputeReadingMaps(reader_->fields(), dataspec_,
-                                       &univariate_field_idx_to_column_idx_,
-                                       &multivariate_field_idx_to_unroll_idx_));
-  } else {
-    if (save_previous_reader->fields() != reader_->fields()) {
-      return absl::InvalidArgumentError(
-          "All the files in the same shard should have the same schema.");
-    }
-  }
-  return absl::OkStatus();
-}
-
-absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
-    proto::Example* example) {
-  example->clear_attributes();
-  while (example->attributes_size() < dataspec_.columns_size()) {
-    example->add_attributes();
-  }
-
-  ASSIGN_OR_RETURN(const bool has_record, reader_->ReadNextRecord());
-  if (!has_record) {
-    return false;
-  }
-
+// Decodes the fields of the next record of "reader" into "example".
+// "example" should contain one empty attribute for each column of "dataspec".
+absl::Status ReadRecord(
+    const std::vector<AvroField>& fields,
+    const proto::DataSpecification& dataspec,
+    const std::vector<CategoricalDictionary>& categorical_dictionaries,
+    const std::vector<int>& univariate_field_idx_to_column_idx,
+    const std::vector<int>& multivariate_field_idx_to_unroll_idx,
+    AvroBlockReader* reader, proto::Example* example) {
   int field_idx = 0;
-  for (const auto& field : reader_->fields()) {
+  for (const auto& field : fields) {
     switch (field.type) {
       case AvroType::kUnknown:
       case AvroType::kNull:
@@ -179,8 +161,8 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
 
       case AvroType::kBoolean: {
         ASSIGN_OR_RETURN(const auto value,
-                         reader_->ReadNextFieldBoolean(field));
-        const int col_idx = univariate_field_idx_to_column_idx_[field_idx];
+                         reader->ReadNextFieldBoolean(field));
+        const int col_idx = univariate_field_idx_to_column_idx[field_idx];
         if (col_idx == -1) {
           // Ignore field.
           break;
@@ -194,8 +176,8 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
       case AvroType::kLong:
       case AvroType::kInt: {
         ASSIGN_OR_RETURN(const auto value,
-                         reader_->ReadNextFieldInteger(field));
-        const int col_idx = univariate_field_idx_to_column_idx_[field_idx];
+                         reader->ReadNextFieldInteger(field));
+        const int col_idx = univariate_field_idx_to_column_idx[field_idx];
         if (col_idx == -1) {
           // Ignore field.
           break;
@@ -210,14 +192,14 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
       case AvroType::kFloat: {
         std::optional<double> value;
         if (field.type == AvroType::kFloat) {
-          ASSIGN_OR_RETURN(value, reader_->ReadNextFieldFloat(field));
+          ASSIGN_OR_RETURN(value, reader->ReadNextFieldFloat(field));
         } else {
-          ASSIGN_OR_RETURN(value, reader_->ReadNextFieldDouble(field));
+          ASSIGN_OR_RETURN(value, reader->ReadNextFieldDouble(field));
         }
         if (value.has_value() && std::isnan(*value)) {
           value = absl::nullopt;
         }
-        const int col_idx = univariate_field_idx_to_column_idx_[field_idx];
+        const int col_idx = univariate_field_idx_to_column_idx[field_idx];
         if (col_idx == -1) {
           // Ignore field.
           break;
@@ -232,8 +214,8 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
       case AvroType::kString: {
         std::string value;
         ASSIGN_OR_RETURN(const auto has_value,
-                         reader_->ReadNextFieldString(field, &value));
-        const int col_idx = univariate_field_idx_to_column_idx_[field_idx];
+                         reader->ReadNextFieldString(field, &value));
+        const int col_idx = univariate_field_idx_to_column_idx[field_idx];
         if (col_idx == -1) {
           // Ignore field.
           break;
@@ -242,8 +224,7 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
           break;
         }
         ASSIGN_OR_RETURN(auto int_value,
-                         CategoricalStringToValueWithStatus(
-                             value, dataspec_.columns(col_idx)));
+                         categorical_dictionaries[col_idx].Lookup(value));
         example->mutable_attributes(col_idx)->set_categorical(int_value);
       } break;
 
@@ -255,11 +236,11 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
             std::vector<float> values;
             if (field.sub_type == AvroType::kFloat) {
               ASSIGN_OR_RETURN(
-                  has_value, reader_->ReadNextFieldArrayFloat(field, &values));
+                  has_value, reader->ReadNextFieldArrayFloat(field, &values));
             } else {
               ASSIGN_OR_RETURN(
                   has_value,
-                  reader_->ReadNextFieldArrayDoubleIntoFloat(field, &values));
+                  reader->ReadNextFieldArrayDoubleIntoFloat(field, &values));
             }
             if (!has_value) {
               break;
@@ -267,12 +248,12 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
 
             // Check if field used.
             const auto unstacked_idx =
-                multivariate_field_idx_to_unroll_idx_[field_idx];
+                multivariate_field_idx_to_unroll_idx[field_idx];
             if (unstacked_idx == -1) {
               break;
             }
 
-            auto& unstacked = dataspec_.unstackeds(unstacked_idx);
+            auto& unstacked = dataspec.unstackeds(unstacked_idx);
             for (int dim_idx = 0; dim_idx < values.size(); dim_idx++) {
               const int col_idx = unstacked.begin_column_idx() + dim_idx;
               const float value = values[dim_idx];
@@ -286,23 +267,22 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
           case AvroType::kBytes: {
             std::vector<std::string> values;
             ASSIGN_OR_RETURN(const auto has_value,
-                             reader_->ReadNextFieldArrayString(field, &values));
+                             reader->ReadNextFieldArrayString(field, &values));
             if (!has_value) {
               break;
             }
 
             const auto univariate_col_idx =
-                univariate_field_idx_to_column_idx_[field_idx];
+                univariate_field_idx_to_column_idx[field_idx];
             if (univariate_col_idx != -1) {
-              const auto& col_spec = dataspec_.columns(univariate_col_idx);
+              const auto& dictionary =
+                  categorical_dictionaries[univariate_col_idx];
               auto* dst = example->mutable_attributes(univariate_col_idx)
                               ->mutable_categorical_set()
                               ->mutable_values();
               dst->Reserve(values.size());
               for (const auto& value : values) {
-                ASSIGN_OR_RETURN(
-                    auto int_value,
-                    CategoricalStringToValueWithStatus(value, col_spec));
+                ASSIGN_OR_RETURN(auto int_value, dictionary.Lookup(value));
                 dst->Add(int_value);
               }
               // Sets are expected to be sorted.
@@ -313,18 +293,17 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
 
             // Check if field used.
             const auto unstacked_idx =
-                multivariate_field_idx_to_unroll_idx_[field_idx];
+                multivariate_field_idx_to_unroll_idx[field_idx];
             if (unstacked_idx == -1) {
               break;
             }
 
-            auto& unstacked = dataspec_.unstackeds(unstacked_idx);
+            auto& unstacked = dataspec.unstackeds(unstacked_idx);
             for (int dim_idx = 0; dim_idx < values.size(); dim_idx++) {
               const int col_idx = unstacked.begin_column_idx() + dim_idx;
-              const auto& col_spec = dataspec_.columns(col_idx);
-              ASSIGN_OR_RETURN(auto int_value,
-                               CategoricalStringToValueWithStatus(
-                                   values[dim_idx], col_spec));
+              ASSIGN_OR_RETURN(
+                  auto int_value,
+                  categorical_dictionaries[col_idx].Lookup(values[dim_idx]));
               example->mutable_attributes(col_idx)->set_categorical(int_value);
             }
           } break;
@@ -339,11 +318,11 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
                 if (field.sub_sub_type == AvroType::kFloat) {
                   ASSIGN_OR_RETURN(
                       has_value,
-                      reader_->ReadNextFieldArrayArrayFloat(field, &values));
+                      reader->ReadNextFieldArrayArrayFloat(field, &values));
                 } else {
                   ASSIGN_OR_RETURN(
                       has_value,
-                      reader_->ReadNextFieldArrayArrayDoubleIntoFloat(field,
+                      reader->ReadNextFieldArrayArrayDoubleIntoFloat(field,
                                                                       &values));
                 }
 
@@ -351,7 +330,7 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
                   break;
                 }
                 const int col_idx =
-                    univariate_field_idx_to_column_idx_[field_idx];
+                    univariate_field_idx_to_column_idx[field_idx];
                 if (col_idx == -1) {
                   // Ignore field.
                   break;
@@ -381,10 +360,154 @@ absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
     }
     field_idx++;
   }
-  DCHECK_EQ(field_idx, reader_->fields().size());
+  DCHECK_EQ(field_idx, fields.size());
+  return absl::OkStatus();
+}
+
+
+}  // namespace
+
+absl::Status AvroExampleReader::Implementation::OpenShard(
+    absl::string_view path) {
+  const bool is_first_file = reader_ == nullptr;
+  auto save_previous_reader = std::move(reader_);
+  ASSIGN_OR_RETURN(reader_, AvroReader::Create(path));
+  if (is_first_file) {
+    RETURN_IF_ERROR(ComputeReadingMaps(reader_->fields(), dataspec_,
+                                       &univariate_field_idx_to_column_idx_,
+                                       &multivariate_field_idx_to_unroll_idx_));
+  } else {
+    if (save_previous_reader->fields() != reader_->fields()) {
+      return absl::InvalidArgumentError(
+          "All the files in the same shard should have the same schema.");
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<bool> AvroExampleReader::Implementation::NextInShard(
+    proto::Example* example) {
+  example->clear_attributes();
+  while (example->attributes_size() < dataspec_.columns_size()) {
+    example->add_attributes();
+  }
+
+  ASSIGN_OR_RETURN(const bool has_record, reader_->ReadNextRecord());
+  if (!has_record) {
+    return false;
+  }
+
+  RETURN_IF_ERROR(ReadRecord(reader_->fields(), dataspec_,
+                             categorical_dictionaries_,
+                             univariate_field_idx_to_column_idx_,
+                             multivariate_field_idx_to_unroll_idx_,
+                             reader_.get(), example));
   return true;
 }
 
+absl::Status ReadAvroFileInParallel(
+    const absl::string_view path, const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns, int num_threads,
+    const std::function<absl::Status(const VerticalDataset&)>& consume) {
+  num_threads = std::max(num_threads, 1);
+  ASSIGN_OR_RETURN(const auto reader, AvroReader::Create(path));
+  std::vector<int> univariate_field_idx_to_column_idx;
+  std::vector<int> multivariate_field_idx_to_unroll_idx;
+  RETURN_IF_ERROR(ComputeReadingMaps(reader->fields(), data_spec,
+                                     &univariate_field_idx_to_column_idx,
+                                     &multivariate_field_idx_to_unroll_idx));
+  const std::vector<CategoricalDictionary> categorical_dictionaries =
+      BuildCategoricalDictionaries(data_spec);
+  const AvroCodec codec = reader->codec();
+
+  // Decompression buffers of each thread.
+  struct Buffers {
+    std::string decompressed;
+    std::string zlib_working_buffer;
+  };
+  std::vector<Buffers> buffers(num_threads);
+
+  using Result = absl::StatusOr<std::unique_ptr<VerticalDataset>>;
+  utils::concurrency::StreamProcessor<AvroRawBlock, Result> processor(
+      "AvroBlockReader", num_threads,
+      [&](AvroRawBlock raw_block, const int thread_idx) -> Result {
+        auto& thread_buffers = buffers[thread_idx];
+        ASSIGN_OR_RETURN(const absl::string_view content,
+                         AvroReader::DecompressBlock(
+                             codec, raw_block.data,
+                             &thread_buffers.decompressed,
+                             &thread_buffers.zlib_working_buffer));
+        AvroBlockReader block_reader(content);
+
+        auto chunk = std::make_unique<VerticalDataset>();
+        chunk->set_data_spec(data_spec);
+        RETURN_IF_ERROR(chunk->CreateColumnsFromDataspec());
+        chunk->Reserve(raw_block.num_records, load_columns);
+        proto::Example example;
+        for (int64_t record_idx = 0; record_idx < raw_block.num_records;
+             record_idx++) {
+          example.clear_attributes();
+          while (example.attributes_size() < data_spec.columns_size()) {
+            example.add_attributes();
+          }
+          RETURN_IF_ERROR(ReadRecord(
+              reader->fields(), data_spec, categorical_dictionaries,
+              univariate_field_idx_to_column_idx,
+              multivariate_field_idx_to_unroll_idx, &block_reader, &example));
+          RETURN_IF_ERROR(
+              chunk->AppendExampleWithStatus(example, load_columns));
+        }
+        if (block_reader.left() != 0) {
+          return absl::InvalidArgumentError(absl::StrCat(
+              "The avro block contains ", block_reader.left(),
+              " bytes after its ", raw_block.num_records, " records"));
+        }
+        return chunk;
+      },
+      /*result_in_order=*/true);
+  processor.StartWorkers();
+
+  // Reads and submits the next block. Returns false if the end of the file is
+  // reached.
+  const auto submit_next_block = [&]() -> absl::StatusOr<bool> {
+    AvroRawBlock raw_block;
+    ASSIGN_OR_RETURN(const bool has_block,
+                     reader->ReadNextRawBlock(&raw_block));
+    if (!has_block) {
+      processor.CloseSubmits();
+      return false;
+    }
+    processor.Submit(std::move(raw_block));
+    return true;
+  };
+
+  // Only a limited number of blocks are scheduled in advance to bound the
+  // memory usage.
+  const int max_pending_blocks = 2 * num_threads;
+  int num_pending_blocks = 0;
+  bool has_more_blocks = true;
+  while (has_more_blocks && num_pending_blocks < max_pending_blocks) {
+    ASSIGN_OR_RETURN(has_more_blocks, submit_next_block());
+    num_pending_blocks += has_more_blocks;
+  }
+
+  while (num_pending_blocks > 0) {
+    std::optional<Result> result = processor.GetResult();
+    if (!result.has_value()) {
+      return absl::InternalError("Missing avro block");
+    }
+    num_pending_blocks--;
+    if (has_more_blocks) {
+      ASSIGN_OR_RETURN(has_more_blocks, submit_next_block());
+      num_pending_blocks += has_more_blocks;
+    }
+    RETURN_IF_ERROR(result->status());
+    RETURN_IF_ERROR(consume(*result->value()));
+  }
+  return reader->Close();
+}
+
 absl::StatusOr<dataset::proto::DataSpecification> CreateDataspec(
     absl::string_view path,
     const dataset::proto::DataSpecificationGuide& guide) {
@@ -423,6 +546,7 @@ absl::StatusOr<dataset::proto::DataSpecification> CreateDataspecImpl(
   while (accumulator.columns_size() < dataspec.columns_size()) {
     accumulator.add_columns();
   }
+  SetDictionaryLimits(guide, &accumulator);
 
   size_t record_idx;
   for (record_idx = 0; true; record_idx++) {
@@ -550,7 +674,8 @@ absl::StatusOr<dataset::proto::DataSpecification> CreateDataspecImpl(
             switch (col_spec_->type()) {
               case proto::ColumnType::CATEGORICAL:
                 RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(
-                    std::vector<std::string>{value}, col_spec_));
+                    std::vector<std::string>{value}, col_spec_,
+                    accumulator.mutable_columns(col_idx)));
                 break;
               default:
                 return absl::InvalidArgumentError(absl::StrCat(
@@ -632,8 +757,9 @@ absl::StatusOr<dataset::proto::DataSpecification> CreateDataspecImpl(
                 } else {
                   switch (dataspec.columns(univariate_col_idx).type()) {
                     case proto::ColumnType::CATEGORICAL_SET:
-                      RETURN_IF_ERROR(
-                          AddTokensToCategoricalColumnSpec(values, col_spec));
+                      RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(
+                          values, col_spec,
+                          accumulator.mutable_columns(univariate_col_idx)));
                       break;
                     default:
                       return absl::InvalidArgumentError(absl::StrCat(
@@ -672,7 +798,7 @@ absl::StatusOr<dataset::proto::DataSpecification> CreateDataspecImpl(
                       case proto::ColumnType::CATEGORICAL:
                         RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(
                             std::vector<std::string>{values[dim_idx]},
-                            col_spec));
+                            col_spec, accumulator.mutable_columns(col_idx)));
                         break;
                       default:
                         return absl::InvalidArgumentError(
@@ -19,6 +19,7 @@
 #define YGGDRASIL_DECISION_FORESTS_DATASET_AVRO_EXAMPLE_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -28,9 +29,11 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/dataset/avro.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 
 namespace yggdrasil_decision_forests::dataset::avro {
@@ -64,7 +67,9 @@ class AvroExampleReader final : public ExampleReaderInterface {
     explicit Implementation(
         const proto::DataSpecification& data_spec,
         const std::optional<std::vector<int>>& required_columns)
-        : dataspec_(data_spec), required_columns_(required_columns) {}
+        : dataspec_(data_spec),
+          categorical_dictionaries_(BuildCategoricalDictionaries(dataspec_)),
+          required_columns_(required_columns) {}
 
    protected:
     // Opens the Avro file at "path", and check that the header is as expected.
@@ -77,6 +82,9 @@ class AvroExampleReader final : public ExampleReaderInterface {
     // The data spec.
     const proto::DataSpecification dataspec_;
 
+    // Compiled categorical dictionaries of "dataspec_".
+    const std::vector<CategoricalDictionary> categorical_dictionaries_;
+
     // Currently, open file;
     std::unique_ptr<AvroReader> reader_;
 
@@ -110,6 +118,17 @@ class AvroDataSpecCreator : public AbstractDataSpecCreator {
 
 REGISTER_AbstractDataSpecCreator(AvroDataSpecCreator, "FORMAT_AVRO");
 
+// Reads a single Avro file with "num_threads" threads. The blocks of the file
+// are read sequentially, and decompressed and decoded concurrently into the
+// columns of a VerticalDataset each. "consume" is called on each block, in the
+// order of the file, in the calling thread. If "load_columns" is set, only the
+// columns in "load_columns" are populated.
+absl::Status ReadAvroFileInParallel(
+    absl::string_view path, const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns, int num_threads,
+    const std::function<absl::Status(const VerticalDataset&)>& consume);
+
 namespace internal {
 
 // Infers the dataspec from the Avro file i.e. find the columns, but do not
@@ -20,11 +20,15 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 #include "yggdrasil_decision_forests/utils/testing_macros.h"
@@ -33,6 +37,7 @@ namespace yggdrasil_decision_forests::dataset::avro {
 namespace {
 
 using test::EqualsProto;
+using test::StatusIs;
 
 std::string DatasetDir() {
   return file::JoinPath(
@@ -631,5 +636,88 @@ Terminology:
   EXPECT_EQ(num_rows, 100);
 }
 
+struct LoadInParallelCase {
+  std::string filename;
+  // If true, "f1" is a numerical vector sequence column.
+  bool vector_sequence = false;
+};
+
+SIMPLE_PARAMETERIZED_TEST(LoadInParallel, LoadInParallelCase,
+                          {
+                              {"toy_codex-null.avro"},
+                              {"toy_codex-deflate.avro"},
+                              {"toy_vector_sequence_from_polars.avro", true},
+                          }) {
+  const auto& test_case = GetParam();
+  const auto dataset_path =
+      absl::StrCat("avro:", file::JoinPath(DatasetDir(), test_case.filename));
+
+  proto::DataSpecificationGuide guide;
+  if (test_case.vector_sequence) {
+    auto* col = guide.add_column_guides();
+    col->set_column_name_pattern("^f1$");
+    col->set_type(proto::ColumnType::NUMERICAL_VECTOR_SEQUENCE);
+  } else {
+    auto* col = guide.add_column_guides();
+    col->set_column_name_pattern("^f_another_array_of_string$");
+    col->set_type(proto::ColumnType::CATEGORICAL_SET);
+  }
+  guide.mutable_default_column_guide()
+      ->mutable_categorial()
+      ->set_min_vocab_frequency(1);
+  proto::DataSpecification data_spec;
+  CreateDataSpec(dataset_path, false, guide, &data_spec);
+
+  LoadConfig sequential_config;
+  sequential_config.num_threads = 1;
+  VerticalDataset expected;
+  ASSERT_OK(LoadVerticalDataset(dataset_path, data_spec, &expected, {},
+                                sequential_config));
+
+  // The blocks of the file are decoded in parallel.
+  LoadConfig parallel_config;
+  parallel_config.num_threads = 4;
+  VerticalDataset dataset;
+  ASSERT_OK(LoadVerticalDataset(dataset_path, data_spec, &dataset, {},
+                                parallel_config));
+
+  ASSERT_EQ(dataset.nrow(), expected.nrow());
+  EXPECT_GT(dataset.nrow(), 0);
+  for (VerticalDataset::row_t row = 0; row < dataset.nrow(); row++) {
+    proto::Example example, expected_example;
+    dataset.ExtractExample(row, &example);
+    expected.ExtractExample(row, &expected_example);
+    EXPECT_THAT(example, EqualsProto(expected_example));
+  }
+}
+
+TEST(LoadInParallel, BlockWithTrailingBytes) {
+  // The first block of "toy_codex-null.avro" contains two records. Its record
+  // count (zigzag encoded "2") directly follows the sync marker of the header.
+  std::string content =
+      file::GetContent(file::JoinPath(DatasetDir(), "toy_codex-null.avro"))
+          .value();
+  const std::string sync_marker = content.substr(content.size() - 16);
+  const size_t block_begin = content.find(sync_marker) + sync_marker.size();
+  ASSERT_EQ(content[block_begin], 4);
+  // Only the first record of the block is announced.
+  content[block_begin] = 2;
+  const std::string path =
+      file::JoinPath(test::TmpDirectory(), "trailing_bytes.avro");
+  ASSERT_OK(file::SetContent(path, content));
+
+  proto::DataSpecification data_spec;
+  CreateDataSpec(absl::StrCat("avro:", file::JoinPath(DatasetDir(),
+                                                      "toy_codex-null.avro")),
+                 false, {}, &data_spec);
+  LoadConfig config;
+  config.num_threads = 4;
+  VerticalDataset dataset;
+  EXPECT_THAT(LoadVerticalDataset(absl::StrCat("avro:", path), data_spec,
+                                  &dataset, {}, config),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "after its 1 records"));
+}
+
 }  // namespace
 }  // namespace yggdrasil_decision_forests::dataset::avro
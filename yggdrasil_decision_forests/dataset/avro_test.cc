@@ -25,6 +25,7 @@
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
@@ -73,6 +74,38 @@ SIMPLE_PARAMETERIZED_TEST(ReadInteger, ReadIntegerCase,
   utils::StringInputByteStream stream(test_case.input);
   ASSERT_OK_AND_ASSIGN(const auto value, internal::ReadInteger(&stream));
   EXPECT_EQ(value, test_case.expected_value);
+
+  // Near the end of the block.
+  internal::BlockCursor cursor(test_case.input);
+  ASSERT_OK_AND_ASSIGN(const auto cursor_value, cursor.ReadInteger());
+  EXPECT_EQ(cursor_value, test_case.expected_value);
+  EXPECT_EQ(cursor.left(), 0);
+
+  // Far from the end of the block.
+  const std::string padded_input = test_case.input + std::string(16, '\xFF');
+  internal::BlockCursor padded_cursor(padded_input);
+  ASSERT_OK_AND_ASSIGN(const auto padded_value, padded_cursor.ReadInteger());
+  EXPECT_EQ(padded_value, test_case.expected_value);
+  EXPECT_EQ(padded_cursor.left(), 16);
+}
+
+TEST(BlockCursor, Errors) {
+  // Truncated integer.
+  internal::BlockCursor truncated_integer("\x80\x80");
+  EXPECT_FALSE(truncated_integer.ReadInteger().ok());
+
+  // Integer with more than 10 bytes.
+  const std::string long_integer(16, '\x80');
+  internal::BlockCursor invalid_integer(long_integer);
+  EXPECT_FALSE(invalid_integer.ReadInteger().ok());
+
+  // String longer than the block.
+  internal::BlockCursor truncated_string("\x08ab");
+  std::string value;
+  EXPECT_FALSE(truncated_string.ReadString(&value).ok());
+
+  internal::BlockCursor truncated_float("\x00\x00");
+  EXPECT_FALSE(truncated_float.ReadFloat().ok());
 }
 
 struct ReadFloatCase {
@@ -344,5 +377,44 @@ TEST(AvroExample, Reader) {
   ASSERT_OK(reader->Close());
 }
 
+TEST(AvroExample, RawBlocks) {
+  for (const auto* filename :
+       {"toy_codex-null.avro", "toy_codex-deflate.avro"}) {
+    ASSERT_OK_AND_ASSIGN(
+        const auto reader,
+        AvroReader::Create(file::JoinPath(DatasetDir(), filename)));
+    AvroRawBlock raw_block;
+    std::string decompressed;
+    std::string working_buffer;
+    int num_records = 0;
+    while (true) {
+      ASSERT_OK_AND_ASSIGN(const bool has_block,
+                           reader->ReadNextRawBlock(&raw_block));
+      if (!has_block) {
+        break;
+      }
+      ASSERT_OK_AND_ASSIGN(
+          const absl::string_view content,
+          AvroReader::DecompressBlock(reader->codec(), raw_block.data,
+                                      &decompressed, &working_buffer));
+      if (num_records == 0) {
+        // The first fields of the first record.
+        AvroBlockReader block_reader(content);
+        ASSERT_OK_AND_ASSIGN(
+            const auto f_boolean,
+            block_reader.ReadNextFieldBoolean(reader->fields()[1]));
+        EXPECT_EQ(f_boolean, true);
+        ASSERT_OK_AND_ASSIGN(
+            const auto f_int,
+            block_reader.ReadNextFieldInteger(reader->fields()[2]));
+        EXPECT_EQ(f_int, 5);
+      }
+      num_records += raw_block.num_records;
+    }
+    EXPECT_EQ(num_records, 2);
+    ASSERT_OK(reader->Close());
+  }
+}
+
 }  // namespace
 }  // namespace yggdrasil_decision_forests::dataset::avro
@@ -0,0 +1,889 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/dataset/columnar_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "absl/base/internal/endian.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/columnar_file.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/zlib.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+namespace {
+
+using proto::ColumnType;
+using Header = proto::ColumnarFileHeader;
+
+constexpr absl::string_view kMagic = "YDFC";
+
+// Alignment of the regions in the file.
+constexpr int64_t kAlignment = 64;
+
+#ifdef ABSL_IS_BIG_ENDIAN
+constexpr Header::ByteOrder kHostByteOrder = Header::BIG_ENDIAN_ORDER;
+#else
+constexpr Header::ByteOrder kHostByteOrder = Header::LITTLE_ENDIAN_ORDER;
+#endif
+
+// Range of a multi-value in a block. Missing values are encoded as
+// {1, 0}. Trivially copyable as it is read with memcpy.
+struct Range {
+  uint64_t first;
+  uint64_t second;
+};
+
+template <typename T>
+absl::string_view AsBytes(const T* values, const size_t num_values) {
+  return {reinterpret_cast<const char*>(values), num_values * sizeof(T)};
+}
+
+// Writes the regions of a file.
+class RegionWriter {
+ public:
+  RegionWriter(utils::OutputByteStream* stream, const bool compress)
+      : stream_(stream), compress_(compress) {}
+
+  // Writes "data" in a new aligned region.
+  absl::Status WriteRegion(absl::string_view data, Header::Region* region) {
+    std::string compressed;
+    if (compress_) {
+      utils::StringOutputByteStream compressed_stream;
+      ASSIGN_OR_RETURN(auto gzip_stream,
+                       utils::GZipOutputByteStream::Create(&compressed_stream));
+      RETURN_IF_ERROR(gzip_stream->Write(data));
+      RETURN_IF_ERROR(gzip_stream->Close());
+      compressed = std::string(compressed_stream.ToString());
+      region->set_uncompressed_size(data.size());
+      data = compressed;
+    }
+    region->set_offset(offset_);
+    region->set_size(data.size());
+    RETURN_IF_ERROR(Write(data));
+    return Pad();
+  }
+
+  absl::Status Write(absl::string_view data) {
+    offset_ += data.size();
+    return stream_->Write(data);
+  }
+
+  // Pads the file until the next aligned offset.
+  absl::Status Pad() {
+    const int64_t padding = (kAlignment - offset_ % kAlignment) % kAlignment;
+    return Write(std::string(padding, '\0'));
+  }
+
+ private:
+  utils::OutputByteStream* stream_;
+  const bool compress_;
+  int64_t offset_ = 0;
+};
+
+// Min/max of the non-missing values of a block.
+class BlockStatistics {
+ public:
+  void Add(const double value) {
+    if (std::isnan(value)) {
+      return;
+    }
+    min_value_ = std::min(min_value_, value);
+    max_value_ = std::max(max_value_, value);
+    empty_ = false;
+  }
+
+  void Export(Header::Block* block) const {
+    if (!empty_) {
+      block->set_min_value(min_value_);
+      block->set_max_value(max_value_);
+    }
+  }
+
+ private:
+  bool empty_ = true;
+  double min_value_ = std::numeric_limits<double>::infinity();
+  double max_value_ = -std::numeric_limits<double>::infinity();
+};
+
+template <typename ColumnT>
+absl::Status WriteScalarBlock(const VerticalDataset::AbstractColumn& src,
+                              const int64_t begin, const int64_t end,
+                              const bool with_statistics, RegionWriter* writer,
+                              Header::Block* block) {
+  const auto& column = static_cast<const ColumnT&>(src);
+  const auto& values = column.values();
+  BlockStatistics statistics;
+  int64_t num_missing = 0;
+  for (int64_t row = begin; row < end; row++) {
+    if (column.IsNa(row)) {
+      num_missing++;
+    } else if (with_statistics) {
+      statistics.Add(values[row]);
+    }
+  }
+  block->set_num_missing(num_missing);
+  statistics.Export(block);
+  return writer->WriteRegion(AsBytes(values.data() + begin, end - begin),
+                             block->mutable_values());
+}
+
+// Same as "WriteScalarBlock" for the columns that do not store their values
+// as an array of "T" in memory (e.g. the bit-packed boolean columns). The
+// values are converted with "value(row)".
+template <typename ColumnT, typename T>
+absl::Status WriteDecodedScalarBlock(const VerticalDataset::AbstractColumn& src,
+                                     const int64_t begin, const int64_t end,
+                                     const bool with_statistics,
+                                     RegionWriter* writer,
+                                     Header::Block* block) {
+  const auto& column = static_cast<const ColumnT&>(src);
+  std::vector<T> values(end - begin);
+  BlockStatistics statistics;
+  int64_t num_missing = 0;
+  for (int64_t row = begin; row < end; row++) {
+    values[row - begin] = column.value(row);
+    if (column.IsNa(row)) {
+      num_missing++;
+    } else if (with_statistics) {
+      statistics.Add(values[row - begin]);
+    }
+  }
+  block->set_num_missing(num_missing);
+  statistics.Export(block);
+  return writer->WriteRegion(AsBytes(values.data(), values.size()),
+                             block->mutable_values());
+}
+
+template <typename ColumnT>
+absl::Status WriteMultiValueBlock(const VerticalDataset::AbstractColumn& src,
+                                  const int64_t begin, const int64_t end,
+                                  const bool with_statistics,
+                                  RegionWriter* writer, Header::Block* block) {
+  const auto& column = static_cast<const ColumnT&>(src);
+  const auto& bank = column.bank();
+  using T = typename std::decay_t<decltype(bank)>::value_type;
+
+  // The values of the block are compacted in a new bank.
+  std::vector<Range> ranges;
+  ranges.reserve(end - begin);
+  std::vector<T> block_bank;
+  BlockStatistics statistics;
+  int64_t num_missing = 0;
+  for (int64_t row = begin; row < end; row++) {
+    if (column.IsNa(row)) {
+      num_missing++;
+      ranges.push_back({1, 0});
+      continue;
+    }
+    const auto& range = column.values()[row];
+    const uint64_t block_begin = block_bank.size();
+    block_bank.insert(block_bank.end(), bank.begin() + range.first,
+                      bank.begin() + range.second);
+    ranges.push_back({block_begin, block_bank.size()});
+    if (with_statistics) {
+      for (size_t item_idx = range.first; item_idx < range.second;
+           item_idx++) {
+        statistics.Add(bank[item_idx]);
+      }
+    }
+  }
+  block->set_num_missing(num_missing);
+  statistics.Export(block);
+  RETURN_IF_ERROR(writer->WriteRegion(AsBytes(ranges.data(), ranges.size()),
+                                      block->mutable_values()));
+  return writer->WriteRegion(AsBytes(block_bank.data(), block_bank.size()),
+                             block->mutable_bank());
+}
+
+absl::Status WriteBlock(const VerticalDataset::AbstractColumn& column,
+                        const int64_t begin, const int64_t end,
+                        RegionWriter* writer, Header::Block* block) {
+  block->set_num_rows(end - begin);
+  switch (column.type()) {
+    case ColumnType::NUMERICAL:
+      return WriteScalarBlock<VerticalDataset::NumericalColumn>(
+          column, begin, end, true, writer, block);
+    case ColumnType::CATEGORICAL:
+      return WriteDecodedScalarBlock<VerticalDataset::CategoricalColumn,
+                                     int32_t>(column, begin, end, true, writer,
+                                              block);
+    case ColumnType::BOOLEAN:
+      return WriteDecodedScalarBlock<VerticalDataset::BooleanColumn, int8_t>(
+          column, begin, end, true, writer, block);
+    case ColumnType::DISCRETIZED_NUMERICAL:
+      return WriteScalarBlock<VerticalDataset::DiscretizedNumericalColumn>(
+          column, begin, end, true, writer, block);
+    case ColumnType::HASH:
+      return WriteScalarBlock<VerticalDataset::HashColumn>(
+          column, begin, end, false, writer, block);
+    case ColumnType::NUMERICAL_SET:
+      return WriteMultiValueBlock<VerticalDataset::NumericalSetColumn>(
+          column, begin, end, true, writer, block);
+    case ColumnType::NUMERICAL_LIST:
+      return WriteMultiValueBlock<VerticalDataset::NumericalListColumn>(
+          column, begin, end, true, writer, block);
+    case ColumnType::CATEGORICAL_SET:
+      return WriteMultiValueBlock<VerticalDataset::CategoricalSetColumn>(
+          column, begin, end, true, writer, block);
+    case ColumnType::CATEGORICAL_LIST:
+      return WriteMultiValueBlock<VerticalDataset::CategoricalListColumn>(
+          column, begin, end, true, writer, block);
+    case ColumnType::STRING:
+      return WriteMultiValueBlock<VerticalDataset::StringColumn>(
+          column, begin, end, false, writer, block);
+    default:
+      return absl::UnimplementedError(
+          absl::StrCat("Column \"", column.name(), "\" of type ",
+                       ColumnType_Name(column.type()),
+                       " is not supported in ydfc files"));
+  }
+}
+
+// Categorical values of a column in a file.
+struct CategoricalValues {
+  // Number of unique values in the dictionary of the file. The values are
+  // expected in [0, number_of_unique_values), or to be missing.
+  int32_t number_of_unique_values;
+  // See "ColumnarFile::AppendRows".
+  absl::Span<const int32_t> remap;
+};
+
+// Checks that the categorical values in "values" are in [min_value,
+// number_of_unique_values), and remaps the non-missing values.
+absl::Status ConvertCategoricalValues(const CategoricalValues& categorical,
+                                      const int32_t min_value,
+                                      absl::Span<int32_t> values) {
+  for (auto& value : values) {
+    if (value < min_value || value >= categorical.number_of_unique_values) {
+      return absl::DataLossError(
+          absl::StrCat("Invalid categorical value ", value, " in ydfc file"));
+    }
+    if (value >= 0 && !categorical.remap.empty()) {
+      value = categorical.remap[value];
+    }
+  }
+  return absl::OkStatus();
+}
+
+template <typename ColumnT>
+absl::Status AppendScalarRows(absl::string_view values, const int64_t begin,
+                              const int64_t end,
+                              VerticalDataset::AbstractColumn* dst) {
+  auto& dst_values = *static_cast<ColumnT*>(dst)->mutable_values();
+  using T = typename std::decay_t<decltype(dst_values)>::value_type;
+  STATUS_CHECK_LE(end * sizeof(T), values.size());
+  const size_t offset = dst_values.size();
+  dst_values.resize(offset + end - begin);
+  std::memcpy(dst_values.data() + offset, values.data() + begin * sizeof(T),
+              (end - begin) * sizeof(T));
+  return absl::OkStatus();
+}
+
+// Same as "AppendScalarRows" for the columns that do not store their values
+// as an array of "T" in memory. The values are added with "Add(value)".
+// "categorical" is only set for the categorical columns.
+template <typename ColumnT, typename T>
+absl::Status AppendDecodedScalarRows(absl::string_view values,
+                                     const int64_t begin, const int64_t end,
+                                     const CategoricalValues* categorical,
+                                     VerticalDataset::AbstractColumn* dst) {
+  STATUS_CHECK_LE(end * sizeof(T), values.size());
+  std::vector<T> buffer(end - begin);
+  std::memcpy(buffer.data(), values.data() + begin * sizeof(T),
+              (end - begin) * sizeof(T));
+  if constexpr (std::is_same_v<T, int32_t>) {
+    if (categorical != nullptr) {
+      RETURN_IF_ERROR(ConvertCategoricalValues(
+          *categorical, VerticalDataset::CategoricalColumn::kNaValue,
+          absl::MakeSpan(buffer)));
+    }
+  }
+  auto* column = static_cast<ColumnT*>(dst);
+  column->Reserve(column->nrows() + buffer.size());
+  for (const T value : buffer) {
+    column->Add(value);
+  }
+  return absl::OkStatus();
+}
+
+// "categorical" is only set for the categorical columns.
+template <typename ColumnT>
+absl::Status AppendMultiValueRows(absl::string_view values,
+                                  absl::string_view bank, const int64_t begin,
+                                  const int64_t end,
+                                  const CategoricalValues* categorical,
+                                  VerticalDataset::AbstractColumn* dst) {
+  auto* column = static_cast<ColumnT*>(dst);
+  auto& dst_ranges = column->mutable_values();
+  auto& dst_bank = column->mutable_bank();
+  using T = typename std::decay_t<decltype(dst_bank)>::value_type;
+  STATUS_CHECK_LE(end * sizeof(Range), values.size());
+
+  // The non-missing values of the rows [begin, end) are contiguous in the
+  // block bank. They are copied at once.
+  std::optional<uint64_t> bank_begin;
+  uint64_t bank_end = 0;
+  const size_t dst_bank_offset = dst_bank.size();
+  for (int64_t row = begin; row < end; row++) {
+    Range range;
+    std::memcpy(&range, values.data() + row * sizeof(Range), sizeof(Range));
+    if (range.first > range.second) {
+      dst_ranges.emplace_back(1, 0);
+      continue;
+    }
+    if (!bank_begin.has_value()) {
+      bank_begin = range.first;
+    }
+    if (range.first < bank_end || range.first < *bank_begin) {
+      return absl::DataLossError("Invalid multi-value ranges in ydfc file");
+    }
+    bank_end = range.second;
+    dst_ranges.emplace_back(dst_bank_offset + range.first - *bank_begin,
+                            dst_bank_offset + range.second - *bank_begin);
+  }
+  if (!bank_begin.has_value()) {
+    return absl::OkStatus();
+  }
+
+  STATUS_CHECK_LE(bank_end * sizeof(T), bank.size());
+  const size_t num_items = bank_end - *bank_begin;
+  dst_bank.resize(dst_bank_offset + num_items);
+  std::memcpy(dst_bank.data() + dst_bank_offset,
+              bank.data() + *bank_begin * sizeof(T), num_items * sizeof(T));
+
+  if constexpr (std::is_same_v<T, int32_t>) {
+    if (categorical != nullptr) {
+      RETURN_IF_ERROR(ConvertCategoricalValues(
+          *categorical, /*min_value=*/0,
+          absl::MakeSpan(dst_bank).subspan(dst_bank_offset)));
+    }
+  }
+  if (categorical != nullptr && !categorical->remap.empty()) {
+    if (column->type() == ColumnType::CATEGORICAL_SET) {
+      // The items of a set are sorted.
+      for (size_t row = dst_ranges.size() - (end - begin);
+           row < dst_ranges.size(); row++) {
+        const auto& range = dst_ranges[row];
+        if (range.first < range.second) {
+          std::sort(dst_bank.begin() + range.first,
+                    dst_bank.begin() + range.second);
+        }
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Computes the conversion of the categorical values of "file_spec" into the
+// categorical values of "spec". Returns an empty vector if no conversion is
+// needed.
+absl::StatusOr<std::vector<int32_t>> ComputeCategoricalRemap(
+    const proto::Column& file_spec, const proto::Column& spec) {
+  const auto& file_categorical = file_spec.categorical();
+  const auto& categorical = spec.categorical();
+  if (file_categorical.is_already_integerized() !=
+      categorical.is_already_integerized()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The column \"", spec.name(),
+        "\" is integerized in one of the dataspec but not in the other"));
+  }
+  if (categorical.is_already_integerized()) {
+    if (file_categorical.number_of_unique_values() >
+        categorical.number_of_unique_values()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The integerized column \"", spec.name(),
+          "\" has more unique values in the file than in the dataspec"));
+    }
+    return std::vector<int32_t>{};
+  }
+
+  const CategoricalDictionary dictionary(spec);
+  std::vector<int32_t> remap(file_categorical.number_of_unique_values(),
+                             kOutOfDictionaryItemIndex);
+  for (const auto& item : file_categorical.items()) {
+    const int32_t index = item.second.index();
+    if (index < 0 || index >= remap.size()) {
+      return absl::DataLossError(absl::StrCat(
+          "Invalid dictionary for column \"", file_spec.name(), "\""));
+    }
+    remap[index] = dictionary.NonintegerizedLookup(item.first);
+  }
+  for (int32_t index = 0; index < remap.size(); index++) {
+    if (remap[index] != index) {
+      return remap;
+    }
+  }
+  // Both dictionaries are the same.
+  return std::vector<int32_t>{};
+}
+
+}  // namespace
+
+absl::Status SaveColumnarFile(const VerticalDataset& dataset,
+                              const absl::string_view path,
+                              const ColumnarFileOptions& options) {
+  STATUS_CHECK_GT(options.block_num_rows, 0);
+  Header header;
+  *header.mutable_data_spec() = dataset.data_spec();
+  header.set_num_rows(dataset.nrow());
+  header.set_block_num_rows(options.block_num_rows);
+  header.set_compression(options.compress ? Header::GZIP : Header::NONE);
+  header.set_byte_order(kHostByteOrder);
+
+  ASSIGN_OR_RETURN(auto file_handle, file::OpenOutputFile(path));
+  file::OutputFileCloser closer(std::move(file_handle));
+  RegionWriter writer(closer.stream(), options.compress);
+  RETURN_IF_ERROR(writer.Write(kMagic));
+  RETURN_IF_ERROR(writer.Pad());
+
+  for (int col_idx = 0; col_idx < dataset.ncol(); col_idx++) {
+    const auto& column = *dataset.column(col_idx);
+    auto* column_header = header.add_columns();
+    for (int64_t begin = 0; begin < dataset.nrow();
+         begin += options.block_num_rows) {
+      const int64_t end =
+          std::min<int64_t>(begin + options.block_num_rows, dataset.nrow());
+      RETURN_IF_ERROR(
+          WriteBlock(column, begin, end, &writer, column_header->add_blocks()));
+    }
+  }
+
+  const std::string serialized_header = header.SerializeAsString();
+  const uint64_t header_size =
+      absl::little_endian::FromHost64(serialized_header.size());
+  RETURN_IF_ERROR(writer.Write(serialized_header));
+  RETURN_IF_ERROR(writer.Write(AsBytes(&header_size, 1)));
+  RETURN_IF_ERROR(writer.Write(kMagic));
+  return closer.Close();
+}
+
+absl::StatusOr<std::unique_ptr<ColumnarFile>> ColumnarFile::Open(
+    const absl::string_view path) {
+  auto columnar_file = std::unique_ptr<ColumnarFile>(new ColumnarFile());
+  ASSIGN_OR_RETURN(columnar_file->file_, utils::MemoryMappedFile::Open(path));
+  const absl::string_view content = columnar_file->file_->data();
+
+  const size_t footer_size = sizeof(uint64_t) + kMagic.size();
+  if (content.size() < kAlignment + footer_size ||
+      content.substr(0, kMagic.size()) != kMagic ||
+      content.substr(content.size() - kMagic.size()) != kMagic) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("\"", path, "\" is not a ydfc file"));
+  }
+  uint64_t header_size;
+  std::memcpy(&header_size, content.data() + content.size() - footer_size,
+              sizeof(uint64_t));
+  header_size = absl::little_endian::ToHost64(header_size);
+  if (header_size > content.size() - kAlignment - footer_size ||
+      !columnar_file->header_.ParseFromArray(
+          content.data() + content.size() - footer_size - header_size,
+          header_size)) {
+    return absl::DataLossError(
+        absl::StrCat("Cannot parse the header of \"", path, "\""));
+  }
+
+  const auto& header = columnar_file->header_;
+  if (header.byte_order() != kHostByteOrder) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "\"", path,
+        "\" was created on a platform with a different endianness. Re-create "
+        "the ydfc file on this platform."));
+  }
+  if (header.columns_size() != header.data_spec().columns_size()) {
+    return absl::DataLossError(
+        absl::StrCat("Inconsistent header in \"", path, "\""));
+  }
+  columnar_file->cache_.resize(header.columns_size());
+  if (header.compression() != Header::NONE) {
+    columnar_file->working_buffer_.resize(64 * 1024);
+  }
+  return columnar_file;
+}
+
+absl::StatusOr<absl::string_view> ColumnarFile::GetRegion(
+    const Header::Region& region, std::string* buffer) {
+  const absl::string_view content = file_->data();
+  const int64_t file_size = content.size();
+  if (region.offset() < 0 || region.size() < 0 || region.offset() > file_size ||
+      region.size() > file_size - region.offset()) {
+    return absl::DataLossError("Region out of the ydfc file");
+  }
+  const absl::string_view data = content.substr(region.offset(), region.size());
+  if (header_.compression() == Header::NONE) {
+    return data;
+  }
+  buffer->clear();
+  buffer->reserve(region.uncompressed_size());
+  RETURN_IF_ERROR(utils::Inflate(data, buffer, &working_buffer_));
+  return *buffer;
+}
+
+absl::StatusOr<ColumnarFile::Block> ColumnarFile::GetBlock(
+    const int col_idx, const int block_idx) {
+  const auto& block = header_.columns(col_idx).blocks(block_idx);
+  auto& cache = cache_[col_idx];
+  if (header_.compression() != Header::NONE && cache.block_idx == block_idx) {
+    return Block{cache.values, cache.bank};
+  }
+  cache.block_idx = -1;
+  Block result;
+  ASSIGN_OR_RETURN(result.values, GetRegion(block.values(), &cache.values));
+  if (block.has_bank()) {
+    ASSIGN_OR_RETURN(result.bank, GetRegion(block.bank(), &cache.bank));
+  }
+  cache.block_idx = block_idx;
+  return result;
+}
+
+absl::Status ColumnarFile::AppendRows(
+    const int col_idx, int64_t begin, const int64_t end,
+    absl::Span<const int32_t> categorical_remap,
+    VerticalDataset::AbstractColumn* dst) {
+  STATUS_CHECK_GE(col_idx, 0);
+  STATUS_CHECK_LT(col_idx, header_.columns_size());
+  STATUS_CHECK_LE(end, num_rows());
+  const auto type = header_.data_spec().columns(col_idx).type();
+  if (dst->type() != type) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The column \"", dst->name(), "\" has type ",
+        ColumnType_Name(dst->type()), " while the ydfc file contains ",
+        ColumnType_Name(type), " values"));
+  }
+
+  const int64_t number_of_unique_values = header_.data_spec()
+                                              .columns(col_idx)
+                                              .categorical()
+                                              .number_of_unique_values();
+  STATUS_CHECK_GE(number_of_unique_values, 0);
+  STATUS_CHECK_LE(number_of_unique_values,
+                  std::numeric_limits<int32_t>::max());
+  const CategoricalValues categorical{
+      /*.number_of_unique_values =*/static_cast<int32_t>(
+          number_of_unique_values),
+      /*.remap =*/categorical_remap};
+  if (!categorical.remap.empty()) {
+    STATUS_CHECK_EQ(categorical.remap.size(),
+                    categorical.number_of_unique_values);
+  }
+
+  const int64_t block_num_rows = header_.block_num_rows();
+  while (begin < end) {
+    const int block_idx = begin / block_num_rows;
+    const int64_t block_begin =
+        static_cast<int64_t>(block_idx) * block_num_rows;
+    const int64_t block_end = std::min(end, block_begin + block_num_rows);
+    STATUS_CHECK_LT(block_idx, header_.columns(col_idx).blocks_size());
+    ASSIGN_OR_RETURN(const Block block, GetBlock(col_idx, block_idx));
+    const int64_t local_begin = begin - block_begin;
+    const int64_t local_end = block_end - block_begin;
+    switch (type) {
+      case ColumnType::NUMERICAL:
+        RETURN_IF_ERROR(AppendScalarRows<VerticalDataset::NumericalColumn>(
+            block.values, local_begin, local_end, dst));
+        break;
+      case ColumnType::CATEGORICAL:
+        RETURN_IF_ERROR(
+            (AppendDecodedScalarRows<VerticalDataset::CategoricalColumn,
+                                     int32_t>(block.values, local_begin,
+                                              local_end, &categorical, dst)));
+        break;
+      case ColumnType::BOOLEAN:
+        RETURN_IF_ERROR(
+            (AppendDecodedScalarRows<VerticalDataset::BooleanColumn, int8_t>(
+                block.values, local_begin, local_end, nullptr, dst)));
+        break;
+      case ColumnType::DISCRETIZED_NUMERICAL:
+        RETURN_IF_ERROR(
+            AppendScalarRows<VerticalDataset::DiscretizedNumericalColumn>(
+                block.values, local_begin, local_end, dst));
+        break;
+      case ColumnType::HASH:
+        RETURN_IF_ERROR(AppendScalarRows<VerticalDataset::HashColumn>(
+            block.values, local_begin, local_end, dst));
+        break;
+      case ColumnType::NUMERICAL_SET:
+        RETURN_IF_ERROR(
+            AppendMultiValueRows<VerticalDataset::NumericalSetColumn>(
+                block.values, block.bank, local_begin, local_end, nullptr,
+                dst));
+        break;
+      case ColumnType::NUMERICAL_LIST:
+        RETURN_IF_ERROR(
+            AppendMultiValueRows<VerticalDataset::NumericalListColumn>(
+                block.values, block.bank, local_begin, local_end, nullptr,
+                dst));
+        break;
+      case ColumnType::CATEGORICAL_SET:
+        RETURN_IF_ERROR(
+            AppendMultiValueRows<VerticalDataset::CategoricalSetColumn>(
+                block.values, block.bank, local_begin, local_end,
+                &categorical, dst));
+        break;
+      case ColumnType::CATEGORICAL_LIST:
+        RETURN_IF_ERROR(
+            AppendMultiValueRows<VerticalDataset::CategoricalListColumn>(
+                block.values, block.bank, local_begin, local_end,
+                &categorical, dst));
+        break;
+      case ColumnType::STRING:
+        RETURN_IF_ERROR(AppendMultiValueRows<VerticalDataset::StringColumn>(
+            block.values, block.bank, local_begin, local_end, nullptr, dst));
+        break;
+      default:
+        return absl::UnimplementedError(
+            absl::StrCat("Column type ", ColumnType_Name(type),
+                         " is not supported in ydfc files"));
+    }
+    begin = block_end;
+  }
+  return absl::OkStatus();
+}
+
+YdfColumnarReader::YdfColumnarReader(
+    const proto::DataSpecification& data_spec,
+    std::optional<std::vector<int>> required_columns)
+    : data_spec_(data_spec), required_columns_(std::move(required_columns)) {}
+
+absl::Status YdfColumnarReader::Open(
+    const absl::string_view sharded_path,
+    const std::optional<std::vector<int>>& load_columns) {
+  load_columns_ = load_columns;
+  RETURN_IF_ERROR(utils::ExpandInputShards(sharded_path, &shards_));
+  if (shards_.empty()) {
+    return absl::NotFoundError(
+        absl::StrCat("No files matching: ", sharded_path));
+  }
+  next_shard_idx_ = 0;
+  return OpenNextShard().status();
+}
+
+absl::StatusOr<bool> YdfColumnarReader::OpenNextShard() {
+  file_.reset();
+  columns_.clear();
+  if (next_shard_idx_ >= shards_.size()) {
+    return false;
+  }
+  const auto& path = shards_[next_shard_idx_++];
+  ASSIGN_OR_RETURN(file_, ColumnarFile::Open(path));
+  next_row_ = 0;
+
+  const auto& file_spec = file_->data_spec();
+  const auto add_column = [&](const int col_idx) -> absl::Status {
+    STATUS_CHECK_GE(col_idx, 0);
+    STATUS_CHECK_LT(col_idx, data_spec_.columns_size());
+    const auto& col_spec = data_spec_.columns(col_idx);
+    Column column{
+        /*.col_idx =*/col_idx,
+        /*.file_col_idx =*/GetOptionalColumnIdxFromName(col_spec.name(),
+                                                        file_spec)
+            .value_or(-1),
+        /*.categorical_remap =*/{}};
+    if (column.file_col_idx == -1) {
+      const bool is_required =
+          !required_columns_.has_value() ||
+          std::find(required_columns_->begin(), required_columns_->end(),
+                    col_idx) != required_columns_->end();
+      if (is_required) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("The required column \"", col_spec.name(),
+                         "\" is not present in \"", path, "\""));
+      }
+    } else {
+      const auto& file_col_spec = file_spec.columns(column.file_col_idx);
+      if (file_col_spec.type() != col_spec.type()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "The column \"", col_spec.name(), "\" has type ",
+            ColumnType_Name(file_col_spec.type()), " in \"", path,
+            "\" while the dataspec expects ",
+            ColumnType_Name(col_spec.type())));
+      }
+      const auto& file_boundaries =
+          file_col_spec.discretized_numerical().boundaries();
+      const auto& boundaries = col_spec.discretized_numerical().boundaries();
+      if (col_spec.type() == ColumnType::DISCRETIZED_NUMERICAL &&
+          !std::equal(file_boundaries.begin(), file_boundaries.end(),
+                      boundaries.begin(), boundaries.end())) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "The column \"", col_spec.name(),
+            "\" has different discretization boundaries in \"", path,
+            "\" and in the dataspec"));
+      }
+      if (IsCategorical(col_spec.type())) {
+        ASSIGN_OR_RETURN(column.categorical_remap,
+                         ComputeCategoricalRemap(file_col_spec, col_spec));
+      }
+    }
+    columns_.push_back(std::move(column));
+    return absl::OkStatus();
+  };
+
+  if (load_columns_.has_value()) {
+    for (const int col_idx : load_columns_.value()) {
+      RETURN_IF_ERROR(add_column(col_idx));
+    }
+  } else {
+    for (int col_idx = 0; col_idx < data_spec_.columns_size(); col_idx++) {
+      RETURN_IF_ERROR(add_column(col_idx));
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<VerticalDataset::row_t> YdfColumnarReader::NextBatch(
+    const VerticalDataset::row_t max_num_examples, VerticalDataset* dataset) {
+  while (file_ && next_row_ >= file_->num_rows()) {
+    RETURN_IF_ERROR(OpenNextShard().status());
+  }
+  if (!file_) {
+    return 0;
+  }
+  const int64_t end =
+      std::min<int64_t>(file_->num_rows(), next_row_ + max_num_examples);
+  for (const auto& column : columns_) {
+    STATUS_CHECK_LT(column.col_idx, dataset->ncol());
+    auto* dst = dataset->mutable_column(column.col_idx);
+    if (column.file_col_idx == -1) {
+      dst->Resize(dst->nrows() + end - next_row_);
+      continue;
+    }
+    RETURN_IF_ERROR(file_->AppendRows(column.file_col_idx, next_row_, end,
+                                      column.categorical_remap, dst));
+  }
+  const VerticalDataset::row_t num_examples = end - next_row_;
+  dataset->set_nrow(dataset->nrow() + num_examples);
+  next_row_ = end;
+  return num_examples;
+}
+
+YdfColumnarExampleReader::YdfColumnarExampleReader(
+    const proto::DataSpecification& data_spec,
+    std::optional<std::vector<int>> required_columns)
+    : data_spec_(data_spec), reader_(data_spec, std::move(required_columns)) {}
+
+absl::Status YdfColumnarExampleReader::Open(
+    const absl::string_view sharded_path) {
+  return reader_.Open(sharded_path, {});
+}
+
+absl::StatusOr<bool> YdfColumnarExampleReader::Next(proto::Example* example) {
+  if (next_row_in_batch_ >= batch_.nrow()) {
+    constexpr VerticalDataset::row_t kBatchSize = 4096;
+    // Note: "Resize" does not release the banks of the multi-value columns.
+    batch_ = VerticalDataset();
+    batch_.set_data_spec(data_spec_);
+    RETURN_IF_ERROR(batch_.CreateColumnsFromDataspec());
+    next_row_in_batch_ = 0;
+    ASSIGN_OR_RETURN(const auto num_examples,
+                     reader_.NextBatch(kBatchSize, &batch_));
+    if (num_examples == 0) {
+      return false;
+    }
+  }
+  batch_.ExtractExample(next_row_in_batch_++, example);
+  return true;
+}
+
+YdfColumnarExampleWriter::YdfColumnarExampleWriter(
+    const proto::DataSpecification& data_spec)
+    : sharded_writer_(data_spec) {}
+
+YdfColumnarExampleWriter::Implementation::Implementation(
+    const proto::DataSpecification& data_spec)
+    : data_spec_(data_spec) {}
+
+YdfColumnarExampleWriter::Implementation::~Implementation() {
+  CHECK_OK(CloseWithStatus());
+}
+
+absl::Status YdfColumnarExampleWriter::Implementation::CloseWithStatus() {
+  if (!path_.has_value()) {
+    return absl::OkStatus();
+  }
+  // The path is reset first so the shard is only written once.
+  const std::string path = std::move(path_).value();
+  path_.reset();
+  const auto status = SaveColumnarFile(buffer_, path);
+  buffer_ = VerticalDataset();
+  return status;
+}
+
+absl::Status YdfColumnarExampleWriter::Implementation::OpenShard(
+    const absl::string_view path) {
+  RETURN_IF_ERROR(CloseWithStatus());
+  buffer_.set_data_spec(data_spec_);
+  RETURN_IF_ERROR(buffer_.CreateColumnsFromDataspec());
+  path_ = std::string(path);
+  return absl::OkStatus();
+}
+
+absl::Status YdfColumnarExampleWriter::Implementation::WriteInShard(
+    const proto::Example& example) {
+  return buffer_.AppendExampleWithStatus(example);
+}
+
+absl::Status YdfColumnarDataSpecCreator::CreateDataspec(
+    const std::vector<std::string>& paths,
+    const proto::DataSpecificationGuide& guide,
+    proto::DataSpecification* data_spec) {
+  if (paths.empty()) {
+    return absl::InvalidArgumentError("No dataset file");
+  }
+  int64_t num_rows = 0;
+  for (int path_idx = 0; path_idx < paths.size(); path_idx++) {
+    ASSIGN_OR_RETURN(const auto file, ColumnarFile::Open(paths[path_idx]));
+    if (path_idx == 0) {
+      *data_spec = file->data_spec();
+    }
+    num_rows += file->num_rows();
+  }
+  data_spec->set_created_num_rows(num_rows);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int64_t> YdfColumnarDataSpecCreator::CountExamples(
+    const absl::string_view path) {
+  ASSIGN_OR_RETURN(const auto file, ColumnarFile::Open(path));
+  return file->num_rows();
+}
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Native columnar binary dataset format (typed path prefix "ydfc:").
+//
+// A ".ydfc" file contains the columns of a "VerticalDataset" in the same
+// in-memory representation as the "VerticalDataset" columns, as well as the
+// dataspec of the dataset. Reading a ".ydfc" file does not parse any value:
+// The file is memory-mapped, and the values are bulk copied into the columns.
+//
+// Each column is split into blocks of "block_num_rows" rows. Each block is
+// stored as one (scalar columns) or two (multi-value columns) regions aligned
+// on 64 bytes. The blocks also contain the number of missing values and the
+// min/max of the values. The regions are optionally gzip compressed.
+//
+// Layout of the file:
+//   "YDFC" magic number, padded to 64 bytes.
+//   Regions of the blocks, each padded to 64 bytes.
+//   Serialized "proto::ColumnarFileHeader".
+//   Size of the serialized header (little-endian uint64).
+//   "YDFC" magic number.
+//
+// The values are stored in the byte order of the host (little-endian on all
+// the supported platforms), recorded in the header. A file created on a
+// platform with a different byte order is rejected.
+//
+// Usage example:
+//   RETURN_IF_ERROR(SaveVerticalDataset(dataset, "ydfc:/tmp/dataset.ydfc"));
+//
+//   proto::DataSpecification data_spec;
+//   RETURN_IF_ERROR(CreateDataSpecWithStatus("ydfc:/tmp/dataset.ydfc", false,
+//                                            {}, &data_spec));
+//   VerticalDataset reloaded;
+//   RETURN_IF_ERROR(LoadVerticalDataset("ydfc:/tmp/dataset.ydfc", data_spec,
+//                                       &reloaded));
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_DATASET_COLUMNAR_FILE_H_
+#define YGGDRASIL_DECISION_FORESTS_DATASET_COLUMNAR_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/columnar_file.pb.h"
+#include "yggdrasil_decision_forests/dataset/columnar_reader_interface.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
+#include "yggdrasil_decision_forests/dataset/example_writer_interface.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+
+struct ColumnarFileOptions {
+  // Maximum number of rows in a block.
+  int64_t block_num_rows = 64 * 1024;
+  // If true, the regions are gzip compressed. Compressed files are smaller,
+  // but the blocks have to be decompressed when read.
+  bool compress = false;
+};
+
+// Saves a dataset in a single ".ydfc" file. "path" is not a typed path.
+absl::Status SaveColumnarFile(const VerticalDataset& dataset,
+                              absl::string_view path,
+                              const ColumnarFileOptions& options = {});
+
+// An open ".ydfc" file.
+//
+// This class is thread-compatible.
+class ColumnarFile {
+ public:
+  // Opens and memory-maps a file. "path" is not a typed path.
+  static absl::StatusOr<std::unique_ptr<ColumnarFile>> Open(
+      absl::string_view path);
+
+  const proto::ColumnarFileHeader& header() const { return header_; }
+  const proto::DataSpecification& data_spec() const {
+    return header_.data_spec();
+  }
+  int64_t num_rows() const { return header_.num_rows(); }
+
+  // Appends the rows [begin, end) of the "col_idx"-th column of the file to
+  // "dst". "dst" should have the same type as the column.
+  //
+  // The categorical values are checked against the dictionary of the file. If
+  // "categorical_remap" is not empty, it contains one entry per value of this
+  // dictionary, and the categorical values are converted with
+  // "categorical_remap[value]" (e.g. to use the dictionary of another
+  // dataspec).
+  absl::Status AppendRows(int col_idx, int64_t begin, int64_t end,
+                          absl::Span<const int32_t> categorical_remap,
+                          VerticalDataset::AbstractColumn* dst);
+
+ private:
+  // Content of a block. The views are valid until the next call to
+  // "GetBlock".
+  struct Block {
+    absl::string_view values;
+    absl::string_view bank;
+  };
+
+  // Decompressed regions of the last block read in a column.
+  struct BlockCache {
+    int block_idx = -1;
+    std::string values;
+    std::string bank;
+  };
+
+  ColumnarFile() = default;
+
+  absl::StatusOr<Block> GetBlock(int col_idx, int block_idx);
+
+  absl::StatusOr<absl::string_view> GetRegion(
+      const proto::ColumnarFileHeader::Region& region, std::string* buffer);
+
+  std::unique_ptr<utils::MemoryMappedFile> file_;
+  proto::ColumnarFileHeader header_;
+  std::vector<BlockCache> cache_;
+  std::string working_buffer_;
+};
+
+// Columnar reader of ".ydfc" files. The columns are matched by name. The
+// categorical dictionaries of the files are converted to the dictionaries of
+// the dataspec of the reader.
+class YdfColumnarReader final : public ColumnarReaderInterface {
+ public:
+  YdfColumnarReader(const proto::DataSpecification& data_spec,
+                    std::optional<std::vector<int>> required_columns);
+
+  absl::Status Open(
+      absl::string_view sharded_path,
+      const std::optional<std::vector<int>>& load_columns) override;
+
+  absl::StatusOr<VerticalDataset::row_t> NextBatch(
+      VerticalDataset::row_t max_num_examples,
+      VerticalDataset* dataset) override;
+
+ private:
+  // A column of the reader's dataspec populated by "NextBatch".
+  struct Column {
+    // Index of the column in the reader's dataspec.
+    int col_idx;
+    // Index of the column in the file's dataspec. -1 if the column is not
+    // in the file, in which case it is filled with missing values.
+    int file_col_idx;
+    // See "ColumnarFile::AppendRows".
+    std::vector<int32_t> categorical_remap;
+  };
+
+  // Opens the next shard. Returns false if all the shards have been read.
+  absl::StatusOr<bool> OpenNextShard();
+
+  const proto::DataSpecification data_spec_;
+  const std::optional<std::vector<int>> required_columns_;
+  std::optional<std::vector<int>> load_columns_;
+
+  std::vector<std::string> shards_;
+  int next_shard_idx_ = 0;
+
+  // Currently open file, and next row to read in it.
+  std::unique_ptr<ColumnarFile> file_;
+  int64_t next_row_ = 0;
+  std::vector<Column> columns_;
+};
+
+REGISTER_ColumnarReaderInterface(YdfColumnarReader, "FORMAT_YDF_COLUMNAR");
+
+// Example reader of ".ydfc" files. The examples are read by batch with
+// "YdfColumnarReader".
+class YdfColumnarExampleReader final : public ExampleReaderInterface {
+ public:
+  YdfColumnarExampleReader(const proto::DataSpecification& data_spec,
+                           std::optional<std::vector<int>> required_columns);
+
+  absl::Status Open(absl::string_view sharded_path) override;
+
+  absl::StatusOr<bool> Next(proto::Example* example) override;
+
+ private:
+  const proto::DataSpecification data_spec_;
+  YdfColumnarReader reader_;
+  VerticalDataset batch_;
+  VerticalDataset::row_t next_row_in_batch_ = 0;
+};
+
+REGISTER_ExampleReaderInterface(YdfColumnarExampleReader,
+                                "FORMAT_YDF_COLUMNAR");
+
+// Example writer of ".ydfc" files. The examples of a shard are accumulated in
+// memory, and the shard is written when the next shard is open or when the
+// writer is destroyed. Prefer "SaveColumnarFile" to save a "VerticalDataset".
+class YdfColumnarExampleWriter final : public ExampleWriterInterface {
+ public:
+  explicit YdfColumnarExampleWriter(const proto::DataSpecification& data_spec);
+
+  absl::Status Write(const proto::Example& example) override {
+    return sharded_writer_.Write(example);
+  }
+
+  absl::Status Open(absl::string_view sharded_path,
+                    const int64_t num_records_by_shard) override {
+    return sharded_writer_.Open(sharded_path, num_records_by_shard);
+  }
+
+ private:
+  class Implementation final : public utils::ShardedWriter<proto::Example> {
+   public:
+    explicit Implementation(const proto::DataSpecification& data_spec);
+    ~Implementation() override;
+
+    absl::Status CloseWithStatus() final;
+
+   protected:
+    absl::Status OpenShard(absl::string_view path) final;
+    absl::Status WriteInShard(const proto::Example& example) final;
+
+   private:
+    const proto::DataSpecification data_spec_;
+
+    // Path and examples of the currently open shard.
+    std::optional<std::string> path_;
+    VerticalDataset buffer_;
+  };
+
+  Implementation sharded_writer_;
+};
+
+REGISTER_ExampleWriterInterface(YdfColumnarExampleWriter,
+                                "FORMAT_YDF_COLUMNAR");
+
+// Dataspec "creator" of ".ydfc" files. The dataspec embedded in the files is
+// returned as is i.e. the guide is ignored.
+class YdfColumnarDataSpecCreator : public AbstractDataSpecCreator {
+ public:
+  absl::Status CreateDataspec(const std::vector<std::string>& paths,
+                              const proto::DataSpecificationGuide& guide,
+                              proto::DataSpecification* data_spec) override;
+
+  absl::StatusOr<int64_t> CountExamples(absl::string_view path) override;
+};
+
+REGISTER_AbstractDataSpecCreator(YdfColumnarDataSpecCreator,
+                                 "FORMAT_YDF_COLUMNAR");
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_DATASET_COLUMNAR_FILE_H_
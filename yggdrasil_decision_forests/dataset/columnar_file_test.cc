@@ -0,0 +1,269 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/dataset/columnar_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/base/internal/endian.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/columnar_file.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+namespace {
+
+using test::EqualsProto;
+using test::StatusIs;
+
+std::string DatasetDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data/dataset");
+}
+
+// Loads a csv dataset from the test data directory.
+VerticalDataset LoadCsvDataset(const absl::string_view filename,
+                               const proto::DataSpecificationGuide& guide) {
+  const std::string path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), filename));
+  proto::DataSpecification data_spec;
+  CHECK_OK(CreateDataSpecWithStatus(path, false, guide, &data_spec));
+  VerticalDataset dataset;
+  CHECK_OK(LoadVerticalDataset(path, data_spec, &dataset));
+  return dataset;
+}
+
+void ExpectSameExamples(const VerticalDataset& a, const VerticalDataset& b) {
+  ASSERT_EQ(a.nrow(), b.nrow());
+  for (VerticalDataset::row_t row = 0; row < a.nrow(); row++) {
+    proto::Example example_a, example_b;
+    a.ExtractExample(row, &example_a);
+    b.ExtractExample(row, &example_b);
+    EXPECT_THAT(example_b, EqualsProto(example_a));
+  }
+}
+
+// Replaces the header of the ydfc file "path" with its modification by "edit".
+void EditHeader(const absl::string_view path,
+                const std::function<void(proto::ColumnarFileHeader*)>& edit) {
+  std::string content = file::GetContent(path).value();
+  constexpr size_t kFooterSize = sizeof(uint64_t) + 4;
+  uint64_t header_size;
+  std::memcpy(&header_size, content.data() + content.size() - kFooterSize,
+              sizeof(uint64_t));
+  header_size = absl::little_endian::ToHost64(header_size);
+  const size_t header_begin = content.size() - kFooterSize - header_size;
+
+  proto::ColumnarFileHeader header;
+  CHECK(header.ParseFromArray(content.data() + header_begin, header_size));
+  edit(&header);
+  const std::string new_header = header.SerializeAsString();
+  const uint64_t new_header_size =
+      absl::little_endian::FromHost64(new_header.size());
+  const std::string magic = content.substr(content.size() - 4);
+  content.resize(header_begin);
+  absl::StrAppend(&content, new_header,
+                  absl::string_view(reinterpret_cast<const char*>(
+                                        &new_header_size),
+                                    sizeof(uint64_t)),
+                  magic);
+  CHECK_OK(file::SetContent(path, content));
+}
+
+class ColumnarFileTest : public testing::TestWithParam<bool> {};
+
+TEST_P(ColumnarFileTest, SaveAndLoad) {
+  const VerticalDataset dataset = LoadCsvDataset("adult.csv", {});
+  const std::string path = file::JoinPath(
+      test::TmpDirectory(), absl::StrCat("adult_", GetParam(), ".ydfc"));
+  ASSERT_OK(SaveColumnarFile(
+      dataset, path, {.block_num_rows = 1000, .compress = GetParam()}));
+
+  // The dataspec is embedded in the file.
+  const std::string typed_path = absl::StrCat("ydfc:", path);
+  proto::DataSpecification data_spec;
+  ASSERT_OK(CreateDataSpecWithStatus(typed_path, false, {}, &data_spec));
+  EXPECT_THAT(data_spec, EqualsProto(dataset.data_spec()));
+
+  VerticalDataset reloaded;
+  ASSERT_OK(LoadVerticalDataset(typed_path, data_spec, &reloaded));
+  ExpectSameExamples(dataset, reloaded);
+}
+
+INSTANTIATE_TEST_SUITE_P(Compression, ColumnarFileTest, testing::Bool());
+
+TEST(ColumnarFile, BlockStatistics) {
+  const VerticalDataset dataset = LoadCsvDataset("adult.csv", {});
+  const std::string path = file::JoinPath(test::TmpDirectory(), "stats.ydfc");
+  ASSERT_OK(SaveColumnarFile(dataset, path, {.block_num_rows = 1000}));
+
+  ASSERT_OK_AND_ASSIGN(const auto file, ColumnarFile::Open(path));
+  EXPECT_EQ(file->num_rows(), dataset.nrow());
+  const int age_idx = GetColumnIdxFromName("age", dataset.data_spec());
+  const auto& blocks = file->header().columns(age_idx).blocks();
+  ASSERT_EQ(blocks.size(), (dataset.nrow() + 999) / 1000);
+
+  const auto& ages =
+      dataset.ColumnWithCast<VerticalDataset::NumericalColumn>(age_idx)
+          ->values();
+  float min_age = std::numeric_limits<float>::infinity();
+  float max_age = -std::numeric_limits<float>::infinity();
+  for (int row = 0; row < 1000; row++) {
+    min_age = std::min(min_age, ages[row]);
+    max_age = std::max(max_age, ages[row]);
+  }
+  EXPECT_EQ(blocks[0].num_rows(), 1000);
+  EXPECT_EQ(blocks[0].num_missing(), 0);
+  EXPECT_EQ(blocks[0].min_value(), min_age);
+  EXPECT_EQ(blocks[0].max_value(), max_age);
+  EXPECT_EQ(blocks[0].values().offset() % 64, 0);
+}
+
+TEST(ColumnarFile, LoadWithOtherDataspec) {
+  proto::DataSpecificationGuide guide;
+  auto* set_guide = guide.add_column_guides();
+  set_guide->set_column_name_pattern("^Cat_set_");
+  set_guide->set_type(proto::CATEGORICAL_SET);
+  guide.mutable_default_column_guide()
+      ->mutable_categorial()
+      ->set_min_vocab_frequency(1);
+  const VerticalDataset dataset = LoadCsvDataset("toy.csv", guide);
+  const std::string path = file::JoinPath(test::TmpDirectory(), "toy.ydfc");
+  ASSERT_OK(SaveColumnarFile(dataset, path));
+
+  // A dataspec with different dictionaries and an extra column.
+  proto::DataSpecification other_data_spec = dataset.data_spec();
+  for (auto& column : *other_data_spec.mutable_columns()) {
+    if (IsCategorical(column.type())) {
+      auto& items = *column.mutable_categorical()->mutable_items();
+      const int num_items = column.categorical().number_of_unique_values();
+      for (auto& item : items) {
+        if (item.second.index() != kOutOfDictionaryItemIndex) {
+          item.second.set_index(num_items - item.second.index());
+        }
+      }
+    }
+  }
+  AddColumn("extra", proto::NUMERICAL, &other_data_spec);
+
+  const std::vector<int> required_columns = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  VerticalDataset expected;
+  ASSERT_OK(LoadVerticalDataset(
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "toy.csv")),
+      other_data_spec, &expected, required_columns));
+  VerticalDataset reloaded;
+  ASSERT_OK(LoadVerticalDataset(absl::StrCat("ydfc:", path), other_data_spec,
+                                &reloaded, required_columns));
+  ExpectSameExamples(expected, reloaded);
+}
+
+TEST(ColumnarFile, OtherEndianness) {
+  const VerticalDataset dataset = LoadCsvDataset("toy.csv", {});
+  const std::string path =
+      file::JoinPath(test::TmpDirectory(), "other_endianness.ydfc");
+  ASSERT_OK(SaveColumnarFile(dataset, path));
+  EditHeader(path, [](proto::ColumnarFileHeader* header) {
+    header->set_byte_order(header->byte_order() ==
+                                   proto::ColumnarFileHeader::BIG_ENDIAN_ORDER
+                               ? proto::ColumnarFileHeader::LITTLE_ENDIAN_ORDER
+                               : proto::ColumnarFileHeader::BIG_ENDIAN_ORDER);
+  });
+  EXPECT_THAT(ColumnarFile::Open(path).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument, "endianness"));
+}
+
+TEST(ColumnarFile, RegionOutOfFile) {
+  const VerticalDataset dataset = LoadCsvDataset("toy.csv", {});
+  const std::string path =
+      file::JoinPath(test::TmpDirectory(), "region_out_of_file.ydfc");
+  ASSERT_OK(SaveColumnarFile(dataset, path));
+  EditHeader(path, [](proto::ColumnarFileHeader* header) {
+    // "offset + size" overflows.
+    auto* region =
+        header->mutable_columns(0)->mutable_blocks(0)->mutable_values();
+    region->set_offset(std::numeric_limits<int64_t>::max() - 10);
+    region->set_size(100);
+  });
+  ASSERT_OK_AND_ASSIGN(const auto file, ColumnarFile::Open(path));
+  VerticalDataset::NumericalColumn column;
+  EXPECT_THAT(file->AppendRows(0, 0, file->num_rows(), {}, &column),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(ColumnarFile, InvalidCategoricalValue) {
+  proto::DataSpecificationGuide guide;
+  guide.mutable_default_column_guide()
+      ->mutable_categorial()
+      ->set_min_vocab_frequency(1);
+  const VerticalDataset dataset = LoadCsvDataset("toy.csv", guide);
+  const std::string path =
+      file::JoinPath(test::TmpDirectory(), "invalid_categorical.ydfc");
+  ASSERT_OK(SaveColumnarFile(dataset, path));
+  const int col_idx = GetColumnIdxFromName("Cat_1", dataset.data_spec());
+  // The values in the file are out of the dictionary of the header.
+  EditHeader(path, [col_idx](proto::ColumnarFileHeader* header) {
+    auto* categorical = header->mutable_data_spec()
+                            ->mutable_columns(col_idx)
+                            ->mutable_categorical();
+    categorical->set_number_of_unique_values(1);
+    categorical->mutable_items()->clear();
+  });
+  ASSERT_OK_AND_ASSIGN(const auto file, ColumnarFile::Open(path));
+  VerticalDataset::CategoricalColumn column;
+  EXPECT_THAT(file->AppendRows(col_idx, 0, file->num_rows(), {}, &column),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(ColumnarFile, ExampleReaderAndWriter) {
+  const VerticalDataset dataset = LoadCsvDataset("adult.csv", {});
+  const std::string typed_path = absl::StrCat(
+      "ydfc:", file::JoinPath(test::TmpDirectory(), "adult_sharded.ydfc@3"));
+  ASSERT_OK(SaveVerticalDataset(dataset, typed_path,
+                                /*num_records_by_shard=*/dataset.nrow() / 3 +
+                                    1));
+
+  LoadConfig config;
+  config.num_threads = 1;
+  // Reads the examples one by one.
+  config.load_example = [](const proto::Example&) { return true; };
+  VerticalDataset reloaded;
+  ASSERT_OK(LoadVerticalDataset(typed_path, dataset.data_spec(), &reloaded,
+                                {}, config));
+  ExpectSameExamples(dataset, reloaded);
+}
+
+}  // namespace
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
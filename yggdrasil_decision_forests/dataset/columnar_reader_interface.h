@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Base interface for a stream of examples read directly in columnar format.
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_DATASET_COLUMNAR_READER_INTERFACE_H_
+#define YGGDRASIL_DECISION_FORESTS_DATASET_COLUMNAR_READER_INTERFACE_H_
+
+#include <optional>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/registration.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+
+// Interface to read a stream of examples directly into the typed columns of a
+// "VerticalDataset". Unlike "ExampleReaderInterface", no "proto::Example" is
+// materialized for each example.
+class ColumnarReaderInterface {
+ public:
+  virtual ~ColumnarReaderInterface() = default;
+
+  // Opens a dataset. If "load_columns" is set, only the columns in
+  // "load_columns" are populated by "NextBatch".
+  virtual absl::Status Open(
+      absl::string_view sharded_path,
+      const std::optional<std::vector<int>>& load_columns) = 0;
+
+  // Appends up to "max_num_examples" examples to "dataset". "dataset" should
+  // have been created with the dataspec of the reader (e.g. with
+  // "CreateColumnsFromDataspec"). Returns the number of appended examples. If
+  // no more examples are available, returns 0.
+  virtual absl::StatusOr<VerticalDataset::row_t> NextBatch(
+      VerticalDataset::row_t max_num_examples, VerticalDataset* dataset) = 0;
+};
+
+REGISTRATION_CREATE_POOL(ColumnarReaderInterface,
+                         const proto::DataSpecification&,
+                         std::optional<std::vector<int>>);
+
+#define REGISTER_ColumnarReaderInterface(name, key) \
+  REGISTRATION_REGISTER_CLASS(name, key, ColumnarReaderInterface)
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_DATASET_COLUMNAR_READER_INTERFACE_H_
@@ -16,7 +16,9 @@
 #include "yggdrasil_decision_forests/dataset/csv_example_reader.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -30,13 +32,18 @@
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/bytestream.h"
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
@@ -44,10 +51,44 @@ namespace dataset {
 
 using proto::ColumnType;
 
+namespace {
+
+// Size of the chunks of a csv file parsed in parallel. Small files are split
+// into several chunks per thread to balance the work, while the chunk size is
+// capped to bound the memory used by the parsed chunks.
+size_t ParallelCsvChunkSize(const size_t content_size, const int num_threads) {
+  constexpr size_t kMinChunkSize = 64 << 10;
+  constexpr size_t kMaxChunkSize = 4 << 20;
+  return std::clamp<size_t>(content_size / (4 * std::max(num_threads, 1)),
+                            kMinChunkSize, kMaxChunkSize);
+}
+
+// Parses the header of a csv file. Returns the header fields and the offset of
+// the first record after the header.
+absl::StatusOr<std::pair<std::vector<std::string>, size_t>> ReadCsvHeader(
+    const absl::string_view content, const absl::string_view path) {
+  const size_t header_end =
+      utils::csv::FindNextRecordStart(content, 0, /*in_quotes=*/false);
+  utils::StringViewInputByteStream stream(content.substr(0, header_end));
+  utils::csv::Reader reader(&stream);
+  std::vector<absl::string_view>* row;
+  ASSIGN_OR_RETURN(const bool has_header, reader.NextRow(&row));
+  if (!has_header) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("CSV file without header: ", path));
+  }
+  return std::make_pair(std::vector<std::string>(row->begin(), row->end()),
+                        header_end);
+}
+
+}  // namespace
+
 CsvExampleReader::Implementation::Implementation(
     const proto::DataSpecification& data_spec,
     const std::optional<std::vector<int>>& required_columns)
-    : data_spec_(data_spec), required_columns_(required_columns) {}
+    : data_spec_(data_spec),
+      categorical_dictionaries_(BuildCategoricalDictionaries(data_spec_)),
+      required_columns_(required_columns) {}
 
 absl::Status CsvExampleReader::Implementation::OpenShard(
     const absl::string_view path) {
@@ -84,7 +125,8 @@ absl::StatusOr<bool> CsvExampleReader::Implementation::NextInShard(
     return false;
   }
   RETURN_IF_ERROR(CsvRowToExample({row->begin(), row->end()}, data_spec_,
-                                  col_idx_to_field_idx_, example));
+                                  col_idx_to_field_idx_,
+                                  categorical_dictionaries_, example));
   return true;
 }
 
@@ -93,6 +135,305 @@ CsvExampleReader::CsvExampleReader(
     const std::optional<std::vector<int>> required_columns)
     : sharded_csv_reader_(data_spec, required_columns) {}
 
+bool CsvRowToColumns::IsSupportedColumn(const proto::Column& col_spec) {
+  return col_spec.type() != ColumnType::NUMERICAL_VECTOR_SEQUENCE;
+}
+
+bool CsvRowToColumns::IsSupported(
+    const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& load_columns) {
+  if (load_columns.has_value()) {
+    for (const int col_idx : load_columns.value()) {
+      if (col_idx >= 0 && col_idx < data_spec.columns_size() &&
+          !IsSupportedColumn(data_spec.columns(col_idx))) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (const auto& col_spec : data_spec.columns()) {
+    if (!IsSupportedColumn(col_spec)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<CsvRowToColumns> CsvRowToColumns::Create(
+    const proto::DataSpecification& data_spec,
+    const std::vector<std::string>& csv_header,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns) {
+  std::vector<int> col_idx_to_field_idx;
+  RETURN_IF_ERROR(BuildColIdxToFeatureLabelIdx(
+      data_spec, csv_header, required_columns, &col_idx_to_field_idx));
+
+  CsvRowToColumns row_to_columns;
+  const auto add_column = [&](const int col_idx) -> absl::Status {
+    STATUS_CHECK_GE(col_idx, 0);
+    STATUS_CHECK_LT(col_idx, data_spec.columns_size());
+    const auto& col_spec = data_spec.columns(col_idx);
+    if (!IsSupportedColumn(col_spec)) {
+      return absl::UnimplementedError(absl::StrCat(
+          "The column \"", col_spec.name(), "\" of type ",
+          proto::ColumnType_Name(col_spec.type()),
+          " cannot be parsed directly into the columns"));
+    }
+    std::shared_ptr<const CategoricalDictionary> dictionary;
+    if (col_spec.has_categorical()) {
+      dictionary = std::make_shared<const CategoricalDictionary>(col_spec);
+    }
+    row_to_columns.columns_.push_back(
+        {col_idx, col_idx_to_field_idx[col_idx], &col_spec,
+         std::move(dictionary)});
+    return absl::OkStatus();
+  };
+  if (load_columns.has_value()) {
+    for (const int col_idx : load_columns.value()) {
+      RETURN_IF_ERROR(add_column(col_idx));
+    }
+  } else {
+    for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
+      RETURN_IF_ERROR(add_column(col_idx));
+    }
+  }
+  return row_to_columns;
+}
+
+absl::Status CsvRowToColumns::CheckDataset(
+    const VerticalDataset& dataset) const {
+  for (const auto& column : columns_) {
+    STATUS_CHECK_LT(column.col_idx, dataset.ncol());
+    const auto* dst = dataset.column(column.col_idx);
+    if (dst->type() != column.spec->type()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The column \"", dst->name(), "\" of the dataset has type ",
+          proto::ColumnType_Name(dst->type()), " while the dataspec expects ",
+          proto::ColumnType_Name(column.spec->type())));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CsvRowToColumns::Append(
+    const absl::Span<const absl::string_view> row, VerticalDataset* dataset) {
+  for (const auto& column : columns_) {
+    auto* dst = dataset->mutable_column(column.col_idx);
+    if (column.field_idx == -1) {
+      dst->AddNA();
+      continue;
+    }
+    if (column.field_idx >= row.size()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The csv row has ", row.size(), " field(s) while the column \"",
+          column.spec->name(), "\" is the field #", column.field_idx));
+    }
+    RETURN_IF_ERROR(AppendValue(column, row[column.field_idx], dst));
+  }
+  dataset->set_nrow(dataset->nrow() + 1);
+  return absl::OkStatus();
+}
+
+absl::Status CsvRowToColumns::AppendValue(
+    const Column& column, const absl::string_view value,
+    VerticalDataset::AbstractColumn* dst) {
+  RETURN_IF_ERROR(
+      ParseCsvField(value, *column.spec, column.dictionary.get(), &parsed_));
+  if (parsed_.is_na) {
+    dst->AddNA();
+    return absl::OkStatus();
+  }
+
+  // Note: The column types are checked by "CheckDataset".
+  switch (column.spec->type()) {
+    case ColumnType::UNKNOWN:
+    case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+      dst->AddNA();
+      break;
+    case ColumnType::NUMERICAL:
+      static_cast<VerticalDataset::NumericalColumn*>(dst)->Add(
+          parsed_.numerical);
+      break;
+    case ColumnType::DISCRETIZED_NUMERICAL:
+      static_cast<VerticalDataset::DiscretizedNumericalColumn*>(dst)->Add(
+          parsed_.discretized_numerical);
+      break;
+    case ColumnType::NUMERICAL_SET:
+    case ColumnType::NUMERICAL_LIST:
+      static_cast<VerticalDataset::TemplateMultiValueStorage<float>*>(dst)
+          ->AddVector(parsed_.numerical_values);
+      break;
+    case ColumnType::CATEGORICAL:
+      static_cast<VerticalDataset::CategoricalColumn*>(dst)->Add(
+          parsed_.categorical);
+      break;
+    case ColumnType::CATEGORICAL_SET:
+    case ColumnType::CATEGORICAL_LIST:
+      static_cast<VerticalDataset::TemplateMultiValueStorage<int32_t>*>(dst)
+          ->AddVector(parsed_.categorical_values);
+      break;
+    case ColumnType::BOOLEAN:
+      static_cast<VerticalDataset::BooleanColumn*>(dst)->Add(parsed_.boolean);
+      break;
+    case ColumnType::STRING:
+      static_cast<VerticalDataset::StringColumn*>(dst)->Add(value);
+      break;
+    case ColumnType::HASH:
+      static_cast<VerticalDataset::HashColumn*>(dst)->Add(parsed_.hash);
+      break;
+  }
+  return absl::OkStatus();
+}
+
+CsvColumnarReader::CsvColumnarReader(
+    const proto::DataSpecification& data_spec,
+    std::optional<std::vector<int>> required_columns)
+    : data_spec_(data_spec), required_columns_(std::move(required_columns)) {}
+
+absl::Status CsvColumnarReader::Open(
+    const absl::string_view sharded_path,
+    const std::optional<std::vector<int>>& load_columns) {
+  load_columns_ = load_columns;
+  if (!CsvRowToColumns::IsSupported(data_spec_, load_columns_)) {
+    // Row-wise reading.
+    example_reader_ =
+        std::make_unique<CsvExampleReader>(data_spec_, required_columns_);
+    return example_reader_->Open(sharded_path);
+  }
+  RETURN_IF_ERROR(utils::ExpandInputShards(sharded_path, &shards_));
+  if (shards_.empty()) {
+    return absl::NotFoundError(
+        absl::StrCat("No files matching: ", sharded_path));
+  }
+  next_shard_idx_ = 0;
+  return OpenNextShard().status();
+}
+
+absl::StatusOr<bool> CsvColumnarReader::OpenNextShard() {
+  RETURN_IF_ERROR(file_closer_.Close());
+  csv_reader_.reset();
+  if (next_shard_idx_ >= shards_.size()) {
+    return false;
+  }
+  const auto& path = shards_[next_shard_idx_++];
+  ASSIGN_OR_RETURN(auto file_handle, file::OpenInputFile(path));
+  csv_reader_ = std::make_unique<utils::csv::Reader>(file_handle.get());
+  RETURN_IF_ERROR(file_closer_.reset(std::move(file_handle)));
+
+  std::vector<absl::string_view>* new_header;
+  ASSIGN_OR_RETURN(const bool has_header, csv_reader_->NextRow(&new_header));
+  if (!has_header) {
+    return absl::InvalidArgumentError("CSV file without header");
+  }
+
+  if (!row_to_columns_.has_value()) {
+    csv_header_ = {new_header->begin(), new_header->end()};
+    ASSIGN_OR_RETURN(row_to_columns_,
+                     CsvRowToColumns::Create(data_spec_, csv_header_,
+                                             required_columns_, load_columns_));
+  } else if (!std::equal(csv_header_.begin(), csv_header_.end(),
+                         new_header->begin(), new_header->end())) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The header of ", path,
+                     " does not match the header of the other files"));
+  }
+  return true;
+}
+
+absl::StatusOr<VerticalDataset::row_t> CsvColumnarReader::NextBatch(
+    const VerticalDataset::row_t max_num_examples, VerticalDataset* dataset) {
+  if (example_reader_) {
+    VerticalDataset::row_t num_examples = 0;
+    while (num_examples < max_num_examples) {
+      ASSIGN_OR_RETURN(const bool has_example,
+                       example_reader_->Next(&example_));
+      if (!has_example) {
+        break;
+      }
+      RETURN_IF_ERROR(
+          dataset->AppendExampleWithStatus(example_, load_columns_));
+      num_examples++;
+    }
+    return num_examples;
+  }
+  if (!row_to_columns_.has_value()) {
+    return absl::FailedPreconditionError("The reader is not open");
+  }
+  RETURN_IF_ERROR(row_to_columns_->CheckDataset(*dataset));
+  VerticalDataset::row_t num_examples = 0;
+  std::vector<absl::string_view>* row;
+  while (num_examples < max_num_examples && csv_reader_) {
+    ASSIGN_OR_RETURN(const bool has_row, csv_reader_->NextRow(&row));
+    if (!has_row) {
+      RETURN_IF_ERROR(OpenNextShard().status());
+      continue;
+    }
+    RETURN_IF_ERROR(row_to_columns_->Append(*row, dataset));
+    num_examples++;
+  }
+  return num_examples;
+}
+
+absl::Status ReadCsvFileInParallel(
+    const absl::string_view path, const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns, const int num_threads,
+    const std::function<absl::Status(const VerticalDataset&)>& consume) {
+  ASSIGN_OR_RETURN(const auto file, utils::MemoryMappedFile::Open(path));
+  const absl::string_view content = file->data();
+  ASSIGN_OR_RETURN(const auto header, ReadCsvHeader(content, path));
+
+  // If some of the columns cannot be parsed directly into the columns, the
+  // rows are parsed as "proto::Example" (see "CsvExampleReader").
+  std::optional<CsvRowToColumns> row_to_columns;
+  std::vector<int> col_idx_to_field_idx;
+  std::vector<CategoricalDictionary> categorical_dictionaries;
+  if (CsvRowToColumns::IsSupported(data_spec, load_columns)) {
+    ASSIGN_OR_RETURN(row_to_columns,
+                     CsvRowToColumns::Create(data_spec, header.first,
+                                             required_columns, load_columns));
+  } else {
+    RETURN_IF_ERROR(BuildColIdxToFeatureLabelIdx(
+        data_spec, header.first, required_columns, &col_idx_to_field_idx));
+    categorical_dictionaries = BuildCategoricalDictionaries(data_spec);
+  }
+
+  const auto process = [&](utils::csv::Reader* reader)
+      -> absl::StatusOr<std::unique_ptr<VerticalDataset>> {
+    auto chunk = std::make_unique<VerticalDataset>();
+    chunk->set_data_spec(data_spec);
+    RETURN_IF_ERROR(chunk->CreateColumnsFromDataspec());
+    // Each chunk has its own buffers.
+    std::optional<CsvRowToColumns> chunk_row_to_columns = row_to_columns;
+    proto::Example example;
+    std::vector<absl::string_view>* row;
+    while (true) {
+      ASSIGN_OR_RETURN(const bool has_row, reader->NextRow(&row));
+      if (!has_row) {
+        break;
+      }
+      if (chunk_row_to_columns.has_value()) {
+        RETURN_IF_ERROR(chunk_row_to_columns->Append(*row, chunk.get()));
+      } else {
+        RETURN_IF_ERROR(CsvRowToExample({row->begin(), row->end()}, data_spec,
+                                        col_idx_to_field_idx,
+                                        categorical_dictionaries, &example));
+        RETURN_IF_ERROR(chunk->AppendExampleWithStatus(example, load_columns));
+      }
+    }
+    return chunk;
+  };
+
+  const absl::string_view records = content.substr(header.second);
+  return utils::csv::ReadChunksInParallel<std::unique_ptr<VerticalDataset>>(
+      records, num_threads, ParallelCsvChunkSize(records.size(), num_threads),
+      process,
+      [&](std::unique_ptr<VerticalDataset> chunk) -> absl::StatusOr<bool> {
+        RETURN_IF_ERROR(consume(*chunk));
+        return true;
+      });
+}
+
 // Does this value looks like to be a numerical value?
 bool LooksLikeANumber(const absl::string_view value) {
   float tmp;
@@ -143,7 +484,7 @@ absl::Status UpdateDataSpecWithCsvExample(
       } else {
         tokens.push_back(value);
       }
-      RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(tokens, col));
+      RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(tokens, col, col_acc));
     }
     if (col->type() == proto::ColumnType::DISCRETIZED_NUMERICAL) {
       float num_value;
@@ -172,6 +513,73 @@ absl::Status UpdateDataSpecWithCsvExample(
   return absl::OkStatus();
 }
 
+// Computes the column statistics of a single csv file. The file is tokenized
+// with "guide.num_threads()" threads while the statistics are accumulated in
+// the calling thread, in the order of the file.
+absl::Status ComputeColumnStatisticsInParallel(
+    const absl::string_view path, const proto::DataSpecificationGuide& guide,
+    proto::DataSpecification* data_spec,
+    proto::DataSpecificationAccumulator* accumulator) {
+  ASSIGN_OR_RETURN(const auto file, utils::MemoryMappedFile::Open(path));
+  const absl::string_view content = file->data();
+  ASSIGN_OR_RETURN(const auto header, ReadCsvHeader(content, path));
+  const std::vector<std::string>& csv_header = header.first;
+  std::vector<int> col_idx_to_field_idx;
+  RETURN_IF_ERROR(BuildColIdxToFeatureLabelIdx(*data_spec, csv_header, {},
+                                               &col_idx_to_field_idx));
+
+  using Rows = std::vector<std::vector<std::string>>;
+  const auto process = [](utils::csv::Reader* reader) -> absl::StatusOr<Rows> {
+    Rows rows;
+    std::vector<absl::string_view>* row;
+    while (true) {
+      ASSIGN_OR_RETURN(const bool has_row, reader->NextRow(&row));
+      if (!has_row) {
+        break;
+      }
+      rows.emplace_back(row->begin(), row->end());
+    }
+    return rows;
+  };
+
+  const auto max_num_scanned_rows_to_accumulate_statistics =
+      guide.max_num_scanned_rows_to_accumulate_statistics();
+  StatisticsRowSampler sampler(guide, path);
+  uint64_t nrow = 0;
+  uint64_t num_selected_rows = 0;
+  const auto consume = [&](Rows rows) -> absl::StatusOr<bool> {
+    for (const auto& row : rows) {
+      if (max_num_scanned_rows_to_accumulate_statistics > 0 &&
+          nrow >= max_num_scanned_rows_to_accumulate_statistics) {
+        return false;
+      }
+      LOG_EVERY_N_SEC(INFO, 30) << nrow << " row(s) processed";
+      // Check the number of fields.
+      if (row.size() != csv_header.size()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Inconsistent number of columns at line ", nrow, " of file ", path,
+            ". The header has ", csv_header.size(),
+            " field(s) while this line has ", row.size()));
+      }
+      if (sampler.SelectNextRow()) {
+        RETURN_IF_ERROR(UpdateDataSpecWithCsvExample(
+            row, col_idx_to_field_idx, data_spec, accumulator));
+        num_selected_rows++;
+      }
+      nrow++;
+    }
+    return true;
+  };
+
+  const absl::string_view records = content.substr(header.second);
+  RETURN_IF_ERROR(utils::csv::ReadChunksInParallel<Rows>(
+      records, guide.num_threads(),
+      ParallelCsvChunkSize(records.size(), guide.num_threads()), process,
+      consume));
+  data_spec->set_created_num_rows(num_selected_rows);
+  return absl::OkStatus();
+}
+
 absl::Status CsvDataSpecCreator::InferColumnsAndTypes(
     const std::vector<std::string>& paths,
     const proto::DataSpecificationGuide& guide,
@@ -262,11 +670,21 @@ absl::Status CsvDataSpecCreator::ComputeColumnStatistics(
     const proto::DataSpecificationGuide& guide,
     proto::DataSpecification* data_spec,
     proto::DataSpecificationAccumulator* accumulator) {
+  // Only local files are scanned in parallel. Non-local files (e.g. remote
+  // files) are streamed instead of being read entirely in memory.
+  if (paths.size() == 1 && guide.num_threads() > 1 &&
+      utils::MemoryMappedFile::CanMap(paths.front())) {
+    return ComputeColumnStatisticsInParallel(paths.front(), guide, data_spec,
+                                             accumulator);
+  }
+
   std::vector<int> col_idx_to_field_idx;
   std::vector<std::string> csv_header;
   uint64_t nrow = 0;
+  uint64_t num_selected_rows = 0;
   const auto max_num_scanned_rows_to_accumulate_statistics =
       guide.max_num_scanned_rows_to_accumulate_statistics();
+  StatisticsRowSampler sampler(guide, paths.front());
   for (const auto& path : paths) {
     // Open the csv file.
     auto csv_file = file::OpenInputFile(path).value();
@@ -308,14 +726,17 @@ absl::Status CsvDataSpecCreator::ComputeColumnStatistics(
             ". The header has ", csv_header.size(),
             " field(s) while this line has ", row->size()));
       }
-      RETURN_IF_ERROR(UpdateDataSpecWithCsvExample({row->begin(), row->end()},
-                                                   col_idx_to_field_idx,
-                                                   data_spec, accumulator));
+      if (sampler.SelectNextRow()) {
+        RETURN_IF_ERROR(UpdateDataSpecWithCsvExample(
+            {row->begin(), row->end()}, col_idx_to_field_idx, data_spec,
+            accumulator));
+        num_selected_rows++;
+      }
       nrow++;
     }
     if (scan_complete) break;
   }
-  data_spec->set_created_num_rows(nrow);
+  data_spec->set_created_num_rows(num_selected_rows);
   return absl::OkStatus();
 }
 
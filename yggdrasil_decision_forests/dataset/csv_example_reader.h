@@ -19,6 +19,7 @@
 #define YGGDRASIL_DECISION_FORESTS_DATASET_CSV_EXAMPLE_READER_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -27,10 +28,14 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/columnar_reader_interface.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
@@ -76,6 +81,9 @@ class CsvExampleReader final : public ExampleReaderInterface {
     // The data spec.
     const proto::DataSpecification data_spec_;
 
+    // Compiled categorical dictionaries of "data_spec_".
+    const std::vector<CategoricalDictionary> categorical_dictionaries_;
+
     // Currently, open file;
     std::unique_ptr<yggdrasil_decision_forests::utils::csv::Reader> csv_reader_;
     file::InputFileCloser file_closer_;
@@ -94,6 +102,105 @@ class CsvExampleReader final : public ExampleReaderInterface {
 
 REGISTER_ExampleReaderInterface(CsvExampleReader, "FORMAT_CSV");
 
+// Parses csv rows directly into the typed columns of a VerticalDataset.
+//
+// NUMERICAL_VECTOR_SEQUENCE columns are not supported. The readers fall back
+// to the row-wise "CsvExampleReader" when such columns are loaded (see
+// "IsSupported").
+class CsvRowToColumns {
+ public:
+  // Tests if the columns of "data_spec" can be parsed directly into the
+  // columns. If "load_columns" is set, only the columns in "load_columns" are
+  // considered.
+  static bool IsSupported(const proto::DataSpecification& data_spec,
+                          const std::optional<std::vector<int>>& load_columns);
+
+  // Matches the dataspec columns with the fields of "csv_header". If
+  // "load_columns" is set, only the columns in "load_columns" are populated.
+  static absl::StatusOr<CsvRowToColumns> Create(
+      const proto::DataSpecification& data_spec,
+      const std::vector<std::string>& csv_header,
+      const std::optional<std::vector<int>>& required_columns,
+      const std::optional<std::vector<int>>& load_columns);
+
+  // Checks that the columns of "dataset" match the dataspec. Should be called
+  // before "Append" is called on a new dataset.
+  absl::Status CheckDataset(const VerticalDataset& dataset) const;
+
+  // Appends a csv row to "dataset".
+  absl::Status Append(absl::Span<const absl::string_view> row,
+                      VerticalDataset* dataset);
+
+ private:
+  // A dataspec column to populate.
+  struct Column {
+    int col_idx;
+    // Index of the column in the csv row, or -1 if the column is missing.
+    int field_idx;
+    const proto::Column* spec;
+    // Compiled dictionary of the categorical columns. Shared between the
+    // copies of the "CsvRowToColumns".
+    std::shared_ptr<const CategoricalDictionary> dictionary;
+  };
+
+  // Tests if a column can be parsed directly into the columns.
+  static bool IsSupportedColumn(const proto::Column& col_spec);
+
+  // Appends the value of a field to a column.
+  absl::Status AppendValue(const Column& column, absl::string_view value,
+                           VerticalDataset::AbstractColumn* dst);
+
+  std::vector<Column> columns_;
+
+  // Buffer re-used for each field.
+  CsvFieldValue parsed_;
+};
+
+// Columnar reader from a csv file. The rows are parsed directly into the
+// columns of the dataset (see "CsvRowToColumns"). If some of the loaded columns
+// are not supported by "CsvRowToColumns", the rows are read with a
+// "CsvExampleReader" instead.
+class CsvColumnarReader final : public ColumnarReaderInterface {
+ public:
+  CsvColumnarReader(const proto::DataSpecification& data_spec,
+                    std::optional<std::vector<int>> required_columns);
+
+  absl::Status Open(
+      absl::string_view sharded_path,
+      const std::optional<std::vector<int>>& load_columns) override;
+
+  absl::StatusOr<VerticalDataset::row_t> NextBatch(
+      VerticalDataset::row_t max_num_examples,
+      VerticalDataset* dataset) override;
+
+ private:
+  // Opens the next shard. Returns false if all the shards have been read.
+  absl::StatusOr<bool> OpenNextShard();
+
+  const proto::DataSpecification data_spec_;
+  const std::optional<std::vector<int>> required_columns_;
+  std::optional<std::vector<int>> load_columns_;
+
+  std::vector<std::string> shards_;
+  int next_shard_idx_ = 0;
+
+  // Currently, open file.
+  std::unique_ptr<utils::csv::Reader> csv_reader_;
+  file::InputFileCloser file_closer_;
+
+  // Header of the csv files.
+  std::vector<std::string> csv_header_;
+  std::optional<CsvRowToColumns> row_to_columns_;
+
+  // Row-wise reader, if some of the loaded columns are not supported by
+  // "CsvRowToColumns".
+  std::unique_ptr<CsvExampleReader> example_reader_;
+  // Buffer re-used for each example of "example_reader_".
+  proto::Example example_;
+};
+
+REGISTER_ColumnarReaderInterface(CsvColumnarReader, "FORMAT_CSV");
+
 class CsvDataSpecCreator : public AbstractDataSpecCreator {
  public:
   absl::Status InferColumnsAndTypes(
@@ -112,6 +219,20 @@ class CsvDataSpecCreator : public AbstractDataSpecCreator {
 
 REGISTER_AbstractDataSpecCreator(CsvDataSpecCreator, "FORMAT_CSV");
 
+// Reads a single csv file with "num_threads" threads. The file is
+// memory-mapped and split into chunks of whole records that are parsed
+// concurrently into the columns of a VerticalDataset each (see
+// "utils::csv::ReadChunksInParallel" and "CsvRowToColumns"). "consume" is
+// called on each chunk, in the order of the file, in the calling thread. If
+// "load_columns" is set, only the columns in "load_columns" are populated. The
+// columns not supported by "CsvRowToColumns" are parsed row-wise with
+// "CsvRowToExample".
+absl::Status ReadCsvFileInParallel(
+    absl::string_view path, const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns, int num_threads,
+    const std::function<absl::Status(const VerticalDataset&)>& consume);
+
 // Determine the most likely type of the attribute according to the current
 // most likely value type and an observed string value.
 absl::StatusOr<proto::ColumnType> InferType(
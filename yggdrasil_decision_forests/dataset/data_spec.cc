@@ -33,6 +33,7 @@
 #include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -145,10 +146,8 @@ int32_t NonintegerizedCategoricalStringToValue(absl::string_view value,
   }
 }
 
-// TODO: Remove this version when external protobuffer supports dictionary
-// query with absl::string_view.
 absl::StatusOr<int32_t> CategoricalStringToValueWithStatus(
-    const std::string& value, const proto::Column& col_spec) {
+    const absl::string_view value, const proto::Column& col_spec) {
   if (col_spec.categorical().is_already_integerized()) {
     int32_t int_value;
     if (!absl::SimpleAtoi(value, &int_value)) {
@@ -164,6 +163,66 @@ absl::StatusOr<int32_t> CategoricalStringToValueWithStatus(
   }
 }
 
+CategoricalDictionary::CategoricalDictionary(const proto::Column& col_spec)
+    : column_name_(col_spec.name()),
+      is_already_integerized_(col_spec.categorical().is_already_integerized()),
+      number_of_unique_values_(
+          col_spec.categorical().number_of_unique_values()) {
+  if (is_already_integerized_) {
+    return;
+  }
+  const auto& items = col_spec.categorical().items();
+  items_.reserve(items.size());
+  for (const auto& item : items) {
+    items_.emplace(item.first, item.second.index());
+  }
+}
+
+absl::StatusOr<int32_t> CategoricalDictionary::Lookup(
+    const absl::string_view value) const {
+  if (is_already_integerized_) {
+    int32_t int_value;
+    if (!absl::SimpleAtoi(value, &int_value)) {
+      STATUS_FATALS("Cannot parse the string \"", value,
+                    "\" as an integer for columns \"", column_name_, "\".");
+    }
+    STATUS_CHECK_GE(int_value, 0);
+    STATUS_CHECK_LT(int_value, number_of_unique_values_);
+    return int_value;
+  }
+  return NonintegerizedLookup(value);
+}
+
+absl::Status CategoricalDictionary::LookupBatch(
+    const absl::Span<const absl::string_view> values,
+    const absl::Span<int32_t> dst) const {
+  STATUS_CHECK_EQ(values.size(), dst.size());
+  if (is_already_integerized_) {
+    for (size_t value_idx = 0; value_idx < values.size(); value_idx++) {
+      ASSIGN_OR_RETURN(dst[value_idx], Lookup(values[value_idx]));
+    }
+    return absl::OkStatus();
+  }
+  for (size_t value_idx = 0; value_idx < values.size(); value_idx++) {
+    dst[value_idx] = NonintegerizedLookup(values[value_idx]);
+  }
+  return absl::OkStatus();
+}
+
+std::vector<CategoricalDictionary> BuildCategoricalDictionaries(
+    const proto::DataSpecification& data_spec) {
+  std::vector<CategoricalDictionary> dictionaries;
+  dictionaries.reserve(data_spec.columns_size());
+  for (const auto& col_spec : data_spec.columns()) {
+    if (col_spec.has_categorical()) {
+      dictionaries.emplace_back(col_spec);
+    } else {
+      dictionaries.emplace_back();
+    }
+  }
+  return dictionaries;
+}
+
 absl::Status BuildColIdxToFeatureLabelIdx(
     const proto::DataSpecification& data_spec,
     const std::vector<std::string>& fields,
@@ -289,11 +348,133 @@ bool HasColumn(absl::string_view name,
   return false;
 }
 
-absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
-                             const proto::DataSpecification& data_spec,
-                             const std::vector<int>& col_idx_to_field_idx,
-                             proto::Example* example) {
+absl::Status ParseCsvField(const absl::string_view value,
+                           const proto::Column& col_spec,
+                           const CategoricalDictionary* dictionary,
+                           CsvFieldValue* parsed) {
+  parsed->is_na = false;
+  if (absl::EqualsIgnoreCase(value, CSV_NA) ||
+      absl::EqualsIgnoreCase(value, CSV_NA_V2)) {
+    parsed->is_na = true;
+    return absl::OkStatus();
+  }
+
+  const auto categorical_string_to_value =
+      [&](const absl::string_view value) -> absl::StatusOr<int32_t> {
+    if (dictionary) {
+      return dictionary->Lookup(value);
+    }
+    return CategoricalStringToValueWithStatus(value, col_spec);
+  };
+
+  switch (col_spec.type()) {
+    case ColumnType::UNKNOWN:
+      parsed->is_na = true;
+      break;
+    case ColumnType::NUMERICAL:
+    case ColumnType::DISCRETIZED_NUMERICAL: {
+      if (value.empty()) {
+        parsed->is_na = true;
+        break;
+      }
+      float num_value;
+      if (!absl::SimpleAtof(value, &num_value)) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Cannot parse value ", value, " as a float"));
+      }
+      if (col_spec.type() == ColumnType::NUMERICAL) {
+        parsed->numerical = num_value;
+      } else {
+        parsed->discretized_numerical =
+            NumericalToDiscretizedNumerical(col_spec, num_value);
+      }
+    } break;
+    case ColumnType::NUMERICAL_SET:
+    case ColumnType::NUMERICAL_LIST: {
+      RETURN_IF_ERROR(Tokenize(value, col_spec.tokenizer(), &parsed->tokens));
+      auto& values = parsed->numerical_values;
+      values.clear();
+      for (const std::string& token : parsed->tokens) {
+        float num_value;
+        if (!absl::SimpleAtof(token, &num_value)) {
+          return absl::InvalidArgumentError(
+              absl::StrCat("Cannot parse: ", token));
+        }
+        values.push_back(num_value);
+      }
+      if (col_spec.type() == ColumnType::NUMERICAL_SET) {
+        // Sets are expected to be sorted.
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+      }
+    } break;
+    case ColumnType::CATEGORICAL: {
+      if (value.empty()) {
+        parsed->is_na = true;
+        break;
+      }
+      ASSIGN_OR_RETURN(parsed->categorical, categorical_string_to_value(value));
+    } break;
+    case ColumnType::CATEGORICAL_SET:
+    case ColumnType::CATEGORICAL_LIST: {
+      RETURN_IF_ERROR(Tokenize(value, col_spec.tokenizer(), &parsed->tokens));
+      auto& values = parsed->categorical_values;
+      values.clear();
+      for (const std::string& token : parsed->tokens) {
+        ASSIGN_OR_RETURN(const int32_t int_value,
+                         categorical_string_to_value(token));
+        values.push_back(int_value);
+      }
+      if (col_spec.type() == ColumnType::CATEGORICAL_SET) {
+        // Sets are expected to be sorted.
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+      }
+    } break;
+    case ColumnType::BOOLEAN: {
+      if (value.empty()) {
+        parsed->is_na = true;
+        break;
+      }
+      float num_value;
+      if (!absl::SimpleAtof(value, &num_value)) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Cannot parse: ", value));
+      }
+      parsed->boolean = num_value >= 0.5f;
+    } break;
+    case ColumnType::STRING:
+      break;
+    case ColumnType::HASH: {
+      if (value.empty()) {
+        parsed->is_na = true;
+        break;
+      }
+      parsed->hash = HashColumnString(value);
+    } break;
+    case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+      return absl::UnimplementedError(
+          "Vector sequence is not supported in csv files");
+  }
+  return absl::OkStatus();
+}
+
+namespace {
+
+// Implementation of "CsvRowToExample". If "categorical_dictionaries" is null,
+// the categorical values are looked up in the dataspec directly.
+absl::Status CsvRowToExampleImpl(
+    const std::vector<std::string>& csv_fields,
+    const proto::DataSpecification& data_spec,
+    const std::vector<int>& col_idx_to_field_idx,
+    const std::vector<CategoricalDictionary>* categorical_dictionaries,
+    proto::Example* example) {
   STATUS_CHECK_EQ(col_idx_to_field_idx.size(), data_spec.columns_size());
+  if (categorical_dictionaries) {
+    STATUS_CHECK_EQ(categorical_dictionaries->size(),
+                    data_spec.columns_size());
+  }
+  CsvFieldValue parsed;
   example->mutable_attributes()->Clear();
   example->mutable_attributes()->Reserve(data_spec.columns_size());
   for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
@@ -305,122 +486,78 @@ absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
       continue;
     }
     const auto& value = csv_fields[field_idx];
-    const auto lower_case = absl::AsciiStrToLower(value);
-    if (lower_case == CSV_NA || lower_case == CSV_NA_V2) {
+    RETURN_IF_ERROR(ParseCsvField(
+        value, col_spec,
+        categorical_dictionaries ? &(*categorical_dictionaries)[col_idx]
+                                 : nullptr,
+        &parsed));
+    if (parsed.is_na) {
       continue;
     }
 
     switch (col_spec.type()) {
       case ColumnType::UNKNOWN:
+      case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+        break;
+      case ColumnType::NUMERICAL:
+        dst_value->set_numerical(parsed.numerical);
+        break;
+      case ColumnType::DISCRETIZED_NUMERICAL:
+        dst_value->set_discretized_numerical(parsed.discretized_numerical);
         break;
-      case ColumnType::NUMERICAL: {
-        if (value.empty()) {
-          break;
-        }
-        float num_value;
-        if (!absl::SimpleAtof(value, &num_value)) {
-          return absl::InvalidArgumentError(
-              absl::StrCat("Cannot parse value ", value, " as a float"));
-        }
-
-        dst_value->set_numerical(num_value);
-      } break;
-      case ColumnType::DISCRETIZED_NUMERICAL: {
-        if (value.empty()) {
-          break;
-        }
-        float num_value;
-        if (!absl::SimpleAtof(value, &num_value)) {
-          return absl::InvalidArgumentError(
-              absl::StrCat("Cannot parse value ", value, " as a float"));
-        }
-        dst_value->set_discretized_numerical(
-            NumericalToDiscretizedNumerical(col_spec, num_value));
-      } break;
       case ColumnType::NUMERICAL_SET:
-      case ColumnType::NUMERICAL_LIST: {
-        google::protobuf::RepeatedField<float>* dst;
-        if (col_spec.type() == ColumnType::NUMERICAL_SET) {
-          dst = dst_value->mutable_numerical_set()->mutable_values();
-        } else {
-          dst = dst_value->mutable_numerical_list()->mutable_values();
-        }
-        std::vector<std::string> tokens;
-        RETURN_IF_ERROR(Tokenize(value, col_spec.tokenizer(), &tokens));
-        dst->Reserve(tokens.size());
-        for (const std::string& token : tokens) {
-          float num_value;
-          if (!absl::SimpleAtof(token, &num_value)) {
-            return absl::InvalidArgumentError(
-                absl::StrCat("Cannot parse: ", token));
-          }
-          dst->Add(num_value);
-        }
-        if (col_spec.type() == ColumnType::NUMERICAL_SET) {
-          // Sets are expected to be sorted.
-          std::sort(dst->begin(), dst->end());
-          dst->erase(std::unique(dst->begin(), dst->end()), dst->end());
-        }
-      } break;
-      case ColumnType::CATEGORICAL: {
-        if (value.empty()) {
-          break;
-        }
-        ASSIGN_OR_RETURN(auto value,
-                         CategoricalStringToValueWithStatus(value, col_spec));
-        dst_value->set_categorical(value);
-      } break;
+        dst_value->mutable_numerical_set()->mutable_values()->Add(
+            parsed.numerical_values.begin(), parsed.numerical_values.end());
+        break;
+      case ColumnType::NUMERICAL_LIST:
+        dst_value->mutable_numerical_list()->mutable_values()->Add(
+            parsed.numerical_values.begin(), parsed.numerical_values.end());
+        break;
+      case ColumnType::CATEGORICAL:
+        dst_value->set_categorical(parsed.categorical);
+        break;
       case ColumnType::CATEGORICAL_SET:
-      case ColumnType::CATEGORICAL_LIST: {
-        google::protobuf::RepeatedField<int32_t>* dst;
-        if (col_spec.type() == ColumnType::CATEGORICAL_SET) {
-          dst = dst_value->mutable_categorical_set()->mutable_values();
-        } else {
-          dst = dst_value->mutable_categorical_list()->mutable_values();
-        }
-        std::vector<std::string> tokens;
-        RETURN_IF_ERROR(Tokenize(value, col_spec.tokenizer(), &tokens));
-        dst->Reserve(tokens.size());
-        for (const std::string& token : tokens) {
-          ASSIGN_OR_RETURN(auto value,
-                           CategoricalStringToValueWithStatus(token, col_spec));
-          dst->Add(value);
-        }
-        if (col_spec.type() == ColumnType::CATEGORICAL_SET) {
-          // Sets are expected to be sorted.
-          std::sort(dst->begin(), dst->end());
-          dst->erase(std::unique(dst->begin(), dst->end()), dst->end());
-        }
-      } break;
-      case ColumnType::BOOLEAN: {
-        if (value.empty()) {
-          break;
-        }
-        float num_value;
-        if (!absl::SimpleAtof(value, &num_value)) {
-          return absl::InvalidArgumentError(
-              absl::StrCat("Cannot parse: ", value));
-        }
-        dst_value->set_boolean(num_value >= 0.5f);
-      } break;
+        dst_value->mutable_categorical_set()->mutable_values()->Add(
+            parsed.categorical_values.begin(), parsed.categorical_values.end());
+        break;
+      case ColumnType::CATEGORICAL_LIST:
+        dst_value->mutable_categorical_list()->mutable_values()->Add(
+            parsed.categorical_values.begin(), parsed.categorical_values.end());
+        break;
+      case ColumnType::BOOLEAN:
+        dst_value->set_boolean(parsed.boolean);
+        break;
       case ColumnType::STRING:
-        *dst_value->mutable_text() = std::string{value};
+        *dst_value->mutable_text() = value;
         break;
-      case ColumnType::HASH: {
-        if (value.empty()) {
-          break;
-        }
-        dst_value->set_hash(HashColumnString(value));
-      } break;
-      case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
-        return absl::UnimplementedError(
-            "Vector sequence is not supported in csv files");
+      case ColumnType::HASH:
+        dst_value->set_hash(parsed.hash);
         break;
     }
   }
   return absl::OkStatus();
 }
 
+}  // namespace
+
+absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
+                             const proto::DataSpecification& data_spec,
+                             const std::vector<int>& col_idx_to_field_idx,
+                             proto::Example* example) {
+  return CsvRowToExampleImpl(csv_fields, data_spec, col_idx_to_field_idx,
+                             /*categorical_dictionaries=*/nullptr, example);
+}
+
+absl::Status CsvRowToExample(
+    const std::vector<std::string>& csv_fields,
+    const proto::DataSpecification& data_spec,
+    const std::vector<int>& col_idx_to_field_idx,
+    const std::vector<CategoricalDictionary>& categorical_dictionaries,
+    proto::Example* example) {
+  return CsvRowToExampleImpl(csv_fields, data_spec, col_idx_to_field_idx,
+                             &categorical_dictionaries, example);
+}
+
 absl::Status ExampleToCsvRow(const proto::Example& example,
                              const proto::DataSpecification& data_spec,
                              std::vector<std::string>* csv_fields) {
@@ -20,13 +20,16 @@
 #include <cmath>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <regex>  // NOLINT
 #include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "absl/base/casts.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -37,10 +40,13 @@
 #include "absl/strings/substitute.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec_sketch.h"
 #include "yggdrasil_decision_forests/dataset/formats.h"
 #include "yggdrasil_decision_forests/dataset/formats.pb.h"
 #include "yggdrasil_decision_forests/utils/accurate_sum.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
+#include "yggdrasil_decision_forests/utils/hash.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
@@ -128,8 +134,110 @@ absl::Status UpdateColSpecsWithGuideInfo(
   return absl::OkStatus();
 }
 
+namespace {
+
+// Reduces the dictionary of "col" if it contains more than
+// "col_acc->max_num_dictionary_items()" items (noted N). Does nothing if N is
+// not set (i.e. <= 0).
+//
+// The dictionary is a Misra-Gries frequent items summary (Agarwal et al.,
+// "Mergeable summaries", 2012): The count "c" of the (N/2+1)-th most frequent
+// item is subtracted from the count of all the items, the items with a null
+// count are removed, and the subtracted counts are attributed to the
+// out-of-dictionary item. At least "N/2+1" items are decreased by "c", so
+// the sum of the "c"s (i.e. the maximum underestimation of any count, stored
+// in "col_acc->dictionary_count_error()") is at most "number of values /
+// (N/2+1)". The result does not depend on the order of the items.
+void ReduceCategoricalDictionary(
+    proto::DataSpecificationAccumulator::Column* col_acc, proto::Column* col) {
+  const int64_t max_num_items = col_acc->max_num_dictionary_items();
+  if (max_num_items <= 0) {
+    return;
+  }
+  auto* items = col->mutable_categorical()->mutable_items();
+  const int64_t num_items =
+      items->size() - items->count(std::string(kOutOfDictionaryItemKey));
+  if (num_items <= max_num_items) {
+    return;
+  }
+
+  std::vector<int64_t> counts;
+  counts.reserve(num_items);
+  for (const auto& item : *items) {
+    if (item.first != kOutOfDictionaryItemKey) {
+      counts.push_back(item.second.count());
+    }
+  }
+  const int64_t num_kept_items = std::max<int64_t>(max_num_items / 2, 1);
+  std::nth_element(counts.begin(), counts.begin() + num_kept_items,
+                   counts.end(), std::greater<int64_t>());
+  const int64_t decrement = counts[num_kept_items];
+
+  int64_t count_removed = 0;
+  for (auto it = items->begin(); it != items->end();) {
+    if (it->first == kOutOfDictionaryItemKey) {
+      ++it;
+      continue;
+    }
+    if (it->second.count() <= decrement) {
+      count_removed += it->second.count();
+      it = items->erase(it);
+    } else {
+      count_removed += decrement;
+      it->second.set_count(it->second.count() - decrement);
+      ++it;
+    }
+  }
+  auto& ood_item = (*items)[kOutOfDictionaryItemKey];
+  ood_item.set_count(ood_item.count() + count_removed);
+  col_acc->set_dictionary_count_error(col_acc->dictionary_count_error() +
+                                      decrement);
+}
+
+// Adds a categorical string value to the cardinality sketch of the column if
+// its dictionary is sketched.
+void AddToCategoricalCardinalitySketch(
+    const absl::string_view value,
+    proto::DataSpecificationAccumulator::Column* col_acc) {
+  if (col_acc->max_num_dictionary_items() > 0) {
+    AddToCardinalitySketch(HashColumnString(value),
+                           col_acc->mutable_cardinality_sketch());
+  }
+}
+
+// Moves the exact values of a DISCRETIZED_NUMERICAL column (i.e.
+// "discretized_numerical") to a KLL sketch if they contain more than
+// "max_num_discretized_numerical_values" unique values, or if "force" is true.
+void SketchDiscretizedNumerical(
+    const bool force, proto::DataSpecificationAccumulator::Column* col_acc) {
+  const int64_t max_num_values =
+      col_acc->max_num_discretized_numerical_values();
+  if (max_num_values <= 0 || col_acc->has_discretized_numerical_sketch() ||
+      (!force && col_acc->discretized_numerical_size() <= max_num_values)) {
+    return;
+  }
+  // A sketch of parameter "k" contains less than "3 x k" values.
+  auto* sketch = col_acc->mutable_discretized_numerical_sketch();
+  InitializeKllSketch(std::max<int64_t>(max_num_values / 3, 8), sketch);
+
+  // The values are inserted in order since the iteration order of a proto map
+  // is not specified.
+  std::vector<std::pair<uint32_t, int32_t>> values_and_counts(
+      col_acc->discretized_numerical().begin(),
+      col_acc->discretized_numerical().end());
+  std::sort(values_and_counts.begin(), values_and_counts.end());
+  for (const auto& value_and_count : values_and_counts) {
+    AddToKllSketch(absl::bit_cast<float>(value_and_count.first),
+                   value_and_count.second, sketch);
+  }
+  col_acc->clear_discretized_numerical();
+}
+
+}  // namespace
+
 absl::Status AddTokensToCategoricalColumnSpec(
-    const std::vector<std::string>& tokens, proto::Column* col) {
+    const std::vector<std::string>& tokens, proto::Column* col,
+    proto::DataSpecificationAccumulator::Column* col_acc) {
   if (col->categorical().is_already_integerized()) {
     // The tokens are already numbers (stored as strings).
     for (const std::string& token : tokens) {
@@ -153,6 +261,12 @@ absl::Status AddTokensToCategoricalColumnSpec(
       auto& item = (*items)[token];
       item.set_count(item.count() + 1);
     }
+    if (col_acc) {
+      for (const std::string& token : tokens) {
+        AddToCategoricalCardinalitySketch(token, col_acc);
+      }
+      ReduceCategoricalDictionary(col_acc, col);
+    }
   }
   return absl::OkStatus();
 }
@@ -160,11 +274,21 @@ absl::Status AddTokensToCategoricalColumnSpec(
 void UpdateComputeSpecDiscretizedNumerical(
     const float value, proto::Column* column,
     proto::DataSpecificationAccumulator::Column* accumulator) {
-  if (!std::isnan(value)) {
-    // TODO: Use absl::bit_cast.
-    const uint32_t int_value = *reinterpret_cast<const uint32_t*>(&value);
-    (*accumulator->mutable_discretized_numerical())[int_value]++;
+  if (std::isnan(value)) {
+    return;
+  }
+  const uint32_t int_value = absl::bit_cast<uint32_t>(value);
+  if (accumulator->max_num_discretized_numerical_values() > 0) {
+    AddToCardinalitySketch(HashColumnInteger(int_value),
+                           accumulator->mutable_cardinality_sketch());
+  }
+  if (accumulator->has_discretized_numerical_sketch()) {
+    AddToKllSketch(value, /*weight=*/1,
+                   accumulator->mutable_discretized_numerical_sketch());
+    return;
   }
+  (*accumulator->mutable_discretized_numerical())[int_value]++;
+  SketchDiscretizedNumerical(/*force=*/false, accumulator);
 }
 
 void UpdateComputeSpecBooleanFeature(float value, proto::Column* column) {
@@ -226,12 +350,30 @@ absl::Status FinalizeComputeSpecDiscretizedNumerical(
     const proto::DataSpecificationAccumulator::Column& accumulator,
     proto::Column* column) {
   std::vector<std::pair<float, int>> unique_values_and_counts;
-  unique_values_and_counts.reserve(accumulator.discretized_numerical_size());
-  for (const auto& item : accumulator.discretized_numerical()) {
-    unique_values_and_counts.emplace_back(
-        *reinterpret_cast<const float*>(&item.first), item.second);
+  int64_t original_num_unique_values;
+  if (accumulator.has_discretized_numerical_sketch()) {
+    for (const auto& item : KllSketchValuesAndCounts(
+             accumulator.discretized_numerical_sketch())) {
+      unique_values_and_counts.emplace_back(
+          item.first, static_cast<int>(std::min<int64_t>(
+                          item.second, std::numeric_limits<int>::max())));
+    }
+    original_num_unique_values =
+        EstimateCardinality(accumulator.cardinality_sketch());
+    LOG(INFO) << "The boundaries of the column " << column->name()
+              << " are computed on a sketch of "
+              << unique_values_and_counts.size() << " value(s) out of ~"
+              << original_num_unique_values << " unique value(s)";
+  } else {
+    unique_values_and_counts.reserve(accumulator.discretized_numerical_size());
+    for (const auto& item : accumulator.discretized_numerical()) {
+      unique_values_and_counts.emplace_back(
+          absl::bit_cast<float>(item.first), item.second);
+    }
+    std::sort(unique_values_and_counts.begin(),
+              unique_values_and_counts.end());
+    original_num_unique_values = unique_values_and_counts.size();
   }
-  std::sort(unique_values_and_counts.begin(), unique_values_and_counts.end());
 
   ASSIGN_OR_RETURN(const auto bounds,
                    GenDiscretizedBoundaries(
@@ -241,7 +383,7 @@ absl::Status FinalizeComputeSpecDiscretizedNumerical(
                        {0.f, static_cast<float>(column->numerical().mean())}));
 
   column->mutable_discretized_numerical()->set_original_num_unique_values(
-      unique_values_and_counts.size());
+      original_num_unique_values);
 
   *column->mutable_discretized_numerical()->mutable_boundaries() = {
       bounds.begin(), bounds.end()};
@@ -361,6 +503,17 @@ absl::Status FinalizeComputeSpecColumnCategorical(
               << col->categorical().max_number_of_unique_values();
   }
 
+  if (col_acc.dictionary_count_error() > 0) {
+    LOG(INFO) << "The dictionary of the column " << col->name()
+              << " was accumulated with max_num_dictionary_items="
+              << col_acc.max_num_dictionary_items()
+              << ". The item counts are underestimated by at most "
+              << col_acc.dictionary_count_error()
+              << " and the column contains ~"
+              << EstimateCardinality(col_acc.cardinality_sketch())
+              << " unique value(s)";
+  }
+
   // Update the dictionary map.
   SortedDictionaryVectorToDictionaryMap(item_frequency_vector, col);
 
@@ -427,6 +580,269 @@ void InitializeDataspecAccumulator(
   }
 }
 
+void SetDictionaryLimits(const proto::DataSpecificationGuide& guide,
+                         proto::DataSpecificationAccumulator* accumulator) {
+  for (auto& col_acc : *accumulator->mutable_columns()) {
+    if (guide.max_num_dictionary_items_during_inference() > 0) {
+      col_acc.set_max_num_dictionary_items(
+          guide.max_num_dictionary_items_during_inference());
+    }
+    if (guide.max_num_discretized_numerical_values_during_inference() > 0) {
+      col_acc.set_max_num_discretized_numerical_values(
+          guide.max_num_discretized_numerical_values_during_inference());
+    }
+  }
+}
+
+StatisticsRowSampler::StatisticsRowSampler(
+    const proto::DataSpecificationGuide& guide, const absl::string_view path)
+    : select_all_(guide.row_sampling_rate_to_accumulate_statistics() >= 1.f),
+      threshold_(static_cast<uint64_t>(
+          std::max(guide.row_sampling_rate_to_accumulate_statistics(), 0.f) *
+          static_cast<double>(uint64_t{1} << 53))),
+      path_hash_(utils::hash::HashInt64ToUint64(
+          utils::hash::HashStringViewToUint64(path) ^
+          static_cast<uint64_t>(guide.row_sampling_seed()))) {}
+
+bool StatisticsRowSampler::SelectNextRow() {
+  if (select_all_) {
+    return true;
+  }
+  const uint64_t hash =
+      utils::hash::HashInt64ToUint64(path_hash_ + row_idx_++);
+  return (hash >> 11) < threshold_;
+}
+
+namespace {
+
+// Adds the Kahan sum "src" to the Kahan sum "dst".
+void MergeAccurateSum(const double src_sum, const double src_error_sum,
+                      double* dst_sum, double* dst_error_sum) {
+  AccurateSum acc(*dst_sum, *dst_error_sum);
+  acc.Add(src_sum);
+  acc.Add(src_error_sum);
+  *dst_sum = acc.Sum();
+  *dst_error_sum = acc.ErrorSum();
+}
+
+absl::Status MergeColumnAccumulator(
+    const proto::DataSpecificationAccumulator::Column& src,
+    proto::DataSpecificationAccumulator::Column* dst) {
+  double sum = dst->kahan_sum();
+  double error_sum = dst->kahan_sum_error();
+  MergeAccurateSum(src.kahan_sum(), src.kahan_sum_error(), &sum, &error_sum);
+  dst->set_kahan_sum(sum);
+  dst->set_kahan_sum_error(error_sum);
+
+  sum = dst->kahan_sum_of_square();
+  error_sum = dst->kahan_sum_of_square_error();
+  MergeAccurateSum(src.kahan_sum_of_square(), src.kahan_sum_of_square_error(),
+                   &sum, &error_sum);
+  dst->set_kahan_sum_of_square(sum);
+  dst->set_kahan_sum_of_square_error(error_sum);
+
+  if (src.has_min_value() &&
+      (!dst->has_min_value() || src.min_value() < dst->min_value())) {
+    dst->set_min_value(src.min_value());
+  }
+  if (src.has_max_value() &&
+      (!dst->has_max_value() || src.max_value() > dst->max_value())) {
+    dst->set_max_value(src.max_value());
+  }
+
+  if (src.has_discretized_numerical_sketch()) {
+    SketchDiscretizedNumerical(/*force=*/true, dst);
+  }
+  if (dst->has_discretized_numerical_sketch()) {
+    proto::DataSpecificationAccumulator::Column sketched_src;
+    const proto::DataSpecificationAccumulator::Column* src_with_sketch = &src;
+    if (!src.has_discretized_numerical_sketch()) {
+      sketched_src.set_max_num_discretized_numerical_values(
+          dst->max_num_discretized_numerical_values());
+      *sketched_src.mutable_discretized_numerical() =
+          src.discretized_numerical();
+      SketchDiscretizedNumerical(/*force=*/true, &sketched_src);
+      src_with_sketch = &sketched_src;
+    }
+    MergeKllSketch(src_with_sketch->discretized_numerical_sketch(),
+                   dst->mutable_discretized_numerical_sketch());
+  } else {
+    auto& dst_discretized_numerical = *dst->mutable_discretized_numerical();
+    for (const auto& value_and_count : src.discretized_numerical()) {
+      dst_discretized_numerical[value_and_count.first] +=
+          value_and_count.second;
+    }
+    SketchDiscretizedNumerical(/*force=*/false, dst);
+  }
+  MergeCardinalitySketch(src.cardinality_sketch(),
+                         dst->mutable_cardinality_sketch());
+  dst->set_dictionary_count_error(dst->dictionary_count_error() +
+                                  src.dictionary_count_error());
+  return absl::OkStatus();
+}
+
+// Merges the column statistics "src" into "dst". The dictionaries are merged
+// as Misra-Gries summaries i.e. their counts are summed before being reduced.
+absl::Status MergeColumnSpec(
+    const proto::Column& src,
+    proto::DataSpecificationAccumulator::Column* dst_acc, proto::Column* dst) {
+  if (src.name() != dst->name() || src.type() != dst->type()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot merge the statistics of the column \"",
+                     src.name(), "\" into the column \"", dst->name(), "\""));
+  }
+  dst->set_count_nas(dst->count_nas() + src.count_nas());
+
+  if (src.has_categorical()) {
+    auto* dst_categorical = dst->mutable_categorical();
+    if (src.categorical().is_already_integerized()) {
+      dst_categorical->set_number_of_unique_values(
+          std::max(dst_categorical->number_of_unique_values(),
+                   src.categorical().number_of_unique_values()));
+    } else {
+      auto& dst_items = *dst_categorical->mutable_items();
+      for (const auto& src_item : src.categorical().items()) {
+        auto& dst_item = dst_items[src_item.first];
+        dst_item.set_count(dst_item.count() + src_item.second.count());
+      }
+      ReduceCategoricalDictionary(dst_acc, dst);
+    }
+  }
+
+  if (src.has_boolean()) {
+    auto* dst_boolean = dst->mutable_boolean();
+    dst_boolean->set_count_true(dst_boolean->count_true() +
+                                src.boolean().count_true());
+    dst_boolean->set_count_false(dst_boolean->count_false() +
+                                 src.boolean().count_false());
+  }
+
+  if (src.has_numerical_vector_sequence()) {
+    const auto& src_seq = src.numerical_vector_sequence();
+    auto* dst_seq = dst->mutable_numerical_vector_sequence();
+    if (src_seq.has_vector_length()) {
+      if (dst_seq->has_vector_length() &&
+          dst_seq->vector_length() != src_seq.vector_length()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Inconsistent vector length in a SEQUENCE_VECTOR feature. Got "
+            "vectors of size ",
+            src_seq.vector_length(), " and ", dst_seq->vector_length()));
+      }
+      dst_seq->set_vector_length(src_seq.vector_length());
+    }
+    dst_seq->set_count_values(dst_seq->count_values() +
+                              src_seq.count_values());
+    if (src_seq.has_min_num_vectors()) {
+      dst_seq->set_min_num_vectors(
+          dst_seq->has_min_num_vectors()
+              ? std::min(dst_seq->min_num_vectors(), src_seq.min_num_vectors())
+              : src_seq.min_num_vectors());
+    }
+    if (src_seq.has_max_num_vectors()) {
+      dst_seq->set_max_num_vectors(
+          dst_seq->has_max_num_vectors()
+              ? std::max(dst_seq->max_num_vectors(), src_seq.max_num_vectors())
+              : src_seq.max_num_vectors());
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Computes the column statistics of each shard independently with
+// "guide.num_threads()" threads, and merges them in the order of the shards.
+// The result does not depend on the number of threads.
+absl::Status ComputeColumnStatisticsOfShardsInParallel(
+    const std::vector<std::string>& paths,
+    const proto::DataSpecificationGuide& guide,
+    AbstractDataSpecCreator* creator, proto::DataSpecification* data_spec,
+    proto::DataSpecificationAccumulator* accumulator) {
+  struct ShardStatistics {
+    proto::DataSpecification data_spec;
+    proto::DataSpecificationAccumulator accumulator;
+  };
+  const int num_threads = std::max(guide.num_threads(), 1);
+
+  // Each shard is scanned by a single thread.
+  proto::DataSpecificationGuide shard_guide = guide;
+  shard_guide.set_num_threads(1);
+  const proto::DataSpecification initial_data_spec = *data_spec;
+  const proto::DataSpecificationAccumulator initial_accumulator = *accumulator;
+
+  utils::concurrency::StreamProcessor<int, absl::StatusOr<ShardStatistics>>
+      processor(
+          "ComputeColumnStatistics", num_threads,
+          [&](const int shard_idx) -> absl::StatusOr<ShardStatistics> {
+            ShardStatistics statistics{initial_data_spec, initial_accumulator};
+            RETURN_IF_ERROR(creator->ComputeColumnStatistics(
+                {paths[shard_idx]}, shard_guide, &statistics.data_spec,
+                &statistics.accumulator));
+            return statistics;
+          },
+          /*result_in_order=*/true);
+  processor.StartWorkers();
+
+  // Only a limited number of shards are scanned in advance to bound the memory
+  // usage.
+  int next_shard_idx = 0;
+  while (next_shard_idx < paths.size() &&
+         next_shard_idx < 2 * num_threads) {
+    processor.Submit(next_shard_idx++);
+  }
+
+  uint64_t nrow = 0;
+  for (int shard_idx = 0; shard_idx < paths.size(); shard_idx++) {
+    std::optional<absl::StatusOr<ShardStatistics>> statistics =
+        processor.GetResult();
+    if (!statistics.has_value()) {
+      return absl::InternalError("Missing shard statistics");
+    }
+    if (next_shard_idx < paths.size()) {
+      processor.Submit(next_shard_idx++);
+    }
+    RETURN_IF_ERROR(statistics->status());
+    nrow += statistics->value().data_spec.created_num_rows();
+    if (shard_idx == 0) {
+      *data_spec = std::move(statistics->value().data_spec);
+      *accumulator = std::move(statistics->value().accumulator);
+    } else {
+      RETURN_IF_ERROR(MergeColumnStatistics(statistics->value().data_spec,
+                                            statistics->value().accumulator,
+                                            data_spec, accumulator));
+    }
+    LOG_EVERY_N_SEC(INFO, 30) << shard_idx + 1 << "/" << paths.size()
+                              << " shard(s) processed";
+  }
+  processor.CloseSubmits();
+  data_spec->set_created_num_rows(nrow);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status MergeColumnStatistics(
+    const proto::DataSpecification& src_data_spec,
+    const proto::DataSpecificationAccumulator& src_accumulator,
+    proto::DataSpecification* dst_data_spec,
+    proto::DataSpecificationAccumulator* dst_accumulator) {
+  if (src_data_spec.columns_size() != dst_data_spec->columns_size() ||
+      src_accumulator.columns_size() != dst_accumulator->columns_size() ||
+      src_data_spec.columns_size() != src_accumulator.columns_size()) {
+    return absl::InvalidArgumentError(
+        "The merged statistics have different columns");
+  }
+  for (int col_idx = 0; col_idx < src_data_spec.columns_size(); col_idx++) {
+    RETURN_IF_ERROR(MergeColumnAccumulator(
+        src_accumulator.columns(col_idx),
+        dst_accumulator->mutable_columns(col_idx)));
+    RETURN_IF_ERROR(MergeColumnSpec(src_data_spec.columns(col_idx),
+                                    dst_accumulator->mutable_columns(col_idx),
+                                    dst_data_spec->mutable_columns(col_idx)));
+  }
+  dst_data_spec->set_created_num_rows(dst_data_spec->created_num_rows() +
+                                      src_data_spec.created_num_rows());
+  return absl::OkStatus();
+}
+
 void MergeColumnGuide(const proto::ColumnGuide& src, proto::ColumnGuide* dst) {
   dst->MergeFrom(src);
 }
@@ -460,9 +876,17 @@ absl::Status AbstractDataSpecCreator::CreateDataspec(
   // each column.
   proto::DataSpecificationAccumulator accumulator;
   InitializeDataspecAccumulator(*data_spec, &accumulator);
-  // TODO: Call ComputeColumnStatistics in parallel on the other paths.
-  RETURN_IF_ERROR(
-      ComputeColumnStatistics(paths, guide, data_spec, &accumulator));
+  SetDictionaryLimits(guide, &accumulator);
+  // The shards are scanned independently even with a single thread so the
+  // dataspec does not depend on the number of threads.
+  if (paths.size() > 1 &&
+      guide.max_num_scanned_rows_to_accumulate_statistics() <= 0) {
+    RETURN_IF_ERROR(ComputeColumnStatisticsOfShardsInParallel(
+        paths, guide, this, data_spec, &accumulator));
+  } else {
+    RETURN_IF_ERROR(
+        ComputeColumnStatistics(paths, guide, data_spec, &accumulator));
+  }
   RETURN_IF_ERROR(FinalizeComputeSpec(guide, accumulator, data_spec));
   return absl::OkStatus();
 }
@@ -657,6 +1081,8 @@ absl::Status UpdateCategoricalStringColumnSpec(
     auto* items = col->mutable_categorical()->mutable_items();
     auto& item = (*items)[str_value];
     item.set_count(item.count() + 1);
+    AddToCategoricalCardinalitySketch(str_value, col_acc);
+    ReduceCategoricalDictionary(col_acc, col);
   }
   return absl::OkStatus();
 }
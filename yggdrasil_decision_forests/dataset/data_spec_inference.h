@@ -118,6 +118,45 @@ void InitializeDataspecAccumulator(
     const proto::DataSpecification& data_spec,
     proto::DataSpecificationAccumulator* accumulator);
 
+// Sets the maximum number of dictionary items and discretized numerical values
+// of the accumulator columns according to
+// "guide.max_num_dictionary_items_during_inference" and
+// "guide.max_num_discretized_numerical_values_during_inference". Should be
+// called after "InitializeDataspecAccumulator".
+void SetDictionaryLimits(const proto::DataSpecificationGuide& guide,
+                         proto::DataSpecificationAccumulator* accumulator);
+
+// Selects the rows used to compute the column statistics according to
+// "guide.row_sampling_rate_to_accumulate_statistics". Each row is selected
+// independently with a hash of "guide.row_sampling_seed", of the first path
+// given to "ComputeColumnStatistics", and of the index of the row.
+class StatisticsRowSampler {
+ public:
+  StatisticsRowSampler(const proto::DataSpecificationGuide& guide,
+                       absl::string_view path);
+
+  // Tests if the next row is selected. Should be called once for each
+  // scanned row, in order.
+  bool SelectNextRow();
+
+ private:
+  bool select_all_;
+  // A row is selected if the 53 high bits of its hash are below this value.
+  uint64_t threshold_;
+  uint64_t path_hash_;
+  int64_t row_idx_ = 0;
+};
+
+// Merges the statistics accumulated by "ComputeColumnStatistics" on a part of a
+// dataset (e.g. a shard) into the statistics accumulated on another part. Both
+// dataspecs should have the same columns. Should be used between
+// "InitializeDataspecAccumulator" and "FinalizeComputeSpec".
+absl::Status MergeColumnStatistics(
+    const proto::DataSpecification& src_data_spec,
+    const proto::DataSpecificationAccumulator& src_accumulator,
+    proto::DataSpecification* dst_data_spec,
+    proto::DataSpecificationAccumulator* dst_accumulator);
+
 // Update a column spec with a single numerical value. Should be used between
 // "InitializeDataspecAccumulator" and "FinalizeComputeSpec".
 absl::Status UpdateNumericalColumnSpec(
@@ -189,9 +228,12 @@ absl::Status UpdateColSpecsWithGuideInfo(
 
 // Add the tokens to the dictionary of categorical column spec that is
 // currently being assembled. Don't check the size of the dictionary (i.e. the
-// dictionary can grow larger than "max_number_of_unique_values").
+// dictionary can grow larger than "max_number_of_unique_values"). If "col_acc"
+// is set, the dictionary is reduced according to
+// "col_acc->max_num_dictionary_items()".
 absl::Status AddTokensToCategoricalColumnSpec(
-    const std::vector<std::string>& tokens, proto::Column* col);
+    const std::vector<std::string>& tokens, proto::Column* col,
+    proto::DataSpecificationAccumulator::Column* col_acc = nullptr);
 
 // Does this value looks like to be a multi dimensional value?
 absl::StatusOr<bool> LooksMultiDimensional(absl::string_view value,
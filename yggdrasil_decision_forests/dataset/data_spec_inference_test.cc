@@ -28,6 +28,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
@@ -1190,6 +1191,204 @@ TEST(Dataset, InferCatSetCSVWithoutTokenization) {
           )")));
 }
 
+// Splits "adult.csv" into "num_shards" csv files. Returns the typed path of the
+// shards.
+std::string ShardAdultDataset(const int num_shards) {
+  const std::string content =
+      file::GetContent(file::JoinPath(DatasetDir(), "adult.csv")).value();
+  const std::vector<absl::string_view> lines =
+      absl::StrSplit(content, '\n', absl::SkipEmpty());
+  const std::string sharded_path =
+      file::JoinPath(test::TmpDirectory(), absl::StrCat("adult@", num_shards));
+  std::vector<std::string> paths;
+  CHECK_OK(utils::ExpandOutputShards(sharded_path, &paths));
+  const int num_rows = lines.size() - 1;
+  const int num_rows_per_shard = (num_rows + num_shards - 1) / num_shards;
+  for (int shard_idx = 0; shard_idx < num_shards; shard_idx++) {
+    std::string shard = absl::StrCat(lines.front(), "\n");
+    const int end_row_idx =
+        std::min((shard_idx + 1) * num_rows_per_shard, num_rows);
+    for (int row_idx = shard_idx * num_rows_per_shard; row_idx < end_row_idx;
+         row_idx++) {
+      absl::StrAppend(&shard, lines[row_idx + 1], "\n");
+    }
+    CHECK_OK(file::SetContent(paths[shard_idx], shard));
+  }
+  return absl::StrCat("csv:", sharded_path);
+}
+
+TEST(Dataset, CreateDataSpecFromShardsInParallel) {
+  const std::string typed_path = ShardAdultDataset(/*num_shards=*/7);
+  proto::DataSpecificationGuide guide;
+  guide.set_detect_numerical_as_discretized_numerical(true);
+  const auto expected_data_spec = CreateDataSpec(typed_path, guide).value();
+  EXPECT_EQ(expected_data_spec.created_num_rows(), 32561);
+
+  for (const int num_threads : {2, 4, 16}) {
+    guide.set_num_threads(num_threads);
+    EXPECT_THAT(CreateDataSpec(typed_path, guide).value(),
+                EqualsProto(expected_data_spec));
+  }
+
+  // The shard statistics are merged with rounding errors.
+  const auto single_file_data_spec =
+      CreateDataSpec(absl::StrCat("csv:", file::JoinPath(DatasetDir(),
+                                                         "adult.csv")),
+                     guide)
+          .value();
+  EXPECT_THAT(expected_data_spec,
+              ApproximatelyEqualsProto(single_file_data_spec));
+}
+
+TEST(Dataset, CreateDataSpecFromTFExampleShardsInParallel) {
+  proto::DataSpecificationGuide guide = ToyDatasetGuide1();
+  const auto expected_data_spec =
+      CreateDataSpec(ToyDatasetTypedPathTFExampleTFRecord(), guide).value();
+  guide.set_num_threads(2);
+  EXPECT_THAT(
+      CreateDataSpec(ToyDatasetTypedPathTFExampleTFRecord(), guide).value(),
+      EqualsProto(expected_data_spec));
+}
+
+TEST(Dataset, MaxNumDictionaryItemsDuringInference) {
+  const std::string typed_path = ShardAdultDataset(/*num_shards=*/3);
+  proto::DataSpecificationGuide guide;
+  const auto exact_data_spec = CreateDataSpec(typed_path, guide).value();
+
+  guide.set_max_num_dictionary_items_during_inference(20);
+  const auto single_thread_data_spec =
+      CreateDataSpec(typed_path, guide).value();
+  for (const int num_threads : {1, 3}) {
+    guide.set_num_threads(num_threads);
+    const auto data_spec = CreateDataSpec(typed_path, guide).value();
+    EXPECT_THAT(data_spec, EqualsProto(single_thread_data_spec));
+
+    // The dictionaries with less than 20 items are exact.
+    for (const absl::string_view col_name :
+         {"workclass", "education", "occupation"}) {
+      EXPECT_THAT(
+          data_spec.columns(GetColumnIdxFromName(col_name, data_spec)),
+          EqualsProto(exact_data_spec.columns(
+              GetColumnIdxFromName(col_name, exact_data_spec))));
+    }
+
+    // "native_country" has 42 unique values.
+    const auto& exact_col = exact_data_spec.columns(
+        GetColumnIdxFromName("native_country", exact_data_spec));
+    const auto& col =
+        data_spec.columns(GetColumnIdxFromName("native_country", data_spec));
+    EXPECT_LT(col.categorical().number_of_unique_values(),
+              exact_col.categorical().number_of_unique_values());
+    // The counts of the pruned items are attributed to the out-of-dictionary
+    // item.
+    int64_t sum_counts = 0;
+    for (const auto& item : col.categorical().items()) {
+      sum_counts += item.second.count();
+    }
+    EXPECT_EQ(sum_counts, data_spec.created_num_rows() - col.count_nas());
+    // The most frequent item is retained.
+    EXPECT_EQ(CategoricalIdxToRepresentation(col, 1),
+              CategoricalIdxToRepresentation(exact_col, 1));
+
+    // The counts are underestimated by at most "number of values / (N/2+1)".
+    const int64_t max_error =
+        (data_spec.created_num_rows() - col.count_nas()) / (20 / 2 + 1);
+    for (const auto& exact_item : exact_col.categorical().items()) {
+      if (exact_item.first == kOutOfDictionaryItemKey) {
+        continue;
+      }
+      const auto it = col.categorical().items().find(exact_item.first);
+      if (it == col.categorical().items().end()) {
+        // Dropped by the sketch or by "min_vocab_frequency".
+        EXPECT_LE(exact_item.second.count(),
+                  max_error + col.categorical().min_value_count());
+      } else {
+        EXPECT_LE(it->second.count(), exact_item.second.count());
+        EXPECT_GE(it->second.count(), exact_item.second.count() - max_error);
+      }
+    }
+  }
+}
+
+TEST(Dataset, MaxNumDiscretizedNumericalValuesDuringInference) {
+  const std::string typed_path = ShardAdultDataset(/*num_shards=*/3);
+  proto::DataSpecificationGuide guide;
+  guide.set_detect_numerical_as_discretized_numerical(true);
+  const auto exact_data_spec = CreateDataSpec(typed_path, guide).value();
+
+  guide.set_max_num_discretized_numerical_values_during_inference(300);
+  const auto single_thread_data_spec =
+      CreateDataSpec(typed_path, guide).value();
+  for (const int num_threads : {1, 3}) {
+    guide.set_num_threads(num_threads);
+    const auto data_spec = CreateDataSpec(typed_path, guide).value();
+    EXPECT_THAT(data_spec, EqualsProto(single_thread_data_spec));
+
+    // "age" has less than 300 unique values and is exact.
+    EXPECT_THAT(data_spec.columns(GetColumnIdxFromName("age", data_spec)),
+                EqualsProto(exact_data_spec.columns(
+                    GetColumnIdxFromName("age", exact_data_spec))));
+
+    // "fnlwgt" has ~20k unique values and is sketched.
+    const auto& exact_col =
+        exact_data_spec.columns(GetColumnIdxFromName("fnlwgt", exact_data_spec))
+            .discretized_numerical();
+    const auto& col =
+        data_spec.columns(GetColumnIdxFromName("fnlwgt", data_spec))
+            .discretized_numerical();
+    EXPECT_NEAR(col.original_num_unique_values(),
+                exact_col.original_num_unique_values(),
+                0.05 * exact_col.original_num_unique_values());
+    EXPECT_TRUE(
+        std::is_sorted(col.boundaries().begin(), col.boundaries().end()));
+    EXPECT_GT(col.boundaries_size(), exact_col.boundaries_size() / 2);
+    // The boundaries are approximately the quantiles of the values.
+    const float median = exact_col.boundaries(exact_col.boundaries_size() / 2);
+    EXPECT_NEAR(col.boundaries(col.boundaries_size() / 2), median,
+                0.05 * median);
+  }
+}
+
+TEST(Dataset, RowSamplingToAccumulateStatistics) {
+  const std::string typed_path = ShardAdultDataset(/*num_shards=*/3);
+  proto::DataSpecificationGuide guide;
+  const auto exact_data_spec = CreateDataSpec(typed_path, guide).value();
+  const auto& exact_age =
+      exact_data_spec.columns(GetColumnIdxFromName("age", exact_data_spec));
+
+  guide.set_row_sampling_rate_to_accumulate_statistics(0.2f);
+  const auto single_thread_data_spec =
+      CreateDataSpec(typed_path, guide).value();
+  for (const int num_threads : {1, 3}) {
+    guide.set_num_threads(num_threads);
+    const auto data_spec = CreateDataSpec(typed_path, guide).value();
+    EXPECT_THAT(data_spec, EqualsProto(single_thread_data_spec));
+  }
+
+  const auto& data_spec = single_thread_data_spec;
+  EXPECT_NEAR(data_spec.created_num_rows(),
+              0.2 * exact_data_spec.created_num_rows(),
+              0.01 * exact_data_spec.created_num_rows());
+  const auto& age = data_spec.columns(GetColumnIdxFromName("age", data_spec));
+  EXPECT_NEAR(age.numerical().mean(), exact_age.numerical().mean(),
+              0.02 * exact_age.numerical().mean());
+
+  // Another seed selects other rows.
+  guide.set_row_sampling_seed(5678);
+  EXPECT_NE(CreateDataSpec(typed_path, guide).value().created_num_rows(),
+            data_spec.created_num_rows());
+
+  // The single csv file is scanned in parallel by chunks.
+  const std::string single_file_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv"));
+  guide.set_num_threads(1);
+  const auto single_file_data_spec =
+      CreateDataSpec(single_file_path, guide).value();
+  guide.set_num_threads(4);
+  EXPECT_THAT(CreateDataSpec(single_file_path, guide).value(),
+              EqualsProto(single_file_data_spec));
+}
+
 }  // namespace
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
@@ -0,0 +1,204 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/dataset/data_spec_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/utils/hash.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+
+using KllSketch = proto::DataSpecificationAccumulator::KllSketch;
+
+namespace {
+
+// Ratio between the capacities of two consecutive levels.
+constexpr double kKllCapacityDecay = 2. / 3.;
+
+// Capacity of a level. The top level has a capacity of "k", and the capacity
+// of the other levels decreases geometrically.
+int64_t KllLevelCapacity(const KllSketch& sketch, const int level) {
+  const int depth = sketch.levels_size() - 1 - level;
+  return std::max<int64_t>(
+      2, static_cast<int64_t>(
+             std::ceil(sketch.k() * std::pow(kKllCapacityDecay, depth))));
+}
+
+// Compacts the lowest full level until the sketch fits in its capacity.
+// Compacting a level sorts it and moves one value out of two to the next
+// level, where the values have twice the weight.
+void CompressKllSketch(KllSketch* sketch) {
+  while (true) {
+    int64_t size = 0;
+    int64_t capacity = 0;
+    for (int level = 0; level < sketch->levels_size(); level++) {
+      size += sketch->levels(level).values_size();
+      capacity += KllLevelCapacity(*sketch, level);
+    }
+    if (size <= capacity) {
+      return;
+    }
+
+    int level = 0;
+    while (sketch->levels(level).values_size() <
+           KllLevelCapacity(*sketch, level)) {
+      level++;
+    }
+    if (level + 1 == sketch->levels_size()) {
+      sketch->add_levels();
+    }
+    auto* values = sketch->mutable_levels(level)->mutable_values();
+    auto* next_values = sketch->mutable_levels(level + 1)->mutable_values();
+    std::sort(values->begin(), values->end());
+
+    // The kept half is selected with a hash of the compaction index so the
+    // sketch is deterministic.
+    const int offset =
+        utils::hash::HashInt64ToUint64(sketch->num_compactions()) & 1;
+    sketch->set_num_compactions(sketch->num_compactions() + 1);
+    const int num_compacted = values->size() & ~1;
+    for (int i = offset; i < num_compacted; i += 2) {
+      next_values->Add(values->Get(i));
+    }
+    // With an odd number of values, the largest value stays in the level.
+    if (values->size() > num_compacted) {
+      values->Set(0, values->Get(num_compacted));
+      values->Truncate(1);
+    } else {
+      values->Clear();
+    }
+  }
+}
+
+}  // namespace
+
+void InitializeKllSketch(const int k, KllSketch* sketch) {
+  sketch->Clear();
+  sketch->set_k(k);
+  sketch->add_levels();
+}
+
+void AddToKllSketch(const float value, int64_t weight, KllSketch* sketch) {
+  // A value of weight "w" is a value of weight 2^h for each bit h of "w".
+  for (int level = 0; weight > 0; level++, weight >>= 1) {
+    if ((weight & 1) == 0) {
+      continue;
+    }
+    while (sketch->levels_size() <= level) {
+      sketch->add_levels();
+    }
+    sketch->mutable_levels(level)->add_values(value);
+  }
+  CompressKllSketch(sketch);
+}
+
+void MergeKllSketch(const KllSketch& src, KllSketch* dst) {
+  while (dst->levels_size() < src.levels_size()) {
+    dst->add_levels();
+  }
+  for (int level = 0; level < src.levels_size(); level++) {
+    dst->mutable_levels(level)->mutable_values()->MergeFrom(
+        src.levels(level).values());
+  }
+  CompressKllSketch(dst);
+}
+
+std::vector<std::pair<float, int64_t>> KllSketchValuesAndCounts(
+    const KllSketch& sketch) {
+  std::vector<std::pair<float, int64_t>> weighted_values;
+  for (int level = 0; level < sketch.levels_size(); level++) {
+    for (const float value : sketch.levels(level).values()) {
+      weighted_values.emplace_back(value, int64_t{1} << level);
+    }
+  }
+  std::sort(weighted_values.begin(), weighted_values.end());
+
+  // Group the identical values.
+  std::vector<std::pair<float, int64_t>> values_and_counts;
+  for (const auto& weighted_value : weighted_values) {
+    if (!values_and_counts.empty() &&
+        values_and_counts.back().first == weighted_value.first) {
+      values_and_counts.back().second += weighted_value.second;
+    } else {
+      values_and_counts.push_back(weighted_value);
+    }
+  }
+  return values_and_counts;
+}
+
+void AddToCardinalitySketch(const uint64_t hash, std::string* sketch) {
+  constexpr int kNumRegisters = 1 << kCardinalitySketchPrecision;
+  if (sketch->empty()) {
+    sketch->assign(kNumRegisters, 0);
+  }
+  // The first bits select the register, and the register records the maximum
+  // position of the first set bit in the remaining bits.
+  const int register_idx = hash >> (64 - kCardinalitySketchPrecision);
+  const uint64_t remaining_bits = hash << kCardinalitySketchPrecision;
+  const char rank =
+      remaining_bits == 0
+          ? 64 - kCardinalitySketchPrecision + 1
+          : absl::countl_zero(remaining_bits) + 1;
+  (*sketch)[register_idx] = std::max((*sketch)[register_idx], rank);
+}
+
+void MergeCardinalitySketch(const absl::string_view src, std::string* dst) {
+  if (src.empty()) {
+    return;
+  }
+  if (dst->empty()) {
+    dst->assign(src.data(), src.size());
+    return;
+  }
+  for (size_t register_idx = 0; register_idx < src.size(); register_idx++) {
+    (*dst)[register_idx] = std::max((*dst)[register_idx], src[register_idx]);
+  }
+}
+
+int64_t EstimateCardinality(const absl::string_view sketch) {
+  if (sketch.empty()) {
+    return 0;
+  }
+  const double num_registers = sketch.size();
+  double sum_inv_powers = 0;
+  int num_zero_registers = 0;
+  for (const char rank : sketch) {
+    sum_inv_powers += std::ldexp(1., -rank);
+    if (rank == 0) {
+      num_zero_registers++;
+    }
+  }
+  const double alpha = 0.7213 / (1. + 1.079 / num_registers);
+  double estimate = alpha * num_registers * num_registers / sum_inv_powers;
+  if (estimate <= 2.5 * num_registers && num_zero_registers > 0) {
+    // Small range correction (linear counting).
+    estimate =
+        num_registers * std::log(num_registers / num_zero_registers);
+  }
+  return std::llround(estimate);
+}
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Mergeable sketches used to bound the memory of the dataspec inference.
+//
+// The sketches are stored in the "DataSpecificationAccumulator" proto so they
+// can be merged like the other column statistics. All the sketches are
+// deterministic: The same values, inserted and merged in the same order, give
+// the same sketch.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_DATASET_DATA_SPEC_SKETCH_H_
+#define YGGDRASIL_DECISION_FORESTS_DATASET_DATA_SPEC_SKETCH_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+
+// KLL quantile sketch.
+//
+// A sketch of parameter "k" contains less than "3 x k" values. The rank error
+// of a quantile is of the order of "1 / k".
+
+// Creates an empty KLL sketch.
+void InitializeKllSketch(
+    int k, proto::DataSpecificationAccumulator::KllSketch* sketch);
+
+// Adds "weight" times the value "value" to the sketch.
+void AddToKllSketch(float value, int64_t weight,
+                    proto::DataSpecificationAccumulator::KllSketch* sketch);
+
+// Adds the values of "src" to "dst".
+void MergeKllSketch(const proto::DataSpecificationAccumulator::KllSketch& src,
+                    proto::DataSpecificationAccumulator::KllSketch* dst);
+
+// Unique values of the sketch sorted in increasing order, and their
+// approximate number of occurrences.
+std::vector<std::pair<float, int64_t>> KllSketchValuesAndCounts(
+    const proto::DataSpecificationAccumulator::KllSketch& sketch);
+
+// HyperLogLog cardinality sketch (Flajolet et al., "HyperLogLog: the analysis
+// of a near-optimal cardinality estimation algorithm", 2007).
+//
+// The sketch is a string of 2^kCardinalitySketchPrecision registers. The
+// relative standard error of the estimate is "1.04 / 2^(precision/2)" i.e.
+// ~1.6%. An empty string is an empty sketch.
+
+constexpr int kCardinalitySketchPrecision = 12;
+
+// Adds a value, represented by its 64 bits hash, to the sketch.
+void AddToCardinalitySketch(uint64_t hash, std::string* sketch);
+
+// Adds the values of "src" to "dst".
+void MergeCardinalitySketch(absl::string_view src, std::string* dst);
+
+// Estimates the number of unique values in the sketch.
+int64_t EstimateCardinality(absl::string_view sketch);
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_DATASET_DATA_SPEC_SKETCH_H_
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/dataset/data_spec_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/utils/hash.h"
+#include "yggdrasil_decision_forests/utils/random.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+namespace {
+
+using KllSketch = proto::DataSpecificationAccumulator::KllSketch;
+
+int64_t NumSketchValues(const KllSketch& sketch) {
+  int64_t num_values = 0;
+  for (const auto& level : sketch.levels()) {
+    num_values += level.values_size();
+  }
+  return num_values;
+}
+
+// Approximate number of values smaller or equal to "value".
+int64_t SketchRank(const KllSketch& sketch, const float value) {
+  int64_t rank = 0;
+  for (const auto& item : KllSketchValuesAndCounts(sketch)) {
+    if (item.first <= value) {
+      rank += item.second;
+    }
+  }
+  return rank;
+}
+
+TEST(KllSketch, SmallIsExact) {
+  KllSketch sketch;
+  InitializeKllSketch(100, &sketch);
+  AddToKllSketch(2.f, 1, &sketch);
+  AddToKllSketch(1.f, 3, &sketch);
+  AddToKllSketch(2.f, 1, &sketch);
+  EXPECT_THAT(KllSketchValuesAndCounts(sketch),
+              testing::ElementsAre(std::make_pair(1.f, 3),
+                                   std::make_pair(2.f, 2)));
+}
+
+TEST(KllSketch, RankError) {
+  const int k = 200;
+  const int num_values = 100000;
+  KllSketch sketch;
+  InitializeKllSketch(k, &sketch);
+  utils::RandomEngine random(1234);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<float> values;
+  for (int i = 0; i < num_values; i++) {
+    values.push_back(dist(random));
+    AddToKllSketch(values.back(), 1, &sketch);
+  }
+  std::sort(values.begin(), values.end());
+
+  EXPECT_LT(NumSketchValues(sketch), 3 * k);
+  int64_t total_count = 0;
+  for (const auto& item : KllSketchValuesAndCounts(sketch)) {
+    total_count += item.second;
+  }
+  EXPECT_EQ(total_count, num_values);
+
+  for (const float quantile : {0.01f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 0.99f}) {
+    const float value = values[static_cast<int>(quantile * num_values)];
+    const int64_t exact_rank =
+        std::upper_bound(values.begin(), values.end(), value) -
+        values.begin();
+    EXPECT_NEAR(SketchRank(sketch, value), exact_rank, 0.02 * num_values);
+  }
+}
+
+TEST(KllSketch, MergeIsDeterministic) {
+  const auto build = [](const int begin, const int end) {
+    KllSketch sketch;
+    InitializeKllSketch(50, &sketch);
+    for (int i = begin; i < end; i++) {
+      AddToKllSketch(static_cast<float>((i * 7919) % 10000), 1, &sketch);
+    }
+    return sketch;
+  };
+  KllSketch merged_1 = build(0, 5000);
+  MergeKllSketch(build(5000, 10000), &merged_1);
+  KllSketch merged_2 = build(0, 5000);
+  MergeKllSketch(build(5000, 10000), &merged_2);
+  EXPECT_EQ(merged_1.SerializeAsString(), merged_2.SerializeAsString());
+
+  EXPECT_LT(NumSketchValues(merged_1), 3 * 50);
+  EXPECT_NEAR(SketchRank(merged_1, 4999.f), 5000, 0.05 * 10000);
+}
+
+TEST(CardinalitySketch, Estimate) {
+  std::string empty;
+  EXPECT_EQ(EstimateCardinality(empty), 0);
+
+  for (const int num_values : {10, 1000, 100000}) {
+    std::string sketch;
+    for (int repetition = 0; repetition < 3; repetition++) {
+      for (int i = 0; i < num_values; i++) {
+        AddToCardinalitySketch(utils::hash::HashInt64ToUint64(i), &sketch);
+      }
+    }
+    EXPECT_NEAR(EstimateCardinality(sketch), num_values, 0.05 * num_values);
+  }
+}
+
+TEST(CardinalitySketch, Merge) {
+  std::string sketch_1;
+  std::string sketch_2;
+  std::string sketch_all;
+  for (int i = 0; i < 20000; i++) {
+    const uint64_t hash = utils::hash::HashInt64ToUint64(i);
+    AddToCardinalitySketch(hash, i < 12000 ? &sketch_1 : &sketch_2);
+    AddToCardinalitySketch(hash, &sketch_all);
+  }
+  MergeCardinalitySketch(sketch_2, &sketch_1);
+  EXPECT_EQ(sketch_1, sketch_all);
+  EXPECT_NEAR(EstimateCardinality(sketch_1), 20000, 0.05 * 20000);
+}
+
+}  // namespace
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
@@ -27,6 +27,8 @@
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
@@ -402,6 +404,70 @@ TEST(DataSpecUtil, CategoricalIdxsToRepresentation) {
   CHECK_EQ(representation, "b, c, ...[1 left]");
 }
 
+TEST(DataSpecUtil, CategoricalDictionary) {
+  const proto::DataSpecification data_spec = PARSE_TEST_PROTO(
+      R"pb(
+        columns {
+          type: CATEGORICAL
+          name: "a"
+          categorical {
+            number_of_unique_values: 3
+            items {
+              key: "<OOD>"
+              value { index: 0 }
+            }
+            items {
+              key: "x"
+              value { index: 1 }
+            }
+            items {
+              key: "y"
+              value { index: 2 }
+            }
+          }
+        }
+        columns {
+          type: CATEGORICAL_SET
+          name: "b"
+          categorical { number_of_unique_values: 4 is_already_integerized: true }
+        }
+        columns { type: NUMERICAL name: "c" }
+      )pb");
+  const auto dictionaries = BuildCategoricalDictionaries(data_spec);
+  ASSERT_EQ(dictionaries.size(), 3);
+
+  // Same results as the lookups in the dataspec.
+  for (const std::string value : {"x", "y", "z", ""}) {
+    EXPECT_EQ(dictionaries[0].NonintegerizedLookup(value),
+              NonintegerizedCategoricalStringToValue(value,
+                                                     data_spec.columns(0)));
+    EXPECT_EQ(dictionaries[0].Lookup(value).value(),
+              CategoricalStringToValueWithStatus(value, data_spec.columns(0))
+                  .value());
+  }
+  EXPECT_EQ(dictionaries[0].NonintegerizedLookup("y"), 2);
+  EXPECT_EQ(dictionaries[0].NonintegerizedLookup("z"),
+            kOutOfDictionaryItemIndex);
+
+  EXPECT_EQ(dictionaries[1].Lookup("3").value(), 3);
+  EXPECT_THAT(dictionaries[1].Lookup("4").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(dictionaries[1].Lookup("x").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  EXPECT_EQ(dictionaries[2].NonintegerizedLookup("x"),
+            kOutOfDictionaryItemIndex);
+
+  const std::vector<absl::string_view> values = {"y", "x", "z", "y"};
+  std::vector<int32_t> int_values(values.size());
+  ASSERT_OK(dictionaries[0].LookupBatch(values, absl::MakeSpan(int_values)));
+  EXPECT_THAT(int_values, ElementsAre(2, 1, 0, 2));
+
+  EXPECT_THAT(dictionaries[1].LookupBatch(
+                  {"1", "5"}, absl::MakeSpan(int_values).subspan(0, 2)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(DataSpecUtil, AddColumn) {
   proto::DataSpecification data_spec;
   AddColumn("a", proto::ColumnType::NUMERICAL, &data_spec);
@@ -24,17 +24,63 @@
 
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
+#include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/columnar_reader_interface.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
 #include "yggdrasil_decision_forests/dataset/formats.h"
 #include "yggdrasil_decision_forests/dataset/formats.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
 namespace dataset {
 
+namespace {
+
+// Columnar reader for the formats without a native columnar reader. The
+// examples are read as "proto::Example" and then copied in the columns.
+class ExampleToColumnarReader final : public ColumnarReaderInterface {
+ public:
+  explicit ExampleToColumnarReader(
+      std::unique_ptr<ExampleReaderInterface> reader)
+      : reader_(std::move(reader)) {}
+
+  absl::Status Open(
+      const absl::string_view sharded_path,
+      const std::optional<std::vector<int>>& load_columns) override {
+    load_columns_ = load_columns;
+    return reader_->Open(sharded_path);
+  }
+
+  absl::StatusOr<VerticalDataset::row_t> NextBatch(
+      const VerticalDataset::row_t max_num_examples,
+      VerticalDataset* dataset) override {
+    VerticalDataset::row_t num_examples = 0;
+    while (num_examples < max_num_examples) {
+      ASSIGN_OR_RETURN(const bool has_example, reader_->Next(&example_));
+      if (!has_example) {
+        break;
+      }
+      RETURN_IF_ERROR(
+          dataset->AppendExampleWithStatus(example_, load_columns_));
+      num_examples++;
+    }
+    return num_examples;
+  }
+
+ private:
+  std::unique_ptr<ExampleReaderInterface> reader_;
+  std::optional<std::vector<int>> load_columns_;
+  // Buffer re-used for each example.
+  proto::Example example_;
+};
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<ExampleReaderInterface>> CreateExampleReader(
     const absl::string_view typed_path,
     const proto::DataSpecification& data_spec,
@@ -55,6 +101,38 @@ absl::StatusOr<std::unique_ptr<ExampleReaderInterface>> CreateExampleReader(
   return std::move(reader);
 }
 
+absl::StatusOr<std::unique_ptr<ColumnarReaderInterface>> CreateColumnarReader(
+    const absl::string_view typed_path,
+    const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns) {
+  std::string sharded_path;
+  proto::DatasetFormat format;
+  ASSIGN_OR_RETURN(std::tie(sharded_path, format),
+                   GetDatasetPathAndTypeOrStatus(typed_path));
+
+  const std::string& format_name = proto::DatasetFormat_Name(format);
+  std::unique_ptr<ColumnarReaderInterface> reader;
+  if (ColumnarReaderInterfaceRegisterer::IsName(format_name)) {
+    ASSIGN_OR_RETURN(reader,
+                     ColumnarReaderInterfaceRegisterer::Create(
+                         format_name, data_spec, required_columns),
+                     _ << "When creating a columnar reader to read "
+                       << sharded_path);
+  } else {
+    ASSIGN_OR_RETURN(auto example_reader,
+                     ExampleReaderInterfaceRegisterer::Create(
+                         format_name, data_spec, required_columns),
+                     _ << "When creating an example reader to read "
+                       << sharded_path
+                       << ". Make sure the format dependency is linked");
+    reader = std::make_unique<ExampleToColumnarReader>(
+        std::move(example_reader));
+  }
+  RETURN_IF_ERROR(reader->Open(sharded_path, load_columns));
+  return std::move(reader);
+}
+
 absl::StatusOr<bool> IsFormatSupported(absl::string_view typed_path) {
   const auto path_format_or = GetDatasetPathAndTypeOrStatus(typed_path);
   if (!path_format_or.ok()) {
@@ -20,6 +20,8 @@
 //
 // Supported readers are:
 //   - CreateExampleReader: Sequential "in-order" local reading.
+//   - CreateColumnarReader: Sequential "in-order" local reading directly into
+//       the columns of a VerticalDataset.
 //
 //
 // See proto::DatasetFormat for a list of supported dataset format.
@@ -43,6 +45,7 @@
 
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/columnar_reader_interface.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
 
@@ -66,6 +69,19 @@ absl::StatusOr<std::unique_ptr<ExampleReaderInterface>> CreateExampleReader(
     absl::string_view typed_path, const proto::DataSpecification& data_spec,
     const std::optional<std::vector<int>>& required_columns = {});
 
+// Creates a stream reader of examples into the columns of a VerticalDataset.
+// "required_columns" has the same semantic as for "CreateExampleReader". If
+// "load_columns" is set, only the columns in "load_columns" are populated.
+//
+// Formats with a registered "ColumnarReaderInterface" (e.g. csv) are parsed
+// directly into the columns. Other formats are read with the
+// "ExampleReaderInterface" of the format, and the examples are then copied in
+// the columns.
+absl::StatusOr<std::unique_ptr<ColumnarReaderInterface>> CreateColumnarReader(
+    absl::string_view typed_path, const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns = {},
+    const std::optional<std::vector<int>>& load_columns = {});
+
 // Checks if the format of a typed dataset is supported i.e. a dataset reader is
 // registered for this format. Returns true, if the format is supported. Returns
 // false if the format is not supported. Returns an error if the typed path
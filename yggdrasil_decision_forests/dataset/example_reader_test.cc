@@ -16,18 +16,22 @@
 #include "yggdrasil_decision_forests/dataset/example_reader.h"
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "yggdrasil_decision_forests/dataset/columnar_reader_interface.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/test.h"
@@ -88,6 +92,60 @@ TEST(ExampleReader, CreateExampleReader) {
   }
 }
 
+TEST(ExampleReader, CreateColumnarReader) {
+  for (const auto& dataset_path : {
+           absl::StrCat("tfrecord:",
+                        file::JoinPath(DatasetDir(), "toy.tfe-tfrecord@2")),
+           absl::StrCat("csv:", file::JoinPath(DatasetDir(), "toy.csv")),
+           absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv")),
+       }) {
+    LOG(INFO) << "Create dataspec for " << dataset_path;
+    proto::DataSpecificationGuide guide;
+    proto::DataSpecification data_spec;
+    CreateDataSpec(dataset_path, false, guide, &data_spec);
+
+    // Expected dataset, read with the example reader.
+    VerticalDataset expected_dataset;
+    expected_dataset.set_data_spec(data_spec);
+    ASSERT_OK(expected_dataset.CreateColumnsFromDataspec());
+    auto example_reader = CreateExampleReader(dataset_path, data_spec).value();
+    proto::Example example;
+    while (example_reader->Next(&example).value()) {
+      ASSERT_OK(expected_dataset.AppendExampleWithStatus(example));
+    }
+
+    // Reads all the columns, and then only the first and last columns.
+    const std::vector<std::optional<std::vector<int>>> all_load_columns = {
+        std::nullopt, std::vector<int>{0, data_spec.columns_size() - 1}};
+    for (const auto& load_columns : all_load_columns) {
+      VerticalDataset dataset;
+      dataset.set_data_spec(data_spec);
+      ASSERT_OK(dataset.CreateColumnsFromDataspec());
+      auto reader =
+          CreateColumnarReader(dataset_path, data_spec, {}, load_columns)
+              .value();
+      while (reader->NextBatch(/*max_num_examples=*/3, &dataset).value() > 0) {
+      }
+      ASSERT_EQ(dataset.nrow(), expected_dataset.nrow());
+
+      std::vector<int> checked_columns;
+      if (load_columns.has_value()) {
+        checked_columns = load_columns.value();
+      } else {
+        for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
+          checked_columns.push_back(col_idx);
+        }
+      }
+      for (int example_idx = 0; example_idx < dataset.nrow(); example_idx++) {
+        for (const int col_idx : checked_columns) {
+          EXPECT_EQ(dataset.ValueToString(example_idx, col_idx),
+                    expected_dataset.ValueToString(example_idx, col_idx));
+        }
+      }
+    }
+  }
+}
+
 TEST(ExampleReader, IsFormatSupported) {
   EXPECT_TRUE(IsFormatSupported("csv:/path/to/ds").value());
   EXPECT_TRUE(IsFormatSupported("avro:/path/to/ds").value());
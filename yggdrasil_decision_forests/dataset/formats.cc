@@ -82,10 +82,17 @@ const std::vector<Format>& GetFormats() {
 
     formats->push_back({
         .extension = "avro",
-        .prefix = "avro",
+        .prefix = FORMAT_AVRO,
         .proto_format = proto::FORMAT_AVRO,
     });
 
+    // Native columnar binary format. See dataset/columnar_file.h.
+    formats->push_back({
+        .extension = "ydfc",
+        .prefix = FORMAT_YDF_COLUMNAR,
+        .proto_format = proto::FORMAT_YDF_COLUMNAR,
+    });
+
     // Partially computed (e.g. non indexed) dataset cache.
     formats->push_back({
         .extension = "partial_dataset_cache",
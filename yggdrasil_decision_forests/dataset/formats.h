@@ -36,6 +36,8 @@ const char* const FORMAT_CSV = "csv";
 const char* const FORMAT_TFE_TFRECORD = "tfrecord+tfe";
 const char* const FORMAT_TFE_TFRECORDV2 = "tfrecordv2+tfe";
 const char* const FORMAT_PARTIAL_DATASET_CACHE = "partial_dataset_cache";
+const char* const FORMAT_YDF_COLUMNAR = "ydfc";
+const char* const FORMAT_AVRO = "avro";
 
 // Splits the format and path from a typed path.
 std::pair<std::string, proto::DatasetFormat> GetDatasetPathAndType(
@@ -39,11 +39,28 @@ namespace yggdrasil_decision_forests {
 namespace dataset {
 namespace {
 using proto::ColumnType;
-}  // namespace
 
-absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
-                                   const proto::DataSpecification& data_spec,
-                                   proto::Example* example) {
+// Implementation of "TfExampleToYdfExample". If "categorical_dictionaries" is
+// null, the categorical values are looked up in the dataspec directly.
+absl::Status TfExampleToYdfExampleImpl(
+    const tensorflow::Example& tf_example,
+    const proto::DataSpecification& data_spec,
+    const std::vector<CategoricalDictionary>* categorical_dictionaries,
+    proto::Example* example) {
+  if (categorical_dictionaries) {
+    STATUS_CHECK_EQ(categorical_dictionaries->size(),
+                    data_spec.columns_size());
+  }
+  const auto categorical_string_to_value =
+      [&](const std::string& value,
+          const int col_idx) -> absl::StatusOr<int32_t> {
+    if (categorical_dictionaries) {
+      return (*categorical_dictionaries)[col_idx].Lookup(value);
+    }
+    return CategoricalStringToValueWithStatus(value,
+                                              data_spec.columns(col_idx));
+  };
+
   example->mutable_attributes()->Clear();
   example->mutable_attributes()->Reserve(data_spec.columns_size());
   for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
@@ -183,8 +200,8 @@ absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
         if (tokens.empty()) {
           // NA.
         } else if (tokens.size() == 1) {
-          ASSIGN_OR_RETURN(auto value, CategoricalStringToValueWithStatus(
-                                           tokens[0], col_spec));
+          ASSIGN_OR_RETURN(auto value,
+                           categorical_string_to_value(tokens[0], col_idx));
           dst_value->set_categorical(value);
         } else {
           return absl::InvalidArgumentError(absl::StrFormat(
@@ -208,7 +225,7 @@ absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
         dst->Reserve(tokens.size());
         for (const std::string& token : tokens) {
           ASSIGN_OR_RETURN(auto value,
-                           CategoricalStringToValueWithStatus(token, col_spec));
+                           categorical_string_to_value(token, col_idx));
           dst->Add(value);
         }
         if (col_spec.type() == ColumnType::CATEGORICAL_SET) {
@@ -262,6 +279,25 @@ absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
   return absl::OkStatus();
 }
 
+}  // namespace
+
+absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
+                                   const proto::DataSpecification& data_spec,
+                                   proto::Example* example) {
+  return TfExampleToYdfExampleImpl(tf_example, data_spec,
+                                   /*categorical_dictionaries=*/nullptr,
+                                   example);
+}
+
+absl::Status TfExampleToYdfExample(
+    const tensorflow::Example& tf_example,
+    const proto::DataSpecification& data_spec,
+    const std::vector<CategoricalDictionary>& categorical_dictionaries,
+    proto::Example* example) {
+  return TfExampleToYdfExampleImpl(tf_example, data_spec,
+                                   &categorical_dictionaries, example);
+}
+
 absl::Status YdfExampleToTfExample(const proto::Example& example,
                                    const proto::DataSpecification& data_spec,
                                    tensorflow::Example* tf_example) {
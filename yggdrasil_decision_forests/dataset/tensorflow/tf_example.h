@@ -20,6 +20,7 @@
 #include <vector>
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/tensorflow_no_dep/tf_example.h"
@@ -33,6 +34,14 @@ absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
                                    const proto::DataSpecification& data_spec,
                                    proto::Example* example);
 
+// Same as above, but with the categorical dictionaries of the dataspec
+// compiled beforehand (see "BuildCategoricalDictionaries").
+absl::Status TfExampleToYdfExample(
+    const tensorflow::Example& tf_example,
+    const proto::DataSpecification& data_spec,
+    const std::vector<CategoricalDictionary>& categorical_dictionaries,
+    proto::Example* example);
+
 // Converts a proto::Example into a tensorflow::Example.
 absl::Status YdfExampleToTfExample(const proto::Example& example,
                                    const proto::DataSpecification& data_spec,
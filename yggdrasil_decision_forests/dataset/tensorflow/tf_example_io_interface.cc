@@ -235,7 +235,7 @@ absl::Status UpdateDataSpecWithTFExampleBase(
         col->set_count_nas(col->count_nas() + 1);
         continue;
       }
-      RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(tokens, col));
+      RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec(tokens, col, col_acc));
     }
 
     if (col->type() == ColumnType::DISCRETIZED_NUMERICAL) {
@@ -271,7 +271,9 @@ absl::Status UpdateDataSpecWithTFExample(
 TFExampleReaderToExampleReader::TFExampleReaderToExampleReader(
     const proto::DataSpecification& data_spec,
     const std::optional<std::vector<int>> ensure_non_missing)
-    : data_spec_(data_spec), ensure_non_missing_(ensure_non_missing) {}
+    : data_spec_(data_spec),
+      categorical_dictionaries_(BuildCategoricalDictionaries(data_spec_)),
+      ensure_non_missing_(ensure_non_missing) {}
 
 absl::Status TFExampleReaderToExampleReader::Open(
     absl::string_view sharded_path) {
@@ -286,8 +288,8 @@ absl::StatusOr<bool> TFExampleReaderToExampleReader::Next(
   if (!did_read) {
     return false;
   }
-  RETURN_IF_ERROR(
-      TfExampleToYdfExample(tfexample_buffer_, data_spec_, example));
+  RETURN_IF_ERROR(TfExampleToYdfExample(
+      tfexample_buffer_, data_spec_, categorical_dictionaries_, example));
   return true;
 }
 
@@ -404,7 +406,9 @@ absl::Status TFExampleReaderToDataSpecCreator::ComputeColumnStatistics(
     proto::DataSpecificationAccumulator* accumulator) {
   auto reader = CreateReader();
   RETURN_IF_ERROR(reader->Open(paths));
+  StatisticsRowSampler sampler(guide, paths.front());
   uint64_t nrow = 0;
+  uint64_t num_selected_rows = 0;
   tensorflow::Example example;
   while (reader->Next(&example).value()) {
     if (guide.max_num_scanned_rows_to_accumulate_statistics() > 0 &&
@@ -412,11 +416,14 @@ absl::Status TFExampleReaderToDataSpecCreator::ComputeColumnStatistics(
       break;
     }
     LOG_EVERY_N_SEC(INFO, 30) << nrow << " row(s) processed";
-    RETURN_IF_ERROR(
-        UpdateDataSpecWithTFExample(example, data_spec, accumulator));
+    if (sampler.SelectNextRow()) {
+      RETURN_IF_ERROR(
+          UpdateDataSpecWithTFExample(example, data_spec, accumulator));
+      num_selected_rows++;
+    }
     nrow++;
   }
-  data_spec->set_created_num_rows(nrow);
+  data_spec->set_created_num_rows(num_selected_rows);
   return absl::OkStatus();
 }
 
@@ -49,6 +49,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
@@ -106,6 +107,8 @@ class TFExampleReaderToExampleReader : public ExampleReaderInterface {
   std::unique_ptr<AbstractTFExampleReader> tf_reader_;
   tensorflow::Example tfexample_buffer_;
   const proto::DataSpecification data_spec_;
+  // Compiled categorical dictionaries of "data_spec_".
+  const std::vector<CategoricalDictionary> categorical_dictionaries_;
   const std::optional<std::vector<int>> ensure_non_missing_;
 };
 
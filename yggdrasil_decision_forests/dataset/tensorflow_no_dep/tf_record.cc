@@ -80,13 +80,15 @@ TFRecordReader::~TFRecordReader() {
 }
 
 absl::StatusOr<std::unique_ptr<TFRecordReader>> TFRecordReader::Create(
-    const absl::string_view path, bool compressed) {
+    const absl::string_view path, bool compressed, const int num_threads) {
   auto reader = std::make_unique<TFRecordReader>();
 
   ASSIGN_OR_RETURN(reader->raw_stream_, file::OpenInputFile(path));
   if (compressed) {
-    ASSIGN_OR_RETURN(reader->zlib_stream_, utils::GZipInputByteStream::Create(
-                                               reader->raw_stream_.get()));
+    ASSIGN_OR_RETURN(reader->zlib_stream_,
+                     utils::GZipInputByteStream::Create(
+                         reader->raw_stream_.get(),
+                         /*buffer_size=*/1024 * 1024, num_threads));
   }
   return reader;
 }
@@ -142,12 +144,15 @@ absl::Status TFRecordReader::Close() {
 }
 
 absl::StatusOr<std::unique_ptr<TFRecordWriter>> TFRecordWriter::Create(
-    absl::string_view path, bool compressed) {
+    absl::string_view path, bool compressed, const size_t gzip_member_size) {
   auto writer = std::make_unique<TFRecordWriter>();
   ASSIGN_OR_RETURN(writer->raw_stream_, file::OpenOutputFile(path));
   if (compressed) {
-    ASSIGN_OR_RETURN(writer->zlib_stream_, utils::GZipOutputByteStream::Create(
-                                               writer->raw_stream_.get()));
+    ASSIGN_OR_RETURN(writer->zlib_stream_,
+                     utils::GZipOutputByteStream::Create(
+                         writer->raw_stream_.get(), Z_DEFAULT_COMPRESSION,
+                         /*buffer_size=*/1024 * 1024, /*raw_deflate=*/false,
+                         gzip_member_size));
   }
   return writer;
 }
@@ -36,9 +36,11 @@ namespace yggdrasil_decision_forests::dataset::tensorflow_no_dep {
 // Currently, only supports non-compressed TFRecords.
 class TFRecordReader {
  public:
-  // Opens a TFRecord for reading.
+  // Opens a TFRecord for reading. If the TFRecord is compressed with indexed
+  // gzip members (see "TFRecordWriter::Create"), the members are decompressed
+  // with "num_threads" threads.
   static absl::StatusOr<std::unique_ptr<TFRecordReader>> Create(
-      absl::string_view path, bool compressed = false);
+      absl::string_view path, bool compressed = false, int num_threads = 1);
 
   ~TFRecordReader();
 
@@ -96,9 +98,13 @@ class ShardedCompressedTFRecordReader : public ShardedTFRecordReader<T> {
 // Currently, only supports non-compressed TFRecords.
 class TFRecordWriter {
  public:
-  // Opens a TFRecord for reading.
+  // Opens a TFRecord for reading. If "compressed" and "gzip_member_size" is
+  // non-zero, the TFRecord is compressed in indexed gzip members of
+  // "gzip_member_size" bytes that can be decompressed in parallel (see
+  // "utils::GZipOutputByteStream::Create").
   static absl::StatusOr<std::unique_ptr<TFRecordWriter>> Create(
-      absl::string_view path, bool compressed = false);
+      absl::string_view path, bool compressed = false,
+      size_t gzip_member_size = 0);
 
   ~TFRecordWriter();
 
@@ -18,10 +18,12 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -165,6 +167,35 @@ absl::Status VerticalDataset::AppendExampleWithStatus(
   return absl::OkStatus();
 }
 
+absl::Status VerticalDataset::AppendDataset(
+    const VerticalDataset& src,
+    const std::optional<std::vector<int>>& load_columns) {
+  std::vector<row_t> indices(src.nrow());
+  std::iota(indices.begin(), indices.end(), 0);
+  return AppendDataset(src, indices, load_columns);
+}
+
+absl::Status VerticalDataset::AppendDataset(
+    const VerticalDataset& src, const absl::Span<const row_t> indices,
+    const std::optional<std::vector<int>>& load_columns) {
+  STATUS_CHECK_EQ(columns_.size(), src.columns_.size());
+  const auto append_column = [&](const int col_idx) -> absl::Status {
+    return src.column(col_idx)->ExtractAndAppend(indices,
+                                                 mutable_column(col_idx));
+  };
+  if (load_columns.has_value()) {
+    for (int col_idx : load_columns.value()) {
+      RETURN_IF_ERROR(append_column(col_idx));
+    }
+  } else {
+    for (int col_idx = 0; col_idx < columns_.size(); col_idx++) {
+      RETURN_IF_ERROR(append_column(col_idx));
+    }
+  }
+  nrow_ += indices.size();
+  return absl::OkStatus();
+}
+
 void VerticalDataset::ExtractExample(const row_t example_idx,
                                      proto::Example* example) const {
   DCHECK_GE(example_idx, 0);
@@ -297,7 +328,9 @@ absl::Status VerticalDataset::BooleanColumn::ConvertToGivenDataspec(
     AbstractColumn* dst, const proto::Column& src_spec,
     const proto::Column& dst_spec) const {
   auto* cast_dst = dst->MutableCast<BooleanColumn>();
-  *cast_dst->mutable_values() = values();
+  cast_dst->num_rows_ = num_rows_;
+  cast_dst->true_bits_ = true_bits_;
+  cast_dst->na_bits_ = na_bits_;
   return absl::OkStatus();
 }
 
@@ -323,7 +356,8 @@ absl::Status VerticalDataset::StringColumn::ConvertToGivenDataspec(
     AbstractColumn* dst, const proto::Column& src_spec,
     const proto::Column& dst_spec) const {
   auto* cast_dst = dst->MutableCast<StringColumn>();
-  *cast_dst->mutable_values() = values();
+  cast_dst->mutable_values() = values();
+  cast_dst->mutable_bank() = bank();
   return absl::OkStatus();
 }
 
@@ -333,18 +367,21 @@ absl::Status VerticalDataset::CategoricalColumn::ConvertToGivenDataspec(
   auto* cast_dst = dst->MutableCast<CategoricalColumn>();
   RETURN_IF_ERROR(CheckCompatibleCategocialColumnSpec(src_spec, dst_spec));
   if (src_spec.categorical().is_already_integerized()) {
-    *cast_dst->mutable_values() = values();
+    cast_dst->storage_type_ = storage_type_;
+    cast_dst->uint8_values_ = uint8_values_;
+    cast_dst->uint16_values_ = uint16_values_;
+    cast_dst->int32_values_ = int32_values_;
   } else {
-    for (row_t example_idx = 0; example_idx < values().size(); example_idx++) {
+    const CategoricalDictionary dst_dictionary(dst_spec);
+    for (row_t example_idx = 0; example_idx < nrows(); example_idx++) {
       if (IsNa(example_idx)) {
         cast_dst->AddNA();
         continue;
       }
-      const int src_value_idx = values()[example_idx];
+      const int src_value_idx = value(example_idx);
       const std::string value =
           CategoricalIdxToRepresentation(src_spec, src_value_idx, false);
-      ASSIGN_OR_RETURN(const int dst_value_idx,
-                       CategoricalStringToValueWithStatus(value, dst_spec));
+      ASSIGN_OR_RETURN(const int dst_value_idx, dst_dictionary.Lookup(value));
       cast_dst->Add(dst_value_idx);
     }
   }
@@ -369,12 +406,12 @@ absl::Status VerticalDataset::CategoricalSetColumn::ConvertToGivenDataspec(
   if (src_spec.categorical().is_already_integerized()) {
     cast_dst->mutable_bank() = bank();
   } else {
+    const CategoricalDictionary dst_dictionary(dst_spec);
     for (row_t bank_idx = 0; bank_idx < bank().size(); bank_idx++) {
       const int src_value_idx = bank()[bank_idx];
       const std::string value =
           CategoricalIdxToRepresentation(src_spec, src_value_idx, false);
-      ASSIGN_OR_RETURN(const int dst_value_idx,
-                       CategoricalStringToValueWithStatus(value, dst_spec));
+      ASSIGN_OR_RETURN(const int dst_value_idx, dst_dictionary.Lookup(value));
       cast_dst->mutable_bank().push_back(dst_value_idx);
     }
   }
@@ -389,12 +426,12 @@ absl::Status VerticalDataset::CategoricalListColumn::ConvertToGivenDataspec(
   if (src_spec.categorical().is_already_integerized()) {
     cast_dst->mutable_bank() = bank();
   } else {
+    const CategoricalDictionary dst_dictionary(dst_spec);
     for (row_t bank_idx = 0; bank_idx < bank().size(); bank_idx++) {
       const int src_value_idx = bank()[bank_idx];
       const std::string value =
           CategoricalIdxToRepresentation(src_spec, src_value_idx, false);
-      ASSIGN_OR_RETURN(const int dst_value_idx,
-                       CategoricalStringToValueWithStatus(value, dst_spec));
+      ASSIGN_OR_RETURN(const int dst_value_idx, dst_dictionary.Lookup(value));
       cast_dst->mutable_bank().push_back(dst_value_idx);
     }
   }
@@ -422,7 +459,7 @@ void VerticalDataset::BooleanColumn::ExtractExample(
   if (IsNa(example_idx)) {
     return;
   }
-  attribute->set_boolean(values()[example_idx] == kTrueValue);
+  attribute->set_boolean(IsTrue(example_idx));
 }
 
 void VerticalDataset::CategoricalColumn::ExtractExample(
@@ -430,7 +467,7 @@ void VerticalDataset::CategoricalColumn::ExtractExample(
   if (IsNa(example_idx)) {
     return;
   }
-  attribute->set_categorical(values()[example_idx]);
+  attribute->set_categorical(value(example_idx));
 }
 
 void VerticalDataset::DiscretizedNumericalColumn::ExtractExample(
@@ -486,7 +523,7 @@ void VerticalDataset::StringColumn::ExtractExample(
   if (IsNa(example_idx)) {
     return;
   }
-  attribute->set_text(values()[example_idx]);
+  attribute->set_text(std::string(value(example_idx)));
 }
 
 void VerticalDataset::NumericalColumn::AddFromExample(
@@ -518,7 +555,7 @@ void VerticalDataset::BooleanColumn::AddFromExample(
   } else {
     DCHECK_EQ(attribute.type_case(),
               proto::Example::Attribute::TypeCase::kBoolean);
-    Add(attribute.boolean());
+    Add(attribute.boolean() ? kTrueValue : kFalseValue);
   }
 }
 
@@ -636,27 +673,283 @@ void VerticalDataset::HashColumn::Set(
 void VerticalDataset::BooleanColumn::Set(
     row_t example_idx, const proto::Example::Attribute& attribute) {
   if (dataset::IsNa(attribute)) {
-    (*mutable_values())[example_idx] = kNaValue;
+    Set(example_idx, kNaValue);
   } else {
     DCHECK_EQ(attribute.type_case(),
               proto::Example::Attribute::TypeCase::kBoolean);
-    (*mutable_values())[example_idx] = attribute.boolean();
+    Set(example_idx, attribute.boolean() ? kTrueValue : kFalseValue);
   }
 }
 
 void VerticalDataset::CategoricalColumn::Set(
     row_t example_idx, const proto::Example::Attribute& attribute) {
   if (dataset::IsNa(attribute)) {
-    (*mutable_values())[example_idx] = kNaValue;
+    Set(example_idx, kNaValue);
   } else {
     DCHECK_EQ(attribute.type_case(),
               proto::Example::Attribute::TypeCase::kCategorical);
-    (*mutable_values())[example_idx] = attribute.categorical();
+    Set(example_idx, attribute.categorical());
   }
 }
 
-void VerticalDataset::CategoricalColumn::Set(row_t example_idx, int32_t value) {
-  (*mutable_values())[example_idx] = value;
+void VerticalDataset::BooleanColumn::Add(const int8_t value) {
+  if (num_rows_ / 64 == true_bits_.size()) {
+    true_bits_.push_back(0);
+    na_bits_.push_back(0);
+  }
+  num_rows_++;
+  Set(num_rows_ - 1, value);
+}
+
+void VerticalDataset::BooleanColumn::Set(const row_t example_idx,
+                                         const int8_t value) {
+  DCHECK(value == kTrueValue || value == kFalseValue || value == kNaValue);
+  DCHECK_LT(example_idx, num_rows_);
+  SetBit(example_idx, value == kTrueValue, &true_bits_);
+  SetBit(example_idx, value == kNaValue, &na_bits_);
+}
+
+void VerticalDataset::BooleanColumn::Resize(const row_t num_rows) {
+  const row_t previous_num_rows = num_rows_;
+  const size_t num_words = (num_rows + 63) / 64;
+  true_bits_.resize(num_words, 0);
+  na_bits_.resize(num_words, 0);
+  num_rows_ = num_rows;
+  for (row_t row = previous_num_rows; row < num_rows; row++) {
+    Set(row, kNaValue);
+  }
+}
+
+void VerticalDataset::BooleanColumn::Reserve(const row_t row) {
+  true_bits_.reserve((row + 63) / 64);
+  na_bits_.reserve((row + 63) / 64);
+}
+
+template <typename T>
+absl::Status VerticalDataset::BooleanColumn::ExtractAndAppendTemplate(
+    const absl::Span<const T> indices, AbstractColumn* dst) const {
+  auto* cast_dst = dynamic_cast<BooleanColumn*>(dst);
+  STATUS_CHECK(cast_dst != nullptr);
+  if (num_rows_ == 0 && !indices.empty()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Trying to extract ", indices.size(),
+        " examples from the non-allocated column \"", name(), "\"."));
+  }
+  const row_t init_dst_nrows = cast_dst->nrows();
+  cast_dst->Resize(init_dst_nrows + indices.size());
+  for (size_t new_idx = 0; new_idx < indices.size(); new_idx++) {
+    DCHECK_LT(indices[new_idx], num_rows_);
+    cast_dst->Set(init_dst_nrows + new_idx, value(indices[new_idx]));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerticalDataset::BooleanColumn::ExtractAndAppend(
+    const absl::Span<const row_t> indices, AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+absl::Status VerticalDataset::BooleanColumn::ExtractAndAppend(
+    const absl::Span<const UnsignedExampleIdx> indices,
+    AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+VerticalDataset::CategoricalColumn::StorageType
+VerticalDataset::CategoricalColumn::StorageTypeForDictionary(
+    const int64_t number_of_unique_values) {
+  // The maximum value of the unsigned types is reserved for missing values.
+  if (number_of_unique_values <= std::numeric_limits<uint8_t>::max()) {
+    return StorageType::kUInt8;
+  }
+  if (number_of_unique_values <= std::numeric_limits<uint16_t>::max()) {
+    return StorageType::kUInt16;
+  }
+  return StorageType::kInt32;
+}
+
+bool VerticalDataset::CategoricalColumn::Fits(const int32_t value) const {
+  DCHECK_GE(value, kNaValue);
+  switch (storage_type_) {
+    case StorageType::kUInt8:
+      return value < std::numeric_limits<uint8_t>::max();
+    case StorageType::kUInt16:
+      return value < std::numeric_limits<uint16_t>::max();
+    case StorageType::kInt32:
+      return true;
+  }
+  return true;
+}
+
+absl::Status VerticalDataset::CategoricalColumn::SetStorageType(
+    const StorageType storage_type) {
+  if (storage_type == storage_type_) {
+    return absl::OkStatus();
+  }
+  const Values src_values = values();
+  const StorageType src_storage_type = storage_type_;
+  storage_type_ = storage_type;
+  for (size_t row = 0; row < src_values.size(); row++) {
+    if (!Fits(src_values[row])) {
+      storage_type_ = src_storage_type;
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The value ", src_values[row], " of column \"", name(),
+          "\" does not fit in the requested storage type"));
+    }
+  }
+
+  const auto encode = [&src_values](auto* dst_values) {
+    using T = typename std::remove_pointer_t<
+        decltype(dst_values)>::value_type;
+    dst_values->resize(src_values.size());
+    for (size_t row = 0; row < src_values.size(); row++) {
+      (*dst_values)[row] = Encode<T>(src_values[row]);
+    }
+  };
+  switch (storage_type_) {
+    case StorageType::kUInt8:
+      encode(&uint8_values_);
+      break;
+    case StorageType::kUInt16:
+      encode(&uint16_values_);
+      break;
+    case StorageType::kInt32:
+      encode(&int32_values_);
+      break;
+  }
+
+  // Release the previous storage.
+  switch (src_storage_type) {
+    case StorageType::kUInt8:
+      std::vector<uint8_t>().swap(uint8_values_);
+      break;
+    case StorageType::kUInt16:
+      std::vector<uint16_t>().swap(uint16_values_);
+      break;
+    case StorageType::kInt32:
+      std::vector<int32_t>().swap(int32_values_);
+      break;
+  }
+  return absl::OkStatus();
+}
+
+void VerticalDataset::CategoricalColumn::Add(const int32_t value) {
+  if (ABSL_PREDICT_FALSE(!Fits(value))) {
+    CHECK_OK(SetStorageType(StorageType::kInt32));
+  }
+  switch (storage_type_) {
+    case StorageType::kUInt8:
+      uint8_values_.push_back(Encode<uint8_t>(value));
+      break;
+    case StorageType::kUInt16:
+      uint16_values_.push_back(Encode<uint16_t>(value));
+      break;
+    case StorageType::kInt32:
+      int32_values_.push_back(value);
+      break;
+  }
+}
+
+void VerticalDataset::CategoricalColumn::Set(const row_t example_idx,
+                                             const int32_t value) {
+  if (ABSL_PREDICT_FALSE(!Fits(value))) {
+    CHECK_OK(SetStorageType(StorageType::kInt32));
+  }
+  switch (storage_type_) {
+    case StorageType::kUInt8:
+      uint8_values_[example_idx] = Encode<uint8_t>(value);
+      break;
+    case StorageType::kUInt16:
+      uint16_values_[example_idx] = Encode<uint16_t>(value);
+      break;
+    case StorageType::kInt32:
+      int32_values_[example_idx] = value;
+      break;
+  }
+}
+
+void VerticalDataset::CategoricalColumn::Resize(const row_t num_rows) {
+  switch (storage_type_) {
+    case StorageType::kUInt8:
+      uint8_values_.resize(num_rows, Encode<uint8_t>(kNaValue));
+      break;
+    case StorageType::kUInt16:
+      uint16_values_.resize(num_rows, Encode<uint16_t>(kNaValue));
+      break;
+    case StorageType::kInt32:
+      int32_values_.resize(num_rows, kNaValue);
+      break;
+  }
+}
+
+void VerticalDataset::CategoricalColumn::Reserve(const row_t row) {
+  switch (storage_type_) {
+    case StorageType::kUInt8:
+      uint8_values_.reserve(row);
+      break;
+    case StorageType::kUInt16:
+      uint16_values_.reserve(row);
+      break;
+    case StorageType::kInt32:
+      int32_values_.reserve(row);
+      break;
+  }
+}
+
+VerticalDataset::row_t VerticalDataset::CategoricalColumn::nrows() const {
+  return values().size();
+}
+
+std::pair<uint64_t, uint64_t> VerticalDataset::CategoricalColumn::memory_usage()
+    const {
+  return std::pair<uint64_t, uint64_t>(
+      uint8_values_.size() * sizeof(uint8_t) +
+          uint16_values_.size() * sizeof(uint16_t) +
+          int32_values_.size() * sizeof(int32_t),
+      uint8_values_.capacity() * sizeof(uint8_t) +
+          uint16_values_.capacity() * sizeof(uint16_t) +
+          int32_values_.capacity() * sizeof(int32_t));
+}
+
+void VerticalDataset::CategoricalColumn::ShrinkToFit() {
+  uint8_values_.shrink_to_fit();
+  uint16_values_.shrink_to_fit();
+  int32_values_.shrink_to_fit();
+}
+
+template <typename T>
+absl::Status VerticalDataset::CategoricalColumn::ExtractAndAppendTemplate(
+    const absl::Span<const T> indices, AbstractColumn* dst) const {
+  auto* cast_dst = dynamic_cast<CategoricalColumn*>(dst);
+  STATUS_CHECK(cast_dst != nullptr);
+  const Values src_values = values();
+  if (src_values.empty() && !indices.empty()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Trying to extract ", indices.size(),
+        " examples from the non-allocated column \"", name(), "\"."));
+  }
+  const row_t init_dst_nrows = cast_dst->nrows();
+  if (init_dst_nrows == 0 && storage_type_ < cast_dst->storage_type_) {
+    // A column extracted from a compact column is also compact.
+    RETURN_IF_ERROR(cast_dst->SetStorageType(storage_type_));
+  }
+  cast_dst->Resize(init_dst_nrows + indices.size());
+  for (size_t new_idx = 0; new_idx < indices.size(); new_idx++) {
+    DCHECK_LT(indices[new_idx], src_values.size());
+    cast_dst->Set(init_dst_nrows + new_idx, src_values[indices[new_idx]]);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerticalDataset::CategoricalColumn::ExtractAndAppend(
+    const absl::Span<const row_t> indices, AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+absl::Status VerticalDataset::CategoricalColumn::ExtractAndAppend(
+    const absl::Span<const UnsignedExampleIdx> indices,
+    AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
 }
 
 void VerticalDataset::DiscretizedNumericalColumn::Set(
@@ -721,8 +1014,7 @@ void VerticalDataset::CategoricalListColumn::Set(
 void VerticalDataset::StringColumn::Set(
     row_t example_idx, const proto::Example::Attribute& attribute) {
   if (dataset::IsNa(attribute)) {
-    is_na_[example_idx] = true;
-    (*mutable_values())[example_idx].clear();
+    SetNA(example_idx);
   } else {
     DCHECK_EQ(attribute.type_case(),
               proto::Example::Attribute::TypeCase::kText);
@@ -732,8 +1024,7 @@ void VerticalDataset::StringColumn::Set(
 
 void VerticalDataset::StringColumn::Set(row_t example_idx,
                                         const absl::string_view value) {
-  (*mutable_values())[example_idx] = std::string(value);
-  is_na_[example_idx] = false;
+  SetIter(example_idx, value.begin(), value.end());
 }
 
 std::string VerticalDataset::NumericalColumn::ToStringWithDigitPrecision(
@@ -743,21 +1034,15 @@ std::string VerticalDataset::NumericalColumn::ToStringWithDigitPrecision(
 
 std::string VerticalDataset::StringColumn::ToStringWithDigitPrecision(
     const row_t row, const proto::Column& col_spec, int digit_precision) const {
-  return values()[row];
+  return std::string(value(row));
 }
 
 std::string VerticalDataset::BooleanColumn::ToStringWithDigitPrecision(
     const row_t row, const proto::Column& col_spec, int digit_precision) const {
-  if (values()[row] == 0) {
-    return "0";
-  }
-  if (values()[row] == 1) {
-    return "1";
-  }
-  if (values()[row] == kNaValue) {
+  if (IsNa(row)) {
     return kNaSymbol;
   }
-  return "Invalid";
+  return IsTrue(row) ? "1" : "0";
 }
 
 std::string VerticalDataset::NumericalSetColumn::ToStringWithDigitPrecision(
@@ -805,9 +1090,9 @@ std::string VerticalDataset::CategoricalColumn::ToStringWithDigitPrecision(
     return kNaSymbol;
   }
   if (col_spec.categorical().is_already_integerized()) {
-    return absl::StrCat(values()[row]);
+    return absl::StrCat(value(row));
   } else {
-    return CategoricalIdxToRepresentation(col_spec, values()[row]);
+    return CategoricalIdxToRepresentation(col_spec, value(row));
   }
 }
 
@@ -330,8 +330,13 @@ class VerticalDataset {
     static constexpr float kNaValue = std::numeric_limits<float>::quiet_NaN();
   };
 
-  class BooleanColumn : public TemplateScalarStorage<int8_t> {
+  // Boolean values. The values are stored as two bitmaps: One for the "true"
+  // values, and one for the missing values. This is 4x smaller than one byte
+  // per value.
+  class BooleanColumn : public AbstractColumn {
    public:
+    using Format = int8_t;
+
     proto::ColumnType type() const override {
       return proto::ColumnType::BOOLEAN;
     }
@@ -339,32 +344,64 @@ class VerticalDataset {
                                            const proto::Column& col_spec,
                                            int digit_precision) const override;
     bool IsNa(const row_t row) const override {
-      return values()[row] == kNaValue;
+      return GetBit(na_bits_, row);
     }
 
-    void AddNA() override { Add(kNaValue); }
+    // Tests if a value is true. Missing values are not true.
+    bool IsTrue(const row_t row) const { return GetBit(true_bits_, row); }
 
-    void SetNA(const row_t row) override {
-      (*mutable_values())[row] = kNaValue;
+    // Value of a row i.e. kTrueValue, kFalseValue or kNaValue.
+    int8_t value(const row_t row) const {
+      if (IsNa(row)) {
+        return kNaValue;
+      }
+      return IsTrue(row) ? kTrueValue : kFalseValue;
     }
 
-    void Resize(const row_t num_rows) override {
-      mutable_values()->resize(num_rows, kNaValue);
-    }
+    // Adds a value. "value" is kTrueValue, kFalseValue or kNaValue.
+    void Add(int8_t value);
+
+    void AddNA() override { Add(kNaValue); }
+
+    void SetNA(const row_t row) override { Set(row, kNaValue); }
+
+    void Resize(row_t num_rows) override;
+
+    void Reserve(row_t row) override;
+
+    row_t nrows() const override { return num_rows_; }
 
     void AddFromExample(const proto::Example::Attribute& attribute) override;
 
     void Set(row_t example_idx,
              const proto::Example::Attribute& attribute) override;
 
+    // Sets a value. "value" is kTrueValue, kFalseValue or kNaValue.
+    void Set(row_t example_idx, int8_t value);
+
     void ExtractExample(row_t example_idx,
                         proto::Example::Attribute* attribute) const override;
 
+    absl::Status ExtractAndAppend(absl::Span<const row_t> indices,
+                                  AbstractColumn* dst) const override;
+
+    absl::Status ExtractAndAppend(absl::Span<const UnsignedExampleIdx> indices,
+                                  AbstractColumn* dst) const override;
+
     absl::Status ConvertToGivenDataspec(
         AbstractColumn* dst, const proto::Column& src_spec,
         const proto::Column& dst_spec) const override;
 
-    bool IsTrue(const row_t row) const { return values()[row] == kTrueValue; }
+    std::pair<uint64_t, uint64_t> memory_usage() const override {
+      return std::pair<uint64_t, uint64_t>(
+          (true_bits_.size() + na_bits_.size()) * sizeof(uint64_t),
+          (true_bits_.capacity() + na_bits_.capacity()) * sizeof(uint64_t));
+    }
+
+    void ShrinkToFit() override {
+      true_bits_.shrink_to_fit();
+      na_bits_.shrink_to_fit();
+    }
 
     // Special value used to represent NA.
     static constexpr int8_t kNaValue = 2;
@@ -372,6 +409,33 @@ class VerticalDataset {
     static constexpr int8_t kTrueValue = 1;
     // Value representing "false".
     static constexpr int8_t kFalseValue = 0;
+
+   private:
+    template <typename T>
+    absl::Status ExtractAndAppendTemplate(absl::Span<const T> indices,
+                                          AbstractColumn* dst) const;
+
+    static bool GetBit(const std::vector<uint64_t>& bits, const row_t row) {
+      DCHECK_GE(row, 0);
+      DCHECK_LT(row / 64, bits.size());
+      return (bits[row / 64] >> (row % 64)) & 1;
+    }
+
+    static void SetBit(const row_t row, const bool value,
+                       std::vector<uint64_t>* bits) {
+      const uint64_t mask = uint64_t{1} << (row % 64);
+      if (value) {
+        (*bits)[row / 64] |= mask;
+      } else {
+        (*bits)[row / 64] &= ~mask;
+      }
+    }
+
+    row_t num_rows_ = 0;
+    // Bit "i" is set iff. the i-th value is true.
+    std::vector<uint64_t> true_bits_;
+    // Bit "i" is set iff. the i-th value is missing.
+    std::vector<uint64_t> na_bits_;
   };
 
   class DiscretizedNumericalColumn
@@ -413,8 +477,67 @@ class VerticalDataset {
     static constexpr Format kNaValue = kDiscretizedNumericalMissingValue;
   };
 
-  class CategoricalColumn : public TemplateScalarStorage<int32_t> {
+  // Categorical values. The values can be stored with a narrower integer type
+  // than "int32_t" (see "StorageType") when the dictionary of the column is
+  // small. All the values are read as "int32_t", with "kNaValue" for the
+  // missing values.
+  class CategoricalColumn : public AbstractColumn {
    public:
+    using Format = int32_t;
+
+    // Type of the stored values, from the narrowest to the widest. The missing
+    // values are stored as the maximum value of the unsigned types, and as
+    // "kNaValue" for "kInt32".
+    enum class StorageType { kUInt8, kUInt16, kInt32 };
+
+    // Read-only view over the values of a categorical column, whatever its
+    // storage type. Missing values are read as "kNaValue".
+    //
+    // The view is invalidated by any modification of the column.
+    class Values {
+     public:
+      // Empty view.
+      Values() : Values(absl::Span<const int32_t>()) {}
+
+      // View over "int32_t" values, e.g. a "std::vector<int32_t>".
+      Values(absl::Span<const int32_t> values)
+          : storage_type_(StorageType::kInt32),
+            size_(values.size()),
+            data_(values.data()) {}
+      Values(const std::vector<int32_t>& values)
+          : Values(absl::MakeConstSpan(values)) {}
+
+      explicit Values(absl::Span<const uint8_t> values)
+          : storage_type_(StorageType::kUInt8),
+            size_(values.size()),
+            data_(values.data()) {}
+
+      explicit Values(absl::Span<const uint16_t> values)
+          : storage_type_(StorageType::kUInt16),
+            size_(values.size()),
+            data_(values.data()) {}
+
+      int32_t operator[](const size_t row) const {
+        DCHECK_LT(row, size_);
+        if (storage_type_ == StorageType::kUInt8) {
+          return Decode(static_cast<const uint8_t*>(data_)[row]);
+        }
+        if (storage_type_ == StorageType::kUInt16) {
+          return Decode(static_cast<const uint16_t*>(data_)[row]);
+        }
+        return static_cast<const int32_t*>(data_)[row];
+      }
+
+      size_t size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+      StorageType storage_type() const { return storage_type_; }
+
+     private:
+      StorageType storage_type_;
+      size_t size_;
+      const void* data_;
+    };
+
     proto::ColumnType type() const override {
       return proto::ColumnType::CATEGORICAL;
     }
@@ -422,35 +545,125 @@ class VerticalDataset {
                                            const proto::Column& col_spec,
                                            int digit_precision) const override;
     bool IsNa(const row_t row) const override {
-      return values()[row] == kNaValue;
+      return value(row) == kNaValue;
     }
 
-    void AddNA() override { Add(kNaValue); }
+    // Smallest storage type able to represent the values of a column with
+    // "number_of_unique_values" values in its dictionary.
+    static StorageType StorageTypeForDictionary(
+        int64_t number_of_unique_values);
 
-    void SetNA(const row_t row) override {
-      (*mutable_values())[row] = kNaValue;
+    StorageType storage_type() const { return storage_type_; }
+
+    // Changes the storage type of the column. Fails if a value cannot be
+    // represented by "storage_type".
+    absl::Status SetStorageType(StorageType storage_type);
+
+    // Access to the values.
+    Values values() const {
+      if (storage_type_ == StorageType::kUInt8) {
+        return Values(absl::MakeConstSpan(uint8_values_));
+      }
+      if (storage_type_ == StorageType::kUInt16) {
+        return Values(absl::MakeConstSpan(uint16_values_));
+      }
+      return Values(absl::MakeConstSpan(int32_values_));
     }
 
-    void Resize(const row_t num_rows) override {
-      mutable_values()->resize(num_rows, kNaValue);
+    // Values of a column stored with "StorageType::kInt32" (the default).
+    // Columns are only stored with a narrower type on request (e.g.
+    // "LoadConfig::compact_columns"), which the label, weight and group
+    // columns never are.
+    const std::vector<int32_t>& int32_values() const {
+      CHECK(storage_type_ == StorageType::kInt32)
+          << "Column \"" << name() << "\" is not stored as int32";
+      return int32_values_;
+    }
+
+    int32_t value(const row_t row) const {
+      if (storage_type_ == StorageType::kUInt8) {
+        return Decode(uint8_values_[row]);
+      }
+      if (storage_type_ == StorageType::kUInt16) {
+        return Decode(uint16_values_[row]);
+      }
+      return int32_values_[row];
     }
 
+    // Adds a value. The storage type is widened if "value" does not fit.
+    void Add(int32_t value);
+
+    void AddNA() override { Add(kNaValue); }
+
+    void SetNA(const row_t row) override { Set(row, kNaValue); }
+
+    void Resize(row_t num_rows) override;
+
+    void Reserve(row_t row) override;
+
+    row_t nrows() const override;
+
     void AddFromExample(const proto::Example::Attribute& attribute) override;
 
     void Set(row_t example_idx,
              const proto::Example::Attribute& attribute) override;
 
+    // Sets a value. The storage type is widened if "value" does not fit.
     void Set(row_t example_idx, int32_t value);
 
     void ExtractExample(row_t example_idx,
                         proto::Example::Attribute* attribute) const override;
 
+    absl::Status ExtractAndAppend(absl::Span<const row_t> indices,
+                                  AbstractColumn* dst) const override;
+
+    absl::Status ExtractAndAppend(absl::Span<const UnsignedExampleIdx> indices,
+                                  AbstractColumn* dst) const override;
+
     absl::Status ConvertToGivenDataspec(
         AbstractColumn* dst, const proto::Column& src_spec,
         const proto::Column& dst_spec) const override;
 
+    std::pair<uint64_t, uint64_t> memory_usage() const override;
+
+    void ShrinkToFit() override;
+
     // Special value used to represent NA.
     static constexpr int kNaValue = -1;
+
+   private:
+    // Conversion between the "int32_t" values and the stored values.
+    template <typename T>
+    static int32_t Decode(const T value) {
+      if constexpr (std::is_same_v<T, int32_t>) {
+        return value;
+      } else {
+        return value == std::numeric_limits<T>::max() ? kNaValue : value;
+      }
+    }
+
+    template <typename T>
+    static T Encode(const int32_t value) {
+      if constexpr (std::is_same_v<T, int32_t>) {
+        return value;
+      } else {
+        return value == kNaValue ? std::numeric_limits<T>::max()
+                                 : static_cast<T>(value);
+      }
+    }
+
+    // Tests if "value" can be stored with the current storage type.
+    bool Fits(int32_t value) const;
+
+    template <typename T>
+    absl::Status ExtractAndAppendTemplate(absl::Span<const T> indices,
+                                          AbstractColumn* dst) const;
+
+    StorageType storage_type_ = StorageType::kInt32;
+    // Only the vector matching "storage_type_" is used.
+    std::vector<uint8_t> uint8_values_;
+    std::vector<uint16_t> uint16_values_;
+    std::vector<int32_t> int32_values_;
   };
 
   class NumericalSetColumn : public TemplateMultiValueStorage<float> {
@@ -537,7 +750,11 @@ class VerticalDataset {
         const proto::Column& dst_spec) const override;
   };
 
-  class StringColumn : public TemplateScalarStorage<std::string> {
+  // Storage of strings. The characters of all the values are pooled in a
+  // single buffer (see "TemplateMultiValueStorage"). Compared to a
+  // "std::vector<std::string>", this saves the "std::string" object and the
+  // heap allocation of each value.
+  class StringColumn : public TemplateMultiValueStorage<char> {
    public:
     proto::ColumnType type() const override {
       return proto::ColumnType::STRING;
@@ -546,36 +763,29 @@ class VerticalDataset {
                                            const proto::Column& col_spec,
                                            int digit_precision) const override;
 
-    void Add(const std::string& value) {
-      TemplateScalarStorage<std::string>::Add(value);
-      is_na_.push_back(false);
+    // Adds a value. The characters are copied in the column.
+    void Add(const absl::string_view value) {
+      TemplateMultiValueStorage<char>::Add(value.begin(), value.end());
     }
 
-    bool IsNa(const row_t row) const override { return is_na_[row]; }
-
-    void AddNA() override {
-      TemplateScalarStorage<std::string>::Add("");
-      is_na_.push_back(true);
-    }
-
-    void SetNA(const row_t row) override {
-      (*mutable_values())[row] = "";
-      is_na_[row] = true;
+    // Value of a row. Missing values are returned as empty strings. The view
+    // is valid until the next modification of the column.
+    absl::string_view value(const row_t row) const {
+      if (IsNa(row)) {
+        return {};
+      }
+      const auto& range = values()[row];
+      return absl::string_view(bank().data() + range.first,
+                               range.second - range.first);
     }
 
-    void Resize(const row_t num_rows) override {
-      mutable_values()->resize(num_rows);
-      is_na_.resize(num_rows, true);
-    }
-    void Reserve(const row_t row) override {
-      TemplateScalarStorage::Reserve(row);
-      is_na_.reserve(row);
-    }
     void AddFromExample(const proto::Example::Attribute& attribute) override;
 
     void Set(row_t example_idx,
              const proto::Example::Attribute& attribute) override;
 
+    // Sets a value. The previous characters of the row are not released
+    // until the column is destroyed.
     void Set(row_t example_idx, const absl::string_view value);
 
     void ExtractExample(row_t example_idx,
@@ -584,9 +794,6 @@ class VerticalDataset {
     absl::Status ConvertToGivenDataspec(
         AbstractColumn* dst, const proto::Column& src_spec,
         const proto::Column& dst_spec) const override;
-
-   private:
-    std::vector<bool> is_na_;
   };
 
   class HashColumn : public TemplateScalarStorage<uint64_t> {
@@ -676,6 +883,21 @@ class VerticalDataset {
           vector_length_);
     };
 
+    // Gets a view to all the vectors of a sequence, stored one after the
+    // other.
+    absl::StatusOr<absl::Span<const float>> GetVectors(row_t row) const {
+      DCHECK_GE(row, 0);
+      DCHECK_LT(row, nrows());
+
+      const auto size = item_sizes_[row];
+      if (size == -1) {
+        return absl::InvalidArgumentError(
+            "Trying to get the vectors of a missing vector sequence.");
+      }
+      return absl::Span<const float>(&bank_[item_begins_[row]],
+                                     size * vector_length_);
+    };
+
     void Add(absl::Span<const float> values);
 
     void Set(row_t row, absl::Span<const float> values);
@@ -897,6 +1119,18 @@ class VerticalDataset {
   void AppendExample(
       const std::unordered_map<std::string, std::string>& example);
 
+  // Appends all the examples of "src" to the dataset. "src" should have the
+  // same columns as the dataset. If "load_columns" is set, only the columns
+  // specified in it will be appended.
+  absl::Status AppendDataset(
+      const VerticalDataset& src,
+      const std::optional<std::vector<int>>& load_columns = {});
+
+  // Same as above, but only appends the examples "indices" of "src".
+  absl::Status AppendDataset(
+      const VerticalDataset& src, absl::Span<const row_t> indices,
+      const std::optional<std::vector<int>>& load_columns = {});
+
   // Create a shallow copy of the dataset. The created dataset does not get
   // ownership of the columns.
   VerticalDataset ShallowNonOwningClone() const;
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -30,6 +31,8 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/avro_example.h"
+#include "yggdrasil_decision_forests/dataset/csv_example_reader.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader.h"
@@ -40,6 +43,7 @@
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/usage.h"
@@ -48,6 +52,57 @@ namespace yggdrasil_decision_forests {
 namespace dataset {
 namespace {
 
+// Number of examples read at once by the columnar readers.
+constexpr VerticalDataset::row_t kLoadBatchSize = 4096;
+
+// Creates the columns of "dataset" from "data_spec", and sets the storage of
+// the "config.compact_columns" columns.
+absl::Status CreateColumns(const proto::DataSpecification& data_spec,
+                           const LoadConfig& config, VerticalDataset* dataset) {
+  dataset->set_data_spec(data_spec);
+  RETURN_IF_ERROR(dataset->CreateColumnsFromDataspec());
+  dataset->set_nrow(0);
+  if (!config.compact_columns.has_value()) {
+    return absl::OkStatus();
+  }
+  for (const int col_idx : config.compact_columns.value()) {
+    const auto& col_spec = data_spec.columns(col_idx);
+    if (col_spec.type() != proto::ColumnType::CATEGORICAL) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(auto* column,
+                     dataset->MutableColumnWithCastWithStatus<
+                         VerticalDataset::CategoricalColumn>(col_idx));
+    RETURN_IF_ERROR(column->SetStorageType(
+        VerticalDataset::CategoricalColumn::StorageTypeForDictionary(
+            col_spec.categorical().number_of_unique_values())));
+  }
+  return absl::OkStatus();
+}
+
+// Appends the examples of "src" accepted by "config.load_example" to "dst".
+// "src" should contain all the columns used by "config.load_example".
+absl::Status AppendSelectedExamples(const VerticalDataset& src,
+                                    const LoadConfig& config,
+                                    VerticalDataset* dst,
+                                    std::size_t* skipped_examples) {
+  if (!config.load_example.has_value()) {
+    return dst->AppendDataset(src, config.load_columns);
+  }
+  std::vector<VerticalDataset::row_t> selected;
+  proto::Example example;
+  for (VerticalDataset::row_t example_idx = 0; example_idx < src.nrow();
+       example_idx++) {
+    src.ExtractExample(example_idx, &example);
+    if (config.load_example.value()(example)) {
+      selected.push_back(example_idx);
+    } else {
+      (*skipped_examples)++;
+    }
+  }
+  return dst->AppendDataset(src, selected, config.load_columns);
+}
+
 // Loads the datasets using a single thread. This solution is more memory
 // efficient that per-shard loading as examples are directly integrated into the
 // vertical representation.
@@ -57,9 +112,27 @@ absl::Status LoadVerticalDatasetSingleThread(
     const std::optional<std::vector<int>>& required_columns,
     const LoadConfig& config) {
   // Initialize dataset.
-  dataset->set_data_spec(data_spec);
-  RETURN_IF_ERROR(dataset->CreateColumnsFromDataspec());
-  dataset->set_nrow(0);
+  RETURN_IF_ERROR(CreateColumns(data_spec, config, dataset));
+
+  if (!config.load_example.has_value()) {
+    // Read the examples directly in the columns.
+    ASSIGN_OR_RETURN(auto reader,
+                     CreateColumnarReader(typed_path, data_spec,
+                                          required_columns,
+                                          config.load_columns));
+    while (true) {
+      ASSIGN_OR_RETURN(const auto num_examples,
+                       reader->NextBatch(kLoadBatchSize, dataset));
+      if (num_examples == 0) {
+        break;
+      }
+      LOG_EVERY_N_SEC(INFO, 30) << dataset->nrow() << " examples scanned.";
+    }
+    dataset->ShrinkToFit();
+    LOG_EVERY_N_SEC(INFO, 30) << dataset->nrow() << " examples read. Memory: "
+                              << dataset->MemorySummary() << ".";
+    return absl::OkStatus();
+  }
 
   // Read and record the examples.
   ASSIGN_OR_RETURN(auto reader, CreateExampleReader(typed_path, data_spec,
@@ -96,19 +169,85 @@ absl::Status LoadVerticalDatasetSingleThread(
   return status.status();
 }
 
+// Reads a single file with multiple threads. "read_file" has the signature of
+// "ReadCsvFileInParallel".
+using ReadFileInParallel = std::function<absl::Status(
+    absl::string_view path, const proto::DataSpecification& data_spec,
+    const std::optional<std::vector<int>>& required_columns,
+    const std::optional<std::vector<int>>& load_columns, int num_threads,
+    const std::function<absl::Status(const VerticalDataset&)>& consume)>;
+
+// Loads a single file using multiple threads. The file is split into chunks
+// (e.g. csv records, avro blocks) parsed in parallel, and the examples are
+// integrated in the vertical representation in the order of the file.
+absl::Status LoadVerticalDatasetSingleFile(
+    const absl::string_view path, const proto::DataSpecification& data_spec,
+    VerticalDataset* dataset,
+    const std::optional<std::vector<int>>& required_columns,
+    const LoadConfig& config, const ReadFileInParallel& read_file) {
+  // Initialize dataset.
+  RETURN_IF_ERROR(CreateColumns(data_spec, config, dataset));
+
+  // Number of skipped example because of "config.load_example".
+  std::size_t skipped_examples = 0;
+
+  // "config.load_example" is evaluated on all the columns.
+  const std::optional<std::vector<int>> read_columns =
+      config.load_example.has_value() ? std::nullopt : config.load_columns;
+  RETURN_IF_ERROR(read_file(
+      path, data_spec, required_columns, read_columns, config.num_threads,
+      [&](const VerticalDataset& chunk) -> absl::Status {
+        RETURN_IF_ERROR(
+            AppendSelectedExamples(chunk, config, dataset, &skipped_examples));
+        LOG_EVERY_N_SEC(INFO, 30) << dataset->nrow() << " examples scanned.";
+        return absl::OkStatus();
+      }));
+
+  dataset->ShrinkToFit();
+
+  LOG_EVERY_N_SEC(INFO, 30)
+      << dataset->nrow() << " examples read with " << config.num_threads
+      << " threads. Memory: " << dataset->MemorySummary() << ". "
+      << skipped_examples << " ("
+      << 100 * skipped_examples /
+             std::max<size_t>(1, dataset->nrow() + skipped_examples)
+      << "%) examples have been skipped.";
+  return absl::OkStatus();
+}
+
 // Set of examples extracted by a worker.
 struct BlockOfExamples {
   // List of examples. These messages are allocated in "arena".
   std::vector<proto::Example*> examples;
   google::protobuf::Arena arena;
+  // Examples read directly in the columns. If set, "examples" is empty.
+  std::unique_ptr<VerticalDataset> columns;
 };
 
-// Reads a shard.
+// Reads a shard. If "config.load_example" is not set, the examples are read
+// directly in the columns.
 absl::StatusOr<std::unique_ptr<BlockOfExamples>> LoadShard(
     const proto::DataSpecification& data_spec, const absl::string_view prefix,
     const std::optional<std::vector<int>>& required_columns,
-    const absl::string_view shard) {
+    const LoadConfig& config, const absl::string_view shard) {
   auto block = std::make_unique<BlockOfExamples>();
+  if (!config.load_example.has_value()) {
+    block->columns = std::make_unique<VerticalDataset>();
+    RETURN_IF_ERROR(CreateColumns(data_spec, config, block->columns.get()));
+    ASSIGN_OR_RETURN(auto reader,
+                     CreateColumnarReader(absl::StrCat(prefix, ":", shard),
+                                          data_spec, required_columns,
+                                          config.load_columns));
+    while (true) {
+      ASSIGN_OR_RETURN(const auto num_examples,
+                       reader->NextBatch(kLoadBatchSize, block->columns.get()));
+      if (num_examples == 0) {
+        break;
+      }
+    }
+    return block;
+  }
+
   ASSIGN_OR_RETURN(auto reader,
                    CreateExampleReader(absl::StrCat(prefix, ":", shard),
                                        data_spec, required_columns));
@@ -136,6 +275,27 @@ absl::Status LoadVerticalDataset(
 
   utils::usage::OnLoadDataset(path);
 
+  if (shards.size() == 1 && config.num_threads > 1) {
+    // The examples of a single csv or avro file are decoded in parallel.
+    //
+    // A local csv file is memory-mapped and split into chunks of records.
+    // Non-local csv files (e.g. remote files) are read in a single thread
+    // instead of being read entirely in memory.
+    if (prefix == FORMAT_CSV &&
+        utils::MemoryMappedFile::CanMap(shards.front())) {
+      return LoadVerticalDatasetSingleFile(shards.front(), data_spec, dataset,
+                                           required_columns, config,
+                                           ReadCsvFileInParallel);
+    }
+    // The blocks of an avro file are read sequentially, and decompressed and
+    // decoded independently.
+    if (prefix == FORMAT_AVRO) {
+      return LoadVerticalDatasetSingleFile(shards.front(), data_spec, dataset,
+                                           required_columns, config,
+                                           avro::ReadAvroFileInParallel);
+    }
+  }
+
   if (shards.size() <= 1 || config.num_threads <= 1) {
     // Loading in a single thread.
     return LoadVerticalDatasetSingleThread(typed_path, data_spec, dataset,
@@ -143,14 +303,12 @@ absl::Status LoadVerticalDataset(
   }
 
   // Initialize dataset.
-  dataset->set_data_spec(data_spec);
-  RETURN_IF_ERROR(dataset->CreateColumnsFromDataspec());
-  dataset->set_nrow(0);
+  RETURN_IF_ERROR(CreateColumns(data_spec, config, dataset));
 
   // Reads the examples in a shard.
   const auto load_shard = [&](const std::string shard)
       -> absl::StatusOr<std::unique_ptr<BlockOfExamples>> {
-    return LoadShard(data_spec, prefix, required_columns, shard);
+    return LoadShard(data_spec, prefix, required_columns, config, shard);
   };
 
   utils::concurrency::StreamProcessor<
@@ -186,7 +344,9 @@ absl::Status LoadVerticalDataset(
 
       // Count the number of examples in the first shard.
       std::size_t num_examples_in_shard;
-      if (config.load_example.has_value()) {
+      if (block->columns) {
+        num_examples_in_shard = block->columns->nrow();
+      } else if (config.load_example.has_value()) {
         num_examples_in_shard = 0;
         for (const auto* example : block->examples) {
           if (config.load_example.value()(*example)) {
@@ -214,6 +374,10 @@ absl::Status LoadVerticalDataset(
         dataset->Reserve(reserved_examples, config.load_columns);
       }
     }
+    if (block->columns) {
+      RETURN_IF_ERROR(
+          dataset->AppendDataset(*block->columns, config.load_columns));
+    }
     for (const auto* example : block->examples) {
       if (config.load_example.has_value() &&
           !config.load_example.value()(*example)) {
@@ -37,13 +37,21 @@ namespace dataset {
 
 // Advanced options for dataset loading.
 struct LoadConfig {
-  // Number of reading threads. Only used for multi-sharded datasets.
-  // num_threads=1 is more memory efficient than num_threads>1.
+  // Number of reading threads. Used for multi-sharded datasets, and for
+  // single local csv and avro files, which are split into chunks read in
+  // parallel. Single non-local csv files (e.g. remote files) are always read
+  // in a single thread. num_threads=1 is more memory efficient than
+  // num_threads>1.
   int num_threads = 10;
   // If specified, only load this subset of columns.
   std::optional<std::vector<int>> load_columns;
   // If specified, only load the examples that evaluate to true.
   std::optional<std::function<bool(const proto::Example&)>> load_example;
+  // If specified, the categorical columns in this list are stored with the
+  // narrowest integer type able to represent their dictionary (see
+  // "VerticalDataset::CategoricalColumn::StorageTypeForDictionary"). Learners
+  // use it for the input features.
+  std::optional<std::vector<int>> compact_columns;
 };
 
 // Load the dataset content from a file (or a set of files).
@@ -15,19 +15,31 @@
 
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 
+#include <initializer_list>
+#include <memory>
+#include <numeric>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/bytestream.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
 
 namespace yggdrasil_decision_forests {
 namespace dataset {
@@ -61,6 +73,227 @@ TEST(VerticalDatasetIOTest, Load) {
   }
 }
 
+TEST(VerticalDatasetIOTest, LoadSingleCsvFileInParallel) {
+  const std::string dataset_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv"));
+  proto::DataSpecificationGuide guide;
+  proto::DataSpecification data_spec;
+  CreateDataSpec(dataset_path, false, guide, &data_spec);
+
+  // The statistics are the same when computed with multiple threads.
+  guide.set_num_threads(4);
+  proto::DataSpecification parallel_data_spec;
+  CreateDataSpec(dataset_path, false, guide, &parallel_data_spec);
+  EXPECT_THAT(parallel_data_spec, EqualsProto(data_spec));
+
+  LoadConfig sequential_config;
+  sequential_config.num_threads = 1;
+  VerticalDataset sequential_ds;
+  ASSERT_OK(LoadVerticalDataset(dataset_path, data_spec, &sequential_ds, {},
+                                sequential_config));
+
+  LoadConfig parallel_config;
+  parallel_config.num_threads = 4;
+  VerticalDataset parallel_ds;
+  ASSERT_OK(LoadVerticalDataset(dataset_path, data_spec, &parallel_ds, {},
+                                parallel_config));
+
+  ASSERT_EQ(parallel_ds.nrow(), sequential_ds.nrow());
+  for (int example_idx = 0; example_idx < sequential_ds.nrow();
+       example_idx++) {
+    proto::Example sequential_example, parallel_example;
+    sequential_ds.ExtractExample(example_idx, &sequential_example);
+    parallel_ds.ExtractExample(example_idx, &parallel_example);
+    EXPECT_THAT(parallel_example, EqualsProto(sequential_example));
+  }
+}
+
+TEST(VerticalDatasetIOTest, LoadCompactColumns) {
+  using CategoricalColumn = VerticalDataset::CategoricalColumn;
+  const std::string dataset_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv"));
+  proto::DataSpecificationGuide guide;
+  proto::DataSpecification data_spec;
+  CreateDataSpec(dataset_path, false, guide, &data_spec);
+  const int workclass_idx = GetColumnIdxFromName("workclass", data_spec);
+  const int education_idx = GetColumnIdxFromName("education", data_spec);
+
+  VerticalDataset ds;
+  ASSERT_OK(LoadVerticalDataset(dataset_path, data_spec, &ds));
+
+  LoadConfig config;
+  config.compact_columns = {workclass_idx};
+  VerticalDataset compact_ds;
+  ASSERT_OK(
+      LoadVerticalDataset(dataset_path, data_spec, &compact_ds, {}, config));
+
+  ASSERT_OK_AND_ASSIGN(
+      const auto* workclass,
+      compact_ds.ColumnWithCastWithStatus<CategoricalColumn>(workclass_idx));
+  EXPECT_EQ(workclass->storage_type(), CategoricalColumn::StorageType::kUInt8);
+  EXPECT_EQ(workclass->memory_usage().first, compact_ds.nrow());
+  ASSERT_OK_AND_ASSIGN(
+      const auto* education,
+      compact_ds.ColumnWithCastWithStatus<CategoricalColumn>(education_idx));
+  EXPECT_EQ(education->storage_type(), CategoricalColumn::StorageType::kInt32);
+
+  // The values are the same.
+  ASSERT_EQ(compact_ds.nrow(), ds.nrow());
+  for (int example_idx = 0; example_idx < ds.nrow(); example_idx++) {
+    proto::Example example, compact_example;
+    ds.ExtractExample(example_idx, &example);
+    compact_ds.ExtractExample(example_idx, &compact_example);
+    EXPECT_THAT(compact_example, EqualsProto(example));
+  }
+}
+
+#ifdef YGG_FILESYSTEM_USES_DEFAULT
+// Remote file system serving the "gs://bucket/<name>" files from the test
+// dataset directory. Such files cannot be memory-mapped.
+class FakeRemoteFileSystem : public utils::filesystem::FileSystemInterface {
+ public:
+  static std::string LocalPath(absl::string_view path) {
+    const auto remote_path = utils::filesystem::GCSPath::Parse(path);
+    return file::JoinPath(DatasetDir(), remote_path->object);
+  }
+
+  std::string JoinPathList(
+      std::initializer_list<absl::string_view> paths) override {
+    return absl::StrJoin(paths, "/");
+  }
+
+  bool GenerateShardedFilenames(absl::string_view spec,
+                                std::vector<std::string>* names) override {
+    return false;
+  }
+
+  absl::Status Match(absl::string_view pattern,
+                     std::vector<std::string>* results,
+                     const int options) override {
+    ASSIGN_OR_RETURN(const bool exists, FileExists(pattern));
+    if (exists) {
+      results->push_back(std::string(pattern));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status RecursivelyCreateDir(absl::string_view path,
+                                    const int options) override {
+    return absl::UnimplementedError("Read-only file system");
+  }
+
+  absl::Status RecursivelyDelete(absl::string_view path,
+                                 const int options) override {
+    return absl::UnimplementedError("Read-only file system");
+  }
+
+  absl::StatusOr<bool> FileExists(absl::string_view path) override {
+    return file::FileExists(LocalPath(path));
+  }
+
+  absl::Status Rename(absl::string_view from, absl::string_view to,
+                      const int options) override {
+    return absl::UnimplementedError("Read-only file system");
+  }
+
+  std::string GetBasename(absl::string_view path) override {
+    return file::GetBasename(LocalPath(path));
+  }
+
+  std::unique_ptr<utils::FileInputByteStream> CreateInputByteStream() override {
+    return std::make_unique<InputByteStream>();
+  }
+
+  std::unique_ptr<utils::FileOutputByteStream> CreateOutputByteStream()
+      override {
+    return nullptr;
+  }
+
+ private:
+  class InputByteStream : public utils::FileInputByteStream {
+   public:
+    absl::Status Open(absl::string_view path) override {
+      return stream_.Open(LocalPath(path));
+    }
+    absl::StatusOr<int> ReadUpTo(char* buffer, int max_read) override {
+      return stream_.ReadUpTo(buffer, max_read);
+    }
+    absl::StatusOr<bool> ReadExactly(char* buffer, int num_read) override {
+      return stream_.ReadExactly(buffer, num_read);
+    }
+    absl::Status Close() override { return stream_.Close(); }
+
+   private:
+    utils::filesystem::STLFileInputByteStream stream_;
+  };
+};
+
+TEST(VerticalDatasetIOTest, LoadRemoteSingleCsvFile) {
+  utils::filesystem::SetGCSImplementation(
+      std::make_unique<FakeRemoteFileSystem>());
+
+  const std::string local_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv"));
+  const std::string remote_path = "csv:gs://bucket/adult.csv";
+
+  proto::DataSpecificationGuide guide;
+  guide.set_num_threads(4);
+  proto::DataSpecification local_data_spec;
+  CreateDataSpec(local_path, false, guide, &local_data_spec);
+  proto::DataSpecification remote_data_spec;
+  CreateDataSpec(remote_path, false, guide, &remote_data_spec);
+  EXPECT_THAT(remote_data_spec, EqualsProto(local_data_spec));
+
+  LoadConfig config;
+  config.num_threads = 4;
+  VerticalDataset local_ds;
+  ASSERT_OK(
+      LoadVerticalDataset(local_path, local_data_spec, &local_ds, {}, config));
+  VerticalDataset remote_ds;
+  ASSERT_OK(LoadVerticalDataset(remote_path, local_data_spec, &remote_ds, {},
+                                config));
+
+  ASSERT_EQ(remote_ds.nrow(), local_ds.nrow());
+  for (int example_idx = 0; example_idx < local_ds.nrow(); example_idx++) {
+    proto::Example local_example, remote_example;
+    local_ds.ExtractExample(example_idx, &local_example);
+    remote_ds.ExtractExample(example_idx, &remote_example);
+    EXPECT_THAT(remote_example, EqualsProto(local_example));
+  }
+
+  utils::filesystem::SetGCSImplementation(nullptr);
+}
+#endif
+
+TEST(VerticalDatasetIOTest, LoadCsvWithVectorSequenceColumn) {
+  const std::string dataset_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "toy.csv"));
+  proto::DataSpecificationGuide guide;
+  proto::DataSpecification data_spec;
+  CreateDataSpec(dataset_path, false, guide, &data_spec);
+  std::vector<int> required_columns(data_spec.columns_size());
+  std::iota(required_columns.begin(), required_columns.end(), 0);
+
+  // The vector sequence column is not in the csv file. Its values are missing.
+  auto* col_spec = data_spec.add_columns();
+  col_spec->set_name("vector_sequence");
+  col_spec->set_type(proto::ColumnType::NUMERICAL_VECTOR_SEQUENCE);
+  col_spec->mutable_numerical_vector_sequence()->set_vector_length(2);
+
+  for (const int num_threads : {1, 4}) {
+    LoadConfig config;
+    config.num_threads = num_threads;
+    VerticalDataset ds;
+    ASSERT_OK(LoadVerticalDataset(dataset_path, data_spec, &ds,
+                                  required_columns, config));
+    EXPECT_EQ(ds.nrow(), 4);
+    EXPECT_EQ(ds.ncol(), 10);
+    for (int example_idx = 0; example_idx < ds.nrow(); example_idx++) {
+      EXPECT_TRUE(ds.column(9)->IsNa(example_idx));
+    }
+  }
+}
+
 TEST(VerticalDatasetIOTest, LoadSaveLoad) {
   const std::string dataset_path = file::JoinPath(DatasetDir(), "toy.csv");
   const std::string format = "csv";
@@ -591,6 +591,156 @@ nan,BBB
 )");
 }
 
+TEST(StringColumn, Inspect) {
+  VerticalDataset dataset;
+  AddColumn("a", proto::ColumnType::STRING, dataset.mutable_data_spec());
+  EXPECT_OK(dataset.CreateColumnsFromDataspec());
+  ASSERT_OK_AND_ASSIGN(
+      auto* col,
+      dataset.MutableColumnWithCastWithStatus<VerticalDataset::StringColumn>(
+          0));
+
+  col->Add("hello");
+  col->AddNA();
+  col->Add("");
+  col->Add("world");
+  dataset.set_nrow(4);
+
+  EXPECT_EQ(col->nrows(), 4);
+  EXPECT_FALSE(col->IsNa(0));
+  EXPECT_TRUE(col->IsNa(1));
+  EXPECT_FALSE(col->IsNa(2));
+  EXPECT_EQ(col->value(0), "hello");
+  EXPECT_EQ(col->value(1), "");
+  EXPECT_EQ(col->value(2), "");
+  EXPECT_EQ(col->value(3), "world");
+
+  // The characters are pooled.
+  EXPECT_EQ(col->bank().size(), 10);
+
+  col->Set(0, "hi");
+  col->SetNA(3);
+  const proto::Example::Attribute text_abc = PARSE_TEST_PROTO("text: \"abc\"");
+  col->Set(1, text_abc);
+  EXPECT_EQ(col->value(0), "hi");
+  EXPECT_EQ(col->value(1), "abc");
+  EXPECT_TRUE(col->IsNa(3));
+
+  proto::Example::Attribute attribute;
+  col->ExtractExample(1, &attribute);
+  EXPECT_THAT(attribute, EqualsProto(text_abc));
+
+  VerticalDataset extracted;
+  *extracted.mutable_data_spec() = dataset.data_spec();
+  EXPECT_OK(extracted.CreateColumnsFromDataspec());
+  EXPECT_OK(col->ExtractAndAppend(std::vector<VerticalDataset::row_t>{3, 1, 0},
+                                  extracted.mutable_column(0)));
+  extracted.set_nrow(3);
+  EXPECT_EQ(extracted.ValueToString(0, 0), "");
+  EXPECT_TRUE(extracted.column(0)->IsNa(0));
+  EXPECT_EQ(extracted.ValueToString(1, 0), "abc");
+  EXPECT_EQ(extracted.ValueToString(2, 0), "hi");
+}
+
+TEST(BooleanColumn, Inspect) {
+  VerticalDataset::BooleanColumn col;
+  for (int row = 0; row < 100; row++) {
+    col.Add(row % 3 == 0   ? VerticalDataset::BooleanColumn::kTrueValue
+            : row % 3 == 1 ? VerticalDataset::BooleanColumn::kFalseValue
+                           : VerticalDataset::BooleanColumn::kNaValue);
+  }
+  EXPECT_EQ(col.nrows(), 100);
+  EXPECT_TRUE(col.IsTrue(0));
+  EXPECT_FALSE(col.IsNa(0));
+  EXPECT_FALSE(col.IsTrue(1));
+  EXPECT_FALSE(col.IsNa(1));
+  EXPECT_FALSE(col.IsTrue(2));
+  EXPECT_TRUE(col.IsNa(2));
+  EXPECT_EQ(col.value(99), VerticalDataset::BooleanColumn::kTrueValue);
+  EXPECT_EQ(col.value(98), VerticalDataset::BooleanColumn::kNaValue);
+
+  // Two bitmaps of two 64 bits words.
+  EXPECT_EQ(col.memory_usage().first, 4 * sizeof(uint64_t));
+
+  col.Set(2, VerticalDataset::BooleanColumn::kTrueValue);
+  col.SetNA(0);
+  EXPECT_TRUE(col.IsTrue(2));
+  EXPECT_FALSE(col.IsNa(2));
+  EXPECT_TRUE(col.IsNa(0));
+  EXPECT_FALSE(col.IsTrue(0));
+
+  // The new rows are missing.
+  col.Resize(130);
+  EXPECT_EQ(col.nrows(), 130);
+  EXPECT_TRUE(col.IsNa(129));
+  EXPECT_EQ(col.value(99), VerticalDataset::BooleanColumn::kTrueValue);
+
+  const proto::Example::Attribute boolean_true =
+      PARSE_TEST_PROTO("boolean: true");
+  proto::Example::Attribute attribute;
+  col.ExtractExample(2, &attribute);
+  EXPECT_THAT(attribute, EqualsProto(boolean_true));
+
+  VerticalDataset::BooleanColumn extracted;
+  EXPECT_OK(col.ExtractAndAppend(
+      std::vector<VerticalDataset::row_t>{99, 0, 1}, &extracted));
+  EXPECT_EQ(extracted.nrows(), 3);
+  EXPECT_EQ(extracted.value(0), VerticalDataset::BooleanColumn::kTrueValue);
+  EXPECT_EQ(extracted.value(1), VerticalDataset::BooleanColumn::kNaValue);
+  EXPECT_EQ(extracted.value(2), VerticalDataset::BooleanColumn::kFalseValue);
+}
+
+TEST(CategoricalColumn, StorageTypeForDictionary) {
+  using StorageType = VerticalDataset::CategoricalColumn::StorageType;
+  EXPECT_EQ(VerticalDataset::CategoricalColumn::StorageTypeForDictionary(10),
+            StorageType::kUInt8);
+  EXPECT_EQ(VerticalDataset::CategoricalColumn::StorageTypeForDictionary(255),
+            StorageType::kUInt8);
+  EXPECT_EQ(VerticalDataset::CategoricalColumn::StorageTypeForDictionary(256),
+            StorageType::kUInt16);
+  EXPECT_EQ(
+      VerticalDataset::CategoricalColumn::StorageTypeForDictionary(100000),
+      StorageType::kInt32);
+}
+
+TEST(CategoricalColumn, CompactStorage) {
+  using StorageType = VerticalDataset::CategoricalColumn::StorageType;
+  VerticalDataset::CategoricalColumn col;
+  col.Add(1);
+  col.AddNA();
+  col.Add(254);
+  EXPECT_OK(col.SetStorageType(StorageType::kUInt8));
+  EXPECT_EQ(col.storage_type(), StorageType::kUInt8);
+  EXPECT_EQ(col.memory_usage().first, 3);
+  EXPECT_EQ(col.nrows(), 3);
+  EXPECT_EQ(col.value(0), 1);
+  EXPECT_TRUE(col.IsNa(1));
+  EXPECT_EQ(col.value(1), VerticalDataset::CategoricalColumn::kNaValue);
+
+  const auto values = col.values();
+  EXPECT_EQ(values.storage_type(), StorageType::kUInt8);
+  EXPECT_EQ(values.size(), 3);
+  EXPECT_EQ(values[2], 254);
+
+  // A value that does not fit widens the storage.
+  col.Set(1, 1000);
+  EXPECT_EQ(col.storage_type(), StorageType::kInt32);
+  EXPECT_THAT(col.int32_values(), ElementsAre(1, 1000, 254));
+  EXPECT_FALSE(col.SetStorageType(StorageType::kUInt8).ok());
+  EXPECT_OK(col.SetStorageType(StorageType::kUInt16));
+  EXPECT_EQ(col.memory_usage().first, 3 * sizeof(uint16_t));
+  EXPECT_EQ(col.value(1), 1000);
+
+  // Extracting a compact column gives a compact column.
+  col.SetNA(0);
+  VerticalDataset::CategoricalColumn extracted;
+  EXPECT_OK(col.ExtractAndAppend(std::vector<VerticalDataset::row_t>{2, 0},
+                                 &extracted));
+  EXPECT_EQ(extracted.storage_type(), StorageType::kUInt16);
+  EXPECT_EQ(extracted.value(0), 254);
+  EXPECT_TRUE(extracted.IsNa(1));
+}
+
 TEST(NumericalVectorSequence, Inspect) {
   VerticalDataset dataset;
   auto* col_spec = AddColumn("f1", proto::ColumnType::NUMERICAL_VECTOR_SEQUENCE,
@@ -1015,6 +1015,19 @@ dataset::LoadConfig OptimalDatasetLoadingConfig(
         link_config.weight_definition().attribute_idx());
   }
 
+  // The categorical input features are stored compactly. The label, group,
+  // treatment and weight columns (listed after the features in
+  // "load_columns") are not, as they are read as int32 values.
+  load_config.compact_columns.emplace();
+  for (const int feature : link_config.features()) {
+    if (std::find(load_config.load_columns->begin() +
+                      link_config.features_size(),
+                  load_config.load_columns->end(),
+                  feature) == load_config.load_columns->end()) {
+      load_config.compact_columns->push_back(feature);
+    }
+  }
+
   // Filter the examples with zero weight.
   if (link_config.has_weight_definition() &&
       link_config.weight_definition().has_numerical()) {
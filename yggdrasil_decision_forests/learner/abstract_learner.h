@@ -291,7 +291,8 @@ absl::Status CopyProblemDefinition(const proto::TrainingConfig& src,
                                    proto::TrainingConfig* dst);
 
 // Create a dataset loading configuration adapted to the training configuration
-// link. Skill unused features and examples with zero weights.
+// link. Skill unused features and examples with zero weights, and compact the
+// categorical input features.
 dataset::LoadConfig OptimalDatasetLoadingConfig(
     const proto::TrainingConfigLinking& link_config);
 
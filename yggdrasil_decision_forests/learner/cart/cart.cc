@@ -423,7 +423,7 @@ absl::Status PruneTreeClassification(
           .ColumnWithCastWithStatus<
               dataset::VerticalDataset::CategoricalColumn>(config_link.label())
           .value()
-          ->values();
+          ->int32_values();
 
   class AccuracyAccumulator {
    public:
@@ -504,14 +504,14 @@ absl::Status PruneTreeUpliftCategorical(
           .ColumnWithCastWithStatus<
               dataset::VerticalDataset::CategoricalColumn>(config_link.label())
           .value()
-          ->values();
+          ->int32_values();
 
   const auto& treatments = dataset
                                .ColumnWithCastWithStatus<
                                    dataset::VerticalDataset::CategoricalColumn>(
                                    config_link.uplift_treatment())
                                .value()
-                               ->values();
+                               ->int32_values();
 
   class UpliftAccumulator {
    public:
@@ -71,6 +71,16 @@ using test::EqualsProto;
 // Margin of error for numerical tests.
 constexpr float TEST_PRECISION = 0.000001f;
 
+// Creates a boolean column from kTrueValue, kFalseValue and kNaValue values.
+dataset::VerticalDataset::BooleanColumn MakeBooleanColumn(
+    const std::vector<int8_t>& values) {
+  dataset::VerticalDataset::BooleanColumn column;
+  for (const int8_t value : values) {
+    column.Add(value);
+  }
+  return column;
+}
+
 std::string DatasetDir() {
   return file::JoinPath(
       test::DataRootDirectory(),
@@ -1298,7 +1308,7 @@ TYPED_TEST(FindBestSplitTest, FindBestCategoricalSplitCartNumericalLabels) {
 TEST(DecisionTree, FindBestCategoricalSplitCartBooleanForClassification) {
   // Small basic dataset.
   const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3, 4, 5};
-  std::vector<int8_t> attributes = {0, 1, 0, 1, 0, 0};
+  const auto attributes = MakeBooleanColumn({0, 1, 0, 1, 0, 0});
   const std::vector<float> weights = {1, 1, 1, 1, 1, 1};
   const std::vector<int32_t> labels = {1, 0, 0, 0, 0, 1};
   const int32_t num_label_classes = 2;
@@ -1346,7 +1356,7 @@ TYPED_TEST(FindBestSplitTest,
            FindBestCategoricalSplitCartBooleanForRegression) {
   // Small basic dataset.
   const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3, 4, 5};
-  std::vector<int8_t> attributes = {0, 1, 0, 1, 0, 0};
+  const auto attributes = MakeBooleanColumn({0, 1, 0, 1, 0, 0});
   std::vector<float> weights;
   if constexpr (TestFixture::kWeighted) {
     weights = {1., 2., 3., 4., 5., 6.};
@@ -1551,7 +1561,7 @@ TEST(DecisionTree, LocalImputationForBooleanAttribute) {
   const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3, 4, 5};
   const std::vector<float> weights = {1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
   const int8_t na = dataset::VerticalDataset::BooleanColumn::kNaValue;
-  std::vector<int8_t> attributes = {0, 1, 0, 0, na, na};
+  auto attributes = MakeBooleanColumn({0, 1, 0, 0, na, na});
   const std::vector<int32_t> labels = {1, 1, 0, 0, 1, 0};
   const int32_t num_label_classes = 2;
 
@@ -1594,7 +1604,7 @@ TEST(DecisionTree, LocalImputationForBooleanAttribute) {
                 .value(),
             SplitSearchResult::kNoBetterSplitFound);
 
-  attributes = {1, 1, 1, 1, 1, 1};
+  attributes = MakeBooleanColumn({1, 1, 1, 1, 1, 1});
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, na_replacement, min_num_obs, dt_config,
@@ -1603,7 +1613,7 @@ TEST(DecisionTree, LocalImputationForBooleanAttribute) {
             SplitSearchResult::kInvalidAttribute);
 
   // Test majority positive case.
-  attributes = {1, 1, 1, 0, na, na};
+  attributes = MakeBooleanColumn({1, 1, 1, 0, na, na});
   proto::NodeCondition best_condition_pos_na;
   SplitterPerThreadCache cache_pos_na;
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
@@ -1707,12 +1717,12 @@ TEST(DecisionTree, GenerateRandomImputation) {
                    .MutableColumnWithCastWithStatus<
                        dataset::VerticalDataset::CategoricalColumn>(2)
                    .value()
-                   ->values() == std::vector<int>{1, 1, 2}) ||
+                   ->int32_values() == std::vector<int>{1, 1, 2}) ||
               (imputed
                    .MutableColumnWithCastWithStatus<
                        dataset::VerticalDataset::CategoricalColumn>(2)
                    .value()
-                   ->values() == std::vector<int>{1, 2, 2}));
+                   ->int32_values() == std::vector<int>{1, 2, 2}));
 }
 
 TEST(DecisionTree,
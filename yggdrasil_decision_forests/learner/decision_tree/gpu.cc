@@ -33,36 +33,9 @@
 #include "yggdrasil_decision_forests/dataset/types.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/vector_kernels.h"
 
 namespace yggdrasil_decision_forests::model::decision_tree::gpu {
-namespace {
-
-// Computes the dot product between two vectors.
-float DotProduct(int n, const float* __restrict a, const float* __restrict b) {
-  float acc = 0;
-  for (int i = 0; i < n; i++) {
-    acc += a[i] * b[i];
-  }
-  return acc;
-}
-
-// Computes the squared distance between two vectors. If the squared distance is
-// greater than "max_value", return a value greater than "max_value" (but not
-// necessary equal to the squared distance).
-float SquaredDistance(int n, const float* __restrict a,
-                      const float* __restrict b, float max_value) {
-  float acc = 0;
-  for (int i = 0; i < n; i++) {
-    const float v = a[i] - b[i];
-    acc += v * v;
-    if (acc >= max_value) {
-      return acc;
-    }
-  }
-  return acc;
-}
-
-}  // namespace
 
 absl::Status AddTwoVectorsCPU(absl::Span<const float> src_1,
                               absl::Span<const float> src_2,
@@ -154,24 +127,23 @@ absl::Status VectorSequenceComputer::ComputeMaxDotProductCPU(
   const auto* attribute = per_attributes_[attribute_idx].attribute;
   DCHECK(attribute);
   const int anchor_dim = attribute->vector_length();
-  for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++) {
-    size_t local_example_idx = selected_examples.size() * anchor_idx;
-    const auto anchor = anchors.subspan(anchor_idx * anchor_dim, anchor_dim);
-    for (const auto example_idx : selected_examples) {
-      float max_p = std::numeric_limits<float>::lowest();
-      if (ABSL_PREDICT_TRUE(!attribute->IsNa(example_idx))) {
-        const auto num_vectors = attribute->SequenceLength(example_idx);
-        for (int vector_idx = 0; vector_idx < num_vectors; vector_idx++) {
-          ASSIGN_OR_RETURN(const auto vector,
-                           attribute->GetVector(example_idx, vector_idx));
-          const float p =
-              DotProduct(vector.size(), vector.data(), anchor.data());
-          if (p > max_p) {
-            max_p = p;
-          }
-        }
-      }
-      dst[local_example_idx++] = max_p;
+  anchors = anchors.subspan(0, num_anchors * anchor_dim);
+  // Compares all the anchors to the vectors of one example at a time.
+  std::vector<float> example_dst(num_anchors);
+  for (size_t local_example_idx = 0;
+       local_example_idx < selected_examples.size(); local_example_idx++) {
+    const auto example_idx = selected_examples[local_example_idx];
+    if (ABSL_PREDICT_TRUE(!attribute->IsNa(example_idx))) {
+      ASSIGN_OR_RETURN(const auto vectors, attribute->GetVectors(example_idx));
+      utils::MaxDotProducts(vectors, anchors, anchor_dim,
+                            absl::MakeSpan(example_dst));
+    } else {
+      std::fill(example_dst.begin(), example_dst.end(),
+                std::numeric_limits<float>::lowest());
+    }
+    for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++) {
+      dst[selected_examples.size() * anchor_idx + local_example_idx] =
+          example_dst[anchor_idx];
     }
   }
   return absl::OkStatus();
@@ -185,26 +157,25 @@ absl::Status VectorSequenceComputer::ComputeNegMinSquareDistanceCPU(
   const auto* attribute = per_attributes_[attribute_idx].attribute;
   DCHECK(attribute);
   const int anchor_dim = attribute->vector_length();
-  for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++) {
-    size_t local_example_idx = selected_examples.size() * anchor_idx;
-    const auto anchor = anchors.subspan(anchor_idx * anchor_dim, anchor_dim);
-    for (const auto example_idx : selected_examples) {
-      float min_dist2 = std::numeric_limits<float>::max();
-      if (ABSL_PREDICT_TRUE(!attribute->IsNa(example_idx))) {
-        const auto num_vectors = attribute->SequenceLength(example_idx);
-        for (int vector_idx = 0; vector_idx < num_vectors; vector_idx++) {
-          ASSIGN_OR_RETURN(const auto vector,
-                           attribute->GetVector(example_idx, vector_idx));
-          const float dist2 = SquaredDistance(vector.size(), vector.data(),
-                                              anchor.data(), min_dist2);
-          if (dist2 < min_dist2) {
-            min_dist2 = dist2;
-          }
-        }
-      }
+  anchors = anchors.subspan(0, num_anchors * anchor_dim);
+  // Compares all the anchors to the vectors of one example at a time.
+  std::vector<float> example_dst(num_anchors);
+  for (size_t local_example_idx = 0;
+       local_example_idx < selected_examples.size(); local_example_idx++) {
+    const auto example_idx = selected_examples[local_example_idx];
+    if (ABSL_PREDICT_TRUE(!attribute->IsNa(example_idx))) {
+      ASSIGN_OR_RETURN(const auto vectors, attribute->GetVectors(example_idx));
+      utils::MinSquaredDistances(vectors, anchors, anchor_dim,
+                                 absl::MakeSpan(example_dst));
+    } else {
+      std::fill(example_dst.begin(), example_dst.end(),
+                std::numeric_limits<float>::max());
+    }
+    for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++) {
       // Note: We negate the values so the vector condition is in the same
       // "direction" as the underlying threshold condition.
-      dst[local_example_idx++] = -min_dist2;
+      dst[selected_examples.size() * anchor_idx + local_example_idx] =
+          -example_dst[anchor_idx];
     }
   }
   return absl::OkStatus();
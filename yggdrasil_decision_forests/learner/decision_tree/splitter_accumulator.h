@@ -384,7 +384,8 @@ struct FeatureCategoricalBucket {
   class Filler {
    public:
     Filler(const int num_categorical_values, const int na_replacement,
-           const std::vector<int32_t>& attributes)
+           const dataset::VerticalDataset::CategoricalColumn::Values&
+               attributes)
         : num_categorical_values_(num_categorical_values),
           na_replacement_(na_replacement),
           attributes_(attributes) {}
@@ -474,7 +475,7 @@ struct FeatureCategoricalBucket {
    private:
     int num_categorical_values_;
     int na_replacement_;
-    const std::vector<int32_t>& attributes_;
+    const dataset::VerticalDataset::CategoricalColumn::Values attributes_;
   };
 
   friend std::ostream& operator<<(std::ostream& os,
@@ -509,7 +510,7 @@ struct FeatureBooleanBucket {
   class Filler {
    public:
     explicit Filler(const bool na_replacement,
-                    const std::vector<int8_t>& attributes)
+                    const dataset::VerticalDataset::BooleanColumn& attributes)
         : na_replacement_(na_replacement), attributes_(attributes) {}
 
     size_t NumBuckets() const { return 2; }
@@ -519,10 +520,8 @@ struct FeatureBooleanBucket {
 
     size_t GetBucketIndex(const size_t local_example_idx,
                           const UnsignedExampleIdx example_idx) const {
-      const auto attribute = attributes_[example_idx];
-      return (attribute == dataset::VerticalDataset::BooleanColumn::kNaValue)
-                 ? na_replacement_
-                 : attribute;
+      return attributes_.IsNa(example_idx) ? na_replacement_
+                                           : attributes_.IsTrue(example_idx);
     }
 
     void ConsumeExample(const UnsignedExampleIdx example_idx,
@@ -538,7 +537,7 @@ struct FeatureBooleanBucket {
 
    private:
     const bool na_replacement_;
-    const std::vector<int8_t>& attributes_;
+    const dataset::VerticalDataset::BooleanColumn& attributes_;
   };
 
   friend std::ostream& operator<<(std::ostream& os,
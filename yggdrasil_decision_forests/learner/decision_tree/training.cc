@@ -182,7 +182,8 @@ void LocalImputationForNumericalAttribute(
 // attribute. Return the most frequent attribute value.
 void LocalImputationForCategoricalAttribute(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const int32_t num_attribute_classes, int32_t* na_replacement) {
   utils::IntegerDistributionDouble attribute_distribution;
   attribute_distribution.SetNumClasses(num_attribute_classes);
@@ -203,16 +204,16 @@ void LocalImputationForCategoricalAttribute(
 // attribute. Returns the most frequent attribute value.
 void LocalImputationForBooleanAttribute(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     bool* na_replacement) {
   DCHECK(!weights.empty());
   utils::IntegerDistributionDouble attribute_distribution;
   attribute_distribution.SetNumClasses(2);
   for (const auto example_idx : selected_examples) {
-    const auto attribute_value = attributes[example_idx];
-    if (attribute_value != dataset::VerticalDataset::BooleanColumn::kNaValue) {
+    if (!attributes.IsNa(example_idx)) {
       const float weight = weights.empty() ? 1.f : weights[example_idx];
-      attribute_distribution.Add(attribute_value, weight);
+      attribute_distribution.Add(attributes.IsTrue(example_idx), weight);
     }
   }
   if (attribute_distribution.NumObservations() > 0) {
@@ -524,7 +525,7 @@ absl::StatusOr<SplitSearchResult> FindBestConditionClassification(
           attribute_column_spec.boolean().count_false();
       ASSIGN_OR_RETURN(
           result, FindSplitLabelClassificationFeatureBoolean(
-                      selected_examples, weights, attribute_data->values(),
+                      selected_examples, weights, *attribute_data,
                       label_stats.label_data, label_stats.num_label_classes,
                       na_replacement, min_num_obs, dt_config,
                       label_stats.label_distribution, attribute_idx,
@@ -730,7 +731,7 @@ absl::StatusOr<SplitSearchResult> FindBestConditionRegressionHessianGain(
         ASSIGN_OR_RETURN(
             result,
             FindSplitLabelHessianRegressionFeatureBoolean</*weighted=*/false>(
-                selected_examples, weights, attribute_data->values(),
+                selected_examples, weights, *attribute_data,
                 label_stats.gradient_data, label_stats.hessian_data,
                 na_replacement, min_num_obs, dt_config,
                 label_stats.sum_gradient, label_stats.sum_hessian,
@@ -740,7 +741,7 @@ absl::StatusOr<SplitSearchResult> FindBestConditionRegressionHessianGain(
         ASSIGN_OR_RETURN(
             result,
             FindSplitLabelHessianRegressionFeatureBoolean</*weighted=*/true>(
-                selected_examples, weights, attribute_data->values(),
+                selected_examples, weights, *attribute_data,
                 label_stats.gradient_data, label_stats.hessian_data,
                 na_replacement, min_num_obs, dt_config,
                 label_stats.sum_gradient, label_stats.sum_hessian,
@@ -987,14 +988,14 @@ absl::StatusOr<SplitSearchResult> FindBestConditionRegression(
       if (weights.empty()) {
         ASSIGN_OR_RETURN(
             result, FindSplitLabelRegressionFeatureBoolean</*weighted=*/false>(
-                        selected_examples, weights, attribute_data->values(),
+                        selected_examples, weights, *attribute_data,
                         label_stats.label_data, na_replacement, min_num_obs,
                         dt_config, label_stats.label_distribution,
                         attribute_idx, best_condition, cache));
       } else {
         ASSIGN_OR_RETURN(
             result, FindSplitLabelRegressionFeatureBoolean</*weighted=*/true>(
-                        selected_examples, weights, attribute_data->values(),
+                        selected_examples, weights, *attribute_data,
                         label_stats.label_data, na_replacement, min_num_obs,
                         dt_config, label_stats.label_distribution,
                         attribute_idx, best_condition, cache));
@@ -1799,7 +1800,7 @@ absl::StatusOr<bool> FindBestCondition(
                        train_dataset.ColumnWithCastWithStatus<
                            dataset::VerticalDataset::CategoricalColumn>(
                            config_link.label()));
-      ClassificationLabelStats label_stat(labels->values());
+      ClassificationLabelStats label_stat(labels->int32_values());
 
       const auto& label_column_spec =
           train_dataset.data_spec().columns(config_link.label());
@@ -1884,9 +1885,9 @@ absl::StatusOr<bool> FindBestCondition(
                            config_link.uplift_treatment()));
 
       CategoricalUpliftLabelStats label_stat(
-          labels->values(),
+          labels->int32_values(),
           outcome_spec.categorical().number_of_unique_values(),
-          treatments->values(),
+          treatments->int32_values(),
           treatment_spec.categorical().number_of_unique_values());
 
       UpliftLeafToLabelDist(parent.uplift(), &label_stat.label_distribution);
@@ -1913,7 +1914,7 @@ absl::StatusOr<bool> FindBestCondition(
                            config_link.uplift_treatment()));
 
       NumericalUpliftLabelStats label_stat(
-          labels->values(), treatments->values(),
+          labels->values(), treatments->int32_values(),
           treatment_spec.categorical().number_of_unique_values());
 
       UpliftLeafToLabelDist(parent.uplift(), &label_stat.label_distribution);
@@ -2729,7 +2730,8 @@ absl::StatusOr<SplitSearchResult> FindSplitLabelHessianRegressionFeatureNA(
 
 absl::StatusOr<SplitSearchResult> FindSplitLabelClassificationFeatureBoolean(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<int32_t>& labels, const int32_t num_label_classes,
     bool na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -2799,7 +2801,8 @@ absl::StatusOr<SplitSearchResult> FindSplitLabelClassificationFeatureBoolean(
 template <bool weighted>
 absl::StatusOr<SplitSearchResult> FindSplitLabelRegressionFeatureBoolean(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<float>& labels, bool na_replacement,
     UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -2831,7 +2834,8 @@ absl::StatusOr<SplitSearchResult> FindSplitLabelRegressionFeatureBoolean(
 template absl::StatusOr<SplitSearchResult>
 FindSplitLabelRegressionFeatureBoolean<true>(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<float>& labels, bool na_replacement,
     UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -2841,7 +2845,8 @@ FindSplitLabelRegressionFeatureBoolean<true>(
 template absl::StatusOr<SplitSearchResult>
 FindSplitLabelRegressionFeatureBoolean<false>(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<float>& labels, bool na_replacement,
     UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -2852,7 +2857,8 @@ FindSplitLabelRegressionFeatureBoolean<false>(
 template <bool weighted>
 absl::StatusOr<SplitSearchResult> FindSplitLabelHessianRegressionFeatureBoolean(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<float>& gradients, const std::vector<float>& hessians,
     bool na_replacement, const UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -2892,7 +2898,8 @@ template <bool weighted>
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelHessianRegressionFeatureCategorical(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<float>& gradients, const std::vector<float>& hessians,
     const int32_t num_attribute_classes, int32_t na_replacement,
     const UnsignedExampleIdx min_num_obs,
@@ -2955,7 +2962,8 @@ FindSplitLabelHessianRegressionFeatureCategorical(
 template <bool weighted>
 absl::StatusOr<SplitSearchResult> FindSplitLabelRegressionFeatureCategorical(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<float>& labels, const int32_t num_attribute_classes,
     int32_t na_replacement, const UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -3418,7 +3426,8 @@ template <typename LabelBucket, typename ExampleBucketSet,
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelClassificationFeatureCategorical(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<int32_t>& labels, int32_t num_attribute_classes,
     int32_t num_label_classes, int32_t na_replacement,
     UnsignedExampleIdx min_num_obs,
@@ -3593,7 +3602,8 @@ FindSplitLabelClassificationFeatureCategorical(
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelClassificationFeatureCategorical(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<int32_t>& labels, int32_t num_attribute_classes,
     int32_t num_label_classes, int32_t na_replacement,
     UnsignedExampleIdx min_num_obs,
@@ -3720,7 +3730,8 @@ FindSplitLabelUpliftNumericalFeatureNumericalCart(
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelUpliftCategoricalFeatureCategorical(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const CategoricalUpliftLabelStats& label_stats, int num_attribute_classes,
     int32_t na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config, int32_t attribute_idx,
@@ -3775,7 +3786,8 @@ FindSplitLabelUpliftCategoricalFeatureCategorical(
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelUpliftNumericalFeatureCategorical(
     const absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const NumericalUpliftLabelStats& label_stats, int num_attribute_classes,
     int32_t na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config, int32_t attribute_idx,
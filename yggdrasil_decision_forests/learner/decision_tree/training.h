@@ -451,7 +451,8 @@ absl::StatusOr<SplitSearchResult> FindSplitLabelHessianRegressionFeatureNA(
 // Search for the best split of the type Boolean for classification.
 absl::StatusOr<SplitSearchResult> FindSplitLabelClassificationFeatureBoolean(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<int32_t>& labels, int32_t num_label_classes,
     bool na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -463,7 +464,8 @@ absl::StatusOr<SplitSearchResult> FindSplitLabelClassificationFeatureBoolean(
 template <bool weighted>
 absl::StatusOr<SplitSearchResult> FindSplitLabelRegressionFeatureBoolean(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<float>& labels, bool na_replacement,
     UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -474,7 +476,8 @@ absl::StatusOr<SplitSearchResult> FindSplitLabelRegressionFeatureBoolean(
 template <bool weighted>
 absl::StatusOr<SplitSearchResult> FindSplitLabelHessianRegressionFeatureBoolean(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int8_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::BooleanColumn& attributes,
     const std::vector<float>& gradients, const std::vector<float>& hessians,
     bool na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config, double sum_gradient,
@@ -657,7 +660,8 @@ FindSplitLabelRegressionFeatureDiscretizedNumericalCart(
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelClassificationFeatureCategorical(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<int32_t>& labels, int32_t num_attribute_classes,
     int32_t num_label_classes, int32_t na_replacement,
     UnsignedExampleIdx min_num_obs,
@@ -674,7 +678,8 @@ FindSplitLabelClassificationFeatureCategorical(
 template <bool weighted>
 absl::StatusOr<SplitSearchResult> FindSplitLabelRegressionFeatureCategorical(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<float>& labels, int32_t num_attribute_classes,
     int32_t na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
@@ -686,7 +691,8 @@ template <bool weighted>
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelHessianRegressionFeatureCategorical(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const std::vector<float>& gradients, const std::vector<float>& hessians,
     int32_t num_attribute_classes, int32_t na_replacement,
     UnsignedExampleIdx min_num_obs,
@@ -778,7 +784,8 @@ FindSplitLabelUpliftNumericalFeatureNumericalCart(
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelUpliftCategoricalFeatureCategorical(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const CategoricalUpliftLabelStats& label_stats, int num_attribute_classes,
     int32_t na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config, int32_t attribute_idx,
@@ -790,7 +797,8 @@ FindSplitLabelUpliftCategoricalFeatureCategorical(
 absl::StatusOr<SplitSearchResult>
 FindSplitLabelUpliftNumericalFeatureCategorical(
     absl::Span<const UnsignedExampleIdx> selected_examples,
-    const std::vector<float>& weights, const std::vector<int32_t>& attributes,
+    const std::vector<float>& weights,
+    const dataset::VerticalDataset::CategoricalColumn::Values& attributes,
     const NumericalUpliftLabelStats& label_stats, int num_attribute_classes,
     int32_t na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config, int32_t attribute_idx,
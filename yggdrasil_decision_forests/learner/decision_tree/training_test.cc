@@ -376,7 +376,7 @@ TEST(SparseOblique, Classification) {
   const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3};
   const std::vector<float> weights = {1.f, 1.f, 1.f, 1.f};
 
-  ClassificationLabelStats label_stats(label_data->values());
+  ClassificationLabelStats label_stats(label_data->int32_values());
   label_stats.num_label_classes = 3;
   label_stats.label_distribution.SetNumClasses(3);
   for (const auto example_idx : selected_examples) {
@@ -438,7 +438,7 @@ TEST(SparseOblique, ClassificationMaxNumFeatures) {
   const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3};
   const std::vector<float> weights = {1.f, 1.f, 1.f, 1.f};
 
-  ClassificationLabelStats label_stats(label_data->values());
+  ClassificationLabelStats label_stats(label_data->int32_values());
   label_stats.num_label_classes = 3;
   label_stats.label_distribution.SetNumClasses(3);
   for (const auto example_idx : selected_examples) {
@@ -499,7 +499,7 @@ TEST(MHLDTOblique, Classification) {
   std::iota(selected_examples.begin(), selected_examples.end(), 0);
   const std::vector<float> weights(selected_examples.size(), 1.f);
 
-  ClassificationLabelStats label_stats(label_data->values());
+  ClassificationLabelStats label_stats(label_data->int32_values());
   label_stats.num_label_classes = 3;
   label_stats.label_distribution.SetNumClasses(3);
   for (const auto example_idx : selected_examples) {
@@ -549,7 +549,7 @@ TEST(MHLDTOblique, Classification_Again) {
   std::iota(selected_examples.begin(), selected_examples.end(), 0);
   const std::vector<float> weights(selected_examples.size(), 1.f);
 
-  ClassificationLabelStats label_stats(label_data->values());
+  ClassificationLabelStats label_stats(label_data->int32_values());
   label_stats.num_label_classes = 3;
   label_stats.label_distribution.SetNumClasses(3);
   for (const auto example_idx : selected_examples) {
@@ -614,7 +614,7 @@ TEST(MHLDTOblique, LDACache) {
 
   internal::LDACache cache;
   ASSERT_OK(cache.ComputeClassification(dt_config, proj, {1, 2}, 3,
-                                        label_data->values(), weights));
+                                        label_data->int32_values(), weights));
 
   std::vector<int> mapping;
   ASSERT_OK(cache.BuildMapping({2}, &mapping));
@@ -693,7 +693,7 @@ TEST(VectorSequenceCondition, Classification) {
   std::iota(selected_examples.begin(), selected_examples.end(), 0);
   const std::vector<float> weights(selected_examples.size(), 1.f);
 
-  ClassificationLabelStats label_stats(label_col->values());
+  ClassificationLabelStats label_stats(label_col->int32_values());
   label_stats.num_label_classes = 3;
   label_stats.label_distribution.SetNumClasses(3);
   for (const auto example_idx : selected_examples) {
@@ -133,15 +133,10 @@ absl::Status SeparateCategoricalColumn(
   size_t begin = 0;
   while (begin < values.size()) {
     const auto num = std::min(values.size() - begin, buffer.size());
-    std::transform(values.begin() + begin, values.begin() + begin + num,
-                   buffer.begin(),
-                   [missing_value_replacement](int32_t value) -> int32_t {
-                     if (value < 0) {
-                       return missing_value_replacement;
-                     } else {
-                       return value;
-                     }
-                   });
+    for (size_t i = 0; i < num; i++) {
+      const int32_t value = values[begin + i];
+      buffer[i] = value < 0 ? missing_value_replacement : value;
+    }
     RETURN_IF_ERROR(
         writer.WriteValues<int32_t>(absl::Span<int32_t>(buffer.data(), num)));
     begin += num;
@@ -179,25 +174,16 @@ absl::Status SeparateBooleanColumn(const int column_idx,
       const auto& column,
       dataset.ColumnWithCastWithStatus<dataset::VerticalDataset::BooleanColumn>(
           column_idx));
-  const auto& values = column->values();
-
   const int8_t missing_value_replacement =
       column_spec.boolean().count_true() >= column_spec.boolean().count_false();
   std::vector<int8_t> buffer(kIOBufferSizeInBytes / sizeof(int8_t));
   size_t begin = 0;
-  while (begin < values.size()) {
-    const auto num = std::min(values.size() - begin, buffer.size());
-    std::transform(
-        values.begin() + begin, values.begin() + begin + num, buffer.begin(),
-        [missing_value_replacement](char value) -> int8_t {
-          DCHECK_GE(value, 0);
-          DCHECK_LT(value, 3);
-          if (value == dataset::VerticalDataset::BooleanColumn::kNaValue) {
-            return missing_value_replacement;
-          } else {
-            return value;
-          }
-        });
+  while (begin < column->nrows()) {
+    const auto num = std::min<size_t>(column->nrows() - begin, buffer.size());
+    for (size_t i = 0; i < num; i++) {
+      buffer[i] = column->IsNa(begin + i) ? missing_value_replacement
+                                          : column->IsTrue(begin + i);
+    }
     RETURN_IF_ERROR(
         writer.WriteValues<int8_t>(absl::Span<int8_t>(buffer.data(), num)));
     begin += num;
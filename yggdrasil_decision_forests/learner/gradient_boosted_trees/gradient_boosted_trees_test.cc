@@ -407,10 +407,11 @@ TEST(GradientBoostedTrees, ExtractValidationDatasetWithGroup) {
           .value();
 
   // Ensure the intersection of the groups is empty.
-  absl::btree_set<int> train_group_values(train_group->values().begin(),
-                                          train_group->values().end());
+  absl::btree_set<int> train_group_values(train_group->int32_values().begin(),
+                                          train_group->int32_values().end());
   absl::btree_set<int> validation_group_values(
-      validation_group->values().begin(), validation_group->values().end());
+      validation_group->int32_values().begin(),
+      validation_group->int32_values().end());
   std::vector<int> group_intersection;
   std::set_intersection(train_group_values.begin(), train_group_values.end(),
                         validation_group_values.begin(),
@@ -76,12 +76,13 @@ BinomialLogLikelihoodLoss::InitialPredictions(
   if (weights.empty()) {
     sum_weights = static_cast<double>(n);
     weighted_sum_positive = static_cast<double>(
-        std::count(labels->values().begin(), labels->values().end(), 2));
+        std::count(labels->int32_values().begin(),
+                   labels->int32_values().end(), 2));
   } else {
     for (UnsignedExampleIdx example_idx = 0; example_idx < n; example_idx++) {
       sum_weights += weights[example_idx];
       weighted_sum_positive +=
-          weights[example_idx] * (labels->values()[example_idx] == 2);
+          weights[example_idx] * (labels->value(example_idx) == 2);
     }
   }
   STATUS_CHECK_GT(sum_weights, 0);
@@ -56,7 +56,7 @@ CustomBinaryClassificationLoss::InitialPredictions(
   DCHECK_EQ(weights.size(), labels->nrows());
   DCHECK_EQ(label_column_.categorical().number_of_unique_values(), 3);
 
-  auto labels_span = absl::MakeConstSpan(labels->values());
+  auto labels_span = absl::MakeConstSpan(labels->int32_values());
   auto weights_span = absl::MakeConstSpan(weights);
 
   ASSIGN_OR_RETURN(
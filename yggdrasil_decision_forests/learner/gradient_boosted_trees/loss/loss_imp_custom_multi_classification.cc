@@ -64,7 +64,7 @@ CustomMultiClassificationLoss::InitialPredictions(
           dataset::VerticalDataset::CategoricalColumn>(label_col_idx));
   DCHECK_EQ(weights.size(), labels->nrows());
 
-  auto labels_span = absl::MakeConstSpan(labels->values());
+  auto labels_span = absl::MakeConstSpan(labels->int32_values());
   auto weights_span = absl::MakeConstSpan(weights);
   std::vector<float> initial_predictions(dimension_);
 
@@ -56,7 +56,7 @@ absl::Status AbstractLoss::UpdateGradients(
       dataset.ColumnWithCastOrNull<dataset::VerticalDataset::CategoricalColumn>(
           label_col_idx);
   if (categorical_labels) {
-    return UpdateGradients(categorical_labels->values(), predictions,
+    return UpdateGradients(categorical_labels->int32_values(), predictions,
                            ranking_index, &compact_gradient, random,
                            thread_pool);
   }
@@ -85,7 +85,7 @@ absl::StatusOr<LossResults> AbstractLoss::Loss(
       dataset.ColumnWithCastOrNull<dataset::VerticalDataset::CategoricalColumn>(
           label_col_idx);
   if (categorical_labels) {
-    return Loss(categorical_labels->values(), predictions, weights,
+    return Loss(categorical_labels->int32_values(), predictions, weights,
                 ranking_index, thread_pool);
   }
 
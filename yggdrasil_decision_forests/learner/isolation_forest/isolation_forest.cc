@@ -26,6 +26,7 @@
 #include <optional>
 #include <random>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -129,14 +130,20 @@ absl::StatusOr<bool> CanSplit(
   ASSIGN_OR_RETURN(const T* value_container,
                    train_dataset.ColumnWithCastWithStatus<T>(feature_idx));
   DCHECK_GT(selected_examples.size(), 1);
-  const auto& values = value_container->values();
-  float first_example = value_container->IsNa(selected_examples[0])
-                            ? na_replacement
-                            : values[selected_examples[0]];
+  using NumericalColumn = dataset::VerticalDataset::NumericalColumn;
+  const auto get_value = [&](const UnsignedExampleIdx example_idx) -> float {
+    if (value_container->IsNa(example_idx)) {
+      return na_replacement;
+    }
+    if constexpr (std::is_same_v<T, NumericalColumn>) {
+      return value_container->values()[example_idx];
+    } else {
+      return value_container->value(example_idx);
+    }
+  };
+  const float first_example = get_value(selected_examples[0]);
   for (const auto example_idx : selected_examples) {
-    float current_example = value_container->IsNa(example_idx)
-                                ? na_replacement
-                                : values[example_idx];
+    const float current_example = get_value(example_idx);
     if (first_example != current_example) {
       return true;
     }
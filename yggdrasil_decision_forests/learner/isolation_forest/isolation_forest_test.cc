@@ -388,7 +388,9 @@ TEST(FindSplit, Boolean) {
     ASSERT_OK_AND_ASSIGN(auto* column,
                          dataset.MutableColumnWithCastWithStatus<
                              dataset::VerticalDataset::BooleanColumn>(0));
-    *column->mutable_values() = {0, 1, 2, 0};
+    for (const int value : {0, 1, 2, 0}) {
+      column->Add(value);
+    }
 
     ASSERT_OK_AND_ASSIGN(
         const bool found_condition,
@@ -424,7 +426,9 @@ TEST(FindSplit, BooleanNAReplacement) {
     ASSERT_OK_AND_ASSIGN(auto* column,
                          dataset.MutableColumnWithCastWithStatus<
                              dataset::VerticalDataset::BooleanColumn>(0));
-    *column->mutable_values() = {0, 0, 1, 2};
+    for (const int value : {0, 0, 1, 2}) {
+      column->Add(value);
+    }
     dataset.mutable_data_spec()
         ->mutable_columns(0)
         ->mutable_boolean()
@@ -492,7 +496,9 @@ TEST(FindSplit, Categorical) {
     ASSERT_OK_AND_ASSIGN(auto* column,
                          dataset.MutableColumnWithCastWithStatus<
                              dataset::VerticalDataset::CategoricalColumn>(0));
-    *column->mutable_values() = {0, 1, 2, 2, 0};
+    for (const int value : {0, 1, 2, 2, 0}) {
+      column->Add(value);
+    }
 
     ASSERT_OK_AND_ASSIGN(
         const bool found_condition,
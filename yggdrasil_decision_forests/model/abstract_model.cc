@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <random>
 #include <string>
 #include <utility>
 #include <vector>
@@ -36,6 +37,8 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
@@ -87,6 +90,101 @@ absl::Status CheckCompatibleEvaluationTask(const proto::Task model_task,
       proto::Task_Name(model_task), proto::Task_Name(evaluation_task)));
 }
 
+// Generates "num_examples" examples with random input feature values sampled
+// according to the dataspec. Non-input features are missing.
+absl::StatusOr<dataset::VerticalDataset> GenerateSyntheticExamples(
+    const dataset::proto::DataSpecification& data_spec,
+    const std::vector<int>& input_features, const int num_examples) {
+  dataset::VerticalDataset dataset;
+  dataset.set_data_spec(data_spec);
+  RETURN_IF_ERROR(dataset.CreateColumnsFromDataspec());
+
+  utils::RandomEngine random(1234);
+  dataset::proto::Example example;
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    example.clear_attributes();
+    for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
+      example.add_attributes();
+    }
+    for (const int col_idx : input_features) {
+      const auto& col_spec = data_spec.columns(col_idx);
+      auto* attribute = example.mutable_attributes(col_idx);
+      switch (col_spec.type()) {
+        case dataset::proto::ColumnType::NUMERICAL: {
+          const float min_value = col_spec.numerical().min_value();
+          const float max_value = col_spec.numerical().max_value();
+          if (!(min_value <= max_value)) {
+            return absl::InvalidArgumentError(absl::Substitute(
+                "The numerical column \"$0\" has a minimum value ($1) "
+                "greater than its maximum value ($2) in the dataspec",
+                col_spec.name(), min_value, max_value));
+          }
+          std::uniform_real_distribution<float> dist(min_value, max_value);
+          attribute->set_numerical(dist(random));
+        } break;
+        case dataset::proto::ColumnType::CATEGORICAL:
+          attribute->set_categorical(utils::RandomUniformInt<int64_t>(
+              std::max<int64_t>(
+                  1, col_spec.categorical().number_of_unique_values()),
+              &random));
+          break;
+        case dataset::proto::ColumnType::BOOLEAN:
+          attribute->set_boolean(utils::RandomUniformInt(2, &random) == 1);
+          break;
+        case dataset::proto::ColumnType::DISCRETIZED_NUMERICAL:
+          attribute->set_discretized_numerical(utils::RandomUniformInt(
+              col_spec.discretized_numerical().boundaries_size() + 1,
+              &random));
+          break;
+        default:
+          // Other types are left missing.
+          break;
+      }
+    }
+    RETURN_IF_ERROR(dataset.AppendExampleWithStatus(example));
+  }
+  return dataset;
+}
+
+// Measures the duration of the fastest of "num_runs" runs of "engine" over
+// "examples", after one warmup run.
+absl::StatusOr<absl::Duration> BenchmarkFastEngine(
+    const serving::FastEngine& engine, const dataset::VerticalDataset& examples,
+    const FastEngineAutotuneOptions& options) {
+  const int64_t num_examples = examples.nrow();
+  const int batch_size =
+      std::max<int64_t>(1, std::min<int64_t>(options.batch_size, num_examples));
+
+  // Convert the examples once, outside of the timed section.
+  std::vector<std::unique_ptr<serving::AbstractExampleSet>> batches;
+  for (int64_t begin = 0; begin < num_examples; begin += batch_size) {
+    const int64_t end = std::min<int64_t>(begin + batch_size, num_examples);
+    auto batch = engine.AllocateExamples(batch_size);
+    RETURN_IF_ERROR(serving::CopyVerticalDatasetToAbstractExampleSet(
+        examples, begin, end, engine.features(), batch.get()));
+    batches.push_back(std::move(batch));
+  }
+
+  std::vector<float> predictions;
+  const auto run = [&]() {
+    for (int batch_idx = 0; batch_idx < batches.size(); batch_idx++) {
+      const int64_t begin = batch_idx * batch_size;
+      const int num_batch_examples =
+          std::min<int64_t>(begin + batch_size, num_examples) - begin;
+      engine.Predict(*batches[batch_idx], num_batch_examples, &predictions);
+    }
+  };
+
+  run();  // Warmup.
+  absl::Duration best_duration = absl::InfiniteDuration();
+  for (int run_idx = 0; run_idx < std::max(1, options.num_runs); run_idx++) {
+    const auto start = absl::Now();
+    run();
+    best_duration = std::min(best_duration, absl::Now() - start);
+  }
+  return best_duration;
+}
+
 }  // namespace
 
 void AbstractModel::ExportProto(const AbstractModel& model,
@@ -1426,8 +1524,22 @@ AbstractModel::BuildFastEngine(
           name()));
     }
 
+    // Select the engine chosen by "AutotuneFastEngine", if still
+    // compatible.
+    const auto& preferred_engine = metadata_.preferred_fast_engine();
+    if (!preferred_engine.empty()) {
+      for (auto& compatible_engine : sorted_compatible_engines) {
+        if (compatible_engine->name() == preferred_engine) {
+          engine_factory = std::move(compatible_engine);
+          break;
+        }
+      }
+    }
+
     // Select the best engine.
-    engine_factory = std::move(sorted_compatible_engines.front());
+    if (!engine_factory) {
+      engine_factory = std::move(sorted_compatible_engines.front());
+    }
   }
 
   auto engine_or = engine_factory->CreateEngine(this);
@@ -1443,6 +1555,72 @@ AbstractModel::BuildFastEngine(
   return engine_or;
 }
 
+absl::StatusOr<std::string> AbstractModel::AutotuneFastEngine(
+    const FastEngineAutotuneOptions& options) {
+  if (!allow_fast_engine_) {
+    return absl::NotFoundError("allow_fast_engine is set to false.");
+  }
+  if (options.batch_size <= 0) {
+    return absl::InvalidArgumentError("The batch size should be positive.");
+  }
+
+  const dataset::VerticalDataset* examples = options.examples;
+  dataset::VerticalDataset synthetic_examples;
+  if (examples == nullptr) {
+    ASSIGN_OR_RETURN(
+        synthetic_examples,
+        GenerateSyntheticExamples(data_spec_, input_features_,
+                                  std::max(1, options.num_synthetic_examples)));
+    examples = &synthetic_examples;
+  }
+  if (examples->nrow() == 0) {
+    return absl::InvalidArgumentError("No examples to benchmark the engines.");
+  }
+
+  std::shared_ptr<utils::concurrency::ThreadPool> thread_pool;
+  if (options.num_threads > 1) {
+    thread_pool = std::make_shared<utils::concurrency::ThreadPool>(
+        options.num_threads - 1);
+    thread_pool->StartWorkers();
+  }
+
+  std::string best_engine;
+  absl::Duration best_duration = absl::InfiniteDuration();
+  for (const auto& factory : ListCompatibleFastEngines()) {
+    auto engine_or = factory->CreateEngine(this);
+    if (!engine_or.ok()) {
+      LOG(INFO) << "The engine \"" << factory->name()
+                << "\" is compatible but could not be created: "
+                << engine_or.status().message();
+      continue;
+    }
+    auto& engine = engine_or.value();
+    if (thread_pool) {
+      engine->SetParallelOptions({.thread_pool = thread_pool});
+    }
+    ASSIGN_OR_RETURN(const auto duration,
+                     BenchmarkFastEngine(*engine, *examples, options));
+    LOG(INFO) << "Engine \"" << factory->name() << "\": "
+              << absl::FormatDuration(duration / examples->nrow())
+              << " / example";
+    if (duration < best_duration) {
+      best_duration = duration;
+      best_engine = factory->name();
+    }
+  }
+
+  if (best_engine.empty()) {
+    return absl::NotFoundError(
+        absl::Substitute("No compatible engine available for model $0",
+                         name()));
+  }
+  LOG(INFO) << "Fastest engine: \"" << best_engine << "\"";
+  if (options.save_in_metadata) {
+    metadata_.set_preferred_fast_engine(best_engine);
+  }
+  return best_engine;
+}
+
 std::optional<size_t> AbstractModel::AbstractAttributesSizeInBytes() const {
   if (!utils::ProtoSizeInBytesIsAvailable()) {
     return {};
@@ -58,6 +58,36 @@ struct ModelIOOptions {
   // auto-detected (if possible) based on the existing files in the given
   // directory.
   std::optional<std::string> file_prefix;
+
+  // Number of threads used to load the model. Only used by the formats that
+  // support parallel loading (e.g. the "BLOB_SEQUENCE_INDEXED_GZIP" node
+  // format of the decision forests).
+  int num_threads = 6;
+};
+
+// Options of "AbstractModel::AutotuneFastEngine".
+struct FastEngineAutotuneOptions {
+  // Examples used to benchmark the engines. If null, "num_synthetic_examples"
+  // examples are sampled from the dataspec.
+  const dataset::VerticalDataset* examples = nullptr;
+  int num_synthetic_examples = 1000;
+
+  // Number of examples in each call to "FastEngine::Predict".
+  int batch_size = 100;
+
+  // Number of threads used by the engines (see
+  // "FastEngine::SetParallelOptions"). If 1, the engines run in the calling
+  // thread.
+  int num_threads = 1;
+
+  // Number of timed runs over the examples, after one warmup run. The
+  // duration of an engine is the duration of its fastest run.
+  int num_runs = 5;
+
+  // If true, the name of the fastest engine is stored in the model metadata
+  // (see "MetaData::preferred_fast_engine"), and the following calls to
+  // "BuildFastEngine" create this engine.
+  bool save_in_metadata = true;
 };
 
 class AbstractModel {
@@ -98,11 +128,19 @@ class AbstractModel {
   // than selecting directly the inference engine at compile time.
   //
   // If specified, "force_engine_name" is the name of the created engine.
-  // If "force_engine_name" is not specified, create the fastest compatible
-  // engine.
+  // If "force_engine_name" is not specified, create the engine selected by
+  // "AutotuneFastEngine" (if any and still compatible), or the compatible
+  // engine with the best expected speed.
   absl::StatusOr<std::unique_ptr<serving::FastEngine>> BuildFastEngine(
       const std::optional<std::string>& force_engine_name = {}) const;
 
+  // Benchmarks all the compatible fast engines, and returns the name of the
+  // fastest one. Unlike the static ordering of "ListCompatibleFastEngines",
+  // the measure accounts for the model structure (e.g. tree depth, number of
+  // features), the batch size and the number of threads.
+  absl::StatusOr<std::string> AutotuneFastEngine(
+      const FastEngineAutotuneOptions& options = {});
+
   // Lists the fast engines compatible with the model.
   // Engines are sorted by decreasing expected speed i.e., for the fastest
   // inference, use the first one.
@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -27,6 +28,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/metric/metric.h"
@@ -169,6 +171,27 @@ class EngineFactory2 : public model::FastEngineFactory {
 
 REGISTER_FastEngineFactory(EngineFactory2, "engine2");
 
+// An engine factory compatible with none of the models.
+class EngineFactory3 : public model::FastEngineFactory {
+ public:
+  std::string name() const override { return "engine3"; }
+
+  bool IsCompatible(const AbstractModel* const model) const override {
+    return false;
+  }
+
+  std::vector<std::string> IsBetterThan() const override {
+    return {"engine1", "engine2"};
+  }
+
+  absl::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
+      const AbstractModel* const model) const override {
+    return absl::InvalidArgumentError("Not compatible.");
+  }
+};
+
+REGISTER_FastEngineFactory(EngineFactory3, "engine3");
+
 class FakeModelWithoutEngine : public FakeModel {
  public:
   FakeModelWithoutEngine() : FakeModel() {}
@@ -291,6 +314,72 @@ TEST(AbstractModel, BuildFastEngine) {
   EXPECT_TRUE(dynamic_cast<const Engine2*>(engine) != nullptr);
 }
 
+TEST(AbstractModel, BuildFastEngineWithPreferredEngine) {
+  FakeModelWithEngine model;
+  model.mutable_metadata()->set_preferred_fast_engine("engine1");
+  ASSERT_OK_AND_ASSIGN(const auto engine, model.BuildFastEngine());
+  EXPECT_TRUE(dynamic_cast<const Engine1*>(engine.get()) != nullptr);
+
+  // Preferred engines that are not compatible with the model are ignored.
+  model.mutable_metadata()->set_preferred_fast_engine("engine3");
+  ASSERT_OK_AND_ASSIGN(const auto fallback_engine, model.BuildFastEngine());
+  EXPECT_TRUE(dynamic_cast<const Engine2*>(fallback_engine.get()) != nullptr);
+
+  // Unknown preferred engines are ignored.
+  model.mutable_metadata()->set_preferred_fast_engine("NonExistingEngine");
+  ASSERT_OK_AND_ASSIGN(const auto default_engine, model.BuildFastEngine());
+  EXPECT_TRUE(dynamic_cast<const Engine2*>(default_engine.get()) != nullptr);
+}
+
+TEST(AbstractModel, AutotuneFastEngine) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "adult_binary_class_gbdt"),
+      &model));
+  dataset::VerticalDataset dataset;
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", "adult_test.csv")),
+      model->data_spec(), &dataset));
+  EXPECT_TRUE(model->metadata().preferred_fast_engine().empty());
+
+  // Synthetic examples.
+  ASSERT_OK_AND_ASSIGN(
+      const std::string synthetic_engine,
+      model->AutotuneFastEngine({.num_synthetic_examples = 200,
+                                 .save_in_metadata = false}));
+  EXPECT_THAT(model->ListCompatibleFastEngineNames(),
+              testing::Contains(synthetic_engine));
+  EXPECT_TRUE(model->metadata().preferred_fast_engine().empty());
+
+  // User examples, multi-threaded.
+  ASSERT_OK_AND_ASSIGN(
+      const std::string engine_name,
+      model->AutotuneFastEngine(
+          {.examples = &dataset, .batch_size = 64, .num_threads = 2}));
+  EXPECT_EQ(model->metadata().preferred_fast_engine(), engine_name);
+
+  // The autotuned engine is used by default.
+  ASSERT_OK_AND_ASSIGN(const auto engine, model->BuildFastEngine());
+  ASSERT_OK_AND_ASSIGN(const auto expected_engine,
+                       model->BuildFastEngine(engine_name));
+  EXPECT_EQ(typeid(*engine), typeid(*expected_engine));
+}
+
+TEST(AbstractModel, AutotuneFastEngineWithInvalidDataspec) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "adult_binary_class_gbdt"),
+      &model));
+  auto* age = model->mutable_data_spec()->mutable_columns(
+      dataset::GetColumnIdxFromName("age", model->data_spec()));
+  age->mutable_numerical()->set_min_value(10);
+  age->mutable_numerical()->set_max_value(5);
+  EXPECT_THAT(
+      model->AutotuneFastEngine({.num_synthetic_examples = 10}).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument, "age"));
+}
+
 TEST(FloatToProtoPrediction, Base) {
   proto::Prediction prediction;
 
@@ -51,6 +51,7 @@
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/vector_kernels.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -249,23 +250,12 @@ absl::Span<const float> AnchorToVector(
 
 float SquaredDistance(const absl::Span<const float> a,
                       const absl::Span<const float> b) {
-  DCHECK_EQ(a.size(), b.size());
-  float acc = 0;
-  for (size_t i = 0; i < a.size(); i++) {
-    const float v = a[i] - b[i];
-    acc += v * v;
-  }
-  return acc;
+  return utils::SquaredDistance(a, b);
 }
 
 float DotProduct(const absl::Span<const float> a,
                  const absl::Span<const float> b) {
-  DCHECK_EQ(a.size(), b.size());
-  float acc = 0;
-  for (size_t i = 0; i < a.size(); i++) {
-    acc += a[i] * b[i];
-  }
-  return acc;
+  return utils::DotProduct(a, b);
 }
 
 // Converts a map of variable importance into a vector of variable importance
@@ -702,14 +692,12 @@ void NodeWithChildren::TurnIntoLeaf() {
 
 struct EvalConditionTrueValue {
   absl::StatusOr<bool> operator()(
-      const std::vector<dataset::VerticalDataset::BooleanColumn::Format>& data,
+      const dataset::VerticalDataset::BooleanColumn& data,
       UnsignedExampleIdx example_idx, const bool na_value) {
-    const auto value = data[example_idx];
-    if (ABSL_PREDICT_FALSE(value ==
-                           dataset::VerticalDataset::BooleanColumn::kNaValue)) {
+    if (ABSL_PREDICT_FALSE(data.IsNa(example_idx))) {
       return na_value;
     }
-    return value == dataset::VerticalDataset::BooleanColumn::kTrueValue;
+    return data.IsTrue(example_idx);
   }
 };
 
@@ -758,8 +746,7 @@ struct EvalConditionContainsCategorical {
       : mask(condition.elements().begin(), condition.elements().end()) {}
 
   absl::StatusOr<bool> operator()(
-      const std::vector<dataset::VerticalDataset::CategoricalColumn::Format>&
-          data,
+      const dataset::VerticalDataset::CategoricalColumn::Values& data,
       UnsignedExampleIdx example_idx, const bool na_value) {
     const auto value = data[example_idx];
     if (ABSL_PREDICT_FALSE(
@@ -797,8 +784,7 @@ struct EvalConditionContainsBitmapCategorical {
       : mask_bitmap(condition.elements_bitmap()) {}
 
   absl::StatusOr<bool> operator()(
-      const std::vector<dataset::VerticalDataset::CategoricalColumn::Format>&
-          data,
+      const dataset::VerticalDataset::CategoricalColumn::Values& data,
       UnsignedExampleIdx example_idx, const bool na_value) {
     const auto value = data[example_idx];
     if (ABSL_PREDICT_FALSE(
@@ -1042,9 +1028,8 @@ absl::Status EvalConditionOnDataset(const dataset::VerticalDataset& dataset,
           const auto* column_data,
           dataset.ColumnWithCastWithStatus<
               dataset::VerticalDataset::BooleanColumn>(condition.attribute()));
-      const auto& data = column_data->values();
       RETURN_IF_ERROR(EvalConditionTemplate(
-          EvalConditionTrueValue(), examples, data, dataset_is_dense,
+          EvalConditionTrueValue(), examples, *column_data, dataset_is_dense,
           condition.na_value(), example_split));
     } break;
 
@@ -1234,7 +1219,7 @@ absl::StatusOr<bool> EvalConditionFromColumn(
         const auto& elements =
             condition.condition().contains_condition().elements();
         return std::binary_search(elements.begin(), elements.end(),
-                                  categorical_column->values()[example_idx]);
+                                  categorical_column->value(example_idx));
       } else if (column_data->type() ==
                  dataset::proto::ColumnType::CATEGORICAL_SET) {
         const auto* categorical_column = static_cast<
@@ -1260,7 +1245,7 @@ absl::StatusOr<bool> EvalConditionFromColumn(
         const auto* categorical_column = static_cast<
             const dataset::VerticalDataset::CategoricalColumn* const>(
             column_data);
-        const auto value = categorical_column->values()[example_idx];
+        const auto value = categorical_column->value(example_idx);
         const std::string& bitmap =
             condition.condition().contains_bitmap_condition().elements_bitmap();
         return utils::bitmap::GetValueBit(bitmap, value);
@@ -1882,6 +1867,41 @@ int64_t NumberOfNodes(const std::vector<std::unique_ptr<DecisionTree>>& trees) {
   return num_nodes;
 }
 
+absl::Status SetNodeTraffic(const dataset::VerticalDataset& dataset,
+                            DecisionForest* trees) {
+  for (auto& tree : *trees) {
+    tree->IterateOnMutableNodes([](NodeWithChildren* node, const int depth) {
+      node->mutable_node()->set_num_profiled_examples(0);
+    });
+    for (dataset::VerticalDataset::row_t row_idx = 0; row_idx < dataset.nrow();
+         row_idx++) {
+      NodeWithChildren* node = tree->mutable_root();
+      while (true) {
+        auto* node_proto = node->mutable_node();
+        node_proto->set_num_profiled_examples(
+            node_proto->num_profiled_examples() + 1);
+        if (node->IsLeaf()) {
+          break;
+        }
+        ASSIGN_OR_RETURN(
+            const bool condition_result,
+            EvalCondition(node->node().condition(), dataset, row_idx));
+        node = condition_result ? node->mutable_pos_child()
+                                : node->mutable_neg_child();
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+void ClearNodeTraffic(DecisionForest* trees) {
+  for (auto& tree : *trees) {
+    tree->IterateOnMutableNodes([](NodeWithChildren* node, const int depth) {
+      node->mutable_node()->clear_num_profiled_examples();
+    });
+  }
+}
+
 bool CheckStructure(const CheckStructureOptions& options,
                     const dataset::proto::DataSpecification& data_spec,
                     const std::vector<std::unique_ptr<DecisionTree>>& trees) {
@@ -382,6 +382,18 @@ std::optional<size_t> EstimateSizeInByte(const DecisionForest& trees);
 // Number of nodes in a list of decision trees.
 int64_t NumberOfNodes(const DecisionForest& trees);
 
+// Sets the "num_profiled_examples" field of all the nodes to the number of
+// examples in "dataset" that reach them. The serving engines use these counts
+// to store the frequently visited nodes next to each other, to make the most
+// visited child of a node its fall-through child, and to order the trees (see
+// "serving::decision_forest::FlatNodeLayout" and "FlatTreeOrder"). "dataset"
+// should be representative of the inference traffic.
+absl::Status SetNodeTraffic(const dataset::VerticalDataset& dataset,
+                            DecisionForest* trees);
+
+// Clears the "num_profiled_examples" field of all the nodes.
+void ClearNodeTraffic(DecisionForest* trees);
+
 // Tests if the model satisfy the condition defined in
 // "CheckStructureOptions".
 bool CheckStructure(const CheckStructureOptions& options,
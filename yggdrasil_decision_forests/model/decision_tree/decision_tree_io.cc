@@ -17,7 +17,9 @@
 
 #include <stddef.h>
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,7 +31,9 @@
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree_io_interface.h"
 #include "yggdrasil_decision_forests/utils/blob_sequence.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
 #include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
@@ -42,6 +46,110 @@ namespace decision_tree {
 constexpr size_t kMaxShardSizeInByte = static_cast<size_t>(200)
                                        << 20;  // 200 MB.
 
+namespace {
+
+// Reads the trees stored in indexed blob sequences. The chunks of nodes are
+// decompressed and parsed in parallel, and the trees are assembled in the
+// calling thread.
+absl::Status LoadTreesFromIndexedBlobSequences(
+    absl::string_view sharded_path, const int num_trees, const int num_threads,
+    std::vector<std::unique_ptr<DecisionTree>>* trees) {
+  std::vector<std::string> paths;
+  RETURN_IF_ERROR(utils::ExpandInputShards(sharded_path, &paths));
+
+  struct Chunk {
+    int shard_idx;
+    int64_t chunk_idx;
+  };
+  std::vector<std::unique_ptr<utils::MemoryMappedFile>> files;
+  std::vector<std::unique_ptr<utils::blob_sequence::IndexedReader>> readers;
+  std::vector<Chunk> chunks;
+  for (const auto& path : paths) {
+    ASSIGN_OR_RETURN(auto file, utils::MemoryMappedFile::Open(path));
+    ASSIGN_OR_RETURN(auto reader,
+                     utils::blob_sequence::IndexedReader::Open(file->data()));
+    for (int64_t chunk_idx = 0; chunk_idx < reader->num_chunks();
+         chunk_idx++) {
+      chunks.push_back({static_cast<int>(files.size()), chunk_idx});
+    }
+    files.push_back(std::move(file));
+    readers.push_back(std::move(reader));
+  }
+
+  using ParsedChunk = absl::StatusOr<std::vector<proto::Node>>;
+  using ChunkParser = utils::concurrency::StreamProcessor<Chunk, ParsedChunk>;
+  ChunkParser parser(
+      "LoadTrees", num_threads,
+      [&readers](const Chunk chunk) -> ParsedChunk {
+        std::vector<std::string> records;
+        RETURN_IF_ERROR(
+            readers[chunk.shard_idx]->ReadChunk(chunk.chunk_idx, &records));
+        std::vector<proto::Node> nodes(records.size());
+        for (size_t node_idx = 0; node_idx < records.size(); node_idx++) {
+          if (!nodes[node_idx].ParseFromString(records[node_idx])) {
+            return absl::InvalidArgumentError("Cannot parse node");
+          }
+        }
+        return nodes;
+      },
+      /*result_in_order=*/true);
+  parser.StartWorkers();
+
+  // Returns the parsed nodes in order. Only a limited number of chunks are
+  // parsed in advance to bound the memory usage.
+  class NodeReader : public utils::ProtoReaderInterface<proto::Node> {
+   public:
+    NodeReader(ChunkParser& parser, const std::vector<Chunk>& chunks,
+               const size_t max_pending_chunks)
+        : parser_(parser), chunks_(chunks) {
+      while (next_submitted_chunk_ < chunks_.size() &&
+             next_submitted_chunk_ < max_pending_chunks) {
+        parser_.Submit(chunks_[next_submitted_chunk_++]);
+      }
+    }
+
+    absl::StatusOr<bool> Next(proto::Node* node) override {
+      while (next_node_ == nodes_.size()) {
+        if (num_read_chunks_ == chunks_.size()) {
+          return false;
+        }
+        std::optional<ParsedChunk> result = parser_.GetResult();
+        if (!result.has_value()) {
+          return absl::InternalError("Missing chunk");
+        }
+        num_read_chunks_++;
+        if (next_submitted_chunk_ < chunks_.size()) {
+          parser_.Submit(chunks_[next_submitted_chunk_++]);
+        }
+        RETURN_IF_ERROR(result->status());
+        nodes_ = std::move(result->value());
+        next_node_ = 0;
+      }
+      *node = std::move(nodes_[next_node_++]);
+      return true;
+    }
+
+   private:
+    ChunkParser& parser_;
+    const std::vector<Chunk>& chunks_;
+    size_t next_submitted_chunk_ = 0;
+    size_t num_read_chunks_ = 0;
+    // Nodes of the current chunk, and index of the next node to return.
+    std::vector<proto::Node> nodes_;
+    size_t next_node_ = 0;
+  } node_reader(parser, chunks, /*max_pending_chunks=*/2 * num_threads);
+
+  for (int64_t tree_idx = 0; tree_idx < num_trees; tree_idx++) {
+    auto decision_tree = std::make_unique<decision_tree::DecisionTree>();
+    RETURN_IF_ERROR(decision_tree->ReadNodes(&node_reader));
+    decision_tree->SetLeafIndices();
+    trees->push_back(std::move(decision_tree));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 absl::Status SaveTreesToDisk(
     absl::string_view directory, absl::string_view basename,
     const std::vector<std::unique_ptr<DecisionTree>>& trees,
@@ -67,6 +175,9 @@ absl::Status SaveTreesToDisk(
       node_writer->Open(file::GenerateShardedFileSpec(base_path, *num_shards),
                         num_nodes_per_shard));
   for (const auto& tree : trees) {
+    // Records the tree boundaries e.g. in the index of the indexed blob
+    // sequences.
+    node_writer->StartGroup();
     RETURN_IF_ERROR(tree->WriteNodes(node_writer.get()));
   }
   RETURN_IF_ERROR(node_writer->CloseWithStatus());
@@ -76,11 +187,16 @@ absl::Status SaveTreesToDisk(
 absl::Status LoadTreesFromDisk(
     absl::string_view directory, absl::string_view basename, int num_shards,
     int num_trees, absl::string_view format,
-    std::vector<std::unique_ptr<DecisionTree>>* trees) {
+    std::vector<std::unique_ptr<DecisionTree>>* trees, const int num_threads) {
   ASSIGN_OR_RETURN(const auto format_impl, GetFormatImplementation(format));
+  const auto sharded_path = file::GenerateShardedFileSpec(
+      file::JoinPath(directory, basename), num_shards);
+  if (format_impl->HasIndexedShards() && num_threads > 1) {
+    return LoadTreesFromIndexedBlobSequences(sharded_path, num_trees,
+                                             num_threads, trees);
+  }
   auto node_reader = format_impl->CreateReader();
-  RETURN_IF_ERROR(node_reader->Open(file::GenerateShardedFileSpec(
-      file::JoinPath(directory, basename), num_shards)));
+  RETURN_IF_ERROR(node_reader->Open(sharded_path));
   for (int64_t tree_idx = 0; tree_idx < num_trees; tree_idx++) {
     auto decision_tree = std::make_unique<decision_tree::DecisionTree>();
     RETURN_IF_ERROR(decision_tree->ReadNodes(node_reader.get()));
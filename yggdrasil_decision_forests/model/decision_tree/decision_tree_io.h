@@ -46,10 +46,12 @@ absl::Status SaveTreesToDisk(
     const std::vector<std::unique_ptr<DecisionTree>>& trees,
     absl::string_view format, int* num_shards);
 
+// If the format has indexed shards (e.g. "BLOB_SEQUENCE_INDEXED_GZIP"), the
+// nodes are decompressed and parsed with "num_threads" threads.
 absl::Status LoadTreesFromDisk(
     absl::string_view directory, absl::string_view basename, int num_shards,
     int num_trees, absl::string_view format,
-    std::vector<std::unique_ptr<DecisionTree>>* trees);
+    std::vector<std::unique_ptr<DecisionTree>>* trees, int num_threads = 1);
 
 // Serializes a list of decision trees to a string. The tree is encoded by
 // proto-serializing the nodes in a blob sequence.
@@ -62,6 +62,29 @@ class BlobSequenceGZipFormat : public AbstractFormat {
 };
 REGISTER_AbstractFormat(BlobSequenceGZipFormat, "BLOB_SEQUENCE_GZIP");
 
+// The nodes are stored in indexed blob sequences: The nodes are compressed in
+// independent chunks, and the index contains the first node of each tree.
+// Such trees are loaded in parallel.
+class BlobSequenceIndexedGZipFormat : public AbstractFormat {
+ public:
+  ~BlobSequenceIndexedGZipFormat() override = default;
+
+  std::unique_ptr<utils::ShardedReader<proto::Node>> CreateReader()
+      const override {
+    return std::make_unique<utils::BlobSequenceShardedReader<proto::Node>>();
+  };
+
+  std::unique_ptr<utils::ShardedWriter<proto::Node>> CreateWriter()
+      const override {
+    return std::make_unique<utils::BlobSequenceShardedWriter<proto::Node>>(
+        utils::blob_sequence::Compression::kGZIP, /*indexed=*/true);
+  };
+
+  bool HasIndexedShards() const override { return true; }
+};
+REGISTER_AbstractFormat(BlobSequenceIndexedGZipFormat,
+                        "BLOB_SEQUENCE_INDEXED_GZIP");
+
 }  // namespace decision_tree
 }  // namespace model
 }  // namespace yggdrasil_decision_forests
@@ -47,6 +47,10 @@ class AbstractFormat {
       const = 0;
   virtual std::unique_ptr<utils::ShardedWriter<proto::Node>> CreateWriter()
       const = 0;
+
+  // If true, the shards are indexed blob sequences (see
+  // "utils::blob_sequence::IndexedReader") that can be read in parallel.
+  virtual bool HasIndexedShards() const { return false; }
 };
 
 REGISTRATION_CREATE_POOL(AbstractFormat);
@@ -35,6 +35,8 @@
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/model/decision_tree/builder.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree_io.h"
+#include "yggdrasil_decision_forests/utils/blob_sequence.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
@@ -1155,6 +1157,61 @@ TEST(DecisionTree, Depth) {
   EXPECT_EQ(tree.root().pos_child()->neg_child()->depth(), 2);
 }
 
+// Creates a complete tree of depth "depth" with thresholds starting at
+// "threshold".
+void BuildCompleteTree(TreeBuilder builder, const int depth,
+                       const float threshold) {
+  if (depth == 0) {
+    builder.LeafRegression(threshold);
+    return;
+  }
+  auto [pos, neg] = builder.ConditionIsGreater(1, threshold);
+  BuildCompleteTree(pos, depth - 1, 2 * threshold);
+  BuildCompleteTree(neg, depth - 1, 2 * threshold + 1);
+}
+
+TEST(DecisionTree, SaveAndLoadIndexedTrees) {
+  dataset::proto::DataSpecification dataspec;
+  dataset::AddColumn("l", dataset::proto::ColumnType::NUMERICAL, &dataspec);
+  dataset::AddColumn("f1", dataset::proto::ColumnType::NUMERICAL, &dataspec);
+
+  std::vector<std::unique_ptr<DecisionTree>> trees;
+  for (int tree_idx = 0; tree_idx < 200; tree_idx++) {
+    trees.push_back(std::make_unique<DecisionTree>());
+    BuildCompleteTree(TreeBuilder(trees.back().get()), tree_idx % 7, tree_idx);
+  }
+
+  const std::string directory =
+      file::JoinPath(test::TmpDirectory(), "indexed_trees");
+  ASSERT_OK(file::RecursivelyCreateDir(directory, file::Defaults()));
+  int num_shards;
+  ASSERT_OK(SaveTreesToDisk(directory, "nodes", trees,
+                            "BLOB_SEQUENCE_INDEXED_GZIP", &num_shards));
+
+  // The tree boundaries are indexed.
+  ASSERT_EQ(num_shards, 1);
+  ASSERT_OK_AND_ASSIGN(
+      const std::string content,
+      file::GetContent(file::JoinPath(directory, "nodes-00000-of-00001")));
+  ASSERT_OK_AND_ASSIGN(const auto indexed_reader,
+                       utils::blob_sequence::IndexedReader::Open(content));
+  EXPECT_EQ(indexed_reader->num_groups(), trees.size());
+  EXPECT_EQ(indexed_reader->num_records(), NumberOfNodes(trees));
+
+  for (const int num_threads : {1, 4}) {
+    std::vector<std::unique_ptr<DecisionTree>> loaded_trees;
+    ASSERT_OK(LoadTreesFromDisk(directory, "nodes", num_shards, trees.size(),
+                                "BLOB_SEQUENCE_INDEXED_GZIP", &loaded_trees,
+                                num_threads));
+    ASSERT_EQ(loaded_trees.size(), trees.size());
+    for (int tree_idx = 0; tree_idx < trees.size(); tree_idx++) {
+      EXPECT_EQ(trees[tree_idx]->DebugCompare(dataspec, 0,
+                                              *loaded_trees[tree_idx]),
+                "");
+    }
+  }
+}
+
 }  // namespace
 }  // namespace decision_tree
 }  // namespace model
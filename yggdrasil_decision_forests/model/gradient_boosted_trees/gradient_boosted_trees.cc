@@ -145,7 +145,8 @@ absl::Status GradientBoostedTreesModel::Load(absl::string_view directory,
       absl::StrCat(io_options.file_prefix.value(), kNodeBaseFilename);
   RETURN_IF_ERROR(decision_tree::LoadTreesFromDisk(
       directory, node_base_filename, header.num_node_shards(),
-      header.num_trees(), header.node_format(), &decision_trees_));
+      header.num_trees(), header.node_format(), &decision_trees_,
+      io_options.num_threads));
   node_format_ = header.node_format();
   ApplyHeaderProto(header);
   return absl::OkStatus();
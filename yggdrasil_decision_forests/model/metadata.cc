@@ -23,6 +23,9 @@ void MetaData::Export(model::proto::Metadata* dst) const {
   dst->set_created_date(created_date_);
   dst->set_uid(uid_);
   dst->set_framework(framework_);
+  if (!preferred_fast_engine_.empty()) {
+    dst->set_preferred_fast_engine(preferred_fast_engine_);
+  }
 }
 
 void MetaData::Import(const model::proto::Metadata& src) {
@@ -30,6 +33,7 @@ void MetaData::Import(const model::proto::Metadata& src) {
   created_date_ = src.created_date();
   uid_ = src.uid();
   framework_ = src.framework();
+  preferred_fast_engine_ = src.preferred_fast_engine();
 }
 
 }  // namespace model
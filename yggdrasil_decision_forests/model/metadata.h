@@ -38,6 +38,13 @@ class MetaData {
   const std::string& framework() const { return framework_; }
   void set_framework(const std::string& value) { framework_ = value; }
 
+  const std::string& preferred_fast_engine() const {
+    return preferred_fast_engine_;
+  }
+  void set_preferred_fast_engine(const std::string& value) {
+    preferred_fast_engine_ = value;
+  }
+
   void Export(model::proto::Metadata* dst) const;
   void Import(const model::proto::Metadata& src);
 
@@ -46,6 +53,7 @@ class MetaData {
   int64_t created_date_ = 0;
   uint64_t uid_ = 0;
   std::string framework_;
+  std::string preferred_fast_engine_;
 };
 
 }  // namespace model
@@ -252,7 +252,6 @@ void Dataset::AddCategoricalColumn(const std::string& name,
     CheckOrThrowError(abstract_column.status());
   }
   column.value()->Resize(data.size());
-  auto& dst_values = *column.value()->mutable_values();
 
   const auto& items = column_spec.value().categorical().items();
 
@@ -274,7 +273,7 @@ void Dataset::AddCategoricalColumn(const std::string& name,
         dst_value = it->second.index();
       }
     }
-    dst_values[value_idx] = dst_value;
+    column.value()->Set(value_idx, dst_value);
   }
   if (dataset_.nrow() == 0) {
     dataset_.set_nrow(data.size());
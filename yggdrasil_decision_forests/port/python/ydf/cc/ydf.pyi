@@ -207,6 +207,12 @@ class DecisionForestCCModel(GenericCCModel):
       dataset1: VerticalDataset,
       dataset2: VerticalDataset,
   ) -> npt.NDArray[np.float32]: ...
+  def PredictShap(
+      self,
+      dataset: VerticalDataset,
+      background: Optional[VerticalDataset],
+      num_threads: int,
+  ) -> Tuple[npt.NDArray[np.float32], float]: ...
   def set_node_format(self, node_format: str) -> None: ...
   def GetTree(
       self,
@@ -40,6 +40,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "pybind11_protobuf/native_proto_caster.h"  // IWYU pragma : keep
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
@@ -376,11 +377,10 @@ absl::Status PopulateColumnBooleanNPBool(
                          column_idx.value()));
   }
 
-  std::vector<BooleanColumn::Format>& dst_values = *column->mutable_values();
-  const size_t offset = dst_values.size();
-  dst_values.resize(offset + src_values.size());
+  column->Reserve(column->nrows() + src_values.size());
   for (size_t i = 0; i < src_values.size(); i++) {
-    dst_values[i + offset] = src_values[i];
+    column->Add(src_values[i] ? BooleanColumn::kTrueValue
+                              : BooleanColumn::kFalseValue);
   }
 
   return absl::OkStatus();
@@ -604,36 +604,28 @@ absl::Status PopulateColumnCategoricalNPBytes(
     ASSIGN_OR_RETURN(column,
                      self.MutableColumnWithCastWithStatus<CategoricalColumn>(
                          column_idx.value()));
-    offset = column->values().size();
+    offset = column->nrows();
   }
   const auto& column_spec = self.data_spec().columns(column_idx.value());
   column->Resize(offset + values.size());
-  auto& dst_values = *column->mutable_values();
-
-  // TODO: Check if using an absl::flat_map is significantly faster.
-  const auto& items = column_spec.categorical().items();
 
-  if (items.empty()) {
+  if (column_spec.categorical().items().empty()) {
     return absl::InvalidArgumentError(
         absl::Substitute("Column \"$0\": Empty categorical dictionary. PYDF "
                          "does not support empty dictionaries",
                          name));
   }
 
+  const dataset::CategoricalDictionary dictionary(column_spec);
+  std::vector<int32_t> dst_values(values_vector.size());
+  RETURN_IF_ERROR(
+      dictionary.LookupBatch(values_vector, absl::MakeSpan(dst_values)));
   for (size_t value_idx = 0; value_idx < values_vector.size(); value_idx++) {
-    const std::string_view value = values_vector[value_idx];
-    int32_t dst_value;
-    if (value.empty()) {
-      dst_value = dataset::VerticalDataset::CategoricalColumn::kNaValue;
+    if (values_vector[value_idx].empty()) {
+      column->SetNA(offset + value_idx);
     } else {
-      const auto it = items.find(value);
-      if (it == items.end()) {
-        dst_value = dataset::kOutOfDictionaryItemIndex;
-      } else {
-        dst_value = it->second.index();
-      }
+      column->Set(offset + value_idx, dst_values[value_idx]);
     }
-    dst_values[offset + value_idx] = dst_value;
   }
 
   return absl::OkStatus();
@@ -15,7 +15,7 @@
 """Definitions for generic decision forest models."""
 
 import sys
-from typing import Any, Iterator, Optional, Sequence
+from typing import Any, Dict, Iterator, Optional, Sequence, Tuple
 
 import numpy as np
 
@@ -24,6 +24,7 @@ from ydf.dataset import dataset
 from ydf.model import generic_model
 from ydf.model.tree import plot as plot_lib
 from ydf.model.tree import tree as tree_lib
+from ydf.utils import concurrency
 
 
 class DecisionForestModel(generic_model.GenericCCModel):
@@ -240,6 +241,76 @@ class DecisionForestModel(generic_model.GenericCCModel):
       )
     return self._model.Distance(ds1._dataset, ds2._dataset)  # pylint: disable=protected-access
 
+  def predict_shap(
+      self,
+      data: dataset.InputDataset,
+      background: Optional[dataset.InputDataset] = None,
+      num_threads: Optional[int] = None,
+  ) -> Tuple[Dict[str, np.ndarray], float]:
+    """Computes the exact SHAP values of the examples with TreeSHAP.
+
+    If "background" is not provided, the SHAP values are computed with the
+    path dependent TreeSHAP algorithm, which uses the training examples counted
+    in each node. Otherwise, the interventional TreeSHAP algorithm is used with
+    (up to 100 examples sampled from) "background".
+
+    The SHAP values are expressed in the output space of the trees, before the
+    activation function (e.g., logits for binary classification Gradient
+    Boosted Trees). For each example, the sum of the SHAP values and of the
+    expected value is equal to the model output before activation.
+
+    Only the single output Gradient Boosted Trees and the binary classification
+    and regression Random Forest models are supported.
+
+    Usage example:
+
+    ```python
+    import pandas as pd
+    import ydf
+
+    # Train model
+    train_ds = pd.read_csv("train.csv")
+    model = ydf.GradientBoostedTreesLearner(label="label").Train(train_ds)
+
+    test_ds = pd.read_csv("test.csv")
+    shap_values, expected_value = model.predict_shap(test_ds)
+    # "shap_values["age"][i]" is the SHAP value of the feature "age" for the
+    # i-th test example.
+    ```
+
+    Args:
+      data: Dataset to explain.
+      background: Background dataset of the interventional algorithm.
+      num_threads: Number of threads used to compute the SHAP values. If not
+        set, the number of threads is determined automatically.
+
+    Returns:
+      The SHAP values indexed by input feature name, and the expected value.
+    """
+
+    if num_threads is None:
+      num_threads = concurrency.determine_optimal_num_threads(training=False)
+
+    ds = dataset.create_vertical_dataset(
+        data,
+        data_spec=self._model.data_spec(),
+        required_columns=self.input_feature_names(),
+    )
+    background_ds = None
+    if background is not None:
+      background_ds = dataset.create_vertical_dataset(
+          background,
+          data_spec=self._model.data_spec(),
+          required_columns=self.input_feature_names(),
+      )._dataset  # pylint: disable=protected-access
+    shap_values, expected_value = self._model.PredictShap(
+        ds._dataset, background_ds, num_threads  # pylint: disable=protected-access
+    )
+    return {
+        name: shap_values[:, column_idx]
+        for column_idx, name in enumerate(self.input_feature_names())
+    }, expected_value
+
   def set_node_format(self, node_format: generic_model.NodeFormat) -> None:
     """Set the serialization format for the nodes.
 
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -27,6 +28,9 @@
 #include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/tree_shap.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
@@ -94,6 +98,43 @@ absl::StatusOr<py::array_t<float>> DecisionForestCCModel::Distance(
   return distances;
 }
 
+absl::StatusOr<std::pair<py::array_t<float>, float>>
+DecisionForestCCModel::PredictShap(const dataset::VerticalDataset& dataset,
+                                   const dataset::VerticalDataset* background,
+                                   const int num_threads) {
+  using serving::decision_forest::TreeShap;
+  using serving::decision_forest::TreeShapOptions;
+  py::array_t<float, py::array::c_style | py::array::forcecast> shap_values;
+
+  TreeShapOptions options;
+  if (background != nullptr) {
+    options.algorithm = TreeShapOptions::Algorithm::kInterventional;
+  }
+  ASSIGN_OR_RETURN(const auto tree_shap,
+                   TreeShap::Create(*model_, options, background));
+
+  const size_t num_examples = dataset.nrow();
+  const size_t num_columns = tree_shap->input_features().size();
+  shap_values.resize({num_examples, num_columns});
+  auto dst = absl::MakeSpan(shap_values.mutable_data(),
+                            num_examples * num_columns);
+  {
+    py::gil_scoped_release release;
+    if (num_threads > 1) {
+      auto thread_pool =
+          std::make_shared<utils::concurrency::ThreadPool>(num_threads - 1);
+      thread_pool->StartWorkers();
+      tree_shap->SetParallelOptions({.thread_pool = std::move(thread_pool),
+                                     .min_examples_per_thread = 16});
+    }
+    auto examples = tree_shap->AllocateExamples(num_examples);
+    RETURN_IF_ERROR(serving::CopyVerticalDatasetToAbstractExampleSet(
+        dataset, 0, num_examples, tree_shap->features(), examples.get()));
+    RETURN_IF_ERROR(tree_shap->Shap(*examples, num_examples, dst));
+  }
+  return std::make_pair(std::move(shap_values), tree_shap->expected_value());
+}
+
 absl::StatusOr<std::vector<model::decision_tree::proto::Node>>
 DecisionForestCCModel::GetTree(int tree_idx) const {
   if (tree_idx < 0 || tree_idx >= df_model_->num_trees()) {
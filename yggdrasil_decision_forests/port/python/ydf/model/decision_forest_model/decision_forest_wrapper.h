@@ -47,6 +47,14 @@ class DecisionForestCCModel : public GenericCCModel {
       const dataset::VerticalDataset& dataset1,
       const dataset::VerticalDataset& dataset2);
 
+  // Computes the SHAP values of the examples in "dataset" with TreeSHAP. Uses
+  // the interventional algorithm with "background" as background dataset if
+  // set, and the path dependent algorithm otherwise. Returns the SHAP values
+  // (with one column per input feature) and the expected value.
+  absl::StatusOr<std::pair<py::array_t<float>, float>> PredictShap(
+      const dataset::VerticalDataset& dataset,
+      const dataset::VerticalDataset* background, int num_threads);
+
   // Sets the format for saving the model's nodes.
   void set_node_format(const std::string& node_format) {
     df_model_->set_node_format(node_format);
@@ -131,11 +131,15 @@ class NodeFormat(enum.Enum):
 
   Attributes:
     BLOB_SEQUENCE: Default format for the public version of YDF.
+    BLOB_SEQUENCE_INDEXED_GZIP: Compressed and indexed format. The trees are
+      loaded in parallel. Not readable by versions of YDF older than this
+      format.
   """
   # pyformat: enable
 
   BLOB_SEQUENCE = enum.auto()
   BLOB_SEQUENCE_GZIP = enum.auto()
+  BLOB_SEQUENCE_INDEXED_GZIP = enum.auto()
 
 
 @dataclasses.dataclass
@@ -201,6 +201,8 @@ void init_model(py::module_& m) {
            py::arg("dataset"))
       .def("Distance", WithStatusOr(&DecisionForestCCModel::Distance),
            py::arg("dataset1"), py::arg("dataset2"))
+      .def("PredictShap", WithStatusOr(&DecisionForestCCModel::PredictShap),
+           py::arg("dataset"), py::arg("background"), py::arg("num_threads"))
       .def("GetTree", WithStatusOr(&DecisionForestCCModel::GetTree),
            py::arg("tree_idx"))
       .def("SetTree", WithStatus(&DecisionForestCCModel::SetTree),
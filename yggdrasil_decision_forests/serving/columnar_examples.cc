@@ -0,0 +1,280 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+absl::Status ColumnarExamples::AddColumn(const absl::string_view name,
+                                         const size_t num_values,
+                                         const Column column) {
+  if (static_cast<int64_t>(num_values) != num_examples_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The column \"", name, "\" contains ", num_values,
+                     " values while ", num_examples_, " were expected"));
+  }
+  if (!columns_.emplace(std::string(name), column).second) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The column \"", name, "\" is defined multiple times"));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ColumnarExamples::AddNumericalColumn(
+    const absl::string_view name, const absl::Span<const float> values) {
+  return AddColumn(name, values.size(),
+                   {ColumnType::kNumerical, values.data()});
+}
+
+absl::Status ColumnarExamples::AddCategoricalColumn(
+    const absl::string_view name, const absl::Span<const int32_t> values) {
+  return AddColumn(name, values.size(),
+                   {ColumnType::kCategorical, values.data()});
+}
+
+absl::Status ColumnarExamples::AddBooleanColumn(
+    const absl::string_view name, const absl::Span<const int8_t> values) {
+  return AddColumn(name, values.size(), {ColumnType::kBoolean, values.data()});
+}
+
+const ColumnarExamples::Column* ColumnarExamples::FindColumn(
+    const absl::string_view name) const {
+  const auto it = columns_.find(name);
+  if (it == columns_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+ColumnarExamples ColumnarExamples::Slice(const int64_t begin,
+                                         const int64_t end) const {
+  DCHECK_LE(0, begin);
+  DCHECK_LE(begin, end);
+  DCHECK_LE(end, num_examples_);
+  ColumnarExamples slice(end - begin);
+  slice.columns_.reserve(columns_.size());
+  for (const auto& [name, column] : columns_) {
+    const void* values = nullptr;
+    switch (column.type) {
+      case ColumnType::kNumerical:
+        values = static_cast<const float*>(column.values) + begin;
+        break;
+      case ColumnType::kCategorical:
+        values = static_cast<const int32_t*>(column.values) + begin;
+        break;
+      case ColumnType::kBoolean:
+        values = static_cast<const int8_t*>(column.values) + begin;
+        break;
+    }
+    slice.columns_.emplace(name, Column{column.type, values});
+  }
+  slice.owned_boolean_values_ = owned_boolean_values_;
+  slice.owned_categorical_values_ = owned_categorical_values_;
+  return slice;
+}
+
+absl::StatusOr<ColumnarExamples> ColumnarExamples::FromVerticalDataset(
+    const dataset::VerticalDataset& dataset,
+    const dataset::VerticalDataset::row_t begin,
+    const dataset::VerticalDataset::row_t end,
+    const FeaturesDefinition& features) {
+  using NumericalColumn = dataset::VerticalDataset::NumericalColumn;
+  using BooleanColumn = dataset::VerticalDataset::BooleanColumn;
+  using CategoricalColumn = dataset::VerticalDataset::CategoricalColumn;
+
+  if (begin < 0 || end < begin || end > dataset.nrow()) {
+    return absl::InvalidArgumentError("Invalid range of examples");
+  }
+  if (!features.categorical_set_features().empty() ||
+      !features.numerical_vector_sequence_features().empty()) {
+    return absl::UnimplementedError(
+        "Columnar examples do not support variable length features");
+  }
+
+  ColumnarExamples examples(end - begin);
+  for (const auto& feature : features.fixed_length_features()) {
+    if (feature.spec_idx < 0 || feature.spec_idx >= dataset.ncol()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid feature index ", feature.spec_idx));
+    }
+    switch (feature.type) {
+      case dataset::proto::ColumnType::NUMERICAL: {
+        ASSIGN_OR_RETURN(const auto* column,
+                         dataset.ColumnWithCastWithStatus<NumericalColumn>(
+                             feature.spec_idx));
+        RETURN_IF_ERROR(examples.AddNumericalColumn(
+            feature.name,
+            absl::MakeConstSpan(column->values()).subspan(begin, end - begin)));
+      } break;
+      case dataset::proto::ColumnType::BOOLEAN: {
+        ASSIGN_OR_RETURN(
+            const auto* column,
+            dataset.ColumnWithCastWithStatus<BooleanColumn>(feature.spec_idx));
+        auto values = std::make_shared<std::vector<int8_t>>(end - begin);
+        for (auto row = begin; row < end; row++) {
+          (*values)[row - begin] = column->value(row);
+        }
+        RETURN_IF_ERROR(examples.AddBooleanColumn(feature.name, *values));
+        examples.owned_boolean_values_.push_back(std::move(values));
+      } break;
+      case dataset::proto::ColumnType::CATEGORICAL: {
+        ASSIGN_OR_RETURN(const auto* column,
+                         dataset.ColumnWithCastWithStatus<CategoricalColumn>(
+                             feature.spec_idx));
+        if (column->storage_type() ==
+            CategoricalColumn::StorageType::kInt32) {
+          RETURN_IF_ERROR(examples.AddCategoricalColumn(
+              feature.name, absl::MakeConstSpan(column->int32_values())
+                                .subspan(begin, end - begin)));
+          break;
+        }
+        auto values = std::make_shared<std::vector<int32_t>>(end - begin);
+        for (auto row = begin; row < end; row++) {
+          (*values)[row - begin] = column->value(row);
+        }
+        RETURN_IF_ERROR(examples.AddCategoricalColumn(feature.name, *values));
+        examples.owned_categorical_values_.push_back(std::move(values));
+      } break;
+      default:
+        return absl::UnimplementedError(
+            absl::StrCat("Columnar examples do not support the type of \"",
+                         feature.name, "\""));
+    }
+  }
+  return examples;
+}
+
+absl::Status CopyColumnarExamplesToAbstractExampleSet(
+    const ColumnarExamples& src, const int64_t begin, const int64_t end,
+    const FeaturesDefinition& features, AbstractExampleSet* dst) {
+  using NumericalFeatureId = FeaturesDefinition::NumericalFeatureId;
+  using BooleanFeatureId = FeaturesDefinition::BooleanFeatureId;
+  using CategoricalFeatureId = FeaturesDefinition::CategoricalFeatureId;
+
+  if (!features.categorical_set_features().empty() ||
+      !features.numerical_vector_sequence_features().empty()) {
+    return absl::UnimplementedError(
+        "Columnar examples do not support variable length features");
+  }
+
+  const int64_t num_examples = end - begin;
+  for (const auto& feature : features.fixed_length_features()) {
+    const auto* column = src.FindColumn(feature.name);
+    if (column == nullptr) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Missing column \"", feature.name, "\""));
+    }
+    const auto WrongType = [&]() {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Wrong column type for feature \"", feature.name, "\""));
+    };
+
+    switch (feature.type) {
+      case dataset::proto::ColumnType::NUMERICAL:
+      case dataset::proto::ColumnType::DISCRETIZED_NUMERICAL: {
+        if (column->type != ColumnarExamples::ColumnType::kNumerical) {
+          return WrongType();
+        }
+        const NumericalFeatureId feature_id{feature.internal_idx};
+        const float* values = static_cast<const float*>(column->values) + begin;
+        for (int64_t example_idx = 0; example_idx < num_examples;
+             example_idx++) {
+          if (std::isnan(values[example_idx])) {
+            dst->SetMissingNumerical(example_idx, feature_id, features);
+          } else {
+            dst->SetNumerical(example_idx, feature_id, values[example_idx],
+                              features);
+          }
+        }
+      } break;
+
+      case dataset::proto::ColumnType::BOOLEAN: {
+        const BooleanFeatureId feature_id{feature.internal_idx};
+        if (column->type == ColumnarExamples::ColumnType::kBoolean) {
+          const int8_t* values =
+              static_cast<const int8_t*>(column->values) + begin;
+          for (int64_t example_idx = 0; example_idx < num_examples;
+               example_idx++) {
+            if (values[example_idx] ==
+                dataset::VerticalDataset::BooleanColumn::kNaValue) {
+              dst->SetMissingBoolean(example_idx, feature_id, features);
+            } else {
+              dst->SetBoolean(example_idx, feature_id, values[example_idx],
+                              features);
+            }
+          }
+        } else if (column->type == ColumnarExamples::ColumnType::kNumerical) {
+          const float* values =
+              static_cast<const float*>(column->values) + begin;
+          for (int64_t example_idx = 0; example_idx < num_examples;
+               example_idx++) {
+            if (std::isnan(values[example_idx])) {
+              dst->SetMissingBoolean(example_idx, feature_id, features);
+            } else {
+              dst->SetBoolean(example_idx, feature_id,
+                              values[example_idx] >= 0.5f, features);
+            }
+          }
+        } else {
+          return WrongType();
+        }
+      } break;
+
+      case dataset::proto::ColumnType::CATEGORICAL: {
+        if (column->type != ColumnarExamples::ColumnType::kCategorical) {
+          return WrongType();
+        }
+        const CategoricalFeatureId feature_id{feature.internal_idx};
+        const int32_t* values =
+            static_cast<const int32_t*>(column->values) + begin;
+        for (int64_t example_idx = 0; example_idx < num_examples;
+             example_idx++) {
+          if (values[example_idx] < 0) {
+            dst->SetMissingCategorical(example_idx, feature_id, features);
+          } else {
+            dst->SetCategorical(example_idx, feature_id, values[example_idx],
+                                features);
+          }
+        }
+      } break;
+
+      default:
+        return absl::InvalidArgumentError("Non supported feature type.");
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
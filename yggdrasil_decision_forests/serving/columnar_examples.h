@@ -0,0 +1,228 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Batch of examples stored column-by-column in buffers owned by the caller.
+//
+// Unlike an "AbstractExampleSet", a "ColumnarExamples" does not own or copy
+// the feature values: It only references existing columns (e.g. the columns
+// of a VerticalDataset, or Arrow / numpy buffers). This makes it possible to
+// run inference on large datasets without re-packing the feature values.
+//
+// Usage example:
+//   std::vector<float> f1 = ...;
+//   std::vector<int32_t> f2 = ...;
+//   ColumnarExamples examples(num_examples);
+//   RETURN_IF_ERROR(examples.AddNumericalColumn("f1", f1));
+//   RETURN_IF_ERROR(examples.AddCategoricalColumn("f2", f2));
+//   std::vector<float> predictions(num_examples *
+//                                  engine->NumPredictionDimension());
+//   RETURN_IF_ERROR(engine->PredictColumnar(examples,
+//                                           absl::MakeSpan(predictions)));
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_COLUMNAR_EXAMPLES_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_COLUMNAR_EXAMPLES_H_
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+class ColumnarExamples {
+ public:
+  enum class ColumnType {
+    // Float values. Missing values are represented as NaN. Also used to feed
+    // boolean features with the values 0, 1 and NaN.
+    kNumerical,
+    // Integerized categorical values. Missing values are represented as -1.
+    kCategorical,
+    // Boolean values as 0 and 1. Missing values are represented as 2 (same as
+    // "VerticalDataset::BooleanColumn").
+    kBoolean,
+  };
+
+  struct Column {
+    ColumnType type;
+    // Points to "num_examples" float, int32_t or int8_t values (depending on
+    // "type").
+    const void* values;
+  };
+
+  explicit ColumnarExamples(int64_t num_examples)
+      : num_examples_(num_examples) {}
+
+  int64_t num_examples() const { return num_examples_; }
+
+  // Registers a column. "values" should contain "num_examples" values and
+  // remain valid while the "ColumnarExamples" is used.
+  absl::Status AddNumericalColumn(absl::string_view name,
+                                  absl::Span<const float> values);
+  absl::Status AddCategoricalColumn(absl::string_view name,
+                                    absl::Span<const int32_t> values);
+  absl::Status AddBooleanColumn(absl::string_view name,
+                                absl::Span<const int8_t> values);
+
+  // Gets a column by name. Returns nullptr if the column does not exist.
+  const Column* FindColumn(absl::string_view name) const;
+
+  // References the examples [begin, end) of this batch. No feature value is
+  // copied.
+  ColumnarExamples Slice(int64_t begin, int64_t end) const;
+
+  // References the examples [begin, end) of the input features of "features"
+  // in "dataset". The numerical and int32 categorical values are not copied.
+  // The boolean values (stored as bitmaps) and the compact categorical values
+  // are copied, and owned by the returned object and its slices.
+  static absl::StatusOr<ColumnarExamples> FromVerticalDataset(
+      const dataset::VerticalDataset& dataset,
+      dataset::VerticalDataset::row_t begin,
+      dataset::VerticalDataset::row_t end, const FeaturesDefinition& features);
+
+ private:
+  absl::Status AddColumn(absl::string_view name, size_t num_values,
+                         Column column);
+
+  int64_t num_examples_;
+  absl::flat_hash_map<std::string, Column> columns_;
+  // Values copied by "FromVerticalDataset". Shared with the slices.
+  std::vector<std::shared_ptr<const std::vector<int8_t>>> owned_boolean_values_;
+  std::vector<std::shared_ptr<const std::vector<int32_t>>>
+      owned_categorical_values_;
+};
+
+// Copies the examples [begin, end) of "src" into "dst". "dst" should be
+// allocated with at least "end - begin" examples.
+absl::Status CopyColumnarExamplesToAbstractExampleSet(
+    const ColumnarExamples& src, int64_t begin, int64_t end,
+    const FeaturesDefinition& features, AbstractExampleSet* dst);
+
+// Read-only example set over the examples [begin, end) of a
+// "ColumnarExamples". Exposes the same accessors as
+// "ExampleSetNumericalOrCategoricalFlat" for fixed-length features, so it can
+// be used in place of an example set by the flat node engines. Missing values
+// are replaced with the model replacement values when read.
+//
+// Only numerical and categorical columns are supported: Boolean columns
+// (stored as int8_t) require a copy. Models consuming variable length features
+// (e.g. categorical-set) are not supported.
+template <typename Model>
+class ColumnarExampleSetView {
+ public:
+  using NumericalFeatureId = FeaturesDefinition::NumericalFeatureId;
+  using CategoricalFeatureId = FeaturesDefinition::CategoricalFeatureId;
+
+  static absl::StatusOr<ColumnarExampleSetView> Create(
+      const ColumnarExamples& examples, const int64_t begin, const int64_t end,
+      const Model& model) {
+    const auto& features = model.features();
+    if (!features.categorical_set_features().empty() ||
+        !features.numerical_vector_sequence_features().empty()) {
+      return absl::UnimplementedError(
+          "Columnar examples do not support variable length features");
+    }
+    ColumnarExampleSetView view;
+    view.num_examples_ = end - begin;
+    view.columns_.reserve(features.fixed_length_features().size());
+    for (const auto& feature : features.fixed_length_features()) {
+      const auto* column = examples.FindColumn(feature.name);
+      if (column == nullptr) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Missing column \"", feature.name, "\""));
+      }
+      const bool is_categorical =
+          feature.type == dataset::proto::ColumnType::CATEGORICAL;
+      if (column->type == ColumnarExamples::ColumnType::kBoolean) {
+        return absl::UnimplementedError(
+            "Boolean columns are not supported without copy");
+      }
+      if (is_categorical !=
+          (column->type == ColumnarExamples::ColumnType::kCategorical)) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Wrong column type for feature \"", feature.name, "\""));
+      }
+      if (is_categorical) {
+        view.columns_.push_back(static_cast<const int32_t*>(column->values) +
+                                begin);
+      } else {
+        view.columns_.push_back(static_cast<const float*>(column->values) +
+                                begin);
+      }
+    }
+    return view;
+  }
+
+  int NumberOfExamples() const { return num_examples_; }
+
+  float GetNumerical(const int example_idx, const NumericalFeatureId feature_id,
+                     const Model& model) const {
+    const float value =
+        static_cast<const float*>(columns_[feature_id.index])[example_idx];
+    if (std::isnan(value)) {
+      return model.features()
+          .fixed_length_na_replacement_values()[feature_id.index]
+          .numerical_value;
+    }
+    return value;
+  }
+
+  int GetCategoricalInt(const int example_idx,
+                        const CategoricalFeatureId feature_id,
+                        const Model& model) const {
+    const int32_t value =
+        static_cast<const int32_t*>(columns_[feature_id.index])[example_idx];
+    if (value < 0) {
+      return model.features()
+          .fixed_length_na_replacement_values()[feature_id.index]
+          .categorical_value;
+    }
+    return value;
+  }
+
+  bool IsMissingCategoricalAndNumerical(const int example_idx,
+                                        const int feature_index,
+                                        const Model& model) const {
+    if (model.features().fixed_length_features()[feature_index].type ==
+        dataset::proto::ColumnType::CATEGORICAL) {
+      return static_cast<const int32_t*>(columns_[feature_index])[example_idx] <
+             0;
+    }
+    return std::isnan(
+        static_cast<const float*>(columns_[feature_index])[example_idx]);
+  }
+
+ private:
+  ColumnarExampleSetView() = default;
+
+  int64_t num_examples_ = 0;
+  // Values of the fixed length features, indexed by internal feature index.
+  std::vector<const void*> columns_;
+};
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_COLUMNAR_EXAMPLES_H_
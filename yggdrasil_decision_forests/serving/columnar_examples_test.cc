@@ -0,0 +1,164 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/test_utils.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+using test::StatusIs;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+// Checks the columnar predictions of the fast engine of "model_name" on
+// "dataset_filename" against the generic model inference. If
+// "compact_columns", the categorical columns are stored compactly.
+void CheckPredictColumnar(const absl::string_view model_name,
+                          const absl::string_view dataset_filename,
+                          const bool compact_columns = false) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), &model));
+
+  dataset::LoadConfig config;
+  if (compact_columns) {
+    config.compact_columns.emplace(model->data_spec().columns_size());
+    std::iota(config.compact_columns->begin(), config.compact_columns->end(),
+              0);
+  }
+  dataset::VerticalDataset dataset;
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", dataset_filename)),
+      model->data_spec(), &dataset, {}, config));
+
+  ASSERT_OK_AND_ASSIGN(const auto engine, model->BuildFastEngine());
+  ASSERT_OK_AND_ASSIGN(const auto examples,
+                       ColumnarExamples::FromVerticalDataset(
+                           dataset, 0, dataset.nrow(), engine->features()));
+  std::vector<float> predictions(dataset.nrow() *
+                                 engine->NumPredictionDimension());
+  ASSERT_OK(engine->PredictColumnar(examples, absl::MakeSpan(predictions)));
+  utils::ExpectEqualPredictions(dataset, 0, dataset.nrow(), *model,
+                                predictions);
+}
+
+TEST(ColumnarExamples, AdultBinaryClassGBT) {
+  CheckPredictColumnar("adult_binary_class_gbdt", "adult_test.csv");
+}
+
+TEST(ColumnarExamples, AdultBinaryClassGBTCompactColumns) {
+  CheckPredictColumnar("adult_binary_class_gbdt", "adult_test.csv",
+                       /*compact_columns=*/true);
+}
+
+TEST(ColumnarExamples, IrisMultiClassGBT) {
+  CheckPredictColumnar("iris_multi_class_gbdt", "iris.csv");
+}
+
+TEST(ColumnarExamples, AbaloneRegressionGBT) {
+  CheckPredictColumnar("abalone_regression_gbdt", "abalone.csv");
+}
+
+TEST(ColumnarExamples, AdultBinaryClassRF) {
+  CheckPredictColumnar("adult_binary_class_rf", "adult_test.csv");
+}
+
+TEST(ColumnarExamples, IrisMultiClassRF) {
+  CheckPredictColumnar("iris_multi_class_rf", "iris.csv");
+}
+
+TEST(ColumnarExamples, ExternalBuffers) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "iris_multi_class_rf"), &model));
+  ASSERT_OK_AND_ASSIGN(const auto engine, model->BuildFastEngine());
+
+  ColumnarExamples examples(2);
+  const std::vector<std::vector<float>> values = {
+      {5.1f, 7.0f}, {3.5f, 3.2f}, {1.4f, 4.7f}, {0.2f, 1.4f}};
+  ASSERT_EQ(engine->features().fixed_length_features().size(), values.size());
+  for (int feature_idx = 0; feature_idx < values.size(); feature_idx++) {
+    ASSERT_OK(examples.AddNumericalColumn(
+        engine->features().fixed_length_features()[feature_idx].name,
+        values[feature_idx]));
+  }
+  std::vector<float> predictions(2 * engine->NumPredictionDimension());
+  ASSERT_OK(engine->PredictColumnar(examples, absl::MakeSpan(predictions)));
+
+  // Same examples through the regular example-major API.
+  auto example_set = engine->AllocateExamples(2);
+  ASSERT_OK(CopyColumnarExamplesToAbstractExampleSet(
+      examples, 0, 2, engine->features(), example_set.get()));
+  std::vector<float> expected_predictions;
+  engine->Predict(*example_set, 2, &expected_predictions);
+  EXPECT_EQ(predictions, expected_predictions);
+}
+
+TEST(ColumnarExamples, InvalidColumns) {
+  ColumnarExamples examples(2);
+  const std::vector<float> values = {1.f, 2.f, 3.f};
+  EXPECT_THAT(examples.AddNumericalColumn("a", values),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  ASSERT_OK(examples.AddNumericalColumn("a", absl::MakeConstSpan(values)
+                                                 .subspan(0, 2)));
+  EXPECT_THAT(examples.AddNumericalColumn("a", absl::MakeConstSpan(values)
+                                                   .subspan(0, 2)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_NE(examples.FindColumn("a"), nullptr);
+  EXPECT_EQ(examples.FindColumn("b"), nullptr);
+}
+
+TEST(ColumnarExamples, MissingColumn) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "abalone_regression_gbdt"),
+      &model));
+  ASSERT_OK_AND_ASSIGN(const auto engine, model->BuildFastEngine());
+  ColumnarExamples examples(1);
+  std::vector<float> predictions(1);
+  EXPECT_THAT(engine->PredictColumnar(examples, absl::MakeSpan(predictions)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
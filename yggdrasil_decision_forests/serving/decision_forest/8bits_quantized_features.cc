@@ -0,0 +1,727 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/8bits_quantized_features.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/numeric/bits.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/substitute.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
+#include "yggdrasil_decision_forests/utils/bitmap.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace quantized_8bits {
+namespace {
+
+using dataset::proto::ColumnType;
+using model::decision_tree::DecisionTree;
+using model::decision_tree::NodeWithChildren;
+using model::decision_tree::proto::Condition;
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using model::gradient_boosted_trees::proto::Loss;
+using model::random_forest::RandomForestModel;
+
+using DecisionTrees = std::vector<std::unique_ptr<DecisionTree>>;
+using Activation = QuantizedLookupModel::Activation;
+
+// Number of "LeafMask" of the active leaves stored without heap allocation in
+// "Predict" e.g. 16 trees of up to 64 leaves.
+constexpr int kNumInlinedMaskWords = 16;
+
+// Sets the "num_leaf_values" values of a leaf.
+using SetLeafFn =
+    std::function<absl::Status(const NodeWithChildren& node, float* values)>;
+
+// Bins of a feature, computed from the conditions of the model.
+struct FeatureBins {
+  bool is_categorical = false;
+
+  // Sorted unique thresholds of a numerical feature.
+  std::vector<float> thresholds;
+
+  // Bin of each categorical value.
+  std::vector<uint8_t> categorical_bins;
+
+  int num_bins = 0;
+};
+
+// Bins of the features used in the conditions, indexed by column index.
+using FeatureBinsMap = std::map<int, FeatureBins>;
+
+// Threshold "t" of a condition "value >= t" on a numerical, discretized
+// numerical or boolean feature.
+absl::StatusOr<float> ConditionThreshold(const Condition& condition,
+                                         const dataset::proto::Column& spec) {
+  switch (condition.type_case()) {
+    case Condition::kHigherCondition:
+      return condition.higher_condition().threshold();
+    case Condition::kDiscretizedHigherCondition:
+      return spec.discretized_numerical().boundaries(
+          condition.discretized_higher_condition().threshold() - 1);
+    case Condition::kTrueValueCondition:
+      // Booleans are stored as numerical 0/1 values in the example set.
+      return 0.5f;
+    default:
+      return absl::InternalError("Not a threshold condition");
+  }
+}
+
+// Lists the categorical values contained in a "contains" condition.
+std::vector<int> ContainedValues(const Condition& condition,
+                                 const dataset::proto::Column& spec) {
+  std::vector<int> values;
+  if (condition.type_case() == Condition::kContainsCondition) {
+    values.assign(condition.contains_condition().elements().begin(),
+                  condition.contains_condition().elements().end());
+  } else {
+    const auto& bitmap =
+        condition.contains_bitmap_condition().elements_bitmap();
+    const int num_values = spec.categorical().number_of_unique_values();
+    for (int value = 0; value < num_values; value++) {
+      if (utils::bitmap::GetValueBit(bitmap, value)) {
+        values.push_back(value);
+      }
+    }
+  }
+  return values;
+}
+
+// Computes the bins of the features from the conditions of the trees.
+absl::Status ComputeFeatureBins(const DecisionTrees& trees,
+                                const dataset::proto::DataSpecification& spec,
+                                FeatureBinsMap* bins) {
+  // "value_conditions[f][v]" is the list of conditions containing the value
+  // "v" of the categorical feature "f".
+  std::map<int, std::vector<std::vector<int>>> value_conditions;
+  int num_categorical_conditions = 0;
+  absl::Status status;
+
+  for (const auto& tree : trees) {
+    tree->IterateOnNodes([&](const NodeWithChildren& node, const int depth) {
+      if (node.IsLeaf() || !status.ok()) {
+        return;
+      }
+      const int attribute = node.node().condition().attribute();
+      const auto& col_spec = spec.columns(attribute);
+      const auto& condition = node.node().condition().condition();
+      switch (condition.type_case()) {
+        case Condition::kHigherCondition:
+        case Condition::kDiscretizedHigherCondition:
+        case Condition::kTrueValueCondition: {
+          const auto threshold = ConditionThreshold(condition, col_spec);
+          if (!threshold.ok()) {
+            status = threshold.status();
+            return;
+          }
+          (*bins)[attribute].thresholds.push_back(threshold.value());
+        } break;
+
+        case Condition::kContainsCondition:
+        case Condition::kContainsBitmapCondition: {
+          if (col_spec.type() != ColumnType::CATEGORICAL) {
+            status = absl::InvalidArgumentError(absl::Substitute(
+                "Feature \"$0\" is not categorical.", col_spec.name()));
+            return;
+          }
+          auto& feature_values = value_conditions[attribute];
+          feature_values.resize(
+              col_spec.categorical().number_of_unique_values());
+          for (const int value : ContainedValues(condition, col_spec)) {
+            if (value >= 0 && value < feature_values.size()) {
+              feature_values[value].push_back(num_categorical_conditions);
+            }
+          }
+          num_categorical_conditions++;
+          (*bins)[attribute].is_categorical = true;
+        } break;
+
+        default:
+          status = absl::InvalidArgumentError(
+              absl::Substitute("Non supported condition on feature \"$0\".",
+                               col_spec.name()));
+          return;
+      }
+    });
+    RETURN_IF_ERROR(status);
+  }
+
+  for (auto& [attribute, feature_bins] : *bins) {
+    const auto& col_spec = spec.columns(attribute);
+    if (feature_bins.is_categorical) {
+      // Values contained in the same set of conditions are in the same bin.
+      const auto& feature_values = value_conditions[attribute];
+      std::map<std::vector<int>, int> signature_to_bin;
+      feature_bins.categorical_bins.resize(feature_values.size());
+      for (int value = 0; value < feature_values.size(); value++) {
+        const auto it = signature_to_bin
+                            .insert({feature_values[value],
+                                     static_cast<int>(signature_to_bin.size())})
+                            .first;
+        if (it->second >= kMaxBins) {
+          return absl::InvalidArgumentError(absl::Substitute(
+              "Feature \"$0\" requires more than $1 bins.", col_spec.name(),
+              kMaxBins));
+        }
+        feature_bins.categorical_bins[value] = it->second;
+      }
+      feature_bins.num_bins = signature_to_bin.size();
+    } else {
+      auto& thresholds = feature_bins.thresholds;
+      std::sort(thresholds.begin(), thresholds.end());
+      thresholds.erase(std::unique(thresholds.begin(), thresholds.end()),
+                       thresholds.end());
+      feature_bins.num_bins = thresholds.size() + 1;
+      if (feature_bins.num_bins > kMaxBins) {
+        return absl::InvalidArgumentError(absl::Substitute(
+            "Feature \"$0\" has $1 unique thresholds. The maximum is $2.",
+            col_spec.name(), thresholds.size(), kMaxBins - 1));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+int MaxNumLeafs(const DecisionTrees& trees) {
+  int64_t max_num_leafs = 0;
+  for (const auto& tree : trees) {
+    max_num_leafs = std::max(max_num_leafs, tree->NumLeafs());
+  }
+  return max_num_leafs;
+}
+
+int NumMaskWords(const int max_num_leafs) {
+  return std::max(1, (max_num_leafs + kLeafMaskBits - 1) / kLeafMaskBits);
+}
+
+// Checks the structure of the trees and computes the feature bins.
+template <typename Model>
+absl::Status CheckTrees(const Model& src, FeatureBinsMap* bins) {
+  if (!src.CheckStructure(
+          model::decision_tree::CheckStructureOptions::GlobalImputation())) {
+    return absl::InvalidArgumentError(
+        "The model should be trained with global imputation.");
+  }
+  if (src.decision_trees().empty()) {
+    return absl::InvalidArgumentError("The model does not contain any tree.");
+  }
+  const int max_num_leafs = MaxNumLeafs(src.decision_trees());
+  if (max_num_leafs > kMaxLeafs) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The model contains trees with $0 leaves. The maximum is $1.",
+        max_num_leafs, kMaxLeafs));
+  }
+  RETURN_IF_ERROR(
+      ComputeFeatureBins(src.decision_trees(), src.data_spec(), bins));
+
+  size_t num_bins = 0;
+  for (const auto& feature_bins : *bins) {
+    num_bins += feature_bins.second.num_bins;
+  }
+  const size_t mask_bytes = num_bins * src.decision_trees().size() *
+                            NumMaskWords(max_num_leafs) * sizeof(LeafMask);
+  if (mask_bytes > kMaxMaskBytes) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The masks would use $0 bytes. The maximum is $1.", mask_bytes,
+        kMaxMaskBytes));
+  }
+  return absl::OkStatus();
+}
+
+// Configures the output of a GBT model, and returns the leaf setter.
+absl::StatusOr<SetLeafFn> SetOutput(const GradientBoostedTreesModel& src,
+                                    QuantizedLookupModel* dst) {
+  switch (src.loss()) {
+    case Loss::BINOMIAL_LOG_LIKELIHOOD:
+    case Loss::BINARY_FOCAL_LOSS:
+      dst->activation = Activation::kSigmoid;
+      break;
+    case Loss::MULTINOMIAL_LOG_LIKELIHOOD:
+      dst->activation = Activation::kSoftmax;
+      break;
+    case Loss::POISSON:
+      dst->activation = Activation::kPoisson;
+      break;
+    case Loss::SQUARED_ERROR:
+    case Loss::MEAN_AVERAGE_ERROR:
+    case Loss::LAMBDA_MART_NDCG:
+    case Loss::LAMBDA_MART_NDCG5:
+    case Loss::XE_NDCG_MART:
+      dst->activation = Activation::kIdentity;
+      break;
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Non supported loss: ", Loss_Name(src.loss())));
+  }
+  if (src.output_logits()) {
+    dst->activation = Activation::kIdentity;
+  }
+
+  dst->num_classes = src.initial_predictions().size();
+  if (dst->num_classes == 0 || src.NumTrees() % dst->num_classes != 0) {
+    return absl::InvalidArgumentError("Unexpected number of trees");
+  }
+  dst->num_leaf_values = 1;
+  dst->initial_predictions.assign(src.initial_predictions().begin(),
+                                  src.initial_predictions().end());
+  return [](const NodeWithChildren& node, float* values) -> absl::Status {
+    values[0] = node.node().regressor().top_value();
+    return absl::OkStatus();
+  };
+}
+
+// Configures the output of a RF model, and returns the leaf setter.
+absl::StatusOr<SetLeafFn> SetOutput(const RandomForestModel& src,
+                                    QuantizedLookupModel* dst) {
+  const float normalization = 1.f / src.NumTrees();
+  switch (src.task()) {
+    case model::proto::Task::CLASSIFICATION: {
+      const int num_labels =
+          src.label_col_spec().categorical().number_of_unique_values() - 1;
+      // Binary classification models output the probability of the positive
+      // class.
+      const int first_label = (num_labels == 2) ? 2 : 1;
+      dst->num_classes = (num_labels == 2) ? 1 : num_labels;
+      dst->num_leaf_values = dst->num_classes;
+      dst->activation = Activation::kClamp01;
+      const int num_classes = dst->num_classes;
+      const bool winner_take_all = src.winner_take_all_inference();
+      return [=](const NodeWithChildren& node, float* values) -> absl::Status {
+        const auto& classifier = node.node().classifier();
+        if (winner_take_all) {
+          const int vote = classifier.top_value();
+          if (vote == dataset::kOutOfDictionaryItemIndex) {
+            return absl::InvalidArgumentError(
+                "The model contains out-of-dictionary leaf values.");
+          }
+          for (int dim = 0; dim < num_classes; dim++) {
+            values[dim] = (vote == first_label + dim) ? normalization : 0.f;
+          }
+        } else {
+          const auto& distribution = classifier.distribution();
+          if (distribution.counts_size() < first_label + num_classes) {
+            return absl::InvalidArgumentError("Unexpected leaf distribution");
+          }
+          for (int dim = 0; dim < num_classes; dim++) {
+            values[dim] =
+                static_cast<float>(distribution.counts(first_label + dim) /
+                                   distribution.sum()) *
+                normalization;
+          }
+        }
+        return absl::OkStatus();
+      };
+    }
+
+    case model::proto::Task::REGRESSION:
+      dst->num_classes = 1;
+      dst->num_leaf_values = 1;
+      dst->activation = Activation::kIdentity;
+      return [=](const NodeWithChildren& node, float* values) -> absl::Status {
+        values[0] = node.node().regressor().top_value() * normalization;
+        return absl::OkStatus();
+      };
+
+    default:
+      return absl::InvalidArgumentError(
+          "Only classification and regression Random Forest models are "
+          "supported.");
+  }
+}
+
+// Compilation of the trees into leaf masks.
+class MaskBuilder {
+ public:
+  MaskBuilder(const FeatureBinsMap& bins, const int num_trees,
+              const int num_mask_words)
+      : bins_(bins), num_trees_(num_trees), num_mask_words_(num_mask_words) {
+    for (const auto& [attribute, feature_bins] : bins_) {
+      rows_[attribute].assign(static_cast<size_t>(feature_bins.num_bins) *
+                                  RowSize(),
+                              ~static_cast<LeafMask>(0));
+    }
+  }
+
+  // Adds the conditions and leaves of a tree. "leaf_idx" is the number of
+  // leaves already visited in the tree.
+  absl::Status AddNode(const NodeWithChildren& node, const int tree_idx,
+                       const dataset::proto::DataSpecification& spec,
+                       const SetLeafFn& set_leaf, QuantizedLookupModel* dst,
+                       int* leaf_idx) {
+    if (node.IsLeaf()) {
+      const size_t value_idx =
+          static_cast<size_t>(dst->leaf_offsets[tree_idx] + *leaf_idx) *
+          dst->num_leaf_values;
+      RETURN_IF_ERROR(set_leaf(node, &dst->leaf_values[value_idx]));
+      (*leaf_idx)++;
+      return absl::OkStatus();
+    }
+
+    // The leaves of the negative branch are hidden when the condition is true.
+    const int begin_neg_leaf_idx = *leaf_idx;
+    RETURN_IF_ERROR(
+        AddNode(*node.neg_child(), tree_idx, spec, set_leaf, dst, leaf_idx));
+    const int end_neg_leaf_idx = *leaf_idx;
+
+    std::vector<LeafMask> tree_mask(num_mask_words_, ~static_cast<LeafMask>(0));
+    for (int leaf = begin_neg_leaf_idx; leaf < end_neg_leaf_idx; leaf++) {
+      tree_mask[leaf / kLeafMaskBits] &=
+          ~(static_cast<LeafMask>(1) << (leaf % kLeafMaskBits));
+    }
+
+    const int attribute = node.node().condition().attribute();
+    const auto& col_spec = spec.columns(attribute);
+    const auto& condition = node.node().condition().condition();
+    const auto& feature_bins = bins_.at(attribute);
+    if (feature_bins.is_categorical) {
+      std::vector<bool> true_bins(feature_bins.num_bins, false);
+      for (const int value : ContainedValues(condition, col_spec)) {
+        if (value >= 0 && value < feature_bins.categorical_bins.size()) {
+          true_bins[feature_bins.categorical_bins[value]] = true;
+        }
+      }
+      for (int bin = 0; bin < feature_bins.num_bins; bin++) {
+        if (true_bins[bin]) {
+          ApplyMask(attribute, bin, tree_idx, tree_mask);
+        }
+      }
+    } else {
+      ASSIGN_OR_RETURN(const float threshold,
+                       ConditionThreshold(condition, col_spec));
+      // The condition is true for the bins containing values >= threshold.
+      const int first_true_bin =
+          std::lower_bound(feature_bins.thresholds.begin(),
+                           feature_bins.thresholds.end(), threshold) -
+          feature_bins.thresholds.begin() + 1;
+      for (int bin = first_true_bin; bin < feature_bins.num_bins; bin++) {
+        ApplyMask(attribute, bin, tree_idx, tree_mask);
+      }
+    }
+
+    return AddNode(*node.pos_child(), tree_idx, spec, set_leaf, dst, leaf_idx);
+  }
+
+  // Exports the unique masks into the model.
+  void Finalize(QuantizedLookupModel* dst) {
+    const size_t row_size = RowSize();
+    const std::vector<LeafMask> full_mask(row_size, ~static_cast<LeafMask>(0));
+    dst->masks = full_mask;
+    dst->bin_to_mask.clear();
+
+    for (auto& feature : dst->quantized_features) {
+      const int attribute = dst->features()
+                                .fixed_length_features()[feature.internal_idx]
+                                .spec_idx;
+      const auto& feature_bins = bins_.at(attribute);
+      const auto& rows = rows_.at(attribute);
+      feature.bin_offset = dst->bin_to_mask.size();
+
+      uint32_t last_mask_idx = 0;
+      const LeafMask* last_row = full_mask.data();
+      for (int bin = 0; bin < feature_bins.num_bins; bin++) {
+        const LeafMask* row = &rows[bin * row_size];
+        if (std::equal(row, row + row_size, full_mask.data())) {
+          dst->bin_to_mask.push_back(0);
+          continue;
+        }
+        if (!std::equal(row, row + row_size, last_row)) {
+          last_mask_idx = dst->masks.size();
+          dst->masks.insert(dst->masks.end(), row, row + row_size);
+          last_row = row;
+        }
+        dst->bin_to_mask.push_back(last_mask_idx);
+      }
+    }
+  }
+
+ private:
+  size_t RowSize() const {
+    return static_cast<size_t>(num_trees_) * num_mask_words_;
+  }
+
+  void ApplyMask(const int attribute, const int bin, const int tree_idx,
+                 const std::vector<LeafMask>& tree_mask) {
+    LeafMask* dst = &rows_[attribute][bin * RowSize() +
+                                      tree_idx * num_mask_words_];
+    for (int word = 0; word < num_mask_words_; word++) {
+      dst[word] &= tree_mask[word];
+    }
+  }
+
+  const FeatureBinsMap& bins_;
+  const int num_trees_;
+  const int num_mask_words_;
+
+  // "rows_[f][b * RowSize() ...]" are the masks of all the trees for the bin
+  // "b" of the feature "f".
+  std::map<int, std::vector<LeafMask>> rows_;
+};
+
+template <typename Model>
+absl::Status CheckCompatibilityImpl(const Model& src) {
+  QuantizedLookupModel dummy;
+  RETURN_IF_ERROR(SetOutput(src, &dummy).status());
+  FeatureBinsMap bins;
+  return CheckTrees(src, &bins);
+}
+
+template <typename Model>
+absl::Status GenericToSpecializedModelImpl(const Model& src,
+                                           QuantizedLookupModel* dst) {
+  ASSIGN_OR_RETURN(const auto set_leaf, SetOutput(src, dst));
+  FeatureBinsMap bins;
+  RETURN_IF_ERROR(CheckTrees(src, &bins));
+
+  src.metadata().Export(&dst->metadata);
+  const auto& trees = src.decision_trees();
+  dst->num_trees = trees.size();
+  dst->num_mask_words = NumMaskWords(MaxNumLeafs(trees));
+  if (dst->initial_predictions.empty()) {
+    dst->initial_predictions.assign(dst->num_classes, 0.f);
+  }
+
+  std::vector<int> input_features;
+  RETURN_IF_ERROR(GetInputFeatures(src, &input_features, nullptr));
+  RETURN_IF_ERROR(dst->mutable_features()->Initialize(
+      input_features, src.data_spec(), /*missing_numerical_is_na=*/false));
+
+  // Only the features used in conditions are quantized.
+  dst->quantized_features.clear();
+  for (const auto& feature : dst->features().fixed_length_features()) {
+    const auto it_bins = bins.find(feature.spec_idx);
+    if (it_bins == bins.end()) {
+      continue;
+    }
+    QuantizedLookupModel::QuantizedFeature quantized_feature;
+    quantized_feature.internal_idx = feature.internal_idx;
+    quantized_feature.is_categorical = it_bins->second.is_categorical;
+    quantized_feature.thresholds = it_bins->second.thresholds;
+    quantized_feature.categorical_bins = it_bins->second.categorical_bins;
+    quantized_feature.bin_offset = 0;
+    dst->quantized_features.push_back(std::move(quantized_feature));
+  }
+  if (dst->quantized_features.size() != bins.size()) {
+    return absl::InvalidArgumentError(
+        "The conditions use features that are not input features.");
+  }
+
+  // Leaves.
+  dst->leaf_offsets.resize(dst->num_trees);
+  uint32_t num_leafs = 0;
+  for (int tree_idx = 0; tree_idx < dst->num_trees; tree_idx++) {
+    dst->leaf_offsets[tree_idx] = num_leafs;
+    num_leafs += trees[tree_idx]->NumLeafs();
+  }
+  dst->leaf_values.assign(
+      static_cast<size_t>(num_leafs) * dst->num_leaf_values, 0.f);
+
+  // Masks.
+  MaskBuilder builder(bins, dst->num_trees, dst->num_mask_words);
+  for (int tree_idx = 0; tree_idx < dst->num_trees; tree_idx++) {
+    int leaf_idx = 0;
+    RETURN_IF_ERROR(builder.AddNode(trees[tree_idx]->root(), tree_idx,
+                                    src.data_spec(), set_leaf, dst,
+                                    &leaf_idx));
+  }
+  builder.Finalize(dst);
+  return absl::OkStatus();
+}
+
+// Applies the activation function on the "num_classes" outputs of an example.
+void Activate(const QuantizedLookupModel& model, float* values) {
+  switch (model.activation) {
+    case Activation::kIdentity:
+      break;
+    case Activation::kSigmoid:
+      values[0] = std::clamp(1.f / (1.f + std::exp(-values[0])), 0.f, 1.f);
+      break;
+    case Activation::kPoisson:
+      values[0] = std::exp(std::clamp(
+          values[0], -GradientBoostedTreesModel::kPoissonLossClampBounds,
+          GradientBoostedTreesModel::kPoissonLossClampBounds));
+      break;
+    case Activation::kClamp01:
+      for (int dim = 0; dim < model.num_classes; dim++) {
+        values[dim] = std::clamp(values[dim], 0.f, 1.f);
+      }
+      break;
+    case Activation::kSoftmax: {
+      float sum = 0.f;
+      for (int dim = 0; dim < model.num_classes; dim++) {
+        values[dim] = std::exp(values[dim]);
+        sum += values[dim];
+      }
+      const float normalize = 1.f / sum;
+      for (int dim = 0; dim < model.num_classes; dim++) {
+        values[dim] *= normalize;
+      }
+    } break;
+  }
+}
+
+}  // namespace
+
+absl::Status CheckCompatibility(const GradientBoostedTreesModel& src) {
+  return CheckCompatibilityImpl(src);
+}
+
+absl::Status CheckCompatibility(const RandomForestModel& src) {
+  return CheckCompatibilityImpl(src);
+}
+
+absl::Status GenericToSpecializedModel(const GradientBoostedTreesModel& src,
+                                       QuantizedLookupModel* dst) {
+  return GenericToSpecializedModelImpl(src, dst);
+}
+
+absl::Status GenericToSpecializedModel(const RandomForestModel& src,
+                                       QuantizedLookupModel* dst) {
+  return GenericToSpecializedModelImpl(src, dst);
+}
+
+void Predict(const QuantizedLookupModel& model,
+             const QuantizedLookupModel::ExampleSet& examples,
+             const int num_examples, std::vector<float>* predictions) {
+  const int num_classes = model.num_classes;
+  predictions->resize(static_cast<size_t>(num_examples) * num_classes);
+
+  const size_t num_features = model.features().fixed_length_features().size();
+  const int num_trees = model.num_trees;
+  const int num_mask_words = model.num_mask_words;
+  const size_t mask_size = static_cast<size_t>(num_trees) * num_mask_words;
+  const bool multi_dim_leaves = model.num_leaf_values > 1;
+
+  const LeafMask* __restrict masks = model.masks.data();
+  const uint32_t* __restrict bin_to_mask = model.bin_to_mask.data();
+  // Active leaves of the current example. Allocated once for the batch and
+  // re-initialized for each example.
+  absl::InlinedVector<LeafMask, kNumInlinedMaskWords> active_leaves(mask_size);
+  LeafMask* __restrict active = active_leaves.data();
+
+  const auto& values = examples.InternalCategoricalAndNumericalValues();
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const NumericalOrCategoricalValue* example =
+        &values[example_idx * num_features];
+    std::fill(active, active + mask_size, ~static_cast<LeafMask>(0));
+
+    // Quantize the feature values and apply the masks.
+    for (const auto& feature : model.quantized_features) {
+      const auto value = example[feature.internal_idx];
+      int bin;
+      if (feature.is_categorical) {
+        const int categorical_value = value.categorical_value;
+        bin = (categorical_value >= 0 &&
+               categorical_value < feature.categorical_bins.size())
+                  ? feature.categorical_bins[categorical_value]
+                  : feature.categorical_bins[0];
+      } else {
+        bin = std::upper_bound(feature.thresholds.begin(),
+                               feature.thresholds.end(),
+                               value.numerical_value) -
+              feature.thresholds.begin();
+      }
+      const uint32_t mask_idx = bin_to_mask[feature.bin_offset + bin];
+      if (mask_idx == 0) {
+        continue;
+      }
+      const LeafMask* __restrict mask = &masks[mask_idx];
+      for (size_t i = 0; i < mask_size; i++) {
+        active[i] &= mask[i];
+      }
+    }
+
+    // Accumulate the values of the active leaves.
+    float* output = &(*predictions)[example_idx * num_classes];
+    std::copy(model.initial_predictions.begin(),
+              model.initial_predictions.end(), output);
+    for (int tree_idx = 0; tree_idx < num_trees; tree_idx++) {
+      const LeafMask* tree_mask = &active[tree_idx * num_mask_words];
+      int word = 0;
+      while (tree_mask[word] == 0) {
+        word++;
+      }
+      const int leaf_idx =
+          word * kLeafMaskBits + absl::countr_zero(tree_mask[word]);
+      const float* leaf_values =
+          &model.leaf_values[static_cast<size_t>(
+                                 model.leaf_offsets[tree_idx] + leaf_idx) *
+                             model.num_leaf_values];
+      if (multi_dim_leaves) {
+        for (int dim = 0; dim < num_classes; dim++) {
+          output[dim] += leaf_values[dim];
+        }
+      } else {
+        output[tree_idx % num_classes] += leaf_values[0];
+      }
+    }
+    Activate(model, output);
+  }
+}
+
+std::string EngineDetails(const QuantizedLookupModel& model) {
+  std::string details;
+  absl::StrAppendFormat(&details, "Number of trees: %d\n", model.num_trees);
+  absl::StrAppendFormat(&details, "Mask words per tree: %d\n",
+                        model.num_mask_words);
+  absl::StrAppendFormat(&details, "Quantized features: %d\n",
+                        model.quantized_features.size());
+  for (const auto& feature : model.quantized_features) {
+    const auto& spec_idx = model.features()
+                               .fixed_length_features()[feature.internal_idx]
+                               .spec_idx;
+    const int num_bins =
+        feature.is_categorical
+            ? *std::max_element(feature.categorical_bins.begin(),
+                                feature.categorical_bins.end()) +
+                  1
+            : feature.thresholds.size() + 1;
+    absl::StrAppendFormat(&details, "\t#%d %s bins:%d\n", spec_idx,
+                          feature.is_categorical ? "categorical" : "numerical",
+                          num_bins);
+  }
+  absl::StrAppendFormat(&details, "Ram usage (in bytes)\n");
+  absl::StrAppendFormat(&details, "\tmasks: %d\n",
+                        model.masks.size() * sizeof(LeafMask));
+  absl::StrAppendFormat(&details, "\tbin_to_mask: %d\n",
+                        model.bin_to_mask.size() * sizeof(uint32_t));
+  absl::StrAppendFormat(&details, "\tleaves: %d\n",
+                        model.leaf_values.size() * sizeof(float));
+  return details;
+}
+
+}  // namespace quantized_8bits
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Generalization of the 8 bits numerical lookup engine (see
+// "8bits_numerical_features.h") to any numerical, boolean and categorical
+// features, and to Gradient Boosted Trees and Random Forest models.
+//
+// At compilation time, the values of each input feature are partitioned into
+// at most 256 bins such that all the values in a bin evaluate all the
+// conditions of the model identically:
+//   - Numerical, discretized numerical and boolean features: The bins are
+//     delimited by the sorted unique thresholds of the conditions of the
+//     model. Since the trees only compare the feature value to those
+//     thresholds, this quantization is exact.
+//   - Categorical features: Categorical values contained in exactly the same
+//     conditions are merged in the same bin.
+//
+// For each (feature, bin), the engine pre-computes the leaf mask of all the
+// trees (similarly to QuickScorer). At inference time, each feature value is
+// quantized (binary search over the thresholds or categorical lookup table),
+// and the masks of the bins are ANDed. The active leaf of each tree is the
+// first active bit of its mask.
+//
+// Limitations:
+//   - The model should be trained with global imputation (missing values are
+//     replaced by the global imputation value when set in the example set).
+//     Conditions on missing values are not supported.
+//   - Only the conditions "is higher", "discretized is higher", "is true" and
+//     "contains" on numerical, discretized numerical, boolean and categorical
+//     features are supported. For example, oblique conditions and conditions
+//     on categorical-set features are not supported.
+//   - At most 256 bins per feature (i.e. 255 unique thresholds for numerical
+//     features).
+//   - At most 512 leaves per tree.
+//   - The pre-computed masks should fit in "kMaxMaskBytes" bytes.
+//
+// This engine is registered as a fast engine. It is selected by
+// "AbstractModel::BuildFastEngine" if no faster engine is compatible, or by
+// "AbstractModel::AutotuneFastEngine" if it is the fastest on the model. It
+// is most efficient for models with few features and small trees.
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_8BITS_QUANTIZED_FEATURES_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_8BITS_QUANTIZED_FEATURES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace quantized_8bits {
+
+// Bitmap over 64 leaves of a tree.
+using LeafMask = uint64_t;
+
+static constexpr int kLeafMaskBits = sizeof(LeafMask) * 8;
+
+// Maximum number of bins per feature.
+static constexpr int kMaxBins = 256;
+
+// Maximum number of leaves per tree.
+static constexpr int kMaxLeafs = 8 * kLeafMaskBits;
+
+// Maximum size of the pre-computed masks.
+static constexpr size_t kMaxMaskBytes = 256 * 1024 * 1024;
+
+struct QuantizedLookupModel {
+  using ExampleSet =
+      ExampleSetNumericalOrCategoricalFlat<QuantizedLookupModel,
+                                           ExampleFormat::FORMAT_EXAMPLE_MAJOR>;
+  using ValueType = NumericalOrCategoricalValue;
+
+  // Definition of the input features of the model, and how they are represented
+  // in an input example set.
+  const ExampleSet::FeaturesDefinition& features() const {
+    return intern_features;
+  }
+
+  ExampleSet::FeaturesDefinition* mutable_features() {
+    return &intern_features;
+  }
+
+  ExampleSet::FeaturesDefinition intern_features;
+
+  // Missing values are replaced by the global imputation value.
+  static constexpr bool uses_na_conditions = false;
+
+  enum class Activation {
+    kIdentity,
+    kSigmoid,
+    kSoftmax,
+    kPoisson,
+    kClamp01,
+  };
+
+  // A feature used by at least one condition.
+  struct QuantizedFeature {
+    // Index of the feature in the example set.
+    int internal_idx;
+
+    // If true, the bin of a value "v" is "categorical_bins[v]". Otherwise, the
+    // bin of a value "v" is the number of thresholds lower or equal to "v".
+    bool is_categorical;
+
+    // Sorted unique thresholds of a numerical feature.
+    std::vector<float> thresholds;
+
+    // Bin of each categorical value.
+    std::vector<uint8_t> categorical_bins;
+
+    // Index in "bin_to_mask" of the first bin of the feature.
+    uint32_t bin_offset;
+  };
+
+  std::vector<QuantizedFeature> quantized_features;
+
+  int num_trees;
+
+  // Number of "LeafMask" per tree.
+  int num_mask_words;
+
+  // "masks[bin_to_mask[f.bin_offset + b]...+num_trees * num_mask_words]" are
+  // the leaf masks of all the trees for the value bin "b" of the feature "f".
+  // "bin_to_mask[...] = 0" is the full mask i.e. no leaf is filtered.
+  std::vector<uint32_t> bin_to_mask;
+  std::vector<LeafMask> masks;
+
+  // Number of output dimensions.
+  int num_classes = 1;
+
+  // Number of values in each leaf. Either 1 or "num_classes". If 1 and
+  // "num_classes>1", the tree "t" contributes to the output dimension
+  // "t % num_classes" (i.e. multi-class Gradient Boosted Trees).
+  int num_leaf_values = 1;
+
+  // "leaf_values[(leaf_offsets[t] + l) * num_leaf_values + d]" is the "d-th"
+  // value of the "l-th" leaf of tree "t".
+  std::vector<uint32_t> leaf_offsets;
+  std::vector<float> leaf_values;
+
+  // Bias of each output dimension.
+  std::vector<float> initial_predictions;
+
+  Activation activation = Activation::kIdentity;
+
+  model::proto::Metadata metadata;
+};
+
+// Checks if a model can be compiled with "GenericToSpecializedModel".
+absl::Status CheckCompatibility(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src);
+absl::Status CheckCompatibility(
+    const model::random_forest::RandomForestModel& src);
+
+// Compiles a model.
+absl::Status GenericToSpecializedModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    QuantizedLookupModel* dst);
+absl::Status GenericToSpecializedModel(
+    const model::random_forest::RandomForestModel& src,
+    QuantizedLookupModel* dst);
+
+// Computes the predictions of a batch of examples. The predictions are stored
+// example-major i.e. "predictions[example_idx * model.num_classes + dim]".
+//
+// This method is thread safe.
+void Predict(const QuantizedLookupModel& model,
+             const QuantizedLookupModel::ExampleSet& examples, int num_examples,
+             std::vector<float>* predictions);
+
+// Human readable string with information about the engine.
+std::string EngineDetails(const QuantizedLookupModel& model);
+
+}  // namespace quantized_8bits
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_8BITS_QUANTIZED_FEATURES_H_
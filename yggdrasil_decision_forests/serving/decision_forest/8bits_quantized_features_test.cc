@@ -0,0 +1,400 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/8bits_quantized_features.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/register_engines.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/bitmap.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace quantized_8bits {
+namespace {
+
+using model::decision_tree::DecisionTree;
+using model::decision_tree::NodeWithChildren;
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using test::StatusIs;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+void LoadModelAndDataset(const absl::string_view model_name,
+                         const absl::string_view dataset_filename,
+                         std::unique_ptr<model::AbstractModel>* model,
+                         dataset::VerticalDataset* dataset) {
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), model));
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", dataset_filename)),
+      (*model)->data_spec(), dataset));
+}
+
+std::vector<float> PredictWithEngine(const FastEngine& engine,
+                                     const dataset::VerticalDataset& dataset) {
+  auto examples = engine.AllocateExamples(dataset.nrow());
+  EXPECT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, dataset.nrow(), engine.features(), examples.get()));
+  std::vector<float> predictions;
+  engine.Predict(*examples, dataset.nrow(), &predictions);
+  return predictions;
+}
+
+// Checks that the quantized lookup engine and the generic engine return the
+// same predictions.
+void CheckEqualToGenericEngine(const model::AbstractModel& model,
+                               const dataset::VerticalDataset& dataset,
+                               const absl::string_view engine_name,
+                               const absl::string_view generic_engine_name) {
+  ASSERT_OK_AND_ASSIGN(const auto engine,
+                       model.BuildFastEngine(std::string(engine_name)));
+  ASSERT_OK_AND_ASSIGN(const auto generic_engine,
+                       model.BuildFastEngine(std::string(generic_engine_name)));
+  EXPECT_EQ(engine->NumPredictionDimension(),
+            generic_engine->NumPredictionDimension());
+
+  const auto predictions = PredictWithEngine(*engine, dataset);
+  const auto expected_predictions = PredictWithEngine(*generic_engine, dataset);
+  ASSERT_EQ(predictions.size(), expected_predictions.size());
+  for (int i = 0; i < predictions.size(); i++) {
+    EXPECT_NEAR(predictions[i], expected_predictions[i], 1e-5f) << "i=" << i;
+  }
+}
+
+TEST(QuantizedLookup, IrisGbt) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("iris_multi_class_gbdt", "iris.csv", &model, &dataset);
+  CheckEqualToGenericEngine(*model, dataset,
+                            gradient_boosted_trees::kQuantizedLookup,
+                            gradient_boosted_trees::kGeneric);
+}
+
+TEST(QuantizedLookup, IrisRf) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("iris_multi_class_rf", "iris.csv", &model, &dataset);
+  CheckEqualToGenericEngine(*model, dataset, random_forest::kQuantizedLookup,
+                            random_forest::kGeneric);
+}
+
+TEST(QuantizedLookup, DiscretizedNumericalGbt) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("8bits_numerical_binary_class_gbdt",
+                      "8bits_numerical_test.csv", &model, &dataset);
+  CheckEqualToGenericEngine(*model, dataset,
+                            gradient_boosted_trees::kQuantizedLookup,
+                            gradient_boosted_trees::kGeneric);
+}
+
+TEST(QuantizedLookup, CategoricalAbaloneGbt) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("abalone_regression_gbdt", "abalone.csv", &model,
+                      &dataset);
+  const auto* gbt_model =
+      dynamic_cast<const GradientBoostedTreesModel*>(model.get());
+  ASSERT_NE(gbt_model, nullptr);
+
+  // The "Type" feature is quantized with the categorical bins.
+  QuantizedLookupModel engine;
+  ASSERT_OK(GenericToSpecializedModel(*gbt_model, &engine));
+  EXPECT_TRUE(std::any_of(
+      engine.quantized_features.begin(), engine.quantized_features.end(),
+      [](const auto& feature) { return feature.is_categorical; }));
+
+  CheckEqualToGenericEngine(*model, dataset,
+                            gradient_boosted_trees::kQuantizedLookup,
+                            gradient_boosted_trees::kGeneric);
+}
+
+// A regression GBT with a boolean feature "b" and a categorical feature "c"
+// with the values {<OOD>, x, y, z, w}:
+//   Tree 1: c in {x, z} ? (b ? 3 : 2) : 1
+//   Tree 2: b ? 30 : (c in {y} ? 20 : 10)
+// The conditions follow the global imputation i.e. the missing values are
+// replaced by "b=true" and "c=x".
+void BuildBooleanAndCategoricalModel(GradientBoostedTreesModel* model) {
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "label" }
+    columns {
+      type: BOOLEAN
+      name: "b"
+      boolean { count_true: 10 count_false: 5 }
+    }
+    columns {
+      type: CATEGORICAL
+      name: "c"
+      categorical {
+        number_of_unique_values: 5
+        most_frequent_value: 1
+        items {
+          key: "<OOD>"
+          value { index: 0 }
+        }
+        items {
+          key: "x"
+          value { index: 1 }
+        }
+        items {
+          key: "y"
+          value { index: 2 }
+        }
+        items {
+          key: "z"
+          value { index: 3 }
+        }
+        items {
+          key: "w"
+          value { index: 4 }
+        }
+      }
+    }
+  )pb");
+
+  const auto set_leaf = [](NodeWithChildren* node, const float value) {
+    node->mutable_node()->mutable_regressor()->set_top_value(value);
+  };
+  const auto set_boolean_condition = [](NodeWithChildren* node) {
+    node->CreateChildren();
+    auto* condition = node->mutable_node()->mutable_condition();
+    condition->set_attribute(1);
+    condition->set_na_value(true);
+    condition->mutable_condition()->mutable_true_value_condition();
+  };
+
+  // Tree 1.
+  auto tree_1 = std::make_unique<DecisionTree>();
+  tree_1->CreateRoot();
+  {
+    NodeWithChildren* root = tree_1->mutable_root();
+    root->CreateChildren();
+    auto* condition = root->mutable_node()->mutable_condition();
+    condition->set_attribute(2);
+    condition->set_na_value(true);
+    std::string bitmap;
+    utils::bitmap::AllocateAndZeroBitMap(5, &bitmap);
+    utils::bitmap::SetValueBit(1, &bitmap);
+    utils::bitmap::SetValueBit(3, &bitmap);
+    condition->mutable_condition()
+        ->mutable_contains_bitmap_condition()
+        ->set_elements_bitmap(bitmap);
+    set_leaf(root->mutable_neg_child(), 1.f);
+    NodeWithChildren* node = root->mutable_pos_child();
+    set_boolean_condition(node);
+    set_leaf(node->mutable_neg_child(), 2.f);
+    set_leaf(node->mutable_pos_child(), 3.f);
+  }
+
+  // Tree 2.
+  auto tree_2 = std::make_unique<DecisionTree>();
+  tree_2->CreateRoot();
+  {
+    NodeWithChildren* root = tree_2->mutable_root();
+    set_boolean_condition(root);
+    set_leaf(root->mutable_pos_child(), 30.f);
+    NodeWithChildren* node = root->mutable_neg_child();
+    node->CreateChildren();
+    auto* condition = node->mutable_node()->mutable_condition();
+    condition->set_attribute(2);
+    condition->set_na_value(false);
+    condition->mutable_condition()->mutable_contains_condition()->add_elements(
+        2);
+    set_leaf(node->mutable_neg_child(), 10.f);
+    set_leaf(node->mutable_pos_child(), 20.f);
+  }
+
+  model->set_task(model::proto::Task::REGRESSION);
+  model->set_label_col_idx(0);
+  model->set_data_spec(dataspec);
+  model::gradient_boosted_trees::proto::LossConfiguration loss_config;
+  model->set_loss(model::gradient_boosted_trees::proto::Loss::SQUARED_ERROR,
+                  loss_config);
+  model->mutable_initial_predictions()->push_back(0.f);
+  *model->mutable_input_features() = {1, 2};
+  model->set_num_trees_per_iter(1);
+  model->mutable_decision_trees()->push_back(std::move(tree_1));
+  model->mutable_decision_trees()->push_back(std::move(tree_2));
+}
+
+TEST(QuantizedLookup, BooleanAndCategoricalGbt) {
+  GradientBoostedTreesModel model;
+  BuildBooleanAndCategoricalModel(&model);
+
+  QuantizedLookupModel engine;
+  ASSERT_OK(GenericToSpecializedModel(model, &engine));
+  LOG(INFO) << "Engine:\n" << EngineDetails(engine);
+  ASSERT_EQ(engine.quantized_features.size(), 2);
+
+  // All the combinations of values, including the missing ones (-1).
+  dataset::VerticalDataset dataset;
+  dataset.set_data_spec(model.data_spec());
+  ASSERT_OK(dataset.CreateColumnsFromDataspec());
+  for (int boolean_value = -1; boolean_value < 2; boolean_value++) {
+    for (int categorical_value = -1; categorical_value < 5;
+         categorical_value++) {
+      dataset::proto::Example example;
+      example.add_attributes();
+      auto* boolean_attribute = example.add_attributes();
+      if (boolean_value >= 0) {
+        boolean_attribute->set_boolean(boolean_value == 1);
+      }
+      auto* categorical_attribute = example.add_attributes();
+      if (categorical_value >= 0) {
+        categorical_attribute->set_categorical(categorical_value);
+      }
+      ASSERT_OK(dataset.AppendExampleWithStatus(example));
+    }
+  }
+
+  const std::vector<float> predictions = PredictWithEngine(
+      *model.BuildFastEngine(gradient_boosted_trees::kQuantizedLookup).value(),
+      dataset);
+  // b=NA and b=true are equivalent. c=NA and c=x are equivalent.
+  //                        c=NA  <OOD>  x    y    z    w
+  const std::vector<float> b_true = {33, 31, 33, 31, 33, 31};
+  const std::vector<float> b_false = {12, 11, 12, 21, 12, 11};
+  std::vector<float> expected_predictions;
+  for (const auto* values : {&b_true, &b_false, &b_true}) {
+    expected_predictions.insert(expected_predictions.end(), values->begin(),
+                                values->end());
+  }
+  EXPECT_THAT(predictions, testing::ElementsAreArray(expected_predictions));
+
+  CheckEqualToGenericEngine(model, dataset,
+                            gradient_boosted_trees::kQuantizedLookup,
+                            gradient_boosted_trees::kGeneric);
+}
+
+TEST(QuantizedLookup, DeepRfNotSupported) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_rf", "adult_test.csv", &model,
+                      &dataset);
+  const auto* rf_model =
+      dynamic_cast<const model::random_forest::RandomForestModel*>(
+          model.get());
+  ASSERT_NE(rf_model, nullptr);
+  EXPECT_THAT(CheckCompatibility(*rf_model),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(model->ListCompatibleFastEngineNames(),
+              testing::Not(testing::Contains(random_forest::kQuantizedLookup)));
+}
+
+// A regression GBT with a single tree of 100 leaves:
+//   value >= 1 ? (value >= 2 ? ( ... ) : 1) : 0
+// The prediction is the integer part of the feature value, clamped in [0, 99].
+void BuildChainModel(GradientBoostedTreesModel* model) {
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "label" }
+    columns {
+      type: NUMERICAL
+      name: "f"
+      numerical { mean: 50 min_value: 0 max_value: 100 }
+    }
+  )pb");
+
+  auto tree = std::make_unique<DecisionTree>();
+  tree->CreateRoot();
+  NodeWithChildren* node = tree->mutable_root();
+  for (int threshold = 1; threshold < 100; threshold++) {
+    node->CreateChildren();
+    auto* condition = node->mutable_node()->mutable_condition();
+    condition->set_attribute(1);
+    condition->set_na_value(50 >= threshold);
+    condition->mutable_condition()->mutable_higher_condition()->set_threshold(
+        threshold);
+    node->mutable_neg_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(threshold - 1);
+    node = node->mutable_pos_child();
+  }
+  node->mutable_node()->mutable_regressor()->set_top_value(99);
+
+  model->set_task(model::proto::Task::REGRESSION);
+  model->set_label_col_idx(0);
+  model->set_data_spec(dataspec);
+  model::gradient_boosted_trees::proto::LossConfiguration loss_config;
+  model->set_loss(model::gradient_boosted_trees::proto::Loss::SQUARED_ERROR,
+                  loss_config);
+  model->mutable_initial_predictions()->push_back(0.f);
+  *model->mutable_input_features() = {1};
+  model->set_num_trees_per_iter(1);
+  model->mutable_decision_trees()->push_back(std::move(tree));
+}
+
+TEST(QuantizedLookup, MoreThan64Leaves) {
+  GradientBoostedTreesModel model;
+  BuildChainModel(&model);
+
+  QuantizedLookupModel engine;
+  ASSERT_OK(GenericToSpecializedModel(model, &engine));
+  LOG(INFO) << "Engine:\n" << EngineDetails(engine);
+  EXPECT_EQ(engine.num_trees, 1);
+  EXPECT_EQ(engine.num_mask_words, 2);
+  ASSERT_EQ(engine.quantized_features.size(), 1);
+  EXPECT_EQ(engine.quantized_features[0].thresholds.size(), 99);
+
+  const std::vector<float> values = {-1.f, 0.f,  0.5f, 1.f,  5.f,
+                                     63.5f, 64.f, 98.9f, 99.f, 150.f};
+  QuantizedLookupModel::ExampleSet examples(values.size(), engine);
+  ASSERT_OK_AND_ASSIGN(const auto feature_id,
+                       examples.GetNumericalFeatureId("f", engine));
+  for (int example_idx = 0; example_idx < values.size(); example_idx++) {
+    examples.SetNumerical(example_idx, feature_id, values[example_idx],
+                          engine);
+  }
+  std::vector<float> predictions;
+  Predict(engine, examples, values.size(), &predictions);
+  EXPECT_THAT(predictions,
+              testing::ElementsAre(0.f, 0.f, 0.f, 1.f, 5.f, 63.f, 64.f, 98.f,
+                                   99.f, 99.f));
+}
+
+}  // namespace
+}  // namespace quantized_8bits
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -593,12 +593,12 @@ absl::Status SetLeafNodeRandomForestMulticlassClassification(
           "\"is_already_integerized=true\" and providing label with "
           "\"OOB\"(=0) values during training.");
     }
-    dst_model->label_buffer[begin_label_index + vote - 1] =
+    dst_model->label_buffer.mutable_values()[begin_label_index + vote - 1] =
         1.f / src_model.NumTrees();
   } else {
     const auto& distribution = src_node.node().classifier().distribution();
     for (int class_idx = 0; class_idx < dst_model->num_classes; class_idx++) {
-      dst_model->label_buffer[begin_label_index + class_idx] =
+      dst_model->label_buffer.mutable_values()[begin_label_index + class_idx] =
           static_cast<float>(distribution.counts(class_idx + 1) /
                              (distribution.sum() * src_model.NumTrees()));
     }
@@ -654,7 +654,7 @@ absl::Status SetLeafNodeRandomForestCategoricalUplift(
       /*.label_buffer_offset = */ static_cast<uint32_t>(begin_label_index));
 
   for (int output_idx = 0; output_idx < dst_model->num_classes; output_idx++) {
-    dst_model->label_buffer[begin_label_index + output_idx] =
+    dst_model->label_buffer.mutable_values()[begin_label_index + output_idx] =
         src_node.node().uplift().treatment_effect(output_idx) /
         src_model.NumTrees();
   }
@@ -735,52 +735,117 @@ absl::Status SetLeafGradientBoostedTreesRanking(
   return SetRegressiveLeaf(src_model, src_node, 1.f, dst_node);
 }
 
-// Recursively explore the children of a node and output the result in the flat
-// node array "specialized_node_array".
+// Tests if "Node" is a "GenericNode" i.e. a node that supports inverted
+// conditions.
+template <typename Node>
+constexpr bool kIsGenericNode = std::is_same_v<Node, GenericNode<uint16_t>> ||
+                                std::is_same_v<Node, GenericNode<uint32_t>>;
+
+// Replaces the condition of a non-leaf generic node with its negation. Only
+// called on the conditions accepted by "CanInvertGenericNodeCondition".
+template <typename SpecializedModel>
+absl::Status InvertCondition(const int spec_feature_idx,
+                             SpecializedModel* dst_model,
+                             typename SpecializedModel::NodeType* dst_node) {
+  using GenericNode = typename SpecializedModel::NodeType;
+  const int num_attribute_classes = dst_model->features()
+                                        .data_spec()
+                                        .columns(spec_feature_idx)
+                                        .categorical()
+                                        .number_of_unique_values();
+  switch (dst_node->type) {
+    case GenericNode::Type::kNumericalIsHigherMissingIsFalse:
+      dst_node->type = GenericNode::Type::kNumericalIsLowerMissingIsTrue;
+      break;
+    case GenericNode::Type::kNumericalIsHigherMissingIsTrue:
+      dst_node->type = GenericNode::Type::kNumericalIsLowerMissingIsFalse;
+      break;
+    case GenericNode::Type::kCategoricalContainsMask:
+      // Missing categorical values are replaced by a value of the dictionary,
+      // so the complement of the mask is the exact negation.
+      dst_node->categorical_contains_mask =
+          ~dst_node->categorical_contains_mask &
+          ((uint32_t{1} << num_attribute_classes) - 1);
+      break;
+    case GenericNode::Type::kCategoricalContainsBufferOffset: {
+      auto mask = dst_model->categorical_mask_buffer.begin() +
+                  dst_node->categorical_contains_buffer_offset;
+      for (int value = 0; value < num_attribute_classes; value++) {
+        mask[value] = !mask[value];
+      }
+    } break;
+    default:
+      return absl::InternalError("The condition cannot be inverted");
+  }
+  return absl::OkStatus();
+}
+
+// Converts a tree and appends the result to the flat node array
+// "specialized_node_array". The order of the nodes, and the conditions stored
+// inverted, are given by "FlatNodeLayout".
 //
 // Arguments:
-//   node: Input node to convert.
+//   root: Root of the tree to convert.
 //   spec_feature_idx_to_node_feature_idx: Mapping between the index of the
 //     data_spec and the exported model.
 //   set_leaf and set_non_leaf: Respectively set the content of the leaf and
 //      non-leaf nodes.
 //   specialized_node_array: Output flat node array.
 template <typename GenericModel, typename SpecializedModel>
-absl::Status ConvertGenericNodeToFlatNode(
-    const GenericModel& src_model, const NodeWithChildren& node,
+absl::Status ConvertGenericTreeToFlatNodes(
+    const GenericModel& src_model, const NodeWithChildren& root,
     const SetLeafFunctor<GenericModel, SpecializedModel> set_node,
     const FeatureDefMap& spec_idx_to_feature, SpecializedModel* dst_model,
-    std::vector<typename SpecializedModel::NodeType>* specialized_node_array) {
-  if (node.IsLeaf()) {
-    // Create a leaf.
+    utils::BorrowableVector<typename SpecializedModel::NodeType>*
+        specialized_node_array) {
+  using NodeOffset = typename SpecializedModel::NodeType::NodeOffset;
+  std::function<bool(const NodeWithChildren&)> can_invert;
+  if constexpr (kIsGenericNode<typename SpecializedModel::NodeType>) {
+    can_invert = [&src_model](const NodeWithChildren& node) {
+      return CanInvertGenericNodeCondition(src_model.data_spec(), node);
+    };
+  }
+  const std::vector<FlatNode> layout = FlatNodeLayout(
+      root, std::numeric_limits<NodeOffset>::max(), can_invert);
+
+  // Index of the nodes in "specialized_node_array".
+  const size_t begin_node_idx = specialized_node_array->size();
+  absl::flat_hash_map<const NodeWithChildren*, size_t> node_idxs;
+  node_idxs.reserve(layout.size());
+  for (size_t local_node_idx = 0; local_node_idx < layout.size();
+       local_node_idx++) {
+    node_idxs[layout[local_node_idx].node] = begin_node_idx + local_node_idx;
+  }
+
+  for (const FlatNode& flat_node : layout) {
+    const NodeWithChildren* node = flat_node.node;
     typename SpecializedModel::NodeType dst_node;
-    RETURN_IF_ERROR(set_node(src_model, node, dst_model, &dst_node));
-    specialized_node_array->push_back(dst_node);
-  } else {
-    // Create a non-leaf node.
-    const int spec_feature_idx = node.node().condition().attribute();
-    typename SpecializedModel::NodeType non_leaf_node;
-    RETURN_IF_ERROR(SetNonLeafNode(src_model, node, spec_feature_idx,
-                                   spec_idx_to_feature, dst_model,
-                                   &non_leaf_node));
-    const size_t new_node_idx = specialized_node_array->size();
-    specialized_node_array->push_back(non_leaf_node);
-
-    // Create its children.
-    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
-        src_model, *node.neg_child(), set_node, spec_idx_to_feature, dst_model,
-        specialized_node_array));
-    const int node_offset = specialized_node_array->size() - new_node_idx;
-    if (node_offset >=
-        std::numeric_limits<
-            typename SpecializedModel::NodeType::NodeOffset>::max()) {
-      return absl::InvalidArgumentError(
-          "Tree with too many nodes for this optimized model format.");
+    if (node->IsLeaf()) {
+      // Create a leaf.
+      RETURN_IF_ERROR(set_node(src_model, *node, dst_model, &dst_node));
+    } else {
+      // Create a non-leaf node.
+      const int spec_feature_idx = node->node().condition().attribute();
+      RETURN_IF_ERROR(SetNonLeafNode(src_model, *node, spec_feature_idx,
+                                     spec_idx_to_feature, dst_model,
+                                     &dst_node));
+      if (flat_node.inverted) {
+        if constexpr (kIsGenericNode<typename SpecializedModel::NodeType>) {
+          RETURN_IF_ERROR(
+              InvertCondition(spec_feature_idx, dst_model, &dst_node));
+        } else {
+          return absl::InternalError("Unexpected inverted condition");
+        }
+      }
+      const size_t node_offset =
+          node_idxs[flat_node.JumpChild()] - specialized_node_array->size();
+      if (node_offset >= std::numeric_limits<NodeOffset>::max()) {
+        return absl::InvalidArgumentError(
+            "Tree with too many nodes for this optimized model format.");
+      }
+      dst_node.right_idx = node_offset;
     }
-    (*specialized_node_array)[new_node_idx].right_idx = node_offset;
-    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
-        src_model, *node.pos_child(), set_node, spec_idx_to_feature, dst_model,
-        specialized_node_array));
+    specialized_node_array->push_back(dst_node);
   }
   return absl::OkStatus();
 }
@@ -799,11 +864,12 @@ absl::Status CreateFlatModelNodes(
   dst_model->nodes.reserve(src_model.NumNodes());
   dst_model->root_offsets.clear();
   dst_model->root_offsets.reserve(src_model.NumTrees());
-  for (const auto& tree : src_model.decision_trees()) {
+  for (const int tree_idx : FlatTreeOrder(src_model.decision_trees(),
+                                          NumTreesPerIter(src_model))) {
     dst_model->root_offsets.push_back(dst_model->nodes.size());
-    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(src_model, tree->root(),
-                                                 set_node, spec_idx_to_feature,
-                                                 dst_model, &dst_model->nodes));
+    RETURN_IF_ERROR(ConvertGenericTreeToFlatNodes(
+        src_model, src_model.decision_trees()[tree_idx]->root(), set_node,
+        spec_idx_to_feature, dst_model, &dst_model->nodes));
   }
   LOG(INFO) << "Model loaded with " << dst_model->root_offsets.size()
             << " root(s), " << dst_model->nodes.size() << " node(s), and "
@@ -819,7 +885,8 @@ absl::Status GenericToSpecializedModelHelper(
     const GenericModel& src_model,
     SetLeafFunctor<GenericModel, SpecializedModel> set_node,
     SpecializedModel* dst_model,
-    const bool global_imputation_optimization = true) {
+    const bool global_imputation_optimization = true,
+    const std::vector<int>* input_features = nullptr) {
   if (src_model.task() != SpecializedModel::kTask) {
     return absl::InvalidArgumentError("Wrong model class.");
   }
@@ -827,7 +894,8 @@ absl::Status GenericToSpecializedModelHelper(
 
   RETURN_IF_ERROR(InitializeFlatNodeModel(
       src_model, dst_model,
-      /*missing_numerical_is_na=*/!global_imputation_optimization));
+      /*missing_numerical_is_na=*/!global_imputation_optimization,
+      input_features));
 
   return CreateFlatModelNodes(src_model, set_node, dst_model);
 }
@@ -838,14 +906,19 @@ template <typename SetLeaf, typename GenericModel, typename SpecializedModel>
 absl::Status GenericToSpecializedGenericModelHelper(
     SetLeaf set_leaf, const GenericModel& src, SpecializedModel* dst,
     std::optional<bool> global_imputation_optimization = {}) {
+  // A shared example set layout stores missing numerical values as NaN, which
+  // is not compatible with the global imputation optimization.
+  const bool shared_layout = !dst->shared_input_features.empty();
   dst->global_imputation_optimization =
+      !shared_layout &&
       src.CheckStructure({/*.global_imputation_is_higher =*/true});
   dst->uses_na_conditions = !src.CheckStructure(
       model::decision_tree::CheckStructureOptions::NACondition());
 
   return GenericToSpecializedModelHelper(
       src, SetLeafFunctor<GenericModel, SpecializedModel>(set_leaf), dst,
-      dst->global_imputation_optimization);
+      dst->global_imputation_optimization,
+      shared_layout ? &dst->shared_input_features : nullptr);
 }
 
 // Checks that a model is a binary classifier.
@@ -22,18 +22,25 @@
 #include <type_traits>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/isolation_forest/isolation_forest.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/usage.h"
+#include "yggdrasil_decision_forests/utils/vector_kernels.h"
 
 namespace yggdrasil_decision_forests {
 namespace serving {
 namespace decision_forest {
 
+// Number of examples evaluated at a time by "PredictColumnar".
+constexpr int64_t kColumnarBlockSize = 1024;
+
 template <typename SpecializedModel>
 void ActivationMultiDimIdentity(const SpecializedModel& model,
                                 float* const values, const int num_values) {}
@@ -127,11 +134,16 @@ inline bool EvalCondition(
   }
 }
 
-template <typename Model>
+// "Examples" is either the model's example set, or a view with the same
+// accessors for fixed length features (e.g. "ColumnarExampleSetView").
+template <typename Model, typename Examples>
 inline bool EvalCondition(const typename Model::NodeType* node,
-                          const typename Model::ExampleSet& examples,
-                          const int example_idx, const Model& model) {
+                          const Examples& examples, const int example_idx,
+                          const Model& model) {
   using GenericNode = typename Model::NodeType;
+  // Only example sets support variable length features.
+  constexpr bool kVariableLengthFeatures =
+      std::is_same_v<Examples, typename Model::ExampleSet>;
   switch (node->type) {
     case GenericNode::Type::kLeaf:
       NOTREACHED();
@@ -150,6 +162,17 @@ inline bool EvalCondition(const typename Model::NodeType* node,
       }
     }
 
+    case GenericNode::Type::kNumericalIsLowerMissingIsFalse:
+    case GenericNode::Type::kNumericalIsLowerMissingIsTrue: {
+      const auto attribute_value =
+          examples.GetNumerical(example_idx, {node->feature_idx}, model);
+      if (node->type == GenericNode::Type::kNumericalIsLowerMissingIsFalse) {
+        return attribute_value < node->numerical_is_higher_threshold;
+      } else {
+        return !(attribute_value >= node->numerical_is_higher_threshold);
+      }
+    }
+
     case GenericNode::Type::kCategoricalContainsMask: {
       const uint32_t attribute_value =
           examples.GetCategoricalInt(example_idx, {node->feature_idx}, model);
@@ -165,19 +188,25 @@ inline bool EvalCondition(const typename Model::NodeType* node,
     }
 
     case GenericNode::Type::kCategoricalSetContainsBufferOffset: {
-      const auto& range_values =
-          examples.InternalCategoricalSetBeginAndEnds()
-              [node->feature_idx * examples.NumberOfExamples() + example_idx];
-      for (int value_idx = range_values.begin; value_idx < range_values.end;
-           value_idx++) {
-        const auto attribute_value =
-            examples.InternalCategoricalItemBuffer()[value_idx];
-        if (model.categorical_mask_buffer
-                [node->categorical_contains_buffer_offset + attribute_value]) {
-          return true;
+      if constexpr (kVariableLengthFeatures) {
+        const auto& range_values =
+            examples.InternalCategoricalSetBeginAndEnds()
+                [node->feature_idx * examples.NumberOfExamples() + example_idx];
+        for (int value_idx = range_values.begin; value_idx < range_values.end;
+             value_idx++) {
+          const auto attribute_value =
+              examples.InternalCategoricalItemBuffer()[value_idx];
+          if (model.categorical_mask_buffer
+                  [node->categorical_contains_buffer_offset +
+                   attribute_value]) {
+            return true;
+          }
         }
+        return false;
+      } else {
+        NOTREACHED();
+        return false;
       }
-      return false;
     }
 
     case GenericNode::Type::kNumericalObliqueProjectionIsHigher: {
@@ -200,54 +229,63 @@ inline bool EvalCondition(const typename Model::NodeType* node,
     }
 
     case GenericNode::Type::kNumericalVectorSequenceCloserThan: {
-      const int vector_length =
-          model.features()
-              .numerical_vector_sequence_features()[node->feature_idx]
-              .vector_length;
-      const auto anchor =
-          absl::MakeConstSpan(model.numerical_vector_sequence_anchor_weights)
-              .subspan(node->numerical_vector_sequence_offset, vector_length);
-      const float threshold2 =
-          model.numerical_vector_sequence_anchor_weights
-              [node->numerical_vector_sequence_offset + vector_length];
-      const auto nvs_value = examples.GetNumericalVectorSequence(
-          example_idx, {node->feature_idx}, model);
-
-      for (int vector_idx = 0; vector_idx < nvs_value.num_vectors;
-           vector_idx++) {
-        const auto vector = nvs_value.GetVector(vector_idx);
-        const float distance2 =
-            model::decision_tree::SquaredDistance(vector, anchor);
-        if (distance2 <= threshold2) {
-          return true;
+      if constexpr (kVariableLengthFeatures) {
+        const int vector_length =
+            model.features()
+                .numerical_vector_sequence_features()[node->feature_idx]
+                .vector_length;
+        const auto anchor =
+            absl::MakeConstSpan(model.numerical_vector_sequence_anchor_weights)
+                .subspan(node->numerical_vector_sequence_offset, vector_length);
+        const float threshold2 =
+            model.numerical_vector_sequence_anchor_weights
+                [node->numerical_vector_sequence_offset + vector_length];
+        const auto nvs_value = examples.GetNumericalVectorSequence(
+            example_idx, {node->feature_idx}, model);
+
+        for (int vector_idx = 0; vector_idx < nvs_value.num_vectors;
+             vector_idx++) {
+          const auto vector = nvs_value.GetVector(vector_idx);
+          const float distance2 = utils::SquaredDistance(vector, anchor);
+          if (distance2 <= threshold2) {
+            return true;
+          }
         }
+        return false;
+      } else {
+        NOTREACHED();
+        return false;
       }
-      return false;
     }
 
     case GenericNode::Type::kNumericalVectorSequenceProjectedMoreThan: {
-      const int vector_length =
-          model.features()
-              .numerical_vector_sequence_features()[node->feature_idx]
-              .vector_length;
-      const auto anchor =
-          absl::MakeConstSpan(model.numerical_vector_sequence_anchor_weights)
-              .subspan(node->numerical_vector_sequence_offset, vector_length);
-      const float threshold =
-          model.numerical_vector_sequence_anchor_weights
-              [node->numerical_vector_sequence_offset + vector_length];
-      const auto nvs_value = examples.GetNumericalVectorSequence(
-          example_idx, {node->feature_idx}, model);
-
-      for (int vector_idx = 0; vector_idx < nvs_value.num_vectors;
-           vector_idx++) {
-        const auto vector = nvs_value.GetVector(vector_idx);
-        const float p = model::decision_tree::DotProduct(vector, anchor);
-        if (p >= threshold) {
-          return true;
+      if constexpr (kVariableLengthFeatures) {
+        const int vector_length =
+            model.features()
+                .numerical_vector_sequence_features()[node->feature_idx]
+                .vector_length;
+        const auto anchor =
+            absl::MakeConstSpan(model.numerical_vector_sequence_anchor_weights)
+                .subspan(node->numerical_vector_sequence_offset, vector_length);
+        const float threshold =
+            model.numerical_vector_sequence_anchor_weights
+                [node->numerical_vector_sequence_offset + vector_length];
+        const auto nvs_value = examples.GetNumericalVectorSequence(
+            example_idx, {node->feature_idx}, model);
+
+        for (int vector_idx = 0; vector_idx < nvs_value.num_vectors;
+             vector_idx++) {
+          const auto vector = nvs_value.GetVector(vector_idx);
+          const float p = utils::DotProduct(vector, anchor);
+          if (p >= threshold) {
+            return true;
+          }
         }
+        return false;
+      } else {
+        NOTREACHED();
+        return false;
       }
-      return false;
     }
 
     case GenericNode::Type::kNumericalAndCategoricalIsNa: {
@@ -256,8 +294,13 @@ inline bool EvalCondition(const typename Model::NodeType* node,
     }
 
     case GenericNode::Type::kCategoricalSetIsNa: {
-      return examples.IsMissingCategoricalSet(example_idx, node->feature_idx,
-                                              model);
+      if constexpr (kVariableLengthFeatures) {
+        return examples.IsMissingCategoricalSet(example_idx, node->feature_idx,
+                                                model);
+      } else {
+        NOTREACHED();
+        return false;
+      }
     }
   }
 }
@@ -289,9 +332,9 @@ inline void PredictHelper(
 }
 
 template <typename Model,
-          float (*FinalTransform)(const Model&, const float) /*= Idendity*/>
-inline void PredictHelper(const Model& model,
-                          const typename Model::ExampleSet& examples,
+          float (*FinalTransform)(const Model&, const float) /*= Idendity*/,
+          typename Examples>
+inline void PredictHelper(const Model& model, const Examples& examples,
                           int num_examples, std::vector<float>* predictions) {
   utils::usage::OnInference(num_examples, model.metadata);
   predictions->resize(num_examples);
@@ -311,10 +354,12 @@ inline void PredictHelper(const Model& model,
 }
 
 template <typename Model,
-          float (*FinalTransform)(const Model&, const float) /*= Idendity*/>
-inline void PredictHelperMultiDimensionTrees(
-    const Model& model, const typename Model::ExampleSet& examples,
-    int num_examples, std::vector<float>* predictions) {
+          float (*FinalTransform)(const Model&, const float) /*= Idendity*/,
+          typename Examples>
+inline void PredictHelperMultiDimensionTrees(const Model& model,
+                                             const Examples& examples,
+                                             int num_examples,
+                                             std::vector<float>* predictions) {
   utils::usage::OnInference(num_examples, model.metadata);
   predictions->assign(num_examples * model.num_classes, 0.f);
   float* cur_predictions = &(*predictions)[0];
@@ -340,10 +385,11 @@ inline void PredictHelperMultiDimensionTrees(
 }
 
 template <typename Model,
-          void (*FinalTransform)(const Model&, float* const, const int)>
+          void (*FinalTransform)(const Model&, float* const, const int),
+          typename Examples>
 inline void PredictHelperMultiDimensionFromSingleDimensionTrees(
-    const Model& model, const typename Model::ExampleSet& examples,
-    int num_examples, std::vector<float>* predictions) {
+    const Model& model, const Examples& examples, int num_examples,
+    std::vector<float>* predictions) {
   predictions->assign(num_examples * model.num_classes, 0.f);
   float* cur_predictions = &(*predictions)[0];
   for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
@@ -635,13 +681,87 @@ void PredictOptimizedV1(
       model, examples, num_examples, predictions);
 }
 
+// "Model" is an instance of the "Family" model template e.g.
+// "GenericRandomForestRegression<uint32_t>" is an instance of
+// "GenericRandomForestRegression".
+template <typename Model, template <typename> class Family>
+struct IsModelFamily : std::false_type {};
+
+template <typename NodeOffsetRep, template <typename> class Family>
+struct IsModelFamily<Family<NodeOffsetRep>, Family> : std::true_type {};
+
+template <typename Model, template <typename> class Family>
+constexpr bool kIsModelFamily = IsModelFamily<Model, Family>::value;
+
+// Inference of the models deriving "ExampleSetModel" on an example set, or on
+// any object with the same accessors (e.g. "ColumnarExampleSetView").
+template <typename Model, typename Examples>
+void PredictExampleSetModel(const Model& model, const Examples& examples,
+                            int num_examples, std::vector<float>* predictions) {
+  if constexpr (kIsModelFamily<Model,
+                               GenericRandomForestBinaryClassification>) {
+    PredictHelper<Model, Clamp01>(model, examples, num_examples, predictions);
+  } else if constexpr (kIsModelFamily<
+                           Model,
+                           GenericRandomForestMulticlassClassification>) {
+    PredictHelperMultiDimensionTrees<Model, Clamp01>(model, examples,
+                                                     num_examples, predictions);
+  } else if constexpr (kIsModelFamily<Model, GenericRandomForestRegression> ||
+                       kIsModelFamily<Model,
+                                      GenericRandomForestNumericalUplift>) {
+    PredictHelper<Model, Idendity>(model, examples, num_examples, predictions);
+  } else if constexpr (kIsModelFamily<Model,
+                                      GenericRandomForestCategoricalUplift>) {
+    PredictHelperMultiDimensionTrees<Model, Idendity>(
+        model, examples, num_examples, predictions);
+  } else if constexpr (kIsModelFamily<Model, GenericIsolationForest>) {
+    PredictHelper<Model, IsolationForestActivation>(model, examples,
+                                                    num_examples, predictions);
+  } else if constexpr (kIsModelFamily<
+                           Model,
+                           GenericGradientBoostedTreesBinaryClassification>) {
+    if (model.output_logits) {
+      PredictHelper<Model, Idendity>(model, examples, num_examples,
+                                     predictions);
+    } else {
+      PredictHelper<Model, ActivationGradientBoostedTreesBinomialLogLikelihood>(
+          model, examples, num_examples, predictions);
+    }
+  } else if constexpr (
+                 kIsModelFamily<
+                     Model,
+                     GenericGradientBoostedTreesMulticlassClassification>) {
+    if (model.output_logits) {
+      PredictHelperMultiDimensionFromSingleDimensionTrees<
+          Model, ActivationMultiDimIdentity>(model, examples, num_examples,
+                                             predictions);
+    } else {
+      PredictHelperMultiDimensionFromSingleDimensionTrees<
+          Model, ActivationGradientBoostedTreesMultinomialLogLikelihood>(
+          model, examples, num_examples, predictions);
+    }
+  } else if constexpr (kIsModelFamily<Model,
+                                      GenericGradientBoostedTreesRegression> ||
+                       kIsModelFamily<Model,
+                                      GenericGradientBoostedTreesRanking>) {
+    PredictHelper<Model, ActivationAddInitialPrediction>(
+        model, examples, num_examples, predictions);
+  } else if constexpr (kIsModelFamily<
+                           Model,
+                           GenericGradientBoostedTreesPoissonRegression>) {
+    PredictHelper<Model, ActivationGradientBoostedTreesPoissonRegression>(
+        model, examples, num_examples, predictions);
+  } else {
+    static_assert(!std::is_same_v<Model, Model>, "Unsupported model.");
+  }
+}
+
 template <>
 void Predict(
     const RandomForestBinaryClassification& model,
     const typename RandomForestBinaryClassification::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Clamp01>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -649,34 +769,28 @@ void Predict(
     const RandomForestMulticlassClassification& model,
     const typename RandomForestMulticlassClassification::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelperMultiDimensionTrees<std::remove_reference<decltype(model)>::type,
-                                   Clamp01>(model, examples, num_examples,
-                                            predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
 void Predict(const RandomForestRegression& model,
              const typename RandomForestRegression::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
 void Predict(const RandomForestCategoricalUplift& model,
              const typename RandomForestCategoricalUplift::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelperMultiDimensionTrees<std::remove_reference<decltype(model)>::type,
-                                   Idendity>(model, examples, num_examples,
-                                             predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
 void Predict(const RandomForestNumericalUplift& model,
              const typename RandomForestNumericalUplift::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -684,8 +798,7 @@ void Predict(const GenericRandomForestBinaryClassification<uint32_t>& model,
              const typename GenericRandomForestBinaryClassification<
                  uint32_t>::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Clamp01>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -693,9 +806,7 @@ void Predict(const GenericRandomForestMulticlassClassification<uint32_t>& model,
              const typename GenericRandomForestMulticlassClassification<
                  uint32_t>::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelperMultiDimensionTrees<std::remove_reference<decltype(model)>::type,
-                                   Clamp01>(model, examples, num_examples,
-                                            predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -703,8 +814,7 @@ void Predict(const GenericRandomForestRegression<uint32_t>& model,
              const typename GenericRandomForestRegression<uint32_t>::ExampleSet&
                  examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -713,9 +823,7 @@ void Predict(
     const typename GenericRandomForestCategoricalUplift<uint32_t>::ExampleSet&
         examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelperMultiDimensionTrees<std::remove_reference<decltype(model)>::type,
-                                   Idendity>(model, examples, num_examples,
-                                             predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -724,8 +832,7 @@ void Predict(
     const typename GenericRandomForestNumericalUplift<uint32_t>::ExampleSet&
         examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -733,18 +840,14 @@ void Predict(
     const GenericIsolationForest<uint32_t>& model,
     const typename GenericIsolationForest<uint32_t>::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                IsolationForestActivation>(model, examples, num_examples,
-                                           predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
 void Predict(const IsolationForest& model,
              const typename IsolationForest::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                IsolationForestActivation>(model, examples, num_examples,
-                                           predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -753,9 +856,7 @@ void Predict(
     const typename GradientBoostedTreesBinaryClassification::ExampleSet&
         examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationGradientBoostedTreesBinomialLogLikelihood>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -764,14 +865,7 @@ void Predict(
     const typename GenericGradientBoostedTreesBinaryClassification<
         uint32_t>::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  if (model.output_logits) {
-    PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-        model, examples, num_examples, predictions);
-  } else {
-    PredictHelper<std::remove_reference<decltype(model)>::type,
-                  ActivationGradientBoostedTreesBinomialLogLikelihood>(
-        model, examples, num_examples, predictions);
-  }
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -780,16 +874,7 @@ void Predict(
     const typename GradientBoostedTreesMulticlassClassification::ExampleSet&
         examples,
     int num_examples, std::vector<float>* predictions) {
-  if (model.output_logits) {
-    PredictHelperMultiDimensionFromSingleDimensionTrees<
-        std::remove_reference<decltype(model)>::type,
-        ActivationMultiDimIdentity>(model, examples, num_examples, predictions);
-  } else {
-    PredictHelperMultiDimensionFromSingleDimensionTrees<
-        std::remove_reference<decltype(model)>::type,
-        ActivationGradientBoostedTreesMultinomialLogLikelihood>(
-        model, examples, num_examples, predictions);
-  }
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -797,18 +882,14 @@ void Predict(
     const GradientBoostedTreesRegression& model,
     const typename GradientBoostedTreesRegression::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationAddInitialPrediction>(model, examples, num_examples,
-                                                predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
 void Predict(const GradientBoostedTreesRanking& model,
              const typename GradientBoostedTreesRanking::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationAddInitialPrediction>(model, examples, num_examples,
-                                                predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
 }
 
 template <>
@@ -816,12 +897,204 @@ void Predict(
     const GradientBoostedTreesPoissonRegression& model,
     const typename GradientBoostedTreesPoissonRegression::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  // Add activation
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationGradientBoostedTreesPoissonRegression>(
-      model, examples, num_examples, predictions);
+  PredictExampleSetModel(model, examples, num_examples, predictions);
+}
+
+template <typename Model>
+absl::Status PredictColumnar(const Model& model,
+                             const ColumnarExamples& examples,
+                             absl::Span<float> predictions) {
+  int num_dims = 1;
+  if constexpr (kIsModelFamily<Model,
+                               GenericRandomForestMulticlassClassification> ||
+                kIsModelFamily<Model, GenericRandomForestCategoricalUplift> ||
+                kIsModelFamily<
+                    Model,
+                    GenericGradientBoostedTreesMulticlassClassification>) {
+    num_dims = model.num_classes;
+  }
+  const int64_t num_examples = examples.num_examples();
+  if (predictions.size() != num_examples * num_dims) {
+    return absl::InvalidArgumentError(
+        "\"predictions\" should contain num_examples x num_dimensions values");
+  }
+
+  std::vector<float> block_predictions;
+  for (int64_t begin = 0; begin < num_examples; begin += kColumnarBlockSize) {
+    const int64_t end = std::min(begin + kColumnarBlockSize, num_examples);
+    ASSIGN_OR_RETURN(const auto view, ColumnarExampleSetView<Model>::Create(
+                                          examples, begin, end, model));
+    PredictExampleSetModel(model, view, end - begin, &block_predictions);
+    std::copy(block_predictions.begin(), block_predictions.end(),
+              predictions.begin() + begin * num_dims);
+  }
+  return absl::OkStatus();
 }
 
+template <typename Model>
+void AddTreeRangeOutputs(const Model& model,
+                         const typename Model::ExampleSet& examples,
+                         const absl::Span<const int> example_idxs,
+                         const int begin_tree_idx, const int end_tree_idx,
+                         absl::Span<float> outputs) {
+  DCHECK_EQ(example_idxs.size(), outputs.size());
+  for (size_t item_idx = 0; item_idx < example_idxs.size(); item_idx++) {
+    const int example_idx = example_idxs[item_idx];
+    float output = 0.f;
+    for (int tree_idx = begin_tree_idx; tree_idx < end_tree_idx; tree_idx++) {
+      const auto* node = &model.nodes[model.root_offsets[tree_idx]];
+      while (node->right_idx) {
+        node += EvalCondition(node, examples, example_idx, model)
+                    ? node->right_idx
+                    : 1;
+      }
+      output += node->label;
+    }
+    outputs[item_idx] += output;
+  }
+}
+
+template void AddTreeRangeOutputs(
+    const GenericGradientBoostedTreesBinaryClassification<uint16_t>& model,
+    const GenericGradientBoostedTreesBinaryClassification<uint16_t>::ExampleSet&
+        examples,
+    absl::Span<const int> example_idxs, int begin_tree_idx, int end_tree_idx,
+    absl::Span<float> outputs);
+template void AddTreeRangeOutputs(
+    const GenericGradientBoostedTreesBinaryClassification<uint32_t>& model,
+    const GenericGradientBoostedTreesBinaryClassification<uint32_t>::ExampleSet&
+        examples,
+    absl::Span<const int> example_idxs, int begin_tree_idx, int end_tree_idx,
+    absl::Span<float> outputs);
+
+template void AddTreeRangeOutputs(
+    const GenericGradientBoostedTreesRegression<uint16_t>& model,
+    const GenericGradientBoostedTreesRegression<uint16_t>::ExampleSet& examples,
+    absl::Span<const int> example_idxs, int begin_tree_idx, int end_tree_idx,
+    absl::Span<float> outputs);
+template void AddTreeRangeOutputs(
+    const GenericGradientBoostedTreesPoissonRegression<uint16_t>& model,
+    const GenericGradientBoostedTreesPoissonRegression<uint16_t>::ExampleSet&
+        examples,
+    absl::Span<const int> example_idxs, int begin_tree_idx, int end_tree_idx,
+    absl::Span<float> outputs);
+template void AddTreeRangeOutputs(
+    const GenericGradientBoostedTreesRanking<uint16_t>& model,
+    const GenericGradientBoostedTreesRanking<uint16_t>::ExampleSet& examples,
+    absl::Span<const int> example_idxs, int begin_tree_idx, int end_tree_idx,
+    absl::Span<float> outputs);
+
+template <typename Model>
+void FinalizeTreeOutputs(const Model& model, absl::Span<float> outputs) {
+  if constexpr (kIsModelFamily<
+                    Model, GenericGradientBoostedTreesBinaryClassification>) {
+    if (!model.output_logits) {
+      for (auto& output : outputs) {
+        output = ActivationGradientBoostedTreesBinomialLogLikelihood(model,
+                                                                     output);
+      }
+    }
+  } else if constexpr (kIsModelFamily<Model,
+                                      GenericGradientBoostedTreesRegression> ||
+                       kIsModelFamily<Model,
+                                      GenericGradientBoostedTreesRanking>) {
+    for (auto& output : outputs) {
+      output = ActivationAddInitialPrediction(model, output);
+    }
+  } else if constexpr (kIsModelFamily<
+                           Model,
+                           GenericGradientBoostedTreesPoissonRegression>) {
+    for (auto& output : outputs) {
+      output = ActivationGradientBoostedTreesPoissonRegression(model, output);
+    }
+  } else {
+    static_assert(!std::is_same_v<Model, Model>, "Unsupported model.");
+  }
+}
+
+template void FinalizeTreeOutputs(
+    const GradientBoostedTreesBinaryClassification& model,
+    absl::Span<float> outputs);
+template void FinalizeTreeOutputs(
+    const GradientBoostedTreesRegression& model, absl::Span<float> outputs);
+template void FinalizeTreeOutputs(
+    const GradientBoostedTreesPoissonRegression& model,
+    absl::Span<float> outputs);
+template void FinalizeTreeOutputs(
+    const GradientBoostedTreesRanking& model, absl::Span<float> outputs);
+
+template <typename Model>
+bool EvalNodeCondition(const Model& model, const typename Model::NodeType& node,
+                       const typename Model::ExampleSet& examples,
+                       const int example_idx) {
+  return EvalCondition(&node, examples, example_idx, model);
+}
+
+template bool EvalNodeCondition(
+    const ExampleSetModel<uint16_t>& model,
+    const ExampleSetModel<uint16_t>::NodeType& node,
+    const ExampleSetModel<uint16_t>::ExampleSet& examples, int example_idx);
+template bool EvalNodeCondition(
+    const ExampleSetModel<uint32_t>& model,
+    const ExampleSetModel<uint32_t>::NodeType& node,
+    const ExampleSetModel<uint32_t>::ExampleSet& examples, int example_idx);
+
+// Engines available with "PredictColumnar".
+template absl::Status PredictColumnar(
+    const GenericRandomForestBinaryClassification<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestBinaryClassification<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestMulticlassClassification<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestMulticlassClassification<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestRegression<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestRegression<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestCategoricalUplift<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestCategoricalUplift<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestNumericalUplift<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericRandomForestNumericalUplift<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericIsolationForest<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericIsolationForest<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericGradientBoostedTreesBinaryClassification<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericGradientBoostedTreesBinaryClassification<uint32_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericGradientBoostedTreesMulticlassClassification<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericGradientBoostedTreesRegression<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericGradientBoostedTreesRanking<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+template absl::Status PredictColumnar(
+    const GenericGradientBoostedTreesPoissonRegression<uint16_t>& model,
+    const ColumnarExamples& examples, absl::Span<float> predictions);
+
 }  // namespace decision_forest
 }  // namespace serving
 }  // namespace yggdrasil_decision_forests
@@ -19,8 +19,12 @@
 #include <cstdint>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/own_or_borrow.h"
 
 namespace yggdrasil_decision_forests {
 namespace serving {
@@ -59,7 +63,8 @@ struct OneDimensionOutputNumericalAndCategoricalFeatureNode {
   using NodeOffset = uint16_t;
   using FeatureIdx = int16_t;
 
-  // Offset to the positive child node. 0 if is leaf.
+  // Offset to the positive child node (the negative child node, if the
+  // condition was inverted by the flat node layout). 0 if is leaf.
   NodeOffset right_idx;
   // Tested attribute idx.
   //
@@ -95,7 +100,8 @@ struct GenericNode {
   using NodeOffset = NodeOffsetRep;
   using FeatureIdx = int16_t;
 
-  // Offset to the positive child node. 0 if is leaf.
+  // Offset to the positive child node (the negative child node, if the
+  // condition was inverted by the flat node layout). 0 if is leaf.
   NodeOffset right_idx;
 
   union {
@@ -122,6 +128,11 @@ struct GenericNode {
     kCategoricalSetIsNa,
     kNumericalVectorSequenceCloserThan,
     kNumericalVectorSequenceProjectedMoreThan,
+    // Inverted "kNumericalIsHigher*" conditions, created by the flat node
+    // layout to make the most visited child the fall-through child (see
+    // "FlatNodeLayout").
+    kNumericalIsLowerMissingIsFalse,
+    kNumericalIsLowerMissingIsTrue,
   };
   // Type of the node (leaf or condition type).
   Type type;
@@ -137,7 +148,8 @@ struct GenericNode {
     // label_buffer[label_buffer_offset+class_idx].
     uint32_t label_buffer_offset;
 
-    // Numerical condition as "attribute >= threshold".
+    // Numerical condition as "attribute >= threshold" (or "attribute <
+    // threshold" for the "kNumericalIsLower*" conditions).
     // Also used for discretized numerical features.
     float numerical_is_higher_threshold;
 
@@ -211,28 +223,32 @@ struct FlatNodeModel {
 
   FeaturesDefinition* mutable_features() { return &internal_features; }
 
+  // The flat buffers below are either owned, or borrowed from a memory-mapped
+  // serving image (see "serving_image.h").
+
   // The list of nodes in the model.
-  std::vector<Node> nodes;
+  utils::BorrowableVector<Node> nodes;
   // The indices (in "nodes") of the root nodes.
-  std::vector<int32_t> root_offsets;
+  utils::BorrowableVector<int32_t> root_offsets;
 
   FeaturesDefinition internal_features;
 
   // Buffer of label values. Used for multi-dimensional output trees.
   // See the description of "label_buffer_offset".
-  std::vector<float> label_buffer;
+  utils::BorrowableVector<float> label_buffer;
 
   // Buffer of categorical mask to use for categorical condition.
   std::vector<bool> categorical_mask_buffer;
 
   // Buffer for oblique projection splits. See "GenericNode" for the
   // documentation about these fields.
-  std::vector<float> oblique_weights;
-  std::vector<typename Node::FeatureIdx> oblique_internal_feature_idxs;
+  utils::BorrowableVector<float> oblique_weights;
+  utils::BorrowableVector<typename Node::FeatureIdx>
+      oblique_internal_feature_idxs;
 
   // Buffer of value for static anchor and thresholds in numerical vector
   // sequence conditions.
-  std::vector<float> numerical_vector_sequence_anchor_weights;
+  utils::BorrowableVector<float> numerical_vector_sequence_anchor_weights;
 
   // True if and only if the model uses N/A conditions.
   bool uses_na_conditions = false;
@@ -351,6 +367,13 @@ struct ExampleSetModel
   // If true, the engine inference runs with the global imputation optimization.
   // That is, missing values are replaced with global imputation.
   bool global_imputation_optimization;
+
+  // If not empty, the example set contains these dataspec columns instead of
+  // only the columns used by the trees, and the missing numerical values are
+  // represented as NaN (i.e. no global imputation optimization). Engines built
+  // with the same "shared_input_features" on the same dataspec use the same
+  // example set layout (see "ModelGroup"). Only used when loading the model.
+  std::vector<int> shared_input_features;
 };
 
 struct ExampleSetModelManyNodes : ExampleSetModel<uint32_t> {};
@@ -474,6 +497,48 @@ template <typename Model>
 void Predict(const Model& model, const typename Model::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions);
 
+// Generates the predictions of a "ExampleSetModel" model (e.g.
+// "GenericRandomForestRegression") directly from columnar examples, without
+// copying the feature values into an example set. "predictions" should contain
+// "num_examples x num_dimensions" values.
+//
+// Returns an "Unimplemented" error if the examples cannot be read without copy
+// (e.g. boolean columns, categorical-set features). In this case, use
+// "FastEngine::PredictColumnar" instead.
+template <typename Model>
+absl::Status PredictColumnar(const Model& model,
+                             const ColumnarExamples& examples,
+                             absl::Span<float> predictions);
+
+// Adds the raw output (i.e. without initial prediction and activation) of the
+// trees [begin_tree_idx, end_tree_idx) of a single dimension GBT model (i.e.
+// binary classification, regression, Poisson regression or ranking) to
+// "outputs". The i-th value of "outputs" is incremented with the sum of the
+// tree outputs for the example "example_idxs[i]".
+template <typename Model>
+void AddTreeRangeOutputs(const Model& model,
+                         const typename Model::ExampleSet& examples,
+                         absl::Span<const int> example_idxs,
+                         int begin_tree_idx, int end_tree_idx,
+                         absl::Span<float> outputs);
+
+// Converts the raw outputs of all the trees of a single dimension GBT model
+// (e.g. computed with "AddTreeRangeOutputs") into predictions, in place. The
+// result is the same as "Predict".
+template <typename Model>
+void FinalizeTreeOutputs(const Model& model, absl::Span<float> outputs);
+
+// Evaluates the condition of the non-leaf node "node" of an "ExampleSetModel"
+// (e.g. "ExampleSetModel<uint32_t>") on the example "example_idx". Returns true
+// if the example goes to the positive child (i.e. "node + node.right_idx").
+//
+// Used by the algorithms that do not simply follow the active path of each tree
+// (e.g. TreeSHAP).
+template <typename Model>
+bool EvalNodeCondition(const Model& model, const typename Model::NodeType& node,
+                       const typename Model::ExampleSet& examples,
+                       int example_idx);
+
 // Generates the predictions of a model on a batch of examples.
 //
 // Args:
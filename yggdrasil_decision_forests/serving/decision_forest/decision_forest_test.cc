@@ -15,6 +15,7 @@
 
 #include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -48,6 +49,7 @@
 #include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/register_engines.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"  // IWYU pragma: keep
 #include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
@@ -410,6 +412,94 @@ TEST(AdultBinaryClassGBDT, ManualGeneric) {
       dataset, *model, engine);
 }
 
+TEST(AdultBinaryClassGBDT, ManualGenericWithNodeTraffic) {
+  const auto model = LoadModel("adult_binary_class_gbdt");
+  const auto dataset = LoadDataset(model->data_spec(), "adult_test.csv", "csv");
+
+  auto* gbt_model = dynamic_cast<GradientBoostedTreesModel*>(model.get());
+  GradientBoostedTreesBinaryClassification default_engine;
+  CHECK_OK(GenericToSpecializedModel(*gbt_model, &default_engine));
+
+  CHECK_OK(model::decision_tree::SetNodeTraffic(
+      dataset, gbt_model->mutable_decision_trees()));
+  EXPECT_EQ(gbt_model->decision_trees()
+                .front()
+                ->root()
+                .node()
+                .num_profiled_examples(),
+            dataset.nrow());
+  GradientBoostedTreesBinaryClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*gbt_model, &engine));
+
+  // The nodes are re-ordered, but the predictions are the same.
+  ASSERT_EQ(engine.nodes.size(), default_engine.nodes.size());
+  int num_moved_nodes = 0;
+  for (size_t node_idx = 0; node_idx < engine.nodes.size(); node_idx++) {
+    if (engine.nodes[node_idx].right_idx !=
+        default_engine.nodes[node_idx].right_idx) {
+      num_moved_nodes++;
+    }
+  }
+  EXPECT_GT(num_moved_nodes, 0);
+
+  // Some numerical conditions are inverted to make the likelier child the
+  // fall-through child.
+  int num_inverted_nodes = 0;
+  for (const auto& node : engine.nodes) {
+    if (node.right_idx != 0 &&
+        (node.type == decltype(engine)::NodeType::Type::
+                          kNumericalIsLowerMissingIsFalse ||
+         node.type == decltype(engine)::NodeType::Type::
+                          kNumericalIsLowerMissingIsTrue)) {
+      num_inverted_nodes++;
+    }
+  }
+  EXPECT_GT(num_inverted_nodes, 0);
+
+  // The trees are re-ordered.
+  const auto tree_order = FlatTreeOrder(gbt_model->decision_trees(), 1);
+  EXPECT_FALSE(std::is_sorted(tree_order.begin(), tree_order.end()));
+
+  utils::ExpectEqualPredictionsTemplate<decltype(engine), Predict>(
+      dataset, *model, engine);
+}
+
+TEST(AdultBinaryClassRF, ManualGenericWithNodeTraffic) {
+  const auto model = LoadModel("adult_binary_class_rf");
+  const auto dataset = LoadDataset(model->data_spec(), "adult_test.csv", "csv");
+
+  auto* rf_model = dynamic_cast<RandomForestModel*>(model.get());
+  CHECK_OK(model::decision_tree::SetNodeTraffic(
+      dataset, rf_model->mutable_decision_trees()));
+  RandomForestBinaryClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*rf_model, &engine));
+
+  utils::ExpectEqualPredictionsTemplate<decltype(engine), Predict>(
+      dataset, *model, engine);
+}
+
+TEST(IrisMulticlassClassGBDT, ManualGenericWithNodeTraffic) {
+  const auto model = LoadModel("iris_multi_class_gbdt");
+  const auto dataset = LoadDataset(model->data_spec(), "iris.csv", "csv");
+
+  auto* gbt_model = dynamic_cast<GradientBoostedTreesModel*>(model.get());
+  CHECK_OK(model::decision_tree::SetNodeTraffic(
+      dataset, gbt_model->mutable_decision_trees()));
+  // The trees are re-ordered within each of the 3 interleaved outputs.
+  const auto tree_order = FlatTreeOrder(gbt_model->decision_trees(),
+                                        gbt_model->num_trees_per_iter());
+  EXPECT_FALSE(std::is_sorted(tree_order.begin(), tree_order.end()));
+  for (int tree_idx = 0; tree_idx < tree_order.size(); tree_idx++) {
+    EXPECT_EQ(tree_order[tree_idx] % 3, tree_idx % 3);
+  }
+
+  GradientBoostedTreesMulticlassClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*gbt_model, &engine));
+
+  utils::ExpectEqualPredictionsTemplate<decltype(engine), Predict>(
+      dataset, *model, engine);
+}
+
 TEST(AdultBinaryClassGBDT, ManualWithNonCompatibleEngines) {
   const auto model = LoadModel("adult_binary_class_gbdt");
   const auto dataset = LoadDataset(model->data_spec(), "adult_test.csv", "csv");
@@ -552,6 +642,145 @@ void BuildFullTree(const int d, model::decision_tree::NodeWithChildren* node) {
   BuildFullTree(d - 1, node->mutable_neg_child());
 }
 
+std::vector<const model::decision_tree::NodeWithChildren*> LayoutNodes(
+    const std::vector<FlatNode>& layout) {
+  std::vector<const model::decision_tree::NodeWithChildren*> nodes;
+  for (const auto& flat_node : layout) {
+    nodes.push_back(flat_node.node);
+  }
+  return nodes;
+}
+
+std::vector<bool> LayoutInverted(const std::vector<FlatNode>& layout) {
+  std::vector<bool> inverted;
+  for (const auto& flat_node : layout) {
+    inverted.push_back(flat_node.inverted);
+  }
+  return inverted;
+}
+
+TEST(DecisionForest, FlatNodeLayout) {
+  using model::decision_tree::NodeWithChildren;
+  model::decision_tree::DecisionTree tree;
+  tree.CreateRoot();
+  BuildFullTree(2, tree.mutable_root());
+  const NodeWithChildren& root = tree.root();
+  const NodeWithChildren* a = root.neg_child();
+  const NodeWithChildren* b = root.pos_child();
+  const auto can_invert = [](const NodeWithChildren&) { return true; };
+
+  EXPECT_THAT(
+      LayoutNodes(FlatNodeLayout(root, std::numeric_limits<uint16_t>::max())),
+      ElementsAre(&root, a, a->neg_child(), a->pos_child(), b, b->neg_child(),
+                  b->pos_child()));
+
+  // Without traffic statistics, no condition is inverted.
+  const auto unprofiled_layout =
+      FlatNodeLayout(root, std::numeric_limits<uint16_t>::max(), can_invert);
+  EXPECT_THAT(LayoutNodes(unprofiled_layout),
+              ElementsAre(&root, a, a->neg_child(), a->pos_child(), b,
+                          b->neg_child(), b->pos_child()));
+  EXPECT_THAT(LayoutInverted(unprofiled_layout),
+              ElementsAre(false, false, false, false, false, false, false));
+
+  // Most of the examples go through the positive branches.
+  const auto set_traffic = [](NodeWithChildren* node, const int traffic) {
+    node->mutable_node()->set_num_profiled_examples(traffic);
+  };
+  set_traffic(tree.mutable_root(), 10);
+  set_traffic(tree.mutable_root()->mutable_neg_child(), 2);
+  set_traffic(tree.mutable_root()->mutable_neg_child()->mutable_neg_child(),
+              1);
+  set_traffic(tree.mutable_root()->mutable_neg_child()->mutable_pos_child(),
+              1);
+  set_traffic(tree.mutable_root()->mutable_pos_child(), 8);
+  set_traffic(tree.mutable_root()->mutable_pos_child()->mutable_neg_child(),
+              2);
+  set_traffic(tree.mutable_root()->mutable_pos_child()->mutable_pos_child(),
+              6);
+  EXPECT_THAT(
+      LayoutNodes(FlatNodeLayout(root, std::numeric_limits<uint16_t>::max())),
+      ElementsAre(&root, a, a->neg_child(), b, b->neg_child(), b->pos_child(),
+                  a->pos_child()));
+
+  // The likelier child is the fall-through child. "a" has two children with
+  // the same traffic and is not inverted.
+  const auto profiled_layout =
+      FlatNodeLayout(root, std::numeric_limits<uint16_t>::max(), can_invert);
+  EXPECT_THAT(LayoutNodes(profiled_layout),
+              ElementsAre(&root, b, b->pos_child(), b->neg_child(), a,
+                          a->neg_child(), a->pos_child()));
+  EXPECT_THAT(LayoutInverted(profiled_layout),
+              ElementsAre(true, true, false, false, false, false, false));
+  EXPECT_EQ(profiled_layout[0].FallThroughChild(), b);
+  EXPECT_EQ(profiled_layout[0].JumpChild(), a);
+
+  // The offsets of "a" (inverted layout) and of "a->pos_child()" (layout
+  // without inversion) are too large. Fall back to the depth-first layout.
+  const auto fallback_layout = FlatNodeLayout(root, 4, can_invert);
+  EXPECT_THAT(LayoutNodes(fallback_layout),
+              ElementsAre(&root, a, a->neg_child(), a->pos_child(), b,
+                          b->neg_child(), b->pos_child()));
+  EXPECT_THAT(LayoutInverted(fallback_layout),
+              ElementsAre(false, false, false, false, false, false, false));
+}
+
+TEST(DecisionForest, FlatTreeOrder) {
+  using model::decision_tree::NodeWithChildren;
+  // The tree "i" has a depth of "depths[i]".
+  const std::vector<int> depths = {3, 2, 1, 1, 2, 3};
+  std::vector<std::unique_ptr<model::decision_tree::DecisionTree>> trees;
+  for (const int depth : depths) {
+    trees.push_back(std::make_unique<model::decision_tree::DecisionTree>());
+    trees.back()->CreateRoot();
+    BuildFullTree(depth, trees.back()->mutable_root());
+  }
+
+  // Without traffic statistics, the trees are not re-ordered.
+  EXPECT_THAT(FlatTreeOrder(trees, 1), ElementsAre(0, 1, 2, 3, 4, 5));
+
+  // All the examples reach all the nodes.
+  for (auto& tree : trees) {
+    tree->IterateOnMutableNodes(
+        [](NodeWithChildren* node, const int depth) {
+          node->mutable_node()->set_num_profiled_examples(1 << (4 - depth));
+        });
+  }
+  EXPECT_THAT(FlatTreeOrder(trees, 1), ElementsAre(2, 3, 1, 4, 0, 5));
+
+  // The trees of the outputs 0 (i.e. the trees 0, 2, 4) and 1 (i.e. the trees
+  // 1, 3, 5) are sorted separately.
+  EXPECT_THAT(FlatTreeOrder(trees, 2), ElementsAre(2, 3, 4, 1, 0, 5));
+}
+
+TEST(DecisionForest, SortInputFeaturesByAccessFrequency) {
+  using model::decision_tree::NodeWithChildren;
+  std::vector<std::unique_ptr<model::decision_tree::DecisionTree>> trees;
+  trees.push_back(std::make_unique<model::decision_tree::DecisionTree>());
+  auto& tree = *trees.back();
+  tree.CreateRoot();
+  BuildFullTree(2, tree.mutable_root());
+  NodeWithChildren* root = tree.mutable_root();
+  NodeWithChildren* a = root->mutable_neg_child();
+  NodeWithChildren* b = root->mutable_pos_child();
+  root->mutable_node()->mutable_condition()->set_attribute(3);
+  a->mutable_node()->mutable_condition()->set_attribute(1);
+  b->mutable_node()->mutable_condition()->set_attribute(2);
+
+  // Without traffic statistics, the features tested close to the root are
+  // the most accessed. Feature 4 is not used.
+  std::vector<int> features = {1, 2, 3, 4};
+  SortInputFeaturesByAccessFrequency(trees, &features);
+  EXPECT_THAT(features, ElementsAre(3, 1, 2, 4));
+
+  // Most of the examples go through the positive branch.
+  root->mutable_node()->set_num_profiled_examples(10);
+  a->mutable_node()->set_num_profiled_examples(1);
+  b->mutable_node()->set_num_profiled_examples(9);
+  SortInputFeaturesByAccessFrequency(trees, &features);
+  EXPECT_THAT(features, ElementsAre(3, 2, 1, 4));
+}
+
 TEST(SpecializedGradientBoostedTreesTest, MoreThan65kNodesPerTrees) {
   model::gradient_boosted_trees::GradientBoostedTreesModel model;
 
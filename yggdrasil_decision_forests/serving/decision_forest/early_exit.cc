@@ -0,0 +1,525 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/early_exit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/register_engines.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+namespace {
+
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using QuickScorerModel =
+    GradientBoostedTreesBinaryClassificationQuickScorerExtended;
+
+// Adds the outputs of the trees of the stage "stage_idx" for the examples
+// "example_idxs" to "outputs" (indexed by position in "example_idxs").
+using EvaluateStage = std::function<absl::Status(
+    int stage_idx, absl::Span<const int> example_idxs,
+    absl::Span<float> outputs)>;
+
+absl::Status CheckEarlyExitModel(const GradientBoostedTreesModel& model) {
+  using model::gradient_boosted_trees::proto::Loss;
+  if (model.loss() != Loss::BINOMIAL_LOG_LIKELIHOOD &&
+      model.loss() != Loss::BINARY_FOCAL_LOSS) {
+    return absl::InvalidArgumentError(
+        "Early exit inference only supports binary classification models");
+  }
+  if (model.initial_predictions().size() != 1) {
+    return absl::InvalidArgumentError("Invalid initial predictions");
+  }
+  if (!model.CheckStructure({/*.global_imputation_is_higher =*/false})) {
+    return absl::InvalidArgumentError(
+        "Early exit inference only supports models trained with "
+        "missing_value_policy=GLOBAL_IMPUTATION");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CheckEarlyExitOptions(const EarlyExitOptions& options) {
+  if (options.num_trees_per_stage <= 0) {
+    return absl::InvalidArgumentError(
+        "\"num_trees_per_stage\" should be strictly positive");
+  }
+  if (!(options.max_error_rate >= 0.f && options.max_error_rate < 0.5f)) {
+    return absl::InvalidArgumentError(
+        "\"max_error_rate\" should be in [0, 0.5)");
+  }
+  if (!(options.decision_threshold > 0.f && options.decision_threshold < 1.f)) {
+    return absl::InvalidArgumentError(
+        "\"decision_threshold\" should be in (0, 1)");
+  }
+  return absl::OkStatus();
+}
+
+// Index of the last tree (exclusive) of each stage.
+std::vector<int> StageEndTreeIdxs(const int num_trees,
+                                  const int num_trees_per_stage) {
+  std::vector<int> end_tree_idxs;
+  for (int end_tree_idx = num_trees_per_stage; end_tree_idx < num_trees;
+       end_tree_idx += num_trees_per_stage) {
+    end_tree_idxs.push_back(end_tree_idx);
+  }
+  end_tree_idxs.push_back(num_trees);
+  return end_tree_idxs;
+}
+
+bool NeedUint32NodeIndex(const GradientBoostedTreesModel& model) {
+  for (const auto& tree : model.decision_trees()) {
+    if (tree->NumNodes() >= std::numeric_limits<uint16_t>::max()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Minimum and maximum leaf value of a tree.
+std::pair<float, float> LeafValueRange(
+    const model::decision_tree::DecisionTree& tree) {
+  float min_value = std::numeric_limits<float>::infinity();
+  float max_value = -std::numeric_limits<float>::infinity();
+  tree.IterateOnNodes([&](const model::decision_tree::NodeWithChildren& node,
+                          const int depth) {
+    if (node.IsLeaf()) {
+      const float value = node.node().regressor().top_value();
+      min_value = std::min(min_value, value);
+      max_value = std::max(max_value, value);
+    }
+  });
+  return {min_value, max_value};
+}
+
+// Partial logits (without initial prediction) of the examples of "dataset"
+// after each stage.
+template <typename GenericModel>
+absl::StatusOr<std::vector<std::vector<float>>> ComputeStageLogits(
+    const GradientBoostedTreesModel& model,
+    const dataset::VerticalDataset& dataset,
+    const std::vector<int>& end_tree_idxs) {
+  GenericModel compiled_model;
+  RETURN_IF_ERROR(GenericToSpecializedModel(model, &compiled_model));
+  ASSIGN_OR_RETURN(const auto examples,
+                   VerticalDatasetToExampleSet(dataset, compiled_model));
+
+  std::vector<int> example_idxs(dataset.nrow());
+  std::iota(example_idxs.begin(), example_idxs.end(), 0);
+  std::vector<float> logits(dataset.nrow(), 0.f);
+  std::vector<std::vector<float>> stage_logits;
+  stage_logits.reserve(end_tree_idxs.size());
+  int begin_tree_idx = 0;
+  for (const int end_tree_idx : end_tree_idxs) {
+    AddTreeRangeOutputs(compiled_model, examples, example_idxs, begin_tree_idx,
+                        end_tree_idx, absl::MakeSpan(logits));
+    stage_logits.push_back(logits);
+    begin_tree_idx = end_tree_idx;
+  }
+  return stage_logits;
+}
+
+// Evaluates the stages on a batch of examples, and retires the examples as
+// soon as their decision is known.
+absl::Status PredictCascade(const std::vector<EarlyExitStage>& stages,
+                            const float initial_prediction,
+                            const bool output_logits, const int num_examples,
+                            const EvaluateStage& evaluate_stage,
+                            std::vector<float>* predictions) {
+  predictions->assign(num_examples, 0.f);
+  if (num_examples == 0) {
+    return absl::OkStatus();
+  }
+  std::vector<int> active_idxs(num_examples);
+  std::iota(active_idxs.begin(), active_idxs.end(), 0);
+  std::vector<float> active_logits(num_examples, 0.f);
+
+  for (int stage_idx = 0; stage_idx < stages.size(); stage_idx++) {
+    const auto& stage = stages[stage_idx];
+    const int num_active = active_idxs.size();
+    RETURN_IF_ERROR(
+        evaluate_stage(stage_idx, active_idxs,
+                       absl::MakeSpan(active_logits).first(num_active)));
+
+    // Retires the examples with a known decision, and compacts the others.
+    int num_remaining = 0;
+    for (int active_idx = 0; active_idx < num_active; active_idx++) {
+      const float logit = active_logits[active_idx];
+      const int example_idx = active_idxs[active_idx];
+      if (logit >= stage.positive_logit || logit < stage.negative_logit) {
+        (*predictions)[example_idx] = logit + stage.remaining_logit;
+      } else {
+        active_idxs[num_remaining] = example_idx;
+        active_logits[num_remaining] = logit;
+        num_remaining++;
+      }
+    }
+    active_idxs.resize(num_remaining);
+    if (num_remaining == 0) {
+      break;
+    }
+  }
+
+  for (auto& prediction : *predictions) {
+    const float logit = prediction + initial_prediction;
+    if (output_logits) {
+      prediction = logit;
+    } else {
+      prediction = std::clamp(1.f / (1.f + std::exp(-logit)), 0.f, 1.f);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Reports an error of "PredictCascade". "FastEngine::Predict" cannot return
+// a status: The error is logged and the predictions are set to NaN.
+void HandlePredictCascadeError(const absl::Status& status,
+                               std::vector<float>* predictions) {
+  if (status.ok()) {
+    return;
+  }
+  LOG(ERROR) << "Early exit inference failed: " << status;
+  std::fill(predictions->begin(), predictions->end(),
+            std::numeric_limits<float>::quiet_NaN());
+}
+
+// Early exit engine over a flat node model (e.g.
+// "GenericGradientBoostedTreesBinaryClassification").
+template <typename GenericModel>
+class GenericEarlyExitEngine : public FastEngine {
+ public:
+  GenericEarlyExitEngine(GenericModel model, std::vector<EarlyExitStage> stages,
+                         const float initial_prediction,
+                         const bool output_logits)
+      : model_(std::move(model)),
+        stages_(std::move(stages)),
+        initial_prediction_(initial_prediction),
+        output_logits_(output_logits) {}
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return std::make_unique<typename GenericModel::ExampleSet>(num_examples,
+                                                               model_);
+  }
+
+  void Predict(const AbstractExampleSet& examples, const int num_examples,
+               std::vector<float>* predictions) const override {
+    const auto& casted_examples =
+        dynamic_cast<const typename GenericModel::ExampleSet&>(examples);
+    const absl::Status status = PredictCascade(
+        stages_, initial_prediction_, output_logits_, num_examples,
+        [&](const int stage_idx, const absl::Span<const int> example_idxs,
+            const absl::Span<float> outputs) -> absl::Status {
+          const int begin_tree_idx =
+              stage_idx == 0 ? 0 : stages_[stage_idx - 1].end_tree_idx;
+          AddTreeRangeOutputs(model_, casted_examples, example_idxs,
+                              begin_tree_idx, stages_[stage_idx].end_tree_idx,
+                              outputs);
+          return absl::OkStatus();
+        },
+        predictions);
+    HandlePredictCascadeError(status, predictions);
+  }
+
+  int NumPredictionDimension() const override { return 1; }
+
+  const serving::FeaturesDefinition& features() const override {
+    return model_.features();
+  }
+
+ private:
+  GenericModel model_;
+  std::vector<EarlyExitStage> stages_;
+  float initial_prediction_;
+  bool output_logits_;
+};
+
+// Early exit engine over one QuickScorer model per stage. The active examples
+// are gathered into a dense example set before the evaluation of each stage.
+class QuickScorerEarlyExitEngine : public FastEngine {
+ public:
+  QuickScorerEarlyExitEngine(std::vector<QuickScorerModel> stage_models,
+                             std::vector<EarlyExitStage> stages,
+                             const float initial_prediction,
+                             const bool output_logits)
+      : stage_models_(std::move(stage_models)),
+        stages_(std::move(stages)),
+        initial_prediction_(initial_prediction),
+        output_logits_(output_logits) {}
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return std::make_unique<QuickScorerModel::ExampleSet>(
+        num_examples, stage_models_.front());
+  }
+
+  void Predict(const AbstractExampleSet& examples, const int num_examples,
+               std::vector<float>* predictions) const override {
+    const auto& casted_examples =
+        dynamic_cast<const QuickScorerModel::ExampleSet&>(examples);
+    std::unique_ptr<QuickScorerModel::ExampleSet> active_examples;
+    std::vector<float> stage_outputs;
+    const absl::Status status = PredictCascade(
+        stages_, initial_prediction_, output_logits_, num_examples,
+        [&](const int stage_idx, const absl::Span<const int> example_idxs,
+            const absl::Span<float> outputs) -> absl::Status {
+          const auto& stage_model = stage_models_[stage_idx];
+          const int num_active = example_idxs.size();
+          if (num_active == num_examples) {
+            // No example was retired. "example_idxs" is [0, num_examples).
+            decision_forest::Predict(stage_model, casted_examples, num_active,
+                                     &stage_outputs);
+          } else {
+            if (!active_examples) {
+              active_examples = std::make_unique<QuickScorerModel::ExampleSet>(
+                  num_examples, stage_model);
+            }
+            RETURN_IF_ERROR(casted_examples.Gather(
+                example_idxs, stage_model.features(), active_examples.get()));
+            decision_forest::Predict(stage_model, *active_examples, num_active,
+                                     &stage_outputs);
+          }
+          for (int active_idx = 0; active_idx < num_active; active_idx++) {
+            outputs[active_idx] += stage_outputs[active_idx];
+          }
+          return absl::OkStatus();
+        },
+        predictions);
+    HandlePredictCascadeError(status, predictions);
+  }
+
+  int NumPredictionDimension() const override { return 1; }
+
+  const serving::FeaturesDefinition& features() const override {
+    return stage_models_.front().features();
+  }
+
+ private:
+  std::vector<QuickScorerModel> stage_models_;
+  std::vector<EarlyExitStage> stages_;
+  float initial_prediction_;
+  bool output_logits_;
+};
+
+template <typename GenericModel>
+absl::StatusOr<std::unique_ptr<FastEngine>> BuildGenericEarlyExitEngine(
+    const GradientBoostedTreesModel& model,
+    std::vector<EarlyExitStage> stages) {
+  GenericModel compiled_model;
+  RETURN_IF_ERROR(GenericToSpecializedModel(model, &compiled_model));
+  return std::make_unique<GenericEarlyExitEngine<GenericModel>>(
+      std::move(compiled_model), std::move(stages),
+      model.initial_predictions()[0], model.output_logits());
+}
+
+absl::StatusOr<std::unique_ptr<FastEngine>> BuildQuickScorerEarlyExitEngine(
+    const GradientBoostedTreesModel& model,
+    std::vector<EarlyExitStage> stages) {
+  std::vector<QuickScorerModel> stage_models(stages.size());
+  int begin_tree_idx = 0;
+  for (int stage_idx = 0; stage_idx < stages.size(); stage_idx++) {
+    RETURN_IF_ERROR(GenericToSpecializedModelTreeRange(
+        model, begin_tree_idx, stages[stage_idx].end_tree_idx,
+        &stage_models[stage_idx]));
+    begin_tree_idx = stages[stage_idx].end_tree_idx;
+  }
+  const auto& features = stage_models.front().features();
+  if (!features.categorical_set_features().empty() ||
+      !features.numerical_vector_sequence_features().empty()) {
+    // The active examples cannot be gathered.
+    return absl::UnimplementedError(
+        "The QuickScorer early exit engine does not support variable length "
+        "features");
+  }
+  return std::make_unique<QuickScorerEarlyExitEngine>(
+      std::move(stage_models), std::move(stages),
+      model.initial_predictions()[0], model.output_logits());
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<EarlyExitStage>> CalibrateEarlyExitStages(
+    const GradientBoostedTreesModel& model,
+    const dataset::VerticalDataset& validation,
+    const EarlyExitOptions& options) {
+  RETURN_IF_ERROR(CheckEarlyExitModel(model));
+  RETURN_IF_ERROR(CheckEarlyExitOptions(options));
+
+  const int num_trees = model.NumTrees();
+  if (num_trees == 0) {
+    return absl::InvalidArgumentError("The model does not contain any tree");
+  }
+  const std::vector<int> end_tree_idxs =
+      StageEndTreeIdxs(num_trees, options.num_trees_per_stage);
+
+  std::vector<std::vector<float>> stage_logits;
+  if (NeedUint32NodeIndex(model)) {
+    ASSIGN_OR_RETURN(
+        stage_logits,
+        ComputeStageLogits<
+            GenericGradientBoostedTreesBinaryClassification<uint32_t>>(
+            model, validation, end_tree_idxs));
+  } else {
+    ASSIGN_OR_RETURN(
+        stage_logits,
+        ComputeStageLogits<GradientBoostedTreesBinaryClassification>(
+            model, validation, end_tree_idxs));
+  }
+  const std::vector<float>& final_logits = stage_logits.back();
+
+  // Range of the sum of the outputs of the trees [tree_idx, num_trees).
+  std::vector<float> min_remaining(num_trees + 1, 0.f);
+  std::vector<float> max_remaining(num_trees + 1, 0.f);
+  for (int tree_idx = num_trees - 1; tree_idx >= 0; tree_idx--) {
+    const auto [min_value, max_value] =
+        LeafValueRange(*model.decision_trees()[tree_idx]);
+    min_remaining[tree_idx] = min_remaining[tree_idx + 1] + min_value;
+    max_remaining[tree_idx] = max_remaining[tree_idx + 1] + max_value;
+  }
+
+  // Decision threshold on the partial logit of the full model.
+  const float threshold =
+      std::log(options.decision_threshold /
+               (1.f - options.decision_threshold)) -
+      model.initial_predictions()[0];
+
+  // The errors of the stages add up: An example can only be retired once, and
+  // each of the early exit stages has two sides. Splitting "max_error_rate"
+  // evenly bounds the error rate of the whole cascade on "validation".
+  const int num_early_exit_stages = end_tree_idxs.size() - 1;
+  const float tail_error_rate =
+      options.max_error_rate / (2 * std::max(1, num_early_exit_stages));
+
+  const int num_examples = validation.nrow();
+  std::vector<EarlyExitStage> stages;
+  stages.reserve(end_tree_idxs.size());
+  std::vector<float> remaining(num_examples);
+  for (int stage_idx = 0; stage_idx + 1 < end_tree_idxs.size(); stage_idx++) {
+    const int end_tree_idx = end_tree_idxs[stage_idx];
+    float lower_remaining = min_remaining[end_tree_idx];
+    float upper_remaining = max_remaining[end_tree_idx];
+    float mean_remaining = (lower_remaining + upper_remaining) / 2;
+
+    if (num_examples > 0) {
+      double sum_remaining = 0;
+      for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+        remaining[example_idx] =
+            final_logits[example_idx] - stage_logits[stage_idx][example_idx];
+        sum_remaining += remaining[example_idx];
+      }
+      mean_remaining = sum_remaining / num_examples;
+
+      if (options.max_error_rate > 0.f) {
+        // An example retired as positive (resp. negative) has a different
+        // decision than the full model if its remaining output is lower than
+        // "lower_remaining" (resp. greater than "upper_remaining"). This
+        // happens for at most "tail_error_rate" of the validation examples on
+        // each side.
+        std::sort(remaining.begin(), remaining.end());
+        const int lower_idx = static_cast<int>(
+            std::floor(tail_error_rate * (num_examples - 1)));
+        const int upper_idx = static_cast<int>(
+            std::ceil((1.f - tail_error_rate) * (num_examples - 1)));
+        lower_remaining = remaining[lower_idx];
+        upper_remaining = remaining[upper_idx];
+      }
+    }
+
+    // The approximated prediction of a retired example should have the same
+    // decision as its retirement.
+    mean_remaining =
+        std::clamp(mean_remaining, lower_remaining, upper_remaining);
+
+    stages.push_back({/*.end_tree_idx =*/end_tree_idx,
+                      /*.positive_logit =*/threshold - lower_remaining,
+                      /*.negative_logit =*/threshold - upper_remaining,
+                      /*.remaining_logit =*/mean_remaining});
+  }
+
+  // All the examples are retired after the last stage.
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  stages.push_back({/*.end_tree_idx =*/num_trees,
+                    /*.positive_logit =*/-kInf,
+                    /*.negative_logit =*/-kInf,
+                    /*.remaining_logit =*/0.f});
+  return stages;
+}
+
+absl::StatusOr<std::unique_ptr<FastEngine>> BuildEarlyExitEngine(
+    const GradientBoostedTreesModel& model,
+    const dataset::VerticalDataset& validation,
+    const EarlyExitOptions& options) {
+  ASSIGN_OR_RETURN(auto stages,
+                   CalibrateEarlyExitStages(model, validation, options));
+
+  switch (options.engine) {
+    case EarlyExitOptions::Engine::kQuickScorer:
+      return BuildQuickScorerEarlyExitEngine(model, std::move(stages));
+    case EarlyExitOptions::Engine::kAuto: {
+      const auto compatible_engines = model.ListCompatibleFastEngineNames();
+      if (std::find(compatible_engines.begin(), compatible_engines.end(),
+                    gradient_boosted_trees::kQuickScorerExtended) !=
+          compatible_engines.end()) {
+        auto engine = BuildQuickScorerEarlyExitEngine(model, stages);
+        if (engine.ok()) {
+          return engine;
+        }
+        // Falls back to the generic engine.
+      }
+    }
+      [[fallthrough]];
+    case EarlyExitOptions::Engine::kGeneric:
+      if (NeedUint32NodeIndex(model)) {
+        return BuildGenericEarlyExitEngine<
+            GenericGradientBoostedTreesBinaryClassification<uint32_t>>(
+            model, std::move(stages));
+      } else {
+        return BuildGenericEarlyExitEngine<
+            GradientBoostedTreesBinaryClassification>(model,
+                                                      std::move(stages));
+      }
+  }
+  return absl::InvalidArgumentError("Unknown engine");
+}
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
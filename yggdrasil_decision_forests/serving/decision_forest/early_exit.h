@@ -0,0 +1,115 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Early exit (a.k.a. cascade) inference for Gradient Boosted Trees binary
+// classification models.
+//
+// The trees are evaluated in stages of "num_trees_per_stage" trees. After each
+// stage, the examples whose partial score is far enough from the decision
+// threshold are retired: Their remaining trees are not evaluated, and the
+// expected output of the remaining trees is used instead.
+//
+// The retirement thresholds of the stages are calibrated on a validation
+// dataset such that the decision of at most a fraction "max_error_rate" of the
+// validation examples differs from the decision of the full model. The bound
+// holds for the whole cascade: "max_error_rate" is split evenly among the
+// stages. With "max_error_rate=0", the thresholds are computed from the range
+// of the leaf values, and the decisions are the ones of the full model (up to
+// floating point rounding).
+//
+// The predictions of the retired examples are approximate. If the model
+// outputs logits, the returned logits include the initial prediction.
+//
+// Usage example:
+//   const GradientBoostedTreesModel& model = ...;
+//   const VerticalDataset validation = ...;
+//   ASSIGN_OR_RETURN(auto engine,
+//                    BuildEarlyExitEngine(model, validation, {}));
+//   // Use "engine" as any other "FastEngine".
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_EARLY_EXIT_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_EARLY_EXIT_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+struct EarlyExitOptions {
+  enum class Engine {
+    // Selects the fastest engine compatible with the model.
+    kAuto,
+    // Flat node engine (see "decision_forest_serving.h").
+    kGeneric,
+    // QuickScorer engine (see "quick_scorer_extended.h").
+    kQuickScorer,
+  };
+
+  // Number of trees evaluated before each early exit check.
+  int num_trees_per_stage = 10;
+
+  // Maximum fraction of validation examples whose decision can differ from the
+  // decision of the full model, over all the stages. Should be in [0, 0.5). If
+  // 0, the decisions are the ones of the full model.
+  float max_error_rate = 0.001f;
+
+  // Probability threshold of the positive class.
+  float decision_threshold = 0.5f;
+
+  Engine engine = Engine::kAuto;
+};
+
+// Early exit thresholds after the evaluation of a stage. The logits are the
+// sum of the outputs of the trees evaluated so far (i.e. without the initial
+// prediction).
+struct EarlyExitStage {
+  // Index of the last tree (exclusive) evaluated in this stage.
+  int end_tree_idx;
+  // An example is retired as positive if its partial logit is greater or equal
+  // to "positive_logit", and as negative if its partial logit is strictly less
+  // than "negative_logit".
+  float positive_logit;
+  float negative_logit;
+  // Expected output of the remaining trees. Added to the partial logit of the
+  // retired examples.
+  float remaining_logit;
+};
+
+// Computes the early exit stages of a binary classification GBT model on a
+// validation dataset. The last stage is always evaluated fully.
+absl::StatusOr<std::vector<EarlyExitStage>> CalibrateEarlyExitStages(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& model,
+    const dataset::VerticalDataset& validation,
+    const EarlyExitOptions& options);
+
+// Creates an early exit engine for a binary classification GBT model. If the
+// inference fails, the error is logged and the predictions are NaN.
+absl::StatusOr<std::unique_ptr<FastEngine>> BuildEarlyExitEngine(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& model,
+    const dataset::VerticalDataset& validation,
+    const EarlyExitOptions& options);
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_EARLY_EXIT_H_
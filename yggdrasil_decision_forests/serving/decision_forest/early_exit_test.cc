@@ -0,0 +1,183 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/early_exit.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace {
+
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using test::StatusIs;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+void LoadModelAndDataset(const absl::string_view model_name,
+                         const absl::string_view dataset_filename,
+                         std::unique_ptr<model::AbstractModel>* model,
+                         dataset::VerticalDataset* dataset) {
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), model));
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", dataset_filename)),
+      (*model)->data_spec(), dataset));
+}
+
+std::vector<float> PredictDataset(const FastEngine& engine,
+                                  const dataset::VerticalDataset& dataset) {
+  auto examples = engine.AllocateExamples(dataset.nrow());
+  CHECK_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, dataset.nrow(), engine.features(), examples.get()));
+  std::vector<float> predictions;
+  engine.Predict(*examples, dataset.nrow(), &predictions);
+  return predictions;
+}
+
+// Fraction of the examples with the same decision in "predictions" as in
+// "expected_predictions". Ignores the examples too close to the threshold to
+// be compared reliably.
+double DecisionAgreement(const std::vector<float>& predictions,
+                         const std::vector<float>& expected_predictions) {
+  int num_compared = 0;
+  int num_agreements = 0;
+  for (int example_idx = 0; example_idx < predictions.size(); example_idx++) {
+    if (std::abs(expected_predictions[example_idx] - 0.5f) < 1e-5f) {
+      continue;
+    }
+    num_compared++;
+    if ((predictions[example_idx] >= 0.5f) ==
+        (expected_predictions[example_idx] >= 0.5f)) {
+      num_agreements++;
+    }
+  }
+  return static_cast<double>(num_agreements) / num_compared;
+}
+
+class EarlyExit : public testing::TestWithParam<EarlyExitOptions::Engine> {};
+
+TEST_P(EarlyExit, LosslessAdult) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  const auto* gbt_model =
+      dynamic_cast<const GradientBoostedTreesModel*>(model.get());
+  ASSERT_NE(gbt_model, nullptr);
+
+  EarlyExitOptions options;
+  options.max_error_rate = 0.f;
+  options.engine = GetParam();
+  ASSERT_OK_AND_ASSIGN(const auto engine,
+                       BuildEarlyExitEngine(*gbt_model, dataset, options));
+  ASSERT_OK_AND_ASSIGN(const auto full_engine, model->BuildFastEngine());
+
+  const auto predictions = PredictDataset(*engine, dataset);
+  const auto expected_predictions = PredictDataset(*full_engine, dataset);
+  ASSERT_EQ(predictions.size(), expected_predictions.size());
+  EXPECT_EQ(DecisionAgreement(predictions, expected_predictions), 1.);
+}
+
+TEST_P(EarlyExit, LossyAdult) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  const auto* gbt_model =
+      dynamic_cast<const GradientBoostedTreesModel*>(model.get());
+  ASSERT_NE(gbt_model, nullptr);
+
+  EarlyExitOptions options;
+  options.max_error_rate = 0.001f;
+  options.engine = GetParam();
+  ASSERT_OK_AND_ASSIGN(const auto stages,
+                       CalibrateEarlyExitStages(*gbt_model, dataset, options));
+  ASSERT_FALSE(stages.empty());
+  EXPECT_EQ(stages.back().end_tree_idx, gbt_model->NumTrees());
+
+  ASSERT_OK_AND_ASSIGN(const auto engine,
+                       BuildEarlyExitEngine(*gbt_model, dataset, options));
+  ASSERT_OK_AND_ASSIGN(const auto full_engine, model->BuildFastEngine());
+
+  const auto predictions = PredictDataset(*engine, dataset);
+  const auto expected_predictions = PredictDataset(*full_engine, dataset);
+  ASSERT_EQ(predictions.size(), expected_predictions.size());
+  // The thresholds are calibrated on the same dataset.
+  EXPECT_GE(DecisionAgreement(predictions, expected_predictions),
+            1. - options.max_error_rate);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllEngines, EarlyExit,
+    testing::Values(EarlyExitOptions::Engine::kAuto,
+                    EarlyExitOptions::Engine::kGeneric,
+                    EarlyExitOptions::Engine::kQuickScorer));
+
+TEST(EarlyExit, NonBinaryClassificationModel) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("abalone_regression_gbdt", "abalone.csv", &model,
+                      &dataset);
+  const auto* gbt_model =
+      dynamic_cast<const GradientBoostedTreesModel*>(model.get());
+  ASSERT_NE(gbt_model, nullptr);
+  EXPECT_THAT(BuildEarlyExitEngine(*gbt_model, dataset, {}).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(EarlyExit, InvalidOptions) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  const auto* gbt_model =
+      dynamic_cast<const GradientBoostedTreesModel*>(model.get());
+  ASSERT_NE(gbt_model, nullptr);
+  EarlyExitOptions options;
+  options.num_trees_per_stage = 0;
+  EXPECT_THAT(CalibrateEarlyExitStages(*gbt_model, dataset, options).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
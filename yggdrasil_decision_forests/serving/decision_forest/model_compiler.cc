@@ -34,8 +34,8 @@ namespace yggdrasil_decision_forests {
 namespace serving {
 namespace decision_forest {
 namespace {
-template <typename T>
-std::string NumericalVecToString(const std::vector<T>& vec) {
+template <typename Container>
+std::string NumericalVecToString(const Container& vec) {
   std::string str = "{";
 
   for (size_t i = 0; i < vec.size(); ++i) {
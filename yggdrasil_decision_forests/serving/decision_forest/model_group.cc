@@ -0,0 +1,588 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/model_group.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_forest_interface.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/model/isolation_forest/isolation_forest.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/register_engines.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/example_set_model_wrapper.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+namespace {
+
+using dataset::proto::Column;
+using dataset::proto::ColumnType;
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using model::isolation_forest::IsolationForestModel;
+using model::random_forest::RandomForestModel;
+using QuickScorerModel =
+    GradientBoostedTreesBinaryClassificationQuickScorerExtended;
+
+// Checks that two columns are represented in the same way in an example set.
+// The numerical statistics are not compared since the missing numerical values
+// are represented as NaN.
+absl::Status CheckCompatibleColumns(const Column& expected,
+                                    const Column& actual) {
+  const auto error = [&](const absl::string_view reason) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("The input feature \"$0\" is not compatible between "
+                         "the models of the group: $1",
+                         expected.name(), reason));
+  };
+  if (expected.name() != actual.name()) {
+    return error(absl::StrCat("Different name \"", actual.name(), "\""));
+  }
+  if (expected.type() != actual.type()) {
+    return error("Different type");
+  }
+  if (expected.is_unstacked() != actual.is_unstacked()) {
+    return error("Different unstacking");
+  }
+  switch (expected.type()) {
+    case ColumnType::CATEGORICAL:
+    case ColumnType::CATEGORICAL_SET: {
+      const auto& a = expected.categorical();
+      const auto& b = actual.categorical();
+      if (a.is_already_integerized() != b.is_already_integerized() ||
+          a.number_of_unique_values() != b.number_of_unique_values() ||
+          a.most_frequent_value() != b.most_frequent_value() ||
+          a.items_size() != b.items_size()) {
+        return error("Different categorical dictionary");
+      }
+      for (const auto& [key, value] : a.items()) {
+        const auto it = b.items().find(key);
+        if (it == b.items().end() || it->second.index() != value.index()) {
+          return error("Different categorical dictionary");
+        }
+      }
+    } break;
+    case ColumnType::BOOLEAN:
+      if ((expected.boolean().count_true() >=
+           expected.boolean().count_false()) !=
+          (actual.boolean().count_true() >= actual.boolean().count_false())) {
+        return error("Different most frequent boolean value");
+      }
+      break;
+    case ColumnType::DISCRETIZED_NUMERICAL:
+      if (!std::equal(
+              expected.discretized_numerical().boundaries().begin(),
+              expected.discretized_numerical().boundaries().end(),
+              actual.discretized_numerical().boundaries().begin(),
+              actual.discretized_numerical().boundaries().end())) {
+        return error("Different discretization boundaries");
+      }
+      break;
+    case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+      if (expected.numerical_vector_sequence().vector_length() !=
+          actual.numerical_vector_sequence().vector_length()) {
+        return error("Different vector length");
+      }
+      break;
+    default:
+      break;
+  }
+  return absl::OkStatus();
+}
+
+// Checks that the unstacked features containing "column_idx" are the same in
+// both dataspecs.
+absl::Status CheckCompatibleUnstacked(
+    const dataset::proto::DataSpecification& expected,
+    const dataset::proto::DataSpecification& actual, const int column_idx) {
+  const auto find = [&](const dataset::proto::DataSpecification& spec)
+      -> const dataset::proto::Unstacked* {
+    for (const auto& unstacked : spec.unstackeds()) {
+      if (column_idx >= unstacked.begin_column_idx() &&
+          column_idx < unstacked.begin_column_idx() + unstacked.size()) {
+        return &unstacked;
+      }
+    }
+    return nullptr;
+  };
+  const auto* a = find(expected);
+  const auto* b = find(actual);
+  if (a == nullptr || b == nullptr ||
+      a->original_name() != b->original_name() ||
+      a->begin_column_idx() != b->begin_column_idx() ||
+      a->size() != b->size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The unstacked feature containing the column \"",
+        expected.columns(column_idx).name(),
+        "\" is not compatible between the models of the group"));
+  }
+  return absl::OkStatus();
+}
+
+// Number of trees in a range of the interleaved schedule. The nodes of a range
+// of trees stay in cache while they are applied on all the examples.
+constexpr int kNumTreesPerRange = 32;
+
+int NumTreeRanges(const int num_trees) {
+  return (num_trees + kNumTreesPerRange - 1) / kNumTreesPerRange;
+}
+
+// A model of the group: Either an engine or an interleaved model.
+struct GroupMember {
+  std::unique_ptr<FastEngine> engine;
+  std::unique_ptr<internal::InterleavedModel> interleaved;
+};
+
+// Interleaved single dimension GBT model compiled with the generic flat node
+// engine.
+template <typename Model>
+class GenericInterleavedModel : public internal::InterleavedModel {
+ public:
+  explicit GenericInterleavedModel(Model model) : model_(std::move(model)) {}
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return std::make_unique<typename Model::ExampleSet>(num_examples, model_);
+  }
+
+  const FeaturesDefinition& features() const override {
+    return model_.features();
+  }
+
+  int NumTreeRanges() const override {
+    return decision_forest::NumTreeRanges(model_.root_offsets.size());
+  }
+
+  void AddTreeRangeOutputs(const AbstractExampleSet& examples,
+                           const absl::Span<const int> example_idxs,
+                           const int range_idx, const absl::Span<float> outputs,
+                           std::vector<float>* buffer) const override {
+    const auto& casted_examples =
+        dynamic_cast<const typename Model::ExampleSet&>(examples);
+    const int begin_tree_idx = range_idx * kNumTreesPerRange;
+    const int end_tree_idx =
+        std::min<int>(begin_tree_idx + kNumTreesPerRange,
+                      model_.root_offsets.size());
+    decision_forest::AddTreeRangeOutputs(model_, casted_examples, example_idxs,
+                                         begin_tree_idx, end_tree_idx,
+                                         outputs);
+  }
+
+  void FinalizeOutputs(const absl::Span<float> outputs) const override {
+    FinalizeTreeOutputs(model_, outputs);
+  }
+
+ private:
+  Model model_;
+};
+
+// Interleaved GBT binary classifier compiled with QuickScorer. Each range of
+// trees is a separate QuickScorer model.
+class QuickScorerInterleavedModel : public internal::InterleavedModel {
+ public:
+  QuickScorerInterleavedModel(std::vector<QuickScorerModel> range_models,
+                              const float initial_prediction,
+                              const bool output_logits)
+      : range_models_(std::move(range_models)),
+        initial_prediction_(initial_prediction),
+        output_logits_(output_logits) {}
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return std::make_unique<QuickScorerModel::ExampleSet>(
+        num_examples, range_models_.front());
+  }
+
+  const FeaturesDefinition& features() const override {
+    return range_models_.front().features();
+  }
+
+  int NumTreeRanges() const override { return range_models_.size(); }
+
+  void AddTreeRangeOutputs(const AbstractExampleSet& examples,
+                           const absl::Span<const int> example_idxs,
+                           const int range_idx, const absl::Span<float> outputs,
+                           std::vector<float>* buffer) const override {
+    const auto& casted_examples =
+        dynamic_cast<const QuickScorerModel::ExampleSet&>(examples);
+    decision_forest::Predict(range_models_[range_idx], casted_examples,
+                             example_idxs.size(), buffer);
+    for (size_t example_idx = 0; example_idx < outputs.size(); example_idx++) {
+      outputs[example_idx] += (*buffer)[example_idx];
+    }
+  }
+
+  void FinalizeOutputs(const absl::Span<float> outputs) const override {
+    for (auto& output : outputs) {
+      const float logit = output + initial_prediction_;
+      if (output_logits_) {
+        output = logit;
+      } else {
+        output = std::clamp(1.f / (1.f + std::exp(-logit)), 0.f, 1.f);
+      }
+    }
+  }
+
+ private:
+  std::vector<QuickScorerModel> range_models_;
+  float initial_prediction_;
+  bool output_logits_;
+};
+
+// Compiles a model with the generic engine and the example set layout of the
+// group.
+template <typename SpecializedModel, typename SourceModel>
+absl::StatusOr<GroupMember> CreateGroupEngine(
+    const SourceModel& src, const std::vector<int>& input_features) {
+  auto engine = std::make_unique<
+      ExampleSetModelWrapper<SpecializedModel, Predict, PredictColumnar>>();
+  engine->mutable_model()->shared_input_features = input_features;
+  RETURN_IF_ERROR(engine->template LoadModel<SourceModel>(src));
+  return GroupMember{std::move(engine), nullptr};
+}
+
+// Compiles a single dimension GBT model with the generic engine and the
+// example set layout of the group, for the interleaved schedule.
+template <typename SpecializedModel>
+absl::StatusOr<GroupMember> CreateGenericInterleavedModel(
+    const GradientBoostedTreesModel& src,
+    const std::vector<int>& input_features) {
+  SpecializedModel model;
+  model.shared_input_features = input_features;
+  RETURN_IF_ERROR(GenericToSpecializedModel(src, &model));
+  return GroupMember{
+      nullptr, std::make_unique<GenericInterleavedModel<SpecializedModel>>(
+                   std::move(model))};
+}
+
+absl::StatusOr<GroupMember> CreateGenericGroupMember(
+    const GradientBoostedTreesModel& src,
+    const std::vector<int>& input_features) {
+  switch (src.task()) {
+    case model::proto::CLASSIFICATION:
+      if (src.label_col_spec().categorical().number_of_unique_values() == 3) {
+        return CreateGenericInterleavedModel<
+            GradientBoostedTreesBinaryClassification>(src, input_features);
+      }
+      return CreateGroupEngine<GradientBoostedTreesMulticlassClassification>(
+          src, input_features);
+    case model::proto::REGRESSION:
+      if (src.loss() == model::gradient_boosted_trees::proto::POISSON) {
+        return CreateGenericInterleavedModel<
+            GradientBoostedTreesPoissonRegression>(src, input_features);
+      }
+      return CreateGenericInterleavedModel<GradientBoostedTreesRegression>(
+          src, input_features);
+    case model::proto::RANKING:
+      return CreateGenericInterleavedModel<GradientBoostedTreesRanking>(
+          src, input_features);
+    default:
+      return absl::InvalidArgumentError("Non supported GBDT model");
+  }
+}
+
+absl::StatusOr<GroupMember> CreateGenericGroupMember(
+    const RandomForestModel& src, const std::vector<int>& input_features) {
+  switch (src.task()) {
+    case model::proto::CLASSIFICATION:
+      if (src.label_col_spec().categorical().number_of_unique_values() == 3) {
+        return CreateGroupEngine<RandomForestBinaryClassification>(
+            src, input_features);
+      }
+      return CreateGroupEngine<RandomForestMulticlassClassification>(
+          src, input_features);
+    case model::proto::REGRESSION:
+      return CreateGroupEngine<RandomForestRegression>(src, input_features);
+    case model::proto::CATEGORICAL_UPLIFT:
+      return CreateGroupEngine<RandomForestCategoricalUplift>(src,
+                                                              input_features);
+    case model::proto::NUMERICAL_UPLIFT:
+      return CreateGroupEngine<RandomForestNumericalUplift>(src,
+                                                            input_features);
+    default:
+      return absl::InvalidArgumentError("Non supported RF model");
+  }
+}
+
+absl::StatusOr<GroupMember> CreateGenericGroupMember(
+    const model::AbstractModel& src, const std::vector<int>& input_features) {
+  if (const auto* gbt = dynamic_cast<const GradientBoostedTreesModel*>(&src)) {
+    return CreateGenericGroupMember(*gbt, input_features);
+  }
+  if (const auto* rf = dynamic_cast<const RandomForestModel*>(&src)) {
+    return CreateGenericGroupMember(*rf, input_features);
+  }
+  if (const auto* iso = dynamic_cast<const IsolationForestModel*>(&src)) {
+    return CreateGroupEngine<IsolationForest>(*iso, input_features);
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Model \"", src.name(), "\" is not supported in a group"));
+}
+
+// Compiles a GBT binary classifier with QuickScorer and the example set layout
+// of the group, for the interleaved schedule.
+absl::StatusOr<GroupMember> CreateQuickScorerGroupMember(
+    const GradientBoostedTreesModel& src,
+    const std::vector<int>& input_features) {
+  const int num_trees = src.NumTrees();
+  std::vector<QuickScorerModel> range_models(NumTreeRanges(num_trees));
+  for (int range_idx = 0; range_idx < range_models.size(); range_idx++) {
+    const int begin_tree_idx = range_idx * kNumTreesPerRange;
+    RETURN_IF_ERROR(GenericToSpecializedModelTreeRange(
+        src, begin_tree_idx,
+        std::min(begin_tree_idx + kNumTreesPerRange, num_trees),
+        &range_models[range_idx], &input_features));
+  }
+  return GroupMember{nullptr, std::make_unique<QuickScorerInterleavedModel>(
+                                  std::move(range_models),
+                                  src.initial_predictions()[0],
+                                  src.output_logits())};
+}
+
+// Tests if a model can be compiled in a QuickScorer group.
+bool IsQuickScorerCompatible(const model::AbstractModel& src) {
+  const auto* gbt = dynamic_cast<const GradientBoostedTreesModel*>(&src);
+  if (gbt == nullptr || gbt->NumTrees() == 0 ||
+      gbt->initial_predictions().size() != 1) {
+    return false;
+  }
+  // Only the binary classifiers can be compiled by range of trees (see
+  // "GenericToSpecializedModelTreeRange").
+  using model::gradient_boosted_trees::proto::Loss;
+  if (gbt->loss() != Loss::BINOMIAL_LOG_LIKELIHOOD &&
+      gbt->loss() != Loss::BINARY_FOCAL_LOSS) {
+    return false;
+  }
+
+  // Like "BuildFastEngine", select the engine chosen by "AutotuneFastEngine"
+  // if any, and the fastest compatible engine otherwise. The engines that
+  // cannot read the example set of a group are skipped.
+  const auto compatible_engines = src.ListCompatibleFastEngineNames();
+  const auto& preferred_engine = src.metadata().preferred_fast_engine();
+  if (!preferred_engine.empty() &&
+      std::find(compatible_engines.begin(), compatible_engines.end(),
+                preferred_engine) != compatible_engines.end()) {
+    if (preferred_engine == gradient_boosted_trees::kQuickScorerExtended) {
+      return true;
+    }
+    if (preferred_engine == gradient_boosted_trees::kGeneric) {
+      return false;
+    }
+  }
+  for (const auto& engine : compatible_engines) {
+    if (engine == gradient_boosted_trees::kQuickScorerExtended) {
+      return true;
+    }
+    if (engine == gradient_boosted_trees::kGeneric) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Checks that a model can be compiled in a group.
+absl::Status CheckGroupModel(const model::AbstractModel& src) {
+  const auto* forest =
+      dynamic_cast<const model::DecisionForestInterface*>(&src);
+  if (forest == nullptr) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Model \"", src.name(), "\" is not a decision forest model"));
+  }
+  if (!forest->CheckStructure({/*.global_imputation_is_higher =*/false})) {
+    return absl::InvalidArgumentError(
+        "The models of a group should only contain conditions supported by "
+        "the generic flat node engine");
+  }
+  for (const auto& tree : forest->decision_trees()) {
+    if (tree->NumNodes() >= std::numeric_limits<uint16_t>::max()) {
+      return absl::InvalidArgumentError(
+          "The models of a group cannot contain trees with more than 65k "
+          "nodes");
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ModelGroup>> ModelGroup::Create(
+    const absl::Span<const model::AbstractModel* const> models) {
+  if (models.empty()) {
+    return absl::InvalidArgumentError("A model group requires one model.");
+  }
+
+  // Union of the input features of the models.
+  std::vector<int> input_features;
+  for (const auto* model : models) {
+    RETURN_IF_ERROR(CheckGroupModel(*model));
+    std::vector<int> model_input_features;
+    RETURN_IF_ERROR(GetInputFeatures(*model, &model_input_features, nullptr));
+    input_features.insert(input_features.end(), model_input_features.begin(),
+                          model_input_features.end());
+  }
+  std::sort(input_features.begin(), input_features.end());
+  input_features.erase(
+      std::unique(input_features.begin(), input_features.end()),
+      input_features.end());
+
+  // The example set is defined with the dataspec of the first model.
+  const auto& reference_spec = models.front()->data_spec();
+  for (const auto* model : models.subspan(1)) {
+    const auto& spec = model->data_spec();
+    for (const int column_idx : input_features) {
+      if (column_idx >= spec.columns_size()) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("The input feature \"",
+                         reference_spec.columns(column_idx).name(),
+                         "\" is missing in the dataspec of a model"));
+      }
+      RETURN_IF_ERROR(CheckCompatibleColumns(reference_spec.columns(column_idx),
+                                             spec.columns(column_idx)));
+      if (spec.columns(column_idx).is_unstacked()) {
+        RETURN_IF_ERROR(
+            CheckCompatibleUnstacked(reference_spec, spec, column_idx));
+      }
+    }
+  }
+
+  // The models are compiled with QuickScorer if all of them support it.
+  const bool use_quick_scorer =
+      std::all_of(models.begin(), models.end(),
+                  [](const model::AbstractModel* model) {
+                    return IsQuickScorerCompatible(*model);
+                  });
+
+  auto group = absl::WrapUnique(new ModelGroup());
+  group->engines_.reserve(models.size());
+  group->interleaved_models_.reserve(models.size());
+  for (const auto* model : models) {
+    GroupMember member;
+    if (use_quick_scorer) {
+      ASSIGN_OR_RETURN(
+          member, CreateQuickScorerGroupMember(
+                      dynamic_cast<const GradientBoostedTreesModel&>(*model),
+                      input_features));
+    } else {
+      ASSIGN_OR_RETURN(member,
+                       CreateGenericGroupMember(*model, input_features));
+    }
+    if (member.interleaved) {
+      group->max_num_tree_ranges_ = std::max(
+          group->max_num_tree_ranges_, member.interleaved->NumTreeRanges());
+    }
+    group->engines_.push_back(std::move(member.engine));
+    group->interleaved_models_.push_back(std::move(member.interleaved));
+  }
+  return group;
+}
+
+std::unique_ptr<AbstractExampleSet> ModelGroup::AllocateExamples(
+    const int num_examples) const {
+  if (engines_.front()) {
+    return engines_.front()->AllocateExamples(num_examples);
+  }
+  return interleaved_models_.front()->AllocateExamples(num_examples);
+}
+
+const FeaturesDefinition& ModelGroup::features() const {
+  if (engines_.front()) {
+    return engines_.front()->features();
+  }
+  return interleaved_models_.front()->features();
+}
+
+int ModelGroup::NumPredictionDimension(const int model_idx) const {
+  if (engines_[model_idx]) {
+    return engines_[model_idx]->NumPredictionDimension();
+  }
+  return 1;
+}
+
+int ModelGroup::NumInterleavedModels() const {
+  return std::count_if(interleaved_models_.begin(), interleaved_models_.end(),
+                       [](const auto& model) { return model != nullptr; });
+}
+
+void ModelGroup::Predict(const AbstractExampleSet& examples,
+                         const int num_examples,
+                         std::vector<std::vector<float>>* predictions) const {
+  predictions->resize(engines_.size());
+  for (int model_idx = 0; model_idx < engines_.size(); model_idx++) {
+    if (engines_[model_idx]) {
+      engines_[model_idx]->Predict(examples, num_examples,
+                                   &(*predictions)[model_idx]);
+    } else {
+      (*predictions)[model_idx].assign(num_examples, 0.f);
+    }
+  }
+  if (max_num_tree_ranges_ == 0) {
+    return;
+  }
+
+  // Interleaved schedule: The i-th range of trees of all the models is
+  // evaluated before the (i+1)-th range of trees.
+  std::vector<int> example_idxs(num_examples);
+  std::iota(example_idxs.begin(), example_idxs.end(), 0);
+  std::vector<float> buffer;
+  for (int range_idx = 0; range_idx < max_num_tree_ranges_; range_idx++) {
+    for (int model_idx = 0; model_idx < interleaved_models_.size();
+         model_idx++) {
+      const auto& model = interleaved_models_[model_idx];
+      if (model && range_idx < model->NumTreeRanges()) {
+        model->AddTreeRangeOutputs(examples, example_idxs, range_idx,
+                                   absl::MakeSpan((*predictions)[model_idx]),
+                                   &buffer);
+      }
+    }
+  }
+  for (int model_idx = 0; model_idx < interleaved_models_.size();
+       model_idx++) {
+    if (interleaved_models_[model_idx]) {
+      interleaved_models_[model_idx]->FinalizeOutputs(
+          absl::MakeSpan((*predictions)[model_idx]));
+    }
+  }
+}
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
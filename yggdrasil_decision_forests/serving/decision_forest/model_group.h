@@ -0,0 +1,139 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Inference of a group of decision forest models sharing their input features.
+//
+// A "ModelGroup" evaluates several models (e.g. models trained on different
+// labels, or different versions of a model) on the same examples. The example
+// set contains the union of the input features of the models, and it is filled
+// once for all the models instead of once per model.
+//
+// The models should be trained on the same dataspec, or at least on dataspecs
+// that agree on the input features of the models (same column index, name,
+// type and dictionary). Like "BuildFastEngine", the group compiles the models
+// with the fastest engine they are compatible with, among the engines able to
+// read the example set of the group: If all the models are Gradient Boosted
+// Trees binary classifiers compatible with QuickScorer, the group uses
+// QuickScorer (see "quick_scorer_extended.h"). Otherwise, the group uses the
+// generic flat node engine (see "decision_forest_serving.h"). In both cases,
+// the missing numerical values are represented as NaN.
+//
+// The trees of the single dimension Gradient Boosted Trees models are
+// evaluated range by range, in an interleaved schedule: The first range of
+// trees of all the models is evaluated on all the examples, then the second
+// range of trees, etc. The other models (e.g. Random Forests) are evaluated
+// one after the other.
+//
+// Usage example:
+//   std::vector<const model::AbstractModel*> models = ...;
+//   ASSIGN_OR_RETURN(auto group, ModelGroup::Create(models));
+//   auto examples = group->AllocateExamples(num_examples);
+//   examples->FillMissing(group->features());
+//   // Set the example values.
+//   std::vector<std::vector<float>> predictions;
+//   group->Predict(*examples, num_examples, &predictions);
+//   // "predictions[i]" are the predictions of "models[i]".
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_MODEL_GROUP_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_MODEL_GROUP_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+namespace internal {
+
+// A model of a group whose trees are evaluated range by range, interleaved
+// with the trees of the other models of the group.
+class InterleavedModel {
+ public:
+  virtual ~InterleavedModel() = default;
+
+  virtual std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      int num_examples) const = 0;
+
+  virtual const FeaturesDefinition& features() const = 0;
+
+  virtual int NumTreeRanges() const = 0;
+
+  // Adds the raw outputs (i.e. without initial prediction and activation) of
+  // the "range_idx"-th range of trees to "outputs". "example_idxs" is
+  // [0, num_examples). "buffer" is a working buffer.
+  virtual void AddTreeRangeOutputs(const AbstractExampleSet& examples,
+                                   absl::Span<const int> example_idxs,
+                                   int range_idx, absl::Span<float> outputs,
+                                   std::vector<float>* buffer) const = 0;
+
+  // Converts the raw outputs of all the trees into predictions, in place.
+  virtual void FinalizeOutputs(absl::Span<float> outputs) const = 0;
+};
+
+}  // namespace internal
+
+class ModelGroup {
+ public:
+  // Compiles a group of Gradient Boosted Trees, Random Forest and Isolation
+  // Forest models. The models can be discarded after this call.
+  static absl::StatusOr<std::unique_ptr<ModelGroup>> Create(
+      absl::Span<const model::AbstractModel* const> models);
+
+  // Allocates a set of examples shared by all the models.
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(int num_examples) const;
+
+  // Definition of the input features of the group i.e. the union of the input
+  // features of the models.
+  const FeaturesDefinition& features() const;
+
+  // Computes the predictions of all the models. "(*predictions)[i]" contains
+  // the predictions of the i-th model, in the same format as
+  // "FastEngine::Predict".
+  void Predict(const AbstractExampleSet& examples, int num_examples,
+               std::vector<std::vector<float>>* predictions) const;
+
+  int NumModels() const { return engines_.size(); }
+
+  // Number of prediction dimensions of the "model_idx"-th model.
+  int NumPredictionDimension(int model_idx) const;
+
+  // Number of models evaluated with the interleaved schedule.
+  int NumInterleavedModels() const;
+
+ private:
+  ModelGroup() = default;
+
+  // The "model_idx"-th model is either evaluated by its own engine
+  // "engines_[model_idx]" or with the interleaved schedule
+  // "interleaved_models_[model_idx]". The other one is null.
+  std::vector<std::unique_ptr<FastEngine>> engines_;
+  std::vector<std::unique_ptr<internal::InterleavedModel>> interleaved_models_;
+
+  // Maximum number of tree ranges of the interleaved models.
+  int max_num_tree_ranges_ = 0;
+};
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_MODEL_GROUP_H_
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/model_group.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace {
+
+using test::StatusIs;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+std::unique_ptr<model::AbstractModel> LoadModel(
+    const absl::string_view model_name) {
+  std::unique_ptr<model::AbstractModel> model;
+  EXPECT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), &model));
+  return model;
+}
+
+// Predictions of a model with its own engine.
+std::vector<float> PredictWithEngine(const model::AbstractModel& model,
+                                     const dataset::VerticalDataset& dataset) {
+  auto engine = model.BuildFastEngine().value();
+  auto examples = engine->AllocateExamples(dataset.nrow());
+  EXPECT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, dataset.nrow(), engine->features(), examples.get()));
+  std::vector<float> predictions;
+  engine->Predict(*examples, dataset.nrow(), &predictions);
+  return predictions;
+}
+
+// Checks that the predictions of a group are the same as the predictions of
+// the models with their own engine.
+void CheckGroupPredictions(
+    const std::vector<const model::AbstractModel*>& models,
+    const ModelGroup& group, const absl::string_view dataset_filename) {
+  dataset::VerticalDataset dataset;
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:", file::JoinPath(TestDataDir(), "dataset",
+                                          dataset_filename)),
+      models.front()->data_spec(), &dataset));
+
+  auto examples = group.AllocateExamples(dataset.nrow());
+  ASSERT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, dataset.nrow(), group.features(), examples.get()));
+  std::vector<std::vector<float>> predictions;
+  group.Predict(*examples, dataset.nrow(), &predictions);
+  ASSERT_EQ(predictions.size(), models.size());
+
+  for (int model_idx = 0; model_idx < models.size(); model_idx++) {
+    SCOPED_TRACE(models[model_idx]->name());
+    const auto expected = PredictWithEngine(*models[model_idx], dataset);
+    ASSERT_EQ(predictions[model_idx].size(), expected.size());
+    ASSERT_EQ(expected.size(),
+              dataset.nrow() * group.NumPredictionDimension(model_idx));
+    for (int value_idx = 0; value_idx < expected.size(); value_idx++) {
+      EXPECT_NEAR(predictions[model_idx][value_idx], expected[value_idx],
+                  1e-4f);
+    }
+  }
+}
+
+TEST(ModelGroup, AdultGBTAndRF) {
+  const auto gbt = LoadModel("adult_binary_class_gbdt");
+  const auto rf = LoadModel("adult_binary_class_rf");
+  ASSERT_OK_AND_ASSIGN(const auto group,
+                       ModelGroup::Create({gbt.get(), rf.get()}));
+  EXPECT_EQ(group->NumModels(), 2);
+  EXPECT_EQ(group->NumPredictionDimension(0), 1);
+  EXPECT_EQ(group->NumPredictionDimension(1), 1);
+  // The GBT is interleaved. The RF is evaluated with its own engine.
+  EXPECT_EQ(group->NumInterleavedModels(), 1);
+  CheckGroupPredictions({gbt.get(), rf.get()}, *group, "adult_test.csv");
+}
+
+TEST(ModelGroup, AdultGBTs) {
+  // Two versions of the same model, compiled with QuickScorer.
+  const auto gbt_1 = LoadModel("adult_binary_class_gbdt");
+  const auto gbt_2 = LoadModel("adult_binary_class_gbdt");
+  ASSERT_OK_AND_ASSIGN(const auto group,
+                       ModelGroup::Create({gbt_1.get(), gbt_2.get()}));
+  EXPECT_EQ(group->NumInterleavedModels(), 2);
+  CheckGroupPredictions({gbt_1.get(), gbt_2.get()}, *group, "adult_test.csv");
+}
+
+TEST(ModelGroup, AbaloneGBTAndRF) {
+  const auto gbt = LoadModel("abalone_regression_gbdt");
+  const auto rf = LoadModel("abalone_regression_rf");
+  ASSERT_OK_AND_ASSIGN(const auto group,
+                       ModelGroup::Create({gbt.get(), rf.get()}));
+  EXPECT_EQ(group->NumInterleavedModels(), 1);
+  CheckGroupPredictions({gbt.get(), rf.get()}, *group, "abalone.csv");
+}
+
+TEST(ModelGroup, IncompatibleDataspecs) {
+  const auto adult = LoadModel("adult_binary_class_gbdt");
+  const auto iris = LoadModel("iris_multi_class_rf");
+  EXPECT_THAT(ModelGroup::Create({adult.get(), iris.get()}).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ModelGroup, Empty) {
+  EXPECT_THAT(ModelGroup::Create({}).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
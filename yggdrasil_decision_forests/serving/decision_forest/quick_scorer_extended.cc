@@ -114,6 +114,7 @@ float ActivationIdentity(const float value) { return value; }
 template <typename AbstractModel>
 absl::Status InitializeAccumulator(
     const AbstractModel& src, const internal::QuickScorerExtendedModel& dst,
+    const int num_trees,
     internal::QuickScorerExtendedModel::BuildingAccumulator* accumulator) {
   for (const auto& feature : dst.features().fixed_length_features()) {
     const auto& feature_spec = src.data_spec().columns(feature.spec_idx);
@@ -126,8 +127,7 @@ absl::Status InitializeAccumulator(
             accumulator->categorical_contains_conditions[feature.spec_idx];
         feature_acc.internal_feature_idx = feature.internal_idx;
         feature_acc.items.assign(
-            src.NumTrees() *
-                feature_spec.categorical().number_of_unique_values(),
+            num_trees * feature_spec.categorical().number_of_unique_values(),
             ~internal::QuickScorerExtendedModel::kZeroLeafMask);
       } break;
 
@@ -161,6 +161,48 @@ absl::Status InitializeAccumulator(
   return absl::OkStatus();
 }
 
+// Removes from a dense "contains" condition the trees that do not test the
+// feature, if they are the majority. Otherwise, the condition is left unchanged
+// as looping over all the trees is faster (no indirection).
+//
+// Returns false if no tree tests the feature (e.g. when compiling a range of
+// trees). In this case, the condition should be discarded.
+bool CompactContainsConditions(
+    const int num_trees,
+    internal::QuickScorerExtendedModel::ContainsConditions* condition) {
+  if (num_trees == 0) {
+    return false;
+  }
+  const int num_values = condition->items.size() / num_trees;
+  std::vector<internal::QuickScorerExtendedModel::TreeIdx> tree_idxs;
+  for (int tree_idx = 0; tree_idx < num_trees; tree_idx++) {
+    for (int value = 0; value < num_values; value++) {
+      if (condition->items[tree_idx + value * num_trees] !=
+          ~internal::QuickScorerExtendedModel::kZeroLeafMask) {
+        tree_idxs.push_back(tree_idx);
+        break;
+      }
+    }
+  }
+  if (tree_idxs.empty()) {
+    return false;
+  }
+  if (2 * static_cast<int>(tree_idxs.size()) >= num_trees) {
+    return true;
+  }
+
+  std::vector<LeafMask> items;
+  items.reserve(tree_idxs.size() * num_values);
+  for (int value = 0; value < num_values; value++) {
+    for (const auto tree_idx : tree_idxs) {
+      items.push_back(condition->items[tree_idx + value * num_trees]);
+    }
+  }
+  condition->tree_idxs = std::move(tree_idxs);
+  condition->items = std::move(items);
+  return true;
+}
+
 // Finalize the model. To be run once all the trees have been integrated to the
 // quick scorer representation with the "FillQuickScorer" method.
 absl::Status FinalizeModel(
@@ -185,8 +227,10 @@ absl::Status FinalizeModel(
   // For dense "contains" conditions.
   for (const auto& it_contains_condition :
        accumulator.categorical_contains_conditions) {
-    dst->categorical_contains_conditions.push_back(
-        it_contains_condition.second);
+    auto condition = it_contains_condition.second;
+    if (CompactContainsConditions(dst->num_trees, &condition)) {
+      dst->categorical_contains_conditions.push_back(std::move(condition));
+    }
   }
 
   // For sparse "contains" conditions.
@@ -197,6 +241,8 @@ absl::Status FinalizeModel(
         it_contains_condition.second.internal_feature_idx;
     const auto& src_masks = it_contains_condition.second.masks;
     condition.value_to_mask_range.reserve(src_masks.size());
+    utils::bitmap::AllocateAndZeroBitMap(src_masks.size(),
+                                         &condition.used_values);
     for (const auto& mask : src_masks) {
       condition.value_to_mask_range.emplace_back();
       condition.value_to_mask_range.back().first = condition.mask_buffer.size();
@@ -209,6 +255,11 @@ absl::Status FinalizeModel(
       }
       condition.value_to_mask_range.back().second =
           condition.mask_buffer.size();
+      if (condition.value_to_mask_range.back().first !=
+          condition.value_to_mask_range.back().second) {
+        utils::bitmap::SetValueBit(condition.value_to_mask_range.size() - 1,
+                                   &condition.used_values);
+      }
     }
     dst->categoricalset_contains_conditions.push_back(std::move(condition));
   }
@@ -417,16 +468,19 @@ absl::Status FillQuickScorerNode(
   return absl::OkStatus();
 }
 
-// Adds the content of the tree structures to the quick scorer structure.
+// Adds the content of the trees [begin_tree_idx, end_tree_idx) to the quick
+// scorer structure.
 template <typename AbstractModel>
 absl::Status FillQuickScorer(
-    const AbstractModel& src, internal::QuickScorerExtendedModel* dst,
+    const AbstractModel& src, const int begin_tree_idx, const int end_tree_idx,
+    internal::QuickScorerExtendedModel* dst,
     internal::QuickScorerExtendedModel::BuildingAccumulator* accumulator) {
-  RETURN_IF_ERROR(InitializeAccumulator(src, *dst, accumulator));
+  RETURN_IF_ERROR(InitializeAccumulator(
+      src, *dst, end_tree_idx - begin_tree_idx, accumulator));
 
   dst->initial_prediction = src.initial_predictions()[0];
   dst->output_logits = src.output_logits();
-  dst->num_trees = src.NumTrees();
+  dst->num_trees = end_tree_idx - begin_tree_idx;
   if (dst->num_trees > internal::QuickScorerExtendedModel::kMaxTrees) {
     return absl::InvalidArgumentError(
         absl::Substitute("The model contains trees with more than $0 trees",
@@ -436,8 +490,8 @@ absl::Status FillQuickScorer(
   // Get the maximum number of leafs per trees.
   dst->max_num_leafs_per_tree = 0;
   int num_leafs = 0;
-  for (const auto& src_tree : src.decision_trees()) {
-    const auto num_leafs_in_tree = src_tree->NumLeafs();
+  for (int tree_idx = begin_tree_idx; tree_idx < end_tree_idx; tree_idx++) {
+    const auto num_leafs_in_tree = src.decision_trees()[tree_idx]->NumLeafs();
     num_leafs += num_leafs_in_tree;
     if (num_leafs_in_tree > dst->max_num_leafs_per_tree) {
       dst->max_num_leafs_per_tree = num_leafs_in_tree;
@@ -454,8 +508,8 @@ absl::Status FillQuickScorer(
   dst->leaf_values.assign(dst->max_num_leafs_per_tree * dst->num_trees, 0.f);
 
   for (internal::QuickScorerExtendedModel::TreeIdx tree_idx = 0;
-       tree_idx < src.decision_trees().size(); ++tree_idx) {
-    const auto& src_tree = src.decision_trees()[tree_idx];
+       tree_idx < dst->num_trees; ++tree_idx) {
+    const auto& src_tree = src.decision_trees()[begin_tree_idx + tree_idx];
     int leaf_idx = 0;
     int non_leaf_idx = 0;
     RETURN_IF_ERROR(FillQuickScorerNode(src, tree_idx, src_tree->root(), dst,
@@ -466,6 +520,137 @@ absl::Status FillQuickScorer(
   return absl::OkStatus();
 }
 
+#ifdef __AVX2__
+// The examples are evaluated by groups of four with AVX2 instructions.
+#define YDF_QUICK_SCORER_SIMD
+
+using IsHigherConditions =
+    internal::QuickScorerExtendedModel::IsHigherConditions;
+
+// Applies the "is higher" conditions of a feature on four examples.
+// "begin_example" points to the four contiguous feature values, and
+// "active_leaf_buffer" contains four leaf masks per tree.
+void ApplyIsHigherConditionSimd(const IsHigherConditions& is_higher_condition,
+                                const bool global_imputation_optimization,
+                                const float* begin_example,
+                                LeafMask* active_leaf_buffer) {
+  constexpr int kNumParallelExamples = 4;
+  const auto feature_values = _mm_loadu_ps(begin_example);
+
+  if (!global_imputation_optimization) {
+    // If any feature value is Nan
+    //   Create NaN mask
+    //   Iterate over examples and apply leaf mask * nan mask
+    //   Replace value as - infinity in next loop
+
+    // Test for the existence of at least one missing value.
+    // mask_no_nan_128 is a bitmask of the non-missing values.
+    __m128i mask_no_nan_128 =
+        _mm_castps_si128(_mm_cmpeq_ps(feature_values, feature_values));
+    int has_nan = !_mm_test_all_ones(mask_no_nan_128);
+    if (has_nan) {
+      // At least one of the feature contains a missing value.
+
+      // Nan mask in 256 bits
+      __m256i mask_no_nan_256 = _mm256_cvtepi32_epi64(mask_no_nan_128);
+
+      // Apply all the masks
+      for (const auto& item : is_higher_condition.missing_value_items) {
+        // Update the active node
+        auto* active_si256 = reinterpret_cast<__m256i*>(
+            &active_leaf_buffer[item.tree_idx * kNumParallelExamples]);
+
+        const auto active = _mm256_load_si256(active_si256);
+        // new_active = active & ( mask_split | mask_no_nan )
+        const auto new_active = _mm256_and_si256(
+            active,
+            _mm256_or_si256(_mm256_set1_epi64x(item.leaf_mask),
+                            mask_no_nan_256));
+        _mm256_store_si256(active_si256, new_active);
+      }
+
+      // Missing values are represented as Nan. They will fail at the
+      // first comparison "value >= threshold" in the next loop.
+    }
+  }
+
+  for (const auto& item : is_higher_condition.items) {
+    const auto threshold = _mm_set1_ps(item.threshold);
+
+    const auto comparison =
+        _mm_castps_si128(_mm_cmpge_ps(feature_values, threshold));
+    // Note: "comparison" is either 0x00000000 or 0xFFFFFFFF depending on
+    // the node condition value.
+    if (!_mm_test_all_zeros(comparison, comparison)) {
+      // The mask attached to the condition i.e. the mask to apply on the
+      // active node bitmap iif. the condition is true.
+      const auto mask = _mm256_set1_epi64x(item.leaf_mask);
+      auto* active_si256 = reinterpret_cast<__m256i*>(
+          &active_leaf_buffer[item.tree_idx * kNumParallelExamples]);
+      const auto active = _mm256_load_si256(active_si256);
+
+      // Expand the comparison to 8 bytes.
+      const auto pd_comparison = _mm256_cvtepi32_epi64(comparison);
+      const auto mask_update = _mm256_andnot_si256(mask, pd_comparison);
+      const auto new_active = _mm256_andnot_si256(mask_update, active);
+      // new_active = (mask v not comparison) ^ active
+      // is equivalent to:
+      // new_active = not (not mask ^ comparison) ^ active
+
+      _mm256_store_si256(active_si256, new_active);
+    } else {
+      break;
+    }
+  }
+}
+
+#endif
+
+// Applies a dense "contains" condition on one example. The mask of the tree
+// "tree_idx" is "active_leaf_buffer[tree_idx * stride]".
+void ApplyContainsCondition(
+    const internal::QuickScorerExtendedModel::ContainsConditions& condition,
+    const int num_trees, const int32_t feature_value, const int stride,
+    LeafMask* active_leaf_buffer) {
+  if (condition.tree_idxs.empty()) {
+    DCHECK_LE(num_trees * (feature_value + 1), condition.items.size());
+    const auto* leaf_mask_stream = &condition.items[num_trees * feature_value];
+    for (int tree_idx = 0; tree_idx < num_trees; ++tree_idx) {
+      active_leaf_buffer[tree_idx * stride] &= *(leaf_mask_stream++);
+    }
+  } else {
+    const int num_listed_trees = condition.tree_idxs.size();
+    DCHECK_LE(num_listed_trees * (feature_value + 1), condition.items.size());
+    const auto* leaf_mask_stream =
+        &condition.items[num_listed_trees * feature_value];
+    for (const auto tree_idx : condition.tree_idxs) {
+      active_leaf_buffer[tree_idx * stride] &= *(leaf_mask_stream++);
+    }
+  }
+}
+
+// Applies a categorical-set "contains" condition on one example with the items
+// "items[begin, end)". The mask of the tree "tree_idx" is
+// "active_leaf_buffer[tree_idx * stride]".
+void ApplyCategoricalSetContainsCondition(
+    const internal::QuickScorerExtendedModel::SparseContainsConditions&
+        condition,
+    const int32_t* items, const int begin, const int end, const int stride,
+    LeafMask* active_leaf_buffer) {
+  for (int value_idx = begin; value_idx < end; value_idx++) {
+    const auto value = items[value_idx] + 1;
+    if (!utils::bitmap::GetValueBit(condition.used_values, value)) {
+      continue;
+    }
+    const auto& range_masks = condition.value_to_mask_range[value];
+    for (int mask_idx = range_masks.first; mask_idx < range_masks.second;
+         mask_idx++) {
+      const auto& mask = condition.mask_buffer[mask_idx];
+      active_leaf_buffer[mask.first * stride] &= mask.second;
+    }
+  }
+}
+
 // Tree inference without SIMD i.e. one example at a time.
 // This method is used for the examples outside of the SIMD batch.
 //
@@ -521,13 +706,8 @@ void PredictQuickScorerSequential(
           fixed_length_features[index(contains_condition.internal_feature_idx,
                                       example_idx)]
               .categorical_value;
-      DCHECK_LE(model.num_trees * (feature_value + 1),
-                contains_condition.items.size());
-      const auto* leaf_mask_stream =
-          &contains_condition.items[model.num_trees * feature_value];
-      for (int tree_idx = 0; tree_idx < model.num_trees; ++tree_idx) {
-        active_leaf_buffer[tree_idx] &= *(leaf_mask_stream++);
-      }
+      ApplyContainsCondition(contains_condition, model.num_trees,
+                             feature_value, /*stride=*/1, active_leaf_buffer);
     }
 
     // Sparse contains conditions.
@@ -536,16 +716,10 @@ void PredictQuickScorerSequential(
       const auto& range_values = categorical_set_begins_and_ends
           [contains_condition.internal_feature_idx * major_feature_offset +
            example_idx];
-      for (int value_idx = range_values.begin; value_idx < range_values.end;
-           value_idx++) {
-        const auto value = categorical_item_buffer[value_idx] + 1;
-        const auto& range_masks = contains_condition.value_to_mask_range[value];
-        for (int mask_idx = range_masks.first; mask_idx < range_masks.second;
-             mask_idx++) {
-          const auto& mask = contains_condition.mask_buffer[mask_idx];
-          active_leaf_buffer[mask.first] &= mask.second;
-        }
-      }
+      ApplyCategoricalSetContainsCondition(
+          contains_condition, categorical_item_buffer.data(),
+          range_values.begin, range_values.end, /*stride=*/1,
+          active_leaf_buffer);
     }
 
     // Get the active leaf.
@@ -640,7 +814,7 @@ void PredictQuickScorerMajorFeatureOffset(
 
   int example_idx = 0;
 
-#ifdef __AVX2__
+#ifdef YDF_QUICK_SCORER_SIMD
   if (model.cpu_supports_avx2) {
     auto* sample_reader = fixed_length_features.data();
     auto* prediction_reader = predictions->data();
@@ -657,73 +831,9 @@ void PredictQuickScorerMajorFeatureOffset(
         const float* begin_example =
             &sample_reader[0].numerical_value +
             is_higher_condition.internal_feature_idx * major_feature_offset;
-
-        const auto feature_values = _mm_loadu_ps(begin_example);
-
-        if (!model.global_imputation_optimization) {
-          // If any feature value is Nan
-          //   Create NaN mask
-          //   Iterate over examples and apply leaf mask * nan mask
-          //   Replace value as - infinity in next loop
-
-          // Test for the existence of at least one missing value.
-          // mask_no_nan_128 is a bitmask of the non-missing values.
-          __m128i mask_no_nan_128 =
-              _mm_castps_si128(_mm_cmpeq_ps(feature_values, feature_values));
-          int has_nan = !_mm_test_all_ones(mask_no_nan_128);
-          if (has_nan) {
-            // At least one of the feature contains a missing value.
-
-            // Nan mask in 256 bits
-            __m256i mask_no_nan_256 = _mm256_cvtepi32_epi64(mask_no_nan_128);
-
-            // Apply all the masks
-            for (const auto& item : is_higher_condition.missing_value_items) {
-              // Update the active node
-              auto* active_si256 = reinterpret_cast<__m256i*>(
-                  &active_leaf_buffer[item.tree_idx * kNumParallelExamples]);
-
-              const auto active = _mm256_load_si256(active_si256);
-              // new_active = active & ( mask_split | mask_no_nan )
-              const auto new_active = _mm256_and_si256(
-                  active, _mm256_or_si256(_mm256_set1_epi64x(item.leaf_mask),
-                                          mask_no_nan_256));
-              _mm256_store_si256(active_si256, new_active);
-            }
-
-            // Missing values are represented as Nan. They will fail at the
-            // first comparison "value >= threshold" in the next loop.
-          }
-        }
-
-        for (const auto& item : is_higher_condition.items) {
-          const auto threshold = _mm_set1_ps(item.threshold);
-
-          const auto comparison =
-              _mm_castps_si128(_mm_cmpge_ps(feature_values, threshold));
-          // Note: "comparison" is either 0x00000000 or 0xFFFFFFFF depending on
-          // the node condition value.
-          if (!_mm_test_all_zeros(comparison, comparison)) {
-            // The mask attached to the condition i.e. the mask to apply on the
-            // active node bitmap iif. the condition is true.
-            const auto mask = _mm256_set1_epi64x(item.leaf_mask);
-            auto* active_si256 = reinterpret_cast<__m256i*>(
-                &active_leaf_buffer[item.tree_idx * kNumParallelExamples]);
-            const auto active = _mm256_load_si256(active_si256);
-
-            // Expand the comparison to 8 bytes.
-            const auto pd_comparison = _mm256_cvtepi32_epi64(comparison);
-            const auto mask_update = _mm256_andnot_si256(mask, pd_comparison);
-            const auto new_active = _mm256_andnot_si256(mask_update, active);
-            // new_active = (mask v not comparison) ^ active
-            // is equivalent to:
-            // new_active = not (not mask ^ comparison) ^ active
-
-            _mm256_store_si256(active_si256, new_active);
-          } else {
-            break;
-          }
-        }
+        ApplyIsHigherConditionSimd(is_higher_condition,
+                                   model.global_imputation_optimization,
+                                   begin_example, active_leaf_buffer);
       }
 
       // Dense contains conditions.
@@ -736,12 +846,9 @@ void PredictQuickScorerMajorFeatureOffset(
                                 major_feature_offset +
                             sub_example_idx]
                   .categorical_value;
-          const auto* leaf_mask_stream =
-              &contains_condition.items[model.num_trees * feature_value];
-          for (int tree_idx = 0; tree_idx < model.num_trees; ++tree_idx) {
-            active_leaf_buffer[tree_idx * kNumParallelExamples +
-                               sub_example_idx] &= *(leaf_mask_stream++);
-          }
+          ApplyContainsCondition(contains_condition, model.num_trees,
+                                 feature_value, kNumParallelExamples,
+                                 active_leaf_buffer + sub_example_idx);
         }
       }
 
@@ -753,18 +860,10 @@ void PredictQuickScorerMajorFeatureOffset(
           const auto& range_values = categorical_set_begins_and_ends
               [contains_condition.internal_feature_idx * major_feature_offset +
                sub_example_idx + example_idx];
-          for (int value_idx = range_values.begin; value_idx < range_values.end;
-               value_idx++) {
-            const auto value = categorical_item_buffer[value_idx] + 1;
-            const auto& range_masks =
-                contains_condition.value_to_mask_range[value];
-            for (int mask_idx = range_masks.first;
-                 mask_idx < range_masks.second; mask_idx++) {
-              const auto& mask = contains_condition.mask_buffer[mask_idx];
-              active_leaf_buffer[mask.first * kNumParallelExamples +
-                                 sub_example_idx] &= mask.second;
-            }
-          }
+          ApplyCategoricalSetContainsCondition(
+              contains_condition, categorical_item_buffer.data(),
+              range_values.begin, range_values.end, kNumParallelExamples,
+              active_leaf_buffer + sub_example_idx);
         }
       }
 
@@ -802,7 +901,7 @@ void PredictQuickScorerMajorFeatureOffset(
       example_idx += kNumParallelExamples;
     }
   }
-#endif
+#endif  // YDF_QUICK_SCORER_SIMD
 
   PredictQuickScorerSequential<Model, Activation>(
       model, fixed_length_features, categorical_set_begins_and_ends,
@@ -903,9 +1002,15 @@ void Predict(
   }
 }
 
+// Compiles the trees [begin_tree_idx, end_tree_idx) of "src". If
+// "end_tree_idx" is -1, compiles all the trees starting at "begin_tree_idx".
+// If set, "shared_input_features" are the input features of the compiled model
+// (see "GenericToSpecializedModelTreeRange").
 template <typename AbstractModel, typename CompiledModel>
-absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
-                                           CompiledModel* dst) {
+absl::Status BaseGenericToSpecializedModel(
+    const AbstractModel& src, CompiledModel* dst, const int begin_tree_idx = 0,
+    int end_tree_idx = -1,
+    const std::vector<int>* shared_input_features = nullptr) {
 #ifdef __AVX2__
 #if ABSL_HAVE_BUILTIN(__builtin_cpu_supports)
   dst->cpu_supports_avx2 = __builtin_cpu_supports("avx2");
@@ -940,9 +1045,16 @@ absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
 
   // List the model input features.
   std::vector<int> all_input_features;
-  RETURN_IF_ERROR(GetInputFeatures(src, &all_input_features, nullptr));
+  if (shared_input_features) {
+    all_input_features = *shared_input_features;
+  } else {
+    RETURN_IF_ERROR(GetInputFeatures(src, &all_input_features, nullptr));
+  }
 
+  // A shared example set layout stores missing numerical values as NaN, which
+  // is not compatible with the global imputation optimization.
   dst->global_imputation_optimization =
+      !shared_input_features &&
       src.CheckStructure({/*.global_imputation_is_higher =*/true});
 
   RETURN_IF_ERROR(dst->mutable_features()->Initialize(
@@ -950,7 +1062,15 @@ absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
       /*missing_numerical_is_na=*/!dst->global_imputation_optimization));
 
   // Compile the model.
-  RETURN_IF_ERROR(FillQuickScorer(src, dst, &accumulator));
+  if (end_tree_idx == -1) {
+    end_tree_idx = src.NumTrees();
+  }
+  if (begin_tree_idx < 0 || begin_tree_idx > end_tree_idx ||
+      end_tree_idx > src.NumTrees()) {
+    return absl::InvalidArgumentError("Invalid range of trees");
+  }
+  RETURN_IF_ERROR(
+      FillQuickScorer(src, begin_tree_idx, end_tree_idx, dst, &accumulator));
 
   return absl::OkStatus();
 }
@@ -1005,6 +1125,26 @@ absl::Status GenericToSpecializedModel(
   return BaseGenericToSpecializedModel(src, dst);
 }
 
+template <>
+absl::Status GenericToSpecializedModelTreeRange(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    const int begin_tree_idx, const int end_tree_idx,
+    GradientBoostedTreesBinaryClassificationQuickScorerExtended* dst,
+    const std::vector<int>* shared_input_features) {
+  if ((src.loss() != Loss::BINOMIAL_LOG_LIKELIHOOD &&
+       src.loss() != Loss::BINARY_FOCAL_LOSS) ||
+      src.initial_predictions().size() != 1) {
+    return absl::InvalidArgumentError(
+        "The GBDT is not trained for binary classification with binomial log "
+        "likelihood or binary focal loss.");
+  }
+  RETURN_IF_ERROR(BaseGenericToSpecializedModel(
+      src, dst, begin_tree_idx, end_tree_idx, shared_input_features));
+  dst->initial_prediction = 0.f;
+  dst->output_logits = true;
+  return absl::OkStatus();
+}
+
 template <typename CompiledModel>
 absl::Status CreateEmptyModel(const std::vector<int>& input_features,
                               const DataSpecification& dataspec,
@@ -1083,6 +1223,8 @@ std::string DescribeQuickScorer(const Model& model, const bool detailed) {
             .fixed_length_features()[item.internal_feature_idx]
             .name,
         item.items.size());
+    const int num_listed_trees =
+        item.tree_idxs.empty() ? model.num_trees : item.tree_idxs.size();
     if (detailed) {
       for (int item_idx = 0; item_idx < item.items.size(); ++item_idx) {
         const auto bitmap_representation = ToStringBit(
@@ -1092,8 +1234,10 @@ std::string DescribeQuickScorer(const Model& model, const bool detailed) {
             internal::QuickScorerExtendedModel::kMaxLeafs);
         absl::SubstituteAndAppend(
             &structure, "\t\ttree:$0 value:$1 mask : $2\n",
-            item_idx % model.num_trees, item_idx / model.num_trees,
-            bitmap_representation);
+            item.tree_idxs.empty()
+                ? item_idx % num_listed_trees
+                : item.tree_idxs[item_idx % num_listed_trees],
+            item_idx / num_listed_trees, bitmap_representation);
       }
     }
   }
@@ -91,7 +91,9 @@
 
 #include <stdlib.h>
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
@@ -223,9 +225,16 @@ struct QuickScorerExtendedModel {
     // Internal index of the feature.
     int internal_feature_idx;
 
+    // Trees testing the feature. If empty, all the trees are listed i.e.
+    // "tree_idxs[i] = i". Only set when the feature is tested by a minority of
+    // the trees, so the masks of the other trees are neither stored nor
+    // applied.
+    std::vector<TreeIdx> tree_idxs;
+
     // "Contains" type condition for each feature value.
-    // items[tree_idx + feature_value * num_trees] is the mask to apply on tree
-    // "tree_idx" when the feature value is "feature_value".
+    // items[i + feature_value * n] is the mask to apply on tree "tree_idxs[i]"
+    // (or "i" if "tree_idxs" is empty) when the feature value is
+    // "feature_value", with "n" the number of listed trees.
     std::vector<LeafMask> items;
   };
 
@@ -239,6 +248,14 @@ struct QuickScorerExtendedModel {
     // "[value_to_mask_range[i).first, value_to_mask_range[i].second[".
     std::vector<std::pair<int, int>> value_to_mask_range;
     std::vector<std::pair<TreeIdx, LeafMask>> mask_buffer;
+
+    // Bitmap of the feature values with at least one mask i.e. the model
+    // vocabulary of the feature. Indexed like "value_to_mask_range". A
+    // categorical-set value is only looked up in "value_to_mask_range" if its
+    // bit is set. This bitmap is much smaller than "value_to_mask_range" and
+    // stays in cache for large vocabularies (e.g. text tokens) where most of
+    // the example items are not tested by the model.
+    std::string used_values;
   };
 
   std::vector<IsHigherConditions> is_higher_conditions;
@@ -359,6 +376,24 @@ template <typename AbstractModel, typename CompiledModel>
 absl::Status GenericToSpecializedModel(const AbstractModel& src,
                                        CompiledModel* dst);
 
+// Converts the trees [begin_tree_idx, end_tree_idx) of a generic
+// GradientBoostedTreesModel into a quick scorer compatible model returning the
+// sum of the tree outputs (i.e. without initial prediction or activation).
+//
+// The compiled model consumes all the input features used by "src", and not
+// only the ones used by the selected trees. Therefore, the models compiled
+// from the different tree ranges of "src" share the same example set format.
+//
+// If "shared_input_features" is set, the compiled model consumes these
+// dataspec columns instead, and the missing numerical values are represented
+// as NaN. Models compiled with the same "shared_input_features" on the same
+// dataspec share the same example set format (see "ModelGroup").
+template <typename AbstractModel, typename CompiledModel>
+absl::Status GenericToSpecializedModelTreeRange(
+    const AbstractModel& src, int begin_tree_idx, int end_tree_idx,
+    CompiledModel* dst,
+    const std::vector<int>* shared_input_features = nullptr);
+
 // Creates an empty model that returns a constant value (e.g. 0 for regression)
 // but which consumes (and ignores) the input features specified at
 // construction.
@@ -28,6 +28,7 @@
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/bitmap.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
 #include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
@@ -388,6 +389,10 @@ TEST(QuickScorer, Compilation_Num_Cat) {
   LOG(INFO) << "Model:\n" << model_description;
 
   ASSERT_EQ(quick_scorer_model.features().input_features().size(), 2);
+  // The categorical feature is tested by most of the trees.
+  ASSERT_EQ(quick_scorer_model.categorical_contains_conditions.size(), 1);
+  EXPECT_TRUE(
+      quick_scorer_model.categorical_contains_conditions[0].tree_idxs.empty());
 
   // Examples in FORMAT_FEATURE_MAJOR, see decision_forest.h.
   using V = NumericalOrCategoricalValue;
@@ -413,6 +418,45 @@ TEST(QuickScorer, Compilation_Num_Cat) {
                           1 + 2 + 30 + 400, 1 + 1 + 10 + 300));
 }
 
+TEST(QuickScorer, TreeRangeWithUntestedFeature) {
+  GradientBoostedTreesModel model;
+  dataset::VerticalDataset dataset;
+  BuildToyModelAndToyDataset(model::proto::Task::CLASSIFICATION,
+                             /*use_num_feature=*/true, /*use_cat_feature=*/true,
+                             /*use_discnum_feature=*/false,
+                             /*use_catset_feature=*/false, &model, &dataset);
+  model::gradient_boosted_trees::proto::LossConfiguration loss_config;
+  model.set_loss(Loss::BINOMIAL_LOG_LIKELIHOOD, loss_config);
+
+  // The first tree does not test the categorical feature.
+  GradientBoostedTreesBinaryClassificationQuickScorerExtended
+      quick_scorer_model;
+  ASSERT_OK(GenericToSpecializedModelTreeRange(model, 0, 1,
+                                               &quick_scorer_model));
+  ASSERT_EQ(quick_scorer_model.features().input_features().size(), 2);
+  EXPECT_TRUE(quick_scorer_model.categorical_contains_conditions.empty());
+
+  using Model = GradientBoostedTreesBinaryClassificationQuickScorerExtended;
+  Model::ExampleSet examples(5, quick_scorer_model);
+  examples.FillMissing(quick_scorer_model);
+  const auto num_feature =
+      Model::ExampleSet::GetNumericalFeatureId("num_2", quick_scorer_model)
+          .value();
+  const auto cat_feature =
+      Model::ExampleSet::GetCategoricalFeatureId("cat", quick_scorer_model)
+          .value();
+  const std::vector<float> num_values = {0.5f, 1.0f, 1.5f, 2.5f, 3.5f};
+  for (int example_idx = 0; example_idx < num_values.size(); example_idx++) {
+    examples.SetNumerical(example_idx, num_feature, num_values[example_idx],
+                          quick_scorer_model);
+    examples.SetCategorical(example_idx, cat_feature, example_idx % 3,
+                            quick_scorer_model);
+  }
+  std::vector<float> predictions;
+  Predict(quick_scorer_model, examples, 5, &predictions);
+  EXPECT_THAT(predictions, ElementsAre(4, 3, 3, 2, 1));
+}
+
 TEST(QuickScorer, ExampleSet) {
   GradientBoostedTreesModel model;
   dataset::VerticalDataset dataset;
@@ -432,6 +476,23 @@ TEST(QuickScorer, ExampleSet) {
 
   EXPECT_EQ(quick_scorer_model.features().input_features().size(), 4);
 
+  // Only the masks of the two trees testing the categorical feature are
+  // stored.
+  ASSERT_EQ(quick_scorer_model.categorical_contains_conditions.size(), 1);
+  const auto& cat_condition =
+      quick_scorer_model.categorical_contains_conditions[0];
+  EXPECT_THAT(cat_condition.tree_idxs, ElementsAre(1, 2));
+  EXPECT_EQ(cat_condition.items.size(), 2 * 4);
+
+  // Only the missing value and the values "v2" and "v3" are tested.
+  ASSERT_EQ(quick_scorer_model.categoricalset_contains_conditions.size(), 1);
+  const auto& catset_condition =
+      quick_scorer_model.categoricalset_contains_conditions[0];
+  std::vector<bool> used_values;
+  utils::bitmap::BitmapToVectorBool(catset_condition.used_values, 5,
+                                    &used_values);
+  EXPECT_THAT(used_values, ElementsAre(true, false, false, true, true));
+
   const auto feature_1 =
       GradientBoostedTreesRegressionQuickScorerExtended::ExampleSet::
           GetNumericalFeatureId("num_2", quick_scorer_model)
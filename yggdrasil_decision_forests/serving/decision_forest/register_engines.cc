@@ -38,6 +38,7 @@
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
 #include "yggdrasil_decision_forests/model/isolation_forest/isolation_forest.h"
 #include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/8bits_quantized_features.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"  // IWYU pragma: keep
 #include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
@@ -214,14 +215,16 @@ class GradientBoostedTreesGenericFastEngineFactory : public FastEngineFactory {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::
                     GenericGradientBoostedTreesBinaryClassification<uint32_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
             return engine;
           } else {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::
                     GradientBoostedTreesBinaryClassification,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
             return engine;
           }
@@ -230,7 +233,8 @@ class GradientBoostedTreesGenericFastEngineFactory : public FastEngineFactory {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::
                   GradientBoostedTreesMulticlassClassification,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
           return engine;
         }
@@ -239,13 +243,15 @@ class GradientBoostedTreesGenericFastEngineFactory : public FastEngineFactory {
         if (gbt_model->loss() == gradient_boosted_trees::proto::POISSON) {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::GradientBoostedTreesPoissonRegression,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
           return engine;
         } else {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::GradientBoostedTreesRegression,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
           return engine;
         }
@@ -254,7 +260,8 @@ class GradientBoostedTreesGenericFastEngineFactory : public FastEngineFactory {
       case proto::RANKING: {
         auto engine = std::make_unique<serving::ExampleSetModelWrapper<
             serving::decision_forest::GradientBoostedTreesRanking,
-            serving::decision_forest::Predict>>();
+            serving::decision_forest::Predict,
+            serving::decision_forest::PredictColumnar>>();
         RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
         return engine;
       }
@@ -319,7 +326,8 @@ class GradientBoostedTreesQuickScorerFastEngineFactory
 
   std::vector<std::string> IsBetterThan() const override {
     return {serving::gradient_boosted_trees::kGeneric,
-            serving::gradient_boosted_trees::kOptPred};
+            serving::gradient_boosted_trees::kOptPred,
+            serving::gradient_boosted_trees::kQuantizedLookup};
   }
 
   absl::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
@@ -440,7 +448,8 @@ class GradientBoostedTreesOptPredFastEngineFactory : public FastEngineFactory {
   }
 
   std::vector<std::string> IsBetterThan() const override {
-    return {serving::gradient_boosted_trees::kGeneric};
+    return {serving::gradient_boosted_trees::kGeneric,
+            serving::gradient_boosted_trees::kQuantizedLookup};
   }
 
   absl::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
@@ -540,14 +549,16 @@ class RandomForestGenericFastEngineFactory : public model::FastEngineFactory {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::GenericRandomForestBinaryClassification<
                   uint32_t>,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
           return engine;
         } else {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::GenericRandomForestBinaryClassification<
                   uint16_t>,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
           return engine;
         }
@@ -557,14 +568,16 @@ class RandomForestGenericFastEngineFactory : public model::FastEngineFactory {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::
                   GenericRandomForestMulticlassClassification<uint32_t>,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
           return engine;
         } else {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::
                   GenericRandomForestMulticlassClassification<uint16_t>,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
           return engine;
         }
@@ -574,14 +587,16 @@ class RandomForestGenericFastEngineFactory : public model::FastEngineFactory {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::GenericRandomForestRegression<
                     uint32_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
             return engine;
           } else {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::GenericRandomForestRegression<
                     uint16_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
             return engine;
           }
@@ -591,14 +606,16 @@ class RandomForestGenericFastEngineFactory : public model::FastEngineFactory {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::GenericRandomForestCategoricalUplift<
                     uint32_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
             return engine;
           } else {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::GenericRandomForestCategoricalUplift<
                     uint16_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
             return engine;
           }
@@ -608,14 +625,16 @@ class RandomForestGenericFastEngineFactory : public model::FastEngineFactory {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::GenericRandomForestNumericalUplift<
                     uint32_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
             return engine;
           } else {
             auto engine = std::make_unique<serving::ExampleSetModelWrapper<
                 serving::decision_forest::GenericRandomForestNumericalUplift<
                     uint16_t>,
-                serving::decision_forest::Predict>>();
+                serving::decision_forest::Predict,
+                serving::decision_forest::PredictColumnar>>();
             RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
             return engine;
           }
@@ -669,13 +688,15 @@ class IsolationForestGenericFastEngineFactory
         if (need_uint32_node_index) {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::GenericIsolationForest<uint32_t>,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*if_model));
           return engine;
         } else {
           auto engine = std::make_unique<serving::ExampleSetModelWrapper<
               serving::decision_forest::GenericIsolationForest<uint16_t>,
-              serving::decision_forest::Predict>>();
+              serving::decision_forest::Predict,
+              serving::decision_forest::PredictColumnar>>();
           RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*if_model));
           return engine;
         }
@@ -734,7 +755,8 @@ class RandomForestOptPredFastEngineFactory : public model::FastEngineFactory {
   }
 
   std::vector<std::string> IsBetterThan() const override {
-    return {serving::random_forest::kGeneric};
+    return {serving::random_forest::kGeneric,
+            serving::random_forest::kQuantizedLookup};
   }
 
   absl::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
@@ -777,5 +799,90 @@ class RandomForestOptPredFastEngineFactory : public model::FastEngineFactory {
 REGISTER_FastEngineFactory(RandomForestOptPredFastEngineFactory,
                            serving::random_forest::kOptPred);
 
+// The quantized lookup engines are not selected by default over the "OptPred"
+// and "QuickScorer" engines: Their relative speed depends on the number of
+// features and on the size of the trees. Use "AutotuneFastEngine" to select
+// them when they are faster.
+class GradientBoostedTreesQuantizedLookupFastEngineFactory
+    : public model::FastEngineFactory {
+ public:
+  using SourceModel = gradient_boosted_trees::GradientBoostedTreesModel;
+
+  std::string name() const override {
+    return serving::gradient_boosted_trees::kQuantizedLookup;
+  }
+
+  bool IsCompatible(const AbstractModel* const model) const override {
+    auto* gbt_model = dynamic_cast<const SourceModel*>(model);
+    if (gbt_model == nullptr) {
+      return false;
+    }
+    return serving::decision_forest::quantized_8bits::CheckCompatibility(
+               *gbt_model)
+        .ok();
+  }
+
+  std::vector<std::string> IsBetterThan() const override {
+    return {serving::gradient_boosted_trees::kGeneric};
+  }
+
+  absl::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
+      const AbstractModel* const model) const override {
+    auto* gbt_model = dynamic_cast<const SourceModel*>(model);
+    if (!gbt_model) {
+      return absl::InvalidArgumentError("The model is not a GBDT.");
+    }
+    auto engine = std::make_unique<serving::ExampleSetModelWrapper<
+        serving::decision_forest::quantized_8bits::QuantizedLookupModel,
+        serving::decision_forest::quantized_8bits::Predict>>();
+    RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
+    return engine;
+  }
+};
+
+REGISTER_FastEngineFactory(
+    GradientBoostedTreesQuantizedLookupFastEngineFactory,
+    serving::gradient_boosted_trees::kQuantizedLookup);
+
+class RandomForestQuantizedLookupFastEngineFactory
+    : public model::FastEngineFactory {
+ public:
+  using SourceModel = random_forest::RandomForestModel;
+
+  std::string name() const override {
+    return serving::random_forest::kQuantizedLookup;
+  }
+
+  bool IsCompatible(const AbstractModel* const model) const override {
+    auto* rf_model = dynamic_cast<const SourceModel*>(model);
+    if (rf_model == nullptr) {
+      return false;
+    }
+    return serving::decision_forest::quantized_8bits::CheckCompatibility(
+               *rf_model)
+        .ok();
+  }
+
+  std::vector<std::string> IsBetterThan() const override {
+    return {serving::random_forest::kGeneric};
+  }
+
+  absl::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
+      const AbstractModel* const model) const override {
+    auto* rf_model = dynamic_cast<const SourceModel*>(model);
+    if (!rf_model) {
+      return absl::InvalidArgumentError("The model is not a RF.");
+    }
+    auto engine = std::make_unique<serving::ExampleSetModelWrapper<
+        serving::decision_forest::quantized_8bits::QuantizedLookupModel,
+        serving::decision_forest::quantized_8bits::Predict>>();
+    RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
+    return engine;
+  }
+};
+
+REGISTER_FastEngineFactory(RandomForestQuantizedLookupFastEngineFactory,
+                           serving::random_forest::kQuantizedLookup);
+
 }  // namespace model
 }  // namespace yggdrasil_decision_forests
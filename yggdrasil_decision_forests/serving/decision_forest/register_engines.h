@@ -27,11 +27,13 @@ constexpr char kGeneric[] = "GradientBoostedTreesGeneric";
 constexpr char kQuickScorerExtended[] =
     "GradientBoostedTreesQuickScorerExtended";
 constexpr char kOptPred[] = "GradientBoostedTreesOptPred";
+constexpr char kQuantizedLookup[] = "GradientBoostedTreesQuantizedLookup";
 }  // namespace gradient_boosted_trees
 
 namespace random_forest {
 constexpr char kGeneric[] = "RandomForestGeneric";
 constexpr char kOptPred[] = "RandomForestOptPred";
+constexpr char kQuantizedLookup[] = "RandomForestQuantizedLookup";
 }  // namespace random_forest
 
 namespace isolation_forest {
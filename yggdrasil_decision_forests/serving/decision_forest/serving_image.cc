@@ -0,0 +1,744 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/serving_image.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/model/isolation_forest/isolation_forest.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/serving_image.pb.h"
+#include "yggdrasil_decision_forests/serving/example_set_model_wrapper.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+namespace {
+
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using model::isolation_forest::IsolationForestModel;
+using model::random_forest::RandomForestModel;
+using proto::ServingImageHeader;
+
+// Size of the fixed part of the image i.e. magic, byte order mark, version and
+// header size.
+constexpr int kPreambleSize = kServingImageMagicSize + 3 * sizeof(uint32_t);
+
+// Written in the native byte order of the writer. Read as
+// "kByteSwappedOrderMark" on a platform with a different endianness.
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kByteSwappedOrderMark = 0x04030201;
+
+size_t AlignUp(const size_t value) {
+  return (value + kServingImageAlignment - 1) / kServingImageAlignment *
+         kServingImageAlignment;
+}
+
+// Detects the task specific fields of the specialized models.
+template <typename T, typename = void>
+struct HasNumClasses : std::false_type {};
+template <typename T>
+struct HasNumClasses<T, std::void_t<decltype(T::num_classes)>>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct HasInitialPredictions : std::false_type {};
+template <typename T>
+struct HasInitialPredictions<T, std::void_t<decltype(T::initial_predictions)>>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct HasOutputLogits : std::false_type {};
+template <typename T>
+struct HasOutputLogits<T, std::void_t<decltype(T::output_logits)>>
+    : std::true_type {};
+
+template <typename T, typename = void>
+struct HasDenominator : std::false_type {};
+template <typename T>
+struct HasDenominator<T, std::void_t<decltype(T::denominator)>>
+    : std::true_type {};
+
+// Accumulates the buffers of the image.
+class BufferWriter {
+ public:
+  template <typename Container>
+  void Add(const Container& values, ServingImageHeader::Buffer* buffer) {
+    using T = typename Container::value_type;
+    static_assert(std::is_trivially_copyable_v<T>);
+    Align();
+    buffer->set_offset(data_.size());
+    buffer->set_num_items(values.size());
+    data_.append(reinterpret_cast<const char*>(values.data()),
+                 values.size() * sizeof(T));
+  }
+
+  // Stores a vector of bool as a bitmap.
+  void AddBitmap(const std::vector<bool>& values,
+                 ServingImageHeader::Buffer* buffer) {
+    std::string bitmap((values.size() + 7) / 8, 0);
+    for (size_t i = 0; i < values.size(); i++) {
+      if (values[i]) {
+        bitmap[i / 8] |= 1 << (i % 8);
+      }
+    }
+    Align();
+    buffer->set_offset(data_.size());
+    buffer->set_num_items(values.size());
+    data_.append(bitmap);
+  }
+
+  const std::string& data() const { return data_; }
+
+ private:
+  void Align() { data_.resize(AlignUp(data_.size()), 0); }
+
+  std::string data_;
+};
+
+// Serializes a specialized model into a serving image.
+template <typename Model>
+absl::StatusOr<std::string> SerializeModel(
+    const Model& model, const ServingImageHeader::ModelType model_type) {
+  using Node = typename Model::NodeType;
+  static_assert(std::is_trivially_copyable_v<Node>);
+
+  ServingImageHeader header;
+  header.set_model_type(model_type);
+  header.set_node_offset_bytes(sizeof(typename Node::NodeOffset));
+  header.set_node_bytes(sizeof(Node));
+  *header.mutable_data_spec() = model.features().data_spec();
+  for (const int feature : model.features().column_input_features()) {
+    header.add_input_features(feature);
+  }
+  *header.mutable_metadata() = model.metadata;
+  header.set_global_imputation_optimization(
+      model.global_imputation_optimization);
+  header.set_uses_na_conditions(model.uses_na_conditions);
+  header.set_num_trees(model.root_offsets.size());
+
+  if constexpr (HasNumClasses<Model>::value) {
+    header.set_num_classes(model.num_classes);
+  }
+  if constexpr (HasInitialPredictions<Model>::value) {
+    if constexpr (std::is_arithmetic_v<decltype(Model::initial_predictions)>) {
+      header.add_initial_predictions(model.initial_predictions);
+    } else {
+      header.mutable_initial_predictions()->Add(
+          model.initial_predictions.begin(), model.initial_predictions.end());
+    }
+  }
+  if constexpr (HasOutputLogits<Model>::value) {
+    header.set_output_logits(model.output_logits);
+  }
+  if constexpr (HasDenominator<Model>::value) {
+    header.set_denominator(model.denominator);
+  }
+
+  BufferWriter buffers;
+  buffers.Add(model.nodes, header.mutable_nodes());
+  buffers.Add(model.root_offsets, header.mutable_root_offsets());
+  buffers.Add(model.label_buffer, header.mutable_label_buffer());
+  buffers.AddBitmap(model.categorical_mask_buffer,
+                    header.mutable_categorical_mask_buffer());
+  buffers.Add(model.oblique_weights, header.mutable_oblique_weights());
+  buffers.Add(model.oblique_internal_feature_idxs,
+              header.mutable_oblique_internal_feature_idxs());
+  buffers.Add(model.numerical_vector_sequence_anchor_weights,
+              header.mutable_numerical_vector_sequence_anchor_weights());
+
+  const std::string serialized_header = header.SerializeAsString();
+  if (serialized_header.size() > std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError("The serving image header is too large");
+  }
+  const uint32_t byte_order_mark = kByteOrderMark;
+  const uint32_t version = kServingImageVersion;
+  const uint32_t header_size = serialized_header.size();
+
+  std::string image;
+  image.reserve(AlignUp(kPreambleSize + header_size) + buffers.data().size());
+  image.append(kServingImageMagic, kServingImageMagicSize);
+  image.append(reinterpret_cast<const char*>(&byte_order_mark),
+               sizeof(byte_order_mark));
+  image.append(reinterpret_cast<const char*>(&version), sizeof(version));
+  image.append(reinterpret_cast<const char*>(&header_size),
+               sizeof(header_size));
+  image.append(serialized_header);
+  image.resize(AlignUp(image.size()), 0);
+  image.append(buffers.data());
+  return image;
+}
+
+// Converts a model into a specialized model and serializes it.
+template <typename Model, typename SourceModel>
+absl::StatusOr<std::string> SpecializeAndSerialize(
+    const SourceModel& src, const ServingImageHeader::ModelType model_type) {
+  Model model;
+  RETURN_IF_ERROR(GenericToSpecializedModel(src, &model));
+  return SerializeModel(model, model_type);
+}
+
+// Maximum number of nodes in any tree.
+int64_t MaxNumberOfNodesPerTree(
+    const std::vector<std::unique_ptr<model::decision_tree::DecisionTree>>&
+        trees) {
+  int64_t max_num_nodes = 0;
+  for (const auto& tree : trees) {
+    max_num_nodes = std::max(max_num_nodes, tree->NumNodes());
+  }
+  return max_num_nodes;
+}
+
+// Follows the choice of specialized model of the generic engines in
+// "register_engines.cc".
+absl::StatusOr<std::string> CreateGradientBoostedTreesServingImage(
+    const GradientBoostedTreesModel& src) {
+  const bool need_uint32_node_index =
+      MaxNumberOfNodesPerTree(src.decision_trees()) >=
+      std::numeric_limits<uint16_t>::max();
+
+  switch (src.task()) {
+    case model::proto::CLASSIFICATION:
+      if (src.label_col_spec().categorical().number_of_unique_values() == 3) {
+        if (need_uint32_node_index) {
+          return SpecializeAndSerialize<
+              GenericGradientBoostedTreesBinaryClassification<uint32_t>>(
+              src, ServingImageHeader::GBT_BINARY_CLASSIFICATION);
+        } else {
+          return SpecializeAndSerialize<
+              GradientBoostedTreesBinaryClassification>(
+              src, ServingImageHeader::GBT_BINARY_CLASSIFICATION);
+        }
+      } else {
+        return SpecializeAndSerialize<
+            GradientBoostedTreesMulticlassClassification>(
+            src, ServingImageHeader::GBT_MULTICLASS_CLASSIFICATION);
+      }
+    case model::proto::REGRESSION:
+      if (src.loss() == model::gradient_boosted_trees::proto::POISSON) {
+        return SpecializeAndSerialize<GradientBoostedTreesPoissonRegression>(
+            src, ServingImageHeader::GBT_POISSON_REGRESSION);
+      } else {
+        return SpecializeAndSerialize<GradientBoostedTreesRegression>(
+            src, ServingImageHeader::GBT_REGRESSION);
+      }
+    case model::proto::RANKING:
+      return SpecializeAndSerialize<GradientBoostedTreesRanking>(
+          src, ServingImageHeader::GBT_RANKING);
+    default:
+      return absl::InvalidArgumentError(
+          "Non supported GBDT model for serving images");
+  }
+}
+
+template <typename NodeOffset>
+absl::StatusOr<std::string> CreateRandomForestServingImage(
+    const RandomForestModel& src) {
+  switch (src.task()) {
+    case model::proto::CLASSIFICATION:
+      if (src.label_col_spec().categorical().number_of_unique_values() == 3) {
+        return SpecializeAndSerialize<
+            GenericRandomForestBinaryClassification<NodeOffset>>(
+            src, ServingImageHeader::RF_BINARY_CLASSIFICATION);
+      } else {
+        return SpecializeAndSerialize<
+            GenericRandomForestMulticlassClassification<NodeOffset>>(
+            src, ServingImageHeader::RF_MULTICLASS_CLASSIFICATION);
+      }
+    case model::proto::REGRESSION:
+      return SpecializeAndSerialize<GenericRandomForestRegression<NodeOffset>>(
+          src, ServingImageHeader::RF_REGRESSION);
+    case model::proto::CATEGORICAL_UPLIFT:
+      return SpecializeAndSerialize<
+          GenericRandomForestCategoricalUplift<NodeOffset>>(
+          src, ServingImageHeader::RF_CATEGORICAL_UPLIFT);
+    case model::proto::NUMERICAL_UPLIFT:
+      return SpecializeAndSerialize<
+          GenericRandomForestNumericalUplift<NodeOffset>>(
+          src, ServingImageHeader::RF_NUMERICAL_UPLIFT);
+    default:
+      return absl::InvalidArgumentError(
+          "Non supported Random Forest model for serving images");
+  }
+}
+
+// Engine reading a specialized model from a serving image.
+template <typename Model,
+          void (*PredictCall)(const Model&, const typename Model::ExampleSet&,
+                              int, std::vector<float>*)>
+class ServingImageEngine
+    : public ExampleSetModelWrapper<Model, PredictCall, PredictColumnar> {
+ public:
+  explicit ServingImageEngine(std::unique_ptr<utils::MemoryMappedFile> image)
+      : image_(std::move(image)) {}
+
+ private:
+  // The serving image. Borrowed by the buffers of the model.
+  std::unique_ptr<utils::MemoryMappedFile> image_;
+};
+
+// Points "dst" to a buffer of the image.
+template <typename T>
+absl::Status BorrowBuffer(const absl::string_view buffers,
+                          const ServingImageHeader::Buffer& buffer,
+                          utils::BorrowableVector<T>* dst) {
+  if (buffer.offset() < 0 || buffer.num_items() < 0 ||
+      buffer.offset() > buffers.size() ||
+      buffer.num_items() > (buffers.size() - buffer.offset()) / sizeof(T)) {
+    return absl::InvalidArgumentError("Corrupted serving image");
+  }
+  const char* begin = buffers.data() + buffer.offset();
+  if (reinterpret_cast<uintptr_t>(begin) % alignof(T) != 0) {
+    return absl::InvalidArgumentError("Unaligned serving image buffer");
+  }
+  dst->borrow(absl::MakeConstSpan(reinterpret_cast<const T*>(begin),
+                                  buffer.num_items()));
+  return absl::OkStatus();
+}
+
+absl::Status ReadBitmap(const absl::string_view buffers,
+                        const ServingImageHeader::Buffer& buffer,
+                        std::vector<bool>* dst) {
+  const int64_t num_bytes = (buffer.num_items() + 7) / 8;
+  if (buffer.offset() < 0 || buffer.num_items() < 0 ||
+      buffer.offset() > buffers.size() ||
+      num_bytes > buffers.size() - buffer.offset()) {
+    return absl::InvalidArgumentError("Corrupted serving image");
+  }
+  const char* bitmap = buffers.data() + buffer.offset();
+  dst->resize(buffer.num_items());
+  for (int64_t i = 0; i < buffer.num_items(); i++) {
+    (*dst)[i] = (bitmap[i / 8] >> (i % 8)) & 1;
+  }
+  return absl::OkStatus();
+}
+
+// Number of distinct values of the categorical feature "feature_idx" (internal
+// index) of "features".
+absl::StatusOr<int64_t> NumCategoricalValues(
+    const std::vector<FeatureDef>& features, const int feature_idx,
+    const dataset::proto::DataSpecification& data_spec) {
+  for (const auto& feature : features) {
+    if (feature.internal_idx == feature_idx) {
+      return data_spec.columns(feature.spec_idx)
+          .categorical()
+          .number_of_unique_values();
+    }
+  }
+  return absl::InvalidArgumentError("Corrupted serving image");
+}
+
+// Checks that the children, features and buffer ranges of the nodes are in
+// bounds. The inference engine does not check them.
+template <typename Model>
+absl::Status ValidateNodes(const Model& model,
+                           const ServingImageHeader::ModelType model_type) {
+  using Node = typename Model::NodeType;
+  using Type = typename Node::Type;
+  const auto& features = model.features();
+  const int64_t num_fixed_length_features =
+      features.fixed_length_features().size();
+  const int64_t num_categorical_set_features =
+      features.categorical_set_features().size();
+  const int64_t num_vector_sequence_features =
+      features.numerical_vector_sequence_features().size();
+  const auto corrupted = [](const int64_t node_idx) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Corrupted serving image: Invalid node #", node_idx));
+  };
+
+  // Models whose leaves point to "num_classes" values in "label_buffer".
+  int64_t num_leaf_values = 0;
+  if constexpr (HasNumClasses<Model>::value) {
+    if (model.num_classes <= 0) {
+      return absl::InvalidArgumentError("Corrupted serving image");
+    }
+    if (model_type == ServingImageHeader::RF_MULTICLASS_CLASSIFICATION ||
+        model_type == ServingImageHeader::RF_CATEGORICAL_UPLIFT) {
+      num_leaf_values = model.num_classes;
+    }
+  }
+
+  const int64_t num_nodes = model.nodes.size();
+  for (int64_t node_idx = 0; node_idx < num_nodes; node_idx++) {
+    const Node& node = model.nodes[node_idx];
+    if (node.right_idx == 0) {
+      // Leaf. Note: The type of single-output leaves is not set.
+      if (num_leaf_values > 0 && node.label_buffer_offset + num_leaf_values >
+                                     model.label_buffer.size()) {
+        return corrupted(node_idx);
+      }
+      continue;
+    }
+
+    // The negative and positive children follow the node.
+    if (node_idx + node.right_idx >= num_nodes) {
+      return corrupted(node_idx);
+    }
+    bool valid_feature = false;
+    switch (node.type) {
+      case Type::kLeaf:
+        break;
+      case Type::kNumericalIsHigherMissingIsFalse:
+      case Type::kNumericalIsHigherMissingIsTrue:
+      case Type::kNumericalIsLowerMissingIsFalse:
+      case Type::kNumericalIsLowerMissingIsTrue:
+      case Type::kCategoricalContainsMask:
+      case Type::kNumericalAndCategoricalIsNa:
+        valid_feature = node.feature_idx >= 0 &&
+                        node.feature_idx < num_fixed_length_features;
+        break;
+      case Type::kCategoricalContainsBufferOffset:
+      case Type::kCategoricalSetContainsBufferOffset: {
+        const bool is_set =
+            node.type == Type::kCategoricalSetContainsBufferOffset;
+        if (node.feature_idx < 0 ||
+            node.feature_idx >= (is_set ? num_categorical_set_features
+                                        : num_fixed_length_features)) {
+          break;
+        }
+        ASSIGN_OR_RETURN(
+            const int64_t num_values,
+            NumCategoricalValues(is_set ? features.categorical_set_features()
+                                        : features.fixed_length_features(),
+                                 node.feature_idx, features.data_spec()));
+        valid_feature = node.categorical_contains_buffer_offset + num_values <=
+                        model.categorical_mask_buffer.size();
+      } break;
+      case Type::kCategoricalSetIsNa:
+        valid_feature = node.feature_idx >= 0 &&
+                        node.feature_idx < num_categorical_set_features;
+        break;
+      case Type::kNumericalObliqueProjectionIsHigher: {
+        const int64_t num_projections = node.num_oblique_projections;
+        const int64_t offset = node.oblique_projection_offset;
+        // The weights are followed by the threshold.
+        if (num_projections < 0 ||
+            offset + num_projections >= model.oblique_weights.size() ||
+            offset + num_projections >
+                model.oblique_internal_feature_idxs.size()) {
+          break;
+        }
+        valid_feature = true;
+        for (int64_t i = offset; i < offset + num_projections; i++) {
+          const auto feature_idx = model.oblique_internal_feature_idxs[i];
+          if (feature_idx < 0 || feature_idx >= num_fixed_length_features) {
+            valid_feature = false;
+          }
+        }
+      } break;
+      case Type::kNumericalVectorSequenceCloserThan:
+      case Type::kNumericalVectorSequenceProjectedMoreThan: {
+        if (node.feature_idx < 0 ||
+            node.feature_idx >= num_vector_sequence_features) {
+          break;
+        }
+        const int64_t vector_length =
+            features.numerical_vector_sequence_features()[node.feature_idx]
+                .vector_length;
+        // The anchor is followed by the threshold.
+        valid_feature = node.numerical_vector_sequence_offset + vector_length <
+                        model.numerical_vector_sequence_anchor_weights.size();
+      } break;
+    }
+    if (!valid_feature) {
+      return corrupted(node_idx);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Creates an engine whose model borrows the buffers of the image.
+template <typename Model>
+absl::StatusOr<std::unique_ptr<FastEngine>> CreateEngine(
+    const ServingImageHeader& header, const absl::string_view buffers,
+    std::unique_ptr<utils::MemoryMappedFile> image) {
+  using Node = typename Model::NodeType;
+  if (header.node_bytes() != sizeof(Node)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The serving image was created with nodes of ", header.node_bytes(),
+        " bytes while this binary uses nodes of ", sizeof(Node),
+        " bytes. Re-create the serving image with this binary."));
+  }
+
+  auto engine =
+      std::make_unique<ServingImageEngine<Model, Predict>>(std::move(image));
+  Model* model = engine->mutable_model();
+
+  std::vector<int> input_features(header.input_features().begin(),
+                                  header.input_features().end());
+  RETURN_IF_ERROR(model->mutable_features()->Initialize(
+      input_features, header.data_spec(),
+      /*missing_numerical_is_na=*/!header.global_imputation_optimization()));
+  model->metadata = header.metadata();
+  model->global_imputation_optimization =
+      header.global_imputation_optimization();
+  model->uses_na_conditions = header.uses_na_conditions();
+
+  if constexpr (HasNumClasses<Model>::value) {
+    model->num_classes = header.num_classes();
+  }
+  if constexpr (HasInitialPredictions<Model>::value) {
+    if constexpr (std::is_arithmetic_v<decltype(Model::initial_predictions)>) {
+      if (header.initial_predictions_size() != 1) {
+        return absl::InvalidArgumentError("Corrupted serving image");
+      }
+      model->initial_predictions = header.initial_predictions(0);
+    } else {
+      model->initial_predictions.assign(header.initial_predictions().begin(),
+                                        header.initial_predictions().end());
+    }
+  }
+  if constexpr (HasOutputLogits<Model>::value) {
+    model->output_logits = header.output_logits();
+  }
+  if constexpr (HasDenominator<Model>::value) {
+    model->denominator = header.denominator();
+  }
+
+  RETURN_IF_ERROR(BorrowBuffer(buffers, header.nodes(), &model->nodes));
+  RETURN_IF_ERROR(
+      BorrowBuffer(buffers, header.root_offsets(), &model->root_offsets));
+  RETURN_IF_ERROR(
+      BorrowBuffer(buffers, header.label_buffer(), &model->label_buffer));
+  RETURN_IF_ERROR(ReadBitmap(buffers, header.categorical_mask_buffer(),
+                             &model->categorical_mask_buffer));
+  RETURN_IF_ERROR(
+      BorrowBuffer(buffers, header.oblique_weights(), &model->oblique_weights));
+  RETURN_IF_ERROR(BorrowBuffer(buffers, header.oblique_internal_feature_idxs(),
+                               &model->oblique_internal_feature_idxs));
+  RETURN_IF_ERROR(
+      BorrowBuffer(buffers, header.numerical_vector_sequence_anchor_weights(),
+                   &model->numerical_vector_sequence_anchor_weights));
+
+  // Check that the root offsets, the output dimensions and the nodes are
+  // valid.
+  if (!header.has_num_trees() ||
+      model->root_offsets.size() != header.num_trees()) {
+    return absl::InvalidArgumentError(
+        "Corrupted serving image: The number of root offsets does not match "
+        "the number of trees");
+  }
+  if constexpr (HasInitialPredictions<Model>::value &&
+                HasNumClasses<Model>::value) {
+    if constexpr (!std::is_arithmetic_v<
+                      decltype(Model::initial_predictions)>) {
+      // Multi-class Gradient Boosted Trees: One initial prediction per class,
+      // and the tree "i" contributes to the class "i % num_classes".
+      if (model->num_classes <= 0 ||
+          model->initial_predictions.size() != model->num_classes ||
+          model->root_offsets.size() % model->num_classes != 0) {
+        return absl::InvalidArgumentError(
+            "Corrupted serving image: The number of initial predictions or "
+            "trees does not match the number of classes");
+      }
+    }
+  }
+  for (const int32_t root_offset : model->root_offsets) {
+    if (root_offset < 0 || root_offset >= model->nodes.size()) {
+      return absl::InvalidArgumentError("Corrupted serving image");
+    }
+  }
+  RETURN_IF_ERROR(ValidateNodes(*model, header.model_type()));
+  return engine;
+}
+
+// Creates an engine with 16 or 32 bits node offsets.
+template <template <typename> class Model>
+absl::StatusOr<std::unique_ptr<FastEngine>> CreateEngineWithNodeOffset(
+    const ServingImageHeader& header, const absl::string_view buffers,
+    std::unique_ptr<utils::MemoryMappedFile> image) {
+  switch (header.node_offset_bytes()) {
+    case sizeof(uint16_t):
+      return CreateEngine<Model<uint16_t>>(header, buffers, std::move(image));
+    case sizeof(uint32_t):
+      return CreateEngine<Model<uint32_t>>(header, buffers, std::move(image));
+    default:
+      return absl::InvalidArgumentError("Non supported node offset");
+  }
+}
+
+// Same as "CreateEngineWithNodeOffset" for models only available with 16 bits
+// node offsets.
+template <typename Model>
+absl::StatusOr<std::unique_ptr<FastEngine>> CreateEngineWith16BitsNodeOffset(
+    const ServingImageHeader& header, const absl::string_view buffers,
+    std::unique_ptr<utils::MemoryMappedFile> image) {
+  if (header.node_offset_bytes() != sizeof(uint16_t)) {
+    return absl::InvalidArgumentError("Non supported node offset");
+  }
+  return CreateEngine<Model>(header, buffers, std::move(image));
+}
+
+}  // namespace
+
+absl::StatusOr<std::string> CreateServingImage(
+    const model::AbstractModel& model) {
+  if (const auto* gbt_model =
+          dynamic_cast<const GradientBoostedTreesModel*>(&model);
+      gbt_model) {
+    return CreateGradientBoostedTreesServingImage(*gbt_model);
+  }
+
+  if (const auto* rf_model = dynamic_cast<const RandomForestModel*>(&model);
+      rf_model) {
+    if (MaxNumberOfNodesPerTree(rf_model->decision_trees()) >=
+        std::numeric_limits<uint16_t>::max()) {
+      return CreateRandomForestServingImage<uint32_t>(*rf_model);
+    } else {
+      return CreateRandomForestServingImage<uint16_t>(*rf_model);
+    }
+  }
+
+  if (const auto* if_model = dynamic_cast<const IsolationForestModel*>(&model);
+      if_model) {
+    if (MaxNumberOfNodesPerTree(if_model->decision_trees()) >=
+        std::numeric_limits<uint16_t>::max()) {
+      return SpecializeAndSerialize<GenericIsolationForest<uint32_t>>(
+          *if_model, ServingImageHeader::ISOLATION_FOREST);
+    } else {
+      return SpecializeAndSerialize<GenericIsolationForest<uint16_t>>(
+          *if_model, ServingImageHeader::ISOLATION_FOREST);
+    }
+  }
+
+  return absl::InvalidArgumentError(
+      "Serving images are only available for Gradient Boosted Trees, Random "
+      "Forest and Isolation Forest models");
+}
+
+absl::Status SaveServingImage(const model::AbstractModel& model,
+                              const absl::string_view path) {
+  ASSIGN_OR_RETURN(const std::string image, CreateServingImage(model));
+  return file::SetContent(path, image);
+}
+
+absl::StatusOr<std::unique_ptr<FastEngine>> LoadServingImage(
+    const absl::string_view path) {
+  ASSIGN_OR_RETURN(auto image, utils::MemoryMappedFile::Open(path));
+  const absl::string_view data = image->data();
+
+  if (data.size() < kPreambleSize ||
+      data.substr(0, kServingImageMagicSize) !=
+          absl::string_view(kServingImageMagic, kServingImageMagicSize)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("\"", path, "\" is not a serving image"));
+  }
+  uint32_t byte_order_mark;
+  uint32_t version;
+  uint32_t header_size;
+  const char* preamble = data.data() + kServingImageMagicSize;
+  std::memcpy(&byte_order_mark, preamble, sizeof(byte_order_mark));
+  std::memcpy(&version, preamble + sizeof(byte_order_mark), sizeof(version));
+  std::memcpy(&header_size,
+              preamble + sizeof(byte_order_mark) + sizeof(version),
+              sizeof(header_size));
+  if (byte_order_mark == kByteSwappedOrderMark) {
+    return absl::InvalidArgumentError(
+        "The serving image was created on a platform with a different "
+        "endianness. Re-create the serving image on this platform.");
+  }
+  if (byte_order_mark != kByteOrderMark) {
+    return absl::InvalidArgumentError("Corrupted serving image");
+  }
+  if (version != kServingImageVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Non supported serving image version ", version,
+                     ". This binary supports version ", kServingImageVersion));
+  }
+  if (header_size > data.size() - kPreambleSize) {
+    return absl::InvalidArgumentError("Corrupted serving image");
+  }
+
+  ServingImageHeader header;
+  if (!header.ParseFromArray(data.data() + kPreambleSize, header_size)) {
+    return absl::InvalidArgumentError("Cannot parse the serving image header");
+  }
+  const size_t buffers_begin =
+      std::min(AlignUp(kPreambleSize + header_size), data.size());
+  const absl::string_view buffers = data.substr(buffers_begin);
+
+  switch (header.model_type()) {
+    case ServingImageHeader::GBT_BINARY_CLASSIFICATION:
+      return CreateEngineWithNodeOffset<
+          GenericGradientBoostedTreesBinaryClassification>(header, buffers,
+                                                           std::move(image));
+    case ServingImageHeader::GBT_MULTICLASS_CLASSIFICATION:
+      return CreateEngineWith16BitsNodeOffset<
+          GradientBoostedTreesMulticlassClassification>(header, buffers,
+                                                        std::move(image));
+    case ServingImageHeader::GBT_REGRESSION:
+      return CreateEngineWith16BitsNodeOffset<GradientBoostedTreesRegression>(
+          header, buffers, std::move(image));
+    case ServingImageHeader::GBT_POISSON_REGRESSION:
+      return CreateEngineWith16BitsNodeOffset<
+          GradientBoostedTreesPoissonRegression>(header, buffers,
+                                                 std::move(image));
+    case ServingImageHeader::GBT_RANKING:
+      return CreateEngineWith16BitsNodeOffset<GradientBoostedTreesRanking>(
+          header, buffers, std::move(image));
+    case ServingImageHeader::RF_BINARY_CLASSIFICATION:
+      return CreateEngineWithNodeOffset<
+          GenericRandomForestBinaryClassification>(header, buffers,
+                                                   std::move(image));
+    case ServingImageHeader::RF_MULTICLASS_CLASSIFICATION:
+      return CreateEngineWithNodeOffset<
+          GenericRandomForestMulticlassClassification>(header, buffers,
+                                                       std::move(image));
+    case ServingImageHeader::RF_REGRESSION:
+      return CreateEngineWithNodeOffset<GenericRandomForestRegression>(
+          header, buffers, std::move(image));
+    case ServingImageHeader::RF_CATEGORICAL_UPLIFT:
+      return CreateEngineWithNodeOffset<GenericRandomForestCategoricalUplift>(
+          header, buffers, std::move(image));
+    case ServingImageHeader::RF_NUMERICAL_UPLIFT:
+      return CreateEngineWithNodeOffset<GenericRandomForestNumericalUplift>(
+          header, buffers, std::move(image));
+    case ServingImageHeader::ISOLATION_FOREST:
+      return CreateEngineWithNodeOffset<GenericIsolationForest>(
+          header, buffers, std::move(image));
+    default:
+      return absl::InvalidArgumentError(
+          "Non supported model type in serving image");
+  }
+}
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
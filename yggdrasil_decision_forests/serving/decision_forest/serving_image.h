@@ -0,0 +1,101 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Serving images.
+//
+// A serving image is a binary file containing the in-memory layout of a
+// specialized decision forest engine (i.e. the "generic" engines based on
+// "GenericNode"): The flat node array, the root offsets, the leaf and
+// condition buffers, and the definition of the input features.
+//
+// Creating a fast engine from a model ("BuildFastEngine") requires parsing the
+// model trees and converting them into flat nodes. Instead, loading a serving
+// image only parses a small header: The image is memory-mapped and the engine
+// reads the nodes and buffers in place. Multiple processes serving the same
+// image share the same physical memory pages.
+//
+// File layout:
+//   kServingImageMagic (8 bytes)
+//   Byte order mark (uint32)
+//   Format version (uint32)
+//   Size of the header (uint32)
+//   Header (proto::ServingImageHeader)
+//   Buffers. The buffer region and each buffer are aligned on
+//     "kServingImageAlignment" bytes.
+//
+// The fixed-size fields and the buffers are stored in the native byte order.
+// Serving images are not portable across platforms with different endianness
+// (detected with the byte order mark) or different node memory layout
+// (detected with the node size). Such images are rejected at loading time, as
+// well as images whose nodes reference out-of-bounds nodes, features or
+// buffer values, and images whose number of trees or initial predictions do
+// not match the model.
+//
+// Usage example:
+//
+//   // Offline, with the "export_serving_image" CLI or:
+//   RETURN_IF_ERROR(SaveServingImage(*model, "/tmp/model.ydfimg"));
+//
+//   // Serving:
+//   ASSIGN_OR_RETURN(auto engine, LoadServingImage("/tmp/model.ydfimg"));
+//   const auto examples = engine->AllocateExamples(5);
+//   ...
+//   engine->Predict(*examples, 5, &predictions);
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_SERVING_IMAGE_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_SERVING_IMAGE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+// First bytes of a serving image.
+constexpr char kServingImageMagic[] = "YDFSRVIM";
+constexpr int kServingImageMagicSize = 8;
+
+// Version of the serving image format.
+constexpr uint32_t kServingImageVersion = 1;
+
+// Alignment, in bytes, of the buffers in the image.
+constexpr int kServingImageAlignment = 64;
+
+// Creates the serving image of a model.
+absl::StatusOr<std::string> CreateServingImage(
+    const model::AbstractModel& model);
+
+// Creates the serving image of a model and saves it to "path".
+absl::Status SaveServingImage(const model::AbstractModel& model,
+                              absl::string_view path);
+
+// Loads a serving image. The image file is memory-mapped if possible, and
+// remains mapped until the engine is destroyed.
+absl::StatusOr<std::unique_ptr<FastEngine>> LoadServingImage(
+    absl::string_view path);
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_SERVING_IMAGE_H_
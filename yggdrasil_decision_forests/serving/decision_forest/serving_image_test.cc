@@ -0,0 +1,285 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/serving_image.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/serving_image.pb.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/test_utils.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace {
+
+using test::StatusIs;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+// Saves "model_name" as a serving image, loads it back, and checks the
+// predictions on "dataset_filename" against the generic model inference.
+void CheckServingImage(const absl::string_view model_name,
+                       const absl::string_view dataset_filename) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), &model));
+
+  dataset::VerticalDataset dataset;
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", dataset_filename)),
+      model->data_spec(), &dataset));
+
+  const std::string image_path = file::JoinPath(
+      test::TmpDirectory(), absl::StrCat(model_name, ".ydfimg"));
+  ASSERT_OK(SaveServingImage(*model, image_path));
+  ASSERT_OK_AND_ASSIGN(const auto engine, LoadServingImage(image_path));
+  utils::ExpectEqualPredictions(dataset, *model, *engine);
+}
+
+TEST(ServingImage, AdultBinaryClassGBT) {
+  CheckServingImage("adult_binary_class_gbdt", "adult_test.csv");
+}
+
+TEST(ServingImage, IrisMultiClassGBT) {
+  CheckServingImage("iris_multi_class_gbdt", "iris.csv");
+}
+
+TEST(ServingImage, AbaloneRegressionGBT) {
+  CheckServingImage("abalone_regression_gbdt", "abalone.csv");
+}
+
+TEST(ServingImage, AdultBinaryClassRF) {
+  CheckServingImage("adult_binary_class_rf", "adult_test.csv");
+}
+
+TEST(ServingImage, AdultBinaryClassObliqueRF) {
+  CheckServingImage("adult_binary_class_oblique_rf", "adult_test.csv");
+}
+
+TEST(ServingImage, IrisMultiClassRF) {
+  CheckServingImage("iris_multi_class_rf", "iris.csv");
+}
+
+TEST(ServingImage, AbaloneRegressionRF) {
+  CheckServingImage("abalone_regression_rf", "abalone.csv");
+}
+
+TEST(ServingImage, GaussiansAnomalyIF) {
+  CheckServingImage("gaussians_anomaly_if", "gaussians_test.csv");
+}
+
+TEST(ServingImage, NotAServingImage) {
+  const std::string path =
+      file::JoinPath(test::TmpDirectory(), "not_a_serving_image");
+  ASSERT_OK(file::SetContent(path, "hello world"));
+  EXPECT_THAT(LoadServingImage(path).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ServingImage, TruncatedServingImage) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "adult_binary_class_gbdt"),
+      &model));
+  ASSERT_OK_AND_ASSIGN(std::string image, CreateServingImage(*model));
+  image.resize(image.size() / 2);
+  const std::string path = file::JoinPath(test::TmpDirectory(), "truncated");
+  ASSERT_OK(file::SetContent(path, image));
+  EXPECT_THAT(LoadServingImage(path).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Creates the serving image of a test model.
+std::string CreateTestServingImage(const absl::string_view model_name) {
+  std::unique_ptr<model::AbstractModel> model;
+  CHECK_OK(model::LoadModel(file::JoinPath(TestDataDir(), "model", model_name),
+                            &model));
+  auto image = CreateServingImage(*model);
+  CHECK_OK(image.status());
+  return std::move(image).value();
+}
+
+absl::Status LoadServingImageContent(const absl::string_view image) {
+  const std::string path =
+      file::JoinPath(test::TmpDirectory(), "modified_serving_image");
+  RETURN_IF_ERROR(file::SetContent(path, image));
+  return LoadServingImage(path).status();
+}
+
+// Offset of the header size in a serving image.
+constexpr size_t kHeaderSizeOffset =
+    kServingImageMagicSize + 2 * sizeof(uint32_t);
+
+// Parses the header of a serving image.
+proto::ServingImageHeader ParseHeader(const absl::string_view image) {
+  uint32_t header_size;
+  std::memcpy(&header_size, image.data() + kHeaderSizeOffset,
+              sizeof(header_size));
+  proto::ServingImageHeader header;
+  CHECK(header.ParseFromArray(
+      image.data() + kHeaderSizeOffset + sizeof(header_size), header_size));
+  return header;
+}
+
+// Returns a copy of "image" with "header" as header.
+std::string ReplaceHeader(const absl::string_view image,
+                          const proto::ServingImageHeader& header) {
+  const auto align_up = [](const size_t offset) {
+    return (offset + kServingImageAlignment - 1) / kServingImageAlignment *
+           kServingImageAlignment;
+  };
+  uint32_t header_size;
+  std::memcpy(&header_size, image.data() + kHeaderSizeOffset,
+              sizeof(header_size));
+  const size_t buffers_offset =
+      align_up(kHeaderSizeOffset + sizeof(header_size) + header_size);
+
+  const std::string serialized_header = header.SerializeAsString();
+  const uint32_t new_header_size = serialized_header.size();
+  std::string new_image(image.substr(0, kHeaderSizeOffset));
+  new_image.append(reinterpret_cast<const char*>(&new_header_size),
+                   sizeof(new_header_size));
+  new_image.append(serialized_header);
+  new_image.resize(align_up(new_image.size()), 0);
+  new_image.append(image.data() + buffers_offset,
+                   image.size() - buffers_offset);
+  return new_image;
+}
+
+TEST(ServingImage, OtherEndianness) {
+  std::string image = CreateTestServingImage("adult_binary_class_gbdt");
+  // Reverses the byte order mark.
+  std::reverse(image.begin() + kServingImageMagicSize,
+               image.begin() + kServingImageMagicSize + sizeof(uint32_t));
+  EXPECT_THAT(LoadServingImageContent(image),
+              StatusIs(absl::StatusCode::kInvalidArgument, "endianness"));
+}
+
+TEST(ServingImage, CorruptedNode) {
+  const std::string image = CreateTestServingImage("adult_binary_class_gbdt");
+  ASSERT_OK(LoadServingImageContent(image));
+
+  // Locates the nodes in the image.
+  uint32_t header_size;
+  const size_t header_size_offset =
+      kServingImageMagicSize + 2 * sizeof(uint32_t);
+  std::memcpy(&header_size, image.data() + header_size_offset,
+              sizeof(header_size));
+  const size_t header_offset = header_size_offset + sizeof(header_size);
+  proto::ServingImageHeader header;
+  ASSERT_TRUE(
+      header.ParseFromArray(image.data() + header_offset, header_size));
+  ASSERT_EQ(header.node_offset_bytes(), sizeof(uint16_t));
+  using Node = GenericNode<uint16_t>;
+  ASSERT_EQ(header.node_bytes(), sizeof(Node));
+  ASSERT_LE(header.nodes().num_items(), std::numeric_limits<uint16_t>::max());
+  const size_t buffers_offset =
+      (header_offset + header_size + kServingImageAlignment - 1) /
+      kServingImageAlignment * kServingImageAlignment;
+  const size_t root_offset = buffers_offset + header.nodes().offset();
+
+  // The root of the first tree is a condition.
+  Node root;
+  std::memcpy(&root, image.data() + root_offset, sizeof(Node));
+  ASSERT_NE(root.right_idx, 0);
+
+  const auto load_with_root = [&](const Node& modified_root) {
+    std::string modified_image = image;
+    std::memcpy(modified_image.data() + root_offset, &modified_root,
+                sizeof(Node));
+    return LoadServingImageContent(modified_image);
+  };
+
+  Node bad_child = root;
+  bad_child.right_idx = header.nodes().num_items();
+  EXPECT_THAT(load_with_root(bad_child),
+              StatusIs(absl::StatusCode::kInvalidArgument, "Invalid node"));
+
+  Node bad_feature = root;
+  bad_feature.feature_idx = header.input_features_size();
+  EXPECT_THAT(load_with_root(bad_feature),
+              StatusIs(absl::StatusCode::kInvalidArgument, "Invalid node"));
+
+  Node bad_type = root;
+  bad_type.type = static_cast<Node::Type>(200);
+  EXPECT_THAT(load_with_root(bad_type),
+              StatusIs(absl::StatusCode::kInvalidArgument, "Invalid node"));
+}
+
+TEST(ServingImage, CorruptedHeader) {
+  const std::string image = CreateTestServingImage("iris_multi_class_gbdt");
+  const proto::ServingImageHeader header = ParseHeader(image);
+  ASSERT_EQ(header.model_type(),
+            proto::ServingImageHeader::GBT_MULTICLASS_CLASSIFICATION);
+  ASSERT_EQ(header.num_classes(), 3);
+  ASSERT_OK(LoadServingImageContent(ReplaceHeader(image, header)));
+
+  proto::ServingImageHeader missing_num_trees = header;
+  missing_num_trees.clear_num_trees();
+  EXPECT_THAT(
+      LoadServingImageContent(ReplaceHeader(image, missing_num_trees)),
+      StatusIs(absl::StatusCode::kInvalidArgument, "number of root offsets"));
+
+  proto::ServingImageHeader extra_root_offset = header;
+  extra_root_offset.mutable_root_offsets()->set_num_items(
+      header.root_offsets().num_items() + 1);
+  EXPECT_THAT(
+      LoadServingImageContent(ReplaceHeader(image, extra_root_offset)),
+      StatusIs(absl::StatusCode::kInvalidArgument, "number of root offsets"));
+
+  proto::ServingImageHeader missing_initial_prediction = header;
+  missing_initial_prediction.mutable_initial_predictions()->RemoveLast();
+  EXPECT_THAT(
+      LoadServingImageContent(ReplaceHeader(image, missing_initial_prediction)),
+      StatusIs(absl::StatusCode::kInvalidArgument, "initial predictions"));
+
+  proto::ServingImageHeader extra_class = header;
+  extra_class.set_num_classes(header.num_classes() + 1);
+  EXPECT_THAT(LoadServingImageContent(ReplaceHeader(image, extra_class)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "initial predictions"));
+}
+
+}  // namespace
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,767 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/tree_shap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest_serving.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+namespace {
+
+using model::decision_tree::DecisionTree;
+using model::decision_tree::NodeWithChildren;
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using model::random_forest::RandomForestModel;
+using DecisionTrees = std::vector<std::unique_ptr<DecisionTree>>;
+
+// Unique path of the path dependent algorithm, stored as a structure of
+// arrays. The path of the recursion level "d" is stored after the path of the
+// level "d-1" (see "PathDependentScratch").
+struct UniquePath {
+  int* columns;
+  double* zero_fractions;
+  double* one_fractions;
+  double* weights;
+
+  UniquePath Next(const int offset) const {
+    return {columns + offset, zero_fractions + offset, one_fractions + offset,
+            weights + offset};
+  }
+};
+
+// Buffers of the path dependent algorithm for a tree of depth "max_depth".
+class PathDependentScratch {
+ public:
+  explicit PathDependentScratch(const int max_depth) {
+    const int size = (max_depth + 2) * (max_depth + 3) / 2;
+    columns_.resize(size);
+    zero_fractions_.resize(size);
+    one_fractions_.resize(size);
+    weights_.resize(size);
+  }
+
+  UniquePath path() {
+    return {columns_.data(), zero_fractions_.data(), one_fractions_.data(),
+            weights_.data()};
+  }
+
+ private:
+  std::vector<int> columns_;
+  std::vector<double> zero_fractions_;
+  std::vector<double> one_fractions_;
+  std::vector<double> weights_;
+};
+
+// Extends the unique path "path" of length "unique_depth" with a new feature.
+void ExtendPath(const UniquePath& path, const int unique_depth,
+                const double zero_fraction, const double one_fraction,
+                const int column) {
+  path.columns[unique_depth] = column;
+  path.zero_fractions[unique_depth] = zero_fraction;
+  path.one_fractions[unique_depth] = one_fraction;
+  path.weights[unique_depth] = unique_depth == 0 ? 1. : 0.;
+  const double norm = 1. / (unique_depth + 1);
+  for (int i = unique_depth - 1; i >= 0; i--) {
+    path.weights[i + 1] += one_fraction * path.weights[i] * (i + 1) * norm;
+    path.weights[i] =
+        zero_fraction * path.weights[i] * (unique_depth - i) * norm;
+  }
+}
+
+// Removes the element "path_idx" from the unique path "path" of length
+// "unique_depth + 1". Undoes "ExtendPath".
+void UnwindPath(const UniquePath& path, const int unique_depth,
+                const int path_idx) {
+  const double one_fraction = path.one_fractions[path_idx];
+  const double zero_fraction = path.zero_fractions[path_idx];
+  double next_one_portion = path.weights[unique_depth];
+  for (int i = unique_depth - 1; i >= 0; i--) {
+    if (one_fraction != 0.) {
+      const double weight = path.weights[i];
+      path.weights[i] =
+          next_one_portion * (unique_depth + 1) / ((i + 1) * one_fraction);
+      next_one_portion = weight - path.weights[i] * zero_fraction *
+                                      (unique_depth - i) / (unique_depth + 1);
+    } else {
+      path.weights[i] = path.weights[i] * (unique_depth + 1) /
+                        (zero_fraction * (unique_depth - i));
+    }
+  }
+  for (int i = path_idx; i < unique_depth; i++) {
+    path.columns[i] = path.columns[i + 1];
+    path.zero_fractions[i] = path.zero_fractions[i + 1];
+    path.one_fractions[i] = path.one_fractions[i + 1];
+  }
+}
+
+// Sum of the weights of the unique path "path" if the element "path_idx" was
+// unwound. Does not modify the path.
+double UnwoundPathSum(const UniquePath& path, const int unique_depth,
+                      const int path_idx) {
+  const double one_fraction = path.one_fractions[path_idx];
+  const double zero_fraction = path.zero_fractions[path_idx];
+  double next_one_portion = path.weights[unique_depth];
+  double total = 0.;
+  for (int i = unique_depth - 1; i >= 0; i--) {
+    if (one_fraction != 0.) {
+      const double weight =
+          next_one_portion * (unique_depth + 1) / ((i + 1) * one_fraction);
+      total += weight;
+      next_one_portion = path.weights[i] - weight * zero_fraction *
+                                               (unique_depth - i) /
+                                               (unique_depth + 1);
+    } else if (zero_fraction != 0.) {
+      total += path.weights[i] * (unique_depth + 1) /
+               (zero_fraction * (unique_depth - i));
+    }
+  }
+  return total;
+}
+
+template <typename SrcModel>
+bool NeedUint32NodeIndex(const SrcModel& model) {
+  for (const auto& tree : model.decision_trees()) {
+    if (tree->NumNodes() >= std::numeric_limits<uint16_t>::max()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Fraction of the training examples of the non-leaf node "node" that reached
+// its positive child.
+absl::StatusOr<double> PositiveFraction(const NodeWithChildren& node) {
+  const auto& condition = node.node().condition();
+  double num_examples;
+  double num_pos_examples;
+  if (condition.has_num_training_examples_with_weight() &&
+      condition.has_num_pos_training_examples_with_weight()) {
+    num_examples = condition.num_training_examples_with_weight();
+    num_pos_examples = condition.num_pos_training_examples_with_weight();
+  } else if (condition.has_num_training_examples_without_weight() &&
+             condition.has_num_pos_training_examples_without_weight()) {
+    num_examples = condition.num_training_examples_without_weight();
+    num_pos_examples = condition.num_pos_training_examples_without_weight();
+  } else {
+    return absl::FailedPreconditionError(
+        "TreeSHAP requires the number of training examples in each node. This "
+        "information is missing in the model (e.g. the model was pruned or "
+        "imported).");
+  }
+  if (num_examples <= 0) {
+    return 0.5;
+  }
+  return std::clamp(num_pos_examples / num_examples, 0., 1.);
+}
+
+// Computes the column (i.e. index in "input_features") of the condition of
+// each node, and the fraction of training examples going to its child at
+// offset "right_idx" (i.e. its positive child, unless the condition is
+// inverted). The nodes are listed in the order of the generic flat node models
+// (see "FlatNodeLayout").
+absl::Status IndexNodes(const NodeWithChildren& root, const size_t offset_limit,
+                        const dataset::proto::DataSpecification& data_spec,
+                        const absl::flat_hash_map<int, int>& spec_to_column,
+                        std::vector<int>* node_columns,
+                        std::vector<float>* node_pos_fractions) {
+  const auto can_invert = [&data_spec](const NodeWithChildren& node) {
+    return CanInvertGenericNodeCondition(data_spec, node);
+  };
+  for (const FlatNode& flat_node :
+       FlatNodeLayout(root, offset_limit, can_invert)) {
+    const NodeWithChildren* node = flat_node.node;
+    if (node->IsLeaf()) {
+      node_columns->push_back(-1);
+      node_pos_fractions->push_back(0.f);
+      continue;
+    }
+    const auto& condition = node->node().condition();
+    if (condition.condition().has_oblique_condition()) {
+      return absl::UnimplementedError(
+          "TreeSHAP does not support oblique conditions");
+    }
+    const auto it = spec_to_column.find(condition.attribute());
+    if (it == spec_to_column.end()) {
+      return absl::InternalError(absl::StrCat(
+          "The condition attribute ", condition.attribute(),
+          " is not an input feature"));
+    }
+    ASSIGN_OR_RETURN(const double pos_fraction, PositiveFraction(*node));
+    node_columns->push_back(it->second);
+    node_pos_fractions->push_back(flat_node.inverted ? 1. - pos_fraction
+                                                     : pos_fraction);
+  }
+  return absl::OkStatus();
+}
+
+template <typename NodeOffsetRep>
+class TreeShapImpl : public TreeShap {
+ public:
+  using Model = ExampleSetModel<NodeOffsetRep>;
+  using Node = typename Model::NodeType;
+  using ExampleSet = typename Model::ExampleSet;
+
+  // Column state of the interventional algorithm.
+  enum ColumnState : uint8_t {
+    // The column is not tested on the current path, or the example and the
+    // reference go in the same direction.
+    kUnset,
+    // The current path follows the example.
+    kExample,
+    // The current path follows the reference.
+    kReference,
+  };
+
+  static absl::StatusOr<std::unique_ptr<TreeShap>> Create(
+      Model model, const std::vector<int>& input_features,
+      const DecisionTrees& trees, const float initial_prediction,
+      const TreeShapOptions& options,
+      const dataset::VerticalDataset* background) {
+    std::unique_ptr<TreeShapImpl> tree_shap(new TreeShapImpl(std::move(model)));
+    tree_shap->input_features_ = input_features;
+    std::sort(tree_shap->input_features_.begin(),
+              tree_shap->input_features_.end());
+    tree_shap->algorithm_ = options.algorithm;
+    RETURN_IF_ERROR(tree_shap->IndexTrees(trees));
+
+    switch (options.algorithm) {
+      case TreeShapOptions::Algorithm::kPathDependent:
+        tree_shap->expected_value_ =
+            initial_prediction + tree_shap->PathDependentExpectedValue();
+        break;
+      case TreeShapOptions::Algorithm::kInterventional:
+        if (background == nullptr || background->nrow() == 0) {
+          return absl::InvalidArgumentError(
+              "The interventional TreeSHAP requires a non-empty background "
+              "dataset");
+        }
+        if (options.max_background_examples <= 0) {
+          return absl::InvalidArgumentError(
+              "\"max_background_examples\" should be strictly positive");
+        }
+        RETURN_IF_ERROR(tree_shap->SetBackground(
+            *background, options.max_background_examples));
+        tree_shap->InitializeCoalitionWeights();
+        tree_shap->expected_value_ =
+            initial_prediction + tree_shap->InterventionalExpectedValue();
+        break;
+    }
+    return tree_shap;
+  }
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return std::make_unique<ExampleSet>(num_examples, model_);
+  }
+
+  absl::Status Shap(const AbstractExampleSet& examples, const int num_examples,
+                    absl::Span<float> shap_values) const override {
+    const int num_columns = input_features_.size();
+    if (shap_values.size() != static_cast<size_t>(num_examples) * num_columns) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "\"shap_values\" should contain ", num_examples * num_columns,
+          " values. Instead, it contains ", shap_values.size(), " values"));
+    }
+    const auto* casted_examples = dynamic_cast<const ExampleSet*>(&examples);
+    if (casted_examples == nullptr) {
+      return absl::InvalidArgumentError(
+          "The examples were not allocated by this TreeShap");
+    }
+    if (casted_examples->NumberOfExamples() < num_examples) {
+      return absl::InvalidArgumentError("Not enough examples");
+    }
+
+    return ParallelForExamples(
+        parallel_options_, num_examples,
+        [&](const int64_t begin, const int64_t end) -> absl::Status {
+          std::vector<double> phi(num_columns);
+          if (algorithm_ == TreeShapOptions::Algorithm::kPathDependent) {
+            PathDependentScratch scratch(max_depth_);
+            for (int64_t example_idx = begin; example_idx < end;
+                 example_idx++) {
+              std::fill(phi.begin(), phi.end(), 0.);
+              PathDependentShap(*casted_examples, example_idx, &scratch,
+                                absl::MakeSpan(phi));
+              std::copy(phi.begin(), phi.end(),
+                        shap_values.begin() + example_idx * num_columns);
+            }
+          } else {
+            InterventionalScratch scratch(num_columns);
+            for (int64_t example_idx = begin; example_idx < end;
+                 example_idx++) {
+              std::fill(phi.begin(), phi.end(), 0.);
+              InterventionalShap(*casted_examples, example_idx, &scratch,
+                                 absl::MakeSpan(phi));
+              for (int column = 0; column < num_columns; column++) {
+                shap_values[example_idx * num_columns + column] =
+                    phi[column] / num_background_;
+              }
+            }
+          }
+          return absl::OkStatus();
+        });
+  }
+
+  const FeaturesDefinition& features() const override {
+    return model_.features();
+  }
+
+ private:
+  // Buffers of the interventional algorithm.
+  struct InterventionalScratch {
+    explicit InterventionalScratch(const int num_columns)
+        : column_states(num_columns, kUnset) {}
+
+    std::vector<ColumnState> column_states;
+    // Columns in the "kExample" and "kReference" states.
+    std::vector<int> example_columns;
+    std::vector<int> reference_columns;
+  };
+
+  explicit TreeShapImpl(Model model) : model_(std::move(model)) {}
+
+  absl::Status IndexTrees(const DecisionTrees& trees) {
+    absl::flat_hash_map<int, int> spec_to_column;
+    for (int column = 0; column < input_features_.size(); column++) {
+      spec_to_column[input_features_[column]] = column;
+    }
+    node_columns_.reserve(model_.nodes.size());
+    node_pos_fractions_.reserve(model_.nodes.size());
+    // TreeSHAP only supports single output models.
+    for (const int tree_idx :
+         FlatTreeOrder(trees, /*num_trees_per_iter=*/1)) {
+      RETURN_IF_ERROR(IndexNodes(
+          trees[tree_idx]->root(), std::numeric_limits<NodeOffsetRep>::max(),
+          model_.features().data_spec(), spec_to_column, &node_columns_,
+          &node_pos_fractions_));
+    }
+    if (node_columns_.size() != model_.nodes.size() ||
+        model_.root_offsets.size() != trees.size()) {
+      return absl::InternalError("Unexpected flat node layout");
+    }
+    max_depth_ = 0;
+    for (const auto& tree : trees) {
+      max_depth_ = std::max(max_depth_, tree->MaximumDepth());
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status SetBackground(const dataset::VerticalDataset& background,
+                             const int max_background_examples) {
+    dataset::VerticalDataset sampled_background;
+    const dataset::VerticalDataset* selected_background = &background;
+    if (background.nrow() > max_background_examples) {
+      // Uniform sub-sampling.
+      std::vector<dataset::VerticalDataset::row_t> idxs(
+          max_background_examples);
+      for (int idx = 0; idx < max_background_examples; idx++) {
+        idxs[idx] = static_cast<int64_t>(idx) * background.nrow() /
+                    max_background_examples;
+      }
+      ASSIGN_OR_RETURN(sampled_background, background.Extract(idxs));
+      selected_background = &sampled_background;
+    }
+    num_background_ = selected_background->nrow();
+    background_ = std::make_unique<ExampleSet>(num_background_, model_);
+    return CopyVerticalDatasetToAbstractExampleSet(
+        *selected_background, 0, num_background_, model_.features(),
+        background_.get());
+  }
+
+  // Computes the Shapley weights of the interventional algorithm.
+  void InitializeCoalitionWeights() {
+    const int n = max_depth_ + 1;
+    // log(k!) for k in [0, 2n].
+    std::vector<double> log_factorials(2 * n + 1, 0.);
+    for (int k = 1; k < log_factorials.size(); k++) {
+      log_factorials[k] = log_factorials[k - 1] + std::log(k);
+    }
+    coalition_weights_.assign(n * n, 0.);
+    for (int a = 0; a < n; a++) {
+      for (int b = 0; b < n; b++) {
+        coalition_weights_[a * n + b] = std::exp(
+            log_factorials[a] + log_factorials[b] - log_factorials[a + b + 1]);
+      }
+    }
+  }
+
+
+  // Expected value of a sub-tree according to the training examples.
+  double PathDependentExpectedValue(const Node* node) const {
+    if (!node->right_idx) {
+      return node->label;
+    }
+    const double pos_fraction = node_pos_fractions_[node - &model_.nodes[0]];
+    return pos_fraction * PathDependentExpectedValue(node + node->right_idx) +
+           (1. - pos_fraction) * PathDependentExpectedValue(node + 1);
+  }
+
+  double PathDependentExpectedValue() const {
+    double sum = 0.;
+    for (const auto root_offset : model_.root_offsets) {
+      sum += PathDependentExpectedValue(&model_.nodes[root_offset]);
+    }
+    return sum;
+  }
+
+  void PathDependentShap(const ExampleSet& examples, const int example_idx,
+                         PathDependentScratch* scratch,
+                         absl::Span<double> phi) const {
+    for (const auto root_offset : model_.root_offsets) {
+      PathDependentShap(&model_.nodes[root_offset], examples, example_idx,
+                        phi, scratch->path(), /*unique_depth=*/0,
+                        /*parent_zero_fraction=*/1., /*parent_one_fraction=*/1.,
+                        /*parent_column=*/-1);
+    }
+  }
+
+  // Algorithm 2 of "From local explanations to global understanding with
+  // explainable AI for trees".
+  void PathDependentShap(const Node* node, const ExampleSet& examples,
+                         const int example_idx, absl::Span<double> phi,
+                         const UniquePath& parent_path, int unique_depth,
+                         const double parent_zero_fraction,
+                         const double parent_one_fraction,
+                         const int parent_column) const {
+    const UniquePath path = parent_path.Next(unique_depth + 1);
+    std::copy_n(parent_path.columns, unique_depth + 1, path.columns);
+    std::copy_n(parent_path.zero_fractions, unique_depth + 1,
+                path.zero_fractions);
+    std::copy_n(parent_path.one_fractions, unique_depth + 1,
+                path.one_fractions);
+    std::copy_n(parent_path.weights, unique_depth + 1, path.weights);
+    ExtendPath(path, unique_depth, parent_zero_fraction, parent_one_fraction,
+               parent_column);
+
+    if (!node->right_idx) {
+      for (int i = 1; i <= unique_depth; i++) {
+        const double weight = UnwoundPathSum(path, unique_depth, i);
+        phi[path.columns[i]] += weight *
+                                (path.one_fractions[i] -
+                                 path.zero_fractions[i]) *
+                                node->label;
+      }
+      return;
+    }
+
+    const int node_idx = node - &model_.nodes[0];
+    const int column = node_columns_[node_idx];
+    const double pos_fraction = node_pos_fractions_[node_idx];
+    const bool eval = EvalNodeCondition(model_, *node, examples, example_idx);
+    const Node* hot_child = eval ? node + node->right_idx : node + 1;
+    const Node* cold_child = eval ? node + 1 : node + node->right_idx;
+    const double hot_fraction = eval ? pos_fraction : 1. - pos_fraction;
+    const double cold_fraction = 1. - hot_fraction;
+
+    // Undo the previous split on the same column, if any.
+    double incoming_zero_fraction = 1.;
+    double incoming_one_fraction = 1.;
+    int path_idx = 0;
+    while (path_idx <= unique_depth && path.columns[path_idx] != column) {
+      path_idx++;
+    }
+    if (path_idx <= unique_depth) {
+      incoming_zero_fraction = path.zero_fractions[path_idx];
+      incoming_one_fraction = path.one_fractions[path_idx];
+      UnwindPath(path, unique_depth, path_idx);
+      unique_depth--;
+    }
+
+    // Note: A child with null zero and one fractions does not contribute to
+    // the SHAP values (and cannot be unwound).
+    const double hot_zero_fraction = hot_fraction * incoming_zero_fraction;
+    if (hot_zero_fraction > 0. || incoming_one_fraction > 0.) {
+      PathDependentShap(hot_child, examples, example_idx, phi, path,
+                        unique_depth + 1, hot_zero_fraction,
+                        incoming_one_fraction, column);
+    }
+    const double cold_zero_fraction = cold_fraction * incoming_zero_fraction;
+    if (cold_zero_fraction > 0.) {
+      PathDependentShap(cold_child, examples, example_idx, phi, path,
+                        unique_depth + 1, cold_zero_fraction,
+                        /*parent_one_fraction=*/0., column);
+    }
+  }
+
+  // Mean raw output of the background examples.
+  double InterventionalExpectedValue() const {
+    double sum = 0.;
+    for (int reference_idx = 0; reference_idx < num_background_;
+         reference_idx++) {
+      for (const auto root_offset : model_.root_offsets) {
+        const Node* node = &model_.nodes[root_offset];
+        while (node->right_idx) {
+          node += EvalNodeCondition(model_, *node, *background_, reference_idx)
+                      ? node->right_idx
+                      : 1;
+        }
+        sum += node->label;
+      }
+    }
+    return sum / num_background_;
+  }
+
+  void InterventionalShap(const ExampleSet& examples, const int example_idx,
+                          InterventionalScratch* scratch,
+                          absl::Span<double> phi) const {
+    for (int reference_idx = 0; reference_idx < num_background_;
+         reference_idx++) {
+      for (const auto root_offset : model_.root_offsets) {
+        InterventionalShap(&model_.nodes[root_offset], examples, example_idx,
+                           reference_idx, scratch, phi);
+      }
+    }
+  }
+
+  // Shapley weight |S|! (M - |S| - 1)! / M! of a coalition of "a" features
+  // among "a + b + 1" features.
+  double CoalitionWeight(const int a, const int b) const {
+    return coalition_weights_[a * (max_depth_ + 1) + b];
+  }
+
+  // Interventional TreeSHAP of one example against one reference. The
+  // features of the path followed by the example (resp. reference) only get
+  // credited (resp. debited) the leaf value with the Shapley weight of the
+  // coalition.
+  void InterventionalShap(const Node* node, const ExampleSet& examples,
+                          const int example_idx, const int reference_idx,
+                          InterventionalScratch* scratch,
+                          absl::Span<double> phi) const {
+    if (!node->right_idx) {
+      const int num_example_columns = scratch->example_columns.size();
+      const int num_reference_columns = scratch->reference_columns.size();
+      if (num_example_columns > 0) {
+        const double weight =
+            node->label *
+            CoalitionWeight(num_example_columns - 1, num_reference_columns);
+        for (const int column : scratch->example_columns) {
+          phi[column] += weight;
+        }
+      }
+      if (num_reference_columns > 0) {
+        const double weight =
+            node->label *
+            CoalitionWeight(num_example_columns, num_reference_columns - 1);
+        for (const int column : scratch->reference_columns) {
+          phi[column] -= weight;
+        }
+      }
+      return;
+    }
+
+    const int column = node_columns_[node - &model_.nodes[0]];
+    const Node* pos_child = node + node->right_idx;
+    const Node* neg_child = node + 1;
+    auto& column_state = scratch->column_states[column];
+    switch (column_state) {
+      case kExample:
+        InterventionalShap(
+            EvalNodeCondition(model_, *node, examples, example_idx)
+                ? pos_child
+                : neg_child,
+            examples, example_idx, reference_idx, scratch, phi);
+        return;
+      case kReference:
+        InterventionalShap(
+            EvalNodeCondition(model_, *node, *background_, reference_idx)
+                ? pos_child
+                : neg_child,
+            examples, example_idx, reference_idx, scratch, phi);
+        return;
+      case kUnset:
+        break;
+    }
+
+    const bool example_eval =
+        EvalNodeCondition(model_, *node, examples, example_idx);
+    const bool reference_eval =
+        EvalNodeCondition(model_, *node, *background_, reference_idx);
+    const Node* example_child = example_eval ? pos_child : neg_child;
+    if (example_eval == reference_eval) {
+      InterventionalShap(example_child, examples, example_idx, reference_idx,
+                         scratch, phi);
+      return;
+    }
+
+    column_state = kExample;
+    scratch->example_columns.push_back(column);
+    InterventionalShap(example_child, examples, example_idx, reference_idx,
+                       scratch, phi);
+    scratch->example_columns.pop_back();
+
+    column_state = kReference;
+    scratch->reference_columns.push_back(column);
+    InterventionalShap(reference_eval ? pos_child : neg_child, examples,
+                       example_idx, reference_idx, scratch, phi);
+    scratch->reference_columns.pop_back();
+    column_state = kUnset;
+  }
+
+ private:
+  Model model_;
+  TreeShapOptions::Algorithm algorithm_;
+
+  // Column of the condition of each node of "model_.nodes". -1 for the leaves.
+  std::vector<int> node_columns_;
+  // Fraction of the training examples that reached the child at offset
+  // "right_idx" of each node of "model_.nodes".
+  std::vector<float> node_pos_fractions_;
+  // Maximum depth of the trees.
+  int max_depth_ = 0;
+
+  // Background examples of the interventional algorithm.
+  std::unique_ptr<ExampleSet> background_;
+  int num_background_ = 0;
+  // Shapley weights indexed by "CoalitionWeight".
+  std::vector<double> coalition_weights_;
+};
+
+// Compiles "src" into the flat node model "CompiledModel", and creates the
+// corresponding TreeShap.
+template <typename CompiledModel, typename SrcModel>
+absl::StatusOr<std::unique_ptr<TreeShap>> CreateTreeShap(
+    const SrcModel& src, const float initial_prediction,
+    const TreeShapOptions& options,
+    const dataset::VerticalDataset* background) {
+  using NodeOffsetRep = typename CompiledModel::NodeType::NodeOffset;
+  CompiledModel compiled_model;
+  RETURN_IF_ERROR(GenericToSpecializedModel(src, &compiled_model));
+  return TreeShapImpl<NodeOffsetRep>::Create(
+      std::move(
+          static_cast<ExampleSetModel<NodeOffsetRep>&>(compiled_model)),
+      src.input_features(), src.decision_trees(), initial_prediction, options,
+      background);
+}
+
+absl::StatusOr<std::unique_ptr<TreeShap>> CreateGradientBoostedTreesTreeShap(
+    const GradientBoostedTreesModel& src, const TreeShapOptions& options,
+    const dataset::VerticalDataset* background) {
+  using model::gradient_boosted_trees::proto::Loss;
+  if (src.initial_predictions().size() != 1) {
+    return absl::UnimplementedError(
+        "TreeSHAP only supports single output Gradient Boosted Trees models");
+  }
+  const float initial_prediction = src.initial_predictions()[0];
+  switch (src.loss()) {
+    case Loss::BINOMIAL_LOG_LIKELIHOOD:
+    case Loss::BINARY_FOCAL_LOSS:
+      if (NeedUint32NodeIndex(src)) {
+        return CreateTreeShap<
+            GenericGradientBoostedTreesBinaryClassification<uint32_t>>(
+            src, initial_prediction, options, background);
+      }
+      return CreateTreeShap<GradientBoostedTreesBinaryClassification>(
+          src, initial_prediction, options, background);
+    case Loss::SQUARED_ERROR:
+    case Loss::MEAN_AVERAGE_ERROR:
+      return CreateTreeShap<GradientBoostedTreesRegression>(
+          src, initial_prediction, options, background);
+    case Loss::LAMBDA_MART_NDCG5:
+    case Loss::LAMBDA_MART_NDCG:
+      return CreateTreeShap<GradientBoostedTreesRanking>(
+          src, initial_prediction, options, background);
+    case Loss::POISSON:
+      return CreateTreeShap<GradientBoostedTreesPoissonRegression>(
+          src, initial_prediction, options, background);
+    default:
+      return absl::UnimplementedError(
+          absl::StrCat("TreeSHAP does not support the loss ",
+                       Loss_Name(src.loss())));
+  }
+}
+
+absl::StatusOr<std::unique_ptr<TreeShap>> CreateRandomForestTreeShap(
+    const RandomForestModel& src, const TreeShapOptions& options,
+    const dataset::VerticalDataset* background) {
+  const bool uint32_node_index = NeedUint32NodeIndex(src);
+  switch (src.task()) {
+    case model::proto::Task::CLASSIFICATION:
+      if (src.label_col_spec().categorical().number_of_unique_values() != 3) {
+        return absl::UnimplementedError(
+            "TreeSHAP only supports binary classification Random Forest "
+            "models");
+      }
+      if (uint32_node_index) {
+        return CreateTreeShap<
+            GenericRandomForestBinaryClassification<uint32_t>>(
+            src, 0.f, options, background);
+      }
+      return CreateTreeShap<RandomForestBinaryClassification>(src, 0.f, options,
+                                                              background);
+    case model::proto::Task::REGRESSION:
+      if (uint32_node_index) {
+        return CreateTreeShap<GenericRandomForestRegression<uint32_t>>(
+            src, 0.f, options, background);
+      }
+      return CreateTreeShap<RandomForestRegression>(src, 0.f, options,
+                                                    background);
+    default:
+      return absl::UnimplementedError(
+          "TreeSHAP only supports classification and regression Random Forest "
+          "models");
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TreeShap>> TreeShap::Create(
+    const model::AbstractModel& model, const TreeShapOptions& options,
+    const dataset::VerticalDataset* background) {
+  if (const auto* gbt_model =
+          dynamic_cast<const GradientBoostedTreesModel*>(&model);
+      gbt_model != nullptr) {
+    return CreateGradientBoostedTreesTreeShap(*gbt_model, options, background);
+  }
+  if (const auto* rf_model = dynamic_cast<const RandomForestModel*>(&model);
+      rf_model != nullptr) {
+    return CreateRandomForestTreeShap(*rf_model, options, background);
+  }
+  return absl::UnimplementedError(absl::StrCat(
+      "TreeSHAP does not support the model \"", model.name(), "\""));
+}
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Exact SHAP values of decision forest models with the TreeSHAP algorithms
+// (Lundberg et al., "From local explanations to global understanding with
+// explainable AI for trees", 2020).
+//
+// Two algorithms are available:
+//   - Path dependent: The expectation of the model output is estimated with the
+//     number of training examples of each node. Runs in O(T x L x D^2) per
+//     example, where T is the number of trees, L the number of leaves per tree,
+//     and D the maximum depth.
+//   - Interventional: The expectation of the model output is computed on a
+//     background dataset. Runs in O(T x L x B) per example, where B is the
+//     number of background examples.
+//
+// The SHAP values are computed in the output space of the trees, before the
+// activation function (e.g. logit for binary classification GBT). For each
+// example, the sum of the SHAP values and of "expected_value()" is equal to
+// the model output before activation.
+//
+// The trees are evaluated on the flat node layout of the generic serving
+// engines (see "decision_forest_serving.h"). Supported models are the single
+// output Gradient Boosted Trees models (binary classification, regression,
+// ranking) and the binary classification and regression Random Forest models.
+//
+// Usage example:
+//   ASSIGN_OR_RETURN(auto tree_shap, TreeShap::Create(*model));
+//   auto examples = tree_shap->AllocateExamples(num_examples);
+//   ... Set the examples.
+//   std::vector<float> shap_values(num_examples *
+//                                  tree_shap->input_features().size());
+//   RETURN_IF_ERROR(tree_shap->Shap(*examples, num_examples,
+//                                   absl::MakeSpan(shap_values)));
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_TREE_SHAP_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_TREE_SHAP_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+struct TreeShapOptions {
+  enum class Algorithm {
+    kPathDependent,
+    kInterventional,
+  };
+  Algorithm algorithm = Algorithm::kPathDependent;
+
+  // Maximum number of background examples used by the interventional
+  // algorithm. If the background dataset is larger, the examples are
+  // sub-sampled uniformly.
+  int max_background_examples = 100;
+};
+
+class TreeShap {
+ public:
+  virtual ~TreeShap() = default;
+
+  // Compiles a model. "background" is only used (and required) by the
+  // interventional algorithm.
+  static absl::StatusOr<std::unique_ptr<TreeShap>> Create(
+      const model::AbstractModel& model, const TreeShapOptions& options = {},
+      const dataset::VerticalDataset* background = nullptr);
+
+  // Allocates a set of examples. See "FastEngine::AllocateExamples".
+  virtual std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      int num_examples) const = 0;
+
+  // Computes the SHAP values of the first "num_examples" examples of
+  // "examples". "shap_values" should contain "num_examples x
+  // input_features().size()" values, stored example-major. The SHAP value of
+  // the j-th feature of the i-th example is "shap_values[i *
+  // input_features().size() + j]".
+  virtual absl::Status Shap(const AbstractExampleSet& examples,
+                            int num_examples,
+                            absl::Span<float> shap_values) const = 0;
+
+  // Input features of the model, as column indices in the dataspec, in
+  // increasing order. Defines the order of the SHAP values.
+  const std::vector<int>& input_features() const { return input_features_; }
+
+  // Expected output of the model before activation.
+  float expected_value() const { return expected_value_; }
+
+  // List of features used by the model.
+  virtual const FeaturesDefinition& features() const = 0;
+
+  // Configures the multi-threaded evaluation of "Shap". See
+  // "FastEngine::SetParallelOptions".
+  void SetParallelOptions(FastEngine::ParallelOptions options) {
+    parallel_options_ = std::move(options);
+  }
+
+ protected:
+  std::vector<int> input_features_;
+  float expected_value_ = 0.f;
+  FastEngine::ParallelOptions parallel_options_;
+};
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_TREE_SHAP_H_
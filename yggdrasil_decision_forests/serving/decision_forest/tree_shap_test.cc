@@ -0,0 +1,522 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/tree_shap.h"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace {
+
+using model::decision_tree::DecisionTree;
+using model::decision_tree::NodeWithChildren;
+using model::gradient_boosted_trees::GradientBoostedTreesModel;
+using test::StatusIs;
+
+constexpr int kNumExamples = 50;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+void LoadModelAndDataset(const absl::string_view model_name,
+                         const absl::string_view dataset_filename,
+                         std::unique_ptr<model::AbstractModel>* model,
+                         dataset::VerticalDataset* dataset) {
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), model));
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", dataset_filename)),
+      (*model)->data_spec(), dataset));
+}
+
+// Computes the SHAP values of the first "kNumExamples" examples of "dataset".
+std::vector<float> ComputeShap(const TreeShap& tree_shap,
+                               const dataset::VerticalDataset& dataset) {
+  auto examples = tree_shap.AllocateExamples(kNumExamples);
+  EXPECT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, kNumExamples, tree_shap.features(), examples.get()));
+  std::vector<float> shap_values(kNumExamples *
+                                 tree_shap.input_features().size());
+  EXPECT_OK(
+      tree_shap.Shap(*examples, kNumExamples, absl::MakeSpan(shap_values)));
+  return shap_values;
+}
+
+// Checks that the sum of the SHAP values and of the expected value is equal to
+// the raw model output (i.e. the logit for "logit_output" models).
+void CheckShapAdditivity(const model::AbstractModel& model,
+                         const dataset::VerticalDataset& dataset,
+                         const TreeShap& tree_shap, const bool logit_output) {
+  ASSERT_OK_AND_ASSIGN(const auto engine, model.BuildFastEngine());
+  auto examples = engine->AllocateExamples(kNumExamples);
+  ASSERT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, kNumExamples, engine->features(), examples.get()));
+  std::vector<float> predictions;
+  engine->Predict(*examples, kNumExamples, &predictions);
+
+  const auto shap_values = ComputeShap(tree_shap, dataset);
+  const int num_columns = tree_shap.input_features().size();
+  for (int example_idx = 0; example_idx < kNumExamples; example_idx++) {
+    double expected_output = predictions[example_idx];
+    if (logit_output) {
+      const double p = expected_output;
+      if (p < 1e-4 || p > 1. - 1e-4) {
+        // The logit cannot be recovered precisely.
+        continue;
+      }
+      expected_output = std::log(p / (1. - p));
+    }
+    double output = tree_shap.expected_value();
+    for (int column = 0; column < num_columns; column++) {
+      output += shap_values[example_idx * num_columns + column];
+    }
+    EXPECT_NEAR(output, expected_output, 2e-3) << "example " << example_idx;
+  }
+}
+
+// Small hand-built model used to compare the SHAP values with the brute-force
+// Shapley values.
+
+// Number of input features of the small model. The feature "xi" is the column
+// "i + 1" of the dataspec and the i-th SHAP value.
+constexpr int kNumSmallModelFeatures = 3;
+constexpr float kSmallModelInitialPrediction = 0.25f;
+
+// Makes "node" a "x_{attribute-1} >= threshold" condition reached by
+// "num_examples" training examples, "num_pos_examples" of which go to the
+// positive child.
+void SetCondition(const int attribute, const float threshold,
+                  const int num_examples, const int num_pos_examples,
+                  NodeWithChildren* node) {
+  node->CreateChildren();
+  auto* condition = node->mutable_node()->mutable_condition();
+  condition->set_attribute(attribute);
+  condition->set_na_value(false);
+  condition->mutable_condition()->mutable_higher_condition()->set_threshold(
+      threshold);
+  condition->set_num_training_examples_without_weight(num_examples);
+  condition->set_num_pos_training_examples_without_weight(num_pos_examples);
+}
+
+void SetLeaf(const float value, NodeWithChildren* node) {
+  node->mutable_node()->mutable_regressor()->set_top_value(value);
+}
+
+// A regression GBT with two trees. The first tree tests "x0" twice on the same
+// path.
+//   Tree 1: x0>=0.5 ? (x1>=0.5 ? (x0>=1.5 ? 5 : -2) : 3) : 1
+//   Tree 2: x2>=0.5 ? 2 : (x1>=0.5 ? -1.5 : 0.5)
+void BuildSmallModel(GradientBoostedTreesModel* model) {
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "label" }
+    columns { type: NUMERICAL name: "x0" numerical { mean: 1 } }
+    columns { type: NUMERICAL name: "x1" numerical { mean: 0.5 } }
+    columns { type: NUMERICAL name: "x2" numerical { mean: 0.5 } }
+  )pb");
+
+  auto tree_1 = std::make_unique<DecisionTree>();
+  tree_1->CreateRoot();
+  NodeWithChildren* node = tree_1->mutable_root();
+  SetCondition(/*attribute=*/1, /*threshold=*/0.5f, /*num_examples=*/10,
+               /*num_pos_examples=*/6, node);
+  SetLeaf(1.f, node->mutable_neg_child());
+  node = node->mutable_pos_child();
+  SetCondition(/*attribute=*/2, /*threshold=*/0.5f, /*num_examples=*/6,
+               /*num_pos_examples=*/2, node);
+  SetLeaf(3.f, node->mutable_neg_child());
+  node = node->mutable_pos_child();
+  SetCondition(/*attribute=*/1, /*threshold=*/1.5f, /*num_examples=*/2,
+               /*num_pos_examples=*/1, node);
+  SetLeaf(-2.f, node->mutable_neg_child());
+  SetLeaf(5.f, node->mutable_pos_child());
+
+  auto tree_2 = std::make_unique<DecisionTree>();
+  tree_2->CreateRoot();
+  node = tree_2->mutable_root();
+  SetCondition(/*attribute=*/3, /*threshold=*/0.5f, /*num_examples=*/10,
+               /*num_pos_examples=*/3, node);
+  SetLeaf(2.f, node->mutable_pos_child());
+  node = node->mutable_neg_child();
+  SetCondition(/*attribute=*/2, /*threshold=*/0.5f, /*num_examples=*/7,
+               /*num_pos_examples=*/4, node);
+  SetLeaf(0.5f, node->mutable_neg_child());
+  SetLeaf(-1.5f, node->mutable_pos_child());
+
+  model->set_task(model::proto::Task::REGRESSION);
+  model->set_label_col_idx(0);
+  model->set_data_spec(dataspec);
+  model::gradient_boosted_trees::proto::LossConfiguration loss_config;
+  model->set_loss(model::gradient_boosted_trees::proto::Loss::SQUARED_ERROR,
+                  loss_config);
+  model->mutable_initial_predictions()->push_back(kSmallModelInitialPrediction);
+  *model->mutable_input_features() = {1, 2, 3};
+  model->set_num_trees_per_iter(1);
+  model->mutable_decision_trees()->push_back(std::move(tree_1));
+  model->mutable_decision_trees()->push_back(std::move(tree_2));
+}
+
+// Creates a dataset for the small model. Each example contains the values of
+// the features "x0", "x1" and "x2".
+dataset::VerticalDataset CreateSmallModelDataset(
+    const model::AbstractModel& model,
+    const std::vector<std::vector<float>>& examples) {
+  dataset::VerticalDataset dataset;
+  dataset.set_data_spec(model.data_spec());
+  CHECK_OK(dataset.CreateColumnsFromDataspec());
+  for (const auto& example : examples) {
+    std::unordered_map<std::string, std::string> values = {{"label", "0"}};
+    for (int feature = 0; feature < kNumSmallModelFeatures; feature++) {
+      values[absl::StrCat("x", feature)] = absl::StrCat(example[feature]);
+    }
+    CHECK_OK(dataset.AppendExampleWithStatus(values));
+  }
+  return dataset;
+}
+
+bool EvalSmallModelCondition(const NodeWithChildren& node,
+                             const std::vector<float>& example) {
+  const auto& condition = node.node().condition();
+  return example[condition.attribute() - 1] >=
+         condition.condition().higher_condition().threshold();
+}
+
+// Raw output of the small model.
+double SmallModelOutput(const GradientBoostedTreesModel& model,
+                        const std::vector<float>& example) {
+  double output = kSmallModelInitialPrediction;
+  for (const auto& tree : model.decision_trees()) {
+    const NodeWithChildren* node = &tree->root();
+    while (!node->IsLeaf()) {
+      node = EvalSmallModelCondition(*node, example) ? node->pos_child()
+                                                     : node->neg_child();
+    }
+    output += node->node().regressor().top_value();
+  }
+  return output;
+}
+
+// Expected output of the sub-tree "node" when only the features in
+// "coalition" (bitmap over the features) are known. The unknown features are
+// integrated out with the fraction of training examples of each child.
+double PathDependentExpectation(const NodeWithChildren& node,
+                                const std::vector<float>& example,
+                                const uint32_t coalition) {
+  if (node.IsLeaf()) {
+    return node.node().regressor().top_value();
+  }
+  const auto& condition = node.node().condition();
+  if (coalition & (1u << (condition.attribute() - 1))) {
+    return PathDependentExpectation(EvalSmallModelCondition(node, example)
+                                        ? *node.pos_child()
+                                        : *node.neg_child(),
+                                    example, coalition);
+  }
+  const double pos_fraction =
+      static_cast<double>(
+          condition.num_pos_training_examples_without_weight()) /
+      condition.num_training_examples_without_weight();
+  return pos_fraction *
+             PathDependentExpectation(*node.pos_child(), example, coalition) +
+         (1. - pos_fraction) *
+             PathDependentExpectation(*node.neg_child(), example, coalition);
+}
+
+// Exact Shapley values of the "value" set function, computed by enumerating
+// all the coalitions. Also returns "value" of the empty coalition in
+// "empty_value".
+std::vector<double> BruteForceShapleyValues(
+    const std::function<double(uint32_t)>& value, double* empty_value) {
+  const int n = kNumSmallModelFeatures;
+  std::vector<double> factorial(n + 1, 1.);
+  for (int i = 1; i <= n; i++) {
+    factorial[i] = factorial[i - 1] * i;
+  }
+  std::vector<double> shapley_values(n, 0.);
+  for (int feature = 0; feature < n; feature++) {
+    for (uint32_t coalition = 0; coalition < (1u << n); coalition++) {
+      if (coalition & (1u << feature)) {
+        continue;
+      }
+      const int size = __builtin_popcount(coalition);
+      const double weight =
+          factorial[size] * factorial[n - size - 1] / factorial[n];
+      shapley_values[feature] +=
+          weight * (value(coalition | (1u << feature)) - value(coalition));
+    }
+  }
+  *empty_value = value(0);
+  return shapley_values;
+}
+
+// All the combinations of x0 in {0, 1, 2}, x1 in {0, 1} and x2 in {0, 1}.
+std::vector<std::vector<float>> SmallModelExamples() {
+  std::vector<std::vector<float>> examples;
+  for (const float x0 : {0.f, 1.f, 2.f}) {
+    for (const float x1 : {0.f, 1.f}) {
+      for (const float x2 : {0.f, 1.f}) {
+        examples.push_back({x0, x1, x2});
+      }
+    }
+  }
+  return examples;
+}
+
+// Checks the SHAP values of "tree_shap" on the small model examples against
+// the brute-force Shapley values of "value(example, coalition)".
+void CheckSmallModelShap(
+    const TreeShap& tree_shap, const model::AbstractModel& model,
+    const std::function<double(const std::vector<float>&, uint32_t)>& value) {
+  ASSERT_EQ(tree_shap.input_features().size(), kNumSmallModelFeatures);
+  const auto examples = SmallModelExamples();
+  const auto dataset = CreateSmallModelDataset(model, examples);
+  auto example_set = tree_shap.AllocateExamples(examples.size());
+  ASSERT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, examples.size(), tree_shap.features(), example_set.get()));
+  std::vector<float> shap_values(examples.size() * kNumSmallModelFeatures);
+  ASSERT_OK(tree_shap.Shap(*example_set, examples.size(),
+                           absl::MakeSpan(shap_values)));
+
+  for (int example_idx = 0; example_idx < examples.size(); example_idx++) {
+    const auto& example = examples[example_idx];
+    double expected_value;
+    const auto expected_shap_values = BruteForceShapleyValues(
+        [&](const uint32_t coalition) { return value(example, coalition); },
+        &expected_value);
+    EXPECT_NEAR(tree_shap.expected_value(), expected_value, 1e-5);
+    for (int feature = 0; feature < kNumSmallModelFeatures; feature++) {
+      EXPECT_NEAR(shap_values[example_idx * kNumSmallModelFeatures + feature],
+                  expected_shap_values[feature], 1e-5)
+          << "example " << example_idx << " feature " << feature;
+    }
+  }
+}
+
+TEST(TreeShap, PathDependentEqualsBruteForce) {
+  GradientBoostedTreesModel model;
+  BuildSmallModel(&model);
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(model));
+  CheckSmallModelShap(
+      *tree_shap, model,
+      [&](const std::vector<float>& example, const uint32_t coalition) {
+        double output = kSmallModelInitialPrediction;
+        for (const auto& tree : model.decision_trees()) {
+          output += PathDependentExpectation(tree->root(), example, coalition);
+        }
+        return output;
+      });
+}
+
+TEST(TreeShap, InterventionalEqualsBruteForce) {
+  GradientBoostedTreesModel model;
+  BuildSmallModel(&model);
+  const std::vector<std::vector<float>> background_examples = {
+      {0.f, 1.f, 0.f}, {2.f, 0.f, 1.f}, {1.f, 1.f, 1.f}, {2.f, 1.f, 0.f}};
+  const auto background = CreateSmallModelDataset(model, background_examples);
+  TreeShapOptions options;
+  options.algorithm = TreeShapOptions::Algorithm::kInterventional;
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap,
+                       TreeShap::Create(model, options, &background));
+  CheckSmallModelShap(
+      *tree_shap, model,
+      [&](const std::vector<float>& example, const uint32_t coalition) {
+        // Mean output on the background examples, with the features of the
+        // coalition replaced by the ones of the explained example.
+        double sum = 0.;
+        for (std::vector<float> mixed : background_examples) {
+          for (int feature = 0; feature < kNumSmallModelFeatures; feature++) {
+            if (coalition & (1u << feature)) {
+              mixed[feature] = example[feature];
+            }
+          }
+          sum += SmallModelOutput(model, mixed);
+        }
+        return sum / background_examples.size();
+      });
+}
+
+TEST(TreeShap, PathDependentAdultGbt) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  EXPECT_THAT(tree_shap->input_features(),
+              testing::UnorderedElementsAreArray(model->input_features()));
+  CheckShapAdditivity(*model, dataset, *tree_shap, /*logit_output=*/true);
+}
+
+TEST(TreeShap, PathDependentAdultGbtWithNodeTraffic) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  ASSERT_OK_AND_ASSIGN(const auto default_tree_shap, TreeShap::Create(*model));
+
+  // The flat model re-orders the trees and inverts some conditions.
+  auto* gbt_model = dynamic_cast<GradientBoostedTreesModel*>(model.get());
+  ASSERT_OK(model::decision_tree::SetNodeTraffic(
+      dataset, gbt_model->mutable_decision_trees()));
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  CheckShapAdditivity(*model, dataset, *tree_shap, /*logit_output=*/true);
+  EXPECT_NEAR(tree_shap->expected_value(), default_tree_shap->expected_value(),
+              1e-4);
+
+  const auto default_shap_values = ComputeShap(*default_tree_shap, dataset);
+  const auto shap_values = ComputeShap(*tree_shap, dataset);
+  ASSERT_EQ(shap_values.size(), default_shap_values.size());
+  for (size_t value_idx = 0; value_idx < shap_values.size(); value_idx++) {
+    EXPECT_NEAR(shap_values[value_idx], default_shap_values[value_idx], 1e-4);
+  }
+}
+
+TEST(TreeShap, PathDependentAbaloneGbt) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("abalone_regression_gbdt", "abalone.csv", &model,
+                      &dataset);
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  CheckShapAdditivity(*model, dataset, *tree_shap, /*logit_output=*/false);
+}
+
+TEST(TreeShap, PathDependentAdultRf) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_rf", "adult_test.csv", &model,
+                      &dataset);
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  CheckShapAdditivity(*model, dataset, *tree_shap, /*logit_output=*/false);
+}
+
+TEST(TreeShap, PathDependentAbaloneRf) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("abalone_regression_rf", "abalone.csv", &model,
+                      &dataset);
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  CheckShapAdditivity(*model, dataset, *tree_shap, /*logit_output=*/false);
+}
+
+TEST(TreeShap, InterventionalAdultGbt) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  TreeShapOptions options;
+  options.algorithm = TreeShapOptions::Algorithm::kInterventional;
+  options.max_background_examples = 20;
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap,
+                       TreeShap::Create(*model, options, &dataset));
+  CheckShapAdditivity(*model, dataset, *tree_shap, /*logit_output=*/true);
+}
+
+TEST(TreeShap, InterventionalSelfReference) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("abalone_regression_gbdt", "abalone.csv", &model,
+                      &dataset);
+  // With the explained example as the only reference, all the SHAP values
+  // are null.
+  ASSERT_OK_AND_ASSIGN(const auto background,
+                       dataset.Extract(std::vector<int>{0}));
+  TreeShapOptions options;
+  options.algorithm = TreeShapOptions::Algorithm::kInterventional;
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap,
+                       TreeShap::Create(*model, options, &background));
+  const auto shap_values = ComputeShap(*tree_shap, dataset);
+  for (int column = 0; column < tree_shap->input_features().size(); column++) {
+    EXPECT_EQ(shap_values[column], 0.f);
+  }
+}
+
+TEST(TreeShap, MultiThreaded) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  const auto expected_shap_values = ComputeShap(*tree_shap, dataset);
+
+  auto thread_pool = std::make_shared<utils::concurrency::ThreadPool>(4);
+  thread_pool->StartWorkers();
+  tree_shap->SetParallelOptions(
+      {.thread_pool = thread_pool, .min_examples_per_thread = 4});
+  EXPECT_EQ(ComputeShap(*tree_shap, dataset), expected_shap_values);
+}
+
+TEST(TreeShap, InvalidArguments) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv", &model,
+                      &dataset);
+
+  TreeShapOptions options;
+  options.algorithm = TreeShapOptions::Algorithm::kInterventional;
+  EXPECT_THAT(TreeShap::Create(*model, options).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  ASSERT_OK_AND_ASSIGN(const auto tree_shap, TreeShap::Create(*model));
+  auto examples = tree_shap->AllocateExamples(1);
+  std::vector<float> shap_values(1);
+  EXPECT_THAT(tree_shap->Shap(*examples, 1, absl::MakeSpan(shap_values)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TreeShap, ObliqueConditions) {
+  std::unique_ptr<model::AbstractModel> model;
+  dataset::VerticalDataset dataset;
+  LoadModelAndDataset("adult_binary_class_oblique_rf", "adult_test.csv", &model,
+                      &dataset);
+  EXPECT_THAT(TreeShap::Create(*model).status(),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
+}  // namespace
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -16,7 +16,14 @@
 #include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <queue>
 #include <unordered_map>
 #include <vector>
 
@@ -24,6 +31,7 @@
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/isolation_forest/isolation_forest.h"
 #include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
@@ -34,6 +42,223 @@ namespace yggdrasil_decision_forests {
 namespace serving {
 namespace decision_forest {
 
+using model::decision_tree::NodeWithChildren;
+
+namespace {
+
+// Lists the nodes depth-first with the negative child first.
+void DepthFirstFlatNodeLayout(const NodeWithChildren& node,
+                              std::vector<FlatNode>* layout) {
+  layout->push_back({/*.node =*/&node});
+  if (!node.IsLeaf()) {
+    DepthFirstFlatNodeLayout(*node.neg_child(), layout);
+    DepthFirstFlatNodeLayout(*node.pos_child(), layout);
+  }
+}
+
+// Lists the nodes according to their "num_profiled_examples". Returns false if
+// a node offset is greater or equal to "offset_limit".
+bool ProfiledFlatNodeLayout(
+    const NodeWithChildren& root, const size_t offset_limit,
+    const std::function<bool(const NodeWithChildren&)>& can_invert,
+    std::vector<FlatNode>* layout) {
+  // A subtree not yet emitted, reached through the jump branch of the node
+  // "parent_idx" in "layout".
+  struct PendingSubtree {
+    int64_t traffic;
+    // Order of discovery. Among subtrees with the same traffic, the last
+    // discovered one is emitted first (like the depth-first layout).
+    int64_t sequence;
+    const NodeWithChildren* node;
+    size_t parent_idx;
+  };
+  const auto emitted_after = [](const PendingSubtree& a,
+                                const PendingSubtree& b) {
+    if (a.traffic != b.traffic) {
+      return a.traffic < b.traffic;
+    }
+    return a.sequence < b.sequence;
+  };
+  std::priority_queue<PendingSubtree, std::vector<PendingSubtree>,
+                      decltype(emitted_after)>
+      pending(emitted_after);
+  int64_t sequence = 0;
+  pending.push({/*.traffic =*/0, /*.sequence =*/sequence++, /*.node =*/&root,
+                /*.parent_idx =*/std::numeric_limits<size_t>::max()});
+
+  while (!pending.empty()) {
+    const PendingSubtree subtree = pending.top();
+    pending.pop();
+    if (subtree.parent_idx != std::numeric_limits<size_t>::max() &&
+        layout->size() - subtree.parent_idx >= offset_limit) {
+      return false;
+    }
+    // Emits the chain of fall-through children.
+    const NodeWithChildren* node = subtree.node;
+    while (true) {
+      const size_t node_idx = layout->size();
+      FlatNode flat_node{/*.node =*/node};
+      if (!node->IsLeaf()) {
+        // Ties keep the negative child as fall-through.
+        const int64_t pos_traffic =
+            node->pos_child()->node().num_profiled_examples();
+        const int64_t neg_traffic =
+            node->neg_child()->node().num_profiled_examples();
+        flat_node.inverted =
+            pos_traffic > neg_traffic && can_invert && can_invert(*node);
+      }
+      layout->push_back(flat_node);
+      if (node->IsLeaf()) {
+        break;
+      }
+      const NodeWithChildren* jump_child = flat_node.JumpChild();
+      pending.push({/*.traffic =*/jump_child->node().num_profiled_examples(),
+                    /*.sequence =*/sequence++, /*.node =*/jump_child,
+                    /*.parent_idx =*/node_idx});
+      node = flat_node.FallThroughChild();
+    }
+  }
+  return true;
+}
+
+// Expected number of conditions evaluated to traverse a profiled tree.
+double ExpectedNumConditions(const model::decision_tree::DecisionTree& tree) {
+  const int64_t root_traffic = tree.root().node().num_profiled_examples();
+  if (root_traffic <= 0) {
+    return 0.;
+  }
+  int64_t sum_traffic = 0;
+  tree.IterateOnNodes([&](const NodeWithChildren& node, const int depth) {
+    if (!node.IsLeaf()) {
+      sum_traffic += node.node().num_profiled_examples();
+    }
+  });
+  return static_cast<double>(sum_traffic) / root_traffic;
+}
+
+}  // namespace
+
+std::vector<FlatNode> FlatNodeLayout(
+    const NodeWithChildren& root, const size_t offset_limit,
+    const std::function<bool(const NodeWithChildren&)>& can_invert) {
+  std::vector<FlatNode> layout;
+  if (root.node().has_num_profiled_examples()) {
+    if (ProfiledFlatNodeLayout(root, offset_limit, can_invert, &layout)) {
+      return layout;
+    }
+    layout.clear();
+  }
+  DepthFirstFlatNodeLayout(root, &layout);
+  return layout;
+}
+
+bool CanInvertGenericNodeCondition(
+    const dataset::proto::DataSpecification& data_spec,
+    const NodeWithChildren& node) {
+  using ConditionType = model::decision_tree::proto::Condition::TypeCase;
+  const auto& condition = node.node().condition();
+  switch (condition.condition().type_case()) {
+    case ConditionType::kHigherCondition:
+    case ConditionType::kTrueValueCondition:
+    case ConditionType::kDiscretizedHigherCondition:
+      return true;
+    case ConditionType::kContainsCondition:
+    case ConditionType::kContainsBitmapCondition:
+      // A categorical-set contains condition tests if any of the values is in
+      // the mask. Its negation is not a contains condition.
+      return data_spec.columns(condition.attribute()).type() ==
+             dataset::proto::CATEGORICAL;
+    default:
+      return false;
+  }
+}
+
+std::vector<int> FlatTreeOrder(
+    const std::vector<std::unique_ptr<model::decision_tree::DecisionTree>>&
+        trees,
+    const int num_trees_per_iter) {
+  std::vector<int> order(trees.size());
+  std::iota(order.begin(), order.end(), 0);
+  if (num_trees_per_iter <= 0 || trees.size() % num_trees_per_iter != 0) {
+    return order;
+  }
+  for (const auto& tree : trees) {
+    if (!tree->root().node().has_num_profiled_examples()) {
+      return order;
+    }
+  }
+
+  std::vector<double> num_conditions(trees.size());
+  for (int tree_idx = 0; tree_idx < trees.size(); tree_idx++) {
+    num_conditions[tree_idx] = ExpectedNumConditions(*trees[tree_idx]);
+  }
+  // Sorts the trees of each output, and stores them back in the slots of this
+  // output.
+  const int num_iters = trees.size() / num_trees_per_iter;
+  std::vector<int> output_trees(num_iters);
+  for (int output_idx = 0; output_idx < num_trees_per_iter; output_idx++) {
+    for (int iter_idx = 0; iter_idx < num_iters; iter_idx++) {
+      output_trees[iter_idx] = iter_idx * num_trees_per_iter + output_idx;
+    }
+    std::stable_sort(output_trees.begin(), output_trees.end(),
+                     [&](const int a, const int b) {
+                       return num_conditions[a] < num_conditions[b];
+                     });
+    for (int iter_idx = 0; iter_idx < num_iters; iter_idx++) {
+      order[iter_idx * num_trees_per_iter + output_idx] =
+          output_trees[iter_idx];
+    }
+  }
+  return order;
+}
+
+void SortInputFeaturesByAccessFrequency(
+    const std::vector<std::unique_ptr<model::decision_tree::DecisionTree>>&
+        trees,
+    std::vector<int>* input_features) {
+  std::unordered_map<int, double> access_frequency;
+  for (const auto& tree : trees) {
+    const auto& root = tree->root();
+    const bool profiled = root.node().has_num_profiled_examples() &&
+                          root.node().num_profiled_examples() > 0;
+    const double root_traffic =
+        profiled ? static_cast<double>(root.node().num_profiled_examples())
+                 : 1.;
+    tree->IterateOnNodes(
+        [&](const NodeWithChildren& node, const int depth) {
+          if (node.IsLeaf()) {
+            return;
+          }
+          const double frequency =
+              profiled ? node.node().num_profiled_examples() / root_traffic
+                       : std::ldexp(1., -depth);
+          const auto& condition = node.node().condition();
+          if (condition.condition().has_oblique_condition()) {
+            for (const auto attribute :
+                 condition.condition().oblique_condition().attributes()) {
+              access_frequency[attribute] += frequency;
+            }
+          } else {
+            access_frequency[condition.attribute()] += frequency;
+          }
+        });
+  }
+
+  std::stable_sort(input_features->begin(), input_features->end(),
+                   [&](const int a, const int b) {
+                     const auto it_a = access_frequency.find(a);
+                     const auto it_b = access_frequency.find(b);
+                     const double freq_a =
+                         it_a == access_frequency.end() ? 0. : it_a->second;
+                     const double freq_b =
+                         it_b == access_frequency.end() ? 0. : it_b->second;
+                     if (freq_a != freq_b) {
+                       return freq_a > freq_b;
+                     }
+                     return a < b;
+                   });
+}
+
 // Get the list of input features used by the model.
 //
 // The order of the input feature is deterministic.
@@ -18,21 +18,34 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_UTILS_H_
 #define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_UTILS_H_
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 
 namespace yggdrasil_decision_forests {
 namespace serving {
 namespace decision_forest {
 
 // Initialize the "feature_name", and "na_replacement_values" fields of a
-// "FlatNodeModel".
+// "FlatNodeModel". If set, "input_features" lists the dataspec columns of the
+// example set. Otherwise, the example set only contains the features used by
+// the trees, sorted by decreasing access frequency (see
+// "SortInputFeaturesByAccessFrequency").
 template <typename GenericModel, typename SpecializedModel>
-absl::Status InitializeFlatNodeModel(const GenericModel& src_model,
-                                     SpecializedModel* dst_model,
-                                     bool missing_numerical_is_na = false);
+absl::Status InitializeFlatNodeModel(
+    const GenericModel& src_model, SpecializedModel* dst_model,
+    bool missing_numerical_is_na = false,
+    const std::vector<int>* input_features = nullptr);
 
 // Get the list of input features used by the model.
 absl::Status GetInputFeatures(
@@ -40,6 +53,89 @@ absl::Status GetInputFeatures(
     std::vector<int>* input_features_idxs,
     std::vector<int>* feature_idx_to_local_feature_idx);
 
+// Sorts the input features by decreasing expected number of accesses during
+// inference. In an example-major example set, the features accessed by most of
+// the examples are then packed at the start of each example and share cache
+// lines.
+//
+// The access frequency of a feature is the sum, over the non-leaf nodes testing
+// it, of the fraction of examples reaching the node. This fraction is computed
+// from the traffic statistics (see "model::decision_tree::SetNodeTraffic") if
+// available, and estimated as "2^-depth" otherwise. Ties are broken by dataspec
+// column index, so the order is deterministic.
+void SortInputFeaturesByAccessFrequency(
+    const std::vector<std::unique_ptr<model::decision_tree::DecisionTree>>&
+        trees,
+    std::vector<int>* input_features);
+
+// A node of a flat node model.
+struct FlatNode {
+  const model::decision_tree::NodeWithChildren* node;
+  // If true, the condition of the node is inverted in the flat node model: The
+  // positive child directly follows the node, and the negative child is at
+  // offset "right_idx".
+  bool inverted = false;
+
+  // Child directly following the node.
+  const model::decision_tree::NodeWithChildren* FallThroughChild() const {
+    return inverted ? node->pos_child() : node->neg_child();
+  }
+  // Child at offset "right_idx" of the node.
+  const model::decision_tree::NodeWithChildren* JumpChild() const {
+    return inverted ? node->neg_child() : node->pos_child();
+  }
+};
+
+// Lists the nodes of a tree in the order they are stored in a flat node model.
+// The fall-through child of a non-leaf node always directly follows it, and
+// its jump child is stored after it.
+//
+// If the nodes contain traffic statistics (see
+// "model::decision_tree::SetNodeTraffic"), the fall-through child of the nodes
+// accepted by "can_invert" is their most visited child, and the chains of
+// fall-through children are emitted hottest first. The nodes visited by most
+// of the examples are then packed at the start of the tree and share cache
+// lines, and the common path does not jump. Otherwise, or if this layout
+// requires a node offset greater or equal to "offset_limit", the nodes are
+// listed depth-first with the negative child as fall-through child.
+//
+// "can_invert" tells if the flat node model can store the inverted condition of
+// a non-leaf node. If null, no condition is inverted.
+std::vector<FlatNode> FlatNodeLayout(
+    const model::decision_tree::NodeWithChildren& root, size_t offset_limit,
+    const std::function<bool(const model::decision_tree::NodeWithChildren&)>&
+        can_invert = nullptr);
+
+// Tests if the condition of a non-leaf node can be stored inverted in a
+// "GenericNode" flat node model i.e. if the engines have a node type for its
+// exact negation. Numerical conditions have "kNumericalIsLower*" node types,
+// and the mask of categorical contains conditions can be complemented.
+bool CanInvertGenericNodeCondition(
+    const dataset::proto::DataSpecification& data_spec,
+    const model::decision_tree::NodeWithChildren& node);
+
+// Lists the indices of the trees in the order they are stored in a flat node
+// model. The output of a tree is added to the output "tree_idx %
+// num_trees_per_iter".
+//
+// If all the trees contain traffic statistics, the trees of each output are
+// sorted by increasing expected number of traversed conditions (ties broken by
+// tree index), and the outputs stay interleaved. The engines that traverse
+// several consecutive trees at the same time (e.g. "PredictOptimizedV1") then
+// traverse trees of similar depth together, and keep all their independent
+// node loads in flight until the end of the batch. Otherwise, the trees are
+// listed in order. Reordering the trees only changes the floating point
+// rounding of the accumulated predictions.
+std::vector<int> FlatTreeOrder(
+    const std::vector<std::unique_ptr<model::decision_tree::DecisionTree>>&
+        trees,
+    int num_trees_per_iter);
+
+// Number of outputs the trees of a model are interleaved over (see
+// "FlatTreeOrder").
+template <typename GenericModel>
+int NumTreesPerIter(const GenericModel& model);
+
 // Converts a feature name into the model's internal feature index. Returns "-1"
 // if the model does not use this feature.
 template <typename SpecializedModel>
@@ -55,13 +151,30 @@ absl::flat_hash_map<std::string, int> GetFeatureIndexMap(
 //   Below are the template definitions.
 // =======================================
 
+template <typename GenericModel>
+int NumTreesPerIter(const GenericModel& model) {
+  if constexpr (std::is_same_v<GenericModel, model::gradient_boosted_trees::
+                                                 GradientBoostedTreesModel>) {
+    return model.num_trees_per_iter();
+  } else {
+    return 1;
+  }
+}
+
 template <typename GenericModel, typename SpecializedModel>
-absl::Status InitializeFlatNodeModel(const GenericModel& src_model,
-                                     SpecializedModel* dst_model,
-                                     const bool missing_numerical_is_na) {
+absl::Status InitializeFlatNodeModel(
+    const GenericModel& src_model, SpecializedModel* dst_model,
+    const bool missing_numerical_is_na,
+    const std::vector<int>* input_features) {
   // List the model input features.
   std::vector<int> all_input_features;
-  RETURN_IF_ERROR(GetInputFeatures(src_model, &all_input_features, nullptr));
+  if (input_features != nullptr) {
+    all_input_features = *input_features;
+  } else {
+    RETURN_IF_ERROR(GetInputFeatures(src_model, &all_input_features, nullptr));
+    SortInputFeaturesByAccessFrequency(src_model.decision_trees(),
+                                       &all_input_features);
+  }
 
   RETURN_IF_ERROR(dst_model->mutable_features()->Initialize(
       all_input_features, src_model.data_spec(), missing_numerical_is_na));
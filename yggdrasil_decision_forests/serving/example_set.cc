@@ -29,6 +29,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
@@ -134,6 +135,22 @@ bool FeaturesDefinitionNumericalOrCategoricalFlat::HasInputFeature(
              indexed_unstacked_features_.end();
 }
 
+std::vector<int> FeaturesDefinitionNumericalOrCategoricalFlat::UnusedColumns(
+    const absl::Span<const int> columns) const {
+  std::vector<bool> is_input(data_spec_.columns_size(), false);
+  for (const int column_idx : column_input_features_) {
+    is_input[column_idx] = true;
+  }
+  std::vector<int> unused;
+  for (const int column_idx : columns) {
+    if (column_idx < 0 || column_idx >= is_input.size() ||
+        !is_input[column_idx]) {
+      unused.push_back(column_idx);
+    }
+  }
+  return unused;
+}
+
 absl::Status FeaturesDefinitionNumericalOrCategoricalFlat::Initialize(
     const std::vector<int>& input_features, const DataSpecification& dataspec,
     const bool missing_numerical_is_na) {
@@ -331,7 +348,7 @@ absl::Status CopyVerticalDatasetToAbstractExampleSet(
         examples->SetMissingBoolean(example_idx, feature_id, features);
       } else {
         examples->SetBoolean(example_idx, feature_id,
-                             feature_data->values()[row_idx], features);
+                             feature_data->IsTrue(row_idx), features);
       }
     }
     return absl::OkStatus();
@@ -373,7 +390,7 @@ absl::Status CopyVerticalDatasetToAbstractExampleSet(
         examples->SetMissingCategorical(example_idx, feature_id, features);
       } else {
         examples->SetCategorical(example_idx, feature_id,
-                                 feature_data->values()[row_idx], features);
+                                 feature_data->value(row_idx), features);
       }
     }
     return absl::OkStatus();
@@ -413,6 +413,12 @@ class FeaturesDefinitionNumericalOrCategoricalFlat {
   // functions "Get*FeatureId" will fail.
   bool HasInputFeature(absl::string_view name) const;
 
+  // Lists the dataspec columns in "columns" that are not input features of the
+  // engine. For instance, with "columns=model.input_features()", lists the
+  // model input features not used by any tree, and that the caller does not
+  // need to fill in the example set.
+  std::vector<int> UnusedColumns(absl::Span<const int> columns) const;
+
   const std::vector<FeatureDef>& fixed_length_features() const {
     return fixed_length_features_;
   }
@@ -1157,6 +1163,13 @@ class ExampleSetNumericalOrCategoricalFlat : public AbstractExampleSet {
     return Copy(begin, end, features, casted_dst);
   }
 
+  // Copies the examples "example_idxs" of "this" example set to the examples
+  // [0, example_idxs.size()) of "dst". Only fixed-length features are
+  // supported.
+  absl::Status Gather(
+      absl::Span<const int> example_idxs, const FeaturesDefinition& features,
+      ExampleSetNumericalOrCategoricalFlat<Model, format>* dst) const;
+
   // Number of examples in the example set.
   int NumberOfExamples() const { return num_examples_; }
 
@@ -1394,7 +1407,7 @@ absl::Status ExampleSetNumericalOrCategoricalFlat<Model, format>::Copy(
       if (store_na_bitmap_) {
         const auto it_src_na_bitmap =
             na_bitmap_.begin() + feature.internal_idx * NumberOfExamples();
-        std::copy(it_src_na_bitmap, it_src_na_bitmap + end,
+        std::copy(it_src_na_bitmap + begin, it_src_na_bitmap + end,
                   dst->na_bitmap_.begin() +
                       feature.internal_idx * dst->NumberOfExamples());
       }
@@ -1444,6 +1457,40 @@ absl::Status ExampleSetNumericalOrCategoricalFlat<Model, format>::Copy(
   return absl::OkStatus();
 }
 
+template <typename Model, ExampleFormat format>
+absl::Status ExampleSetNumericalOrCategoricalFlat<Model, format>::Gather(
+    const absl::Span<const int> example_idxs,
+    const FeaturesDefinition& features,
+    ExampleSetNumericalOrCategoricalFlat<Model, format>* dst) const {
+  if (dst->NumberOfExamples() < example_idxs.size()) {
+    return absl::OutOfRangeError(
+        "The destination does not contain enough examples.");
+  }
+  if (!features.categorical_set_features().empty() ||
+      !features.numerical_vector_sequence_features().empty()) {
+    return absl::UnimplementedError(
+        "Gather does not support variable length features.");
+  }
+
+  const int num_features = features.fixed_length_features().size();
+  for (int dst_example_idx = 0; dst_example_idx < example_idxs.size();
+       dst_example_idx++) {
+    const int src_example_idx = example_idxs[dst_example_idx];
+    for (int feature_idx = 0; feature_idx < num_features; feature_idx++) {
+      const auto src_index =
+          FixedLengthIndex(src_example_idx, feature_idx, features);
+      const auto dst_index =
+          dst->FixedLengthIndex(dst_example_idx, feature_idx, features);
+      dst->fixed_length_features_[dst_index] =
+          fixed_length_features_[src_index];
+      if (store_na_bitmap_) {
+        dst->na_bitmap_[dst_index] = na_bitmap_[src_index];
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
 template <typename Model, ExampleFormat format>
 absl::Status
 ExampleSetNumericalOrCategoricalFlat<Model, format>::FromProtoExample(
@@ -19,18 +19,34 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_SERVING_EXAMPLE_SET_MODEL_WRAPPER_H_
 #define YGGDRASIL_DECISION_FORESTS_SERVING_EXAMPLE_SET_MODEL_WRAPPER_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
 namespace serving {
 
 // Utility class to wrap a fast ExampleSet model into a FastGenericEngine.
+//
+// If set, "PredictColumnarCall" generates predictions directly from columnar
+// examples. If not set, or if "PredictColumnarCall" returns an "Unimplemented"
+// error, "PredictColumnar" copies the examples in an example set.
 template <typename Model,
           void (*PredictCall)(const Model&, const typename Model::ExampleSet&,
-                              int, std::vector<float>*)>
+                              int, std::vector<float>*),
+          absl::Status (*PredictColumnarCall)(const Model&,
+                                              const ColumnarExamples&,
+                                              absl::Span<float>) = nullptr>
 class ExampleSetModelWrapper : public FastEngine {
  public:
   // Loads the model in the engine. The "src" model can be discarded after that.
@@ -48,9 +64,44 @@ class ExampleSetModelWrapper : public FastEngine {
                std::vector<float>* predictions) const override {
     const auto& casted_examples =
         dynamic_cast<const typename Model::ExampleSet&>(examples);
+    if (NumParallelBlocks(num_examples) > 1) {
+      const auto status =
+          PredictInParallel(casted_examples, num_examples, predictions);
+      if (status.ok()) {
+        return;
+      }
+      // "Predict" cannot report errors. The examples are evaluated again in
+      // the calling thread.
+      LOG(WARNING) << "Multi-threaded inference failed: " << status
+                   << ". Running the inference in the calling thread.";
+    }
     PredictCall(model_, casted_examples, num_examples, predictions);
   }
 
+  absl::Status PredictColumnar(const ColumnarExamples& examples,
+                               absl::Span<float> predictions) const override {
+    if constexpr (PredictColumnarCall != nullptr) {
+      const int num_dims = NumPredictionDimension();
+      if (predictions.size() != examples.num_examples() * num_dims) {
+        return absl::InvalidArgumentError(
+            "\"predictions\" should contain num_examples x "
+            "NumPredictionDimension() values");
+      }
+      const auto status = ParallelFor(
+          examples.num_examples(),
+          [&](const int64_t begin, const int64_t end) -> absl::Status {
+            return PredictColumnarCall(
+                model_, examples.Slice(begin, end),
+                predictions.subspan(begin * num_dims,
+                                    (end - begin) * num_dims));
+          });
+      if (!absl::IsUnimplemented(status)) {
+        return status;
+      }
+    }
+    return FastEngine::PredictColumnar(examples, predictions);
+  }
+
   template <class...>
   using void_t = void;
 
@@ -72,7 +123,56 @@ class ExampleSetModelWrapper : public FastEngine {
     return model_.features();
   }
 
+  // The specialized model.
+  const Model& model() const { return model_; }
+  Model* mutable_model() { return &model_; }
+
+ protected:
+  void PredictSingleThread(const AbstractExampleSet& examples,
+                           int num_examples,
+                           std::vector<float>* predictions) const override {
+    PredictCall(model_,
+                dynamic_cast<const typename Model::ExampleSet&>(examples),
+                num_examples, predictions);
+  }
+
  private:
+  // Maximum number of examples copied at once in the scratch example set of
+  // a thread.
+  static constexpr int64_t kMaxScratchExamples = 1024;
+
+  // Splits the examples among the threads of the parallel options. Each
+  // thread copies its block of examples, "kMaxScratchExamples" at a time, in
+  // a single scratch example set, and writes its predictions in a disjoint
+  // range of "predictions". Returns the first error of the blocks, if any.
+  absl::Status PredictInParallel(const typename Model::ExampleSet& examples,
+                                 const int num_examples,
+                                 std::vector<float>* predictions) const {
+    const int num_dims = NumPredictionDimension();
+    predictions->resize(static_cast<size_t>(num_examples) * num_dims);
+    return ParallelFor(
+        num_examples,
+        [&](const int64_t block_begin,
+            const int64_t block_end) -> absl::Status {
+          const int64_t scratch_size =
+              std::min(kMaxScratchExamples, block_end - block_begin);
+          typename Model::ExampleSet scratch_examples(scratch_size, model_);
+          std::vector<float> scratch_predictions;
+          for (int64_t begin = block_begin; begin < block_end;
+               begin += scratch_size) {
+            const int64_t end = std::min(begin + scratch_size, block_end);
+            RETURN_IF_ERROR(
+                examples.Copy(begin, end, model_, &scratch_examples));
+            PredictCall(model_, scratch_examples, end - begin,
+                        &scratch_predictions);
+            std::copy(scratch_predictions.begin(),
+                      scratch_predictions.begin() + (end - begin) * num_dims,
+                      predictions->begin() + begin * num_dims);
+          }
+          return absl::OkStatus();
+        });
+  }
+
   Model model_;
 };
 
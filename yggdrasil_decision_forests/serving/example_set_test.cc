@@ -523,6 +523,14 @@ TEST_P(ExampleSetTest, HasFeature) {
   EXPECT_TRUE(ToyModel::ExampleSet::HasInputFeature("k", model));
 }
 
+TEST(ExampleSetTest, UnusedColumns) {
+  ToyModel model(/*enable_na_conditions=*/false);
+  const std::vector<int> columns = {0, 7, 1, 10, 11};
+  EXPECT_THAT(model.features().UnusedColumns(columns),
+              testing::ElementsAre(7, 10, 11));
+  EXPECT_THAT(model.features().UnusedColumns({0, 1}), testing::IsEmpty());
+}
+
 TEST_P(ExampleSetTest, GetValueMissing) {
   const bool enable_na_conditions = GetParam();
   ToyModel model(enable_na_conditions);
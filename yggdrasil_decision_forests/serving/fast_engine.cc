@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+namespace {
+// Number of examples copied in an example set at a time by the default
+// implementation of "PredictColumnar".
+constexpr int64_t kColumnarBlockSize = 1000;
+
+// The blocks of examples evaluated in parallel contain a multiple of
+// "kParallelBlockAlignment" examples i.e. 64 bytes of float predictions per
+// output dimension.
+constexpr int64_t kParallelBlockAlignment = 16;
+}  // namespace
+
+int NumParallelBlocks(const FastEngine::ParallelOptions& options,
+                      const int64_t num_examples) {
+  const auto& thread_pool = options.thread_pool;
+  if (thread_pool == nullptr || thread_pool->num_threads() == 0) {
+    return 1;
+  }
+  const int64_t min_examples_per_thread =
+      std::max<int64_t>(1, options.min_examples_per_thread);
+  // The calling thread evaluates one of the blocks.
+  const int64_t max_num_blocks = thread_pool->num_threads() + 1;
+  return static_cast<int>(std::clamp<int64_t>(
+      num_examples / min_examples_per_thread, 1, max_num_blocks));
+}
+
+absl::Status ParallelForExamples(
+    const FastEngine::ParallelOptions& options, const int64_t num_examples,
+    const std::function<absl::Status(int64_t begin, int64_t end)>& function) {
+  const int num_blocks = NumParallelBlocks(options, num_examples);
+  if (num_blocks <= 1) {
+    return function(0, num_examples);
+  }
+
+  int64_t block_size = (num_examples + num_blocks - 1) / num_blocks;
+  block_size = (block_size + kParallelBlockAlignment - 1) /
+               kParallelBlockAlignment * kParallelBlockAlignment;
+  // Because of the alignment, the actual number of blocks can be smaller than
+  // "num_blocks".
+  const int64_t num_scheduled_blocks =
+      (num_examples + block_size - 1) / block_size - 1;
+
+  utils::concurrency::Mutex status_mutex;
+  absl::Status status;
+  utils::concurrency::BlockingCounter blocker(num_scheduled_blocks);
+  for (int64_t block_idx = 0; block_idx < num_scheduled_blocks; block_idx++) {
+    const int64_t begin = block_idx * block_size;
+    const int64_t end = begin + block_size;
+    options.thread_pool->Schedule([&, begin, end]() {
+      const auto block_status = function(begin, end);
+      if (!block_status.ok()) {
+        utils::concurrency::MutexLock lock(&status_mutex);
+        status.Update(block_status);
+      }
+      blocker.DecrementCount();
+    });
+  }
+
+  // The last block is evaluated in the calling thread.
+  const auto last_block_status =
+      function(num_scheduled_blocks * block_size, num_examples);
+  blocker.Wait();
+
+  utils::concurrency::MutexLock lock(&status_mutex);
+  status.Update(last_block_status);
+  return status;
+}
+
+int FastEngine::NumParallelBlocks(const int64_t num_examples) const {
+  return serving::NumParallelBlocks(parallel_options_, num_examples);
+}
+
+absl::Status FastEngine::ParallelFor(
+    const int64_t num_examples,
+    const std::function<absl::Status(int64_t begin, int64_t end)>& function)
+    const {
+  return ParallelForExamples(parallel_options_, num_examples, function);
+}
+
+absl::Status FastEngine::PredictColumnar(const ColumnarExamples& examples,
+                                         absl::Span<float> predictions) const {
+  const int64_t num_examples = examples.num_examples();
+  const int num_dims = NumPredictionDimension();
+  if (predictions.size() != num_examples * num_dims) {
+    return absl::InvalidArgumentError(
+        "\"predictions\" should contain num_examples x "
+        "NumPredictionDimension() values");
+  }
+  if (num_examples == 0) {
+    return absl::OkStatus();
+  }
+
+  return ParallelFor(
+      num_examples,
+      [&](const int64_t block_begin, const int64_t block_end) -> absl::Status {
+        // Per-thread example set.
+        const int64_t block_size =
+            std::min(kColumnarBlockSize, block_end - block_begin);
+        auto block_examples = AllocateExamples(block_size);
+        std::vector<float> block_predictions;
+        for (int64_t begin = block_begin; begin < block_end;
+             begin += block_size) {
+          const int64_t end = std::min(begin + block_size, block_end);
+          block_examples->Clear();
+          RETURN_IF_ERROR(CopyColumnarExamplesToAbstractExampleSet(
+              examples, begin, end, features(), block_examples.get()));
+          PredictSingleThread(*block_examples, end - begin, &block_predictions);
+          std::copy(block_predictions.begin(),
+                    block_predictions.begin() + (end - begin) * num_dims,
+                    predictions.begin() + begin * num_dims);
+        }
+        return absl::OkStatus();
+      });
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
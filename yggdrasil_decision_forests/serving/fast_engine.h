@@ -27,21 +27,57 @@
 //   examples->SetNumericalFeature(...);
 //   std::vector<float> predictions;
 //   engine.Predict(examples, 1, &predictions);
+//
+// Large batches of examples can be evaluated with multiple threads:
+//   auto pool = std::make_shared<utils::concurrency::ThreadPool>(8);
+//   pool->StartWorkers();
+//   engine->SetParallelOptions({.thread_pool = pool});
 
 #ifndef YGGDRASIL_DECISION_FORESTS_SERVING_FAST_ENGINE_H_
 #define YGGDRASIL_DECISION_FORESTS_SERVING_FAST_ENGINE_H_
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "absl/status/status.h"
 #include "absl/types/span.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 
 namespace yggdrasil_decision_forests {
 namespace serving {
 
 class FastEngine {
  public:
+  // Multi-threaded evaluation of large batches of examples.
+  struct ParallelOptions {
+    // Started thread pool used to evaluate the blocks of examples. The same
+    // thread pool can be shared by multiple engines. If null, the inference
+    // runs in the calling thread.
+    //
+    // "Predict" and "PredictColumnar" should not be called from one of the
+    // threads of this pool.
+    std::shared_ptr<utils::concurrency::ThreadPool> thread_pool;
+
+    // Minimum number of examples evaluated by a thread. Batches of less than
+    // 2 x "min_examples_per_thread" examples run in the calling thread.
+    int64_t min_examples_per_thread = 512;
+  };
+
   virtual ~FastEngine() = default;
 
+  // Configures the multi-threaded inference of "Predict" and
+  // "PredictColumnar". Should not be called while the engine is in use.
+  void SetParallelOptions(ParallelOptions options) {
+    parallel_options_ = std::move(options);
+  }
+
+  const ParallelOptions& parallel_options() const { return parallel_options_; }
+
   // Allocates a set of examples. The "num_examples" argument of the "Predict"
   // method should be less or equal to the "num_examples" of "AllocateExamples".
   //
@@ -77,10 +113,23 @@ class FastEngine {
 
   // Applies the model on a set of examples.
   // After the function call, "predictions" will be of size "num_examples *
-  // NumPredictionDimension()".
+  // NumPredictionDimension()". Large batches are split among the threads of
+  // the parallel options (if any).
   virtual void Predict(const AbstractExampleSet& examples, int num_examples,
                        std::vector<float>* predictions) const = 0;
 
+  // Applies the model on a batch of examples stored column-wise (see
+  // "columnar_examples.h") and writes the predictions in "predictions".
+  //
+  // "predictions" should contain exactly "examples.num_examples() x
+  // NumPredictionDimension()" values, stored example-major. Unlike "Predict",
+  // this method does not require for the caller to copy the feature values into
+  // an example set. Engines that can read the columns directly (e.g. the
+  // generic decision forest engines) do not copy the feature values at all.
+  // Other engines copy them, block by block, into an example set.
+  virtual absl::Status PredictColumnar(const ColumnarExamples& examples,
+                                       absl::Span<float> predictions) const;
+
   // Applies the model on a set of examples and returns the index of the active
   // leaf of each tree.
   //
@@ -100,8 +149,50 @@ class FastEngine {
 
   // List of features used by the model.
   virtual const serving::FeaturesDefinition& features() const = 0;
+
+ protected:
+  // Applies the model on a set of examples in the calling thread. Engines
+  // splitting "Predict" among threads override this method to evaluate a
+  // single block.
+  virtual void PredictSingleThread(const AbstractExampleSet& examples,
+                                   int num_examples,
+                                   std::vector<float>* predictions) const {
+    Predict(examples, num_examples, predictions);
+  }
+
+  // Number of blocks "ParallelFor" splits a batch of "num_examples" examples
+  // into. Returns 1 if the batch should be evaluated in the calling thread.
+  int NumParallelBlocks(int64_t num_examples) const;
+
+  // Splits the examples [0, num_examples) into "NumParallelBlocks" contiguous
+  // blocks, and calls "function(begin, end)" on each of them in parallel. The
+  // last block runs in the calling thread. Returns once all the blocks are
+  // evaluated.
+  //
+  // Except for the last one, the blocks contain a multiple of 16 examples.
+  // Therefore, threads writing example-major float predictions of a block
+  // never write in the same cache line.
+  absl::Status ParallelFor(
+      int64_t num_examples,
+      const std::function<absl::Status(int64_t begin, int64_t end)>& function)
+      const;
+
+ private:
+  ParallelOptions parallel_options_;
 };
 
+// Number of blocks "ParallelForExamples" splits a batch of "num_examples"
+// examples into.
+int NumParallelBlocks(const FastEngine::ParallelOptions& options,
+                      int64_t num_examples);
+
+// Implementation of "FastEngine::ParallelFor" for the "options" parallel
+// options. Can be used by the tools evaluating batches of examples outside of
+// a "FastEngine" (e.g. "TreeShap").
+absl::Status ParallelForExamples(
+    const FastEngine::ParallelOptions& options, int64_t num_examples,
+    const std::function<absl::Status(int64_t begin, int64_t end)>& function);
+
 }  // namespace serving
 }  // namespace yggdrasil_decision_forests
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/columnar_examples.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/test_utils.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+// Checks the multi-threaded predictions of the fast engine of "model_name" on
+// "dataset_filename" against the generic model inference.
+void CheckParallelPredict(const absl::string_view model_name,
+                          const absl::string_view dataset_filename) {
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", model_name), &model));
+
+  dataset::VerticalDataset dataset;
+  ASSERT_OK(dataset::LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", dataset_filename)),
+      model->data_spec(), &dataset));
+
+  ASSERT_OK_AND_ASSIGN(auto engine, model->BuildFastEngine());
+  auto thread_pool = std::make_shared<utils::concurrency::ThreadPool>(4);
+  thread_pool->StartWorkers();
+  engine->SetParallelOptions(
+      {.thread_pool = thread_pool, .min_examples_per_thread = 37});
+
+  // Example set API.
+  auto examples = engine->AllocateExamples(dataset.nrow());
+  ASSERT_OK(CopyVerticalDatasetToAbstractExampleSet(
+      dataset, 0, dataset.nrow(), engine->features(), examples.get()));
+  std::vector<float> predictions;
+  engine->Predict(*examples, dataset.nrow(), &predictions);
+  utils::ExpectEqualPredictions(dataset, 0, dataset.nrow(), *model,
+                                predictions);
+
+  // Columnar API.
+  ASSERT_OK_AND_ASSIGN(const auto columnar_examples,
+                       ColumnarExamples::FromVerticalDataset(
+                           dataset, 0, dataset.nrow(), engine->features()));
+  std::vector<float> columnar_predictions(predictions.size());
+  ASSERT_OK(engine->PredictColumnar(columnar_examples,
+                                    absl::MakeSpan(columnar_predictions)));
+  EXPECT_EQ(columnar_predictions, predictions);
+}
+
+TEST(FastEngine, ParallelAdultBinaryClassGBT) {
+  CheckParallelPredict("adult_binary_class_gbdt", "adult_test.csv");
+}
+
+TEST(FastEngine, ParallelIrisMultiClassRF) {
+  CheckParallelPredict("iris_multi_class_rf", "iris.csv");
+}
+
+TEST(FastEngine, ParallelAbaloneRegressionGBT) {
+  CheckParallelPredict("abalone_regression_gbdt", "abalone.csv");
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
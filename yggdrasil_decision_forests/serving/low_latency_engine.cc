@@ -0,0 +1,124 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/low_latency_engine.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+LowLatencyEngine::Example::~Example() {
+  if (slot_ != nullptr) {
+    engine_->ReleaseSlot(slot_);
+  }
+}
+
+absl::Status LowLatencyEngine::Example::Predict(
+    absl::Span<float> predictions) {
+  const int num_dims = engine_->NumPredictionDimension();
+  if (predictions.size() != num_dims) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("\"predictions\" should contain ", num_dims,
+                     " values. Got ", predictions.size(), " values instead."));
+  }
+  // "slot_->predictions" already has the right size, so the engine does not
+  // re-allocate it.
+  engine_->engine_->Predict(*slot_->examples, /*num_examples=*/1,
+                            &slot_->predictions);
+  std::copy(slot_->predictions.begin(), slot_->predictions.end(),
+            predictions.begin());
+  return absl::OkStatus();
+}
+
+LowLatencyEngine::LowLatencyEngine(std::unique_ptr<FastEngine> engine)
+    : engine_(std::move(engine)),
+      num_prediction_dimensions_(engine_->NumPredictionDimension()) {}
+
+absl::StatusOr<std::unique_ptr<LowLatencyEngine>> LowLatencyEngine::Create(
+    std::unique_ptr<FastEngine> engine, const int num_slots) {
+  if (engine == nullptr) {
+    return absl::InvalidArgumentError("The engine is null.");
+  }
+  if (num_slots < 0) {
+    return absl::InvalidArgumentError("\"num_slots\" should be positive.");
+  }
+  auto low_latency_engine =
+      absl::WrapUnique(new LowLatencyEngine(std::move(engine)));
+  low_latency_engine->slots_.reserve(num_slots);
+  low_latency_engine->free_slots_.reserve(num_slots);
+  for (int slot_idx = 0; slot_idx < num_slots; slot_idx++) {
+    low_latency_engine->slots_.push_back(low_latency_engine->CreateSlot());
+    low_latency_engine->free_slots_.push_back(
+        low_latency_engine->slots_.back().get());
+  }
+  return low_latency_engine;
+}
+
+std::unique_ptr<LowLatencyEngine::Slot> LowLatencyEngine::CreateSlot() const {
+  auto slot = std::make_unique<Slot>();
+  slot->examples = engine_->AllocateExamples(1);
+  slot->predictions.resize(num_prediction_dimensions_);
+  return slot;
+}
+
+LowLatencyEngine::Example LowLatencyEngine::Acquire() const {
+  Slot* slot = AcquireSlot();
+  slot->examples->FillMissing(features());
+  return Example(this, slot);
+}
+
+LowLatencyEngine::Slot* LowLatencyEngine::AcquireSlot() const {
+  {
+    utils::concurrency::MutexLock lock(&mutex_);
+    if (!free_slots_.empty()) {
+      Slot* slot = free_slots_.back();
+      free_slots_.pop_back();
+      return slot;
+    }
+  }
+
+  // All the slots are in use. The new slot is allocated outside of the lock.
+  auto new_slot = CreateSlot();
+  Slot* slot = new_slot.get();
+  utils::concurrency::MutexLock lock(&mutex_);
+  slots_.push_back(std::move(new_slot));
+  free_slots_.reserve(slots_.size());
+  return slot;
+}
+
+void LowLatencyEngine::ReleaseSlot(Slot* slot) const {
+  utils::concurrency::MutexLock lock(&mutex_);
+  free_slots_.push_back(slot);
+}
+
+int LowLatencyEngine::NumSlots() const {
+  utils::concurrency::MutexLock lock(&mutex_);
+  return slots_.size();
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Low latency inference of one example at a time, for instance to score one
+// example per request in an online service.
+//
+// Using a "FastEngine" directly on a single example requires allocating an
+// example set and a prediction vector for each call (or managing a set of
+// pre-allocated buffers per thread). The "LowLatencyEngine" owns a pool of
+// single-example slots (an example set and its output buffer) which are
+// allocated once and re-used across calls. After the warm-up (i.e. once there
+// is one slot per concurrent caller), a prediction does not allocate memory.
+//
+// The feature ids should be resolved once, after the creation of the engine.
+//
+// Usage example:
+//   ASSIGN_OR_RETURN(auto fast_engine, model->BuildFastEngine());
+//   ASSIGN_OR_RETURN(auto engine,
+//                    LowLatencyEngine::Create(std::move(fast_engine)));
+//   ASSIGN_OR_RETURN(const auto age_id,
+//                    engine->features().GetNumericalFeatureId("age"));
+//
+//   // In any thread:
+//   float prediction[1];
+//   auto example = engine->Acquire();
+//   example.SetNumerical(age_id, 30.f);
+//   RETURN_IF_ERROR(example.Predict(absl::MakeSpan(prediction)));
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_LOW_LATENCY_ENGINE_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_LOW_LATENCY_ENGINE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+class LowLatencyEngine {
+ private:
+  // Pre-allocated buffers to evaluate one example.
+  struct Slot {
+    std::unique_ptr<AbstractExampleSet> examples;
+    std::vector<float> predictions;
+  };
+
+ public:
+  // Single example being evaluated. An "Example" is acquired from the engine
+  // with "LowLatencyEngine::Acquire", and its slot is released back to the
+  // engine on destruction. An "Example" should not be shared among threads.
+  //
+  // All the feature values are missing when the example is acquired.
+  class Example {
+   public:
+    Example(Example&& other) : engine_(other.engine_), slot_(other.slot_) {
+      other.slot_ = nullptr;
+    }
+    Example(const Example&) = delete;
+    Example& operator=(const Example&) = delete;
+    Example& operator=(Example&&) = delete;
+    ~Example();
+
+    void SetNumerical(FeaturesDefinition::NumericalFeatureId feature_id,
+                      float value) {
+      slot_->examples->SetNumerical(0, feature_id, value, features());
+    }
+
+    void SetBoolean(FeaturesDefinition::BooleanFeatureId feature_id,
+                    bool value) {
+      slot_->examples->SetBoolean(0, feature_id, value, features());
+    }
+
+    void SetCategorical(FeaturesDefinition::CategoricalFeatureId feature_id,
+                        int value) {
+      slot_->examples->SetCategorical(0, feature_id, value, features());
+    }
+
+    void SetCategoricalSet(
+        FeaturesDefinition::CategoricalSetFeatureId feature_id,
+        const std::vector<int>& values) {
+      slot_->examples->SetCategoricalSet(0, feature_id, values, features());
+    }
+
+    void SetMissingNumerical(
+        FeaturesDefinition::NumericalFeatureId feature_id) {
+      slot_->examples->SetMissingNumerical(0, feature_id, features());
+    }
+
+    void SetMissingBoolean(FeaturesDefinition::BooleanFeatureId feature_id) {
+      slot_->examples->SetMissingBoolean(0, feature_id, features());
+    }
+
+    void SetMissingCategorical(
+        FeaturesDefinition::CategoricalFeatureId feature_id) {
+      slot_->examples->SetMissingCategorical(0, feature_id, features());
+    }
+
+    void SetMissingCategoricalSet(
+        FeaturesDefinition::CategoricalSetFeatureId feature_id) {
+      slot_->examples->SetMissingCategoricalSet(0, feature_id, features());
+    }
+
+    // Underlying single-example example set. Can be used to set the feature
+    // types not covered by the methods above.
+    AbstractExampleSet* mutable_examples() { return slot_->examples.get(); }
+
+    // Applies the model on the example. "predictions" should contain exactly
+    // "NumPredictionDimension()" values.
+    //
+    // The feature values are not reset after the prediction i.e. the same
+    // example can be modified and evaluated again.
+    absl::Status Predict(absl::Span<float> predictions);
+
+   private:
+    friend class LowLatencyEngine;
+
+    Example(const LowLatencyEngine* engine, Slot* slot)
+        : engine_(engine), slot_(slot) {}
+
+    const FeaturesDefinition& features() const {
+      return engine_->features();
+    }
+
+    const LowLatencyEngine* engine_;
+    Slot* slot_;
+  };
+
+  // Creates a low latency engine around a fast engine. "num_slots" slots are
+  // allocated immediately. More slots are allocated if more than "num_slots"
+  // examples are acquired at the same time.
+  static absl::StatusOr<std::unique_ptr<LowLatencyEngine>> Create(
+      std::unique_ptr<FastEngine> engine, int num_slots = 1);
+
+  // Acquires an example with all the feature values missing. Thread safe.
+  Example Acquire() const;
+
+  // List of features used by the model.
+  const FeaturesDefinition& features() const { return engine_->features(); }
+
+  // Number of dimensions of the output predictions.
+  int NumPredictionDimension() const { return num_prediction_dimensions_; }
+
+  // Underlying fast engine.
+  const FastEngine& engine() const { return *engine_; }
+
+  // Number of allocated slots. Indicates the maximum number of examples that
+  // were acquired at the same time.
+  int NumSlots() const;
+
+ private:
+  explicit LowLatencyEngine(std::unique_ptr<FastEngine> engine);
+
+  // Returns a slot, allocating a new one if none is available.
+  Slot* AcquireSlot() const;
+
+  // Returns a slot previously acquired with "AcquireSlot".
+  void ReleaseSlot(Slot* slot) const;
+
+  std::unique_ptr<Slot> CreateSlot() const;
+
+  std::unique_ptr<FastEngine> engine_;
+  int num_prediction_dimensions_;
+
+  mutable utils::concurrency::Mutex mutex_;
+  // All the allocated slots.
+  mutable std::vector<std::unique_ptr<Slot>> slots_;
+  // Slots not acquired. "free_slots_" has a capacity of "slots_.size()" so
+  // releasing a slot never allocates.
+  mutable std::vector<Slot*> free_slots_;
+};
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_LOW_LATENCY_ENGINE_H_
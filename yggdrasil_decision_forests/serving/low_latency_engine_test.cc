@@ -0,0 +1,184 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/low_latency_engine.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+using test::StatusIs;
+
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
+class LowLatencyEngineTest : public ::testing::Test {
+ protected:
+  void LoadModelAndDataset(const absl::string_view model_name,
+                           const absl::string_view dataset_filename) {
+    ASSERT_OK(model::LoadModel(
+        file::JoinPath(TestDataDir(), "model", model_name), &model_));
+    ASSERT_OK(dataset::LoadVerticalDataset(
+        absl::StrCat("csv:", file::JoinPath(TestDataDir(), "dataset",
+                                            dataset_filename)),
+        model_->data_spec(), &dataset_));
+
+    // Batch predictions used as ground truth.
+    ASSERT_OK_AND_ASSIGN(auto batch_engine, model_->BuildFastEngine());
+    auto examples = batch_engine->AllocateExamples(dataset_.nrow());
+    ASSERT_OK(CopyVerticalDatasetToAbstractExampleSet(
+        dataset_, 0, dataset_.nrow(), batch_engine->features(),
+        examples.get()));
+    batch_engine->Predict(*examples, dataset_.nrow(), &expected_predictions_);
+  }
+
+  // Predicts the "example_idx"-th example of the dataset.
+  void PredictOne(const LowLatencyEngine& engine, const int example_idx,
+                  absl::Span<float> predictions) {
+    auto example = engine.Acquire();
+    ASSERT_OK(CopyVerticalDatasetToAbstractExampleSet(
+        dataset_, example_idx, example_idx + 1, engine.features(),
+        example.mutable_examples()));
+    ASSERT_OK(example.Predict(predictions));
+  }
+
+  std::unique_ptr<model::AbstractModel> model_;
+  dataset::VerticalDataset dataset_;
+  std::vector<float> expected_predictions_;
+};
+
+TEST_F(LowLatencyEngineTest, AdultBinaryClassGBT) {
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv");
+  ASSERT_OK_AND_ASSIGN(auto fast_engine, model_->BuildFastEngine());
+  ASSERT_OK_AND_ASSIGN(auto engine,
+                       LowLatencyEngine::Create(std::move(fast_engine)));
+  EXPECT_EQ(engine->NumPredictionDimension(), 1);
+
+  float prediction;
+  for (int example_idx = 0; example_idx < dataset_.nrow(); example_idx++) {
+    PredictOne(*engine, example_idx, absl::MakeSpan(&prediction, 1));
+    EXPECT_NEAR(prediction, expected_predictions_[example_idx], 1e-6f);
+  }
+  // The examples are evaluated one after the other.
+  EXPECT_EQ(engine->NumSlots(), 1);
+}
+
+TEST_F(LowLatencyEngineTest, IrisMultiClassRFWithFeatureIds) {
+  LoadModelAndDataset("iris_multi_class_rf", "iris.csv");
+  ASSERT_OK_AND_ASSIGN(auto fast_engine, model_->BuildFastEngine());
+  ASSERT_OK_AND_ASSIGN(auto engine,
+                       LowLatencyEngine::Create(std::move(fast_engine),
+                                                /*num_slots=*/0));
+  const int num_dims = engine->NumPredictionDimension();
+  EXPECT_EQ(num_dims, 3);
+
+  const std::vector<std::string> feature_names = {
+      "Sepal.Length", "Sepal.Width", "Petal.Length", "Petal.Width"};
+  std::vector<FeaturesDefinition::NumericalFeatureId> feature_ids;
+  std::vector<const dataset::VerticalDataset::NumericalColumn*> columns;
+  for (const auto& name : feature_names) {
+    ASSERT_OK_AND_ASSIGN(const auto feature_id,
+                         engine->features().GetNumericalFeatureId(name));
+    feature_ids.push_back(feature_id);
+    ASSERT_OK_AND_ASSIGN(
+        const auto* column,
+        dataset_.ColumnWithCastWithStatus<
+            dataset::VerticalDataset::NumericalColumn>(
+            dataset_.ColumnNameToColumnIdx(name)));
+    columns.push_back(column);
+  }
+
+  std::vector<float> predictions(num_dims);
+  for (int example_idx = 0; example_idx < dataset_.nrow(); example_idx++) {
+    auto example = engine->Acquire();
+    for (int feature_idx = 0; feature_idx < feature_ids.size();
+         feature_idx++) {
+      example.SetNumerical(feature_ids[feature_idx],
+                           columns[feature_idx]->values()[example_idx]);
+    }
+    ASSERT_OK(example.Predict(absl::MakeSpan(predictions)));
+    for (int dim_idx = 0; dim_idx < num_dims; dim_idx++) {
+      EXPECT_NEAR(predictions[dim_idx],
+                  expected_predictions_[example_idx * num_dims + dim_idx],
+                  1e-6f);
+    }
+  }
+  EXPECT_EQ(engine->NumSlots(), 1);
+}
+
+TEST_F(LowLatencyEngineTest, WrongPredictionSize) {
+  LoadModelAndDataset("iris_multi_class_rf", "iris.csv");
+  ASSERT_OK_AND_ASSIGN(auto fast_engine, model_->BuildFastEngine());
+  ASSERT_OK_AND_ASSIGN(auto engine,
+                       LowLatencyEngine::Create(std::move(fast_engine)));
+  float prediction;
+  auto example = engine->Acquire();
+  EXPECT_THAT(example.Predict(absl::MakeSpan(&prediction, 1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(LowLatencyEngineTest, MultiThreaded) {
+  LoadModelAndDataset("adult_binary_class_gbdt", "adult_test.csv");
+  ASSERT_OK_AND_ASSIGN(auto fast_engine, model_->BuildFastEngine());
+  ASSERT_OK_AND_ASSIGN(auto engine,
+                       LowLatencyEngine::Create(std::move(fast_engine)));
+
+  constexpr int kNumThreads = 4;
+  std::vector<float> predictions(dataset_.nrow());
+  {
+    utils::concurrency::ThreadPool pool(kNumThreads);
+    pool.StartWorkers();
+    for (int thread_idx = 0; thread_idx < kNumThreads; thread_idx++) {
+      pool.Schedule([&, thread_idx]() {
+        for (int example_idx = thread_idx; example_idx < dataset_.nrow();
+             example_idx += kNumThreads) {
+          PredictOne(*engine, example_idx,
+                     absl::MakeSpan(&predictions[example_idx], 1));
+        }
+      });
+    }
+  }
+  for (int example_idx = 0; example_idx < dataset_.nrow(); example_idx++) {
+    EXPECT_NEAR(predictions[example_idx], expected_predictions_[example_idx],
+                1e-6f);
+  }
+  EXPECT_LE(engine->NumSlots(), kNumThreads);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
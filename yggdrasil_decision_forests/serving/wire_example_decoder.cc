@@ -0,0 +1,728 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/wire_example_decoder.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+using dataset::proto::ColumnType;
+
+// Protobuf wire types.
+enum WireType {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kFixed32 = 5,
+};
+
+// Field numbers of "tensorflow::Example", "tensorflow::Features",
+// "tensorflow::Feature" and of the "*List" messages.
+constexpr int kTfExampleFeatures = 1;
+constexpr int kTfFeaturesFeature = 1;
+constexpr int kTfMapEntryKey = 1;
+constexpr int kTfMapEntryValue = 2;
+constexpr int kTfFeatureBytesList = 1;
+constexpr int kTfFeatureFloatList = 2;
+constexpr int kTfFeatureInt64List = 3;
+constexpr int kTfListValue = 1;
+
+// Field numbers of "dataset::proto::Example" and its sub-messages.
+constexpr int kExampleAttributes = 1;
+constexpr int kAttributeBoolean = 1;
+constexpr int kAttributeNumerical = 2;
+constexpr int kAttributeCategorical = 3;
+constexpr int kAttributeCategoricalSet = 6;
+constexpr int kAttributeDiscretizedNumerical = 9;
+constexpr int kAttributeNumericalVectorSequence = 11;
+constexpr int kVectorValues = 1;
+
+// Values of a feature. Small lists are stored inline.
+using FloatValues = absl::InlinedVector<float, 4>;
+using IntValues = absl::InlinedVector<int64_t, 4>;
+using BytesValues = absl::InlinedVector<absl::string_view, 4>;
+
+// Sequential reader of a serialized protobuf message.
+class WireReader {
+ public:
+  explicit WireReader(const absl::string_view data)
+      : cur_(data.data()), end_(data.data() + data.size()) {}
+
+  bool done() const { return cur_ >= end_; }
+
+  absl::Status ReadTag(int* field, int* wire_type) {
+    uint64_t tag;
+    RETURN_IF_ERROR(ReadVarint(&tag));
+    *field = static_cast<int>(tag >> 3);
+    *wire_type = static_cast<int>(tag & 7);
+    return absl::OkStatus();
+  }
+
+  absl::Status ReadVarint(uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (cur_ >= end_) {
+        return Truncated();
+      }
+      const uint8_t byte = static_cast<uint8_t>(*cur_++);
+      result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        *value = result;
+        return absl::OkStatus();
+      }
+    }
+    return absl::InvalidArgumentError("Invalid varint in serialized proto.");
+  }
+
+  absl::Status ReadFixed32(uint32_t* value) {
+    if (end_ - cur_ < 4) {
+      return Truncated();
+    }
+    // Protobuf integers are little-endian.
+    const auto* bytes = reinterpret_cast<const uint8_t*>(cur_);
+    *value = static_cast<uint32_t>(bytes[0]) |
+             (static_cast<uint32_t>(bytes[1]) << 8) |
+             (static_cast<uint32_t>(bytes[2]) << 16) |
+             (static_cast<uint32_t>(bytes[3]) << 24);
+    cur_ += 4;
+    return absl::OkStatus();
+  }
+
+  absl::Status ReadFloat(float* value) {
+    uint32_t bits;
+    RETURN_IF_ERROR(ReadFixed32(&bits));
+    std::memcpy(value, &bits, sizeof(float));
+    return absl::OkStatus();
+  }
+
+  absl::Status ReadLengthDelimited(absl::string_view* value) {
+    uint64_t length;
+    RETURN_IF_ERROR(ReadVarint(&length));
+    if (length > static_cast<uint64_t>(end_ - cur_)) {
+      return Truncated();
+    }
+    *value = absl::string_view(cur_, length);
+    cur_ += length;
+    return absl::OkStatus();
+  }
+
+  // Skips the value of a field.
+  absl::Status Skip(const int wire_type) {
+    switch (wire_type) {
+      case kVarint: {
+        uint64_t value;
+        return ReadVarint(&value);
+      }
+      case kFixed64:
+        if (end_ - cur_ < 8) {
+          return Truncated();
+        }
+        cur_ += 8;
+        return absl::OkStatus();
+      case kLengthDelimited: {
+        absl::string_view value;
+        return ReadLengthDelimited(&value);
+      }
+      case kFixed32:
+        if (end_ - cur_ < 4) {
+          return Truncated();
+        }
+        cur_ += 4;
+        return absl::OkStatus();
+      default:
+        return absl::InvalidArgumentError(
+            absl::StrCat("Unsupported wire type ", wire_type,
+                         " in serialized proto."));
+    }
+  }
+
+ private:
+  static absl::Status Truncated() {
+    return absl::InvalidArgumentError("Truncated serialized proto.");
+  }
+
+  const char* cur_;
+  const char* end_;
+};
+
+// Appends the values of a repeated float field, packed or not.
+absl::Status ReadFloats(WireReader* reader, const int wire_type,
+                        FloatValues* values) {
+  if (wire_type == kFixed32) {
+    float value;
+    RETURN_IF_ERROR(reader->ReadFloat(&value));
+    values->push_back(value);
+  } else if (wire_type == kLengthDelimited) {
+    absl::string_view packed;
+    RETURN_IF_ERROR(reader->ReadLengthDelimited(&packed));
+    if (packed.size() % 4 != 0) {
+      return absl::InvalidArgumentError("Invalid packed float values.");
+    }
+    WireReader packed_reader(packed);
+    while (!packed_reader.done()) {
+      float value;
+      RETURN_IF_ERROR(packed_reader.ReadFloat(&value));
+      values->push_back(value);
+    }
+  } else {
+    return absl::InvalidArgumentError("Unexpected wire type for floats.");
+  }
+  return absl::OkStatus();
+}
+
+// Appends the values of a repeated integer field, packed or not.
+absl::Status ReadInts(WireReader* reader, const int wire_type,
+                      IntValues* values) {
+  uint64_t value;
+  if (wire_type == kVarint) {
+    RETURN_IF_ERROR(reader->ReadVarint(&value));
+    values->push_back(static_cast<int64_t>(value));
+  } else if (wire_type == kLengthDelimited) {
+    absl::string_view packed;
+    RETURN_IF_ERROR(reader->ReadLengthDelimited(&packed));
+    WireReader packed_reader(packed);
+    while (!packed_reader.done()) {
+      RETURN_IF_ERROR(packed_reader.ReadVarint(&value));
+      values->push_back(static_cast<int64_t>(value));
+    }
+  } else {
+    return absl::InvalidArgumentError("Unexpected wire type for integers.");
+  }
+  return absl::OkStatus();
+}
+
+// Reads the values of a "tensorflow::*List" message.
+template <typename Values, typename Read>
+absl::Status ReadTfList(const absl::string_view serialized, Read read,
+                        Values* values) {
+  WireReader reader(serialized);
+  while (!reader.done()) {
+    int field, wire_type;
+    RETURN_IF_ERROR(reader.ReadTag(&field, &wire_type));
+    if (field == kTfListValue) {
+      RETURN_IF_ERROR(read(&reader, wire_type, values));
+    } else {
+      RETURN_IF_ERROR(reader.Skip(wire_type));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ReadBytes(WireReader* reader, const int wire_type,
+                       BytesValues* values) {
+  if (wire_type != kLengthDelimited) {
+    return absl::InvalidArgumentError("Unexpected wire type for bytes.");
+  }
+  absl::string_view value;
+  RETURN_IF_ERROR(reader->ReadLengthDelimited(&value));
+  values->push_back(value);
+  return absl::OkStatus();
+}
+
+absl::Status TooManyValues(const absl::string_view feature_name) {
+  return absl::InvalidArgumentError(
+      absl::StrCat("Too many values for feature: ", feature_name));
+}
+
+}  // namespace
+
+absl::StatusOr<WireExampleDecoder> WireExampleDecoder::Create(
+    const FeaturesDefinition& features) {
+  WireExampleDecoder decoder(features);
+  const auto& data_spec = features.data_spec();
+  decoder.spec_idx_to_feature_idx_.assign(data_spec.columns_size(), -1);
+
+  const auto add_feature = [&](Feature feature) -> absl::Status {
+    const int feature_idx = decoder.input_features_.size();
+    if (!decoder.feature_name_to_idx_.emplace(feature.name, feature_idx)
+             .second) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Duplicated feature name: ", feature.name));
+    }
+    if (!feature.is_unstacked) {
+      decoder.spec_idx_to_feature_idx_[feature.spec_idx] = feature_idx;
+    }
+    decoder.input_features_.push_back(std::move(feature));
+    return absl::OkStatus();
+  };
+
+  for (const auto& def : features.input_features()) {
+    Feature feature{/*.name =*/def.name,
+                    /*.type =*/def.type,
+                    /*.spec_idx =*/def.spec_idx,
+                    /*.index =*/def.internal_idx};
+    const auto& col_spec = data_spec.columns(def.spec_idx);
+    switch (def.type) {
+      case ColumnType::NUMERICAL:
+      case ColumnType::BOOLEAN:
+      case ColumnType::DISCRETIZED_NUMERICAL:
+        break;
+      case ColumnType::CATEGORICAL:
+      case ColumnType::CATEGORICAL_SET:
+        if (!col_spec.categorical().is_already_integerized()) {
+          feature.dictionary_idx = decoder.dictionaries_.size();
+          decoder.dictionaries_.emplace_back(col_spec);
+        }
+        break;
+      case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+        feature.vector_length =
+            col_spec.numerical_vector_sequence().vector_length();
+        break;
+      default:
+        return absl::InvalidArgumentError(
+            absl::StrCat("Unsupported feature type ",
+                         dataset::proto::ColumnType_Name(def.type)));
+    }
+    RETURN_IF_ERROR(add_feature(std::move(feature)));
+  }
+
+  for (const auto& unstacked : data_spec.unstackeds()) {
+    const auto unstacked_def =
+        features.FindUnstackedFeatureDefByName(unstacked.original_name());
+    if (!unstacked_def.ok()) {
+      // The unstacked feature is not used by the model.
+      continue;
+    }
+    Feature feature{
+        /*.name =*/unstacked.original_name(),
+        /*.type =*/unstacked.type(),
+        /*.spec_idx =*/unstacked_def.value()->begin_spec_idx,
+        /*.index =*/unstacked_def.value()->unstacked_index};
+    feature.is_unstacked = true;
+    RETURN_IF_ERROR(add_feature(std::move(feature)));
+  }
+
+  return decoder;
+}
+
+int32_t WireExampleDecoder::CategoricalStringToValue(
+    const Feature& feature, const absl::string_view value) const {
+  if (feature.dictionary_idx >= 0) {
+    return dictionaries_[feature.dictionary_idx].NonintegerizedLookup(value);
+  }
+
+  // Integerized categorical value.
+  int32_t int_value;
+  if (!absl::SimpleAtoi(value, &int_value) || int_value < 0 ||
+      int_value >= features_->data_spec()
+                       .columns(feature.spec_idx)
+                       .categorical()
+                       .number_of_unique_values()) {
+    return -1;
+  }
+  return int_value;
+}
+
+absl::Status WireExampleDecoder::DecodeTfExample(
+    const absl::string_view serialized, const int example_idx,
+    AbstractExampleSet* dst) const {
+  WireReader example_reader(serialized);
+  while (!example_reader.done()) {
+    int field, wire_type;
+    RETURN_IF_ERROR(example_reader.ReadTag(&field, &wire_type));
+    if (field != kTfExampleFeatures || wire_type != kLengthDelimited) {
+      RETURN_IF_ERROR(example_reader.Skip(wire_type));
+      continue;
+    }
+
+    absl::string_view serialized_features;
+    RETURN_IF_ERROR(example_reader.ReadLengthDelimited(&serialized_features));
+    WireReader features_reader(serialized_features);
+    while (!features_reader.done()) {
+      RETURN_IF_ERROR(features_reader.ReadTag(&field, &wire_type));
+      if (field != kTfFeaturesFeature || wire_type != kLengthDelimited) {
+        RETURN_IF_ERROR(features_reader.Skip(wire_type));
+        continue;
+      }
+
+      // A (feature name, feature value) map entry.
+      absl::string_view serialized_entry;
+      RETURN_IF_ERROR(features_reader.ReadLengthDelimited(&serialized_entry));
+      absl::string_view key;
+      absl::string_view value;
+      WireReader entry_reader(serialized_entry);
+      while (!entry_reader.done()) {
+        RETURN_IF_ERROR(entry_reader.ReadTag(&field, &wire_type));
+        if (field == kTfMapEntryKey && wire_type == kLengthDelimited) {
+          RETURN_IF_ERROR(entry_reader.ReadLengthDelimited(&key));
+        } else if (field == kTfMapEntryValue &&
+                   wire_type == kLengthDelimited) {
+          RETURN_IF_ERROR(entry_reader.ReadLengthDelimited(&value));
+        } else {
+          RETURN_IF_ERROR(entry_reader.Skip(wire_type));
+        }
+      }
+
+      const auto it_feature = feature_name_to_idx_.find(key);
+      if (it_feature == feature_name_to_idx_.end()) {
+        // The feature is not used by the model.
+        continue;
+      }
+      RETURN_IF_ERROR(DecodeTfFeature(input_features_[it_feature->second],
+                                      value, example_idx, dst));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WireExampleDecoder::DecodeTfFeature(
+    const Feature& feature, const absl::string_view serialized,
+    const int example_idx, AbstractExampleSet* dst) const {
+  // "kind" is the field number of the "oneof" of "tensorflow::Feature". The
+  // last set field wins.
+  int kind = 0;
+  absl::string_view list;
+  WireReader reader(serialized);
+  while (!reader.done()) {
+    int field, wire_type;
+    RETURN_IF_ERROR(reader.ReadTag(&field, &wire_type));
+    if ((field == kTfFeatureBytesList || field == kTfFeatureFloatList ||
+         field == kTfFeatureInt64List) &&
+        wire_type == kLengthDelimited) {
+      kind = field;
+      RETURN_IF_ERROR(reader.ReadLengthDelimited(&list));
+    } else {
+      RETURN_IF_ERROR(reader.Skip(wire_type));
+    }
+  }
+
+  FloatValues floats;
+  IntValues ints;
+  BytesValues bytes;
+  switch (kind) {
+    case kTfFeatureFloatList:
+      RETURN_IF_ERROR(ReadTfList(list, ReadFloats, &floats));
+      break;
+    case kTfFeatureInt64List:
+      RETURN_IF_ERROR(ReadTfList(list, ReadInts, &ints));
+      break;
+    case kTfFeatureBytesList:
+      RETURN_IF_ERROR(ReadTfList(list, ReadBytes, &bytes));
+      break;
+  }
+
+  const auto& features = *features_;
+  if (feature.is_unstacked) {
+    const FeaturesDefinition::MultiDimNumericalFeatureId feature_id{
+        feature.index};
+    switch (kind) {
+      case kTfFeatureFloatList:
+        return dst->SetMultiDimNumerical(example_idx, feature_id, floats,
+                                         features);
+      case kTfFeatureInt64List:
+        floats.assign(ints.begin(), ints.end());
+        return dst->SetMultiDimNumerical(example_idx, feature_id, floats,
+                                         features);
+      default:
+        return absl::InvalidArgumentError(
+            absl::StrCat("Feature ", feature.name, " is not numerical."));
+    }
+  }
+
+  switch (feature.type) {
+    case ColumnType::NUMERICAL:
+    case ColumnType::BOOLEAN:
+    case ColumnType::DISCRETIZED_NUMERICAL: {
+      const FeaturesDefinition::NumericalFeatureId feature_id{feature.index};
+      if (kind == kTfFeatureFloatList) {
+        if (floats.size() > 1) {
+          return TooManyValues(feature.name);
+        }
+        if (floats.size() == 1) {
+          dst->SetNumerical(example_idx, feature_id, floats[0], features);
+        }
+      } else if (kind == kTfFeatureInt64List) {
+        if (ints.size() > 1) {
+          return TooManyValues(feature.name);
+        }
+        if (ints.size() == 1) {
+          dst->SetNumerical(example_idx, feature_id, ints[0], features);
+        }
+      } else {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Feature ", feature.name, " is not numerical."));
+      }
+    } break;
+
+    case ColumnType::CATEGORICAL: {
+      const FeaturesDefinition::CategoricalFeatureId feature_id{feature.index};
+      if (kind == kTfFeatureBytesList) {
+        if (bytes.size() > 1) {
+          return TooManyValues(feature.name);
+        }
+        if (bytes.size() == 1) {
+          const int32_t value = CategoricalStringToValue(feature, bytes[0]);
+          if (value >= 0) {
+            dst->SetCategorical(example_idx, feature_id, value, features);
+          }
+        }
+      } else if (kind == kTfFeatureInt64List) {
+        if (ints.size() > 1) {
+          return TooManyValues(feature.name);
+        }
+        if (ints.size() == 1) {
+          dst->SetCategorical(example_idx, feature_id, ints[0], features);
+        }
+      } else {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Feature ", feature.name, " is not categorical."));
+      }
+    } break;
+
+    case ColumnType::CATEGORICAL_SET: {
+      const FeaturesDefinition::CategoricalSetFeatureId feature_id{
+          feature.index};
+      std::vector<int> values;
+      if (kind == kTfFeatureBytesList) {
+        values.reserve(bytes.size());
+        for (const auto value : bytes) {
+          const int32_t int_value = CategoricalStringToValue(feature, value);
+          if (int_value >= 0) {
+            values.push_back(int_value);
+          }
+        }
+        if (!bytes.empty()) {
+          dst->SetCategoricalSet(example_idx, feature_id, values, features);
+        }
+      } else if (kind == kTfFeatureInt64List) {
+        if (!ints.empty()) {
+          values.assign(ints.begin(), ints.end());
+          dst->SetCategoricalSet(example_idx, feature_id, values, features);
+        }
+      } else {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Feature ", feature.name, " is not a categorical set."));
+      }
+    } break;
+
+    default:
+      return absl::InvalidArgumentError("Non supported feature type.");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WireExampleDecoder::DecodeExample(
+    const absl::string_view serialized, const int example_idx,
+    AbstractExampleSet* dst) const {
+  for (const auto& feature : input_features_) {
+    if (!feature.is_unstacked) {
+      SetMissing(feature, example_idx, dst);
+    }
+  }
+
+  int column_idx = 0;
+  WireReader reader(serialized);
+  while (!reader.done()) {
+    int field, wire_type;
+    RETURN_IF_ERROR(reader.ReadTag(&field, &wire_type));
+    if (field != kExampleAttributes || wire_type != kLengthDelimited) {
+      RETURN_IF_ERROR(reader.Skip(wire_type));
+      continue;
+    }
+    absl::string_view attribute;
+    RETURN_IF_ERROR(reader.ReadLengthDelimited(&attribute));
+    if (column_idx < spec_idx_to_feature_idx_.size()) {
+      const int feature_idx = spec_idx_to_feature_idx_[column_idx];
+      if (feature_idx >= 0) {
+        RETURN_IF_ERROR(DecodeAttribute(input_features_[feature_idx],
+                                        attribute, example_idx, dst));
+      }
+    }
+    column_idx++;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WireExampleDecoder::DecodeAttribute(
+    const Feature& feature, const absl::string_view serialized,
+    const int example_idx, AbstractExampleSet* dst) const {
+  // "kind" is the field number of the "oneof" of the attribute. The last set
+  // field wins.
+  int kind = 0;
+  uint64_t int_value = 0;
+  float float_value = 0;
+  absl::string_view message;
+  WireReader reader(serialized);
+  while (!reader.done()) {
+    int field, wire_type;
+    RETURN_IF_ERROR(reader.ReadTag(&field, &wire_type));
+    kind = field;
+    switch (wire_type) {
+      case kVarint:
+        RETURN_IF_ERROR(reader.ReadVarint(&int_value));
+        break;
+      case kFixed32:
+        RETURN_IF_ERROR(reader.ReadFloat(&float_value));
+        break;
+      case kLengthDelimited:
+        RETURN_IF_ERROR(reader.ReadLengthDelimited(&message));
+        break;
+      default:
+        RETURN_IF_ERROR(reader.Skip(wire_type));
+        kind = 0;
+    }
+  }
+
+  // Values not matching the feature type are treated as missing, like in
+  // "FromProtoExample".
+  const auto& features = *features_;
+  switch (feature.type) {
+    case ColumnType::NUMERICAL:
+      if (kind == kAttributeNumerical) {
+        dst->SetNumerical(example_idx,
+                          FeaturesDefinition::NumericalFeatureId{feature.index},
+                          float_value, features);
+      }
+      break;
+
+    case ColumnType::BOOLEAN:
+      if (kind == kAttributeBoolean) {
+        dst->SetBoolean(example_idx,
+                        FeaturesDefinition::BooleanFeatureId{feature.index},
+                        int_value != 0, features);
+      }
+      break;
+
+    case ColumnType::DISCRETIZED_NUMERICAL:
+      if (kind == kAttributeDiscretizedNumerical) {
+        ASSIGN_OR_RETURN(
+            const float value,
+            dataset::DiscretizedNumericalToNumerical(
+                features.data_spec().columns(feature.spec_idx),
+                static_cast<int32_t>(int_value)));
+        dst->SetNumerical(example_idx,
+                          FeaturesDefinition::NumericalFeatureId{feature.index},
+                          value, features);
+      }
+      break;
+
+    case ColumnType::CATEGORICAL:
+      if (kind == kAttributeCategorical) {
+        dst->SetCategorical(
+            example_idx,
+            FeaturesDefinition::CategoricalFeatureId{feature.index},
+            static_cast<int32_t>(int_value), features);
+      }
+      break;
+
+    case ColumnType::CATEGORICAL_SET:
+      if (kind == kAttributeCategoricalSet) {
+        IntValues ints;
+        RETURN_IF_ERROR(ReadTfList(message, ReadInts, &ints));
+        const std::vector<int> values(ints.begin(), ints.end());
+        dst->SetCategoricalSet(
+            example_idx,
+            FeaturesDefinition::CategoricalSetFeatureId{feature.index},
+            values, features);
+      }
+      break;
+
+    case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+      if (kind == kAttributeNumericalVectorSequence) {
+        FloatValues values;
+        WireReader vectors_reader(message);
+        while (!vectors_reader.done()) {
+          int field, wire_type;
+          RETURN_IF_ERROR(vectors_reader.ReadTag(&field, &wire_type));
+          if (field != kVectorValues || wire_type != kLengthDelimited) {
+            RETURN_IF_ERROR(vectors_reader.Skip(wire_type));
+            continue;
+          }
+          absl::string_view vector;
+          RETURN_IF_ERROR(vectors_reader.ReadLengthDelimited(&vector));
+          const size_t num_values = values.size();
+          RETURN_IF_ERROR(ReadTfList(vector, ReadFloats, &values));
+          if (values.size() - num_values != feature.vector_length) {
+            return absl::InvalidArgumentError(absl::StrCat(
+                "Feature ", feature.name, " expects vectors of ",
+                feature.vector_length, " values. Got ",
+                values.size() - num_values, " values instead."));
+          }
+        }
+        dst->SetNumericalVectorSequence(
+            example_idx,
+            FeaturesDefinition::NumericalVectorSequenceFeatureId{
+                feature.index},
+            values, features);
+      }
+      break;
+
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported feature type.",
+                       dataset::proto::ColumnType_Name(feature.type)));
+  }
+  return absl::OkStatus();
+}
+
+void WireExampleDecoder::SetMissing(const Feature& feature,
+                                    const int example_idx,
+                                    AbstractExampleSet* dst) const {
+  const auto& features = *features_;
+  switch (feature.type) {
+    case ColumnType::NUMERICAL:
+    case ColumnType::DISCRETIZED_NUMERICAL:
+      dst->SetMissingNumerical(
+          example_idx, FeaturesDefinition::NumericalFeatureId{feature.index},
+          features);
+      break;
+    case ColumnType::BOOLEAN:
+      dst->SetMissingBoolean(
+          example_idx, FeaturesDefinition::BooleanFeatureId{feature.index},
+          features);
+      break;
+    case ColumnType::CATEGORICAL:
+      dst->SetMissingCategorical(
+          example_idx, FeaturesDefinition::CategoricalFeatureId{feature.index},
+          features);
+      break;
+    case ColumnType::CATEGORICAL_SET:
+      dst->SetMissingCategoricalSet(
+          example_idx,
+          FeaturesDefinition::CategoricalSetFeatureId{feature.index},
+          features);
+      break;
+    case ColumnType::NUMERICAL_VECTOR_SEQUENCE:
+      dst->SetMissingNumericalVectorSequence(
+          example_idx,
+          FeaturesDefinition::NumericalVectorSequenceFeatureId{feature.index},
+          features);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Decodes serialized "tensorflow::Example" and "dataset::proto::Example"
+// protos directly into an example set, without parsing them into protobuf
+// messages first.
+//
+// The decoder reads the protobuf wire format in a single pass. The features
+// not used by the model are skipped without being materialized. The feature
+// names and the categorical dictionaries are indexed once, when the decoder is
+// created, so the decoding does not allocate strings or query the dataspec.
+//
+// "DecodeTfExample" is equivalent to parsing a "tensorflow::Example" and
+// calling "TfExampleToExampleSet" (see "tf_example.h"). "DecodeExample" is
+// equivalent to parsing a "dataset::proto::Example" and calling
+// "AbstractExampleSet::FromProtoExample".
+//
+// Usage example:
+//   ASSIGN_OR_RETURN(const auto decoder,
+//                    WireExampleDecoder::Create(engine->features()));
+//   auto examples = engine->AllocateExamples(1);
+//   examples->FillMissing(engine->features());
+//   RETURN_IF_ERROR(decoder.DecodeTfExample(serialized_tf_example,
+//                                           /*example_idx=*/0,
+//                                           examples.get()));
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_WIRE_EXAMPLE_DECODER_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_WIRE_EXAMPLE_DECODER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+class WireExampleDecoder {
+ public:
+  // Indexes the input features of a model. "features" should outlive the
+  // decoder.
+  static absl::StatusOr<WireExampleDecoder> Create(
+      const FeaturesDefinition& features);
+
+  // Decodes a serialized "tensorflow::Example" into the "example_idx"-th
+  // example of "dst". The features missing in "serialized" are not modified.
+  // Thread safe.
+  absl::Status DecodeTfExample(absl::string_view serialized, int example_idx,
+                               AbstractExampleSet* dst) const;
+
+  // Decodes a serialized "dataset::proto::Example" into the "example_idx"-th
+  // example of "dst". The features missing in "serialized" are set as missing.
+  // Thread safe.
+  absl::Status DecodeExample(absl::string_view serialized, int example_idx,
+                             AbstractExampleSet* dst) const;
+
+ private:
+  // An input feature of the model.
+  struct Feature {
+    // Name of the feature in a "tensorflow::Example".
+    std::string name;
+    dataset::proto::ColumnType type;
+    // Index of the feature in the dataspec.
+    int spec_idx;
+    // Index of the feature in the example set i.e. "index" of the
+    // "*FeatureId" structs.
+    int index;
+    // If true, the feature is an unstacked feature set with
+    // "SetMultiDimNumerical".
+    bool is_unstacked = false;
+    // Index in "dictionaries_" of the dictionary of categorical string values,
+    // or -1 if the feature is not a non-integerized categorical(-set) feature.
+    int dictionary_idx = -1;
+    // Number of values in a numerical vector.
+    int vector_length = 0;
+  };
+
+  explicit WireExampleDecoder(const FeaturesDefinition& features)
+      : features_(&features) {}
+
+  // Converts a categorical string into its dictionary index. Returns -1 if
+  // "value" is an invalid integerized value.
+  int32_t CategoricalStringToValue(const Feature& feature,
+                                   absl::string_view value) const;
+
+  // Decodes a serialized "tensorflow::Feature".
+  absl::Status DecodeTfFeature(const Feature& feature,
+                               absl::string_view serialized, int example_idx,
+                               AbstractExampleSet* dst) const;
+
+  // Decodes a serialized "dataset::proto::Example::Attribute".
+  absl::Status DecodeAttribute(const Feature& feature,
+                               absl::string_view serialized, int example_idx,
+                               AbstractExampleSet* dst) const;
+
+  // Sets a feature value as missing.
+  void SetMissing(const Feature& feature, int example_idx,
+                  AbstractExampleSet* dst) const;
+
+  const FeaturesDefinition* features_;
+
+  std::vector<Feature> input_features_;
+
+  // Index in "input_features_" of the features, by "tensorflow::Example"
+  // feature name.
+  absl::flat_hash_map<std::string, int> feature_name_to_idx_;
+
+  // Index in "input_features_" of the features, by dataspec column index. -1
+  // for the columns not used by the model.
+  std::vector<int> spec_idx_to_feature_idx_;
+
+  // Dictionaries of categorical string values.
+  std::vector<dataset::CategoricalDictionary> dictionaries_;
+};
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_WIRE_EXAMPLE_DECODER_H_
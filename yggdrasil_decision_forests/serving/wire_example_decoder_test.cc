@@ -0,0 +1,273 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/wire_example_decoder.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/tensorflow_no_dep/tf_example.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/tf_example.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+using test::EqualsProto;
+using test::StatusIs;
+
+dataset::proto::DataSpecification ToyDataSpec() {
+  return PARSE_TEST_PROTO(R"pb(
+    # Id:0
+    columns {
+      type: NUMERICAL
+      name: "a"
+      numerical { mean: -1 }
+    }
+
+    # Id:1
+    columns {
+      type: CATEGORICAL
+      name: "b"
+      categorical {
+        is_already_integerized: true
+        number_of_unique_values: 3
+        most_frequent_value: 0
+      }
+    }
+
+    # Id:2
+    columns {
+      type: CATEGORICAL
+      name: "c"
+      categorical {
+        is_already_integerized: false
+        number_of_unique_values: 3
+        items {
+          key: "x_c"
+          value { index: 0 }
+        }
+        items {
+          key: "y_c"
+          value { index: 1 }
+        }
+        items {
+          key: "z_c"
+          value { index: 2 }
+        }
+      }
+    }
+
+    # Id:3
+    columns {
+      type: CATEGORICAL_SET
+      name: "d"
+      categorical { is_already_integerized: true number_of_unique_values: 5 }
+    }
+
+    # Id:4
+    columns {
+      type: CATEGORICAL_SET
+      name: "e"
+      categorical {
+        is_already_integerized: false
+        number_of_unique_values: 3
+        items {
+          key: "x_d"
+          value { index: 0 }
+        }
+        items {
+          key: "y_d"
+          value { index: 1 }
+        }
+        items {
+          key: "z_d"
+          value { index: 2 }
+        }
+      }
+    }
+
+    # Id:5
+    columns { type: NUMERICAL name: "UNUSED" }
+
+    # Id:6
+    columns {
+      type: DISCRETIZED_NUMERICAL
+      name: "f"
+      numerical { mean: -1 }
+      discretized_numerical {
+        boundaries: 0
+        boundaries: 1
+        boundaries: 2
+        boundaries: 3
+      }
+    }
+
+    # Id:7
+    columns {
+      type: NUMERICAL
+      name: "g_0"
+      numerical { mean: 0 }
+      is_unstacked: true
+    }
+
+    # Id:8
+    columns {
+      type: NUMERICAL
+      name: "g_1"
+      numerical { mean: 1 }
+      is_unstacked: true
+    }
+
+    # Id:9
+    columns {
+      type: BOOLEAN
+      name: "h"
+      boolean { count_true: 5 count_false: 10 }
+    }
+
+    unstackeds {
+      original_name: "g"
+      begin_column_idx: 7
+      size: 2
+      type: NUMERICAL
+    }
+  )pb");
+}
+
+struct ToyModel : serving::EmptyModel {
+  ToyModel() {
+    CHECK_OK(Initialize({0, 1, 2, 3, 4, 6, 7, 8, 9}, ToyDataSpec()));
+  }
+};
+
+tensorflow::Example ToyTfExample() {
+  tensorflow::Example example;
+  tensorflow::SetFeatureValues({3.0f}, "a", &example);
+  tensorflow::SetFeatureValues({1}, "b", &example);
+  tensorflow::SetFeatureValues({"y_c"}, "c", &example);
+  tensorflow::SetFeatureValues({2, 3}, "d", &example);
+  tensorflow::SetFeatureValues({"y_d", "z_d", "unknown"}, "e", &example);
+  tensorflow::SetFeatureValues({5.f}, "UNUSED", &example);
+  tensorflow::SetFeatureValues({1.9}, "f", &example);
+  tensorflow::SetFeatureValues({10.f, 11.f}, "g", &example);
+  tensorflow::SetFeatureValues({1.0f}, "h", &example);
+  tensorflow::SetFeatureValues({"not", "a", "feature"}, "i", &example);
+  return example;
+}
+
+TEST(WireExampleDecoder, TfExampleSameAsTfExampleToExampleSet) {
+  ToyModel model;
+  ASSERT_OK_AND_ASSIGN(const auto decoder,
+                       WireExampleDecoder::Create(model.features()));
+
+  const tensorflow::Example example = ToyTfExample();
+  ToyModel::ExampleSet expected_examples(1, model);
+  expected_examples.FillMissing(model);
+  ASSERT_OK(TfExampleToExampleSet(example, 0, model.features(),
+                                  &expected_examples));
+
+  ToyModel::ExampleSet examples(2, model);
+  examples.FillMissing(model);
+  ASSERT_OK(decoder.DecodeTfExample(example.SerializeAsString(), 1,
+                                    &examples));
+  EXPECT_THAT(examples.ExtractProtoExample(1, model).value(),
+              EqualsProto(expected_examples.ExtractProtoExample(0, model)
+                              .value()));
+
+  // The other examples are not modified.
+  ToyModel::ExampleSet missing_examples(1, model);
+  missing_examples.FillMissing(model);
+  EXPECT_THAT(examples.ExtractProtoExample(0, model).value(),
+              EqualsProto(missing_examples.ExtractProtoExample(0, model)
+                              .value()));
+}
+
+TEST(WireExampleDecoder, TfExampleErrors) {
+  ToyModel model;
+  ASSERT_OK_AND_ASSIGN(const auto decoder,
+                       WireExampleDecoder::Create(model.features()));
+  ToyModel::ExampleSet examples(1, model);
+
+  tensorflow::Example example = ToyTfExample();
+  tensorflow::SetFeatureValues({1.0f, 2.0f}, "a", &example);
+  EXPECT_THAT(decoder.DecodeTfExample(example.SerializeAsString(), 0,
+                                      &examples),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Too many values for feature: a"));
+
+  example = ToyTfExample();
+  tensorflow::SetFeatureValues({"1.0f"}, "a", &example);
+  EXPECT_THAT(decoder.DecodeTfExample(example.SerializeAsString(), 0,
+                                      &examples),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Feature a is not numerical."));
+
+  example = ToyTfExample();
+  tensorflow::SetFeatureValues({10.f, 11.f, 12.f}, "g", &example);
+  EXPECT_THAT(decoder.DecodeTfExample(example.SerializeAsString(), 0,
+                                      &examples),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Wrong number of values."));
+
+  std::string truncated = ToyTfExample().SerializeAsString();
+  truncated.resize(truncated.size() / 2);
+  EXPECT_THAT(decoder.DecodeTfExample(truncated, 0, &examples),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(WireExampleDecoder, ExampleSameAsFromProtoExample) {
+  ToyModel model;
+  ASSERT_OK_AND_ASSIGN(const auto decoder,
+                       WireExampleDecoder::Create(model.features()));
+
+  const dataset::proto::Example example = PARSE_TEST_PROTO(
+      R"pb(
+        attributes { numerical: 3.0 }
+        attributes { categorical: 1 }
+        attributes {}
+        attributes { categorical_set { values: 2 values: 3 } }
+        attributes { categorical_set { values: 1 values: 2 } }
+        attributes { numerical: 5.0 }
+        attributes { discretized_numerical: 2 }
+        attributes { numerical: 10 }
+        attributes { numerical: 11 }
+        attributes { boolean: true }
+      )pb");
+
+  ToyModel::ExampleSet expected_examples(1, model);
+  ASSERT_OK(expected_examples.FromProtoExample(example, 0, model.features()));
+
+  ToyModel::ExampleSet examples(1, model);
+  // Set all the features, to check that the missing ones are reset.
+  ASSERT_OK(decoder.DecodeTfExample(ToyTfExample().SerializeAsString(), 0,
+                                    &examples));
+  ASSERT_OK(decoder.DecodeExample(example.SerializeAsString(), 0, &examples));
+  EXPECT_THAT(examples.ExtractProtoExample(0, model).value(),
+              EqualsProto(expected_examples.ExtractProtoExample(0, model)
+                              .value()));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -28,11 +28,13 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/fast_engine_factory.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/serving/low_latency_engine.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/concurrency_channel.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
@@ -85,6 +87,29 @@ void RunOnceEngine(const serving::FastEngine& engine, const int num_batches,
   }
 }
 
+// Evaluates all the examples one at a time. If "latencies" is not null, the
+// latency of each prediction, in nanoseconds, is appended to it.
+absl::Status RunOnceLowLatencyEngine(
+    const serving::LowLatencyEngine& engine,
+    const serving::AbstractExampleSet& examples, const int64_t num_examples,
+    absl::Span<float> predictions, std::vector<int64_t>* latencies) {
+  const int num_dims = engine.NumPredictionDimension();
+  for (int64_t example_idx = 0; example_idx < num_examples; example_idx++) {
+    const auto begin = absl::Now();
+    auto example = engine.Acquire();
+    RETURN_IF_ERROR(examples.Copy(example_idx, example_idx + 1,
+                                  engine.features(),
+                                  example.mutable_examples()));
+    RETURN_IF_ERROR(example.Predict(
+        predictions.subspan(example_idx * num_dims, num_dims)));
+    const auto end = absl::Now();
+    if (latencies) {
+      latencies->push_back(absl::ToInt64Nanoseconds(end - begin));
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::Status BenchmarkGenericSlowEngine(
@@ -351,4 +376,57 @@ absl::Status BenchmarkFastEngineMultiThreaded(
   return absl::OkStatus();
 }
 
+absl::Status BenchmarkLowLatencyEngine(
+    const BenchmarkInterfaceNumRunsOptions& options,
+    const serving::LowLatencyEngine& engine,
+    const dataset::VerticalDataset& dataset,
+    std::vector<BenchmarkLatencyResult>* results,
+    absl::string_view engine_name) {
+  STATUS_CHECK_GT(options.num_runs, 0);
+  const int64_t num_examples = dataset.nrow();
+  STATUS_CHECK_GT(num_examples, 0);
+
+  // Convert dataset into the format expected by the engine.
+  auto examples = engine.engine().AllocateExamples(num_examples);
+  RETURN_IF_ERROR(CopyVerticalDatasetToAbstractExampleSet(
+      dataset,
+      /*begin_example_idx=*/0,
+      /*end_example_idx=*/num_examples, engine.features(), examples.get()));
+
+  std::vector<float> predictions(num_examples *
+                                 engine.NumPredictionDimension());
+
+  // Warming up.
+  for (int run_idx = 0; run_idx < options.warmup_runs; run_idx++) {
+    RETURN_IF_ERROR(RunOnceLowLatencyEngine(engine, *examples, num_examples,
+                                            absl::MakeSpan(predictions),
+                                            /*latencies=*/nullptr));
+  }
+
+  // Run benchmark.
+  std::vector<int64_t> latencies;
+  latencies.reserve(options.num_runs * num_examples);
+  for (int run_idx = 0; run_idx < options.num_runs; run_idx++) {
+    RETURN_IF_ERROR(RunOnceLowLatencyEngine(engine, *examples, num_examples,
+                                            absl::MakeSpan(predictions),
+                                            &latencies));
+  }
+
+  // Save results.
+  std::sort(latencies.begin(), latencies.end());
+  const auto quantile = [&latencies](const double q) {
+    const size_t idx = std::min(
+        latencies.size() - 1, static_cast<size_t>(q * latencies.size()));
+    return absl::Nanoseconds(latencies[idx]);
+  };
+  results->push_back({/*.name =*/absl::StrCat(engine_name, " [low latency]"),
+                      /*.p50 =*/quantile(0.50),
+                      /*.p90 =*/quantile(0.90),
+                      /*.p99 =*/quantile(0.99),
+                      /*.max =*/absl::Nanoseconds(latencies.back()),
+                      /*.num_predictions =*/
+                      static_cast<int64_t>(latencies.size())});
+  return absl::OkStatus();
+}
+
 }  // namespace yggdrasil_decision_forests::utils
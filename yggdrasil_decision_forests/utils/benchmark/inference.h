@@ -27,6 +27,7 @@
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/serving/low_latency_engine.h"
 
 namespace yggdrasil_decision_forests::utils {
 
@@ -49,6 +50,16 @@ struct BenchmarkInterfaceTimingOptions {
   double warmup_duration;
 };
 
+// Latency distribution of the evaluation of individual examples.
+struct BenchmarkLatencyResult {
+  std::string name;
+  absl::Duration p50;
+  absl::Duration p90;
+  absl::Duration p99;
+  absl::Duration max;
+  int64_t num_predictions;
+};
+
 // How to run the benchmark.
 struct BenchmarkInferenceRunOptions {
   int batch_size;
@@ -84,6 +95,17 @@ absl::Status BenchmarkFastEngineMultiThreaded(const BenchmarkInferenceRunOptions
                                  std::vector<BenchmarkInferenceResult>* results,
                                  absl::string_view engine_name = "");
 
+// Benchmarks the latency of the evaluation of the examples one at a time with
+// a low latency engine. Each measure covers the acquisition of the example, the
+// copy of its feature values (a memory copy from a pre-converted example set)
+// and the inference.
+absl::Status BenchmarkLowLatencyEngine(
+    const BenchmarkInterfaceNumRunsOptions& options,
+    const serving::LowLatencyEngine& engine,
+    const dataset::VerticalDataset& dataset,
+    std::vector<BenchmarkLatencyResult>* results,
+    absl::string_view engine_name = "");
+
 }  // namespace yggdrasil_decision_forests::utils
 
 #endif  // YGGDRASIL_DECISION_FORESTS_UTILS_BENCHMARK_INFERENCE_H_
@@ -15,8 +15,14 @@
 
 #include "yggdrasil_decision_forests/utils/blob_sequence.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/base/internal/endian.h"
 #include "absl/status/status.h"
@@ -32,9 +38,76 @@ namespace utils {
 namespace blob_sequence {
 
 // See "FileHeader::version" for the definition of the versions.
-constexpr int kCurrentVersion = 1;
+constexpr int kCurrentVersion = 3;
 
-absl::StatusOr<Reader> Reader::Create(utils::InputByteStream* stream) {
+// First version with indexed gzip members.
+constexpr int kGZipMembersVersion = 2;
+
+// First version of the indexed blob sequences.
+constexpr int kIndexedVersion = 3;
+
+namespace {
+
+// Size of the working buffers used to decompress the chunks.
+constexpr size_t kWorkingBufferSize = 64 * 1024;
+
+// Uncompresses the content of a chunk.
+absl::Status DecodeChunk(const absl::string_view data,
+                         const Compression compression, std::string* chunk,
+                         std::string* working_buffer) {
+  switch (compression) {
+    case Compression::kNone:
+      chunk->assign(data.data(), data.size());
+      return absl::OkStatus();
+    case Compression::kGZIP:
+      chunk->clear();
+      working_buffer->resize(kWorkingBufferSize);
+      return Inflate(data, chunk, working_buffer);
+  }
+  return absl::InvalidArgumentError("Unknown compression");
+}
+
+// Extracts the record starting at "*begin" in "chunk", and moves "*begin" to
+// the next record.
+absl::Status NextRecordInChunk(const absl::string_view chunk, size_t* begin,
+                               std::string* blob) {
+  internal::RecordHeader header;
+  if (*begin + sizeof(header) > chunk.size()) {
+    return absl::InvalidArgumentError("Truncated record header");
+  }
+  std::memcpy(&header, chunk.data() + *begin, sizeof(header));
+  const size_t length = absl::little_endian::ToHost32(header.length);
+  *begin += sizeof(header);
+  if (*begin + length > chunk.size()) {
+    return absl::InvalidArgumentError("Truncated blob");
+  }
+  blob->assign(chunk.data() + *begin, length);
+  *begin += length;
+  return absl::OkStatus();
+}
+
+void AppendLittleEndian64(const int64_t value, std::string* dst) {
+  const uint64_t le_value = absl::little_endian::FromHost64(value);
+  dst->append(reinterpret_cast<const char*>(&le_value), sizeof(le_value));
+}
+
+// Checks that "indices" are sorted record indices in [0, num_records].
+absl::Status CheckSortedRecordIndices(const std::vector<int64_t>& indices,
+                                      const int64_t num_records) {
+  int64_t previous = 0;
+  for (const int64_t index : indices) {
+    if (index < previous || index > num_records) {
+      return absl::InvalidArgumentError("Invalid record index");
+    }
+    previous = index;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<Reader> Reader::Create(utils::InputByteStream* stream,
+                                      const int num_threads) {
   Reader reader;
   reader.raw_stream_ = stream;
 
@@ -63,12 +136,19 @@ absl::StatusOr<Reader> Reader::Create(utils::InputByteStream* stream) {
     reader.compression_ = Compression::kNone;
   }
 
+  if (reader.version_ >= kIndexedVersion) {
+    // The chunks are compressed independently.
+    return reader;
+  }
+
   switch (reader.compression_) {
     case Compression::kNone:
       break;
     case Compression::kGZIP:
       ASSIGN_OR_RETURN(reader.gzip_stream_,
-                       utils::GZipInputByteStream::Create(reader.raw_stream_));
+                       utils::GZipInputByteStream::Create(
+                           reader.raw_stream_, /*buffer_size=*/1024 * 1024,
+                           num_threads));
       break;
   }
 
@@ -76,6 +156,17 @@ absl::StatusOr<Reader> Reader::Create(utils::InputByteStream* stream) {
 }
 
 absl::StatusOr<bool> Reader::Read(std::string* blob) {
+  if (version_ >= kIndexedVersion) {
+    while (chunk_begin_ == chunk_.size()) {
+      ASSIGN_OR_RETURN(const bool has_chunk, ReadChunk());
+      if (!has_chunk) {
+        return false;
+      }
+    }
+    RETURN_IF_ERROR(NextRecordInChunk(chunk_, &chunk_begin_, blob));
+    return true;
+  }
+
   internal::RecordHeader header;
   ASSIGN_OR_RETURN(
       auto has_content,
@@ -97,6 +188,37 @@ absl::StatusOr<bool> Reader::Read(std::string* blob) {
   return true;
 }
 
+absl::StatusOr<bool> Reader::ReadChunk() {
+  if (end_of_chunks_) {
+    return false;
+  }
+  internal::ChunkHeader header;
+  ASSIGN_OR_RETURN(bool has_content,
+                   raw_stream_->ReadExactly((char*)&header,
+                                            sizeof(internal::ChunkHeader)));
+  if (!has_content) {
+    return absl::InvalidArgumentError("Truncated indexed blob sequence");
+  }
+  const uint32_t length = absl::little_endian::ToHost32(header.length);
+  if (length == 0) {
+    // The index that follows the chunks is not used by sequential reading.
+    end_of_chunks_ = true;
+    chunk_.clear();
+    chunk_begin_ = 0;
+    return false;
+  }
+  compressed_chunk_.resize(length);
+  ASSIGN_OR_RETURN(has_content,
+                   raw_stream_->ReadExactly(&compressed_chunk_[0], length));
+  if (!has_content) {
+    return absl::InvalidArgumentError("Truncated chunk");
+  }
+  RETURN_IF_ERROR(DecodeChunk(compressed_chunk_, compression_, &chunk_,
+                              &working_buffer_));
+  chunk_begin_ = 0;
+  return true;
+}
+
 absl::Status Reader::Close() {
   if (gzip_stream_) {
     RETURN_IF_ERROR(gzip_stream_->Close());
@@ -106,14 +228,20 @@ absl::Status Reader::Close() {
 }
 
 absl::StatusOr<Writer> Writer::Create(utils::OutputByteStream* stream,
-                                      Compression compression) {
+                                      Compression compression,
+                                      const size_t gzip_member_size) {
   Writer writer;
   writer.raw_stream_ = stream;
 
   internal::FileHeader header;
   header.magic[0] = 'B';
   header.magic[1] = 'S';
-  header.version = absl::little_endian::FromHost16(kCurrentVersion);
+  // Files without indexed gzip members remain readable by the readers
+  // predating them.
+  const bool use_members =
+      compression == Compression::kGZIP && gzip_member_size > 0;
+  header.version =
+      absl::little_endian::FromHost16(use_members ? kGZipMembersVersion : 1);
   header.compression = static_cast<uint8_t>(compression);
 
   RETURN_IF_ERROR(writer.raw_stream_->Write(
@@ -124,24 +252,124 @@ absl::StatusOr<Writer> Writer::Create(utils::OutputByteStream* stream,
       break;
     case Compression::kGZIP:
       ASSIGN_OR_RETURN(writer.gzip_stream_,
-                       utils::GZipOutputByteStream::Create(writer.raw_stream_));
+                       utils::GZipOutputByteStream::Create(
+                           writer.raw_stream_, Z_DEFAULT_COMPRESSION,
+                           /*buffer_size=*/1024 * 1024, /*raw_deflate=*/false,
+                           gzip_member_size));
       break;
   }
 
   return writer;
 }
 
+absl::StatusOr<Writer> Writer::CreateIndexed(utils::OutputByteStream* stream,
+                                             Compression compression,
+                                             const size_t chunk_size) {
+  Writer writer;
+  writer.raw_stream_ = stream;
+  writer.indexed_ = true;
+  writer.compression_ = compression;
+  writer.chunk_size_ = std::max<size_t>(chunk_size, 1);
+
+  internal::FileHeader header;
+  header.magic[0] = 'B';
+  header.magic[1] = 'S';
+  header.version = absl::little_endian::FromHost16(kIndexedVersion);
+  header.compression = static_cast<uint8_t>(compression);
+  RETURN_IF_ERROR(writer.raw_stream_->Write(
+      absl::string_view((char*)&header, sizeof(internal::FileHeader))));
+  writer.offset_ = sizeof(internal::FileHeader);
+  return writer;
+}
+
 absl::Status Writer::Write(const absl::string_view blob) {
   internal::RecordHeader header;
   header.length = absl::little_endian::FromHost32(blob.size());
 
+  if (indexed_) {
+    chunk_.append((char*)&header, sizeof(internal::RecordHeader));
+    chunk_.append(blob.data(), blob.size());
+    chunk_num_records_++;
+    num_records_++;
+    if (chunk_.size() >= chunk_size_) {
+      return WriteChunk();
+    }
+    return absl::OkStatus();
+  }
+
   RETURN_IF_ERROR(stream().Write(
       absl::string_view((char*)&header, sizeof(internal::RecordHeader))));
 
   return stream().Write(blob);
 }
 
+absl::Status Writer::WriteChunk() {
+  if (chunk_num_records_ == 0) {
+    return absl::OkStatus();
+  }
+  std::string compressed_chunk;
+  absl::string_view data = chunk_;
+  if (compression_ == Compression::kGZIP) {
+    StringOutputByteStream compressed_stream;
+    ASSIGN_OR_RETURN(auto gzip_stream,
+                     utils::GZipOutputByteStream::Create(&compressed_stream));
+    RETURN_IF_ERROR(gzip_stream->Write(chunk_));
+    RETURN_IF_ERROR(gzip_stream->Close());
+    compressed_chunk = std::string(compressed_stream.ToString());
+    data = compressed_chunk;
+  }
+  if (data.size() > std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError("Too large chunk");
+  }
+
+  internal::ChunkHeader header;
+  header.length = absl::little_endian::FromHost32(data.size());
+  header.num_records = absl::little_endian::FromHost32(chunk_num_records_);
+  RETURN_IF_ERROR(raw_stream_->Write(
+      absl::string_view((char*)&header, sizeof(internal::ChunkHeader))));
+  RETURN_IF_ERROR(raw_stream_->Write(data));
+
+  chunk_offsets_.push_back(offset_);
+  chunk_begins_.push_back(num_records_ - chunk_num_records_);
+  offset_ += sizeof(internal::ChunkHeader) + data.size();
+  chunk_.clear();
+  chunk_num_records_ = 0;
+  return absl::OkStatus();
+}
+
 absl::Status Writer::Close() {
+  if (indexed_) {
+    indexed_ = false;
+    RETURN_IF_ERROR(WriteChunk());
+
+    // End of the chunks.
+    internal::ChunkHeader end_header;
+    end_header.length = 0;
+    end_header.num_records = 0;
+    RETURN_IF_ERROR(raw_stream_->Write(
+        absl::string_view((char*)&end_header, sizeof(internal::ChunkHeader))));
+    offset_ += sizeof(internal::ChunkHeader);
+
+    std::string index;
+    AppendLittleEndian64(chunk_offsets_.size(), &index);
+    AppendLittleEndian64(group_begins_.size(), &index);
+    AppendLittleEndian64(num_records_, &index);
+    for (const auto* values : {&chunk_offsets_, &chunk_begins_,
+                               &group_begins_}) {
+      for (const int64_t value : *values) {
+        AppendLittleEndian64(value, &index);
+      }
+    }
+    RETURN_IF_ERROR(raw_stream_->Write(index));
+
+    internal::IndexFooter footer;
+    footer.index_offset = absl::little_endian::FromHost64(offset_);
+    footer.index_length = absl::little_endian::FromHost32(index.size());
+    std::memcpy(footer.magic, "BSIX", 4);
+    return raw_stream_->Write(
+        absl::string_view((char*)&footer, sizeof(internal::IndexFooter)));
+  }
+
   if (gzip_stream_) {
     RETURN_IF_ERROR(gzip_stream_->Close());
     gzip_stream_.reset();
@@ -149,6 +377,185 @@ absl::Status Writer::Close() {
   return absl::OkStatus();
 }
 
+absl::StatusOr<std::unique_ptr<IndexedReader>> IndexedReader::Open(
+    const absl::string_view content) {
+  auto reader = std::unique_ptr<IndexedReader>(new IndexedReader());
+  reader->content_ = content;
+
+  internal::FileHeader header;
+  if (content.size() <
+      sizeof(internal::FileHeader) + sizeof(internal::IndexFooter)) {
+    return absl::InvalidArgumentError("Not an indexed blob sequence");
+  }
+  std::memcpy(&header, content.data(), sizeof(header));
+  if (header.magic[0] != 'B' || header.magic[1] != 'S') {
+    return absl::InvalidArgumentError("Invalid header");
+  }
+  const uint16_t version = absl::little_endian::ToHost16(header.version);
+  if (version < kIndexedVersion) {
+    return absl::InvalidArgumentError("Not an indexed blob sequence");
+  }
+  if (version > kCurrentVersion) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The blob sequence file's version ($0) is greater than "
+        "the blob sequence library ($1). Update your code.",
+        version, kCurrentVersion));
+  }
+  reader->compression_ = static_cast<Compression>(header.compression);
+
+  internal::IndexFooter footer;
+  std::memcpy(&footer, content.data() + content.size() - sizeof(footer),
+              sizeof(footer));
+  if (std::memcmp(footer.magic, "BSIX", 4) != 0) {
+    return absl::InvalidArgumentError("Invalid index footer");
+  }
+  // The index is stored just before the footer.
+  const uint32_t index_length =
+      absl::little_endian::ToHost32(footer.index_length);
+  if (index_length % sizeof(uint64_t) != 0 ||
+      index_length > content.size() - sizeof(internal::FileHeader) -
+                         sizeof(footer)) {
+    return absl::InvalidArgumentError("Invalid index");
+  }
+  const uint64_t index_offset = content.size() - sizeof(footer) - index_length;
+  if (absl::little_endian::ToHost64(footer.index_offset) != index_offset) {
+    return absl::InvalidArgumentError("Invalid index");
+  }
+  reader->index_offset_ = index_offset;
+
+  std::vector<int64_t> index(index_length / sizeof(uint64_t));
+  std::memcpy(index.data(), content.data() + index_offset, index_length);
+  for (auto& value : index) {
+    value = absl::little_endian::ToHost64(value);
+  }
+  if (index.size() < 3) {
+    return absl::InvalidArgumentError("Invalid index");
+  }
+  const int64_t num_chunks = index[0];
+  const int64_t num_groups = index[1];
+  reader->num_records_ = index[2];
+  if (num_chunks < 0 || num_groups < 0 || reader->num_records_ < 0 ||
+      num_chunks > static_cast<int64_t>(index.size()) ||
+      num_groups > static_cast<int64_t>(index.size()) ||
+      index.size() != 3 + 2 * num_chunks + num_groups) {
+    return absl::InvalidArgumentError("Invalid index");
+  }
+  auto it = index.begin() + 3;
+  reader->chunk_offsets_.assign(it, it + num_chunks);
+  it += num_chunks;
+  reader->chunk_begins_.assign(it, it + num_chunks);
+  it += num_chunks;
+  reader->group_begins_.assign(it, it + num_groups);
+
+  for (const int64_t offset : reader->chunk_offsets_) {
+    if (offset < static_cast<int64_t>(sizeof(internal::FileHeader)) ||
+        offset + sizeof(internal::ChunkHeader) > index_offset) {
+      return absl::InvalidArgumentError("Invalid chunk offset");
+    }
+  }
+  // The chunks cover all the records, in order.
+  if (num_chunks == 0 ? reader->num_records_ != 0
+                      : reader->chunk_begins_.front() != 0) {
+    return absl::InvalidArgumentError("Invalid chunk records");
+  }
+  RETURN_IF_ERROR(CheckSortedRecordIndices(reader->chunk_begins_,
+                                           reader->num_records_));
+  RETURN_IF_ERROR(CheckSortedRecordIndices(reader->group_begins_,
+                                           reader->num_records_));
+  return reader;
+}
+
+absl::StatusOr<std::pair<int64_t, int64_t>> IndexedReader::ChunkRecords(
+    const int64_t chunk_idx) const {
+  if (chunk_idx < 0 || chunk_idx >= num_chunks()) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Invalid chunk index $0", chunk_idx));
+  }
+  const int64_t end = chunk_idx + 1 < num_chunks()
+                          ? chunk_begins_[chunk_idx + 1]
+                          : num_records_;
+  return std::make_pair(chunk_begins_[chunk_idx], end);
+}
+
+absl::StatusOr<std::pair<int64_t, int64_t>> IndexedReader::GroupRecords(
+    const int64_t group_idx) const {
+  if (group_idx < 0 || group_idx >= num_groups()) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Invalid group index $0", group_idx));
+  }
+  const int64_t end = group_idx + 1 < num_groups()
+                          ? group_begins_[group_idx + 1]
+                          : num_records_;
+  return std::make_pair(group_begins_[group_idx], end);
+}
+
+absl::Status IndexedReader::ReadChunk(
+    const int64_t chunk_idx, std::vector<std::string>* records) const {
+  ASSIGN_OR_RETURN(const auto range, ChunkRecords(chunk_idx));
+  const int64_t offset = chunk_offsets_[chunk_idx];
+  internal::ChunkHeader header;
+  std::memcpy(&header, content_.data() + offset, sizeof(header));
+  const uint32_t length = absl::little_endian::ToHost32(header.length);
+  const uint32_t num_records =
+      absl::little_endian::ToHost32(header.num_records);
+  if (offset + sizeof(header) + length > index_offset_) {
+    return absl::InvalidArgumentError("Truncated chunk");
+  }
+  if (num_records != range.second - range.first) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The chunk $0 contains $1 records while the index expects $2",
+        chunk_idx, num_records, range.second - range.first));
+  }
+
+  std::string chunk;
+  std::string working_buffer;
+  RETURN_IF_ERROR(
+      DecodeChunk(content_.substr(offset + sizeof(header), length),
+                  compression_, &chunk, &working_buffer));
+  records->resize(num_records);
+  size_t begin = 0;
+  for (auto& record : *records) {
+    RETURN_IF_ERROR(NextRecordInChunk(chunk, &begin, &record));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status IndexedReader::ReadRecords(
+    const int64_t begin, const int64_t end,
+    std::vector<std::string>* records) const {
+  records->clear();
+  if (begin < 0 || begin > end || end > num_records_) {
+    return absl::InvalidArgumentError("Invalid record range");
+  }
+  if (begin == end) {
+    return absl::OkStatus();
+  }
+  // Index of the chunk containing the "begin"-th record. Since the first chunk
+  // starts at record 0, "chunk_idx" is not negative.
+  int64_t chunk_idx =
+      std::upper_bound(chunk_begins_.begin(), chunk_begins_.end(), begin) -
+      chunk_begins_.begin() - 1;
+  std::vector<std::string> chunk_records;
+  for (; chunk_idx < num_chunks(); chunk_idx++) {
+    ASSIGN_OR_RETURN(const auto range, ChunkRecords(chunk_idx));
+    if (range.first >= end) {
+      break;
+    }
+    RETURN_IF_ERROR(ReadChunk(chunk_idx, &chunk_records));
+    for (int64_t record_idx = std::max(begin, range.first);
+         record_idx < std::min(end, range.second); record_idx++) {
+      records->push_back(std::move(chunk_records[record_idx - range.first]));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status IndexedReader::ReadGroup(
+    const int64_t group_idx, std::vector<std::string>* records) const {
+  ASSIGN_OR_RETURN(const auto range, GroupRecords(group_idx));
+  return ReadRecords(range.first, range.second, records);
+}
+
 }  // namespace blob_sequence
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
@@ -35,12 +35,26 @@
 //   CHECK_OK(reader.Close());
 //   CHECK_OK(input_stream->Close());
 //
+// Indexed blob sequences (created with "Writer::CreateIndexed") store the
+// blobs in independently compressed chunks followed by an index of the chunks
+// and of the groups of blobs (e.g. the nodes of a tree). Indexed blob
+// sequences can be read sequentially with "Reader", or randomly and in
+// parallel with "IndexedReader":
+//
+//   auto file = utils::MemoryMappedFile::Open(path).value();
+//   auto reader = blob_sequence::IndexedReader::Open(file->data()).value();
+//   std::vector<std::string> blobs;
+//   CHECK_OK(reader->ReadGroup(/*group_idx=*/5, &blobs));
+//
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_BLOB_SEQUENCE_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_BLOB_SEQUENCE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -61,7 +75,10 @@ enum class Compression : uint8_t {
 class Reader {
  public:
   // Creates a reader attached to a stream. Does not take ownership of "stream".
-  static absl::StatusOr<Reader> Create(utils::InputByteStream* stream);
+  // If the blobs are compressed in indexed gzip members (see "Writer::Create"),
+  // the members are decompressed with "num_threads" threads.
+  static absl::StatusOr<Reader> Create(utils::InputByteStream* stream,
+                                       int num_threads = 1);
 
   // Creates a non attached reader.
   Reader() {}
@@ -69,6 +86,9 @@ class Reader {
   // Reads the next blob. Return false iff no more blobs are available.
   absl::StatusOr<bool> Read(std::string* blob);
 
+  // Version of the format of the stream.
+  uint16_t version() const { return version_; }
+
   // Closes the reader. Does not close the stream (passed in the constructor)
   // Should be called BEFORE the stream is closed (if the stream has the concept
   // of being closed).
@@ -79,12 +99,78 @@ class Reader {
     return gzip_stream_ ? *gzip_stream_ : *raw_stream_;
   }
 
+  // Loads the next chunk of an indexed blob sequence in "chunk_". Returns
+  // false if all the chunks have been read.
+  absl::StatusOr<bool> ReadChunk();
+
   // Non-owned input stream.
   InputByteStream* raw_stream_ = nullptr;
   // gzip decoder is the file is compressed.
   std::unique_ptr<utils::GZipInputByteStream> gzip_stream_;
   uint16_t version_;
   Compression compression_;
+
+  // Indexed blob sequences only.
+  //
+  // Uncompressed records of the current chunk and position of the next record.
+  std::string chunk_;
+  size_t chunk_begin_ = 0;
+  // True once the last chunk has been read.
+  bool end_of_chunks_ = false;
+  std::string compressed_chunk_;
+  std::string working_buffer_;
+};
+
+// Random access reader of an indexed blob sequence. The chunks are
+// decompressed on demand.
+//
+// This class is thread-safe.
+class IndexedReader {
+ public:
+  // Opens an indexed blob sequence stored in memory (e.g. in a memory-mapped
+  // file). Does not take ownership of "content" that should outlive the
+  // reader.
+  static absl::StatusOr<std::unique_ptr<IndexedReader>> Open(
+      absl::string_view content);
+
+  int64_t num_records() const { return num_records_; }
+  int64_t num_chunks() const { return chunk_offsets_.size(); }
+  int64_t num_groups() const { return group_begins_.size(); }
+
+  // Range [begin, end) of the records of the "chunk_idx"-th chunk.
+  absl::StatusOr<std::pair<int64_t, int64_t>> ChunkRecords(
+      int64_t chunk_idx) const;
+
+  // Range [begin, end) of the records of the "group_idx"-th group. The records
+  // before the first group, if any, are not part of a group.
+  absl::StatusOr<std::pair<int64_t, int64_t>> GroupRecords(
+      int64_t group_idx) const;
+
+  // Reads the records of the "chunk_idx"-th chunk into "records".
+  absl::Status ReadChunk(int64_t chunk_idx,
+                         std::vector<std::string>* records) const;
+
+  // Reads the records [begin, end) into "records".
+  absl::Status ReadRecords(int64_t begin, int64_t end,
+                           std::vector<std::string>* records) const;
+
+  // Reads the records of the "group_idx"-th group into "records".
+  absl::Status ReadGroup(int64_t group_idx,
+                         std::vector<std::string>* records) const;
+
+ private:
+  IndexedReader() = default;
+
+  absl::string_view content_;
+  Compression compression_;
+  // Offset of the index in "content_", i.e. end of the chunks.
+  uint64_t index_offset_ = 0;
+  int64_t num_records_ = 0;
+  // Offset in "content_" and index of the first record of each chunk.
+  std::vector<int64_t> chunk_offsets_;
+  std::vector<int64_t> chunk_begins_;
+  // Index of the first record of each group.
+  std::vector<int64_t> group_begins_;
 };
 
 // Blog sequence writer.
@@ -92,9 +178,25 @@ class Writer {
  public:
   // Creates a writer attached to a stream.  Does not take ownership of
   // "stream".
+  //
+  // If "compression" is kGZIP and "gzip_member_size" is non-zero, the blobs are
+  // compressed in indexed gzip members of "gzip_member_size" bytes that can be
+  // decompressed in parallel (see "utils::GZipOutputByteStream::Create").
   static absl::StatusOr<Writer> Create(
       utils::OutputByteStream* stream,
-      Compression compression = Compression::kNone);
+      Compression compression = Compression::kNone,
+      size_t gzip_member_size = 0);
+
+  // Creates a writer of an indexed blob sequence. The blobs are accumulated in
+  // chunks of approximately "chunk_size" bytes that are compressed
+  // independently. The index of the chunks and groups is written by "Close".
+  //
+  // Note: Versions of "Reader" older than the indexed blob sequences cannot
+  // read them.
+  static absl::StatusOr<Writer> CreateIndexed(
+      utils::OutputByteStream* stream,
+      Compression compression = Compression::kGZIP,
+      size_t chunk_size = 1024 * 1024);
 
   // Creates a non attached writer.
   Writer() {}
@@ -102,6 +204,15 @@ class Writer {
   // Writes a blob.
   absl::Status Write(absl::string_view blob);
 
+  // Starts a new group of blobs i.e. the next blob is the first blob of a new
+  // group. The groups are recorded in the index of the indexed blob sequences,
+  // and ignored otherwise.
+  void StartGroup() {
+    if (indexed_) {
+      group_begins_.push_back(num_records_);
+    }
+  }
+
   // Closes the writer. Does not close the stream passed in the constructor.
   // Should be called BEFORE the stream is closed (if the stream has the concept
   // of being closed).
@@ -112,10 +223,28 @@ class Writer {
     return gzip_stream_ ? *gzip_stream_ : *raw_stream_;
   }
 
+  // Compresses and writes "chunk_".
+  absl::Status WriteChunk();
+
   // Non-owned output stream.
   OutputByteStream* raw_stream_ = nullptr;
   // gzip encoder is the file is compressed.
   std::unique_ptr<utils::GZipOutputByteStream> gzip_stream_;
+
+  // Indexed blob sequences only.
+  bool indexed_ = false;
+  Compression compression_ = Compression::kNone;
+  size_t chunk_size_ = 0;
+  // Records of the current chunk.
+  std::string chunk_;
+  int64_t chunk_num_records_ = 0;
+  int64_t num_records_ = 0;
+  // Number of bytes written in "raw_stream_".
+  int64_t offset_ = 0;
+  // See "IndexedReader".
+  std::vector<int64_t> chunk_offsets_;
+  std::vector<int64_t> chunk_begins_;
+  std::vector<int64_t> group_begins_;
 };
 
 namespace internal {
@@ -130,6 +259,11 @@ struct FileHeader {
   // Version:
   //   0: Initial version.
   //   1: Add support for gzip compression.
+  //   2: The gzip compressed data is made of indexed gzip members. Only used
+  //      when the members are enabled.
+  //   3: Indexed blob sequence: The records are stored in chunks (see
+  //      "ChunkHeader") followed by an index (see "IndexFooter"). Only used
+  //      by "Writer::CreateIndexed".
   uint16_t version;
 
   // Compression.
@@ -148,6 +282,32 @@ struct RecordHeader {
   uint32_t length;
 };
 
+// Chunk header of the indexed blob sequences. The header is followed by the
+// "length" bytes of the chunk. The chunk contains "num_records" records (i.e.
+// "RecordHeader" and blob), compressed with the compression of the file.
+//
+// The last chunk is followed by an empty chunk header (i.e. length=0 and
+// num_records=0), the index, and the "IndexFooter".
+//
+// The index is a sequence of little endian uint64:
+//   num_chunks, num_groups, num_records,
+//   offset of each chunk header in the file,
+//   index of the first record of each chunk,
+//   index of the first record of each group.
+struct ChunkHeader {
+  uint32_t length;
+  uint32_t num_records;
+};
+
+// Last bytes of an indexed blob sequence.
+struct IndexFooter {
+  // Offset and size of the index in the file.
+  uint64_t index_offset;
+  uint32_t index_length;
+  // Should be 'BSIX'.
+  uint8_t magic[4];
+};
+
 };  // namespace internal
 
 }  // namespace blob_sequence
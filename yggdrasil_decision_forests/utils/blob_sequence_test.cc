@@ -15,13 +15,21 @@
 
 #include "yggdrasil_decision_forests/utils/blob_sequence.h"
 
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/base/internal/endian.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
+#include "yggdrasil_decision_forests/utils/bytestream.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 #include "yggdrasil_decision_forests/utils/testing_macros.h"
@@ -34,6 +42,8 @@ namespace {
 TEST(BlobSequence, BlockSize) {
   EXPECT_EQ(sizeof(internal::FileHeader), 8);
   EXPECT_EQ(sizeof(internal::RecordHeader), 4);
+  EXPECT_EQ(sizeof(internal::ChunkHeader), 8);
+  EXPECT_EQ(sizeof(internal::IndexFooter), 16);
 }
 
 SIMPLE_PARAMETERIZED_TEST(BlobSequence_Base, Compression,
@@ -67,6 +77,247 @@ SIMPLE_PARAMETERIZED_TEST(BlobSequence_Base, Compression,
   CHECK_OK(input_stream->Close());
 }
 
+TEST(BlobSequence, GZipMembers) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence_members.bin");
+  const int num_blobs = 10000;
+  const auto blob_value = [](const int blob_idx) {
+    return absl::StrCat("BLOB_", blob_idx);
+  };
+
+  ASSERT_OK_AND_ASSIGN(auto output_stream, file::OpenOutputFile(path));
+  ASSERT_OK_AND_ASSIGN(
+      auto writer,
+      blob_sequence::Writer::Create(output_stream.get(), Compression::kGZIP,
+                                    /*gzip_member_size=*/1000));
+  for (int blob_idx = 0; blob_idx < num_blobs; blob_idx++) {
+    CHECK_OK(writer.Write(blob_value(blob_idx)));
+  }
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  for (const int num_threads : {1, 4}) {
+    ASSERT_OK_AND_ASSIGN(auto input_stream, file::OpenInputFile(path));
+    ASSERT_OK_AND_ASSIGN(
+        auto reader, blob_sequence::Reader::Create(input_stream.get(),
+                                                   num_threads));
+    std::string blob;
+    for (int blob_idx = 0; blob_idx < num_blobs; blob_idx++) {
+      CHECK(reader.Read(&blob).value());
+      CHECK_EQ(blob, blob_value(blob_idx));
+    }
+    CHECK(!reader.Read(&blob).value());
+    CHECK_OK(reader.Close());
+    CHECK_OK(input_stream->Close());
+  }
+}
+
+SIMPLE_PARAMETERIZED_TEST(BlobSequence_Indexed, Compression,
+                          {Compression::kNone, Compression::kGZIP}) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence_index.bin");
+  const int num_groups = 100;
+  const auto blob_value = [](const int group_idx, const int blob_idx) {
+    return absl::StrCat("BLOB_", group_idx, "_", blob_idx);
+  };
+
+  // The i-th group contains i blobs.
+  ASSERT_OK_AND_ASSIGN(auto output_stream, file::OpenOutputFile(path));
+  ASSERT_OK_AND_ASSIGN(auto writer, blob_sequence::Writer::CreateIndexed(
+                                        output_stream.get(), GetParam(),
+                                        /*chunk_size=*/500));
+  CHECK_OK(writer.Write("NOT_IN_A_GROUP"));
+  for (int group_idx = 0; group_idx < num_groups; group_idx++) {
+    writer.StartGroup();
+    for (int blob_idx = 0; blob_idx < group_idx; blob_idx++) {
+      CHECK_OK(writer.Write(blob_value(group_idx, blob_idx)));
+    }
+  }
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  // Sequential reading.
+  ASSERT_OK_AND_ASSIGN(auto input_stream, file::OpenInputFile(path));
+  ASSERT_OK_AND_ASSIGN(auto reader,
+                       blob_sequence::Reader::Create(input_stream.get()));
+  std::string blob;
+  CHECK(reader.Read(&blob).value());
+  CHECK_EQ(blob, "NOT_IN_A_GROUP");
+  for (int group_idx = 0; group_idx < num_groups; group_idx++) {
+    for (int blob_idx = 0; blob_idx < group_idx; blob_idx++) {
+      CHECK(reader.Read(&blob).value());
+      CHECK_EQ(blob, blob_value(group_idx, blob_idx));
+    }
+  }
+  CHECK(!reader.Read(&blob).value());
+  CHECK_OK(reader.Close());
+  CHECK_OK(input_stream->Close());
+
+  // Random access.
+  ASSERT_OK_AND_ASSIGN(const std::string content, file::GetContent(path));
+  ASSERT_OK_AND_ASSIGN(const auto indexed_reader,
+                       blob_sequence::IndexedReader::Open(content));
+  EXPECT_EQ(indexed_reader->num_records(),
+            1 + num_groups * (num_groups - 1) / 2);
+  EXPECT_EQ(indexed_reader->num_groups(), num_groups);
+  EXPECT_GT(indexed_reader->num_chunks(), 10);
+  std::vector<std::string> blobs;
+  for (const int group_idx : {99, 0, 1, 50}) {
+    ASSERT_OK(indexed_reader->ReadGroup(group_idx, &blobs));
+    ASSERT_EQ(blobs.size(), group_idx);
+    for (int blob_idx = 0; blob_idx < group_idx; blob_idx++) {
+      EXPECT_EQ(blobs[blob_idx], blob_value(group_idx, blob_idx));
+    }
+  }
+
+  int64_t num_records = 0;
+  for (int chunk_idx = 0; chunk_idx < indexed_reader->num_chunks();
+       chunk_idx++) {
+    ASSERT_OK_AND_ASSIGN(const auto range,
+                         indexed_reader->ChunkRecords(chunk_idx));
+    EXPECT_EQ(range.first, num_records);
+    ASSERT_OK(indexed_reader->ReadChunk(chunk_idx, &blobs));
+    EXPECT_EQ(blobs.size(), range.second - range.first);
+    num_records += blobs.size();
+  }
+  EXPECT_EQ(num_records, indexed_reader->num_records());
+}
+
+// Replaces the "value_idx"-th value of the index of an indexed blob sequence.
+std::string SetIndexValue(std::string content, const int value_idx,
+                          const int64_t value) {
+  internal::IndexFooter footer;
+  std::memcpy(&footer, content.data() + content.size() - sizeof(footer),
+              sizeof(footer));
+  const uint64_t le_value = absl::little_endian::FromHost64(value);
+  std::memcpy(content.data() +
+                  absl::little_endian::ToHost64(footer.index_offset) +
+                  value_idx * sizeof(uint64_t),
+              &le_value, sizeof(le_value));
+  return content;
+}
+
+// Replaces the footer of an indexed blob sequence.
+std::string SetFooter(std::string content, const uint64_t index_offset,
+                      const uint32_t index_length) {
+  internal::IndexFooter footer;
+  const size_t footer_offset = content.size() - sizeof(footer);
+  std::memcpy(&footer, content.data() + footer_offset, sizeof(footer));
+  footer.index_offset = absl::little_endian::FromHost64(index_offset);
+  footer.index_length = absl::little_endian::FromHost32(index_length);
+  std::memcpy(content.data() + footer_offset, &footer, sizeof(footer));
+  return content;
+}
+
+TEST(BlobSequence, IndexedCorrupted) {
+  utils::StringOutputByteStream output_stream;
+  ASSERT_OK_AND_ASSIGN(auto writer, blob_sequence::Writer::CreateIndexed(
+                                        &output_stream, Compression::kNone,
+                                        /*chunk_size=*/10));
+  CHECK_OK(writer.Write("x"));
+  writer.StartGroup();
+  CHECK_OK(writer.Write("a"));
+  CHECK_OK(writer.Write("b"));
+  writer.StartGroup();
+  CHECK_OK(writer.Write("c"));
+  CHECK_OK(writer.Close());
+  const std::string content(output_stream.ToString());
+
+  ASSERT_OK_AND_ASSIGN(const auto indexed_reader,
+                       blob_sequence::IndexedReader::Open(content));
+  ASSERT_EQ(indexed_reader->num_records(), 4);
+  ASSERT_EQ(indexed_reader->num_groups(), 2);
+  const int num_chunks = indexed_reader->num_chunks();
+  ASSERT_GE(num_chunks, 2);
+
+  // Out of range accesses.
+  std::vector<std::string> blobs;
+  EXPECT_OK(indexed_reader->ReadGroup(1, &blobs));
+  EXPECT_THAT(blobs, testing::ElementsAre("c"));
+  EXPECT_FALSE(indexed_reader->ReadGroup(2, &blobs).ok());
+  EXPECT_FALSE(indexed_reader->ReadGroup(-1, &blobs).ok());
+  EXPECT_FALSE(indexed_reader->GroupRecords(2).ok());
+  EXPECT_FALSE(indexed_reader->ReadChunk(num_chunks, &blobs).ok());
+  EXPECT_FALSE(indexed_reader->ReadChunk(-1, &blobs).ok());
+  EXPECT_FALSE(indexed_reader->ReadRecords(2, 1, &blobs).ok());
+  EXPECT_FALSE(indexed_reader->ReadRecords(0, 5, &blobs).ok());
+
+  // Corrupted footers.
+  const uint64_t index_length = (3 + 2 * num_chunks + 2) * sizeof(uint64_t);
+  const uint64_t index_offset =
+      content.size() - sizeof(internal::IndexFooter) - index_length;
+  EXPECT_OK(blob_sequence::IndexedReader::Open(
+      SetFooter(content, index_offset, index_length)));
+  EXPECT_FALSE(blob_sequence::IndexedReader::Open(
+                   SetFooter(content, index_offset + 8, index_length))
+                   .ok());
+  EXPECT_FALSE(
+      blob_sequence::IndexedReader::Open(
+          SetFooter(content, std::numeric_limits<uint64_t>::max() - 8,
+                    index_length))
+          .ok());
+  EXPECT_FALSE(blob_sequence::IndexedReader::Open(
+                   SetFooter(content, index_offset, 0xFFFFFFF8))
+                   .ok());
+
+  // Corrupted indexes. The index contains: num_chunks, num_groups,
+  // num_records, the chunk offsets, the chunk begins and the group begins.
+  const int chunk_begins = 3 + num_chunks;
+  const int group_begins = 3 + 2 * num_chunks;
+  for (const auto& [value_idx, value] : std::vector<std::pair<int, int64_t>>{
+           {0, std::numeric_limits<int64_t>::max()},
+           {1, -1},
+           {2, -1},
+           {3, 0},
+           {3, static_cast<int64_t>(content.size())},
+           {chunk_begins, 1},
+           {chunk_begins + 1, 5},
+           {group_begins, 4},
+           {group_begins + 1, 5},
+       }) {
+    SCOPED_TRACE(absl::StrCat(value_idx, ":", value));
+    EXPECT_FALSE(blob_sequence::IndexedReader::Open(
+                     SetIndexValue(content, value_idx, value))
+                     .ok());
+  }
+
+  // The number of records in the index does not match the chunk headers.
+  const std::string extra_record = SetIndexValue(content, 2, 5);
+  ASSERT_OK_AND_ASSIGN(const auto extra_record_reader,
+                       blob_sequence::IndexedReader::Open(extra_record));
+  EXPECT_FALSE(
+      extra_record_reader->ReadChunk(num_chunks - 1, &blobs).ok());
+  EXPECT_FALSE(extra_record_reader->ReadGroup(1, &blobs).ok());
+}
+
+TEST(BlobSequence, IndexedEmpty) {
+  utils::StringOutputByteStream output_stream;
+  ASSERT_OK_AND_ASSIGN(auto writer,
+                       blob_sequence::Writer::CreateIndexed(&output_stream));
+  CHECK_OK(writer.Close());
+  const std::string content(output_stream.ToString());
+
+  ASSERT_OK_AND_ASSIGN(const auto indexed_reader,
+                       blob_sequence::IndexedReader::Open(content));
+  EXPECT_EQ(indexed_reader->num_records(), 0);
+  EXPECT_EQ(indexed_reader->num_chunks(), 0);
+
+  utils::StringViewInputByteStream input_stream(content);
+  ASSERT_OK_AND_ASSIGN(auto reader,
+                       blob_sequence::Reader::Create(&input_stream));
+  std::string blob;
+  CHECK(!reader.Read(&blob).value());
+
+  // Non-indexed blob sequences.
+  utils::StringOutputByteStream non_indexed_stream;
+  ASSERT_OK_AND_ASSIGN(auto non_indexed_writer,
+                       blob_sequence::Writer::Create(&non_indexed_stream));
+  CHECK_OK(non_indexed_writer.Write("HELLO"));
+  CHECK_OK(non_indexed_writer.Close());
+  EXPECT_THAT(
+      blob_sequence::IndexedReader::Open(non_indexed_stream.ToString())
+          .status(),
+      test::StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 // Make sure old blog sequence files generated by the BlobSequence_Base test can
 // still be read.
 SIMPLE_PARAMETERIZED_TEST(BlobSequence_BackwardCompatibility, std::string,
@@ -15,11 +15,18 @@
 
 #include "yggdrasil_decision_forests/utils/csv.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
@@ -55,6 +62,11 @@ bool NeedsEscape(absl::string_view field) {
   return false;
 }
 
+// Tests if a character ends a non quoted field.
+bool IsEndOfNonQuotedField(char c) {
+  return c == ',' || c == '\n' || c == '\r' || c == '"';
+}
+
 }  // namespace
 
 Reader::Reader(InputByteStream* stream) : stream_(stream) {}
@@ -106,6 +118,7 @@ absl::StatusOr<bool> Reader::NextRow(std::vector<absl::string_view>** fields) {
         break;
 
       case NON_QUOTED_FIELD:
+        RETURN_IF_ERROR(ConsumeFieldCharacters(/*quoted=*/false));
         if (CurrentChar() == ',') {
           SubmitFieldToRowCache();
           RETURN_IF_ERROR(set_state_and_consume(START));
@@ -123,6 +136,7 @@ absl::StatusOr<bool> Reader::NextRow(std::vector<absl::string_view>** fields) {
         break;
 
       case QUOTED_FIELD:
+        RETURN_IF_ERROR(ConsumeFieldCharacters(/*quoted=*/true));
         if (CurrentChar() == '"') {
           RETURN_IF_ERROR(set_state_and_consume(SECOND_QUOTE_IN_QUOTED_FIELD));
         } else if (CurrentChar() == -1) {
@@ -175,6 +189,32 @@ absl::Status Reader::ConsumeEndOfRow() {
   return absl::OkStatus();
 }
 
+absl::Status Reader::ConsumeFieldCharacters(const bool quoted) {
+  while (char_idx < buffer_size_) {
+    const char* begin = buffer_ + char_idx;
+    const char* buffer_end = buffer_ + buffer_size_;
+    const char* end;
+    if (quoted) {
+      end = static_cast<const char*>(
+          std::memchr(begin, '"', buffer_end - begin));
+      if (end == nullptr) {
+        end = buffer_end;
+      }
+    } else {
+      end = std::find_if(begin, buffer_end, IsEndOfNonQuotedField);
+    }
+    cached_row_.append(begin, end - begin);
+    if (end != buffer_end) {
+      char_idx = end - buffer_;
+      return absl::OkStatus();
+    }
+    // The whole buffer was consumed. Load the next one.
+    char_idx = buffer_size_ - 1;
+    RETURN_IF_ERROR(ConsumeChar());
+  }
+  return absl::OkStatus();
+}
+
 int Reader::CurrentChar() {
   if (char_idx < buffer_size_) {
     return buffer_[char_idx];
@@ -215,6 +255,84 @@ void Reader::FinalizeRowCache() {
   }
 }
 
+size_t FindNextRecordStart(const absl::string_view content, size_t offset,
+                           bool in_quotes) {
+  const char* data = content.data();
+  while (offset < content.size()) {
+    if (in_quotes) {
+      // Skip to the end of the quoted field. An escaped double quote is
+      // handled as the end of a quoted field immediately followed by a new one.
+      const void* quote = std::memchr(data + offset, '"',
+                                      content.size() - offset);
+      if (quote == nullptr) {
+        return content.size();
+      }
+      offset = static_cast<const char*>(quote) - data + 1;
+      in_quotes = false;
+      continue;
+    }
+    const char c = data[offset];
+    if (c == '"') {
+      in_quotes = true;
+    } else if (c == '\n') {
+      return offset + 1;
+    } else if (c == '\r') {
+      if (offset + 1 < content.size() && data[offset + 1] == '\n') {
+        return offset + 2;
+      }
+      return offset + 1;
+    }
+    offset++;
+  }
+  return content.size();
+}
+
+std::vector<size_t> SplitIntoRecordRanges(
+    const absl::string_view content, int num_chunks,
+    concurrency::ThreadPool* thread_pool) {
+  num_chunks = std::max(num_chunks, 1);
+  const size_t target_chunk_size = content.size() / num_chunks;
+
+  // Number of double quotes in each chunk of "target_chunk_size" bytes.
+  std::vector<int64_t> num_quotes(num_chunks, 0);
+  const auto count_quotes = [&](const size_t block_idx, const size_t begin,
+                                const size_t end) {
+    for (size_t chunk_idx = begin; chunk_idx < end; chunk_idx++) {
+      const size_t chunk_begin = chunk_idx * target_chunk_size;
+      const size_t chunk_end = chunk_idx + 1 == num_chunks
+                                   ? content.size()
+                                   : chunk_begin + target_chunk_size;
+      num_quotes[chunk_idx] = std::count(content.begin() + chunk_begin,
+                                         content.begin() + chunk_end, '"');
+    }
+  };
+  if (thread_pool != nullptr && num_chunks > 1) {
+    concurrency::ConcurrentForLoop(
+        std::min<size_t>(num_chunks, thread_pool->num_threads()), thread_pool,
+        num_chunks, count_quotes);
+  } else {
+    count_quotes(0, 0, num_chunks);
+  }
+
+  std::vector<size_t> boundaries;
+  boundaries.reserve(num_chunks + 1);
+  boundaries.push_back(0);
+  int64_t num_preceding_quotes = 0;
+  for (int chunk_idx = 1; chunk_idx < num_chunks; chunk_idx++) {
+    num_preceding_quotes += num_quotes[chunk_idx - 1];
+    const size_t offset = chunk_idx * target_chunk_size;
+    if (boundaries.back() >= offset) {
+      // The previous chunk already covers this chunk.
+      boundaries.push_back(boundaries.back());
+      continue;
+    }
+    boundaries.push_back(FindNextRecordStart(
+        content, offset, /*in_quotes=*/(num_preceding_quotes % 2) == 1));
+  }
+  boundaries.push_back(content.size());
+  return boundaries;
+}
+
 Writer::Writer(OutputByteStream* stream, NewLine newline) : stream_(stream) {
   switch (newline) {
     case NewLine::UNIX:
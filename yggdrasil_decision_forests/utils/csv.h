@@ -41,15 +41,28 @@
 // Supports Unix, Windows and Mac new lines for reading. Writes
 // new lines in Unix ("\n") or Windows ("\r\n") format.
 //
+// A large csv file can be read with multiple threads with
+// "ReadChunksInParallel": The file is split into chunks of whole records that
+// are tokenized concurrently.
+//
 #ifndef THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_CSV_H_
 #define THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_CSV_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
 namespace utils {
@@ -82,6 +95,12 @@ class Reader {
   // Consumes character(s) representing a end of line.
   absl::Status ConsumeEndOfRow();
 
+  // Adds to the field in construction the characters, starting with the
+  // current one, until the next character that can change the state of the
+  // parser. "quoted" indicates if the field is quoted. The characters are
+  // scanned and copied in bulk instead of one at a time.
+  absl::Status ConsumeFieldCharacters(bool quoted);
+
   // Start the construction of a new row in the cache. Should be called before
   // any "*Cache" operations.
   void NewRowCache();
@@ -130,6 +149,40 @@ class Reader {
   int num_rows = 0;
 };
 
+// Returns the offset of the first record starting after "offset" in "content",
+// the content of a csv file. "in_quotes" indicates if the character at
+// "offset" is inside a quoted field i.e. if an odd number of double quotes
+// precede it. Returns "content.size()" if no record starts after "offset".
+size_t FindNextRecordStart(absl::string_view content, size_t offset,
+                           bool in_quotes);
+
+// Splits "content", the content of a csv file, into "num_chunks" ranges of
+// whole records of similar size. Returns "num_chunks + 1" non-decreasing
+// offsets: The i-th chunk is "[offsets[i], offsets[i+1])". Some chunks can be
+// empty.
+//
+// A chunk boundary depends on whether it falls in a quoted field. Since the
+// double quotes of a valid csv file are balanced in each quoted field, this is
+// the parity of the number of double quotes before the boundary. The double
+// quotes are counted in parallel in "thread_pool", if set.
+std::vector<size_t> SplitIntoRecordRanges(
+    absl::string_view content, int num_chunks,
+    concurrency::ThreadPool* thread_pool = nullptr);
+
+// Reads the records of "content", the content of a csv file, with
+// "num_threads" threads. "content" is split into chunks of whole records of
+// about "chunk_size" bytes (see "SplitIntoRecordRanges").
+//
+// "process" is called concurrently on each chunk with a "Reader" over the
+// records of the chunk. "consume" is called on the results, in the order of
+// the chunks, in the calling thread. Reading stops if "consume" returns false.
+// At most "2 x num_threads" chunk results are in memory at any time.
+template <typename T>
+absl::Status ReadChunksInParallel(
+    absl::string_view content, int num_threads, size_t chunk_size,
+    const std::function<absl::StatusOr<T>(Reader* reader)>& process,
+    const std::function<absl::StatusOr<bool>(T result)>& consume);
+
 class Writer {
  public:
   // CSV writer constructor.
@@ -156,6 +209,69 @@ class Writer {
   std::string newline_;
 };
 
+// =======================================
+//   Below are the template definitions.
+// =======================================
+
+template <typename T>
+absl::Status ReadChunksInParallel(
+    const absl::string_view content, int num_threads, const size_t chunk_size,
+    const std::function<absl::StatusOr<T>(Reader* reader)>& process,
+    const std::function<absl::StatusOr<bool>(T result)>& consume) {
+  num_threads = std::max(num_threads, 1);
+  const size_t num_chunks =
+      std::max<size_t>(1, (content.size() + chunk_size - 1) /
+                              std::max<size_t>(chunk_size, 1));
+
+  std::vector<size_t> boundaries;
+  {
+    concurrency::ThreadPool pool(num_threads, {"CsvSplitter"});
+    pool.StartWorkers();
+    boundaries = SplitIntoRecordRanges(content, num_chunks, &pool);
+  }
+
+  using Result = absl::StatusOr<T>;
+  concurrency::StreamProcessor<size_t, Result> processor(
+      "CsvChunkReader", num_threads,
+      [&](const size_t chunk_idx) -> Result {
+        StringViewInputByteStream stream(
+            content.substr(boundaries[chunk_idx],
+                           boundaries[chunk_idx + 1] - boundaries[chunk_idx]));
+        Reader reader(&stream);
+        return process(&reader);
+      },
+      /*result_in_order=*/true);
+  processor.StartWorkers();
+
+  // Only a limited number of chunks are scheduled in advance to bound the
+  // memory usage.
+  const size_t max_pending_chunks = 2 * num_threads;
+  size_t next_chunk_idx = 0;
+  for (; next_chunk_idx < std::min(num_chunks, max_pending_chunks);
+       next_chunk_idx++) {
+    processor.Submit(next_chunk_idx);
+  }
+
+  for (size_t chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+    std::optional<Result> result = processor.GetResult();
+    if (!result.has_value()) {
+      return absl::InternalError("Missing csv chunk");
+    }
+    if (next_chunk_idx < num_chunks) {
+      processor.Submit(next_chunk_idx++);
+    } else {
+      processor.CloseSubmits();
+    }
+    RETURN_IF_ERROR(result->status());
+    ASSIGN_OR_RETURN(const bool keep_reading,
+                     consume(std::move(result->value())));
+    if (!keep_reading) {
+      break;
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace csv
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
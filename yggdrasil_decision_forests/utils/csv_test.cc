@@ -15,9 +15,15 @@
 
 #include "yggdrasil_decision_forests/utils/csv.h"
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
@@ -258,6 +264,81 @@ TEST(Csv, WriterUnix) {
   EXPECT_OK(input_handle->Close());
 }
 
+TEST(Csv, FindNextRecordStart) {
+  const absl::string_view content = "a,b\n\"c\nd\",e\r\nf,g";
+  EXPECT_EQ(FindNextRecordStart(content, 0, false), 4);
+  EXPECT_EQ(FindNextRecordStart(content, 3, false), 4);
+  // The new line in the quoted field is skipped.
+  EXPECT_EQ(FindNextRecordStart(content, 5, true), 13);
+  // Windows new line.
+  EXPECT_EQ(FindNextRecordStart(content, 11, false), 13);
+  EXPECT_EQ(FindNextRecordStart(content, 12, false), 13);
+  EXPECT_EQ(FindNextRecordStart(content, 13, false), content.size());
+}
+
+TEST(Csv, ReadChunksInParallel) {
+  // Builds a csv content with quoted new lines and mixed new lines.
+  std::string content;
+  std::vector<std::vector<std::string>> expected_rows;
+  for (int row_idx = 0; row_idx < 1000; row_idx++) {
+    const std::string value = absl::StrCat("v", row_idx);
+    if (row_idx % 3 == 0) {
+      absl::StrAppend(&content, "\"", value, "\n\"\"x\",", row_idx,
+                      "\r\n");
+      expected_rows.push_back({absl::StrCat(value, "\n\"x"),
+                               absl::StrCat(row_idx)});
+    } else {
+      absl::StrAppend(&content, value, ",", row_idx, "\n");
+      expected_rows.push_back({value, absl::StrCat(row_idx)});
+    }
+  }
+
+  for (const size_t chunk_size : {1, 7, 100, 100000}) {
+    std::vector<std::vector<std::string>> rows;
+    EXPECT_OK(ReadChunksInParallel<std::vector<std::vector<std::string>>>(
+        content, /*num_threads=*/4, chunk_size,
+        [](Reader* reader)
+            -> absl::StatusOr<std::vector<std::vector<std::string>>> {
+          std::vector<std::vector<std::string>> chunk_rows;
+          std::vector<absl::string_view>* row;
+          while (reader->NextRow(&row).value()) {
+            chunk_rows.emplace_back(row->begin(), row->end());
+          }
+          return chunk_rows;
+        },
+        [&](std::vector<std::vector<std::string>> chunk_rows)
+            -> absl::StatusOr<bool> {
+          rows.insert(rows.end(), chunk_rows.begin(), chunk_rows.end());
+          return true;
+        }));
+    EXPECT_EQ(rows, expected_rows);
+  }
+}
+
+TEST(Csv, ReadChunksInParallelEarlyStop) {
+  std::string content;
+  for (int row_idx = 0; row_idx < 100; row_idx++) {
+    absl::StrAppend(&content, row_idx, "\n");
+  }
+  int num_rows = 0;
+  EXPECT_OK(ReadChunksInParallel<int>(
+      content, /*num_threads=*/4, /*chunk_size=*/10,
+      [](Reader* reader) -> absl::StatusOr<int> {
+        int count = 0;
+        std::vector<absl::string_view>* row;
+        while (reader->NextRow(&row).value()) {
+          count++;
+        }
+        return count;
+      },
+      [&](const int count) -> absl::StatusOr<bool> {
+        num_rows += count;
+        return num_rows < 20;
+      }));
+  EXPECT_GE(num_rows, 20);
+  EXPECT_LT(num_rows, 100);
+}
+
 }  // namespace
 }  // namespace csv
 }  // namespace utils
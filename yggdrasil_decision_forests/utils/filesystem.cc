@@ -24,13 +24,27 @@
 
 namespace file {
 
+namespace {
+// Options used by "OpenInputFile(path)".
+InputFileOptions default_input_file_options;
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<FileInputByteStream>> OpenInputFile(
     absl::string_view path) {
+  return OpenInputFile(path, default_input_file_options);
+}
+
+absl::StatusOr<std::unique_ptr<FileInputByteStream>> OpenInputFile(
+    absl::string_view path, const InputFileOptions& options) {
   auto reader = std::make_unique<FileInputByteStream>();
-  RETURN_IF_ERROR(reader->Open(path));
+  RETURN_IF_ERROR(reader->Open(path, options));
   return std::move(reader);
 }
 
+void SetDefaultInputFileOptions(const InputFileOptions& options) {
+  default_input_file_options = options;
+}
+
 absl::StatusOr<std::unique_ptr<FileOutputByteStream>> OpenOutputFile(
     absl::string_view path) {
   auto writer = std::make_unique<FileOutputByteStream>();
@@ -31,10 +31,32 @@
 
 namespace file {
 
-// Open a file for reading.
+using InputFileOptions =
+    ::yggdrasil_decision_forests::utils::filesystem::InputFileOptions;
+
+// Open a file for reading with the default options (see
+// "SetDefaultInputFileOptions").
 absl::StatusOr<std::unique_ptr<FileInputByteStream>> OpenInputFile(
     absl::string_view path);
 
+// Open a file for reading.
+//
+// Usage example:
+//   // Reads a large local file with 4 reads of 4MB in flight.
+//   ASSIGN_OR_RETURN(auto stream,
+//                    OpenInputFile(path, {.read_ahead_depth = 4,
+//                                         .read_ahead_block_size = 4 << 20}));
+//
+// The options are ignored by the file systems that do not support them (e.g.
+// GCS, TensorFlow).
+absl::StatusOr<std::unique_ptr<FileInputByteStream>> OpenInputFile(
+    absl::string_view path, const InputFileOptions& options);
+
+// Sets the options used by "OpenInputFile(path)" and, consequently, by most of
+// the readers of the library (e.g. datasets, models). Not thread safe: Should
+// be called before any file is open.
+void SetDefaultInputFileOptions(const InputFileOptions& options);
+
 // Open a file for writing.
 absl::StatusOr<std::unique_ptr<FileOutputByteStream>> OpenOutputFile(
     absl::string_view path);
@@ -16,17 +16,29 @@
 #include "yggdrasil_decision_forests/utils/filesystem_default.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <filesystem>
 #include <initializer_list>
 #include <ios>
 #include <memory>
+#include <optional>
 #include <regex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
@@ -34,6 +46,7 @@
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/filesystem_interface.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
@@ -125,6 +138,169 @@ absl::Status STLFileInputByteStream::Close() {
   return absl::OkStatus();
 }
 
+#if !defined(_WIN32)
+
+namespace {
+// Alignment of the offset, size and buffers of the direct I/O reads.
+constexpr int64_t kDirectIOAlignment = 4096;
+}  // namespace
+
+ReadAheadFileInputByteStream::ReadAheadFileInputByteStream(
+    const InputFileOptions& options)
+    : options_(options) {
+  const int64_t block_size = std::max(options.read_ahead_block_size, 1);
+  block_size_ = (block_size + kDirectIOAlignment - 1) / kDirectIOAlignment *
+                kDirectIOAlignment;
+}
+
+ReadAheadFileInputByteStream::~ReadAheadFileInputByteStream() {
+  Close().IgnoreError();
+}
+
+absl::Status ReadAheadFileInputByteStream::Open(absl::string_view path) {
+  RETURN_IF_ERROR(Close());
+  const std::string str_path(path);
+  direct_io_ = false;
+#if defined(O_DIRECT)
+  if (options_.direct_io) {
+    fd_ = ::open(str_path.c_str(), O_RDONLY | O_DIRECT);
+    // Some file systems (e.g. tmpfs) do not support direct I/O.
+    direct_io_ = fd_ >= 0;
+  }
+#endif
+  if (fd_ < 0) {
+    fd_ = ::open(str_path.c_str(), O_RDONLY);
+  }
+  if (fd_ < 0) {
+    return absl::Status(
+        absl::StatusCode::kUnknown,
+        absl::StrCat("Failed to open ", path, ": ", std::strerror(errno)));
+  }
+  struct stat file_stat;
+  if (::fstat(fd_, &file_stat) != 0) {
+    return absl::Status(absl::StatusCode::kUnknown,
+                        absl::StrCat("Failed to stat ", path));
+  }
+  num_blocks_ = (file_stat.st_size + block_size_ - 1) / block_size_;
+  next_submitted_block_idx_ = 0;
+  num_pending_blocks_ = 0;
+  current_block_ = {};
+  current_block_begin_ = 0;
+
+  const int num_threads = std::max(options_.read_ahead_depth, 1);
+  block_reader_ = std::make_unique<BlockReader>(
+      "ReadAheadFileInputByteStream", num_threads,
+      [this](const int64_t block_idx) { return ReadBlock(block_idx); },
+      /*result_in_order=*/true);
+  block_reader_->StartWorkers();
+  while (next_submitted_block_idx_ < num_blocks_ &&
+         num_pending_blocks_ < num_threads) {
+    block_reader_->Submit(next_submitted_block_idx_++);
+    num_pending_blocks_++;
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<ReadAheadFileInputByteStream::Block>
+ReadAheadFileInputByteStream::ReadBlock(const int64_t block_idx) const {
+  Block block;
+  block.data.reset(static_cast<char*>(
+      std::aligned_alloc(kDirectIOAlignment, block_size_)));
+  if (!block.data) {
+    return absl::ResourceExhaustedError("Cannot allocate read-ahead block");
+  }
+  const int64_t offset = block_idx * block_size_;
+  while (block.size < block_size_) {
+    const ssize_t n = ::pread(fd_, block.data.get() + block.size,
+                              block_size_ - block.size, offset + block.size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return absl::Status(
+          absl::StatusCode::kUnknown,
+          absl::StrCat("Failed to read chunk: ", std::strerror(errno)));
+    }
+    if (n == 0) {
+      // End of file.
+      break;
+    }
+    block.size += n;
+  }
+  return block;
+}
+
+absl::StatusOr<bool> ReadAheadFileInputByteStream::NextBlock() {
+  if (num_pending_blocks_ == 0) {
+    return false;
+  }
+  std::optional<absl::StatusOr<Block>> result = block_reader_->GetResult();
+  if (!result.has_value()) {
+    return absl::InternalError("Missing read-ahead block");
+  }
+  num_pending_blocks_--;
+  if (next_submitted_block_idx_ < num_blocks_) {
+    block_reader_->Submit(next_submitted_block_idx_++);
+    num_pending_blocks_++;
+  }
+  RETURN_IF_ERROR(result->status());
+  current_block_ = std::move(result->value());
+  current_block_begin_ = 0;
+  return true;
+}
+
+absl::StatusOr<int> ReadAheadFileInputByteStream::ReadUpTo(char* buffer,
+                                                           int max_read) {
+  if (!block_reader_) {
+    return absl::FailedPreconditionError("The file is not open");
+  }
+  while (current_block_begin_ == current_block_.size) {
+    ASSIGN_OR_RETURN(const bool has_block, NextBlock());
+    if (!has_block) {
+      return 0;
+    }
+  }
+  const int64_t n = std::min(static_cast<int64_t>(max_read),
+                             current_block_.size - current_block_begin_);
+  std::memcpy(buffer, current_block_.data.get() + current_block_begin_, n);
+  current_block_begin_ += n;
+  return n;
+}
+
+absl::StatusOr<bool> ReadAheadFileInputByteStream::ReadExactly(char* buffer,
+                                                               int num_read) {
+  int read_count = 0;
+  while (read_count < num_read) {
+    ASSIGN_OR_RETURN(const int n,
+                     ReadUpTo(buffer + read_count, num_read - read_count));
+    if (n == 0) {
+      if (read_count > 0) {
+        return absl::Status(absl::StatusCode::kUnknown,
+                            "Failed to read chunk");
+      }
+      return false;
+    }
+    read_count += n;
+  }
+  return true;
+}
+
+absl::Status ReadAheadFileInputByteStream::Close() {
+  // Waits for the pending reads before closing the file.
+  block_reader_.reset();
+  current_block_ = {};
+  if (fd_ >= 0) {
+    const int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0) {
+      return absl::Status(absl::StatusCode::kUnknown, "Failed to close file");
+    }
+  }
+  return absl::OkStatus();
+}
+
+#endif
+
 absl::Status STLFileOutputByteStream::Open(absl::string_view path) {
   file_stream_.open(std::string(path), std::ios::binary);
   if (!file_stream_.is_open()) {
@@ -278,6 +454,13 @@ absl::Status RecursivelyDelete(absl::string_view path, int options) {
 }
 
 absl::Status FileInputByteStream::Open(absl::string_view path) {
+  return Open(path, {});
+}
+
+absl::Status FileInputByteStream::Open(
+    absl::string_view path,
+    const yggdrasil_decision_forests::utils::filesystem::InputFileOptions&
+        options) {
   stream_.reset();
 
   // Support for GCS
@@ -291,6 +474,13 @@ absl::Status FileInputByteStream::Open(absl::string_view path) {
     }
   }
 
+#if !defined(_WIN32)
+  if (!stream_ && options.read_ahead_depth > 0) {
+    stream_ = std::make_unique<yggdrasil_decision_forests::utils::filesystem::
+                                   ReadAheadFileInputByteStream>(options);
+  }
+#endif
+
   if (!stream_) {
     stream_ = std::make_unique<yggdrasil_decision_forests::utils::filesystem::
                                    STLFileInputByteStream>();
@@ -17,6 +17,8 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_FILESYSTEM_DEFAULT_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_FILESYSTEM_DEFAULT_H_
 
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <initializer_list>
 #include <memory>
@@ -24,10 +26,12 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/filesystem_interface.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/protobuf.h"
@@ -63,6 +67,64 @@ class STLFileInputByteStream
   std::ifstream file_stream_;
 };
 
+#if !defined(_WIN32)
+// Reads a local file with "read_ahead_depth" background threads reading the
+// next blocks of the file with "pread" while the caller consumes the current
+// block. Used instead of "STLFileInputByteStream" if "read_ahead_depth > 0".
+//
+// The size of the file is fixed when the file is open: Data appended to the
+// file afterwards is not read.
+class ReadAheadFileInputByteStream
+    : public yggdrasil_decision_forests::utils::FileInputByteStream {
+ public:
+  explicit ReadAheadFileInputByteStream(const InputFileOptions& options);
+  ~ReadAheadFileInputByteStream() override;
+
+  absl::Status Open(absl::string_view path) override;
+  absl::StatusOr<int> ReadUpTo(char* buffer, int max_read) override;
+  absl::StatusOr<bool> ReadExactly(char* buffer, int num_read) override;
+  absl::Status Close() override;
+
+ private:
+  struct FreeDeleter {
+    void operator()(char* ptr) const { std::free(ptr); }
+  };
+
+  // A block of the file read by a background thread.
+  struct Block {
+    std::unique_ptr<char, FreeDeleter> data;
+    int64_t size = 0;
+  };
+
+  using BlockReader =
+      utils::concurrency::StreamProcessor<int64_t, absl::StatusOr<Block>>;
+
+  // Reads the "block_idx"-th block of the file.
+  absl::StatusOr<Block> ReadBlock(int64_t block_idx) const;
+
+  // Makes the next block the current block. Returns false if all the blocks
+  // have been read.
+  absl::StatusOr<bool> NextBlock();
+
+  const InputFileOptions options_;
+  // Size of the blocks. Multiple of the direct I/O alignment.
+  int64_t block_size_;
+  // File descriptor of the open file. -1 if the file is not open.
+  int fd_ = -1;
+  // True if "fd_" was open with direct I/O.
+  bool direct_io_ = false;
+  int64_t num_blocks_ = 0;
+  // Index of the next block to submit to "block_reader_".
+  int64_t next_submitted_block_idx_ = 0;
+  // Number of blocks submitted to "block_reader_" and not yet returned.
+  int num_pending_blocks_ = 0;
+  // Current block and position of the next byte to return.
+  Block current_block_;
+  int64_t current_block_begin_ = 0;
+  std::unique_ptr<BlockReader> block_reader_;
+};
+#endif
+
 class STLFileOutputByteStream
     : public yggdrasil_decision_forests::utils::FileOutputByteStream {
  public:
@@ -150,6 +212,10 @@ class FileInputByteStream
     : public yggdrasil_decision_forests::utils::InputByteStream {
  public:
   absl::Status Open(absl::string_view path);
+  absl::Status Open(
+      absl::string_view path,
+      const yggdrasil_decision_forests::utils::filesystem::InputFileOptions&
+          options);
   absl::StatusOr<int> ReadUpTo(char* buffer, int max_read) override;
   absl::StatusOr<bool> ReadExactly(char* buffer, int num_read) override;
   absl::Status Close() override;
@@ -28,6 +28,21 @@
 
 namespace yggdrasil_decision_forests::utils::filesystem {
 
+// Options to open a file for reading.
+struct InputFileOptions {
+  // Number of blocks read in advance, in parallel, by background threads. If
+  // 0, the file is read synchronously when the reader requests the data.
+  int read_ahead_depth = 0;
+
+  // Size of each read-ahead block in bytes.
+  int read_ahead_block_size = 1024 * 1024;
+
+  // If true, the read-ahead reads bypass the OS page cache (e.g. O_DIRECT) if
+  // supported by the file system. Useful for files read only once and larger
+  // than the available memory. Only used if "read_ahead_depth > 0".
+  bool direct_io = false;
+};
+
 class FileSystemInterface {
  public:
   virtual ~FileSystemInterface() = default;
@@ -110,6 +110,13 @@ class FileInputByteStream
  public:
   FileInputByteStream() : stream_(Interface().CreateInputByteStream()) {}
   absl::Status Open(absl::string_view path) { return stream_->Open(path); }
+  // The options are not supported by the TensorFlow file system.
+  absl::Status Open(
+      absl::string_view path,
+      const yggdrasil_decision_forests::utils::filesystem::InputFileOptions&
+      /*options*/) {
+    return stream_->Open(path);
+  }
   absl::StatusOr<int> ReadUpTo(char* buffer, int max_read) {
     return stream_->ReadUpTo(buffer, max_read);
   }
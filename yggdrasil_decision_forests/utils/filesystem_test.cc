@@ -15,6 +15,9 @@
 
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 
+#include <cstring>
+#include <string>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
@@ -135,6 +138,67 @@ TEST(Filesystem, ReadExactly) {
   }
 }
 
+class ReadAheadTest : public testing::TestWithParam<bool> {};
+
+TEST_P(ReadAheadTest, Read) {
+  auto file_path =
+      JoinPath(yggdrasil_decision_forests::test::TmpDirectory(), "file.bin");
+  // 3.5 blocks.
+  std::string content(4096 * 3 + 2048, 0);
+  for (int i = 0; i < content.size(); i++) {
+    content[i] = i % 251;
+  }
+  EXPECT_OK(SetContent(file_path, content));
+
+  const InputFileOptions options{.read_ahead_depth = 2,
+                                 .read_ahead_block_size = 4096,
+                                 .direct_io = GetParam()};
+  auto input_handle = OpenInputFile(file_path, options).value();
+  // Reads that span several blocks.
+  std::string read_content;
+  char buffer[3000];
+  while (true) {
+    const int n = input_handle->ReadUpTo(buffer, sizeof(buffer)).value();
+    if (n == 0) {
+      break;
+    }
+    read_content.append(buffer, n);
+  }
+  EXPECT_OK(input_handle->Close());
+  EXPECT_EQ(read_content, content);
+
+  // Re-open the same file.
+  EXPECT_OK(input_handle->Open(file_path, options));
+  EXPECT_TRUE(input_handle->ReadExactly(buffer, 2000).value());
+  EXPECT_EQ(std::memcmp(buffer, content.data(), 2000), 0);
+  EXPECT_EQ(input_handle->ReadAll().value(), content.substr(2000));
+  EXPECT_FALSE(input_handle->ReadExactly(buffer, 4).value());
+  EXPECT_OK(input_handle->Close());
+
+  // Partial read at the end of the file.
+  input_handle = OpenInputFile(file_path, options).value();
+  std::string large_buffer(content.size() + 1, 0);
+  EXPECT_FALSE(
+      input_handle->ReadExactly(&large_buffer[0], large_buffer.size()).ok());
+  EXPECT_OK(input_handle->Close());
+
+  EXPECT_FALSE(OpenInputFile(file_path + "_missing", options).ok());
+}
+
+TEST_P(ReadAheadTest, EmptyFile) {
+  auto file_path =
+      JoinPath(yggdrasil_decision_forests::test::TmpDirectory(), "empty.bin");
+  EXPECT_OK(SetContent(file_path, ""));
+  auto input_handle =
+      OpenInputFile(file_path,
+                    {.read_ahead_depth = 2, .direct_io = GetParam()})
+          .value();
+  EXPECT_EQ(input_handle->ReadAll().value(), "");
+  EXPECT_OK(input_handle->Close());
+}
+
+INSTANTIATE_TEST_SUITE_P(DirectIO, ReadAheadTest, testing::Bool());
+
 TEST(Filesystem, FileIOHelper) {
   auto tmp_dir = yggdrasil_decision_forests::test::TmpDirectory();
   auto file_path = JoinPath(tmp_dir, "my_file.txt");
@@ -229,7 +229,7 @@ absl::Status GenerateFoldsPrecomputedCrossValidation(
   ASSIGN_OR_RETURN(const auto fold_column,
                    folds_dataset.ColumnWithCastWithStatus<
                        dataset::VerticalDataset::CategoricalColumn>(0));
-  const auto& fold_values = fold_column->values();
+  const auto& fold_values = fold_column->int32_values();
   if (fold_values.empty()) {
     return absl::InvalidArgumentError("The set of precomputed folds is empty.");
   }
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests::utils {
+
+absl::StatusOr<std::unique_ptr<MemoryMappedFile>> MemoryMappedFile::Open(
+    const absl::string_view path) {
+  auto file = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile());
+
+#if !defined(_WIN32)
+  const std::string str_path(path);
+  const int fd = ::open(str_path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+      void* const address = ::mmap(nullptr, file_stat.st_size, PROT_READ,
+                                   MAP_SHARED, fd, /*offset=*/0);
+      if (address != MAP_FAILED) {
+        ::close(fd);
+        file->data_ = static_cast<const char*>(address);
+        file->size_ = file_stat.st_size;
+        file->is_mapped_ = true;
+        return file;
+      }
+    }
+    ::close(fd);
+  }
+#endif
+
+  // The file cannot be mapped (e.g. non local file, empty file).
+  ASSIGN_OR_RETURN(file->owned_content_, file::GetContent(path));
+  file->data_ = file->owned_content_.data();
+  file->size_ = file->owned_content_.size();
+  return file;
+}
+
+bool MemoryMappedFile::CanMap(const absl::string_view path) {
+#if !defined(_WIN32)
+  const std::string str_path(path);
+  const int fd = ::open(str_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  const bool can_map = ::fstat(fd, &file_stat) == 0 &&
+                       S_ISREG(file_stat.st_mode) && file_stat.st_size > 0;
+  ::close(fd);
+  return can_map;
+#else
+  return false;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+#if !defined(_WIN32)
+  if (is_mapped_) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+}
+
+}  // namespace yggdrasil_decision_forests::utils
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Read-only memory mapping of a file.
+//
+// Local files are mapped with "mmap" such that multiple processes reading the
+// same file share the same physical pages. Files that cannot be mapped (e.g.
+// remote files, or on platforms without "mmap") are read in memory instead.
+//
+// Usage example:
+//   ASSIGN_OR_RETURN(auto file, MemoryMappedFile::Open("/tmp/file"));
+//   absl::string_view content = file->data();
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_MEMORY_MAPPED_FILE_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace yggdrasil_decision_forests::utils {
+
+class MemoryMappedFile {
+ public:
+  // Opens and maps a file. If the file cannot be mapped, its content is read
+  // in memory.
+  static absl::StatusOr<std::unique_ptr<MemoryMappedFile>> Open(
+      absl::string_view path);
+
+  // Tests if "Open" would map the file instead of reading it in memory, i.e.
+  // the file is a non-empty local file.
+  static bool CanMap(absl::string_view path);
+
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  // Content of the file. Valid during the lifetime of the object.
+  absl::string_view data() const { return {data_, size_}; }
+
+  // True if the file is memory-mapped. False if the file was read in memory.
+  bool is_mapped() const { return is_mapped_; }
+
+ private:
+  MemoryMappedFile() = default;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool is_mapped_ = false;
+
+  // Content of the file, if the file is not mapped.
+  std::string owned_content_;
+};
+
+}  // namespace yggdrasil_decision_forests::utils
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_MEMORY_MAPPED_FILE_H_
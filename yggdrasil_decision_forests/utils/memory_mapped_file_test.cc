@@ -0,0 +1,51 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+#include "yggdrasil_decision_forests/utils/testing_macros.h"
+
+namespace yggdrasil_decision_forests::utils {
+namespace {
+
+TEST(MemoryMappedFile, Base) {
+  const std::string path = file::JoinPath(test::TmpDirectory(), "mapped");
+  ASSERT_OK(file::SetContent(path, "Hello world"));
+  ASSERT_OK_AND_ASSIGN(const auto mapped_file, MemoryMappedFile::Open(path));
+  EXPECT_EQ(mapped_file->data(), "Hello world");
+}
+
+TEST(MemoryMappedFile, Empty) {
+  const std::string path = file::JoinPath(test::TmpDirectory(), "empty");
+  ASSERT_OK(file::SetContent(path, ""));
+  ASSERT_OK_AND_ASSIGN(const auto mapped_file, MemoryMappedFile::Open(path));
+  EXPECT_TRUE(mapped_file->data().empty());
+  EXPECT_FALSE(mapped_file->is_mapped());
+}
+
+TEST(MemoryMappedFile, DoesNotExist) {
+  EXPECT_FALSE(MemoryMappedFile::Open(file::JoinPath(test::TmpDirectory(),
+                                                     "does_not_exist"))
+                   .ok());
+}
+
+}  // namespace
+}  // namespace yggdrasil_decision_forests::utils
@@ -17,6 +17,8 @@
 #define YGGDRASIL_DECISION_FORESTS_UTILS_OWN_OR_BORROW_H_
 
 #include <cstddef>
+#include <initializer_list>
+#include <utility>
 #include <vector>
 
 #include "absl/types/span.h"
@@ -75,6 +77,196 @@ class VectorOwnOrBorrow {
   bool owner_ = true;
 };
 
+// Vector-like container that either owns its data, or borrows it from an
+// external buffer (e.g. a memory-mapped file).
+//
+// Unlike "VectorOwnOrBorrow", this class is copyable, movable and implements
+// the subset of the "std::vector" interface used to build and read the data.
+// Borrowed data is never modified: Any mutating call on a borrowed buffer
+// first copies the data into an owned vector (i.e., copy-on-write).
+//
+// Read accessors do not branch on the ownership mode.
+template <typename T>
+class BorrowableVector {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using const_iterator = const T*;
+  using iterator = T*;
+
+  BorrowableVector() = default;
+
+  BorrowableVector(std::initializer_list<T> values) : owned_values_(values) {
+    Sync();
+  }
+
+  BorrowableVector(const BorrowableVector& other)
+      : owned_values_(other.owned_values_), owner_(other.owner_) {
+    if (owner_) {
+      Sync();
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+    }
+  }
+
+  BorrowableVector(BorrowableVector&& other)
+      : owned_values_(std::move(other.owned_values_)), owner_(other.owner_) {
+    if (owner_) {
+      Sync();
+    } else {
+      data_ = other.data_;
+      size_ = other.size_;
+    }
+    other.release();
+  }
+
+  BorrowableVector& operator=(const BorrowableVector& other) {
+    if (this != &other) {
+      owned_values_ = other.owned_values_;
+      owner_ = other.owner_;
+      if (owner_) {
+        Sync();
+      } else {
+        data_ = other.data_;
+        size_ = other.size_;
+      }
+    }
+    return *this;
+  }
+
+  BorrowableVector& operator=(BorrowableVector&& other) {
+    if (this != &other) {
+      owned_values_ = std::move(other.owned_values_);
+      owner_ = other.owner_;
+      if (owner_) {
+        Sync();
+      } else {
+        data_ = other.data_;
+        size_ = other.size_;
+      }
+      other.release();
+    }
+    return *this;
+  }
+
+  BorrowableVector& operator=(std::vector<T> values) {
+    own(std::move(values));
+    return *this;
+  }
+
+  BorrowableVector& operator=(std::initializer_list<T> values) {
+    own(std::vector<T>(values));
+    return *this;
+  }
+
+  // Is the data owned.
+  bool owner() const { return owner_; }
+
+  // Points to "src". The data is not owned. Release any previously owned data.
+  // "src" should outlive this object (and its copies).
+  void borrow(absl::Span<const T> src) {
+    owner_ = false;
+    owned_values_.clear();
+    owned_values_.shrink_to_fit();
+    data_ = src.data();
+    size_ = src.size();
+  }
+
+  void own(std::vector<T>&& src) {
+    owner_ = true;
+    owned_values_ = std::move(src);
+    Sync();
+  }
+
+  // Releases the data.
+  void release() {
+    owned_values_.clear();
+    owned_values_.shrink_to_fit();
+    owner_ = true;
+    Sync();
+  }
+
+  // Accesses the data (owned or not owned).
+  absl::Span<const T> values() const { return {data_, size_}; }
+
+  // Read-only "std::vector" interface.
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T* data() const { return data_; }
+  const T& operator[](const size_t idx) const { return data_[idx]; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+  const T& front() const { return data_[0]; }
+  const T& back() const { return data_[size_ - 1]; }
+
+  // Mutable access to the data. Converts borrowed data into owned data.
+  absl::Span<T> mutable_values() { return absl::MakeSpan(owned_vector()); }
+
+  // Mutating "std::vector" interface. Converts borrowed data into owned data.
+  void push_back(const T& value) {
+    owned_vector().push_back(value);
+    Sync();
+  }
+
+  void reserve(const size_t size) {
+    owned_vector().reserve(size);
+    Sync();
+  }
+
+  void resize(const size_t size) {
+    owned_vector().resize(size);
+    Sync();
+  }
+
+  void resize(const size_t size, const T& value) {
+    owned_vector().resize(size, value);
+    Sync();
+  }
+
+  void clear() {
+    owned_values_.clear();
+    owner_ = true;
+    Sync();
+  }
+
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last) {
+    owner_ = true;
+    owned_values_.assign(first, last);
+    Sync();
+  }
+
+  template <typename InputIt>
+  void insert(const T* pos, InputIt first, InputIt last) {
+    const size_t offset = pos - data_;
+    auto& values = owned_vector();
+    values.insert(values.begin() + offset, first, last);
+    Sync();
+  }
+
+ private:
+  // Returns the owned vector. Copies the borrowed data if necessary.
+  std::vector<T>& owned_vector() {
+    if (!owner_) {
+      owned_values_.assign(data_, data_ + size_);
+      owner_ = true;
+      Sync();
+    }
+    return owned_values_;
+  }
+
+  void Sync() {
+    data_ = owned_values_.data();
+    size_ = owned_values_.size();
+  }
+
+  std::vector<T> owned_values_;
+  const T* data_ = nullptr;
+  size_t size_ = 0;
+  bool owner_ = true;
+};
+
 }  // namespace yggdrasil_decision_forests::utils
 
 #endif  // YGGDRASIL_DECISION_FORESTS_UTILS_OWN_OR_BORROW_H_
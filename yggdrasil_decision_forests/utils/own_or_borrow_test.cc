@@ -62,6 +62,59 @@ TEST(OwnOrBorrow, Vector) {
   EXPECT_TRUE(a.empty());
 }
 
+TEST(OwnOrBorrow, BorrowableVector) {
+  std::vector<int> data{1, 2, 3, 4};
+
+  BorrowableVector<int> a;
+  EXPECT_TRUE(a.empty());
+  EXPECT_TRUE(a.owner());
+
+  a.push_back(5);
+  a.push_back(6);
+  EXPECT_TRUE(a.owner());
+  EXPECT_THAT(a, ElementsAre(5, 6));
+
+  a.borrow(data);
+  EXPECT_FALSE(a.owner());
+  EXPECT_EQ(a.data(), data.data());
+  EXPECT_THAT(a, ElementsAre(1, 2, 3, 4));
+
+  // Copies of a borrowed vector are also borrowed.
+  BorrowableVector<int> b = a;
+  EXPECT_FALSE(b.owner());
+  EXPECT_EQ(b.data(), data.data());
+
+  // Mutating a borrowed vector makes it owned, without changing the source.
+  b.push_back(7);
+  EXPECT_TRUE(b.owner());
+  EXPECT_THAT(b, ElementsAre(1, 2, 3, 4, 7));
+  EXPECT_THAT(data, ElementsAre(1, 2, 3, 4));
+  EXPECT_THAT(a, ElementsAre(1, 2, 3, 4));
+
+  // Mutable accesses are explicit.
+  BorrowableVector<int> d = a;
+  EXPECT_EQ(d[0], 1);
+  EXPECT_FALSE(d.owner());
+  d.mutable_values()[0] = 10;
+  EXPECT_TRUE(d.owner());
+  EXPECT_THAT(d, ElementsAre(10, 2, 3, 4));
+  EXPECT_THAT(data, ElementsAre(1, 2, 3, 4));
+
+  BorrowableVector<int> c = std::move(b);
+  EXPECT_TRUE(c.owner());
+  EXPECT_THAT(c, ElementsAre(1, 2, 3, 4, 7));
+  EXPECT_TRUE(b.empty());
+
+  c = {8, 9};
+  EXPECT_THAT(c, ElementsAre(8, 9));
+  c.insert(c.end(), data.begin(), data.begin() + 2);
+  EXPECT_THAT(c, ElementsAre(8, 9, 1, 2));
+
+  a.release();
+  EXPECT_TRUE(a.owner());
+  EXPECT_TRUE(a.empty());
+}
+
 }  // namespace
 
 }  // namespace yggdrasil_decision_forests::utils
@@ -109,6 +109,10 @@ class ShardedWriter : public ProtoWriterInterface<T> {
   // case, and it will lead to a CHECK() failure.
   virtual absl::Status CloseWithStatus() = 0;
 
+  // Indicates that the next record starts a new group of records (e.g. the
+  // nodes of a tree). Formats that do not index groups ignore it.
+  virtual void StartGroup() {}
+
  protected:
   // Start writing in a given file (i.e. not a sharded path).
   virtual absl::Status OpenShard(absl::string_view path) = 0;
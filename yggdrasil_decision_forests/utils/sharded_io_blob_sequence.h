@@ -51,12 +51,16 @@ class BlobSequenceShardedReader : public ShardedReader<T> {
 
 // Specialization of ShardedWriter for TFRecords: Class for the sequential
 // writing of sharded TFRecords.
+//
+// If "indexed" is true, the shards are indexed blob sequences (see
+// "blob_sequence::Writer::CreateIndexed").
 template <typename T>
 class BlobSequenceShardedWriter : public ShardedWriter<T> {
  public:
   BlobSequenceShardedWriter(blob_sequence::Compression compression =
-                                blob_sequence::Compression::kNone)
-      : compression_(compression) {};
+                                blob_sequence::Compression::kNone,
+                            bool indexed = false)
+      : compression_(compression), indexed_(indexed) {};
 
   // This type is neither copyable nor movable.
   BlobSequenceShardedWriter(const BlobSequenceShardedWriter&) = delete;
@@ -68,11 +72,18 @@ class BlobSequenceShardedWriter : public ShardedWriter<T> {
   absl::Status WriteInShard(const T& value) final;
   absl::Status CloseWithStatus() final;
 
+  // Starts a new group of values (see "blob_sequence::Writer::StartGroup") in
+  // the shard of the next value.
+  void StartGroup() final { start_group_ = true; }
+
  private:
   blob_sequence::Writer writer_;
   file::OutputFileCloser file_closer_;
   std::string buffer_;
   blob_sequence::Compression compression_;
+  bool indexed_;
+  // If true, the next value starts a new group.
+  bool start_group_ = false;
 };
 
 template <typename T>
@@ -102,13 +113,22 @@ absl::Status BlobSequenceShardedWriter<T>::OpenShard(
 
   ASSIGN_OR_RETURN(auto stream, file::OpenOutputFile(path));
   RETURN_IF_ERROR(file_closer_.reset(std::move(stream)));
-  ASSIGN_OR_RETURN(writer_, blob_sequence::Writer::Create(file_closer_.stream(),
-                                                          compression_));
+  if (indexed_) {
+    ASSIGN_OR_RETURN(writer_, blob_sequence::Writer::CreateIndexed(
+                                  file_closer_.stream(), compression_));
+  } else {
+    ASSIGN_OR_RETURN(writer_, blob_sequence::Writer::Create(
+                                  file_closer_.stream(), compression_));
+  }
   return absl::OkStatus();
 }
 
 template <typename T>
 absl::Status BlobSequenceShardedWriter<T>::WriteInShard(const T& value) {
+  if (start_group_) {
+    writer_.StartGroup();
+    start_group_ = false;
+  }
   buffer_.clear();
   value.AppendToString(&buffer_);
   return writer_.Write(buffer_);
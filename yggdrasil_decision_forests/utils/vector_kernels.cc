@@ -0,0 +1,239 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/vector_kernels.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "absl/log/check.h"
+#include "absl/types/span.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace {
+
+// Number of values processed in parallel.
+constexpr int kNumLanes = 8;
+
+// Number of anchors compared simultaneously to a vector by the blocked kernels.
+constexpr int kAnchorBlockSize = 4;
+
+#ifdef __AVX2__
+
+using Lanes = __m256;
+
+inline Lanes ZeroLanes() { return _mm256_setzero_ps(); }
+inline Lanes LoadLanes(const float* values) { return _mm256_loadu_ps(values); }
+inline Lanes AddLanes(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes SubLanes(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes MulLanes(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+
+// Sums the lanes as ((l0 + l4) + (l2 + l6)) + ((l1 + l5) + (l3 + l7)).
+inline float SumLanes(Lanes a) {
+  const __m128 s = _mm_add_ps(_mm256_castps256_ps128(a),
+                              _mm256_extractf128_ps(a, 1));
+  const __m128 t = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  return _mm_cvtss_f32(_mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+}
+
+#else
+
+struct Lanes {
+  float values[kNumLanes];
+};
+
+inline Lanes ZeroLanes() { return Lanes{}; }
+
+inline Lanes LoadLanes(const float* values) {
+  Lanes r;
+  std::copy(values, values + kNumLanes, r.values);
+  return r;
+}
+
+inline Lanes AddLanes(const Lanes& a, const Lanes& b) {
+  Lanes r;
+  for (int i = 0; i < kNumLanes; i++) {
+    r.values[i] = a.values[i] + b.values[i];
+  }
+  return r;
+}
+
+inline Lanes SubLanes(const Lanes& a, const Lanes& b) {
+  Lanes r;
+  for (int i = 0; i < kNumLanes; i++) {
+    r.values[i] = a.values[i] - b.values[i];
+  }
+  return r;
+}
+
+inline Lanes MulLanes(const Lanes& a, const Lanes& b) {
+  Lanes r;
+  for (int i = 0; i < kNumLanes; i++) {
+    r.values[i] = a.values[i] * b.values[i];
+  }
+  return r;
+}
+
+// Same order of operations as the AVX2 implementation.
+inline float SumLanes(const Lanes& a) {
+  const float* l = a.values;
+  return ((l[0] + l[4]) + (l[2] + l[6])) + ((l[1] + l[5]) + (l[3] + l[7]));
+}
+
+#endif
+
+struct DotProductOp {
+  static Lanes Accumulate(const Lanes& acc, const Lanes& a, const Lanes& b) {
+    return AddLanes(acc, MulLanes(a, b));
+  }
+  static float Accumulate(const float acc, const float a, const float b) {
+    return acc + a * b;
+  }
+};
+
+struct SquaredDistanceOp {
+  static Lanes Accumulate(const Lanes& acc, const Lanes& a, const Lanes& b) {
+    const Lanes d = SubLanes(a, b);
+    return AddLanes(acc, MulLanes(d, d));
+  }
+  static float Accumulate(const float acc, const float a, const float b) {
+    const float d = a - b;
+    return acc + d * d;
+  }
+};
+
+// Accumulates "Op" over the values of "a" and "b". The first values are
+// accumulated in "kNumLanes" independent lanes, and the remaining ones are
+// added to the sum of the lanes.
+template <typename Op>
+float Reduce(const float* a, const float* b, const int n) {
+  const int num_lane_values = n - n % kNumLanes;
+  Lanes acc = ZeroLanes();
+  for (int i = 0; i < num_lane_values; i += kNumLanes) {
+    acc = Op::Accumulate(acc, LoadLanes(a + i), LoadLanes(b + i));
+  }
+  float result = SumLanes(acc);
+  for (int i = num_lane_values; i < n; i++) {
+    result = Op::Accumulate(result, a[i], b[i]);
+  }
+  return result;
+}
+
+// Same as "Reduce" between "vector" and "kAnchorBlockSize" consecutive anchors.
+// The values of "vector" are loaded once for all the anchors.
+template <typename Op>
+void ReduceAnchorBlock(const float* vector, const float* anchors, const int n,
+                       float* dst) {
+  const int num_lane_values = n - n % kNumLanes;
+  Lanes acc[kAnchorBlockSize];
+  for (int k = 0; k < kAnchorBlockSize; k++) {
+    acc[k] = ZeroLanes();
+  }
+  for (int i = 0; i < num_lane_values; i += kNumLanes) {
+    const Lanes v = LoadLanes(vector + i);
+    for (int k = 0; k < kAnchorBlockSize; k++) {
+      acc[k] = Op::Accumulate(acc[k], v, LoadLanes(anchors + k * n + i));
+    }
+  }
+  for (int k = 0; k < kAnchorBlockSize; k++) {
+    float result = SumLanes(acc[k]);
+    for (int i = num_lane_values; i < n; i++) {
+      result = Op::Accumulate(result, vector[i], anchors[k * n + i]);
+    }
+    dst[k] = result;
+  }
+}
+
+// For each anchor, finds the best "Op" value over all the vectors. "is_better"
+// compares two "Op" values.
+template <typename Op, typename IsBetter>
+void BestOverVectors(const absl::Span<const float> vectors,
+                     const absl::Span<const float> anchors,
+                     const int vector_length, const float initial_value,
+                     IsBetter is_better, const absl::Span<float> dst) {
+  DCHECK_GT(vector_length, 0);
+  DCHECK_EQ(vectors.size() % vector_length, 0);
+  DCHECK_EQ(anchors.size(), dst.size() * vector_length);
+  const size_t num_vectors = vectors.size() / vector_length;
+  const size_t num_anchors = dst.size();
+  std::fill(dst.begin(), dst.end(), initial_value);
+
+  size_t anchor_idx = 0;
+  float block_values[kAnchorBlockSize];
+  for (; anchor_idx + kAnchorBlockSize <= num_anchors;
+       anchor_idx += kAnchorBlockSize) {
+    const float* block_anchors = anchors.data() + anchor_idx * vector_length;
+    for (size_t vector_idx = 0; vector_idx < num_vectors; vector_idx++) {
+      ReduceAnchorBlock<Op>(vectors.data() + vector_idx * vector_length,
+                            block_anchors, vector_length, block_values);
+      for (int k = 0; k < kAnchorBlockSize; k++) {
+        if (is_better(block_values[k], dst[anchor_idx + k])) {
+          dst[anchor_idx + k] = block_values[k];
+        }
+      }
+    }
+  }
+
+  // Remaining anchors.
+  for (; anchor_idx < num_anchors; anchor_idx++) {
+    const float* anchor = anchors.data() + anchor_idx * vector_length;
+    for (size_t vector_idx = 0; vector_idx < num_vectors; vector_idx++) {
+      const float value = Reduce<Op>(
+          vectors.data() + vector_idx * vector_length, anchor, vector_length);
+      if (is_better(value, dst[anchor_idx])) {
+        dst[anchor_idx] = value;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+float DotProduct(const absl::Span<const float> a,
+                 const absl::Span<const float> b) {
+  DCHECK_EQ(a.size(), b.size());
+  return Reduce<DotProductOp>(a.data(), b.data(), a.size());
+}
+
+float SquaredDistance(const absl::Span<const float> a,
+                      const absl::Span<const float> b) {
+  DCHECK_EQ(a.size(), b.size());
+  return Reduce<SquaredDistanceOp>(a.data(), b.data(), a.size());
+}
+
+void MaxDotProducts(const absl::Span<const float> vectors,
+                    const absl::Span<const float> anchors,
+                    const int vector_length, const absl::Span<float> dst) {
+  BestOverVectors<DotProductOp>(
+      vectors, anchors, vector_length, std::numeric_limits<float>::lowest(),
+      [](const float a, const float b) { return a > b; }, dst);
+}
+
+void MinSquaredDistances(const absl::Span<const float> vectors,
+                         const absl::Span<const float> anchors,
+                         const int vector_length,
+                         const absl::Span<float> dst) {
+  BestOverVectors<SquaredDistanceOp>(
+      vectors, anchors, vector_length, std::numeric_limits<float>::max(),
+      [](const float a, const float b) { return a < b; }, dst);
+}
+
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
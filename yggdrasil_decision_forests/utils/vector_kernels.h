@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Vectorized kernels over dense float vectors. Used to evaluate the numerical
+// vector sequence conditions during training and inference.
+//
+// The kernels use AVX2 instructions when the binary is compiled with AVX2
+// support (e.g. "--copt=-mavx2"). Otherwise, they use a portable
+// implementation with the same order of operations.
+//
+// "MaxDotProducts" and "MinSquaredDistances" compare several anchors to all the
+// vectors of a sequence. The anchors are processed in blocks so each vector is
+// loaded once per block. For a given anchor and vector, they perform the same
+// operations in the same order as "DotProduct" and "SquaredDistance", so a
+// condition learned with the blocked kernels is evaluated consistently by the
+// inference engines.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_VECTOR_KERNELS_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_VECTOR_KERNELS_H_
+
+#include "absl/types/span.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+
+// Dot product between two vectors of the same size.
+float DotProduct(absl::Span<const float> a, absl::Span<const float> b);
+
+// Square of the euclidean distance between two vectors of the same size.
+float SquaredDistance(absl::Span<const float> a, absl::Span<const float> b);
+
+// Computes the maximum dot product between each anchor and a sequence of
+// vectors.
+//
+// "vectors" and "anchors" contain vectors of "vector_length" values stored one
+// after the other. "anchors" contains "dst.size()" vectors. "dst[i]" is set to
+// the maximum dot product between the "i"-th anchor and the vectors, or to
+// "std::numeric_limits<float>::lowest()" if "vectors" is empty.
+void MaxDotProducts(absl::Span<const float> vectors,
+                    absl::Span<const float> anchors, int vector_length,
+                    absl::Span<float> dst);
+
+// Computes the minimum squared distance between each anchor and a sequence of
+// vectors. Same arguments as "MaxDotProducts". "dst[i]" is set to
+// "std::numeric_limits<float>::max()" if "vectors" is empty.
+void MinSquaredDistances(absl::Span<const float> vectors,
+                         absl::Span<const float> anchors, int vector_length,
+                         absl::Span<float> dst);
+
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_VECTOR_KERNELS_H_
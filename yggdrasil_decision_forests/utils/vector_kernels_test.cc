@@ -0,0 +1,117 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/vector_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/random/random.h"
+#include "absl/types/span.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::vector<float> RandomValues(const int n, absl::BitGen* rnd) {
+  std::vector<float> values(n);
+  for (auto& value : values) {
+    value = absl::Uniform(*rnd, -1.f, 1.f);
+  }
+  return values;
+}
+
+TEST(VectorKernels, DotProductAndSquaredDistance) {
+  absl::BitGen rnd;
+  for (int n = 0; n < 40; n++) {
+    const auto a = RandomValues(n, &rnd);
+    const auto b = RandomValues(n, &rnd);
+    double expected_dot = 0;
+    double expected_dist2 = 0;
+    for (int i = 0; i < n; i++) {
+      expected_dot += static_cast<double>(a[i]) * b[i];
+      expected_dist2 += (static_cast<double>(a[i]) - b[i]) * (a[i] - b[i]);
+    }
+    EXPECT_NEAR(DotProduct(a, b), expected_dot, 1e-5);
+    EXPECT_NEAR(SquaredDistance(a, b), expected_dist2, 1e-5);
+  }
+}
+
+TEST(VectorKernels, Small) {
+  const std::vector<float> vectors = {1, 0, 0, 2, 1, 1};
+  const std::vector<float> anchors = {1, 0, 0, 1, -1, -1};
+  std::vector<float> dst(3);
+
+  MaxDotProducts(vectors, anchors, 2, absl::MakeSpan(dst));
+  EXPECT_THAT(dst, ElementsAre(1, 2, -1));
+
+  MinSquaredDistances(vectors, anchors, 2, absl::MakeSpan(dst));
+  EXPECT_THAT(dst, ElementsAre(0, 1, 5));
+
+  MaxDotProducts({}, anchors, 2, absl::MakeSpan(dst));
+  EXPECT_THAT(dst, ElementsAre(std::numeric_limits<float>::lowest(),
+                               std::numeric_limits<float>::lowest(),
+                               std::numeric_limits<float>::lowest()));
+
+  MinSquaredDistances({}, anchors, 2, absl::MakeSpan(dst));
+  EXPECT_THAT(dst, ElementsAre(std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::max()));
+}
+
+// The blocked kernels return the same values as the individual kernels.
+TEST(VectorKernels, BlockedSameAsIndividual) {
+  absl::BitGen rnd;
+  for (const int vector_length : {1, 3, 8, 13, 32}) {
+    for (int num_anchors = 0; num_anchors < 10; num_anchors++) {
+      for (const int num_vectors : {0, 1, 5}) {
+        const auto vectors = RandomValues(num_vectors * vector_length, &rnd);
+        const auto anchors = RandomValues(num_anchors * vector_length, &rnd);
+        std::vector<float> max_dot_products(num_anchors);
+        std::vector<float> min_squared_distances(num_anchors);
+        MaxDotProducts(vectors, anchors, vector_length,
+                       absl::MakeSpan(max_dot_products));
+        MinSquaredDistances(vectors, anchors, vector_length,
+                            absl::MakeSpan(min_squared_distances));
+
+        for (int anchor_idx = 0; anchor_idx < num_anchors; anchor_idx++) {
+          const auto anchor = absl::MakeConstSpan(anchors).subspan(
+              anchor_idx * vector_length, vector_length);
+          float expected_max = std::numeric_limits<float>::lowest();
+          float expected_min = std::numeric_limits<float>::max();
+          for (int vector_idx = 0; vector_idx < num_vectors; vector_idx++) {
+            const auto vector = absl::MakeConstSpan(vectors).subspan(
+                vector_idx * vector_length, vector_length);
+            expected_max = std::max(expected_max, DotProduct(vector, anchor));
+            expected_min =
+                std::min(expected_min, SquaredDistance(vector, anchor));
+          }
+          EXPECT_EQ(max_dot_products[anchor_idx], expected_max);
+          EXPECT_EQ(min_squared_distances[anchor_idx], expected_min);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
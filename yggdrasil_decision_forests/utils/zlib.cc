@@ -20,9 +20,12 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 
 #include "absl/base/nullability.h"
 #include "absl/log/check.h"
@@ -31,6 +34,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include <zconf.h>
 
@@ -39,9 +43,85 @@
 
 namespace yggdrasil_decision_forests::utils {
 
+namespace {
+
+// Size of the trailer of a gzip member (CRC32 and uncompressed size).
+constexpr size_t kGZipTrailerSize = 8;
+
+// Gzip header flag indicating the presence of an extra field.
+constexpr uint8_t kGZipFlagExtra = 4;
+
+void StoreLittleEndian16(const uint16_t value, char* dst) {
+  dst[0] = static_cast<char>(value & 0xFF);
+  dst[1] = static_cast<char>(value >> 8);
+}
+
+void StoreLittleEndian32(const uint32_t value, char* dst) {
+  for (int byte_idx = 0; byte_idx < 4; byte_idx++) {
+    dst[byte_idx] = static_cast<char>((value >> (8 * byte_idx)) & 0xFF);
+  }
+}
+
+// Writes the header of an indexed member of "member_size" bytes.
+void WriteIndexedMemberHeader(const uint32_t member_size, char* dst) {
+  dst[0] = static_cast<char>(0x1F);  // Magic number.
+  dst[1] = static_cast<char>(0x8B);
+  dst[2] = 8;  // Deflate compression.
+  dst[3] = kGZipFlagExtra;
+  StoreLittleEndian32(0, dst + 4);  // Modification time.
+  dst[8] = 0;                       // Extra flags.
+  dst[9] = static_cast<char>(255);  // Unknown OS.
+  StoreLittleEndian16(8, dst + 10);  // Size of the extra field.
+  dst[12] = 'Y';                     // Subfield id.
+  dst[13] = 'D';
+  StoreLittleEndian16(4, dst + 14);  // Size of the subfield.
+  StoreLittleEndian32(member_size, dst + 16);
+}
+
+// Returns the size of the indexed member starting with "header". Returns
+// nullopt if "header" is not the header of an indexed member.
+std::optional<uint32_t> ParseIndexedMemberHeader(
+    const absl::string_view header) {
+  if (header.size() < kGZipIndexedMemberHeaderSize) {
+    return {};
+  }
+  const auto* h = reinterpret_cast<const uint8_t*>(header.data());
+  if (h[0] != 0x1F || h[1] != 0x8B || h[2] != 8 || h[3] != kGZipFlagExtra ||
+      h[10] != 8 || h[11] != 0 || h[12] != 'Y' || h[13] != 'D' || h[14] != 4 ||
+      h[15] != 0) {
+    return {};
+  }
+  const uint32_t member_size = static_cast<uint32_t>(h[16]) |
+                               (static_cast<uint32_t>(h[17]) << 8) |
+                               (static_cast<uint32_t>(h[18]) << 16) |
+                               (static_cast<uint32_t>(h[19]) << 24);
+  if (member_size < kGZipIndexedMemberHeaderSize + kGZipTrailerSize) {
+    return {};
+  }
+  return member_size;
+}
+
+// Reads up to "size" bytes. Only returns less than "size" bytes at the end of
+// the stream.
+absl::StatusOr<size_t> ReadUpToEnd(InputByteStream* stream, char* buffer,
+                                   const size_t size) {
+  size_t num_read = 0;
+  while (num_read < size) {
+    ASSIGN_OR_RETURN(const int n,
+                     stream->ReadUpTo(buffer + num_read, size - num_read));
+    if (n == 0) {
+      break;
+    }
+    num_read += n;
+  }
+  return num_read;
+}
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<GZipInputByteStream>>
 GZipInputByteStream::Create(absl::Nonnull<utils::InputByteStream*> stream,
-                            size_t buffer_size) {
+                            size_t buffer_size, const int num_threads) {
   auto gz_stream = std::make_unique<GZipInputByteStream>(stream, buffer_size);
   std::memset(&gz_stream->deflate_stream_, 0,
               sizeof(gz_stream->deflate_stream_));
@@ -49,6 +129,23 @@ GZipInputByteStream::Create(absl::Nonnull<utils::InputByteStream*> stream,
     return absl::InternalError("Cannot initialize gzip stream");
   }
   gz_stream->deflate_stream_is_allocated_ = true;
+
+  if (num_threads > 1 && buffer_size >= kGZipIndexedMemberHeaderSize) {
+    // Look for indexed members.
+    char* header = reinterpret_cast<char*>(gz_stream->input_buffer_.data());
+    ASSIGN_OR_RETURN(
+        const size_t header_size,
+        ReadUpToEnd(stream, header, kGZipIndexedMemberHeaderSize));
+    if (ParseIndexedMemberHeader(absl::string_view(header, header_size))
+            .has_value()) {
+      RETURN_IF_ERROR(gz_stream->StartParallelDecompression(
+          absl::string_view(header, header_size), num_threads));
+    } else {
+      // The bytes already read are decompressed in the calling thread.
+      gz_stream->deflate_stream_.next_in = gz_stream->input_buffer_.data();
+      gz_stream->deflate_stream_.avail_in = header_size;
+    }
+  }
   return gz_stream;
 }
 
@@ -60,6 +157,21 @@ GZipInputByteStream::GZipInputByteStream(utils::InputByteStream* stream,
 }
 
 absl::StatusOr<int> GZipInputByteStream::ReadUpTo(char* buffer, int max_read) {
+  if (member_processor_) {
+    // Indexed members decompressed in parallel.
+    while (current_member_begin_ == current_member_.size()) {
+      ASSIGN_OR_RETURN(const bool has_member, NextMember());
+      if (!has_member) {
+        return 0;
+      }
+    }
+    const size_t n = std::min(static_cast<size_t>(max_read),
+                              current_member_.size() - current_member_begin_);
+    std::memcpy(buffer, current_member_.data() + current_member_begin_, n);
+    current_member_begin_ += n;
+    return n;
+  }
+
   while (true) {    // Compressed data reading block.
     while (true) {  // Decompression block.
       // 1. Is there decompressed data available?
@@ -87,6 +199,13 @@ absl::StatusOr<int> GZipInputByteStream::ReadUpTo(char* buffer, int max_read) {
         return absl::InternalError(absl::StrCat("Internal error", zlib_error));
       }
 
+      if (zlib_error == Z_STREAM_END) {
+        // End of a gzip member. The next bytes, if any, are another member.
+        if (inflateReset(&deflate_stream_) != Z_OK) {
+          return absl::InternalError("Cannot reset gzip stream");
+        }
+      }
+
       const int produced_bytes = buffer_size_ - deflate_stream_.avail_out;
       output_buffer_begin_ = 0;
       output_buffer_end_ = produced_bytes;
@@ -128,6 +247,7 @@ GZipInputByteStream::~GZipInputByteStream() {
 }
 
 absl::Status GZipInputByteStream::Close() {
+  member_processor_.reset();
   RETURN_IF_ERROR(CloseDeflateStream());
   if (stream_) {
     return stream_->Close();
@@ -145,21 +265,112 @@ absl::Status GZipInputByteStream::CloseDeflateStream() {
   return absl::OkStatus();
 }
 
+absl::Status GZipInputByteStream::StartParallelDecompression(
+    const absl::string_view header, const int num_threads) {
+  working_buffers_.assign(num_threads, std::string());
+  member_processor_ = std::make_unique<MemberProcessor>(
+      "GZipMemberDecompressor", num_threads,
+      [this](std::string member,
+             const int thread_idx) -> absl::StatusOr<std::string> {
+        std::string& working_buffer = working_buffers_[thread_idx];
+        working_buffer.resize(std::max<size_t>(buffer_size_, 1024));
+        std::string content;
+        RETURN_IF_ERROR(Inflate(member, &content, &working_buffer));
+        return content;
+      },
+      /*result_in_order=*/true);
+  member_processor_->StartWorkers();
+
+  // The first member.
+  const uint32_t member_size = ParseIndexedMemberHeader(header).value();
+  std::string member(member_size, 0);
+  std::memcpy(&member[0], header.data(), header.size());
+  ASSIGN_OR_RETURN(const bool has_read,
+                   stream_->ReadExactly(&member[header.size()],
+                                        member_size - header.size()));
+  if (!has_read) {
+    return absl::InvalidArgumentError("Truncated gzip member");
+  }
+  member_processor_->Submit(std::move(member));
+  num_pending_members_++;
+
+  // Only a limited number of members are decompressed in advance to bound the
+  // memory usage.
+  while (has_more_members_ && num_pending_members_ < 2 * num_threads) {
+    RETURN_IF_ERROR(SubmitNextMember().status());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<bool> GZipInputByteStream::SubmitNextMember() {
+  char header[kGZipIndexedMemberHeaderSize];
+  ASSIGN_OR_RETURN(const size_t header_size,
+                   ReadUpToEnd(stream_, header, sizeof(header)));
+  if (header_size == 0) {
+    has_more_members_ = false;
+    member_processor_->CloseSubmits();
+    return false;
+  }
+  const auto member_size =
+      ParseIndexedMemberHeader(absl::string_view(header, header_size));
+  if (!member_size.has_value()) {
+    return absl::InvalidArgumentError(
+        "Non-indexed gzip member in an indexed gzip stream");
+  }
+  std::string member(*member_size, 0);
+  std::memcpy(&member[0], header, header_size);
+  ASSIGN_OR_RETURN(const bool has_read,
+                   stream_->ReadExactly(&member[header_size],
+                                        *member_size - header_size));
+  if (!has_read) {
+    return absl::InvalidArgumentError("Truncated gzip member");
+  }
+  member_processor_->Submit(std::move(member));
+  num_pending_members_++;
+  return true;
+}
+
+absl::StatusOr<bool> GZipInputByteStream::NextMember() {
+  if (num_pending_members_ == 0) {
+    return false;
+  }
+  std::optional<absl::StatusOr<std::string>> result =
+      member_processor_->GetResult();
+  if (!result.has_value()) {
+    return absl::InternalError("Missing gzip member");
+  }
+  num_pending_members_--;
+  if (has_more_members_) {
+    RETURN_IF_ERROR(SubmitNextMember().status());
+  }
+  RETURN_IF_ERROR(result->status());
+  current_member_ = std::move(result->value());
+  current_member_begin_ = 0;
+  return true;
+}
+
 absl::StatusOr<std::unique_ptr<GZipOutputByteStream>>
 GZipOutputByteStream::Create(absl::Nonnull<utils::OutputByteStream*> stream,
                              int compression_level, size_t buffer_size,
-                             bool raw_deflate) {
+                             bool raw_deflate, size_t member_size) {
   if (compression_level != Z_DEFAULT_COMPRESSION) {
     STATUS_CHECK_GT(compression_level, Z_NO_COMPRESSION);
     STATUS_CHECK_LT(compression_level, Z_BEST_COMPRESSION);
   }
+  if (member_size > 0) {
+    STATUS_CHECK(!raw_deflate);
+    // The compressed size of a member should fit in 32 bits.
+    STATUS_CHECK_LE(member_size, size_t{1} << 30);
+  }
   auto gz_stream = std::make_unique<GZipOutputByteStream>(stream, buffer_size);
+  gz_stream->member_size_ = member_size;
   std::memset(&gz_stream->deflate_stream_, 0,
               sizeof(gz_stream->deflate_stream_));
   // Note: A negative window size indicate to use the raw deflate algorithm (!=
-  // zlib or gzip).
+  // zlib or gzip). The gzip header and trailer of indexed members are written
+  // by "WriteMember".
   if (deflateInit2(&gz_stream->deflate_stream_, compression_level, Z_DEFLATED,
-                   raw_deflate ? -15 : (MAX_WBITS + 16),
+                   (raw_deflate || member_size > 0) ? -15 : (MAX_WBITS + 16),
                    /*memLevel=*/8,  // 8 is the recommended default
                    Z_DEFAULT_STRATEGY) != Z_OK) {
     return absl::InternalError("Cannot initialize gzip stream");
@@ -179,9 +390,60 @@ GZipOutputByteStream::~GZipOutputByteStream() {
 }
 
 absl::Status GZipOutputByteStream::Write(absl::string_view chunk) {
+  if (member_size_ > 0) {
+    while (!chunk.empty()) {
+      const size_t n =
+          std::min(chunk.size(), member_size_ - member_buffer_.size());
+      member_buffer_.append(chunk.data(), n);
+      chunk.remove_prefix(n);
+      if (member_buffer_.size() == member_size_) {
+        RETURN_IF_ERROR(WriteMember());
+      }
+    }
+    return absl::OkStatus();
+  }
   return WriteImpl(chunk, false);
 }
 
+absl::Status GZipOutputByteStream::WriteMember() {
+  const uLong max_compressed_size =
+      deflateBound(&deflate_stream_, member_buffer_.size());
+  compressed_member_.resize(kGZipIndexedMemberHeaderSize +
+                            max_compressed_size + kGZipTrailerSize);
+  deflate_stream_.next_in =
+      reinterpret_cast<const Bytef*>(member_buffer_.data());
+  deflate_stream_.avail_in = member_buffer_.size();
+  deflate_stream_.next_out = reinterpret_cast<Bytef*>(
+      &compressed_member_[kGZipIndexedMemberHeaderSize]);
+  deflate_stream_.avail_out = max_compressed_size;
+  const auto zlib_error = deflate(&deflate_stream_, Z_FINISH);
+  if (zlib_error != Z_STREAM_END) {
+    return absl::InternalError(absl::StrCat("Internal error ", zlib_error));
+  }
+  const size_t compressed_size =
+      max_compressed_size - deflate_stream_.avail_out;
+  if (deflateReset(&deflate_stream_) != Z_OK) {
+    return absl::InternalError("Cannot reset deflate");
+  }
+
+  const size_t member_size =
+      kGZipIndexedMemberHeaderSize + compressed_size + kGZipTrailerSize;
+  compressed_member_.resize(member_size);
+  WriteIndexedMemberHeader(member_size, &compressed_member_[0]);
+  const uLong crc =
+      crc32(crc32(0L, Z_NULL, 0),
+            reinterpret_cast<const Bytef*>(member_buffer_.data()),
+            member_buffer_.size());
+  char* trailer = &compressed_member_[member_size - kGZipTrailerSize];
+  StoreLittleEndian32(crc, trailer);
+  StoreLittleEndian32(member_buffer_.size(), trailer + 4);
+  RETURN_IF_ERROR(stream_.Write(compressed_member_));
+
+  member_buffer_.clear();
+  num_written_members_++;
+  return absl::OkStatus();
+}
+
 absl::Status GZipOutputByteStream::WriteImpl(absl::string_view chunk,
                                              bool flush) {
   if (chunk.empty() && !flush) {
@@ -230,7 +492,16 @@ absl::Status GZipOutputByteStream::Close() {
   return absl::OkStatus();
 }
 
-absl::Status GZipOutputByteStream::Flush() { return WriteImpl("", true); }
+absl::Status GZipOutputByteStream::Flush() {
+  if (member_size_ > 0) {
+    // Note: An empty stream is written as a single empty member.
+    if (!member_buffer_.empty() || num_written_members_ == 0) {
+      RETURN_IF_ERROR(WriteMember());
+    }
+    return absl::OkStatus();
+  }
+  return WriteImpl("", true);
+}
 
 absl::Status GZipOutputByteStream::CloseInflateStream() {
   if (deflate_stream_is_allocated_) {
@@ -17,6 +17,7 @@
 #define YGGDRASIL_DECISION_FORESTS_UTILS_ZLIB_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,17 +27,37 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 
 #define ZLIB_CONST
 #include <zlib.h>
 
 namespace yggdrasil_decision_forests::utils {
 
+// Gzip streams can contain multiple "members" (i.e. concatenated gzip
+// streams). "GZipOutputByteStream" can write "indexed members": Independent
+// gzip members of bounded size whose header contains the compressed size of
+// the member (similarly to the BGZF format). Indexed members can be located
+// without being decompressed, and are decompressed in parallel by
+// "GZipInputByteStream". Indexed gzip streams are valid gzip streams.
+//
+// Header of an indexed member: A gzip header with the FEXTRA flag and a single
+// extra subfield "YD" of 4 bytes containing the size of the member (including
+// the header and the trailer) as a little-endian uint32.
+inline constexpr size_t kGZipIndexedMemberHeaderSize = 20;
+
 class GZipInputByteStream : public utils::InputByteStream {
  public:
+  // Creates a gzip decompression stream.
+  // Args:
+  //   stream: Stream of compressed data.
+  //   buffer_size: Size of the compressed and uncompressed buffers.
+  //   num_threads: Number of threads used to decompress indexed members (see
+  //     "GZipOutputByteStream::Create"). Other gzip streams are always
+  //     decompressed in the calling thread.
   static absl::StatusOr<std::unique_ptr<GZipInputByteStream>> Create(
       absl::Nonnull<utils::InputByteStream*> stream,
-      size_t buffer_size = 1024 * 1024);
+      size_t buffer_size = 1024 * 1024, int num_threads = 1);
 
   GZipInputByteStream(utils::InputByteStream* stream, size_t buffer_size);
   ~GZipInputByteStream() override;
@@ -46,8 +67,24 @@ class GZipInputByteStream : public utils::InputByteStream {
   absl::Status Close() override;
 
  private:
+  using MemberProcessor =
+      concurrency::StreamProcessor<std::string, absl::StatusOr<std::string>>;
+
   absl::Status CloseDeflateStream();
 
+  // Starts the parallel decompression of the indexed members. "header" is the
+  // header of the first member, already read from "stream_".
+  absl::Status StartParallelDecompression(absl::string_view header,
+                                          int num_threads);
+
+  // Reads the next indexed member from "stream_" and submits it for
+  // decompression. Returns false if there are no more members.
+  absl::StatusOr<bool> SubmitNextMember();
+
+  // Makes the next decompressed member the current member. Returns false if
+  // there are no more members.
+  absl::StatusOr<bool> NextMember();
+
   // Size of the compressed and uncompressed buffers.
   size_t buffer_size_;
   // Non-owned underlying input stream.
@@ -64,6 +101,21 @@ class GZipInputByteStream : public utils::InputByteStream {
   z_stream deflate_stream_;
   // Was "deflate_stream_" allocated?
   bool deflate_stream_is_allocated_ = false;
+
+  // Parallel decompression of indexed members. Only used if
+  // "member_processor_" is set.
+  //
+  // Decompressed content of the current member and position of the next byte
+  // to return.
+  std::string current_member_;
+  size_t current_member_begin_ = 0;
+  // Number of members submitted to "member_processor_" and not yet returned.
+  int num_pending_members_ = 0;
+  // False once all the members have been read from "stream_".
+  bool has_more_members_ = true;
+  // zlib working buffer of each thread.
+  std::vector<std::string> working_buffers_;
+  std::unique_ptr<MemberProcessor> member_processor_;
 };
 
 class GZipOutputByteStream : public utils::OutputByteStream {
@@ -75,10 +127,17 @@ class GZipOutputByteStream : public utils::OutputByteStream {
   //   buffer_size: Size of the working buffer. The minimum size depends on the
   //     compressed data, but 1MB should work in most cases.
   //   raw_deflate: If true, uses the raw deflate algorithm (!= zlib or gzip).
+  //   member_size: If non-zero, the data is written as a sequence of indexed
+  //     gzip members of "member_size" uncompressed bytes each (except for the
+  //     last one). Such streams can be decompressed in parallel. Smaller
+  //     members decompress with more parallelism but compress slightly less.
+  //     Note: Versions of "GZipInputByteStream" older than the indexed members
+  //     cannot read multi-member streams.
   static absl::StatusOr<std::unique_ptr<GZipOutputByteStream>> Create(
       absl::Nonnull<utils::OutputByteStream*> stream,
       int compression_level = Z_DEFAULT_COMPRESSION,
-      size_t buffer_size = 1024 * 1024, bool raw_deflate = false);
+      size_t buffer_size = 1024 * 1024, bool raw_deflate = false,
+      size_t member_size = 0);
 
   GZipOutputByteStream(utils::OutputByteStream* stream, size_t buffer_size);
   ~GZipOutputByteStream() override;
@@ -91,6 +150,9 @@ class GZipOutputByteStream : public utils::OutputByteStream {
   absl::Status CloseInflateStream();
   absl::Status WriteImpl(absl::string_view chunk, bool flush);
 
+  // Compresses and writes "member_buffer_" as an indexed member.
+  absl::Status WriteMember();
+
   // Size of the compressed and uncompressed buffers.
   size_t buffer_size_;
   // Non-owned underlying stream of compressed data.
@@ -101,6 +163,17 @@ class GZipOutputByteStream : public utils::OutputByteStream {
   z_stream deflate_stream_;
   // Was "deflate_stream_" allocated?
   bool deflate_stream_is_allocated_ = false;
+
+  // Indexed members. Only used if "member_size_" is non-zero.
+  //
+  // Maximum number of uncompressed bytes in a member.
+  size_t member_size_ = 0;
+  // Uncompressed data of the current member.
+  std::string member_buffer_;
+  // Compressed current member.
+  std::string compressed_member_;
+  // Number of members written so far.
+  int64_t num_written_members_ = 0;
 };
 
 // Inflates (i.e. decompress) "input" and appends it to "output".
@@ -27,6 +27,7 @@
 #include "absl/log/log.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
@@ -142,6 +143,114 @@ TEST_P(GZipTestCaseTest, WriteAndRead) {
   }
 }
 
+TEST(GZip, ReadConcatenatedMembers) {
+  std::string compressed;
+  for (const absl::string_view part : {"hello", " ", "world"}) {
+    StringOutputByteStream raw_stream;
+    auto stream = GZipOutputByteStream::Create(&raw_stream).value();
+    EXPECT_OK(stream->Write(part));
+    EXPECT_OK(stream->Close());
+    absl::StrAppend(&compressed, raw_stream.ToString());
+  }
+
+  StringInputByteStream raw_stream(compressed);
+  auto stream = GZipInputByteStream::Create(&raw_stream).value();
+  EXPECT_EQ(stream->ReadAll().value(), "hello world");
+  EXPECT_OK(stream->Close());
+}
+
+struct IndexedGZipTestCase {
+  size_t content_size;
+  size_t member_size;
+  int num_threads;
+};
+
+using IndexedGZipTestCaseTest = TestWithParam<IndexedGZipTestCase>;
+
+INSTANTIATE_TEST_SUITE_P(
+    IndexedGZipTestCaseTestSuiteInstantiation, IndexedGZipTestCaseTest,
+    testing::ValuesIn<IndexedGZipTestCase>({{0, 1024, 1},
+                                            {0, 1024, 4},
+                                            {1000, 1024, 4},
+                                            {1024, 1024, 4},
+                                            {100 * 1024, 1024, 1},
+                                            {100 * 1024, 1024, 4},
+                                            {1024 * 1024, 10 * 1024, 8},
+                                            {1024 * 1024, 1024 * 1024, 2}}));
+
+TEST_P(IndexedGZipTestCaseTest, WriteAndRead) {
+  const IndexedGZipTestCase& test_case = GetParam();
+  std::uniform_int_distribution<int> dist(0, 10);
+  std::mt19937_64 rng(1);
+  std::string content;
+  while (content.size() < test_case.content_size) {
+    absl::StrAppend(&content, dist(rng));
+  }
+  content.resize(test_case.content_size);
+
+  StringOutputByteStream raw_output;
+  {
+    auto stream = GZipOutputByteStream::Create(
+                      &raw_output, 8, 1024 * 1024, /*raw_deflate=*/false,
+                      /*member_size=*/test_case.member_size)
+                      .value();
+    // Writes the content in chunks not aligned with the members.
+    for (size_t begin = 0; begin < content.size(); begin += 700) {
+      EXPECT_OK(stream->Write(absl::string_view(content).substr(begin, 700)));
+    }
+    EXPECT_OK(stream->Close());
+  }
+  const std::string compressed(raw_output.ToString());
+
+  // Parallel decompression.
+  {
+    StringInputByteStream raw_input(compressed);
+    auto stream = GZipInputByteStream::Create(&raw_input, 1024 * 1024,
+                                              test_case.num_threads)
+                      .value();
+    EXPECT_EQ(stream->ReadAll().value(), content);
+    EXPECT_OK(stream->Close());
+  }
+
+  // Indexed gzip streams are regular gzip streams.
+  {
+    StringInputByteStream raw_input(compressed);
+    auto stream = GZipInputByteStream::Create(&raw_input).value();
+    EXPECT_EQ(stream->ReadAll().value(), content);
+    EXPECT_OK(stream->Close());
+  }
+}
+
+TEST(GZip, ReadNonIndexedWithThreads) {
+  auto file_stream = file::OpenInputFile(HelloPath()).value();
+  auto stream = GZipInputByteStream::Create(file_stream.get(), 1024 * 1024,
+                                            /*num_threads=*/4)
+                    .value();
+  EXPECT_EQ(stream->ReadAll().value(), "hello");
+  EXPECT_OK(stream->Close());
+}
+
+TEST(GZip, ReadCorruptedIndexedMember) {
+  StringOutputByteStream raw_output;
+  {
+    auto stream = GZipOutputByteStream::Create(&raw_output, 8, 1024 * 1024,
+                                               /*raw_deflate=*/false,
+                                               /*member_size=*/1024)
+                      .value();
+    EXPECT_OK(stream->Write(std::string(10 * 1024, 'a')));
+    EXPECT_OK(stream->Close());
+  }
+  std::string compressed(raw_output.ToString());
+  // Corrupts the CRC of the last member.
+  compressed[compressed.size() - 8] ^= 1;
+
+  StringInputByteStream raw_input(compressed);
+  auto stream =
+      GZipInputByteStream::Create(&raw_input, 1024 * 1024, /*num_threads=*/4)
+          .value();
+  EXPECT_FALSE(stream->ReadAll().ok());
+}
+
 TEST(RawInflate, Base) {
   const auto input =
       absl::HexStringToBytes("05804109000008c4aa184ec1c7e0c08ff5c70ea43e470b");